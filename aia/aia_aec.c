@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_aec.h"
+
+#if ( aiaconfigCLIENT_AEC == 1 )
+
+#if ( aiaconfigCLIENT_SPEAKER_SAMPLE_RATE != aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE )
+#error "Echo cancellation needs the speaker and the microphone to run at the same sample rate."
+#endif
+
+#define AIA_AEC_FRAME_SAMPLES           AIA_MICROPHONE_RAW_FRAME_SAMPLES
+#define AIA_AEC_HISTORY_SAMPLES         ( aiaconfigCLIENT_AEC_TAPS - 1 + AIA_AEC_FRAME_SAMPLES )
+#define AIA_AEC_REFERENCE_MASK          ( aiaconfigCLIENT_AEC_REFERENCE_SAMPLES - 1 )
+/* Frames whose reference position is kept. Older ones have lost their reference anyway. */
+#define AIA_AEC_POSITIONS               ( aiaconfigCLIENT_AEC_REFERENCE_SAMPLES / AIA_AEC_FRAME_SAMPLES )
+
+/* The filter weights are in Q24, so that they cover echo paths with a gain of up to 128. */
+#define AIA_AEC_WEIGHT_SHIFT            ( 24 )
+#define AIA_AEC_STEP_SHIFT              ( 12 )
+/* Regularization of the NLMS step, as if every reference sample was at least at -42 dBFS. */
+#define AIA_AEC_DELTA                   ( ( int64_t )aiaconfigCLIENT_AEC_TAPS << 12 )
+/* A frame is near-end talk when a sample is louder than half the loudest reference sample (Geigel). Adaptation
+ * stays frozen for a while after it.
+ */
+#define AIA_AEC_DOUBLE_TALK_HOLD        ( 30 * AIA_AEC_FRAME_SAMPLES / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+#if ( ( aiaconfigCLIENT_AEC_REFERENCE_SAMPLES & AIA_AEC_REFERENCE_MASK ) != 0 )
+#error "aiaconfigCLIENT_AEC_REFERENCE_SAMPLES must be a power of two."
+#endif
+
+/* The NLMS step is at most STEP_Q15 * 2^15 * 2^( WEIGHT_SHIFT + STEP_SHIFT - 15 ) / DELTA, i.e.
+ * STEP_Q15 * 2^24 / TAPS, which fits 32 bits for any step below 1.0 with 128 taps or more.
+ */
+#if ( aiaconfigCLIENT_AEC_TAPS < 128 ) || ( aiaconfigCLIENT_AEC_STEP_Q15 >= 128 * aiaconfigCLIENT_AEC_TAPS )
+#error "aiaconfigCLIENT_AEC_TAPS must be 128 or more, and aiaconfigCLIENT_AEC_STEP_Q15 below 128 per tap."
+#endif
+
+#define AIA_AEC_UPDATE_TAPS             ( aiaconfigCLIENT_AEC_TAPS / aiaconfigCLIENT_AEC_UPDATE_PARTS )
+#if ( AIA_AEC_UPDATE_TAPS * aiaconfigCLIENT_AEC_UPDATE_PARTS != aiaconfigCLIENT_AEC_TAPS )
+#error "aiaconfigCLIENT_AEC_UPDATE_PARTS must divide aiaconfigCLIENT_AEC_TAPS."
+#endif
+
+static struct {
+    /* Written from interrupt only. */
+    int16_t sReference[ aiaconfigCLIENT_AEC_REFERENCE_SAMPLES ];
+    volatile uint32_t ulWritten;
+    uint32_t ulWrittenAtLastFrame;
+    uint32_t ulFramePosition[ AIA_AEC_POSITIONS ];
+    uint32_t ulFrameNumber[ AIA_AEC_POSITIONS ];
+
+    /* Used by the microphone task only. The oldest sample of the history comes first, and so does the weight of
+     * the longest echo path.
+     */
+    int16_t sHistory[ AIA_AEC_HISTORY_SAMPLES ];
+    int32_t lWeights[ aiaconfigCLIENT_AEC_TAPS ];
+    uint32_t ulDoubleTalk;
+    /* The first tap adapted by the next sample. */
+    uint32_t ulUpdateTap;
+
+    uint32_t ulFrames;
+    uint32_t ulBypassedFrames;
+    uint64_t ullNearEnergy;
+    uint64_t ullResidualEnergy;
+    AIACycleMeter_t xMeter;
+} xAec;
+
+/* Must be called with interrupts masked. */
+static void prvWriteReference( const int16_t * psData, size_t xSamples )
+{
+    for( size_t i = 0; i < xSamples; i++ )
+    {
+        xAec.sReference[ ( xAec.ulWritten + i ) & AIA_AEC_REFERENCE_MASK ] = ( psData != NULL ) ? psData[ i ] : 0;
+    }
+    xAec.ulWritten += xSamples;
+}
+
+static void prvPlayed( const void * pvData, size_t xRead, size_t xSize )
+{
+    prvWriteReference( ( const int16_t * )pvData, xRead / sizeof( int16_t ) );
+    if( xSize > xRead )
+    {
+        prvWriteReference( NULL, ( xSize - xRead ) / sizeof( int16_t ) );
+    }
+}
+
+void vAIAAecInit( void )
+{
+    memset( &xAec, 0, sizeof( xAec ) );
+    for( uint32_t i = 0; i < AIA_AEC_POSITIONS; i++ )
+    {
+        xAec.ulFrameNumber[ i ] = UINT32_MAX;
+    }
+}
+
+void vAIAAecPlayedFromISR( const void * pvData, size_t xRead, size_t xSize )
+{
+    UBaseType_t uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    prvPlayed( pvData, xRead, xSize );
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+}
+
+void vAIAAecPlayed( const void * pvData, size_t xRead, size_t xSize )
+{
+    taskENTER_CRITICAL();
+    prvPlayed( pvData, xRead, xSize );
+    taskEXIT_CRITICAL();
+}
+
+void vAIAAecFrameCapturedFromISR( uint32_t ulFrame )
+{
+    /* Nothing played during the frame, so the speaker is idle. Keep the reference in step with silence. */
+    if( xAec.ulWritten == xAec.ulWrittenAtLastFrame )
+    {
+        prvWriteReference( NULL, AIA_AEC_FRAME_SAMPLES );
+    }
+    xAec.ulWrittenAtLastFrame = xAec.ulWritten;
+
+    xAec.ulFramePosition[ ulFrame % AIA_AEC_POSITIONS ] = xAec.ulWritten;
+    xAec.ulFrameNumber[ ulFrame % AIA_AEC_POSITIONS ] = ulFrame;
+}
+
+/* Copy the reference of a frame to the history. Returns the loudest sample, or -1 if the reference is gone. */
+static int32_t prvLoadHistory( uint32_t ulFrame )
+{
+    uint32_t ulStart;
+    int32_t lMax = 0;
+
+    taskENTER_CRITICAL();
+    if( xAec.ulFrameNumber[ ulFrame % AIA_AEC_POSITIONS ] != ulFrame )
+    {
+        taskEXIT_CRITICAL();
+        return -1;
+    }
+    ulStart = xAec.ulFramePosition[ ulFrame % AIA_AEC_POSITIONS ] - aiaconfigCLIENT_AEC_DELAY_SAMPLES - AIA_AEC_HISTORY_SAMPLES;
+    taskEXIT_CRITICAL();
+
+    /* Leave a frame of margin for the speaker writing meanwhile. */
+    if( xAec.ulWritten - ulStart > aiaconfigCLIENT_AEC_REFERENCE_SAMPLES - AIA_AEC_FRAME_SAMPLES )
+    {
+        return -1;
+    }
+
+    for( uint32_t i = 0; i < AIA_AEC_HISTORY_SAMPLES; i++ )
+    {
+        int16_t sSample = xAec.sReference[ ( ulStart + i ) & AIA_AEC_REFERENCE_MASK ];
+
+        xAec.sHistory[ i ] = sSample;
+        if( sSample > lMax )
+        {
+            lMax = sSample;
+        }
+        else if( -sSample > lMax )
+        {
+            lMax = -sSample;
+        }
+    }
+
+    /* The speaker may have overwritten the history while it was copied. */
+    if( xAec.ulWritten - ulStart > aiaconfigCLIENT_AEC_REFERENCE_SAMPLES )
+    {
+        return -1;
+    }
+
+    return lMax;
+}
+
+void vAIAAecProcess( int16_t * psFrame, uint32_t ulFrame )
+{
+    const int16_t * psX;
+    int64_t llPower = 0;
+    int64_t llEcho;
+    int32_t lError;
+    int32_t lStep;
+    int32_t lMax;
+    uint64_t ullNear = 0;
+    uint64_t ullResidual = 0;
+
+    lMax = prvLoadHistory( ulFrame );
+    if( lMax <= 0 )
+    {
+        xAec.ulBypassedFrames++;
+        return;
+    }
+
+    vAIACycleMeterStart( &xAec.xMeter );
+
+    for( uint32_t i = 0; i < aiaconfigCLIENT_AEC_TAPS; i++ )
+    {
+        llPower += ( int32_t )xAec.sHistory[ i ] * xAec.sHistory[ i ];
+    }
+
+    for( uint32_t n = 0; n < AIA_AEC_FRAME_SAMPLES; n++ )
+    {
+        /* The taps seen by sample n, its own reference sample last. */
+        psX = &xAec.sHistory[ n ];
+        if( n > 0 )
+        {
+            llPower += ( int32_t )psX[ aiaconfigCLIENT_AEC_TAPS - 1 ] * psX[ aiaconfigCLIENT_AEC_TAPS - 1 ];
+            llPower -= ( int32_t )psX[ -1 ] * psX[ -1 ];
+        }
+
+        llEcho = 0;
+        for( uint32_t k = 0; k < aiaconfigCLIENT_AEC_TAPS; k++ )
+        {
+            llEcho += ( int64_t )xAec.lWeights[ k ] * psX[ k ];
+        }
+
+        lError = psFrame[ n ] - ( int32_t )( llEcho >> AIA_AEC_WEIGHT_SHIFT );
+        lError = ( lError > INT16_MAX ) ? INT16_MAX : ( lError < INT16_MIN ) ? INT16_MIN : lError;
+
+        if( 2 * ( psFrame[ n ] >= 0 ? psFrame[ n ] : -psFrame[ n ] ) > lMax )
+        {
+            xAec.ulDoubleTalk = AIA_AEC_DOUBLE_TALK_HOLD;
+        }
+
+        if( xAec.ulDoubleTalk > 0 )
+        {
+            xAec.ulDoubleTalk--;
+        }
+        else
+        {
+            /* w += mu * e * x / ( |x|^2 + delta ), on the next AIA_AEC_UPDATE_TAPS taps only. The step carries
+             * AIA_AEC_STEP_SHIFT more bits than the weights, so that small errors still adapt once the echo is mostly
+             * cancelled. Given delta, it fits 32 bits.
+             */
+            lStep = ( int32_t )( ( ( int64_t )aiaconfigCLIENT_AEC_STEP_Q15 * lError << ( AIA_AEC_WEIGHT_SHIFT + AIA_AEC_STEP_SHIFT - 15 ) ) /
+                                 ( llPower + AIA_AEC_DELTA ) );
+            for( uint32_t k = xAec.ulUpdateTap; k < xAec.ulUpdateTap + AIA_AEC_UPDATE_TAPS; k++ )
+            {
+                xAec.lWeights[ k ] += ( int32_t )( ( ( int64_t )lStep * psX[ k ] ) >> AIA_AEC_STEP_SHIFT );
+            }
+            xAec.ulUpdateTap = ( xAec.ulUpdateTap + AIA_AEC_UPDATE_TAPS ) % aiaconfigCLIENT_AEC_TAPS;
+
+            ullNear += ( int32_t )psFrame[ n ] * psFrame[ n ];
+            ullResidual += lError * lError;
+        }
+
+        psFrame[ n ] = ( int16_t )lError;
+    }
+
+    vAIACycleMeterStop( &xAec.xMeter );
+
+    xAec.ulFrames++;
+    xAec.ullNearEnergy += ullNear;
+    xAec.ullResidualEnergy += ullResidual;
+}
+
+void vAIAAecGetStatistics( AIAAecStatistics_t * pxStatistics )
+{
+    pxStatistics->ulFrames = xAec.ulFrames;
+    pxStatistics->ulBypassedFrames = xAec.ulBypassedFrames;
+    pxStatistics->ulCyclesAverage = ulAIACycleMeterAverage( &xAec.xMeter );
+    pxStatistics->ulCyclesMax = xAec.xMeter.ulMax;
+    /* 10 * log10( near / residual ) = 3.0103 * log2( near / residual ). */
+    pxStatistics->lErleQ8 = ( int32_t )( ( int64_t )( lAIALog2Q8( xAec.ullNearEnergy ) - lAIALog2Q8( xAec.ullResidualEnergy ) ) * 771 / 256 );
+}
+
+void vAIAAecReport( void )
+{
+    AIAAecStatistics_t xAecStatistics;
+
+    vAIAAecGetStatistics( &xAecStatistics );
+    configPRINTF_DEBUG( ( "DEBUG: Echo canceller %u cycles per frame on average, %u max, over %u frames (%u without echo), ERLE %d dB\r\n",
+                          xAecStatistics.ulCyclesAverage, xAecStatistics.ulCyclesMax, xAecStatistics.ulFrames,
+                          xAecStatistics.ulBypassedFrames, xAecStatistics.lErleQ8 / 256 ) );
+}
+
+void vAIAAecResetStatistics( void )
+{
+    xAec.ulFrames = 0;
+    xAec.ulBypassedFrames = 0;
+    xAec.ullNearEnergy = 0;
+    xAec.ullResidualEnergy = 0;
+    vAIACycleMeterReset( &xAec.xMeter );
+}
+
+#endif /* aiaconfigCLIENT_AEC == 1 */
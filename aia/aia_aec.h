@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_AEC_H_
+#define _AIA_AEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* Acoustic echo cancellation of the microphone audio, with the audio played by the speaker as the reference.
+ *
+ * The audio read by the platform speaker is kept in a reference ring. As each microphone frame is captured, the
+ * position of the ring is recorded with the number of the frame, so that the microphone task later finds the audio
+ * played while that frame was captured. aiaconfigCLIENT_AEC_DELAY_SAMPLES accounts for the play DMA block, the I2S
+ * FIFO and the echo path up to the first tap of the filter. While the speaker is idle the ring is filled with
+ * silence, so it keeps in step with the capture.
+ *
+ * The echo is estimated by a fixed-point NLMS filter of aiaconfigCLIENT_AEC_TAPS taps and subtracted from the frame
+ * in place. Each sample adapts the next 1 / aiaconfigCLIENT_AEC_UPDATE_PARTS of the taps. Adaptation is frozen while
+ * the near end talks, which a Geigel detector tells from the echo.
+ */
+
+/**
+ * @brief                   Clear the reference and the filter.
+ */
+void vAIAAecInit( void );
+
+/**
+ * @brief                   Add audio read by the platform speaker to the reference, from interrupt.
+ *
+ * @param[in] pvData        The audio read.
+ * @param[in] xRead         The number of bytes read.
+ * @param[in] xSize         The number of bytes the platform plays. Those not read are played as silence.
+ */
+void vAIAAecPlayedFromISR( const void * pvData, size_t xRead, size_t xSize );
+
+/**
+ * @brief                   The task version of vAIAAecPlayedFromISR().
+ */
+void vAIAAecPlayed( const void * pvData, size_t xRead, size_t xSize );
+
+/**
+ * @brief                   Record where the reference is as a microphone frame has been captured.
+ *
+ * This is the frame hook of the capture, see vAIACaptureSetFrameHook().
+ *
+ * @param[in] ulFrame       The number of the frame.
+ */
+void vAIAAecFrameCapturedFromISR( uint32_t ulFrame );
+
+/**
+ * @brief                   Remove the echo from a microphone frame in place.
+ *
+ * The frame is left as it is if the speaker was idle, or if its reference has already been overwritten because the
+ * microphone task fell too far behind the capture.
+ *
+ * @param[in,out] psFrame   The frame of AIA_MICROPHONE_RAW_FRAME_SAMPLES samples.
+ * @param[in] ulFrame       The number of the frame, see ulAIACaptureFirstFrame().
+ */
+void vAIAAecProcess( int16_t * psFrame, uint32_t ulFrame );
+
+typedef struct {
+    /* Frames with echo to cancel, and frames left as they were. */
+    uint32_t ulFrames;
+    uint32_t ulBypassedFrames;
+    /* CPU cycles per frame with echo to cancel. */
+    uint32_t ulCyclesAverage;
+    uint32_t ulCyclesMax;
+    /* Echo return loss enhancement over the frames without near-end talk, in 1/256 dB. */
+    int32_t lErleQ8;
+} AIAAecStatistics_t;
+
+/**
+ * @brief                   Get the statistics since the last vAIAAecResetStatistics().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIAAecGetStatistics( AIAAecStatistics_t * pxStatistics );
+
+/**
+ * @brief                   Print the statistics since the last vAIAAecResetStatistics() to the debug log.
+ */
+void vAIAAecReport( void );
+
+/**
+ * @brief                   Clear the statistics.
+ */
+void vAIAAecResetStatistics( void );
+
+#endif /* _AIA_AEC_H_ */
@@ -32,6 +32,8 @@ typedef enum AUDIO_CHANNEL_NUM {
 
 #define AUDIO_SAMPLE_RATE_32KHZ         (32000u)
 
+#define AUDIO_SAMPLE_RATE_48KHZ         (48000u)
+
 /*
  * Maximum frame sample size for OPUS codec.
  * From RFC6716 the opus max duration is 120ms.
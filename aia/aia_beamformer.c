@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_beamformer.h"
+
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 )
+
+#if defined( __ARM_FEATURE_SIMD32 )
+#include <arm_acle.h>
+#endif
+
+#define AIA_BEAMFORMER_CHANNELS         aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS
+#define AIA_BEAMFORMER_FRAME_SAMPLES    AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES
+/* Each channel keeps the end of the previous frame for its delay, rounded up so that its frame stays 32-bit aligned. */
+#define AIA_BEAMFORMER_HISTORY          ( ( aiaconfigCLIENT_MICROPHONE_ARRAY_MAX_DELAY + 1UL ) & ~1UL )
+
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 4 )
+#error "The beamformer supports up to 4 microphones."
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS != AUDIO_CHANNEL_MONO )
+#error "The beamformer produces a mono stream."
+#endif
+
+#if defined( __ARM_FEATURE_SIMD32 ) && ( AIA_BEAMFORMER_CHANNELS != 3 )
+#define AIA_BEAMFORMER_SIMD             1
+#else
+#define AIA_BEAMFORMER_SIMD             0
+#endif
+
+/* DEBUG builds check the SIMD version against the reference on a frame every second. */
+#define AIA_BEAMFORMER_CHECK_FRAMES     ( 1000UL / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+static struct {
+    int16_t sChannel[ AIA_BEAMFORMER_CHANNELS ][ AIA_BEAMFORMER_HISTORY + AIA_BEAMFORMER_FRAME_SAMPLES ] __attribute__((aligned(4)));
+    AIACycleMeter_t xMeter;
+#if AIA_BEAMFORMER_SIMD && defined( DEBUG )
+    int16_t sReference[ AIA_BEAMFORMER_FRAME_SAMPLES ];
+    AIACycleMeter_t xReferenceMeter;
+    uint32_t ulReferenceMismatches;
+#endif
+} xBeamformer;
+
+static const uint16_t usDelays[ AIA_BEAMFORMER_CHANNELS ] = aiaconfigCLIENT_MICROPHONE_ARRAY_DELAYS;
+
+static void prvDeinterleave( const int16_t * psFrame )
+{
+    for( uint32_t c = 0; c < AIA_BEAMFORMER_CHANNELS; c++ )
+    {
+        /* Keep the end of the previous frame before this one. */
+        memcpy( &xBeamformer.sChannel[ c ][ 0 ], &xBeamformer.sChannel[ c ][ AIA_BEAMFORMER_FRAME_SAMPLES ],
+                AIA_BEAMFORMER_HISTORY * sizeof( int16_t ) );
+    }
+
+#if ( ( AIA_BEAMFORMER_CHANNELS % 2 ) == 0 )
+    {
+        /* Two channels and two samples at a time: each word holds a sample of two channels, and the word of the next
+         * sample gives their next samples. The halfwords are packed with PKHBT/PKHTB on Cortex-M4.
+         */
+        const uint32_t * pulFrame = ( const uint32_t * )psFrame;
+        uint32_t ulThis;
+        uint32_t ulNext;
+        uint32_t ulPair;
+
+        for( uint32_t i = 0; i < AIA_BEAMFORMER_FRAME_SAMPLES; i += 2 )
+        {
+            for( uint32_t p = 0; p < AIA_BEAMFORMER_CHANNELS / 2; p++ )
+            {
+                ulThis = pulFrame[ i * AIA_BEAMFORMER_CHANNELS / 2 + p ];
+                ulNext = pulFrame[ ( i + 1 ) * AIA_BEAMFORMER_CHANNELS / 2 + p ];
+
+                ulPair = ( ulThis & 0xFFFFU ) | ( ulNext << 16 );
+                memcpy( &xBeamformer.sChannel[ 2 * p ][ AIA_BEAMFORMER_HISTORY + i ], &ulPair, sizeof( ulPair ) );
+                ulPair = ( ulNext & 0xFFFF0000U ) | ( ulThis >> 16 );
+                memcpy( &xBeamformer.sChannel[ 2 * p + 1 ][ AIA_BEAMFORMER_HISTORY + i ], &ulPair, sizeof( ulPair ) );
+            }
+        }
+    }
+#else
+    for( uint32_t i = 0; i < AIA_BEAMFORMER_FRAME_SAMPLES; i++ )
+    {
+        for( uint32_t c = 0; c < AIA_BEAMFORMER_CHANNELS; c++ )
+        {
+            xBeamformer.sChannel[ c ][ AIA_BEAMFORMER_HISTORY + i ] = psFrame[ i * AIA_BEAMFORMER_CHANNELS + c ];
+        }
+    }
+#endif
+}
+
+/* The plain C version, which the SIMD one is checked against, and the version for three channels. Two or four
+ * channels are summed in pairs, each sum halved and rounded down as SHADD16 does, so that both give the same beam.
+ * That is up to a step below the mean of two channels and a step and a half below that of four, and never clips.
+ */
+static void prvSumReference( int16_t * psBeam )
+{
+    const int16_t * psChannel[ AIA_BEAMFORMER_CHANNELS ];
+    int32_t lSum;
+
+    for( uint32_t c = 0; c < AIA_BEAMFORMER_CHANNELS; c++ )
+    {
+        psChannel[ c ] = &xBeamformer.sChannel[ c ][ AIA_BEAMFORMER_HISTORY - usDelays[ c ] ];
+    }
+
+    for( uint32_t i = 0; i < AIA_BEAMFORMER_FRAME_SAMPLES; i++ )
+    {
+#if ( AIA_BEAMFORMER_CHANNELS == 3 )
+        lSum = ( ( int32_t )psChannel[ 0 ][ i ] + psChannel[ 1 ][ i ] + psChannel[ 2 ][ i ] ) / 3;
+#else
+        lSum = ( ( int32_t )psChannel[ 0 ][ i ] + psChannel[ 1 ][ i ] ) >> 1;
+#if ( AIA_BEAMFORMER_CHANNELS == 4 )
+        lSum = ( lSum + ( ( ( int32_t )psChannel[ 2 ][ i ] + psChannel[ 3 ][ i ] ) >> 1 ) ) >> 1;
+#endif
+#endif
+        psBeam[ i ] = ( int16_t )lSum;
+    }
+}
+
+#if AIA_BEAMFORMER_SIMD
+
+static uint32_t prvLoadPair( const int16_t * psSamples )
+{
+    uint32_t ulPair;
+
+    /* Delays may leave the pair unaligned, which LDR allows. */
+    memcpy( &ulPair, psSamples, sizeof( ulPair ) );
+
+    return ulPair;
+}
+
+/* Two samples at a time with SHADD16. Each addition halves, so that the beam never clips. */
+static void prvSum( int16_t * psBeam )
+{
+    const int16_t * psChannel[ AIA_BEAMFORMER_CHANNELS ];
+    uint32_t ulBeam;
+
+    for( uint32_t c = 0; c < AIA_BEAMFORMER_CHANNELS; c++ )
+    {
+        psChannel[ c ] = &xBeamformer.sChannel[ c ][ AIA_BEAMFORMER_HISTORY - usDelays[ c ] ];
+    }
+
+    for( uint32_t i = 0; i < AIA_BEAMFORMER_FRAME_SAMPLES; i += 2 )
+    {
+        ulBeam = __shadd16( prvLoadPair( psChannel[ 0 ] + i ), prvLoadPair( psChannel[ 1 ] + i ) );
+#if ( AIA_BEAMFORMER_CHANNELS == 4 )
+        ulBeam = __shadd16( ulBeam, __shadd16( prvLoadPair( psChannel[ 2 ] + i ), prvLoadPair( psChannel[ 3 ] + i ) ) );
+#endif
+        memcpy( &psBeam[ i ], &ulBeam, sizeof( ulBeam ) );
+    }
+}
+
+#else
+
+#define prvSum      prvSumReference
+
+#endif
+
+void vAIABeamformerInit( void )
+{
+    memset( &xBeamformer, 0, sizeof( xBeamformer ) );
+
+    for( uint32_t c = 0; c < AIA_BEAMFORMER_CHANNELS; c++ )
+    {
+        configASSERT( usDelays[ c ] <= aiaconfigCLIENT_MICROPHONE_ARRAY_MAX_DELAY );
+    }
+}
+
+void vAIABeamformerProcess( const int16_t * psFrame, int16_t * psBeam )
+{
+    vAIACycleMeterStart( &xBeamformer.xMeter );
+    prvDeinterleave( psFrame );
+    prvSum( psBeam );
+    vAIACycleMeterStop( &xBeamformer.xMeter );
+
+#if AIA_BEAMFORMER_SIMD && defined( DEBUG )
+    if( xBeamformer.xMeter.ulCount % AIA_BEAMFORMER_CHECK_FRAMES == 1 )
+    {
+        vAIACycleMeterStart( &xBeamformer.xReferenceMeter );
+        prvSumReference( xBeamformer.sReference );
+        vAIACycleMeterStop( &xBeamformer.xReferenceMeter );
+
+        if( memcmp( xBeamformer.sReference, psBeam, sizeof( xBeamformer.sReference ) ) != 0 )
+        {
+            xBeamformer.ulReferenceMismatches++;
+        }
+    }
+#endif
+}
+
+void vAIABeamformerGetStatistics( AIABeamformerStatistics_t * pxStatistics )
+{
+    pxStatistics->ulCyclesAverage = ulAIACycleMeterAverage( &xBeamformer.xMeter );
+    pxStatistics->ulCyclesMax = xBeamformer.xMeter.ulMax;
+    pxStatistics->ulFrames = xBeamformer.xMeter.ulCount;
+#if AIA_BEAMFORMER_SIMD && defined( DEBUG )
+    pxStatistics->ulReferenceCyclesAverage = ulAIACycleMeterAverage( &xBeamformer.xReferenceMeter );
+    pxStatistics->ulReferenceMismatches = xBeamformer.ulReferenceMismatches;
+#else
+    pxStatistics->ulReferenceCyclesAverage = 0;
+    pxStatistics->ulReferenceMismatches = 0;
+#endif
+}
+
+void vAIABeamformerReport( void )
+{
+    AIABeamformerStatistics_t xBeamformer;
+
+    vAIABeamformerGetStatistics( &xBeamformer );
+    configPRINTF_DEBUG( ( "DEBUG: Beamformer of %u microphones %u cycles per frame on average, %u max, over %u frames\r\n",
+                          ( uint32_t )aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS, xBeamformer.ulCyclesAverage,
+                          xBeamformer.ulCyclesMax, xBeamformer.ulFrames ) );
+    if( xBeamformer.ulReferenceCyclesAverage != 0 )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: Beamformer reference %u cycles per frame on average, %u frames not matching\r\n",
+                              xBeamformer.ulReferenceCyclesAverage, xBeamformer.ulReferenceMismatches ) );
+    }
+}
+
+#endif /* aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_BEAMFORMER_H_
+#define _AIA_BEAMFORMER_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A delay-and-sum beamformer that turns the aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS microphones of an array into
+ * the mono stream sent to AIA. It runs on each frame captured, see aia_micinput.h, at the capture rate.
+ *
+ * Each channel is delayed by its entry of aiaconfigCLIENT_MICROPHONE_ARRAY_DELAYS in samples, which steers the beam
+ * towards the direction the sound reaches the channels with those delays from.
+ */
+
+/**
+ * @brief                   Clear the history of the channels.
+ */
+void vAIABeamformerInit( void );
+
+/**
+ * @brief                   Form the beam of a frame.
+ *
+ * @param[in] psFrame       The frame of AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES samples of all the channels, interleaved.
+ * @param[out] psBeam       The beam, AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES samples.
+ */
+void vAIABeamformerProcess( const int16_t * psFrame, int16_t * psBeam );
+
+typedef struct {
+    /* CPU cycles to de-interleave and sum a frame of all the channels. */
+    uint32_t ulCyclesAverage;
+    uint32_t ulCyclesMax;
+    uint32_t ulFrames;
+    /* CPU cycles per frame of the plain C reference, and the frames it did not give the same beam on. DEBUG builds
+     * for cores with the DSP extension run it on a frame every second.
+     */
+    uint32_t ulReferenceCyclesAverage;
+    uint32_t ulReferenceMismatches;
+} AIABeamformerStatistics_t;
+
+/**
+ * @brief                   Get the statistics since vAIABeamformerInit().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIABeamformerGetStatistics( AIABeamformerStatistics_t * pxStatistics );
+
+/**
+ * @brief                   Print the statistics since vAIABeamformerInit() to the debug log.
+ */
+void vAIABeamformerReport( void );
+
+#endif /* _AIA_BEAMFORMER_H_ */
@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <stddef.h>
+
+#include "aia_client_priv.h"
+#include "aia_capture.h"
+
+#define AIA_CAPTURE_SLOT_SIZE           ( AIA_MSG_PARAMS_SIZE_SEQ + sizeof( AIABinaryAudioStream_t ) )
+#define AIA_CAPTURE_FRAMES_OFFSET       ( AIA_MSG_PARAMS_SIZE_SEQ + offsetof( AIABinaryAudioStream_t, ucAudio ) )
+
+typedef enum {
+    eSlotFree = 0,
+    eSlotFilling,
+    /* Queued to or held by the microphone task, or queued to the outbound task. */
+    eSlotFilled,
+} AIACaptureSlotState_t;
+
+static struct {
+    uint8_t ucSlot[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ][ AIA_CAPTURE_SLOT_SIZE ] __attribute__((aligned(4)));
+    uint8_t ucState[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+    uint32_t ulFrames[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+    uint32_t ulSlotSession[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+    /* Frames of the stream dropped right before each slot. */
+    uint32_t ulGapFrames[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+    /* The number of the first frame of each slot, see ulFrameCount. */
+    uint32_t ulFirstFrame[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+    /* The slot being filled, or -1 if none was free. */
+    int32_t lFilling;
+    /* Frames of the slot being filled before it is queued. */
+    uint32_t ulTarget;
+    /* Frames scheduled in the stream so far, and in its last slot. */
+    uint32_t ulStreamFrames;
+    uint32_t ulLastTarget;
+    uint32_t ulFirstFrames;
+    uint32_t ulSmallFrames;
+    volatile BaseType_t xCongested;
+    volatile BaseType_t xListening;
+    /* Bumped on every restart to drop slots of the previous stream. */
+    uint32_t ulSession;
+    /* Bytes of the current frame written by xAIACaptureWriteFromISR(). */
+    size_t xFrameBytes;
+    /* Whether the platform DMA writes frames at the addresses given by the capture, and whether the frame it is
+     * writing was given before the last restart, which moved the start of the stream.
+     */
+    BaseType_t xDmaPointed;
+    BaseType_t xDmaFrameStale;
+    /* Frames dropped since the last slot was started, to be reported with the next one. */
+    uint32_t ulPendingGapFrames;
+    /* Frames captured since xAIACaptureInit(), dropped ones included. */
+    uint32_t ulFrameCount;
+    void ( * vFrameHook )( uint32_t ulFrame );
+    QueueHandle_t xFilled;
+    uint32_t ulDroppedFrames;
+    uint32_t ulOverflows;
+    uint32_t ulCopiedBytes;
+    uint32_t ulMaxSlotsInUse;
+    AIACycleMeter_t xIsrMeter;
+    /* Cycle count at the last restart, and the cycles from it to the end of the first frame after it. */
+    uint32_t ulRestartCycles;
+    uint32_t ulRestartToFrameCycles;
+    uint32_t ulFirstFrameCycles;
+    BaseType_t xFirstFramePending;
+} xCapture;
+
+/* Must be called with interrupts masked. */
+static uint32_t prvNextTarget( void )
+{
+    uint32_t ulTarget;
+
+    /* Frames are spotted one at a time, and the next stream starts with its own ramp. */
+    if( xCapture.xListening == pdTRUE )
+    {
+        xCapture.ulStreamFrames = 0;
+        xCapture.ulLastTarget = 0;
+        return 1;
+    }
+
+    if( xCapture.xCongested == pdTRUE )
+    {
+        ulTarget = AIA_MICROPHONE_MAX_FRAMES;
+    }
+    else if( xCapture.ulStreamFrames < xCapture.ulSmallFrames || xCapture.ulLastTarget == 0 )
+    {
+        ulTarget = xCapture.ulFirstFrames;
+    }
+    else
+    {
+        ulTarget = xCapture.ulLastTarget * 2;
+        if( ulTarget > AIA_MICROPHONE_MAX_FRAMES )
+        {
+            ulTarget = AIA_MICROPHONE_MAX_FRAMES;
+        }
+    }
+
+    xCapture.ulStreamFrames += ulTarget;
+    xCapture.ulLastTarget = ulTarget;
+
+    return ulTarget;
+}
+
+/* Must be called with interrupts masked. Returns the index of a free slot, or -1 if there is none. */
+static int32_t prvFreeSlot( void )
+{
+    int32_t lFree = -1;
+    uint32_t ulInUse = 0;
+
+    for( int i = 0; i < aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS; i++ )
+    {
+        if( xCapture.ucState[ i ] != eSlotFree )
+        {
+            ulInUse++;
+        }
+        else if( lFree < 0 )
+        {
+            lFree = i;
+        }
+    }
+
+    if( ulInUse > xCapture.ulMaxSlotsInUse )
+    {
+        xCapture.ulMaxSlotsInUse = ulInUse;
+    }
+
+    return lFree;
+}
+
+/* Must be called with interrupts masked. */
+static void prvStartSlot( void )
+{
+    int32_t lSlot = prvFreeSlot();
+
+    xCapture.lFilling = lSlot;
+    xCapture.xFrameBytes = 0;
+
+    if( lSlot >= 0 )
+    {
+        xCapture.ucState[ lSlot ] = eSlotFilling;
+        xCapture.ulFrames[ lSlot ] = 0;
+        xCapture.ulSlotSession[ lSlot ] = xCapture.ulSession;
+        xCapture.ulGapFrames[ lSlot ] = xCapture.ulPendingGapFrames;
+        xCapture.ulFirstFrame[ lSlot ] = xCapture.ulFrameCount;
+        xCapture.ulPendingGapFrames = 0;
+        xCapture.ulTarget = prvNextTarget();
+    }
+}
+
+/* Must be called with interrupts masked. */
+static void prvDropFrames( uint32_t ulFrames )
+{
+    xCapture.ulDroppedFrames += ulFrames;
+    xCapture.ulPendingGapFrames += ulFrames;
+    if( xCapture.ulPendingGapFrames == ulFrames )
+    {
+        xCapture.ulOverflows++;
+    }
+}
+
+static void * prvFrame( void )
+{
+    int32_t lSlot = xCapture.lFilling;
+
+    if( lSlot < 0 )
+    {
+        return NULL;
+    }
+
+    return &xCapture.ucSlot[ lSlot ][ AIA_CAPTURE_FRAMES_OFFSET + xCapture.ulFrames[ lSlot ] * AIA_MICROPHONE_RAW_FRAME_SIZE ];
+}
+
+/* Must be called with interrupts masked. */
+static void prvFrameDone( BaseType_t * pxHigherPriorityTaskWoken )
+{
+    int32_t lSlot = xCapture.lFilling;
+
+    if( xCapture.vFrameHook != NULL )
+    {
+        xCapture.vFrameHook( xCapture.ulFrameCount );
+    }
+    xCapture.ulFrameCount++;
+
+    if( xCapture.xDmaFrameStale == pdTRUE )
+    {
+        /* Restarted while the DMA was running. This frame went where the previous stream was, so the new one starts
+         * with the next frame, at the start of its slot.
+         */
+        xCapture.xDmaFrameStale = pdFALSE;
+        if( lSlot >= 0 )
+        {
+            xCapture.ulFirstFrame[ lSlot ] = xCapture.ulFrameCount;
+        }
+        return;
+    }
+
+    if( xCapture.xFirstFramePending == pdTRUE )
+    {
+        xCapture.xFirstFramePending = pdFALSE;
+        xCapture.ulFirstFrameCycles = ulPlatformGetCycleCount();
+        xCapture.ulRestartToFrameCycles = xCapture.ulFirstFrameCycles - xCapture.ulRestartCycles;
+    }
+
+    if( lSlot < 0 )
+    {
+        /* The frame went to the scratch buffer of the platform. Try again with the next one. */
+        prvDropFrames( 1 );
+        prvStartSlot();
+        return;
+    }
+
+    xCapture.ulFrames[ lSlot ]++;
+
+    /* While the network stalls and no other slot is free, keep growing this one rather than dropping audio. */
+    if( xCapture.ulFrames[ lSlot ] >= xCapture.ulTarget &&
+        ( xCapture.ulFrames[ lSlot ] >= AIA_MICROPHONE_MAX_FRAMES || prvFreeSlot() >= 0 ) )
+    {
+        uint8_t ucSlot = ( uint8_t )lSlot;
+
+        xCapture.ucState[ lSlot ] = eSlotFilled;
+        /* The queue can hold every slot, so this never fails. */
+        xQueueSendFromISR( xCapture.xFilled, &ucSlot, pxHigherPriorityTaskWoken );
+        prvStartSlot();
+    }
+}
+
+static void prvRestart( void )
+{
+    xCapture.ulRestartCycles = ulPlatformGetCycleCount();
+    xCapture.xFirstFramePending = pdTRUE;
+    /* Unless the platform asks for the first frame again as it opens the microphone. */
+    xCapture.xDmaFrameStale = xCapture.xDmaPointed;
+    xCapture.ulSession++;
+    xCapture.ulStreamFrames = 0;
+    xCapture.ulLastTarget = 0;
+    /* Audio dropped before the restart belongs to the previous stream. */
+    xCapture.ulPendingGapFrames = 0;
+    if( xCapture.lFilling >= 0 )
+    {
+        xCapture.ulFrames[ xCapture.lFilling ] = 0;
+        xCapture.ulSlotSession[ xCapture.lFilling ] = xCapture.ulSession;
+        xCapture.ulGapFrames[ xCapture.lFilling ] = 0;
+        xCapture.ulFirstFrame[ xCapture.lFilling ] = xCapture.ulFrameCount;
+        xCapture.ulTarget = prvNextTarget();
+        xCapture.xFrameBytes = 0;
+    }
+    else
+    {
+        prvStartSlot();
+    }
+}
+
+BaseType_t xAIACaptureInit( void )
+{
+    /* Every slot starts with a zeroed binary header, i.e. a single audio frame of type 0. */
+    memset( &xCapture, 0, sizeof( xCapture ) );
+    xCapture.ulFirstFrames = 1;
+
+    xCapture.xFilled = xQueueCreate( aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS, sizeof( uint8_t ) );
+    if( xCapture.xFilled == NULL )
+    {
+        return pdFAIL;
+    }
+
+    prvStartSlot();
+
+    return pdPASS;
+}
+
+void vAIACaptureRestart( void )
+{
+    taskENTER_CRITICAL();
+    prvRestart();
+    taskEXIT_CRITICAL();
+}
+
+void vAIACaptureRestartFromISR( void )
+{
+    UBaseType_t uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    prvRestart();
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+}
+
+void vAIACaptureSetChunking( uint32_t ulFirstFrames, uint32_t ulSmallFrames )
+{
+    if( ulFirstFrames > AIA_MICROPHONE_MAX_FRAMES )
+    {
+        ulFirstFrames = AIA_MICROPHONE_MAX_FRAMES;
+    }
+
+    taskENTER_CRITICAL();
+    xCapture.ulFirstFrames = ( ulFirstFrames != 0 ) ? ulFirstFrames : 1;
+    xCapture.ulSmallFrames = ulSmallFrames;
+    taskEXIT_CRITICAL();
+}
+
+void vAIACaptureSetCongested( BaseType_t xCongested )
+{
+    xCapture.xCongested = xCongested;
+}
+
+void vAIACaptureSetFrameHook( void ( * vFrameHook )( uint32_t ulFrame ) )
+{
+    taskENTER_CRITICAL();
+    xCapture.vFrameHook = vFrameHook;
+    taskEXIT_CRITICAL();
+}
+
+void vAIACaptureSetListening( BaseType_t xListening )
+{
+    xCapture.xListening = xListening;
+}
+
+void * pvAIACaptureAcquire( void )
+{
+    int32_t lSlot;
+
+    taskENTER_CRITICAL();
+    lSlot = prvFreeSlot();
+    if( lSlot >= 0 )
+    {
+        xCapture.ucState[ lSlot ] = eSlotFilled;
+    }
+    taskEXIT_CRITICAL();
+
+    return ( lSlot >= 0 ) ? xCapture.ucSlot[ lSlot ] : NULL;
+}
+
+void * pvAIACaptureFrame( void )
+{
+    void * pvFrame;
+
+    taskENTER_CRITICAL();
+    xCapture.xDmaPointed = pdTRUE;
+    xCapture.xDmaFrameStale = pdFALSE;
+    pvFrame = prvFrame();
+    taskEXIT_CRITICAL();
+
+    return pvFrame;
+}
+
+void * pvAIACaptureFrameDoneFromISR( BaseType_t * pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxSavedInterruptStatus;
+    void * pvFrame;
+
+    vAIACycleMeterStart( &xCapture.xIsrMeter );
+
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    prvFrameDone( pxHigherPriorityTaskWoken );
+    pvFrame = prvFrame();
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+    vAIACycleMeterStop( &xCapture.xIsrMeter );
+
+    return pvFrame;
+}
+
+size_t xAIACaptureWriteFromISR( const void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxSavedInterruptStatus;
+    const uint8_t * pucData = ( const uint8_t * )pvData;
+    size_t xCopied = 0;
+
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    /* No DMA writes to the slots, so a restart applies from the next byte. */
+    xCapture.xDmaPointed = pdFALSE;
+    xCapture.xDmaFrameStale = pdFALSE;
+    while( xCopied < xSize )
+    {
+        uint8_t * pucFrame = ( uint8_t * )prvFrame();
+        size_t xLength = AIA_MICROPHONE_RAW_FRAME_SIZE - xCapture.xFrameBytes;
+
+        if( pucFrame == NULL )
+        {
+            prvStartSlot();
+            if( xCapture.lFilling < 0 )
+            {
+                prvDropFrames( ( xSize - xCopied + AIA_MICROPHONE_RAW_FRAME_SIZE - 1 ) / AIA_MICROPHONE_RAW_FRAME_SIZE );
+                break;
+            }
+            continue;
+        }
+
+        if( xLength > xSize - xCopied )
+        {
+            xLength = xSize - xCopied;
+        }
+        memcpy( pucFrame + xCapture.xFrameBytes, pucData + xCopied, xLength );
+        xCapture.xFrameBytes += xLength;
+        xCopied += xLength;
+
+        if( xCapture.xFrameBytes == AIA_MICROPHONE_RAW_FRAME_SIZE )
+        {
+            xCapture.xFrameBytes = 0;
+            prvFrameDone( pxHigherPriorityTaskWoken );
+        }
+    }
+    xCapture.ulCopiedBytes += xCopied;
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+    return xCopied;
+}
+
+BaseType_t xAIACaptureReceive( void ** ppvSlot, uint32_t * pulFrames, uint32_t * pulGapFrames, TickType_t xTicksToWait )
+{
+    uint8_t ucSlot;
+
+    while( xQueueReceive( xCapture.xFilled, &ucSlot, xTicksToWait ) == pdPASS )
+    {
+        if( xCapture.ulSlotSession[ ucSlot ] != xCapture.ulSession )
+        {
+            vAIACaptureRelease( xCapture.ucSlot[ ucSlot ] );
+            continue;
+        }
+
+        *ppvSlot = xCapture.ucSlot[ ucSlot ];
+        *pulFrames = xCapture.ulFrames[ ucSlot ];
+        *pulGapFrames = xCapture.ulGapFrames[ ucSlot ];
+        return pdPASS;
+    }
+
+    return pdFAIL;
+}
+
+uint32_t ulAIACaptureFirstFrame( const void * pvSlot )
+{
+    size_t xSlot = ( size_t )( ( const uint8_t * )pvSlot - &xCapture.ucSlot[ 0 ][ 0 ] ) / AIA_CAPTURE_SLOT_SIZE;
+
+    configASSERT( xSlot < aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS );
+
+    return xCapture.ulFirstFrame[ xSlot ];
+}
+
+uint32_t ulAIACaptureFrameCount( void )
+{
+    /* A single word, written from interrupt only. */
+    return xCapture.ulFrameCount;
+}
+
+void vAIACaptureRelease( void * pvSlot )
+{
+    size_t xSlot = ( size_t )( ( uint8_t * )pvSlot - &xCapture.ucSlot[ 0 ][ 0 ] ) / AIA_CAPTURE_SLOT_SIZE;
+
+    configASSERT( xSlot < aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS );
+
+    taskENTER_CRITICAL();
+    xCapture.ucState[ xSlot ] = eSlotFree;
+    taskEXIT_CRITICAL();
+}
+
+void vAIACaptureGetStatistics( AIACaptureStatistics_t * pxStatistics )
+{
+    taskENTER_CRITICAL();
+    pxStatistics->ulDroppedFrames = xCapture.ulDroppedFrames;
+    pxStatistics->ulOverflows = xCapture.ulOverflows;
+    pxStatistics->ulCopiedBytes = xCapture.ulCopiedBytes;
+    pxStatistics->ulMaxSlotsInUse = xCapture.ulMaxSlotsInUse;
+    pxStatistics->ulIsrCyclesAverage = ulAIACycleMeterAverage( &xCapture.xIsrMeter );
+    pxStatistics->ulIsrCyclesMax = xCapture.xIsrMeter.ulMax;
+    pxStatistics->ulRestartToFrameCycles = xCapture.ulRestartToFrameCycles;
+    pxStatistics->ulFirstFrameCycles = xCapture.ulFirstFrameCycles;
+    taskEXIT_CRITICAL();
+}
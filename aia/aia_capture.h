@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_CAPTURE_H_
+#define _AIA_CAPTURE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* Microphone audio is captured straight into a ring of microphone message buffers ("slots"). Each slot starts
+ * with AIA_MSG_PARAMS_SIZE_SEQ bytes for the sequence number followed by an AIABinaryAudioStream_t, so that a filled
+ * slot can be handed to the outbound task and encrypted into the MQTT packet without being copied.
+ *
+ * The platform microphone DMA writes one frame of AIA_MICROPHONE_RAW_FRAME_SIZE bytes at a time to the address
+ * given by pvAIACaptureFrame(). When a frame is complete, the ISR calls pvAIACaptureFrameDoneFromISR() to get the
+ * address of the next frame. Once a slot holds the requested number of frames, only its index is queued to the
+ * microphone task. If no other slot is free at that point, the slot keeps growing until it is full. Only then is
+ * a frame dropped and NULL returned, in which case the platform should let the DMA write to a scratch buffer of
+ * its own. The frames dropped are reported with the next slot, so that the offsets of the stream still match the
+ * time the audio was captured at.
+ */
+
+/**
+ * @brief                   Initialize the slots and the queue of filled slots.
+ *
+ * @return                  pdPASS on success and pdFAIL on failure.
+ */
+BaseType_t xAIACaptureInit( void );
+
+/**
+ * @brief                   Start capturing a new microphone stream.
+ *
+ * The slot being filled is emptied, and slots filled before this call are dropped by xAIACaptureReceive().
+ * Call this before the platform microphone is opened. If it is already running, the DMA keeps writing the frame it
+ * was given, which is dropped: the stream starts with the next frame, unless the platform opens the microphone and
+ * asks for the first frame with pvAIACaptureFrame() meanwhile.
+ */
+void vAIACaptureRestart( void );
+
+/**
+ * @brief                   The interrupt-safe version of vAIACaptureRestart().
+ */
+void vAIACaptureRestartFromISR( void );
+
+/**
+ * @brief                   Set how many frames go into each slot at the start of a stream.
+ *
+ * The slots of a stream hold ulFirstFrames each until ulSmallFrames have been captured, so that the start of an
+ * utterance reaches the network quickly. After that, the number of frames doubles with every slot until a slot is
+ * full. This applies from the next slot to be filled.
+ *
+ * @param[in] ulFirstFrames The number of frames in each of the first slots. It is capped to what a slot can hold.
+ * @param[in] ulSmallFrames The number of frames to capture in small slots.
+ */
+void vAIACaptureSetChunking( uint32_t ulFirstFrames, uint32_t ulSmallFrames );
+
+/**
+ * @brief                   Fill whole slots while the network does not keep up, regardless of the chunking.
+ *
+ * @param[in] xCongested    pdTRUE to fill whole slots, pdFALSE to follow the chunking again.
+ */
+void vAIACaptureSetCongested( BaseType_t xCongested );
+
+/**
+ * @brief                   Set a function called from interrupt as each frame has been captured, dropped ones included.
+ *
+ * Frames are numbered from xAIACaptureInit() on. This lets other stages keep data in step with the capture, e.g. the
+ * audio played at the time each frame was captured.
+ *
+ * @param[in] vFrameHook    The function, given the number of the frame. It runs with interrupts masked.
+ */
+void vAIACaptureSetFrameHook( void ( * vFrameHook )( uint32_t ulFrame ) );
+
+/**
+ * @brief                   Queue every frame in a slot of its own, for the keyword spotter between utterances.
+ *
+ * This applies from the next slot to be filled. The chunking starts over once listening stops.
+ *
+ * @param[in] xListening    pdTRUE to queue single frames, pdFALSE to follow the chunking again.
+ */
+void vAIACaptureSetListening( BaseType_t xListening );
+
+/**
+ * @brief                   Take a free slot to be filled by the caller instead of the platform microphone.
+ *
+ * The slot is laid out as the slots from xAIACaptureReceive() and is given back with vAIACaptureRelease().
+ *
+ * @return                  The slot, or NULL if no slot is free.
+ */
+void * pvAIACaptureAcquire( void );
+
+/**
+ * @brief                   Get where the next frame of microphone audio is to be written, as the DMA is started.
+ *
+ * @return                  The address of the frame, or NULL if no slot is free.
+ */
+void * pvAIACaptureFrame( void );
+
+/**
+ * @brief                   Mark the frame returned by pvAIACaptureFrame() as written. Call this from interrupt only.
+ *
+ * @param[out] pxHigherPriorityTaskWoken    Set to pdTRUE if the microphone task has been woken up.
+ *
+ * @return                  The address the next frame is to be written to, or NULL if no slot is free.
+ */
+void * pvAIACaptureFrameDoneFromISR( BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief                   Copy microphone audio into the slots, for platforms whose DMA cannot write to them.
+ *
+ * @param[in] pvData        The audio.
+ * @param[in] xSize         The length of the audio in bytes.
+ * @param[out] pxHigherPriorityTaskWoken    Set to pdTRUE if the microphone task has been woken up.
+ *
+ * @return                  The number of bytes copied. The rest is dropped as no slot is free.
+ */
+size_t xAIACaptureWriteFromISR( const void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief                   Wait for a filled slot.
+ *
+ * @param[out] ppvSlot      The slot.
+ * @param[out] pulFrames    The number of frames in the slot.
+ * @param[out] pulGapFrames The number of frames dropped between the previous slot of the stream and this one.
+ * @param[in] xTicksToWait  The maximum time to wait.
+ *
+ * @return                  pdPASS if a slot has been received and pdFAIL on timeout.
+ */
+BaseType_t xAIACaptureReceive( void ** ppvSlot, uint32_t * pulFrames, uint32_t * pulGapFrames, TickType_t xTicksToWait );
+
+/**
+ * @brief                   Get the number of the first frame of a slot, as given to the frame hook.
+ *
+ * @param[in] pvSlot        The slot received from xAIACaptureReceive().
+ *
+ * @return                  The number of the frame. The frames of a slot are consecutive.
+ */
+uint32_t ulAIACaptureFirstFrame( const void * pvSlot );
+
+/**
+ * @brief                   Get the number the next frame to be captured will be given, as for the frame hook.
+ *
+ * Frames whose number is below it were captured before this call, so it marks a point in the stream.
+ *
+ * @return                  The number of the frame.
+ */
+uint32_t ulAIACaptureFrameCount( void );
+
+/**
+ * @brief                   Give a slot back to be filled again.
+ *
+ * @param[in] pvSlot        The slot received from xAIACaptureReceive().
+ */
+void vAIACaptureRelease( void * pvSlot );
+
+typedef struct {
+    /* Frames dropped as no slot was free. */
+    uint32_t ulDroppedFrames;
+    /* Runs of consecutive frames dropped, i.e. the gaps left in the streams. */
+    uint32_t ulOverflows;
+    /* Bytes copied by xAIACaptureWriteFromISR(). */
+    uint32_t ulCopiedBytes;
+    /* The most slots that have been taken at once. */
+    uint32_t ulMaxSlotsInUse;
+    /* CPU cycles spent in pvAIACaptureFrameDoneFromISR(). */
+    uint32_t ulIsrCyclesAverage;
+    uint32_t ulIsrCyclesMax;
+    /* CPU cycles from the last restart to the end of the first frame captured after it, and the cycle count then. */
+    uint32_t ulRestartToFrameCycles;
+    uint32_t ulFirstFrameCycles;
+} AIACaptureStatistics_t;
+
+/**
+ * @brief                   Get the capture statistics since xAIACaptureInit().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIACaptureGetStatistics( AIACaptureStatistics_t * pxStatistics );
+
+#endif /* _AIA_CAPTURE_H_ */
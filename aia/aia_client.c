@@ -32,12 +32,26 @@ TaskHandle_t xDemoTaskHandle;
 
 static AIAClient_t AIAClient;
 
-static uint8_t ucAiaRecvMsg[ aiaconfigAIA_MESSAGE_MAX_SIZE ] __attribute__((aligned(4)));
-
 static uint8_t ucDecodeTaskTemp[ aiaconfigAIA_MESSAGE_MAX_SIZE ] __attribute__((aligned(4)));
 
 static AIAClient_Resequence_t xReseqBuffer;
 
+/* The Opus decoder state is placed here with opus_decoder_init() rather than allocated by opus_decoder_create(). */
+static uint8_t ucDecoderState[ aiaconfigCLIENT_DECODER_STATE_SIZE ] __attribute__((aligned(8)));
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+/* The Opus encoder state is placed here with opus_encoder_init() rather than allocated by opus_encoder_create(). */
+static uint8_t ucEncoderState[ aiaconfigCLIENT_ENCODER_STATE_SIZE ] __attribute__((aligned(8)));
+
+/* The encoder and the decoder run in different tasks but share the Opus pseudo-stack. */
+static SemaphoreHandle_t xOpusLock;
+#define OPUS_LOCK()                 xSemaphoreTake( xOpusLock, portMAX_DELAY )
+#define OPUS_UNLOCK()               xSemaphoreGive( xOpusLock )
+#else
+#define OPUS_LOCK()
+#define OPUS_UNLOCK()
+#endif
+
 static AIACryptoKeys_t xKeys = {
         .client_public_key = aiaconfigCLIENT_PUBLIC_KEY,
         .client_private_key = aiaconfigCLIENT_PRIVATE_KEY,
@@ -50,27 +64,236 @@ static bool bMicrophoneOpenedDuringOverrun = false;
 static bool bSendMicrophoneOpenedEvent = false;
 static SemaphoreHandle_t xGenericLock;
 
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+/* Set when listening starts or resumes after an utterance, so that the microphone task resets the spotter. */
+static volatile bool bResetWakeword = false;
+/* The pre-roll takes at most all the capture slots but two, which leaves the DMA a slot to go on filling and one to
+ * move to once it is full.
+ */
+#define AIA_WAKEWORD_PREROLL_MAX_SLOTS      ( aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS - 2UL )
+#if ( ( aiaconfigCLIENT_WAKEWORD_PREROLL_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS ) > \
+      ( aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS < 2UL ? 0UL : AIA_WAKEWORD_PREROLL_MAX_SLOTS * aiaconfigAIA_MICROPHONE_SLOT_FRAMES ) )
+#error "aiaconfigCLIENT_WAKEWORD_PREROLL_MS does not fit in the capture slots but two"
+#endif
+/* Slots holding the pre-roll of an utterance opened on the wake word, newest audio first. */
+static void * pvWakewordPreroll[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+static uint32_t ulWakewordPrerollFrames[ aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS ];
+static uint32_t ulWakewordPrerollSlots;
+/* Whether the capture feeds the spotter between utterances, and whether an utterance is open. Both are read and
+ * written together in critical sections, so that an utterance opened or closed while xClientStartWakeword() runs
+ * leaves the capture and the platform microphone running if, and only if, either one needs them.
+ */
+static bool bWakewordListening = false;
+static bool bWakewordUtterance = false;
+#endif
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+/* Only used by the microphone task. */
+static AIAVad_t xVad;
+/* Cleared by vClientSetEndpointer() to leave closing the microphone to AIA. */
+static volatile BaseType_t xEndpointerEnabled = pdTRUE;
+#endif
+
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+/* Shared by the task reporting the touch button and the microphone task, in critical sections. */
+static volatile AIAClient_Gesture_t xGesture = eAIAGestureIdle;
+static TickType_t xTickAtTouchDown;
+static TickType_t xTickAtTouchUp;
+/* The first frame captured after a long press was released. */
+static uint32_t ulFrameAtTouchUp;
+#endif
+
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+/* Shared by the directive handlers, the speaker and microphone paths and the timer, in critical sections. */
+static AIAWarmupPolicy_t xWarmup;
+static TimerHandle_t xWarmupTimer;
+
+/* Used to measure the time from a claim to the first audio. */
+static volatile bool bSpeakerStartupPending;
+static BaseType_t xSpeakerStartupWarm;
+static uint32_t ulSpeakerStartupCycles;
+static volatile bool bMicrophoneStartupPending;
+static BaseType_t xMicrophoneStartupWarm;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES > 0 )
+/* While the speaker is closed, the speaker task decodes the start of the first /speaker message here. The message
+ * itself is left in the speaker buffer, where new audio may still drop it. Only the speaker task uses these.
+ */
+static bool bDecodeAheadHeld = false;
+static int16_t sDecodeAhead[ aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES ][ AIA_SPEAKER_RAW_FRAME_SAMPLES ];
+static uint64_t ullDecodeAheadOffset[ aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES ];
+static uint32_t ulDecodeAheadFrames;
+static uint32_t ulDecodeAheadNext;
+#endif
+
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+/* Shared by the /speaker handler, the speaker task, the capabilities acknowledgement and the timer below, in critical
+ * sections.
+ */
+static AIAPlayout_t xPlayout;
+/* Gives up on the thresholds proposed when the service does not acknowledge them. */
+static TimerHandle_t xCapabilitiesTimer;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+/* Set by the /speaker handler and the gap timer, in critical sections. Everything else about the recovery is done
+ * by the /speaker handler.
+ */
+static volatile AIAClient_Gap_t xSpeakerGap = eAIAGapNone;
+static uint32_t ulGapSequence;
+static TimerHandle_t xGapTimer;
+static AIAClient_GapStatistics_t xGapStatistics;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+/* Only used by the speaker task. Frames concealed while the audio was late are played ahead of ullOutputOffset, and
+ * the audio for them is dropped when it comes. The first frame decoded after concealment is faded in, from the last
+ * sample concealed.
+ */
+static uint32_t ulConcealedAhead;
+static uint32_t ulLateFrames;
+static bool bFadeInPending;
+static int16_t sFadeFrom;
+#define AIA_SPEAKER_FADE_SAMPLES        ( AIA_SPEAKER_RAW_FRAME_SAMPLES / 4 )
+/* Set by the /speaker handler while it holds messages after the one expected, or waits for missing ones: the stream
+ * goes on past the audio that is late.
+ */
+static volatile bool bSpeakerAudioAhead;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+/* Written by the speaker task, in critical sections, and by the speaker DMA interrupt through the read functions. */
+static AIAPlayclock_t xPlayclock;
+#endif
+
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+/* Added to by the directive handlers and taken from by the speaker task, in critical sections. bSpeakerCloseDue is
+ * only used by the speaker task, set once it gets to the offset of CloseSpeaker.
+ */
+static AIAOffsetAction_t xOffsetActionStorage[ aiaconfigCLIENT_OFFSET_ACTIONS_MAX ];
+static AIAOffsetScheduler_t xOffsetActions;
+static bool bSpeakerCloseDue;
+#endif
+
+/* The last backpressure from the outbound task. */
+static volatile BaseType_t xMicrophoneCongested = pdFALSE;
+
 static TaskHandle_t xMicrophoneTaskHandle;
 static TaskHandle_t xSpeakerTaskHandle;
 
+#ifdef DEBUG
+/* Used to report heap allocations per second of playback. */
+static uint32_t ulHeapAllocationsAtSpeakerOpen;
+static TickType_t xTickAtSpeakerOpen;
+
+/* Used to report the cost of microphone capture per second. */
+static TickType_t xTickAtMicrophoneOpen;
+static AIACaptureStatistics_t xCaptureAtMicrophoneOpen;
+
+/* Set from the tap, the OpenMicrophone directive or the wake word, in a critical section as taps may come from an
+ * interrupt. The outbound task takes it with the next microphone message and resets the figures below, which only it
+ * writes.
+ */
+static uint32_t ulCyclesAtUtteranceStart;
+static bool bUtteranceStartPending;
+/* The cycle count of the last touch reported with vClientButtonPressed(), for the tap it turns into. */
+static uint32_t ulCyclesAtButtonPress;
+static bool bButtonPressPending;
+
+/* Used to report the latency and the overhead of streaming each utterance. */
+static uint32_t ulCyclesAtMicrophoneTap;
+static bool bFirstMicrophoneMessagePending;
+static uint32_t ulTapToFirstMessageUs;
+static uint32_t ulMicrophoneMessages;
+static uint32_t ulMicrophoneAudioBytes;
+static uint32_t ulMicrophoneOverheadBytes;
+static AIACycleMeter_t xMicrophonePublishMeter;
+#if ( aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS > 0 )
+/* Publish stalls injected in the utterance, see aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS. */
+static uint32_t ulInjectedStalls;
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+/* Used to compare the cost of encoding with the crypto and network load it saves. */
+static AIACycleMeter_t xEncodeMeter;
+#endif
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+/* Used to report the cost of the endpointer, and how much sooner than AIA it ends an utterance. */
+static AIACycleMeter_t xEndpointerMeter;
+static bool bEndOfSpeechDetected;
+static TickType_t xTickAtEndOfSpeech;
+static uint64_t ullOffsetAtEndOfSpeech;
+#endif
+
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+/* Touch-down to the first captured sample of each utterance, in AIA_TOUCH_LATENCY_BUCKET_MS buckets. The last bucket
+ * takes the rest.
+ */
+#define AIA_TOUCH_LATENCY_BUCKETS       ( 8 )
+#define AIA_TOUCH_LATENCY_BUCKET_MS     ( 5UL )
+static uint32_t ulTouchLatencyHistogram[ AIA_TOUCH_LATENCY_BUCKETS ];
+static bool bTouchLatencyPending;
+/* The cycle count the platform saw the touch-down at, before its debounce. */
+static uint32_t ulCyclesAtTouchDown;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+/* Used to report the frames concealed and the cost of concealment against the frame. */
+static AIACycleMeter_t xConcealMeter;
+static uint32_t ulConcealedMissingFrames;
+static uint32_t ulConcealedLateFrames;
+static uint32_t ulFecFrames;
+static uint32_t ulDroppedLateFrames;
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+/* Used to report how long markers are held until the audio before them has been played. */
+static uint32_t ulMarkerHeldMs;
+static uint32_t ulMarkerHeldMsMax;
+#endif
+
+/* Used to report the worst time taken to write a /speaker message while the speaker is closed, old ones dropped. */
+static AIACycleMeter_t xDropOldestMeter;
+static uint32_t ulDroppedWhileClosed;
+
+/* Used to report the time from OpenSpeaker to the first non-zero sample read for the speaker DMA. */
+static volatile bool bFirstSoundPending;
+static uint32_t ulCyclesAtOpenSpeaker;
+static uint32_t ulOpenToSoundUs;
+static uint32_t ulOpenToSoundUsMax;
+static uint32_t ulOpenToSoundUsTotal;
+static uint32_t ulOpenToSoundCount;
+#endif
+
 static BaseType_t prvClientSetState( BaseType_t xState );
 static BaseType_t prvClientSetStateFromISR( BaseType_t xState, BaseType_t *pxHigherPriorityTaskWoken );
 static BaseType_t prvClientClearState( BaseType_t xState );
 static BaseType_t prvClientGetState( BaseType_t xState );
+static BaseType_t prvClientTakeState( BaseType_t xState );
 static BaseType_t prvClientWaitForState( BaseType_t xState, BaseType_t xClearOnExit, BaseType_t xWaitForAllStates, TickType_t xTicksToWait );
 static BaseType_t prvClientPublishMessage( const char * pcTopic, const void * pvData, uint32_t ulLen );
+static BaseType_t prvClientPublishEncryptedMessage( const char * pcTopic, void * pvPlaintext, uint32_t ulLen, uint32_t ulSequence );
 static BaseType_t prvClientDisconnectFromAIA( void );
-static BaseType_t prvClientOpenMicrophone( void );
-static BaseType_t prvClientOpenMicrophoneFromISR( BaseType_t * pxHigherPriorityTaskWoken );
+static BaseType_t prvClientOpenMicrophone( uint32_t ulCyclesAtTap );
+static BaseType_t prvClientOpenMicrophoneFromISR( uint32_t ulCyclesAtTap, BaseType_t * pxHigherPriorityTaskWoken );
 static BaseType_t prvClientCloseMicrophone( void );
 static BaseType_t prvClientOpenSpeaker( uint64_t ullOpenOffset );
 static BaseType_t prvClientCloseSpeaker( uint64_t ullCloseOffset );
 static BaseType_t prvClientReconnectToAIA( void );
 static BaseType_t prvClientPublishCapabilities( void );
+static BaseType_t prvClientSendCapabilities( void );
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+static BaseType_t prvClientQueueCapabilities( uint32_t ulOverrunWarning, uint32_t ulUnderrunWarning );
+#endif
 static BaseType_t prvClientSynchronizeState( void );
 static BaseType_t prvClientSetVolume( AIAClient_SetVolume_t xSetVolume );
 static BaseType_t prvClientSendMarker( uint32_t ulMarker );
 static BaseType_t prvClientBufferStateChanged( AIABufferStateChanged_t xBufferStateChanged );
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+static void prvClientRunOffsetActions( uint64_t ullOffset );
+#endif
 
 static void prvClientHandleTopicConnectionService( const uint8_t * pucMessage, uint32_t ulMessageLength );
 static void prvClientHandleTopicSpeaker( const uint8_t * pucMessage, uint32_t ulMessageLength );
@@ -110,6 +333,21 @@ static void prvClientHandleDirectiveSetVolume( const uint8_t * pucMessage,
 static void prvAIAStreamMicrophoneTask( void * pvParameters );
 static void prvAIASpeakerTask( void * pvParameters );
 
+static void prvClientResetResequenceBuffer( void )
+{
+    for( int i = 0; i < aiaconfigAIA_SPEAKER_RESEQUENCING; i++ )
+    {
+        if( xReseqBuffer.xMessage[ i ].ulLen != 0 )
+        {
+            vAIARecvPoolFree( xReseqBuffer.xMessage[ i ].pucBuffer );
+            xReseqBuffer.xMessage[ i ].ulLen = 0;
+        }
+    }
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+    bSpeakerAudioAhead = false;
+#endif
+}
+
 static BaseType_t prvClientSetState( BaseType_t xState )
 {
     EventBits_t uxBits;
@@ -152,6 +390,19 @@ static BaseType_t prvClientGetState( BaseType_t xState )
     }
 }
 
+/* Clear a state and return whether it was set, in one step, so that of two tasks clearing it only one finds it set. */
+static BaseType_t prvClientTakeState( BaseType_t xState )
+{
+    if( ( xEventGroupClearBits( AIAClient.xState, xState ) & xState ) != 0 )
+    {
+        return pdTRUE;
+    }
+    else
+    {
+        return pdFALSE;
+    }
+}
+
 static BaseType_t prvClientWaitForState( BaseType_t xState, BaseType_t xClearOnExit, BaseType_t xWaitForAllStates, TickType_t xTicksToWait )
 {
     return xEventGroupWaitBits( AIAClient.xState,
@@ -161,7 +412,166 @@ static BaseType_t prvClientWaitForState( BaseType_t xState, BaseType_t xClearOnE
                                 xTicksToWait );
 }
 
-static BaseType_t prvClientPublishMessage( const char * pcTopic, const void * pvData, uint32_t ulLen )
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+
+static void prvClientWarmupSetPath( AIAWarmupPath_t xPath, BaseType_t xStart )
+{
+    if( xPath == eAIAWarmupSpeaker )
+    {
+        /* The speaker buffer is empty until OpenSpeaker, so the speaker plays silence. */
+        if( xStart == pdTRUE )
+        {
+            vPlatformSpeakerOpen();
+        }
+        else
+        {
+            vPlatformSpeakerClose();
+        }
+    }
+    else
+    {
+        /* The microphone task gives the slots back as they are filled, and the capture restarts on OpenMicrophone.
+         * The DMA keeps running, so the stream starts with the frame after the one under way, see vAIACaptureRestart().
+         */
+        if( xStart == pdTRUE )
+        {
+            prvClientSetState( AIA_STATE_MICROPHONE_WARM );
+            vPlatformMicrophoneOpen();
+        }
+        else
+        {
+            vPlatformMicrophoneClose();
+            prvClientClearState( AIA_STATE_MICROPHONE_WARM );
+        }
+    }
+}
+
+/* Arm the timer for the first hold to run out. */
+static void prvClientWarmupSchedule( void )
+{
+    TickType_t xNext;
+
+    taskENTER_CRITICAL();
+    xNext = xAIAWarmupNextExpiry( &xWarmup, xTaskGetTickCount() );
+    taskEXIT_CRITICAL();
+
+    if( xNext == portMAX_DELAY )
+    {
+        xTimerStop( xWarmupTimer, 0 );
+    }
+    else
+    {
+        xTimerChangePeriod( xWarmupTimer, ( xNext != 0 ) ? xNext : 1, 0 );
+    }
+}
+
+static void prvClientWarmupTimer( TimerHandle_t xTimer )
+{
+    BaseType_t xStop;
+
+    ( void )xTimer;
+    for( uint32_t i = 0; i < eAIAWarmupPathNum; i++ )
+    {
+        taskENTER_CRITICAL();
+        xStop = xAIAWarmupStop( &xWarmup, ( AIAWarmupPath_t )i, xTaskGetTickCount(), pdFALSE );
+        taskEXIT_CRITICAL();
+
+        if( xStop == pdTRUE )
+        {
+            prvClientWarmupSetPath( ( AIAWarmupPath_t )i, pdFALSE );
+        }
+    }
+    prvClientWarmupSchedule();
+}
+
+/* Start a path ahead of the directive likely to need it. */
+static void prvClientWarmup( AIAWarmupPath_t xPath )
+{
+    BaseType_t xStart;
+
+    taskENTER_CRITICAL();
+    xStart = xAIAWarmupStart( &xWarmup, xPath, xTaskGetTickCount() );
+    taskEXIT_CRITICAL();
+
+    if( xStart == pdTRUE )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: Warming up the %s\r\n", ( xPath == eAIAWarmupSpeaker ) ? "speaker" : "microphone" ) );
+        prvClientWarmupSetPath( xPath, pdTRUE );
+    }
+    prvClientWarmupSchedule();
+}
+
+/* Stop a warm path right away, as the directive it was started for will not come. */
+static void prvClientCooldown( AIAWarmupPath_t xPath )
+{
+    BaseType_t xStop;
+
+    taskENTER_CRITICAL();
+    xStop = xAIAWarmupStop( &xWarmup, xPath, xTaskGetTickCount(), pdTRUE );
+    taskEXIT_CRITICAL();
+
+    if( xStop == pdTRUE )
+    {
+        prvClientWarmupSetPath( xPath, pdFALSE );
+    }
+}
+
+/* Claim a path for a directive. Returns pdTRUE if it is running already. */
+static BaseType_t prvClientWarmupClaim( AIAWarmupPath_t xPath )
+{
+    BaseType_t xWarm;
+
+    taskENTER_CRITICAL();
+    xWarm = xAIAWarmupClaim( &xWarmup, xPath, xTaskGetTickCount() );
+    taskEXIT_CRITICAL();
+
+    return xWarm;
+}
+
+static BaseType_t prvClientWarmupClaimFromISR( AIAWarmupPath_t xPath )
+{
+    UBaseType_t uxSavedInterruptStatus;
+    BaseType_t xWarm;
+
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    xWarm = xAIAWarmupClaim( &xWarmup, xPath, xTaskGetTickCountFromISR() );
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+    return xWarm;
+}
+
+static void prvClientWarmupRelease( AIAWarmupPath_t xPath )
+{
+    taskENTER_CRITICAL();
+    vAIAWarmupRelease( &xWarmup, xPath );
+    taskEXIT_CRITICAL();
+
+    if( xPath == eAIAWarmupMicrophone )
+    {
+        prvClientClearState( AIA_STATE_MICROPHONE_WARM );
+    }
+}
+
+#ifdef DEBUG
+static void prvClientReportWarmup( AIAWarmupPath_t xPath )
+{
+    AIAWarmupStatistics_t xStatistics;
+
+    taskENTER_CRITICAL();
+    vAIAWarmupGetStatistics( &xWarmup, xPath, &xStatistics );
+    taskEXIT_CRITICAL();
+
+    configPRINTF_DEBUG( ( "DEBUG: %s warm-up used %u of %u times, %u ms active ahead of time, started in %u us cold and %u us warm, %u ms saved\r\n",
+                          ( xPath == eAIAWarmupSpeaker ) ? "Speaker" : "Microphone",
+                          xStatistics.ulHits, xStatistics.ulWarmups, xStatistics.ulExtraActiveMs,
+                          xStatistics.ulColdStartupUs, xStatistics.ulWarmStartupUs, xStatistics.ulSavedMs ) );
+}
+#endif
+
+#endif
+
+/* The payload is built into the packet by xAIAMqttSerializer, see aia_publish.h. */
+static BaseType_t prvClientPublish( const char * pcTopic, const AIAPublishPayload_t * pxPayload, uint32_t ulPayloadLength )
 {
     BaseType_t xReturned = pdPASS;
     IotMqttError_t xMqttStatus = IOT_MQTT_STATUS_PENDING;
@@ -170,8 +580,8 @@ static BaseType_t prvClientPublishMessage( const char * pcTopic, const void * pv
     xPublishInfo.pTopicName = pcTopic;
     xPublishInfo.topicNameLength = strlen( pcTopic );
     xPublishInfo.qos = IOT_MQTT_QOS_0;
-    xPublishInfo.pPayload = pvData;
-    xPublishInfo.payloadLength = ulLen;
+    xPublishInfo.pPayload = pxPayload;
+    xPublishInfo.payloadLength = ulPayloadLength;
 
     xMqttStatus = IotMqtt_Publish( AIAClient.xMqttConnection,
                                    &xPublishInfo,
@@ -192,6 +602,150 @@ static BaseType_t prvClientPublishMessage( const char * pcTopic, const void * pv
     return xReturned;
 }
 
+static BaseType_t prvClientPublishMessage( const char * pcTopic, const void * pvData, uint32_t ulLen )
+{
+    AIAPublishPayload_t xPayload = {
+        .pxCrypto = NULL,
+        .pvMessage = ( void * )pvData,
+        .ulMessageLength = ulLen,
+    };
+
+    return prvClientPublish( pcTopic, &xPayload, ulLen );
+}
+
+/* The plaintext is encrypted straight into the MQTT packet. AIA_MSG_PARAMS_SIZE_SEQ bytes preceding it are used
+ * for the sequence number.
+ */
+static BaseType_t prvClientPublishEncryptedMessage( const char * pcTopic, void * pvPlaintext, uint32_t ulLen, uint32_t ulSequence )
+{
+    AIAPublishPayload_t xPayload = {
+        .pxCrypto = &AIAClient.xCrypto,
+        .pvMessage = pvPlaintext,
+        .ulMessageLength = ulLen,
+        .ulSequence = ulSequence,
+    };
+
+    return prvClientPublish( pcTopic, &xPayload, AIA_MSG_ENCRYPTED_LENGTH( ulLen ) );
+}
+
+#ifdef DEBUG
+/* Starts the figures of an utterance at ulCyclesAtTap, from any task. */
+static void prvClientStartUtteranceStatistics( uint32_t ulCyclesAtTap )
+{
+    taskENTER_CRITICAL();
+    ulCyclesAtUtteranceStart = ulCyclesAtTap;
+    bUtteranceStartPending = true;
+    taskEXIT_CRITICAL();
+}
+
+static void prvClientStartUtteranceStatisticsFromISR( uint32_t ulCyclesAtTap )
+{
+    UBaseType_t uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+
+    ulCyclesAtUtteranceStart = ulCyclesAtTap;
+    bUtteranceStartPending = true;
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+}
+
+/* Called by the outbound task before each microphone message it publishes. */
+static void prvClientResetUtteranceStatistics( void )
+{
+    bool bStart;
+
+    taskENTER_CRITICAL();
+    bStart = bUtteranceStartPending;
+    if( bStart == true )
+    {
+        bUtteranceStartPending = false;
+        ulCyclesAtMicrophoneTap = ulCyclesAtUtteranceStart;
+    }
+    taskEXIT_CRITICAL();
+
+    if( bStart == true )
+    {
+        bFirstMicrophoneMessagePending = true;
+        ulTapToFirstMessageUs = 0;
+        ulMicrophoneMessages = 0;
+        ulMicrophoneAudioBytes = 0;
+        ulMicrophoneOverheadBytes = 0;
+        vAIACycleMeterReset( &xMicrophonePublishMeter );
+#if ( aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS > 0 )
+        ulInjectedStalls = 0;
+#endif
+    }
+}
+
+static void prvClientUpdateUtteranceStatistics( const AIAOutboundMessage_t * pxMessage )
+{
+    uint32_t ulAudioBytes = pxMessage->ulLength - sizeof( AIABinaryHeader_t ) - sizeof( uint64_t );
+    /* The MQTT fixed header with a two-byte remaining length, the topic and the encrypted message. */
+    uint32_t ulWireBytes = 1 + 2 + 2 + strlen( pxMessage->pcTopic ) + AIA_MSG_ENCRYPTED_LENGTH( pxMessage->ulLength );
+
+    if( bFirstMicrophoneMessagePending == true )
+    {
+        bFirstMicrophoneMessagePending = false;
+        ulTapToFirstMessageUs = ( uint32_t )( ( uint64_t )( ulPlatformGetCycleCount() - ulCyclesAtMicrophoneTap ) *
+                                              1000000UL / configCPU_CLOCK_HZ );
+    }
+    ulMicrophoneMessages++;
+    ulMicrophoneAudioBytes += ulAudioBytes;
+    ulMicrophoneOverheadBytes += ulWireBytes - ulAudioBytes;
+}
+#endif
+
+/* Called by the outbound task for each event and audio message it publishes. */
+static BaseType_t prvClientPublishOutbound( const AIAOutboundMessage_t * pxMessage )
+{
+    BaseType_t xReturned;
+
+#ifdef DEBUG
+    bool bMicrophone = ( pxMessage->pulSequence == &AIAClient.xMicrophone.ulMicrophoneSequence );
+
+    if( bMicrophone == true )
+    {
+        prvClientResetUtteranceStatistics();
+    }
+
+#if ( aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS > 0 )
+    if( bMicrophone == true && ( ulMicrophoneMessages + 1 ) % aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_INTERVAL == 0 )
+    {
+        /* Simulate a network stall. */
+        vTaskDelay( pdMS_TO_TICKS( aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS ) );
+        ulInjectedStalls++;
+    }
+#endif
+
+    if( bMicrophone == true )
+    {
+        vAIACycleMeterStart( &xMicrophonePublishMeter );
+    }
+#endif
+
+    xReturned = prvClientPublishEncryptedMessage( pxMessage->pcTopic,
+                                                  pxMessage->pvPlaintext,
+                                                  pxMessage->ulLength,
+                                                  *pxMessage->pulSequence );
+#ifdef DEBUG
+    if( bMicrophone == true && xReturned == pdPASS )
+    {
+        vAIACycleMeterStop( &xMicrophonePublishMeter );
+        prvClientUpdateUtteranceStatistics( pxMessage );
+    }
+#endif
+
+    if( xReturned == pdPASS )
+    {
+        ( *pxMessage->pulSequence )++;
+    }
+    else if( pxMessage->pulSequence == &AIAClient.xMicrophone.ulMicrophoneSequence && xDemoTaskHandle != NULL )
+    {
+        /* Streaming the microphone has failed. Signal the demo task. */
+        xTaskNotifyGive( xDemoTaskHandle );
+    }
+
+    return xReturned;
+}
+
 static void prvClientHandleTopicConnectionService( const uint8_t * pucMessage, uint32_t ulMessageLength )
 {
     jsmntok_t xJSMNTokens[ aiaconfigJSMN_MAX_TOKENS ];
@@ -241,178 +795,528 @@ static void prvClientHandleTopicConnectionService( const uint8_t * pucMessage, u
     }
 }
 
-static void prvClientHandleTopicSpeaker( const uint8_t * pucMessage, uint32_t ulMessageLength )
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+static void prvClientPlayoutArrival( const uint8_t * pucMessage, uint32_t ulMessageLength )
 {
-    AIAClient_Speaker_t * pxSpeaker = &AIAClient.xSpeaker;
-    uint32_t ulSequence = *( uint32_t * )pucMessage;
-    size_t xBytesRemainedBefore;
-    static uint32_t ulNextExpectedSeq;
-
-    configPRINTF_DEBUG( ( "DEBUG: /speaker msg length %d seq %u\r\n", ulMessageLength, ulSequence ) );
+    const AIABinaryHeader_t * pxBinaryHeader = ( const AIABinaryHeader_t * )( pucMessage + AIA_MSG_PARAMS_SIZE_SEQ );
+    const uint8_t * pucOffset = pucMessage + AIA_MSG_PARAMS_SIZE_SEQ + sizeof( AIABinaryHeader_t );
+    uint64_t ullOffset;
 
-    if( ulSequence < ulNextExpectedSeq )
+    /* Only messages starting with audio carry an offset to compare the arrival with. */
+    if( ulMessageLength < AIA_MSG_PARAMS_SIZE_SEQ + sizeof( AIABinaryHeader_t ) + sizeof( ullOffset ) ||
+        pxBinaryHeader->ucType != 0 )
     {
-        /* Skip the message of a smaller sequence number than expected.
-         * This is actually not consistent with AIA spec, which requires to replace
-         * the old message if a message with the same sequence number is received
-         * twice. In our current implementation using message buffer there's no way
-         * to arbitrarily replace data in the buffer.
-         * So far observation shows that the only circumstance that duplicate sequence
-         * messages are received is when overrun happens. Messages start with the sequence
-         * number specified in the event message will be resent by the server. And since
-         * the overrun event message won't take effect immediately, we will still receive
-         * messages before the server starts resending. Those which are within our
-         * resequencing range will be put into the resequencing buffer and pushed into
-         * the speaker buffer immediately following the expected message is resent and
-         * pushed.
-         * Sadly we cannot skip messages until the overrun message is received,because
-         * it can also happen that the resent messages are still out of order:)
-         * e.g.
-         *      Buffer overruns at: 42
-         *      Resequencing buffer size: 4
-         *                                               these 4 are ignored as they have been sent before
-         *                                                                  ^
-         *                                                             _____|______
-         *                                                             |    |  |  |
-         *      Message received on /speaker: 40 41 42 43 44 45 46 47 43 42 44 45 46 47 ...
-         *                                           ^                  ^
-         *                                           |                  |
-         *                            overrun message sent      43 is resent before 42
-         */
+        return;
     }
-    else if( ulSequence > ulNextExpectedSeq )
+
+    ullOffset = ( uint64_t )*( uint32_t * )( pucOffset + sizeof( uint32_t ) ) << 32 | *( uint32_t * )pucOffset;
+    taskENTER_CRITICAL();
+    vAIAPlayoutArrival( &xPlayout, ullOffset, xTaskGetTickCount() );
+    taskEXIT_CRITICAL();
+}
+
+/* Hold the speaker until the prebuffer is complete. */
+static void prvClientPlayoutPrebuffer( void )
+{
+    TickType_t xWait;
+
+    for( ; ; )
     {
-        if( ulSequence > ulNextExpectedSeq + aiaconfigAIA_SPEAKER_RESEQUENCING )
+        taskENTER_CRITICAL();
+        xWait = xAIAPlayoutPrebuffer( &xPlayout,
+                                      xAIASpeakerBufferBytesAvailable( &AIAClient.xSpeaker.xSpeakerBuffer ),
+                                      xTaskGetTickCount() );
+        taskEXIT_CRITICAL();
+        if( xWait == 0 )
         {
-            if( bBufferOverrun == false )
-            {
-                configPRINTF_DEBUG( ( "DEBUG: Unexpected sequence %u goes out of range while expecting %u!\r\n", ulSequence, ulNextExpectedSeq ) );
-                prvClientDisconnectFromAIA();
-                /* Signal the demo task. */
-                if( xDemoTaskHandle != NULL )
-                {
-                    xTaskNotifyGive( xDemoTaskHandle );
-                }
-            }
+            break;
         }
-        else
-        {
-            uint8_t ucIndex;
 
-            /* Calculate where the message should be put in the resequencing buffer. */
-            ucIndex = ( ulSequence - ulNextExpectedSeq - 1 + xReseqBuffer.ucStartIndex ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
-            memcpy( xReseqBuffer.xMessage[ ucIndex ].ucBuffer, ucAiaRecvMsg, ulMessageLength );
-            xReseqBuffer.xMessage[ ucIndex ].ulLen = ulMessageLength;
+        /* Check the buffer again every frame, as it may fill up before the time runs out. */
+        if( xWait > pdMS_TO_TICKS( aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS ) )
+        {
+            xWait = pdMS_TO_TICKS( aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
         }
+        vTaskDelay( xWait );
     }
-    else
-    {
-        void * pvData;
-        size_t xDataLen;
-        bool bContinue;
-        AIABufferStateChanged_t xBufferStateChanged;
+}
 
-        if( bBufferOverrun == true )
+/* Take the measurements of the stream closed into the target, and propose the thresholds if they have moved. The
+ * thresholds in use only change once the service accepts them, see prvClientPlayoutAcknowledge().
+ */
+static void prvClientPlayoutStreamEnd( uint64_t ullCloseOffset )
+{
+    BaseType_t xProposed;
+    uint32_t ulOverrunWarning;
+    uint32_t ulUnderrunWarning;
+    AIAPlayoutStatistics_t xStatistics;
+
+    taskENTER_CRITICAL();
+    xProposed = xAIAPlayoutStreamEnd( &xPlayout, ullCloseOffset );
+    vAIAPlayoutGetProposedThresholds( &xPlayout, &ulOverrunWarning, &ulUnderrunWarning );
+    vAIAPlayoutGetStatistics( &xPlayout, &xStatistics );
+    taskEXIT_CRITICAL();
+
+    configPRINTF_DEBUG( ( "DEBUG: Playout jitter %u ms, max %u ms, prebuffer target %u ms, %u underruns in %u streams\r\n",
+                          xStatistics.ulLastJitterMs, xStatistics.ulMaxJitterMs, xStatistics.ulTargetMs,
+                          xStatistics.ulUnderruns, xStatistics.ulStreams ) );
+
+    if( xProposed == pdTRUE )
+    {
+        configPRINTF( ( "Proposing speaker buffer warnings at %u and %u bytes\r\n", ulOverrunWarning, ulUnderrunWarning ) );
+        xTimerReset( xCapabilitiesTimer, 0 );
+        if( prvClientQueueCapabilities( ulOverrunWarning, ulUnderrunWarning ) != pdPASS )
         {
-            bBufferOverrun = false;
-
-            /* If microphone was opened during overrun state, which is the case when media playback
-             * is interrupted by a new user request, drop the messages in the resequence buffer as
-             * messages of the same sequence number but different contents will be sent by the server.
-             */
-            if( bMicrophoneOpenedDuringOverrun == true )
-            {
-                bMicrophoneOpenedDuringOverrun = false;
-                for( int i = 0; i < aiaconfigAIA_SPEAKER_RESEQUENCING; i++ )
-                {
-                   xReseqBuffer.xMessage[ i ].ulLen = 0;
-                }
-            }
+            configPRINTF( ( "Failed to publish capabilities!\r\n" ) );
+            xTimerStop( xCapabilitiesTimer, 0 );
+            taskENTER_CRITICAL();
+            ( void )xAIAPlayoutAcknowledge( &xPlayout, pdFALSE );
+            taskEXIT_CRITICAL();
         }
+    }
+}
 
-        pvData = ( void * )ucAiaRecvMsg;
-        xDataLen = ulMessageLength;
+/* Settle the thresholds proposed, on the capabilities acknowledgement or its timeout. */
+static void prvClientPlayoutAcknowledge( BaseType_t xAccepted )
+{
+    BaseType_t xSettled;
+    uint32_t ulOverrunWarning;
+    uint32_t ulUnderrunWarning;
+
+    taskENTER_CRITICAL();
+    xSettled = xAIAPlayoutAcknowledge( &xPlayout, xAccepted );
+    vAIAPlayoutGetThresholds( &xPlayout, &ulOverrunWarning, &ulUnderrunWarning );
+    if( xSettled == pdTRUE )
+    {
+        AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning = ulOverrunWarning;
+        AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning = ulUnderrunWarning;
+    }
+    taskEXIT_CRITICAL();
 
-        do
-        {
-            bContinue = false;
+    if( xSettled == pdTRUE )
+    {
+        xTimerStop( xCapabilitiesTimer, 0 );
+        configPRINTF( ( "Speaker buffer warnings at %u and %u bytes%s\r\n", ulOverrunWarning, ulUnderrunWarning,
+                        ( xAccepted == pdTRUE ) ? "" : ", the proposal was not accepted" ) );
+    }
+}
 
-            xBytesRemainedBefore = xStreamBufferBytesAvailable( ( StreamBufferHandle_t )pxSpeaker->xSpeakerBuffer );
-            if( xMessageBufferSend( pxSpeaker->xSpeakerBuffer, pvData, xDataLen, pdMS_TO_TICKS( 100 ) ) == 0 )
-            {
-                /* According to the spec, overrun event should only be sent when the speaker is opened. If it's
-                 * closed, new data should be added to the buffer and old data dropped if the buffer runs out.
-                 * It is not handled accordingly here, as it requires extra logic but is only a corner case which
-                 * barely happens.
-                 */
-                configPRINTF_DEBUG( ( "DEBUG: Speaker buffer overruns!\r\n" ) );
-                bBufferOverrun = true;
+static void prvClientCapabilitiesTimer( TimerHandle_t xTimer )
+{
+    ( void )xTimer;
+    prvClientPlayoutAcknowledge( pdFALSE );
+}
+#endif
 
-                if( prvClientGetState( AIA_STATE_MICROPHONE_OPENED ) == pdTRUE )
-                {
-                    bMicrophoneOpenedDuringOverrun = true;
-                }
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+static void prvClientReportGaps( void )
+{
+    configPRINTF_DEBUG( ( "DEBUG: Speaker gaps %u, filled %u, resends %u, resent %u, lost %u of %u messages, %u frames concealed\r\n",
+                          xGapStatistics.ulGaps, xGapStatistics.ulFilled, xGapStatistics.ulResends,
+                          xGapStatistics.ulResent, xGapStatistics.ulLost, xGapStatistics.ulLostMessages,
+                          xGapStatistics.ulConcealedFrames ) );
+}
 
-                /* Reset the resequence buffer as the following messages will be resent by AIA. */
-                for( int i = 0; i < aiaconfigAIA_SPEAKER_RESEQUENCING; i++ )
-                {
-                    xReseqBuffer.xMessage[ i ].ulLen = 0;
-                }
+static void prvClientSpeakerGapTimer( TimerHandle_t xTimer )
+{
+    AIABufferStateChanged_t xBufferStateChanged;
+    AIAClient_Gap_t xGap;
+    BaseType_t xResend;
 
-                xBufferStateChanged.ulSequence = ulNextExpectedSeq;
-                xBufferStateChanged.pcBufferStateStr = "OVERRUN";
+    ( void )xTimer;
 
-                /* Only send this event while speaker is open. In case it is not, discard old data. */
-                vTaskSuspendAll();
+    /* OVERRUN is only to be sent while the speaker is open. Otherwise the gap is given up on at once. */
+    xResend = prvClientGetState( AIA_STATE_SPEAKER_OPENED );
 
-                if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) == pdTRUE )
-                {
-                    xTaskResumeAll();
-                    prvClientBufferStateChanged( xBufferStateChanged );
-                }
-                else
-                {
-                    do
-                    {
-                        xMessageBufferReceive( pxSpeaker->xSpeakerBuffer, ucDecodeTaskTemp, sizeof( ucDecodeTaskTemp ), 0 );
-                    } while( xMessageBufferSend( pxSpeaker->xSpeakerBuffer, pvData, xDataLen, 0 ) == 0 );
-                    ulNextExpectedSeq++;
-                    xTaskResumeAll();
-                }
+    taskENTER_CRITICAL();
+    xGap = xSpeakerGap;
+    if( xGap == eAIAGapWaiting && xResend == pdTRUE )
+    {
+        xSpeakerGap = eAIAGapResendRequested;
+    }
+    else if( xGap != eAIAGapNone )
+    {
+        xSpeakerGap = eAIAGapLost;
+    }
+    taskEXIT_CRITICAL();
+
+    if( xGap == eAIAGapWaiting && xResend == pdTRUE )
+    {
+        /* Ask for everything from the first missing message on, as for an overrun. */
+        configPRINTF( ( "Speaker sequence %u is missing, asking for a resend\r\n", ulGapSequence ) );
+        xGapStatistics.ulResends++;
+        xBufferStateChanged.ulSequence = ulGapSequence;
+        xBufferStateChanged.pcBufferStateStr = "OVERRUN";
+        prvClientBufferStateChanged( xBufferStateChanged );
+        xTimerChangePeriod( xGapTimer, pdMS_TO_TICKS( aiaconfigCLIENT_SPEAKER_GAP_RESEND_MS ), 0 );
+    }
+    else if( xGap != eAIAGapNone )
+    {
+        configPRINTF( ( "Speaker sequence %u has not come, playing on without it\r\n", ulGapSequence ) );
+    }
+}
+
+/* Called from the /speaker handler when a message lands beyond the resequencing range of ulNextExpectedSeq. */
+static void prvClientSpeakerGap( uint32_t ulNextExpectedSeq )
+{
+    BaseType_t xStart = pdFALSE;
+
+    taskENTER_CRITICAL();
+    if( xSpeakerGap == eAIAGapNone )
+    {
+        xSpeakerGap = eAIAGapWaiting;
+        xStart = pdTRUE;
+    }
+    taskEXIT_CRITICAL();
+
+    if( xStart == pdTRUE )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: Speaker sequence %u is missing, waiting for it\r\n", ulNextExpectedSeq ) );
+        ulGapSequence = ulNextExpectedSeq;
+        xGapStatistics.ulGaps++;
+        xTimerChangePeriod( xGapTimer, pdMS_TO_TICKS( aiaconfigCLIENT_SPEAKER_GAP_WAIT_MS ), 0 );
+    }
+}
+
+/* Called from the /speaker handler as the expected message comes in. */
+static void prvClientSpeakerGapFilled( void )
+{
+    AIAClient_Gap_t xGap;
+
+    taskENTER_CRITICAL();
+    xGap = xSpeakerGap;
+    xSpeakerGap = eAIAGapNone;
+    taskEXIT_CRITICAL();
+
+    if( xGap != eAIAGapNone )
+    {
+        xTimerStop( xGapTimer, 0 );
+        if( xGap == eAIAGapWaiting )
+        {
+            xGapStatistics.ulFilled++;
+        }
+        else
+        {
+            xGapStatistics.ulResent++;
+        }
+        prvClientReportGaps();
+    }
+}
+#endif
+
+/* While the speaker is closed, new audio replaces the oldest in the speaker buffer. Returns the length written. */
+static size_t prvClientSpeakerSendDropOldest( const void * pvData, size_t xDataLen )
+{
+    size_t xDataSent;
+    uint32_t ulDropped;
+
+#ifdef DEBUG
+    vAIACycleMeterStart( &xDropOldestMeter );
+#endif
+    xDataSent = xAIASpeakerBufferSendDropOldest( &AIAClient.xSpeaker.xSpeakerBuffer, pvData, xDataLen, &ulDropped );
+#ifdef DEBUG
+    vAIACycleMeterStop( &xDropOldestMeter );
+    ulDroppedWhileClosed += ulDropped;
+#else
+    ( void )ulDropped;
+#endif
+
+    return xDataSent;
+}
+
+/* Write the expected /speaker message to the speaker buffer, followed by those in order after it in the resequencing
+ * buffer, and advance the expected sequence number past them.
+ */
+static void prvClientSpeakerPush( uint8_t * pucMessage,
+                                  uint32_t ulMessageLength,
+                                  uint32_t ulSequence,
+                                  uint32_t * pulNextExpectedSeq )
+{
+    AIAClient_Speaker_t * pxSpeaker = &AIAClient.xSpeaker;
+    size_t xBytesRemainedBefore;
+    void * pvData;
+    size_t xDataLen;
+    size_t xDataSent;
+    bool bContinue;
+    AIABufferStateChanged_t xBufferStateChanged;
+    uint8_t * pucSentFromReseq;
+    uint8_t * pucNextFromReseq = NULL;
+
+    if( bBufferOverrun == true )
+    {
+        bBufferOverrun = false;
+
+        /* If microphone was opened during overrun state, which is the case when media playback
+         * is interrupted by a new user request, drop the messages in the resequence buffer as
+         * messages of the same sequence number but different contents will be sent by the server.
+         */
+        if( bMicrophoneOpenedDuringOverrun == true )
+        {
+            bMicrophoneOpenedDuringOverrun = false;
+            prvClientResetResequenceBuffer();
+        }
+    }
+
+    pvData = ( void * )pucMessage;
+    xDataLen = ulMessageLength;
+
+    do
+    {
+        bContinue = false;
+        pucSentFromReseq = pucNextFromReseq;
+        pucNextFromReseq = NULL;
 
+        xBytesRemainedBefore = xAIASpeakerBufferBytesAvailable( &pxSpeaker->xSpeakerBuffer );
+        if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) != pdTRUE &&
+            prvClientGetState( AIA_STATE_OPENSPEAKER_RECEIVED ) != pdTRUE )
+        {
+            /* According to the spec, overrun event should only be sent when the speaker is opened. If it's
+             * closed, new data should be added to the buffer and old data dropped if the buffer runs out.
+             */
+            xDataSent = prvClientSpeakerSendDropOldest( pvData, xDataLen );
+        }
+        else
+        {
+            xDataSent = xAIASpeakerBufferSend( &pxSpeaker->xSpeakerBuffer, pvData, xDataLen, pdMS_TO_TICKS( 100 ) );
+            if( xDataSent == 0 && prvClientGetState( AIA_STATE_SPEAKER_OPENED ) != pdTRUE )
+            {
+                xDataSent = prvClientSpeakerSendDropOldest( pvData, xDataLen );
             }
-            else
+        }
+
+        if( xDataSent == 0 )
+        {
+            configPRINTF_DEBUG( ( "DEBUG: Speaker buffer overruns!\r\n" ) );
+            bBufferOverrun = true;
+
+            if( prvClientGetState( AIA_STATE_MICROPHONE_OPENED ) == pdTRUE )
             {
-                /* Send the overrun warning only when speaker is still opened and
-                 * the buffer goes from a good state to a warning state.
-                 */
-                if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) == pdTRUE &&
-                    xBytesRemainedBefore < pxSpeaker->ulSpeakerBufferOverrunWarning &&
-                    xStreamBufferBytesAvailable( ( StreamBufferHandle_t )pxSpeaker->xSpeakerBuffer ) >= pxSpeaker->ulSpeakerBufferOverrunWarning )
-                {
-                    xBufferStateChanged.ulSequence = ulSequence;
-                    xBufferStateChanged.pcBufferStateStr = "OVERRUN_WARNING";
-                    prvClientBufferStateChanged( xBufferStateChanged );
-                }
+                bMicrophoneOpenedDuringOverrun = true;
+            }
 
-                /* If the next slot in the resequencing buffer has valid data,
-                 * prepare to push it to the speaker buffer.
-                 */
-                uint8_t ucNextIndex = xReseqBuffer.ucStartIndex;
-                if( xReseqBuffer.xMessage[ ucNextIndex ].ulLen != 0 )
+            /* Reset the resequence buffer as the following messages will be resent by AIA. */
+            prvClientResetResequenceBuffer();
+
+            xBufferStateChanged.ulSequence = *pulNextExpectedSeq;
+            xBufferStateChanged.pcBufferStateStr = "OVERRUN";
+            prvClientBufferStateChanged( xBufferStateChanged );
+        }
+        else
+        {
+            /* Send the overrun warning only when speaker is still opened and
+             * the buffer goes from a good state to a warning state.
+             */
+            if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) == pdTRUE &&
+                xBytesRemainedBefore < pxSpeaker->ulSpeakerBufferOverrunWarning &&
+                xAIASpeakerBufferBytesAvailable( &pxSpeaker->xSpeakerBuffer ) >= pxSpeaker->ulSpeakerBufferOverrunWarning )
+            {
+                xBufferStateChanged.ulSequence = ulSequence;
+                xBufferStateChanged.pcBufferStateStr = "OVERRUN_WARNING";
+                prvClientBufferStateChanged( xBufferStateChanged );
+            }
+
+            /* If the next slot in the resequencing buffer has valid data,
+             * prepare to push it to the speaker buffer.
+             */
+            uint8_t ucNextIndex = xReseqBuffer.ucStartIndex;
+            if( xReseqBuffer.xMessage[ ucNextIndex ].ulLen != 0 )
+            {
+                pucNextFromReseq = xReseqBuffer.xMessage[ ucNextIndex ].pucBuffer;
+                pvData = pucNextFromReseq;
+                xDataLen = xReseqBuffer.xMessage[ ucNextIndex ].ulLen;
+                xReseqBuffer.xMessage[ ucNextIndex ].ulLen = 0;
+                bContinue = true;
+            }
+
+            xReseqBuffer.ucStartIndex = ( ucNextIndex + 1 ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
+            ( *pulNextExpectedSeq )++;
+        }
+
+        /* The message has been copied to the speaker buffer or dropped. Give its receive buffer back. */
+        if( pucSentFromReseq != NULL )
+        {
+            vAIARecvPoolFree( pucSentFromReseq );
+        }
+    } while( bContinue );
+}
+
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+/* Let the speaker task know whether audio after the expected message has come, for it to conceal what is late. */
+static void prvClientUpdateAudioAhead( void )
+{
+    bool bAhead = false;
+
+    for( int i = 0; i < aiaconfigAIA_SPEAKER_RESEQUENCING; i++ )
+    {
+        if( xReseqBuffer.xMessage[ i ].ulLen != 0 )
+        {
+            bAhead = true;
+        }
+    }
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+    if( xSpeakerGap != eAIAGapNone )
+    {
+        bAhead = true;
+    }
+#endif
+    bSpeakerAudioAhead = bAhead;
+}
+#endif
+
+static void prvClientHandleTopicSpeaker( const uint8_t * pucMessage, uint32_t ulMessageLength )
+{
+    uint32_t ulSequence = *( uint32_t * )pucMessage;
+    static uint32_t ulNextExpectedSeq;
+
+    configPRINTF_DEBUG( ( "DEBUG: /speaker msg length %d seq %u\r\n", ulMessageLength, ulSequence ) );
+
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+    if( ulSequence >= ulNextExpectedSeq )
+    {
+        prvClientPlayoutArrival( pucMessage, ulMessageLength );
+    }
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+    if( xSpeakerGap == eAIAGapResendRequested )
+    {
+        /* Messages of the same sequence numbers are resent, as for an overrun. */
+        taskENTER_CRITICAL();
+        if( xSpeakerGap == eAIAGapResendRequested )
+        {
+            xSpeakerGap = eAIAGapResending;
+        }
+        taskEXIT_CRITICAL();
+        bBufferOverrun = true;
+        prvClientResetResequenceBuffer();
+    }
+    else if( xSpeakerGap == eAIAGapLost && ulSequence > ulNextExpectedSeq )
+    {
+        uint8_t * pucHeld = NULL;
+        uint32_t ulHeldLength = 0;
+        uint32_t ulMissing;
+
+        /* Give up on the missing messages only. The lowest message held after them is played as if it were the one
+         * expected, with those following it in the resequencing buffer, and this one is handled after them.
+         */
+        taskENTER_CRITICAL();
+        xSpeakerGap = eAIAGapNone;
+        taskEXIT_CRITICAL();
+        bBufferOverrun = false;
+
+        for( ulMissing = 1; ulMissing <= aiaconfigAIA_SPEAKER_RESEQUENCING; ulMissing++ )
+        {
+            uint8_t ucIndex = ( xReseqBuffer.ucStartIndex + ulMissing - 1 ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
+
+            if( xReseqBuffer.xMessage[ ucIndex ].ulLen != 0 )
+            {
+                pucHeld = xReseqBuffer.xMessage[ ucIndex ].pucBuffer;
+                ulHeldLength = xReseqBuffer.xMessage[ ucIndex ].ulLen;
+                xReseqBuffer.xMessage[ ucIndex ].ulLen = 0;
+                xReseqBuffer.ucStartIndex = ( ucIndex + 1 ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
+                break;
+            }
+        }
+
+        if( pucHeld != NULL )
+        {
+            ulNextExpectedSeq += ulMissing;
+            configPRINTF_DEBUG( ( "DEBUG: Playing on from held speaker sequence %u\r\n", ulNextExpectedSeq ) );
+            prvClientSpeakerPush( pucHeld, ulHeldLength, ulNextExpectedSeq, &ulNextExpectedSeq );
+            vAIARecvPoolFree( pucHeld );
+        }
+        else
+        {
+            /* Nothing is held, play on from this one. */
+            ulMissing = ulSequence - ulNextExpectedSeq;
+            ulNextExpectedSeq = ulSequence;
+        }
+        xGapStatistics.ulLost++;
+        xGapStatistics.ulLostMessages += ulMissing;
+        prvClientReportGaps();
+    }
+#endif
+
+    if( ulSequence < ulNextExpectedSeq )
+    {
+        /* Skip the message of a smaller sequence number than expected.
+         * This is actually not consistent with AIA spec, which requires to replace
+         * the old message if a message with the same sequence number is received
+         * twice. In our current implementation using message buffer there's no way
+         * to arbitrarily replace data in the buffer.
+         * So far observation shows that the only circumstance that duplicate sequence
+         * messages are received is when overrun happens. Messages start with the sequence
+         * number specified in the event message will be resent by the server. And since
+         * the overrun event message won't take effect immediately, we will still receive
+         * messages before the server starts resending. Those which are within our
+         * resequencing range will be put into the resequencing buffer and pushed into
+         * the speaker buffer immediately following the expected message is resent and
+         * pushed.
+         * Sadly we cannot skip messages until the overrun message is received,because
+         * it can also happen that the resent messages are still out of order:)
+         * e.g.
+         *      Buffer overruns at: 42
+         *      Resequencing buffer size: 4
+         *                                               these 4 are ignored as they have been sent before
+         *                                                                  ^
+         *                                                             _____|______
+         *                                                             |    |  |  |
+         *      Message received on /speaker: 40 41 42 43 44 45 46 47 43 42 44 45 46 47 ...
+         *                                           ^                  ^
+         *                                           |                  |
+         *                            overrun message sent      43 is resent before 42
+         */
+    }
+    else if( ulSequence > ulNextExpectedSeq )
+    {
+        if( ulSequence > ulNextExpectedSeq + aiaconfigAIA_SPEAKER_RESEQUENCING )
+        {
+            if( bBufferOverrun == false )
+            {
+                configPRINTF_DEBUG( ( "DEBUG: Unexpected sequence %u goes out of range while expecting %u!\r\n", ulSequence, ulNextExpectedSeq ) );
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+                /* The message is dropped. It is resent along with the missing ones if they do not turn up. */
+                prvClientSpeakerGap( ulNextExpectedSeq );
+#else
+                prvClientDisconnectFromAIA();
+                /* Signal the demo task. */
+                if( xDemoTaskHandle != NULL )
                 {
-                    pvData = xReseqBuffer.xMessage[ ucNextIndex ].ucBuffer;
-                    xDataLen = xReseqBuffer.xMessage[ ucNextIndex ].ulLen;
-                    xReseqBuffer.xMessage[ ucNextIndex ].ulLen = 0;
-                    bContinue = true;
+                    xTaskNotifyGive( xDemoTaskHandle );
                 }
+#endif
+            }
+        }
+        else
+        {
+            uint8_t ucIndex;
 
-                xReseqBuffer.ucStartIndex = ( ucNextIndex + 1 ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
-                ulNextExpectedSeq++;
+            /* Calculate where the message should be put in the resequencing buffer. */
+            ucIndex = ( ulSequence - ulNextExpectedSeq - 1 + xReseqBuffer.ucStartIndex ) % aiaconfigAIA_SPEAKER_RESEQUENCING;
+            if( xReseqBuffer.xMessage[ ucIndex ].ulLen != 0 )
+            {
+                vAIARecvPoolFree( xReseqBuffer.xMessage[ ucIndex ].pucBuffer );
             }
-        } while( bContinue );
+
+            /* Keep the message in the MQTT receive buffer, which is taken over from MQTT, rather than copy it. */
+            xReseqBuffer.xMessage[ ucIndex ].pucBuffer = pvAIARecvPoolRetain( pucMessage, ulMessageLength );
+            configASSERT( xReseqBuffer.xMessage[ ucIndex ].pucBuffer != NULL );
+            xReseqBuffer.xMessage[ ucIndex ].ulLen = ulMessageLength;
+        }
+    }
+    else
+    {
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+        prvClientSpeakerGapFilled();
+#endif
+
+        prvClientSpeakerPush( ( uint8_t * )pucMessage, ulMessageLength, ulSequence, &ulNextExpectedSeq );
     }
 
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+    prvClientUpdateAudioAhead();
+#endif
+
     return;
 }
 
@@ -439,11 +1343,17 @@ static void prvClientHandleTopicCapabilitiesAck( const uint8_t * pucMessage, uin
     if( xIsStringEqual( pucMessage + pxJSMNToken->start, pxJSMNToken->end - pxJSMNToken->start, "CAPABILITIES_ACCEPTED" ) == pdTRUE )
     {
         configPRINTF( ( "AIA has accepted the capabilities!\r\n" ) );
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+        prvClientPlayoutAcknowledge( pdTRUE );
+#endif
         prvClientSetState( AIA_STATE_CAPABILITIES_ACCEPTED );
     }
     else
     {
         vPrintJSONString( "AIA has rejected the capabilities! Description: ", pucMessage, pxJSMNToken->start, pxJSMNToken->end );
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+        prvClientPlayoutAcknowledge( pdFALSE );
+#endif
         prvClientSetState( AIA_STATE_CAPABILITIES_REJECTED );
     }
 }
@@ -531,10 +1441,9 @@ static void prvClientHandleTopicDirective( const uint8_t * pucMessage, uint32_t
     pxBufferList = &AIAClient.xDirectiveBufferList;
     if( ulSequence != ulExpectSequence )
     {
-        /* When a message is received out of order, allocate a memory to store this message and put it into the list. */
-        pucMessageCopy = ( uint8_t * )pvPortMalloc( ulMessageLength );
+        /* When a message is received out of order, keep it and put it into the list. */
+        pucMessageCopy = ( uint8_t * )pvAIARecvPoolRetain( pucMessage, ulMessageLength );
         configASSERT( pucMessageCopy != NULL );
-        memcpy( pucMessageCopy, pucMessage, ulMessageLength );
         xReturned = xAIABufferListInsert( pxBufferList, pucMessageCopy, ulMessageLength );
         configASSERT( xReturned == pdPASS );
     }
@@ -550,7 +1459,7 @@ static void prvClientHandleTopicDirective( const uint8_t * pucMessage, uint32_t
                 /* When the first message in the list has the expected sequence number, pop it out and process it. */
                 ulMessageLength = xAIABufferListPopFirstMessage( pxBufferList, ( const void ** )&pucMessageCopy );
                 prvProcessDirective( pucMessageCopy, ulMessageLength );
-                vPortFree( pucMessageCopy );
+                vAIARecvPoolFree( pucMessageCopy );
             }
             else
             {
@@ -560,6 +1469,90 @@ static void prvClientHandleTopicDirective( const uint8_t * pucMessage, uint32_t
     }
 }
 
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+/* Leave an action to the speaker task, to take when it gets to ullOffset. Returns pdFALSE if it is to be taken now,
+ * as no audio is coming or too many actions are waiting.
+ */
+static BaseType_t prvClientScheduleAtOffset( uint64_t ullOffset, AIAClient_OffsetAction_t xAction, uint32_t ulValue )
+{
+    BaseType_t xScheduled;
+
+    if( prvClientGetState( AIA_STATE_SPEAKER_OPENED | AIA_STATE_OPENSPEAKER_RECEIVED ) != pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+    taskENTER_CRITICAL();
+    xScheduled = xAIAOffsetSchedAdd( &xOffsetActions, ullOffset, ( uint32_t )xAction, ulValue );
+    taskEXIT_CRITICAL();
+    configPRINTF_DEBUG( ( "DEBUG: Action %u at offset %u %s\r\n", ( uint32_t )xAction, ( uint32_t )ullOffset,
+                          ( xScheduled == pdPASS ) ? "scheduled" : "taken now" ) );
+
+    return ( xScheduled == pdPASS ) ? pdTRUE : pdFALSE;
+}
+#endif
+
+static void prvClientSetAttentionState( EventBits_t xState )
+{
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    BaseType_t xWasSpeaking = prvClientGetState( AIA_STATE_ALEXA_SPEAKING );
+#endif
+
+    prvClientClearState( AIA_STATE_ALEXA_MASK );
+    if( xState == AIA_STATE_ALEXA_IDLE )
+    {
+        configPRINTF( ( "Switching to IDLE state.\r\n" ) );
+        prvClientSetState( AIA_STATE_ALEXA_IDLE );
+        vPlatformTouchButtonEnable();
+        vPlatformLEDOn();
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+        /* Nothing is going to be said. */
+        prvClientCooldown( eAIAWarmupSpeaker );
+#endif
+    }
+    else if( xState == AIA_STATE_ALEXA_THINKING )
+    {
+        configPRINTF( ( "Switching to THINKING state.\r\n" ) );
+        prvClientSetState( AIA_STATE_ALEXA_THINKING );
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+        /* OpenSpeaker usually follows with the answer. */
+        prvClientWarmup( eAIAWarmupSpeaker );
+#endif
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 ) && defined( DEBUG )
+        if( bEndOfSpeechDetected == true )
+        {
+            bEndOfSpeechDetected = false;
+            configPRINTF_DEBUG( ( "DEBUG: THINKING %u ms after the end of speech\r\n",
+                                  ( uint32_t )( ( xTaskGetTickCount() - xTickAtEndOfSpeech ) * portTICK_PERIOD_MS ) ) );
+        }
+#endif
+    }
+    else if( xState == AIA_STATE_ALEXA_SPEAKING )
+    {
+        configPRINTF( ( "Switching to SPEAKING state.\r\n" ) );
+        prvClientSetState( AIA_STATE_ALEXA_SPEAKING );
+#if ( aiaconfigCLIENT_AEC == 1 )
+        /* The echo of the speech is cancelled, so users can barge in. */
+        vPlatformTouchButtonEnable();
+#endif
+    }
+    else if( xState == AIA_STATE_ALEXA_ALERTING )
+    {
+        configPRINTF( ( "Switching to ALERTING state.\r\n" ) );
+        prvClientSetState( AIA_STATE_ALEXA_ALERTING );
+    }
+
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    /* A follow-up question opens the microphone soon after the answer. While listening for the wake word, the
+     * microphone runs anyway. */
+    if( xWasSpeaking == pdTRUE && prvClientGetState( AIA_STATE_ALEXA_SPEAKING ) != pdTRUE &&
+        prvClientGetState( AIA_STATE_MICROPHONE_OPENED | AIA_STATE_MICROPHONE_LISTENING ) != pdTRUE )
+    {
+        prvClientWarmup( eAIAWarmupMicrophone );
+    }
+#endif
+}
+
 static void prvClientHandleDirectiveSetAttentionState( const uint8_t * pucMessage,
                                                        const jsmntok_t * pxJSMNToken,
                                                        const jsmntok_t * pxJSMNTokenEndMarker,
@@ -568,6 +1561,7 @@ static void prvClientHandleDirectiveSetAttentionState( const uint8_t * pucMessag
     const uint8_t * pucState;
     const jsmntok_t * pxJSMNTokenTemp;
     size_t xStateLength;
+    EventBits_t xState = 0;
 
     *pucDirectiveTokenSize = AIA_MSGTOKENSIZE_SETATTENTIONSTATE;
     pxJSMNTokenTemp = &pxJSMNToken[ AIA_MSGTOKENPOS_SETATTENTIONSTATE_STATE ];
@@ -575,28 +1569,21 @@ static void prvClientHandleDirectiveSetAttentionState( const uint8_t * pucMessag
     pucState = pucMessage + pxJSMNTokenTemp->start;
     xStateLength = pxJSMNTokenTemp->end - pxJSMNTokenTemp->start;
 
-    prvClientClearState( AIA_STATE_ALEXA_MASK );
     if( xIsStringEqual( pucState, xStateLength, "IDLE" ) == pdTRUE )
     {
-        configPRINTF( ( "Switching to IDLE state.\r\n" ) );
-        prvClientSetState( AIA_STATE_ALEXA_IDLE );
-        vPlatformTouchButtonEnable();
-        vPlatformLEDOn();
+        xState = AIA_STATE_ALEXA_IDLE;
     }
     else if( xIsStringEqual( pucState, xStateLength, "THINKING" ) == pdTRUE )
     {
-        configPRINTF( ( "Switching to THINKING state.\r\n" ) );
-        prvClientSetState( AIA_STATE_ALEXA_THINKING );
+        xState = AIA_STATE_ALEXA_THINKING;
     }
     else if( xIsStringEqual( pucState, xStateLength, "SPEAKING" ) == pdTRUE )
     {
-        configPRINTF( ( "Switching to SPEAKING state.\r\n" ) );
-        prvClientSetState( AIA_STATE_ALEXA_SPEAKING );
+        xState = AIA_STATE_ALEXA_SPEAKING;
     }
     else if( xIsStringEqual( pucState, xStateLength, "ALERTING" ) == pdTRUE )
     {
-        configPRINTF( ( "Switching to ALERTING state.\r\n" ) );
-        prvClientSetState( AIA_STATE_ALEXA_ALERTING );
+        xState = AIA_STATE_ALEXA_ALERTING;
     }
 
     pxJSMNTokenTemp = &pxJSMNToken[ AIA_MSGTOKENPOS_SETATTENTIONSTATE_OFFSET - 1 ];
@@ -606,8 +1593,19 @@ static void prvClientHandleDirectiveSetAttentionState( const uint8_t * pucMessag
     {
         configASSERT( pxJSMNTokenTemp + 1 < pxJSMNTokenEndMarker );
         *pucDirectiveTokenSize += 2;
-        configPRINTF( ( "We are not handling offset in SetAttentionState yet!!!\r\n" ) );
-    }
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+        pxJSMNTokenTemp += 1;
+        if( prvClientScheduleAtOffset( ullConvertJSONLong( pucMessage, pxJSMNTokenTemp->start, pxJSMNTokenTemp->end ),
+                                       eAIAOffsetActionSetAttentionState, ( uint32_t )xState ) == pdTRUE )
+        {
+            return;
+        }
+#else
+        configPRINTF( ( "We are not handling offset in SetAttentionState yet!!!\r\n" ) );
+#endif
+    }
+
+    prvClientSetAttentionState( xState );
 }
 
 static void prvClientHandleDirectiveOpenSpeaker( const uint8_t * pucMessage,
@@ -622,6 +1620,10 @@ static void prvClientHandleDirectiveOpenSpeaker( const uint8_t * pucMessage,
     configASSERT( pxJSMNTokenTemp < pxJSMNTokenEndMarker );
     AIAClient.xSpeaker.ullOpenOffset = ullConvertJSONLong( pucMessage, pxJSMNTokenTemp->start, pxJSMNTokenTemp->end );
     configPRINTF_DEBUG( ( "DEBUG: OpenSpeaker offset is %lu.\r\n", ( uint32_t )AIAClient.xSpeaker.ullOpenOffset ) );
+#ifdef DEBUG
+    ulCyclesAtOpenSpeaker = ulPlatformGetCycleCount();
+    bFirstSoundPending = true;
+#endif
     prvClientSetState( AIA_STATE_OPENSPEAKER_RECEIVED );
 }
 
@@ -642,6 +1644,10 @@ static void prvClientHandleDirectiveCloseSpeaker( const uint8_t * pucMessage,
         AIAClient.xSpeaker.ullCloseOffset = ullConvertJSONLong( pucMessage, pxJSMNTokenTemp->start, pxJSMNTokenTemp->end );
         configPRINTF_DEBUG( ( "DEBUG: CloseSpeaker offset is %lu.\r\n", ( uint32_t )AIAClient.xSpeaker.ullCloseOffset ) );
         *pucDirectiveTokenSize += 4;
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+        /* Otherwise the speaker is closed once a message ends at the offset. */
+        ( void )prvClientScheduleAtOffset( AIAClient.xSpeaker.ullCloseOffset, eAIAOffsetActionCloseSpeaker, 0 );
+#endif
     }
     else
     {
@@ -671,9 +1677,7 @@ static void prvClientHandleDirectiveOpenMicrophone( const uint8_t * pucMessage,
         AIAClient.pcInitiatorType = NULL;
     }
 
-    xStreamBufferReset( AIAClient.xMicrophone.xMicBuffer );
-
-    prvClientOpenMicrophone();
+    prvClientOpenMicrophone( ulPlatformGetCycleCount() );
 
     /* Change the blink interval to 200ms in this case. */
     vPlatformLEDBlink( 200 );
@@ -686,7 +1690,13 @@ static void prvClientHandleDirectiveCloseMicrophone( const uint8_t * pucMessage,
 {
     *pucDirectiveTokenSize = AIA_MSGTOKENSIZE_CLOSEMICROPHONE;
     configPRINTF_DEBUG( ( "DEBUG: CloseMicrophone is received.\r\n" ) );
-    prvClientCloseMicrophone();
+    /* The microphone task may have closed the microphone on the end of speech or the release of a hold already, or
+     * be closing it: whichever of them takes the state first closes it.
+     */
+    if( prvClientTakeState( AIA_STATE_MICROPHONE_OPENED ) == pdTRUE )
+    {
+        prvClientCloseMicrophone();
+    }
     vPlatformLEDOff();
 }
 
@@ -713,6 +1723,13 @@ static void prvClientHandleDirectiveSetVolume( const uint8_t * pucMessage,
         *pucDirectiveTokenSize += 2;
     }
     configPRINTF_DEBUG( ( "DEBUG: SetVolume is received to set volume to %u.\r\n", xSetVolume.ulVolume ) );
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+    if( xSetVolume.ullOffset != 0 &&
+        prvClientScheduleAtOffset( xSetVolume.ullOffset, eAIAOffsetActionSetVolume, xSetVolume.ulVolume ) == pdTRUE )
+    {
+        return;
+    }
+#endif
     prvClientSetVolume( xSetVolume );
 }
 
@@ -730,8 +1747,12 @@ static void prvClientGeneralCallback( void * pvUserData, IotMqttCallbackParam_t
     /* If the message is received on connection topic, no need for decryption. */
     if( xIsTopic( pcTopicName, ( size_t )usTopicNameLength, AIA_TOPIC_CONNECTION_SER ) != pdTRUE )
     {
+        /* Decrypt in place over the ciphertext in the receive buffer of MQTT. The buffer comes from
+         * the pool of the client (aia_recvpool.h), so the message can be retained without a copy.
+         */
+        uint8_t * pucRecvMsg = ( ( AIAMessage_t * )pxPublishParameters->u.message.info.pPayload )->ciphertext;
         lMsgLen = lAIACryptoDecrypt( &AIAClient.xCrypto,
-                                      ucAiaRecvMsg,
+                                      pucRecvMsg,
                                       pxPublishParameters->u.message.info.pPayload,
                                       pxPublishParameters->u.message.info.payloadLength );
         if( lMsgLen == eCryptoSequenceNotMatch )
@@ -745,7 +1766,7 @@ static void prvClientGeneralCallback( void * pvUserData, IotMqttCallbackParam_t
             configPRINTF( ( "Failed to decrypt received message!\r\n" ) );
             goto client_callback_exit;
         }
-        pucMsgContent = ucAiaRecvMsg;
+        pucMsgContent = pucRecvMsg;
     }
     else
     {
@@ -782,16 +1803,38 @@ client_callback_exit:
  */
 #define SNPRINTF_POST_PROCESS( m, b, l )    ({ if( l < 0 ) return pdFAIL; m += l; b -= l; })
 
-static BaseType_t prvGenerateCapabilitiesJSON( char * pcCapabilities )
+/* The capabilities, with the speaker buffer warning thresholds given. */
+static BaseType_t prvGenerateCapabilitiesJSON( char * pcCapabilities, uint32_t ulOverrunWarning, uint32_t ulUnderrunWarning )
 {
     configASSERT( AIAClient.xSpeaker.ulSpeakerBufferSize != 0 );
-    configASSERT( AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning != 0 );
-    configASSERT( AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning != 0 );
+    configASSERT( ulOverrunWarning != 0 );
+    configASSERT( ulUnderrunWarning != 0 );
     configASSERT( AIAClient.xSpeaker.ulDecoderBitrate != 0 );
     configASSERT( AIAClient.xSpeaker.ucChannels != 0 );
 
     int xLength;
     size_t xBytesLeft = AIA_EVENT_MESSAGE_MAX_SIZE;
+    char cMicrophoneEncoder[ 96 ];
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    xLength = snprintf( cMicrophoneEncoder, sizeof( cMicrophoneEncoder ),
+                        "\"format\":\"OPUS\","                                                                  \
+                        "\"bitrate\":{"                                                                         \
+                            "\"type\":\"CONSTANT\","                                                            \
+                            "\"bitsPerSecond\":%lu"                                                             \
+                        "},"                                                                                    \
+                        "\"numberOfChannels\":%u",
+                        aiaconfigCLIENT_MICROPHONE_ENCODER_BITRATE,
+                        aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS );
+#else
+    xLength = snprintf( cMicrophoneEncoder, sizeof( cMicrophoneEncoder ),
+                        "\"format\":\"AUDIO_L16_RATE_16000_CHANNELS_1\"" );
+#endif
+    if( xLength < 0 || xLength >= sizeof( cMicrophoneEncoder ) )
+    {
+        return pdFAIL;
+    }
+
     xLength = snprintf( pcCapabilities, xBytesLeft,
                         "{"                                                                                     \
                             "\"header\":{"                                                                      \
@@ -828,7 +1871,7 @@ static BaseType_t prvGenerateCapabilitiesJSON( char * pcCapabilities )
                                         "\"version\":\"1.0\","                                                  \
                                         "\"configurations\":{"                                                  \
                                             "\"audioEncoder\":{"                                                \
-                                                "\"format\":\"AUDIO_L16_RATE_16000_CHANNELS_1\""                \
+                                                "%s"                                                            \
                                             "}"                                                                 \
                                         "}"                                                                     \
                                     "},"                                                                        \
@@ -851,10 +1894,11 @@ static BaseType_t prvGenerateCapabilitiesJSON( char * pcCapabilities )
                         "}",
                         clientcredentialIOT_THING_NAME,
                         AIAClient.xSpeaker.ulSpeakerBufferSize,
-                        AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning,
-                        AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning,
+                        ulOverrunWarning,
+                        ulUnderrunWarning,
                         AIAClient.xSpeaker.ulDecoderBitrate,
                         AIAClient.xSpeaker.ucChannels,
+                        cMicrophoneEncoder,
                         aiaconfigAIA_MESSAGE_MAX_SIZE );
     SNPRINTF_POST_PROCESS( pcCapabilities, xBytesLeft, xLength );
     return pdPASS;
@@ -1181,32 +2225,37 @@ static BaseType_t prvGenerateStopPlayingJSON( char * pcEventMessage, uint32_t ul
             xReturned = pdFAIL;                       \
             goto send_event_exit; } }
 
-static BaseType_t prvClientSendEvent( AIAEvent_t event_type, void * parameters )
+/* Only the outbound task uses this, when an event is actually published. */
+static uint32_t ulEventSequence = 0;
+
+/* Given by the outbound task once an event sent with prvClientSendEventAndWait() has been published. */
+static SemaphoreHandle_t xEventPublished = NULL;
+
+/* Queue an event for the outbound task, which publishes events in the order they are queued. pdPASS only means
+ * that the event is queued. With xPublished not NULL, the outbound task gives it once the event is published.
+ */
+static BaseType_t prvClientQueueEvent( AIAEvent_t event_type, void * parameters, SemaphoreHandle_t xPublished )
 {
-    static uint32_t ulEventSequence = 0;
     static uint32_t ulMessageId = 0;
     BaseType_t xReturned = pdPASS;
-    char * pcBlob = NULL;
     char * pcEventMessage;
-    char * pcEncryptedMessage = NULL;
-    int32_t lEncryptedMessageLength;
-    uint32_t ulSeq = 0;
+    char * pcMessageBuffer = NULL;
     uint32_t ulId = 0;
+    AIAOutboundQueue_t xQueue = eAIAOutboundControl;
+    AIAOutboundMessage_t xMessage;
 
-    /* Allocate a buffer of EVENT_MESSAGE_MAX_SIZE to hold the event message. */
-    pcBlob = ( char * )pvPortMalloc( AIA_EVENT_MESSAGE_MAX_SIZE );
-    SEND_EVENT_GOTO_FAIL( pcBlob == NULL, "Failed to allocate memory for event message!\r\n");
-
-    /* Leave enough space to hold the squence number. */
-    pcEventMessage = pcBlob + AIA_MSG_PARAMS_SIZE_SEQ;
+    /* The event message is encrypted straight into the MQTT packet, so only room for the sequence number is needed. */
+    pcMessageBuffer = ( char * )pvAIAEventPoolTake( aiaconfigAIA_DEFAULT_TIMEOUT );
+    if( pcMessageBuffer == NULL )
+    {
+        configPRINTF( ( "No event buffer is free!\r\n" ) );
+        return pdFAIL;
+    }
 
-    /* Allocate a buffer to hold the encrypted event message. */
-    pcEncryptedMessage = ( char * )pvPortMalloc( sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + AIA_EVENT_MESSAGE_MAX_SIZE );
-    SEND_EVENT_GOTO_FAIL( pcEncryptedMessage == NULL, "Failed to allocate memory for encrypted event message!\r\n" );
+    pcEventMessage = pcMessageBuffer + AIA_MSG_PARAMS_SIZE_SEQ;
 
-    /* Lock before updating sequence number and message Id for reentrancy. */
+    /* Lock before updating message Id for reentrancy. */
     vTaskSuspendAll();
-    ulSeq = ulEventSequence++;
     /* Simply use an increasing number for message Id for now. */
     ulId = ulMessageId++;
     xTaskResumeAll();
@@ -1216,6 +2265,8 @@ static BaseType_t prvClientSendEvent( AIAEvent_t event_type, void * parameters )
         case aiaEventMicrophoneOpened:
             SEND_EVENT_GOTO_FAIL( prvGenerateMicrophoneOpenedJSON( pcEventMessage, ulId ) == pdFAIL,
                                   "Failed to generate MicrophoneOpened message" );
+            /* Keep it in order with the audio stream it opens. */
+            xQueue = eAIAOutboundAudio;
             break;
         case aiaEventSynchronizeState:
             SEND_EVENT_GOTO_FAIL( prvGenerateSynchronizeStateJSON( pcEventMessage, ulId ) == pdFAIL,
@@ -1224,6 +2275,8 @@ static BaseType_t prvClientSendEvent( AIAEvent_t event_type, void * parameters )
         case aiaEventMicrophoneClosed:
             SEND_EVENT_GOTO_FAIL( prvGenerateMicrophoneClosedJSON( pcEventMessage, ulId ) == pdFAIL,
                                   "Failed to generate MicrophoneClosed message" );
+            /* Keep it after the audio it accounts for. */
+            xQueue = eAIAOutboundAudio;
             break;
         case aiaEventSpeakerOpened:
             SEND_EVENT_GOTO_FAIL( prvGenerateSpeakerOpenedJSON( pcEventMessage, ulId, *( uint64_t * )parameters ) == pdFAIL,
@@ -1253,19 +2306,51 @@ static BaseType_t prvClientSendEvent( AIAEvent_t event_type, void * parameters )
             SEND_EVENT_GOTO_FAIL( true ,"Unsupported event type!\r\n" );
     }
 
-    lEncryptedMessageLength = lAIACryptoEncrypt( &AIAClient.xCrypto, pcEncryptedMessage, pcEventMessage,
-                                            strlen(pcEventMessage), ulSeq );
-    SEND_EVENT_GOTO_FAIL( lEncryptedMessageLength < 0, "Failed to encrypt the event message");
+    configPRINTF_DEBUG( ( "DEBUG: Queuing event message %u: %s\r\n", ulId, pcEventMessage ) );
 
-    configPRINTF_DEBUG( ( "DEBUG: Sending event message %u: %s\r\n", ulSeq, pcEventMessage ) );
-    xReturned = prvClientPublishMessage( AIA_TOPIC_EVENT, pcEncryptedMessage, lEncryptedMessageLength );
+    xMessage.pcTopic = AIA_TOPIC_EVENT;
+    xMessage.pvPlaintext = pcEventMessage;
+    xMessage.ulLength = strlen( pcEventMessage );
+    xMessage.pulSequence = &ulEventSequence;
+    xMessage.pvBuffer = pcMessageBuffer;
+    xMessage.vRelease = vAIAEventPoolGive;
+    xMessage.xEvent = pdTRUE;
+    xMessage.xPublished = xPublished;
+    SEND_EVENT_GOTO_FAIL( xAIAOutboundSend( xQueue, &xMessage, aiaconfigAIA_DEFAULT_TIMEOUT ) != pdPASS, "" );
+
+    /* The buffer is owned by the outbound task from now on. */
+    return pdPASS;
 
 send_event_exit:
-    vPortFree( pcBlob );
-    vPortFree( pcEncryptedMessage );
+    vAIAEventPoolGive( pcMessageBuffer );
     return xReturned;
 }
 
+static BaseType_t prvClientSendEvent( AIAEvent_t event_type, void * parameters )
+{
+    return prvClientQueueEvent( event_type, parameters, NULL );
+}
+
+/* Send an event and wait until it has actually been published. Only one task may use this at a time. */
+static BaseType_t prvClientSendEventAndWait( AIAEvent_t event_type, void * parameters )
+{
+    /* Clear a give left by an event that was published after its caller had stopped waiting. */
+    xSemaphoreTake( xEventPublished, 0 );
+
+    if( prvClientQueueEvent( event_type, parameters, xEventPublished ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    if( xSemaphoreTake( xEventPublished, aiaconfigAIA_DEFAULT_TIMEOUT ) != pdPASS )
+    {
+        configPRINTF( ( "Event %d was not published in time!\r\n", event_type ) );
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+
 static BaseType_t prvClientSubscribe( const char * pcTopic )
 {
     BaseType_t xReturned;
@@ -1367,73 +2452,120 @@ static BaseType_t prvClientReconnectToAIA( void )
     return pdFAIL;
 }
 
-static BaseType_t prvClientPublishCapabilities( void )
+/* Counts the capabilities messages published, by this task or by the outbound task. */
+static uint32_t ulCapabilitiesSequence = 0;
+
+/* Publish the capabilities without waiting for them to be acknowledged. */
+static BaseType_t prvClientSendCapabilities( void )
 {
     BaseType_t xReturned;
-    BaseType_t xState;
-    static uint32_t ulCapabilitiesSequence = 0;
-    char * pcBlob = NULL;
     char * pcCapabilitiesMessage;
-    char * pcEncryptedMessage = NULL;
-    int32_t lEncryptedMessageLength;
+    char * pcMessageBuffer = NULL;
 
-    /* Subscribe to capabilities/acknowledge topic. */
-    xReturned = prvClientSubscribe( AIA_TOPIC_CAPABILITIES_ACK );
-    if( xReturned == pdFAIL )
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+    /* The acknowledgement of these capabilities is not for thresholds proposed before. */
+    prvClientPlayoutAcknowledge( pdFALSE );
+#endif
+
+    /* The capabilities message is encrypted straight into the MQTT packet, so only room for the sequence number is needed. */
+    pcMessageBuffer = ( char * )pvAIAEventPoolTake( aiaconfigAIA_DEFAULT_TIMEOUT );
+    if( pcMessageBuffer == NULL )
     {
+        configPRINTF( ( "No event buffer is free for the capabilities!\r\n" ) );
         return pdFAIL;
     }
 
-    /* Subscribe to directive topic. */
-    xReturned = prvClientSubscribe( AIA_TOPIC_DIRECTIVE );
-    if( xReturned == pdFAIL )
+    pcCapabilitiesMessage = pcMessageBuffer + AIA_MSG_PARAMS_SIZE_SEQ;
+    prvGenerateCapabilitiesJSON( pcCapabilitiesMessage,
+                                 AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning,
+                                 AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning );
+
+    /* Any acknowledgement from before is stale. */
+    prvClientClearState( AIA_STATE_CAPABILITIES_ACCEPTED | AIA_STATE_CAPABILITIES_REJECTED );
+    xReturned = prvClientPublishEncryptedMessage( AIA_TOPIC_CAPABILITIES_PUB,
+                                                  pcCapabilitiesMessage,
+                                                  strlen( pcCapabilitiesMessage ),
+                                                  ulCapabilitiesSequence );
+    vAIAEventPoolGive( pcMessageBuffer );
+
+    if( xReturned == pdPASS )
+    {
+        ulCapabilitiesSequence++;
+    }
+
+    return xReturned;
+}
+
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+/* Have the outbound task publish the capabilities with the thresholds given, from a buffer of the event pool. The
+ * caller does not wait for the publication, nor for the acknowledgement.
+ */
+static BaseType_t prvClientQueueCapabilities( uint32_t ulOverrunWarning, uint32_t ulUnderrunWarning )
+{
+    AIAOutboundMessage_t xMessage;
+    char * pcCapabilitiesMessage;
+    char * pcMessageBuffer;
+
+    pcMessageBuffer = ( char * )pvAIAEventPoolTake( 0 );
+    if( pcMessageBuffer == NULL )
     {
+        configPRINTF( ( "No event buffer is free for the capabilities!\r\n" ) );
         return pdFAIL;
     }
 
-    xReturned = prvClientSubscribe( AIA_TOPIC_SPEAKER );
-    if( xReturned == pdFAIL )
+    pcCapabilitiesMessage = pcMessageBuffer + AIA_MSG_PARAMS_SIZE_SEQ;
+    if( prvGenerateCapabilitiesJSON( pcCapabilitiesMessage, ulOverrunWarning, ulUnderrunWarning ) != pdPASS )
     {
+        vAIAEventPoolGive( pcMessageBuffer );
         return pdFAIL;
     }
 
-    pcBlob = ( char * )pvPortMalloc( AIA_EVENT_MESSAGE_MAX_SIZE );
-    if( pcBlob == NULL )
+    xMessage.pcTopic = AIA_TOPIC_CAPABILITIES_PUB;
+    xMessage.pvPlaintext = pcCapabilitiesMessage;
+    xMessage.ulLength = strlen( pcCapabilitiesMessage );
+    xMessage.pulSequence = &ulCapabilitiesSequence;
+    xMessage.pvBuffer = pcMessageBuffer;
+    xMessage.vRelease = vAIAEventPoolGive;
+    xMessage.xEvent = pdTRUE;
+    xMessage.xPublished = NULL;
+    if( xAIAOutboundSend( eAIAOutboundControl, &xMessage, 0 ) != pdPASS )
     {
-        configPRINTF( ( "Failed to allocate memory for capabilities message!\r\n" ) );
+        vAIAEventPoolGive( pcMessageBuffer );
         return pdFAIL;
     }
 
-    pcCapabilitiesMessage = pcBlob + AIA_MSG_PARAMS_SIZE_SEQ;
-    prvGenerateCapabilitiesJSON( pcCapabilitiesMessage );
+    return pdPASS;
+}
+#endif
+
+static BaseType_t prvClientPublishCapabilities( void )
+{
+    BaseType_t xReturned;
+    BaseType_t xState;
 
-    /* Allocate a buffer to hold the encrypted message. */
-    pcEncryptedMessage = ( char * )pvPortMalloc( sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + AIA_EVENT_MESSAGE_MAX_SIZE );
-    if( pcEncryptedMessage == NULL )
+    /* Subscribe to capabilities/acknowledge topic. */
+    xReturned = prvClientSubscribe( AIA_TOPIC_CAPABILITIES_ACK );
+    if( xReturned == pdFAIL )
     {
-        configPRINTF( ( "Failed to allocate memory for encrypted event message!\r\n" ) );
-        vPortFree( pcBlob );
         return pdFAIL;
     }
 
-    lEncryptedMessageLength = lAIACryptoEncrypt( &AIAClient.xCrypto,
-                                                  pcEncryptedMessage,
-                                                  pcCapabilitiesMessage,
-                                                  strlen( pcCapabilitiesMessage ),
-                                                  ulCapabilitiesSequence );
-    vPortFree( pcBlob );
-    if( lEncryptedMessageLength < 0 )
+    /* Subscribe to directive topic. */
+    xReturned = prvClientSubscribe( AIA_TOPIC_DIRECTIVE );
+    if( xReturned == pdFAIL )
     {
-        vPortFree( pcEncryptedMessage );
         return pdFAIL;
     }
 
-    xReturned = prvClientPublishMessage( AIA_TOPIC_CAPABILITIES_PUB, pcEncryptedMessage, lEncryptedMessageLength );
-    vPortFree( pcEncryptedMessage );
+    xReturned = prvClientSubscribe( AIA_TOPIC_SPEAKER );
+    if( xReturned == pdFAIL )
+    {
+        return pdFAIL;
+    }
 
+    xReturned = prvClientSendCapabilities();
     if( xReturned == pdPASS )
     {
-        ulCapabilitiesSequence++;
         xState = prvClientWaitForState( AIA_STATE_CAPABILITIES_ACCEPTED | AIA_STATE_CAPABILITIES_REJECTED,
                                         pdFALSE,
                                         pdFALSE,
@@ -1456,9 +2588,10 @@ static BaseType_t prvClientPublishCapabilities( void )
     return xReturned;
 }
 
+/* The client is only ready once the service has been sent its state. */
 static BaseType_t prvClientSynchronizeState( void )
 {
-    return prvClientSendEvent( aiaEventSynchronizeState, NULL );
+    return prvClientSendEventAndWait( aiaEventSynchronizeState, NULL );
 }
 
 static BaseType_t prvClientSetVolume( AIAClient_SetVolume_t xSetVolume )
@@ -1467,9 +2600,45 @@ static BaseType_t prvClientSetVolume( AIAClient_SetVolume_t xSetVolume )
     return prvClientSendEvent( aiaEventVolumeChanged, &xSetVolume.ulVolume );
 }
 
-static BaseType_t prvClientOpenMicrophone( void )
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 ) && defined( DEBUG )
+
+/* The capture restarts on touch-down, and its first frame ends a frame after its first sample was captured. That
+ * sample may come before the touch-down, when the frame was under way at the restart, which counts as no latency.
+ */
+static void prvClientReportTouchLatency( void )
+{
+    AIACaptureStatistics_t xCapture;
+    int32_t lLatencyCycles;
+    uint32_t ulLatencyMs;
+    uint32_t ulBucket;
+
+    vAIACaptureGetStatistics( &xCapture );
+    lLatencyCycles = ( int32_t )( xCapture.ulFirstFrameCycles - ulCyclesAtTouchDown -
+                                  configCPU_CLOCK_HZ / 1000UL * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS );
+    ulLatencyMs = ( lLatencyCycles > 0 ) ? ( uint32_t )( ( uint64_t )lLatencyCycles * 1000UL / configCPU_CLOCK_HZ ) : 0;
+    ulBucket = ulLatencyMs / AIA_TOUCH_LATENCY_BUCKET_MS;
+    if( ulBucket >= AIA_TOUCH_LATENCY_BUCKETS )
+    {
+        ulBucket = AIA_TOUCH_LATENCY_BUCKETS - 1;
+    }
+    ulTouchLatencyHistogram[ ulBucket ]++;
+
+    configPRINTF_DEBUG( ( "DEBUG: First sample captured %u ms after touch-down, %u ms buckets so far: %u %u %u %u %u %u %u %u\r\n",
+                          ulLatencyMs, AIA_TOUCH_LATENCY_BUCKET_MS,
+                          ulTouchLatencyHistogram[ 0 ], ulTouchLatencyHistogram[ 1 ], ulTouchLatencyHistogram[ 2 ],
+                          ulTouchLatencyHistogram[ 3 ], ulTouchLatencyHistogram[ 4 ], ulTouchLatencyHistogram[ 5 ],
+                          ulTouchLatencyHistogram[ 6 ], ulTouchLatencyHistogram[ 7 ] ) );
+}
+
+#endif
+
+/* ulCyclesAtTap is ulPlatformGetCycleCount() at the tap or the directive the microphone opens for. */
+static BaseType_t prvClientOpenMicrophone( uint32_t ulCyclesAtTap )
 {
     BaseType_t xReturned;
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    BaseType_t xCapturing;
+#endif
 
     xReturned = prvClientSetState( AIA_STATE_MICROPHONE_OPENED );
     if( xReturned == pdPASS )
@@ -1484,176 +2653,1592 @@ static BaseType_t prvClientOpenMicrophone( void )
         bSendMicrophoneOpenedEvent = true;
     }
 
+#ifdef DEBUG
+    prvClientStartUtteranceStatistics( ulCyclesAtTap );
+#else
+    ( void )ulCyclesAtTap;
+#endif
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    taskENTER_CRITICAL();
+    bWakewordUtterance = true;
+    xCapturing = ( bWakewordListening == true ) ? pdTRUE : pdFALSE;
+    vAIACaptureSetListening( pdFALSE );
+    vAIACaptureRestart();
+    taskEXIT_CRITICAL();
+#else
+    vAIACaptureRestart();
+#endif
+    vPlatformLEDBlink( 500 );
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    if( xCapturing != pdTRUE )
+#endif
+    {
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+        xMicrophoneStartupWarm = prvClientWarmupClaim( eAIAWarmupMicrophone );
+        bMicrophoneStartupPending = true;
+        if( xMicrophoneStartupWarm != pdTRUE )
+#endif
+        {
+            vPlatformMicrophoneOpen();
+        }
+    }
+
+    return xReturned;
+}
+
+static BaseType_t prvClientOpenMicrophoneFromISR( uint32_t ulCyclesAtTap, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    BaseType_t xReturned;
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    BaseType_t xCapturing;
+    UBaseType_t uxSavedInterruptStatus;
+#endif
+
+    xReturned = prvClientSetStateFromISR( AIA_STATE_MICROPHONE_OPENED, pxHigherPriorityTaskWoken );
+    if( xReturned == pdPASS )
+    {
+        if( bBufferOverrun == true )
+        {
+            bMicrophoneOpenedDuringOverrun = true;
+        }
+
+        bSendMicrophoneOpenedEvent = true;
+    }
+
+#ifdef DEBUG
+    prvClientStartUtteranceStatisticsFromISR( ulCyclesAtTap );
+#else
+    ( void )ulCyclesAtTap;
+#endif
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    bWakewordUtterance = true;
+    xCapturing = ( bWakewordListening == true ) ? pdTRUE : pdFALSE;
+    vAIACaptureSetListening( pdFALSE );
+    vAIACaptureRestartFromISR();
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+#else
+    vAIACaptureRestartFromISR();
+#endif
     vPlatformLEDBlink( 500 );
-    vPlatformMicrophoneOpen();
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    if( xCapturing != pdTRUE )
+#endif
+    {
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+        xMicrophoneStartupWarm = prvClientWarmupClaimFromISR( eAIAWarmupMicrophone );
+        bMicrophoneStartupPending = true;
+        if( xMicrophoneStartupWarm != pdTRUE )
+#endif
+        {
+            vPlatformMicrophoneOpen();
+        }
+    }
+
+    return xReturned;
+}
+
+#ifdef DEBUG
+
+/* Report the figures of the utterance, and of each stage of the microphone path, as the microphone closes. */
+static void prvClientReportMicrophone( void )
+{
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    if( bTouchLatencyPending == true )
+    {
+        bTouchLatencyPending = false;
+        prvClientReportTouchLatency();
+    }
+#endif
+    {
+        AIACaptureStatistics_t xCapture;
+        uint32_t ulCaptureMs = ( uint32_t )( ( xTaskGetTickCount() - xTickAtMicrophoneOpen ) * portTICK_PERIOD_MS );
+        uint32_t ulCopiedBytes;
+
+        vAIACaptureGetStatistics( &xCapture );
+        ulCopiedBytes = xCapture.ulCopiedBytes - xCaptureAtMicrophoneOpen.ulCopiedBytes;
+
+        configPRINTF_DEBUG( ( "DEBUG: Microphone ISR %u cycles per frame on average, %u max, %u samples dropped in %u overflows, %u of %u capture slots used at most, %u bytes copied per second\r\n",
+                              xCapture.ulIsrCyclesAverage, xCapture.ulIsrCyclesMax,
+                              ( xCapture.ulDroppedFrames - xCaptureAtMicrophoneOpen.ulDroppedFrames ) * AIA_MICROPHONE_RAW_FRAME_SAMPLES,
+                              xCapture.ulOverflows - xCaptureAtMicrophoneOpen.ulOverflows,
+                              xCapture.ulMaxSlotsInUse, ( uint32_t )aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS,
+                              ( ulCaptureMs != 0 ) ? ( uint32_t )( ( uint64_t )ulCopiedBytes * 1000UL / ulCaptureMs ) : 0 ) );
+#if ( aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS > 0 )
+        configPRINTF_DEBUG( ( "DEBUG: %u publish stalls of %u ms injected, %u samples dropped with %u spare capture slots\r\n",
+                              ulInjectedStalls, ( uint32_t )aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS,
+                              ( xCapture.ulDroppedFrames - xCaptureAtMicrophoneOpen.ulDroppedFrames ) * AIA_MICROPHONE_RAW_FRAME_SAMPLES,
+                              ( uint32_t )aiaconfigAIA_MICROPHONE_SPARE_SLOTS ) );
+#endif
+    }
+
+    {
+        /* Audio still queued is published after this, so the figures cover the utterance up to now. */
+        uint32_t ulOverheadX10 = ( ulMicrophoneAudioBytes != 0 ) ?
+                                 ( uint32_t )( ( uint64_t )ulMicrophoneOverheadBytes * 1000UL / ulMicrophoneAudioBytes ) : 0;
+
+        configPRINTF_DEBUG( ( "DEBUG: First microphone message published %u.%u ms after the tap or the directive that opened the microphone\r\n",
+                              ulTapToFirstMessageUs / 1000, ( ulTapToFirstMessageUs % 1000 ) / 100 ) );
+        configPRINTF_DEBUG( ( "DEBUG: %u microphone messages, %u bytes of audio, %u bytes of overhead (%u.%u%%), %u cycles to publish each\r\n",
+                              ulMicrophoneMessages, ulMicrophoneAudioBytes, ulMicrophoneOverheadBytes,
+                              ulOverheadX10 / 10, ulOverheadX10 % 10, ulAIACycleMeterAverage( &xMicrophonePublishMeter ) ) );
+    }
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+    configPRINTF_DEBUG( ( "DEBUG: End of speech detector %u cycles per frame on average, %u max, over %u frames\r\n",
+                          ulAIACycleMeterAverage( &xEndpointerMeter ), xEndpointerMeter.ulMax, xEndpointerMeter.ulCount ) );
+    if( bEndOfSpeechDetected == true && xEndpointerEnabled != pdTRUE )
+    {
+        /* What closing the microphone on the end of speech would have saved on this utterance. */
+        configPRINTF_DEBUG( ( "DEBUG: End of speech detected %u ms before the microphone was closed, %u bytes of audio streamed after it\r\n",
+                              ( uint32_t )( ( xTaskGetTickCount() - xTickAtEndOfSpeech ) * portTICK_PERIOD_MS ),
+                              ( uint32_t )( AIAClient.xMicrophone.ullMicrophoneOffset - ullOffsetAtEndOfSpeech ) ) );
+    }
+#endif
+#if ( aiaconfigCLIENT_AEC == 1 )
+    vAIAAecReport();
+#endif
+#if ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 16 )
+    vAIAMicInputReport();
+#endif
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 )
+    vAIABeamformerReport();
+#endif
+#if ( AIA_MICROPHONE_DECIMATION > 1 )
+    vAIADecimatorReport();
+#endif
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+    vAIAFrontendReport();
+#endif
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    {
+        /* Each encoded frame spares AES-GCM and the radio the difference between the raw and the encoded frame. */
+        uint32_t ulSavedBytes = AIA_MICROPHONE_RAW_FRAME_SIZE - AIA_MICROPHONE_ENCODER_FRAME_SIZE;
+        uint32_t ulCryptoCyclesSaved = ( uint32_t )( ( uint64_t )ulSavedBytes * ulAIAPublishCryptoCyclesPerKB() / 1024U );
+
+        configPRINTF_DEBUG( ( "DEBUG: Opus encode %u cycles per frame on average, %u max, over %u frames\r\n",
+                              ulAIACycleMeterAverage( &xEncodeMeter ), xEncodeMeter.ulMax, xEncodeMeter.ulCount ) );
+        configPRINTF_DEBUG( ( "DEBUG: %u bytes per frame sent instead of %u, saving %u AES-GCM cycles per frame and %u bytes per second of uplink\r\n",
+                              ( uint32_t )AIA_MICROPHONE_ENCODER_FRAME_SIZE, ( uint32_t )AIA_MICROPHONE_RAW_FRAME_SIZE,
+                              ulCryptoCyclesSaved, ( uint32_t )( ulSavedBytes * 1000UL / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS ) ) );
+    }
+#endif
+}
+
+#endif
+
+static BaseType_t prvClientCloseMicrophone( void )
+{
+    BaseType_t xReturned;
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    BaseType_t xCapturing;
+
+    /* Keep capturing, and give the audio to the spotter again. */
+    taskENTER_CRITICAL();
+    bWakewordUtterance = false;
+    xCapturing = ( bWakewordListening == true ) ? pdTRUE : pdFALSE;
+    if( xCapturing == pdTRUE )
+    {
+        vAIACaptureSetListening( pdTRUE );
+        bResetWakeword = true;
+    }
+    taskEXIT_CRITICAL();
+    if( xCapturing != pdTRUE )
+#endif
+    {
+        vPlatformMicrophoneClose();
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+        prvClientWarmupRelease( eAIAWarmupMicrophone );
+#endif
+    }
+    xReturned = prvClientClearState( AIA_STATE_MICROPHONE_OPENED );
+
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    if( bMicrophoneStartupPending == true )
+    {
+        AIACaptureStatistics_t xCapture;
+        uint32_t ulStartupUs;
+
+        /* The capture restarts on the claim. The first frame ends a frame after its first sample, and a warm
+         * microphone may have captured part of it before. */
+        bMicrophoneStartupPending = false;
+        vAIACaptureGetStatistics( &xCapture );
+        ulStartupUs = ( uint32_t )( ( uint64_t )xCapture.ulRestartToFrameCycles * 1000000UL / configCPU_CLOCK_HZ );
+        ulStartupUs = ( ulStartupUs > aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS * 1000UL ) ?
+                      ulStartupUs - aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS * 1000UL : 0;
+        taskENTER_CRITICAL();
+        vAIAWarmupRecordStartup( &xWarmup, eAIAWarmupMicrophone, xMicrophoneStartupWarm, ulStartupUs );
+        taskEXIT_CRITICAL();
+#ifdef DEBUG
+        prvClientReportWarmup( eAIAWarmupMicrophone );
+#endif
+    }
+#endif
+
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    /* A long press may still be held when AIA closes the microphone. Its release is then ignored. */
+    taskENTER_CRITICAL();
+    xGesture = eAIAGestureIdle;
+    taskEXIT_CRITICAL();
+#endif
+
+#ifdef DEBUG
+    prvClientReportMicrophone();
+#endif
+
+    return xReturned;
+}
+
+static BaseType_t prvClientOpenSpeaker( uint64_t ullOpenOffset )
+{
+    BaseType_t xReturned;
+
+    xStreamBufferReset( AIAClient.xSpeaker.xDecodeBuffer );
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    taskENTER_CRITICAL();
+    vAIAPlayclockStart( &xPlayclock, ullOpenOffset );
+    taskEXIT_CRITICAL();
+#endif
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    xSpeakerStartupWarm = prvClientWarmupClaim( eAIAWarmupSpeaker );
+    if( xSpeakerStartupWarm != pdTRUE )
+#endif
+    {
+        vPlatformSpeakerOpen();
+    }
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    /* Measured up to the first audio read for the speaker DMA, see xClientReadSpeakerBufferFromISR(). */
+    ulSpeakerStartupCycles = ulPlatformGetCycleCount();
+    bSpeakerStartupPending = true;
+#endif
+
+#ifdef DEBUG
+    ulHeapAllocationsAtSpeakerOpen = ulAIARecvPoolHeapAllocations();
+    xTickAtSpeakerOpen = xTaskGetTickCount();
+#endif
+
+    xReturned = prvClientSendEvent( aiaEventSpeakerOpened, &ullOpenOffset );
+    if( xReturned == pdPASS )
+    {
+        prvClientSetState( AIA_STATE_SPEAKER_OPENED );
+    }
+
+    return xReturned;
+}
+
+#ifdef DEBUG
+
+/* Report the figures of the playback as the speaker closes at ullCloseOffset. */
+static void prvClientReportSpeaker( uint64_t ullCloseOffset )
+{
+#if ( INCLUDE_uxTaskGetStackHighWaterMark == 1 )
+    /* Report memory usage of the speaker path at the end of each playback for stack sizing. The figures add up to
+     * the same total whether Opus keeps its scratch on the task stack (VAR_ARRAYS) or in the arena.
+     */
+    configPRINTF_DEBUG( ( "DEBUG: AIA_Speaker stack used %u of %u bytes, Opus scratch used %u of %u bytes\r\n",
+                          ( uint32_t )( ( aiaconfigAIA_SPEAKER_TASK_STACK_SIZE - uxTaskGetStackHighWaterMark( xSpeakerTaskHandle ) ) * sizeof( StackType_t ) ),
+                          ( uint32_t )( aiaconfigAIA_SPEAKER_TASK_STACK_SIZE * sizeof( StackType_t ) ),
+                          ( uint32_t )( aiaconfigCLIENT_DECODER_SCRATCH_SIZE - xAIAOpusScratchHighWaterMark() ),
+                          ( uint32_t )aiaconfigCLIENT_DECODER_SCRATCH_SIZE ) );
+#endif
+
+    {
+        uint32_t ulPlaybackMs = ( uint32_t )( ( xTaskGetTickCount() - xTickAtSpeakerOpen ) * portTICK_PERIOD_MS );
+        uint32_t ulHeapAllocations = ulAIARecvPoolHeapAllocations() - ulHeapAllocationsAtSpeakerOpen;
+
+        uint32_t ulPerSecondX100 = ( ulPlaybackMs != 0 ) ? ( uint32_t )( ( uint64_t )ulHeapAllocations * 100000UL / ulPlaybackMs ) : 0;
+
+        configPRINTF_DEBUG( ( "DEBUG: %u MQTT buffer heap allocations in %u ms of playback, %u.%02u per second\r\n",
+                              ulHeapAllocations, ulPlaybackMs, ulPerSecondX100 / 100, ulPerSecondX100 % 100 ) );
+    }
+
+    if( ulDroppedWhileClosed > 0 )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: Dropped %u old speaker messages while closed, %u cycles at most to write one\r\n",
+                              ulDroppedWhileClosed, xDropOldestMeter.ulMax ) );
+        ulDroppedWhileClosed = 0;
+        vAIACycleMeterReset( &xDropOldestMeter );
+    }
+
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+    {
+        uint32_t ulConcealCycles = ulAIACycleMeterAverage( &xConcealMeter );
+        uint32_t ulFrameCycles = configCPU_CLOCK_HZ / 1000UL * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS;
+
+        configPRINTF_DEBUG( ( "DEBUG: Concealed %u missing and %u late frames, %u from FEC, dropped %u late frames, "
+                              "%u cycles per frame (max %u, %u.%u%% of the frame)\r\n",
+                              ulConcealedMissingFrames, ulConcealedLateFrames, ulFecFrames, ulDroppedLateFrames,
+                              ulConcealCycles, xConcealMeter.ulMax,
+                              ( uint32_t )( ( uint64_t )xConcealMeter.ulMax * 100UL / ulFrameCycles ),
+                              ( uint32_t )( ( uint64_t )xConcealMeter.ulMax * 1000UL / ulFrameCycles % 10 ) ) );
+    }
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    configPRINTF_DEBUG( ( "DEBUG: Closed at offset %u played, last marker held %u ms for playback, max %u ms\r\n",
+                          ( uint32_t )ullCloseOffset, ulMarkerHeldMs, ulMarkerHeldMsMax ) );
+#endif
+
+    if( bFirstSoundPending == true )
+    {
+        bFirstSoundPending = false;
+        configPRINTF_DEBUG( ( "DEBUG: No sound since OpenSpeaker\r\n" ) );
+    }
+    else if( ulOpenToSoundCount != 0 )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: OpenSpeaker to first sound %u us, average %u us, max %u us\r\n",
+                              ulOpenToSoundUs, ulOpenToSoundUsTotal / ulOpenToSoundCount, ulOpenToSoundUsMax ) );
+    }
+}
+
+#endif
+
+static BaseType_t prvClientCloseSpeaker( uint64_t ullCloseOffset )
+{
+    BaseType_t xReturned;
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    uint64_t ullPlayedOffset;
+
+    /* Report the offset actually played, short of ullCloseOffset if the speaker is stopped early. Markers not played
+     * yet are dropped.
+     */
+    taskENTER_CRITICAL();
+    ullPlayedOffset = ullAIAPlayclockOffset( &xPlayclock );
+    vAIAPlayclockStop( &xPlayclock );
+    taskEXIT_CRITICAL();
+    if( ullPlayedOffset < ullCloseOffset )
+    {
+        ullCloseOffset = ullPlayedOffset;
+    }
+#endif
+
+    vPlatformSpeakerClose();
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    prvClientWarmupRelease( eAIAWarmupSpeaker );
+    bSpeakerStartupPending = false;
+#ifdef DEBUG
+    prvClientReportWarmup( eAIAWarmupSpeaker );
+#endif
+#endif
+    prvClientClearState( AIA_STATE_SPEAKER_OPENED );
+    xReturned = prvClientSendEvent( aiaEventSpeakerClosed, &ullCloseOffset );
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+    ulConcealedAhead = 0;
+    ulLateFrames = 0;
+    bFadeInPending = false;
+#endif
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+    /* The state and the volume are not left behind if the stream ends short of their offset. */
+    bSpeakerCloseDue = true;
+    prvClientRunOffsetActions( UINT64_MAX );
+    bSpeakerCloseDue = false;
+#endif
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+    prvClientPlayoutStreamEnd( ullCloseOffset );
+#endif
+
+#ifdef DEBUG
+    prvClientReportSpeaker( ullCloseOffset );
+#endif
+
+    return xReturned;
+}
+
+static BaseType_t prvClientSendMarker( uint32_t ulMarker )
+{
+    return prvClientSendEvent( aiaEventSpeakerMarkerEncountered, &ulMarker );
+}
+
+static BaseType_t prvClientBufferStateChanged( AIABufferStateChanged_t xBufferStateChanged )
+{
+    return prvClientSendEvent( aiaEventBufferStateChanged, &xBufferStateChanged );
+}
+
+#define STREAM_TASK_GOTO_FAIL( expr, str )            \
+        { if( ( expr ) == true ) {                    \
+            configPRINTF( ( str ) );                  \
+            goto stream_task_exit; } }
+
+/* Capture slots are handed to the outbound task with the audio they hold and given back once published. */
+static void prvClientReleaseMicrophoneBuffer( void * pvBuffer )
+{
+    vAIACaptureRelease( pvBuffer );
+}
+
+/* Called by the outbound task. Send fewer, larger messages while the network does not keep up. */
+static void prvClientMicrophoneBackpressure( BaseType_t xCongested )
+{
+    xMicrophoneCongested = xCongested;
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    /* Slots stay whole while a gesture holds the stream back, see prvClientWaitForGesture(). */
+    if( xGesture == eAIAGesturePressed || xGesture == eAIAGestureReleased )
+    {
+        return;
+    }
+#endif
+    vAIACaptureSetCongested( xCongested );
+}
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+
+/* Start a new microphone stream without any history of the previous one. */
+static void prvClientResetMicrophoneEncoder( AIAClient_Microphone_t * pxMicrophone )
+{
+    OPUS_LOCK();
+    opus_encoder_ctl( pxMicrophone->xEncoder, OPUS_RESET_STATE );
+    OPUS_UNLOCK();
+    pxMicrophone->xLastEncodedFrameValid = pdFALSE;
+
+#ifdef DEBUG
+    vAIACycleMeterReset( &xEncodeMeter );
+#endif
+}
+
+/* Encode the raw frames captured in pxAudioStream in place, as 20ms Opus frames. Every message holds whole frames,
+ * so that its offset is always on a frame boundary. Returns the number of encoded bytes.
+ *
+ * A frame that fails to encode is replaced with the last frame encoded, so that the offsets of the frames after it
+ * stay where they were captured. Before any frame of the stream has been encoded there is nothing to repeat: the
+ * failed frames are then left out of the start of the message, and counted in *pulSkippedFrames for the caller to
+ * leave a gap in the offsets.
+ */
+static size_t prvClientEncodeMicrophone( AIAClient_Microphone_t * pxMicrophone, AIABinaryAudioStream_t * pxAudioStream, uint32_t ulFrames,
+                                         uint32_t * pulSkippedFrames )
+{
+    /* The first encoded frame overlaps the raw frame it is encoded from, so it is staged here. */
+    uint8_t ucFirstFrame[ AIA_MICROPHONE_ENCODER_FRAME_SIZE ];
+    uint8_t * pucEncoded;
+    size_t xFrames = 0;
+    opus_int32 lEncoded;
+
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        pucEncoded = ( xFrames == 0 ) ? ucFirstFrame : pxAudioStream->ucAudio + xFrames * AIA_MICROPHONE_ENCODER_FRAME_SIZE;
+
+#ifdef DEBUG
+        vAIACycleMeterStart( &xEncodeMeter );
+#endif
+        OPUS_LOCK();
+        /* With VBR disabled every frame is exactly AIA_MICROPHONE_ENCODER_FRAME_SIZE bytes. */
+        lEncoded = opus_encode( pxMicrophone->xEncoder,
+                                ( const opus_int16 * )( pxAudioStream->ucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE ),
+                                AIA_MICROPHONE_RAW_FRAME_SAMPLES,
+                                pucEncoded,
+                                AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+        OPUS_UNLOCK();
+#ifdef DEBUG
+        vAIACycleMeterStop( &xEncodeMeter );
+#endif
+        configASSERT( xAIAOpusScratchIsIntact() == pdTRUE );
+
+        if( lEncoded == AIA_MICROPHONE_ENCODER_FRAME_SIZE )
+        {
+            memcpy( pxMicrophone->ucLastEncodedFrame, pucEncoded, AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+            pxMicrophone->xLastEncodedFrameValid = pdTRUE;
+        }
+        else
+        {
+            configPRINTF( ( "opus_encode error %d\r\n", ( int )lEncoded ) );
+            if( pxMicrophone->xLastEncodedFrameValid != pdTRUE )
+            {
+                ( *pulSkippedFrames )++;
+                continue;
+            }
+            memcpy( pucEncoded, pxMicrophone->ucLastEncodedFrame, AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+        }
+        xFrames++;
+    }
+
+    if( xFrames != 0 )
+    {
+        memcpy( pxAudioStream->ucAudio, ucFirstFrame, AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+        pxAudioStream->xHeader.ucCount = ( uint8_t )( xFrames - 1 );
+    }
+
+    return xFrames * AIA_MICROPHONE_ENCODER_FRAME_SIZE;
+}
+
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_GAP_SILENCE == 1 )
+
+/* Silence sent in place of the audio dropped during an overflow. Its frames are zeros, or the Opus frame the encoder
+ * makes of zeros. The outbound task gives the buffer back once the message has been published or dropped.
+ */
+static struct {
+    uint8_t ucMessage[ AIA_MSG_PARAMS_SIZE_SEQ + offsetof( AIABinaryAudioStream_t, ucAudio ) +
+                       AIA_MICROPHONE_MAX_FRAMES * AIA_MICROPHONE_STREAM_FRAME_SIZE ] __attribute__((aligned(4)));
+    SemaphoreHandle_t xFree;
+} xMicrophoneSilence;
+
+static void prvClientReleaseMicrophoneSilence( void * pvBuffer )
+{
+    ( void )pvBuffer;
+    xSemaphoreGive( xMicrophoneSilence.xFree );
+}
+
+static BaseType_t prvClientInitMicrophoneSilence( AIAClient_Microphone_t * pxMicrophone )
+{
+    xMicrophoneSilence.xFree = xSemaphoreCreateBinary();
+    if( xMicrophoneSilence.xFree == NULL )
+    {
+        return pdFAIL;
+    }
+    xSemaphoreGive( xMicrophoneSilence.xFree );
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    {
+        uint8_t * pucAudio = xMicrophoneSilence.ucMessage + AIA_MSG_PARAMS_SIZE_SEQ + offsetof( AIABinaryAudioStream_t, ucAudio );
+        opus_int16 * psZeros = ( opus_int16 * )pvPortMalloc( AIA_MICROPHONE_RAW_FRAME_SIZE );
+        opus_int32 lEncoded;
+
+        if( psZeros == NULL )
+        {
+            return pdFAIL;
+        }
+        memset( psZeros, 0, AIA_MICROPHONE_RAW_FRAME_SIZE );
+        OPUS_LOCK();
+        lEncoded = opus_encode( pxMicrophone->xEncoder, psZeros, AIA_MICROPHONE_RAW_FRAME_SAMPLES, pucAudio, AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+        opus_encoder_ctl( pxMicrophone->xEncoder, OPUS_RESET_STATE );
+        OPUS_UNLOCK();
+        vPortFree( psZeros );
+        if( lEncoded != AIA_MICROPHONE_ENCODER_FRAME_SIZE )
+        {
+            return pdFAIL;
+        }
+        for( uint32_t i = 1; i < AIA_MICROPHONE_MAX_FRAMES; i++ )
+        {
+            memcpy( pucAudio + i * AIA_MICROPHONE_ENCODER_FRAME_SIZE, pucAudio, AIA_MICROPHONE_ENCODER_FRAME_SIZE );
+        }
+    }
+#else
+    ( void )pxMicrophone;
+#endif
+
+    return pdPASS;
+}
+
+/* Send ulFrames frames of silence at the offset of the stream, in as many messages as it takes. */
+static BaseType_t prvClientSendMicrophoneSilence( AIAClient_Microphone_t * pxMicrophone, uint32_t ulFrames )
+{
+    AIABinaryAudioStream_t * pxAudioStream = ( AIABinaryAudioStream_t * )( xMicrophoneSilence.ucMessage + AIA_MSG_PARAMS_SIZE_SEQ );
+    AIAOutboundMessage_t xMessage;
+
+    while( ulFrames > 0 )
+    {
+        uint32_t ulCount = ( ulFrames > AIA_MICROPHONE_MAX_FRAMES ) ? AIA_MICROPHONE_MAX_FRAMES : ulFrames;
+        uint32_t ulBytes = ulCount * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+
+        /* Wait for the previous message of silence to be published. */
+        if( xSemaphoreTake( xMicrophoneSilence.xFree, aiaconfigAIA_DEFAULT_TIMEOUT ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+        pxAudioStream->xHeader.ucCount = ( uint8_t )( ulCount - 1 );
+#else
+        pxAudioStream->xHeader.ucCount = 0;
+#endif
+        pxAudioStream->xHeader.ulLength = ulBytes + sizeof( pxAudioStream->ullOffset );
+        pxAudioStream->ullOffset = pxMicrophone->ullMicrophoneOffset;
+
+        xMessage.pcTopic = AIA_TOPIC_MICROPHONE;
+        xMessage.pvPlaintext = pxAudioStream;
+        xMessage.ulLength = pxAudioStream->xHeader.ulLength + sizeof( AIABinaryHeader_t );
+        xMessage.pulSequence = &pxMicrophone->ulMicrophoneSequence;
+        xMessage.pvBuffer = xMicrophoneSilence.ucMessage;
+        xMessage.vRelease = prvClientReleaseMicrophoneSilence;
+        xMessage.xEvent = pdFALSE;
+        xMessage.xPublished = NULL;
+        if( xAIAOutboundSend( eAIAOutboundAudio, &xMessage, aiaconfigAIA_DEFAULT_TIMEOUT ) != pdPASS )
+        {
+            xSemaphoreGive( xMicrophoneSilence.xFree );
+            return pdFAIL;
+        }
+
+        pxMicrophone->ullMicrophoneOffset += ulBytes;
+        ulFrames -= ulCount;
+    }
+
+    return pdPASS;
+}
+
+#endif
+
+/* Stamp the offset of a filled slot and queue it to the outbound task, which releases it once published. Returns
+ * pdFAIL if the outbound task could not take the slot.
+ */
+static BaseType_t prvClientStreamMicrophoneSlot( AIAClient_Microphone_t * pxMicrophone, void * pvSlot, uint32_t ulFrames, uint32_t ulGapFrames )
+{
+    BaseType_t xReturned;
+    AIABinaryAudioStream_t * xAudioStream;
+    size_t xBytesReceived;
+    AIAOutboundMessage_t xMessage;
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    uint32_t ulSkippedFrames = 0;
+#endif
+
+    /* The audio dropped during an overflow is not spliced out of the stream: silence takes its place, or a hole is
+     * left in the offsets. Either way later offsets still match the time the audio was captured at. */
+    if( ulGapFrames != 0 )
+    {
+        configPRINTF( ( "WARN: Microphone overflow, %u ms of audio dropped at offset %u\r\n",
+                        ulGapFrames * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS,
+                        ( uint32_t )pxMicrophone->ullMicrophoneOffset ) );
+#if ( aiaconfigCLIENT_MICROPHONE_GAP_SILENCE == 1 )
+        if( prvClientSendMicrophoneSilence( pxMicrophone, ulGapFrames ) != pdPASS )
+        {
+            prvClientReleaseMicrophoneBuffer( pvSlot );
+            return pdFAIL;
+        }
+#else
+        pxMicrophone->ullMicrophoneOffset += ( uint64_t )ulGapFrames * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+#endif
+    }
+
+    xAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    xBytesReceived = prvClientEncodeMicrophone( pxMicrophone, xAudioStream, ulFrames, &ulSkippedFrames );
+    pxMicrophone->ullMicrophoneOffset += ( uint64_t )ulSkippedFrames * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+#else
+    xAudioStream->xHeader.ucCount = 0;
+    xBytesReceived = ulFrames * AIA_MICROPHONE_RAW_FRAME_SIZE;
+#endif
+    if( xBytesReceived == 0 )
+    {
+        prvClientReleaseMicrophoneBuffer( pvSlot );
+        return pdPASS;
+    }
+
+    xAudioStream->ullOffset = pxMicrophone->ullMicrophoneOffset;
+    xAudioStream->xHeader.ulLength = xBytesReceived + sizeof( xAudioStream->ullOffset );
+
+    /* The sequence number is taken by the outbound task when the message is published. */
+    xMessage.pcTopic = AIA_TOPIC_MICROPHONE;
+    xMessage.pvPlaintext = xAudioStream;
+    xMessage.ulLength = xAudioStream->xHeader.ulLength + sizeof( AIABinaryHeader_t );
+    xMessage.pulSequence = &pxMicrophone->ulMicrophoneSequence;
+    xMessage.pvBuffer = pvSlot;
+    xMessage.vRelease = prvClientReleaseMicrophoneBuffer;
+    xMessage.xEvent = pdFALSE;
+    xMessage.xPublished = NULL;
+    xReturned = xAIAOutboundSend( eAIAOutboundAudio, &xMessage, aiaconfigAIA_DEFAULT_TIMEOUT );
+    if( xReturned != pdPASS )
+    {
+        prvClientReleaseMicrophoneBuffer( pvSlot );
+        return pdFAIL;
+    }
+
+    pxMicrophone->ullMicrophoneOffset += xBytesReceived;
+
+    return pdPASS;
+}
+
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+
+/* Open an utterance on the wake word. The pre-roll is copied to slots right away, while the capture still leaves
+ * them free, and sent by prvClientSendWakewordPreroll() once MicrophoneOpened is queued. The capture keeps running,
+ * so the slots captured since the detection follow without a gap.
+ */
+static void prvClientOpenMicrophoneOnWakeword( AIAClient_Microphone_t * pxMicrophone )
+{
+    uint32_t ulCount = ulAIAWakewordPrerollFrames();
+    uint32_t ulBeginFrame, ulEndFrame;
+    uint32_t ulFrame;
+    AIABinaryAudioStream_t * pxAudioStream;
+    void * pvSlot;
+
+    vAIAWakewordGetIndices( &ulBeginFrame, &ulEndFrame );
+
+    /* Fill the slots from the newest frame backwards, so that only the oldest audio is lost if slots run out. */
+    ulWakewordPrerollSlots = 0;
+    while( ulCount > 0 && ulWakewordPrerollSlots < AIA_WAKEWORD_PREROLL_MAX_SLOTS )
+    {
+        uint32_t ulFrames = ( ulCount > AIA_MICROPHONE_MAX_FRAMES ) ? AIA_MICROPHONE_MAX_FRAMES : ulCount;
+
+        pvSlot = pvAIACaptureAcquire();
+        if( pvSlot == NULL )
+        {
+            break;
+        }
+
+        ulCount -= ulFrames;
+        pxAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+        for( ulFrame = 0; ulFrame < ulFrames; ulFrame++ )
+        {
+            memcpy( pxAudioStream->ucAudio + ulFrame * AIA_MICROPHONE_RAW_FRAME_SIZE,
+                    pvAIAWakewordPrerollFrame( ulCount + ulFrame ),
+                    AIA_MICROPHONE_RAW_FRAME_SIZE );
+        }
+        pvWakewordPreroll[ ulWakewordPrerollSlots ] = pvSlot;
+        ulWakewordPrerollFrames[ ulWakewordPrerollSlots ] = ulFrames;
+        ulWakewordPrerollSlots++;
+    }
+
+    if( ulCount > 0 )
+    {
+        configPRINTF( ( "WARN: No capture slot free for the first %u ms of the pre-roll\r\n",
+                        ulCount * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS ) );
+    }
+
+    /* The stream starts ulCount frames into the pre-roll. */
+    ulBeginFrame = ( ulBeginFrame > ulCount ) ? ulBeginFrame - ulCount : 0;
+    ulEndFrame = ( ulEndFrame > ulCount ) ? ulEndFrame - ulCount : 0;
+    AIAClient.xWakeword.pcWakeWordString = pxAIAWakewordGetEngine()->pcWakeWord;
+    AIAClient.xWakeword.ullWakeWordBegin = pxMicrophone->ullMicrophoneOffset + ( uint64_t )ulBeginFrame * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+    AIAClient.xWakeword.ullWakeWordEnd = pxMicrophone->ullMicrophoneOffset + ( uint64_t )ulEndFrame * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+    AIAClient.pcInitiatorType = "WAKEWORD";
+
+#ifdef DEBUG
+    {
+        AIAWakewordStatistics_t xStatistics;
+
+        vAIAWakewordGetStatistics( &xStatistics );
+        configPRINTF_DEBUG( ( "DEBUG: Wake word detected, spotter %u cycles per frame on average (%u%% of a frame), %u max, over %u frames\r\n",
+                              xStatistics.ulCyclesAverage,
+                              ( uint32_t )( ( uint64_t )xStatistics.ulCyclesAverage * 100UL * 1000UL /
+                                            ( ( uint64_t )configCPU_CLOCK_HZ * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS ) ),
+                              xStatistics.ulCyclesMax, xStatistics.ulFrames ) );
+    }
+    prvClientStartUtteranceStatistics( ulPlatformGetCycleCount() );
+#endif
+
+    taskENTER_CRITICAL();
+    bWakewordUtterance = true;
+    vAIACaptureSetListening( pdFALSE );
+    taskEXIT_CRITICAL();
+    if( prvClientSetState( AIA_STATE_MICROPHONE_OPENED ) == pdPASS )
+    {
+        vTaskSuspendAll();
+        if( bBufferOverrun == true )
+        {
+            bMicrophoneOpenedDuringOverrun = true;
+        }
+        xTaskResumeAll();
+
+        bSendMicrophoneOpenedEvent = true;
+    }
+    vPlatformLEDBlink( 500 );
+    vPlatformTouchButtonDisable();
+}
+
+/* Send the slots filled by prvClientOpenMicrophoneOnWakeword(), ahead of the live audio. */
+static BaseType_t prvClientSendWakewordPreroll( AIAClient_Microphone_t * pxMicrophone )
+{
+    BaseType_t xReturned = pdPASS;
+
+    for( uint32_t i = 0; i < ulWakewordPrerollSlots; i++ )
+    {
+        if( xReturned != pdPASS || prvClientGetState( AIA_STATE_MICROPHONE_OPENED ) != pdTRUE )
+        {
+            prvClientReleaseMicrophoneBuffer( pvWakewordPreroll[ ulWakewordPrerollSlots - 1 - i ] );
+            continue;
+        }
+        xReturned = prvClientStreamMicrophoneSlot( pxMicrophone, pvWakewordPreroll[ ulWakewordPrerollSlots - 1 - i ],
+                                                   ulWakewordPrerollFrames[ ulWakewordPrerollSlots - 1 - i ], 0 );
+    }
+    ulWakewordPrerollSlots = 0;
+
+    return xReturned;
+}
+
+/* Give the frames of a slot captured between utterances to the spotter. */
+static void prvClientListenMicrophone( AIAClient_Microphone_t * pxMicrophone, void * pvSlot, uint32_t ulFrames )
+{
+    AIABinaryAudioStream_t * pxAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+    BaseType_t xDetected = pdFALSE;
+
+    if( bResetWakeword == true )
+    {
+        bResetWakeword = false;
+        vAIAWakewordReset();
+    }
+
+    /* Frames after the wake word in the same slot still go to the pre-roll. */
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        if( xAIAWakewordProcess( pxAudioStream->ucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE ) == pdTRUE )
+        {
+            xDetected = pdTRUE;
+        }
+    }
+    prvClientReleaseMicrophoneBuffer( pvSlot );
+
+    if( xDetected == pdTRUE )
+    {
+        prvClientOpenMicrophoneOnWakeword( pxMicrophone );
+    }
+}
+
+#endif
+
+#if ( aiaconfigCLIENT_AEC == 1 )
+
+/* Remove the echo of the speaker from the frames of a slot. */
+static void prvClientCancelEcho( void * pvSlot, uint32_t ulFrames )
+{
+    AIABinaryAudioStream_t * pxAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+    uint32_t ulFirstFrame = ulAIACaptureFirstFrame( pvSlot );
+
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        vAIAAecProcess( ( int16_t * )( pxAudioStream->ucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE ), ulFirstFrame + i );
+    }
+}
+
+#endif
+
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+
+/* Run the front-end on the frames of a slot. */
+static void prvClientRunFrontend( void * pvSlot, uint32_t ulFrames )
+{
+    AIABinaryAudioStream_t * pxAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        vAIAFrontendProcess( ( int16_t * )( pxAudioStream->ucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE ) );
+    }
+}
+
+#endif
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+
+/* Run the endpointer on the frames of a slot. Returns pdTRUE if the microphone is to be closed on the end of speech,
+ * in which case *pulFrames is cut to the frames up to it.
+ */
+static BaseType_t prvClientDetectEndOfSpeech( AIAClient_Microphone_t * pxMicrophone, void * pvSlot, uint32_t * pulFrames )
+{
+    AIABinaryAudioStream_t * pxAudioStream = ( AIABinaryAudioStream_t * )( ( uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ );
+    BaseType_t xEndOfSpeech = pdFALSE;
+    uint32_t i;
+
+    for( i = 0; i < *pulFrames && xEndOfSpeech == pdFALSE; i++ )
+    {
+#ifdef DEBUG
+        vAIACycleMeterStart( &xEndpointerMeter );
+#endif
+        xEndOfSpeech = xAIAVadEndOfSpeech( &xVad, ( const int16_t * )( pxAudioStream->ucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE ),
+                                           AIA_MICROPHONE_RAW_FRAME_SAMPLES );
+#ifdef DEBUG
+        vAIACycleMeterStop( &xEndpointerMeter );
+#endif
+    }
+
+    if( xEndOfSpeech != pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+#ifdef DEBUG
+    bEndOfSpeechDetected = true;
+    xTickAtEndOfSpeech = xTaskGetTickCount();
+    ullOffsetAtEndOfSpeech = pxMicrophone->ullMicrophoneOffset + ( uint64_t )i * AIA_MICROPHONE_STREAM_FRAME_SIZE;
+#endif
+
+    if( xEndpointerEnabled != pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    /* Users end a long press themselves. */
+    if( xGesture == eAIAGestureHeld || xGesture == eAIAGestureHoldReleased )
+    {
+        return pdFALSE;
+    }
+#endif
+
+    *pulFrames = i;
+
+    return pdTRUE;
+}
+
+/* Close the microphone on the end of speech, as AIA would with CloseMicrophone. */
+static BaseType_t prvClientCloseMicrophoneOnEndOfSpeech( void )
+{
+    /* Unless CloseMicrophone has closed it meanwhile. */
+    if( prvClientTakeState( AIA_STATE_MICROPHONE_OPENED ) != pdTRUE )
+    {
+        return pdPASS;
+    }
+    configPRINTF( ( "End of speech detected, closing the microphone.\r\n" ) );
+    prvClientCloseMicrophone();
+    vPlatformLEDOff();
+
+    /* Queued after the last audio of the utterance, so its offset is where the stream ends. */
+    return prvClientSendEvent( aiaEventMicrophoneClosed, NULL );
+}
+
+#endif
+
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+
+/* Called by the microphone task before MicrophoneOpened is sent. Returns pdTRUE once the gesture that opened the
+ * microphone is known and the initiator set, and pdFALSE after waiting for it for a while.
+ */
+static BaseType_t prvClientWaitForGesture( void )
+{
+    TickType_t xNow = xTaskGetTickCount();
+    TickType_t xWait = 0;
+    BaseType_t xTouched;
+
+    taskENTER_CRITICAL();
+    xTouched = ( xGesture != eAIAGestureIdle ) ? pdTRUE : pdFALSE;
+    if( xGesture == eAIAGesturePressed )
+    {
+        if( xNow - xTickAtTouchDown >= pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_LONG_PRESS_MS ) )
+        {
+            AIAClient.pcInitiatorType = "HOLD";
+            xGesture = eAIAGestureHeld;
+        }
+        else
+        {
+            xWait = pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_LONG_PRESS_MS ) - ( xNow - xTickAtTouchDown );
+        }
+    }
+    else if( xGesture == eAIAGestureReleased )
+    {
+        if( xNow - xTickAtTouchUp >= pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_DOUBLE_TAP_MS ) )
+        {
+            AIAClient.pcInitiatorType = "TAP";
+            xGesture = eAIAGestureIdle;
+        }
+        else
+        {
+            xWait = pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_DOUBLE_TAP_MS ) - ( xNow - xTickAtTouchUp );
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xWait != 0 )
+    {
+        /* Woken up early by a release or a second tap. */
+        ulTaskNotifyTake( pdTRUE, xWait );
+        return pdFALSE;
+    }
+
+    if( xTouched == pdTRUE )
+    {
+        vAIACaptureSetCongested( xMicrophoneCongested );
+        vPlatformTouchButtonDisable();
+    }
+
+    return pdTRUE;
+}
+
+/* Cut a slot at the release of a long press. Returns pdTRUE if the microphone is to be closed after the slot, in which
+ * case *pulFrames is cut to the frames captured before the release.
+ */
+static BaseType_t prvClientDetectEndOfHold( void * pvSlot, uint32_t * pulFrames )
+{
+    int32_t lFrames;
+
+    taskENTER_CRITICAL();
+    if( xGesture != eAIAGestureHoldReleased )
+    {
+        taskEXIT_CRITICAL();
+        return pdFALSE;
+    }
+    /* Frame numbers wrap around, so only their distance counts. */
+    lFrames = ( int32_t )( ulFrameAtTouchUp - ulAIACaptureFirstFrame( pvSlot ) );
+    taskEXIT_CRITICAL();
+
+    if( lFrames > ( int32_t )*pulFrames )
+    {
+        return pdFALSE;
+    }
+
+    *pulFrames = ( lFrames > 0 ) ? ( uint32_t )lFrames : 0;
+
+    return pdTRUE;
+}
+
+/* Close the microphone on the release of a long press, as the HOLD initiator requires. */
+static BaseType_t prvClientCloseMicrophoneOnRelease( void )
+{
+    /* Unless CloseMicrophone has closed it meanwhile. */
+    if( prvClientTakeState( AIA_STATE_MICROPHONE_OPENED ) != pdTRUE )
+    {
+        return pdPASS;
+    }
+    configPRINTF( ( "Long press released, closing the microphone.\r\n" ) );
+    prvClientCloseMicrophone();
+    vPlatformLEDOff();
+
+    /* Queued after the last audio of the utterance, so its offset is where the stream ends. */
+    return prvClientSendEvent( aiaEventMicrophoneClosed, NULL );
+}
+
+#endif
+
+static void prvAIAStreamMicrophoneTask( void * pvParameters )
+{
+    BaseType_t xReturned;
+    AIAClient_Microphone_t * pxMicrophone;
+    uint32_t ulFrames;
+    uint32_t ulGapFrames;
+    void * pvSlot;
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+    BaseType_t xEndOfSpeech;
+#endif
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    BaseType_t xEndOfHold;
+#endif
+
+    pxMicrophone = &AIAClient.xMicrophone;
+
+    for( ;; )
+    {
+        /* While listening for the wake word or warm, the capture never stops and paces this task. */
+        prvClientWaitForState( AIA_STATE_MICROPHONE_OPENED | AIA_STATE_MICROPHONE_LISTENING | AIA_STATE_MICROPHONE_WARM,
+                               pdFALSE, pdFALSE, portMAX_DELAY );
+        if( bSendMicrophoneOpenedEvent == true )
+        {
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+            /* The audio waits in the capture slots until the initiator is known. */
+            if( prvClientWaitForGesture() != pdTRUE )
+            {
+                continue;
+            }
+#endif
+            bSendMicrophoneOpenedEvent = false;
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+            prvClientResetMicrophoneEncoder( pxMicrophone );
+#endif
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+            vAIAVadStart( &xVad );
+#ifdef DEBUG
+            vAIACycleMeterReset( &xEndpointerMeter );
+            bEndOfSpeechDetected = false;
+#endif
+#endif
+#if ( aiaconfigCLIENT_AEC == 1 ) && defined( DEBUG )
+            vAIAAecResetStatistics();
+#endif
+#if ( aiaconfigCLIENT_FRONTEND == 1 ) && defined( DEBUG )
+            vAIAFrontendResetStatistics();
+#endif
+#ifdef DEBUG
+            xTickAtMicrophoneOpen = xTaskGetTickCount();
+            vAIACaptureGetStatistics( &xCaptureAtMicrophoneOpen );
+#endif
+            xReturned = prvClientSendEvent( aiaEventMicrophoneOpened, NULL );
+            STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+            xReturned = prvClientSendWakewordPreroll( pxMicrophone );
+            STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
+#endif
+        }
+
+        /* The DMA fills the slots, so the wait is bounded by the duration of the largest message plus extra 50ms. */
+        xReturned = xAIACaptureReceive( &pvSlot, &ulFrames, &ulGapFrames,
+                                        pdMS_TO_TICKS( AIA_MICROPHONE_MAX_FRAMES * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS + 50 ) );
+        if( xReturned != pdPASS )
+        {
+            continue;
+        }
+
+#if ( aiaconfigCLIENT_AEC == 1 ) || ( aiaconfigCLIENT_FRONTEND == 1 )
+        /* The slots of a warm or closed microphone are dropped below, and not worth the cycles. */
+        if( prvClientGetState( AIA_STATE_MICROPHONE_OPENED | AIA_STATE_MICROPHONE_LISTENING ) == pdTRUE )
+        {
+#if ( aiaconfigCLIENT_AEC == 1 )
+            /* Before the spotter and the endpointer, so that neither hears the speaker. */
+            prvClientCancelEcho( pvSlot, ulFrames );
+#endif
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+            prvClientRunFrontend( pvSlot, ulFrames );
+#endif
+        }
+#endif
+
+        /* Only publish the message if CloseMicrophone is not received yet. */
+        if( prvClientGetState( AIA_STATE_MICROPHONE_OPENED ) != pdTRUE )
+        {
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+            if( prvClientGetState( AIA_STATE_MICROPHONE_LISTENING ) == pdTRUE )
+            {
+                prvClientListenMicrophone( pxMicrophone, pvSlot, ulFrames );
+                continue;
+            }
+#endif
+            prvClientReleaseMicrophoneBuffer( pvSlot );
+            continue;
+        }
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+        xEndOfSpeech = prvClientDetectEndOfSpeech( pxMicrophone, pvSlot, &ulFrames );
+#endif
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+        xEndOfHold = prvClientDetectEndOfHold( pvSlot, &ulFrames );
+#endif
+
+        xReturned = prvClientStreamMicrophoneSlot( pxMicrophone, pvSlot, ulFrames, ulGapFrames );
+        STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+        if( xEndOfSpeech == pdTRUE )
+        {
+            xReturned = prvClientCloseMicrophoneOnEndOfSpeech();
+            STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
+        }
+#endif
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+        if( xEndOfHold == pdTRUE )
+        {
+            xReturned = prvClientCloseMicrophoneOnRelease();
+            STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
+        }
+#endif
+    }
+
+stream_task_exit:
+    /* Signal the demo task. */
+    if( xDemoTaskHandle != NULL )
+    {
+        xTaskNotifyGive( xDemoTaskHandle );
+    }
+    vTaskDelete( NULL );
+}
+
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+/* Send the events that the audio played has reached. Pended from the speaker read functions to the timer task. */
+static void prvClientPlayclockDue( void * pvParameter1, uint32_t ulParameter2 )
+{
+    AIAPlayclockEvent_t xEvent;
+    BaseType_t xTaken;
+
+    ( void )pvParameter1;
+    ( void )ulParameter2;
+
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        xTaken = xAIAPlayclockTakeDue( &xPlayclock, &xEvent );
+        taskEXIT_CRITICAL();
+        if( xTaken != pdTRUE )
+        {
+            break;
+        }
+
+        if( xEvent.xType == eAIAPlayclockMarker )
+        {
+            prvClientSendMarker( xEvent.ulValue );
+        }
+        else
+        {
+            xTaskNotifyGive( xSpeakerTaskHandle );
+        }
+    }
+}
+
+/* Send SpeakerMarkerEncountered once the audio before the marker has been played. */
+static void prvClientPlayclockMarker( uint32_t ulMarker )
+{
+    BaseType_t xHeld;
+#ifdef DEBUG
+    uint32_t ulUnplayed;
+#endif
+
+    taskENTER_CRITICAL();
+    xHeld = xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockMarker, ulMarker );
+#ifdef DEBUG
+    ulUnplayed = ulAIAPlayclockUnplayed( &xPlayclock );
+#endif
+    taskEXIT_CRITICAL();
+
+    if( xHeld != pdPASS )
+    {
+        /* The speaker is closed, or too many markers are held. */
+        prvClientSendMarker( ulMarker );
+        return;
+    }
+
+#ifdef DEBUG
+    ulMarkerHeldMs = ulUnplayed * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / AIA_SPEAKER_RAW_FRAME_SIZE;
+    if( ulMarkerHeldMs > ulMarkerHeldMsMax )
+    {
+        ulMarkerHeldMsMax = ulMarkerHeldMs;
+    }
+#endif
+    /* Everything written may have been played already. */
+    prvClientPlayclockDue( NULL, 0 );
+}
+
+/* Wait for the audio written to be played before the speaker is closed at the end of the stream. */
+static void prvClientPlayclockDrain( void )
+{
+    TimeOut_t xTimeOut;
+    TickType_t xTicksToWait;
+    BaseType_t xHeld;
+    uint32_t ulUnplayed;
+
+    /* The end is signalled by a notification from prvClientPlayclockDue(). Drop any left from before. */
+    ( void )ulTaskNotifyTake( pdTRUE, 0 );
+
+    taskENTER_CRITICAL();
+    xHeld = xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockEnd, 0 );
+    ulUnplayed = ulAIAPlayclockUnplayed( &xPlayclock );
+    taskEXIT_CRITICAL();
+    if( xHeld != pdPASS )
+    {
+        return;
+    }
+    prvClientPlayclockDue( NULL, 0 );
+
+    /* Give up if the speaker stops playing, allowing for the audio written and for the DMA buffer. */
+    xTicksToWait = pdMS_TO_TICKS( ulUnplayed * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / AIA_SPEAKER_RAW_FRAME_SIZE +
+                                  2 * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    vTaskSetTimeOutState( &xTimeOut );
+    while( ulTaskNotifyTake( pdTRUE, xTicksToWait ) == 0 )
+    {
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+        {
+            configPRINTF_DEBUG( ( "DEBUG: Speaker not played out before close\r\n" ) );
+            break;
+        }
+    }
+}
+#endif
+
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+static void prvClientRunOffsetAction( const AIAOffsetAction_t * pxAction )
+{
+    AIAClient_SetVolume_t xSetVolume;
+
+    switch( ( AIAClient_OffsetAction_t )pxAction->ulAction )
+    {
+        case eAIAOffsetActionSetVolume:
+            xSetVolume.ulVolume = pxAction->ulValue;
+            xSetVolume.ullOffset = pxAction->ullOffset;
+            prvClientSetVolume( xSetVolume );
+            break;
+        case eAIAOffsetActionSetAttentionState:
+            prvClientSetAttentionState( ( EventBits_t )pxAction->ulValue );
+            break;
+        case eAIAOffsetActionCloseSpeaker:
+            /* A CloseSpeaker replaced by a later one is ignored. */
+            if( pxAction->ullOffset == AIAClient.xSpeaker.ullCloseOffset )
+            {
+                bSpeakerCloseDue = true;
+            }
+            break;
+    }
+}
+
+/* Take the actions due by the frame at ullOffset, before it is played. */
+static void prvClientRunOffsetActions( uint64_t ullOffset )
+{
+    AIAOffsetAction_t xAction;
+    BaseType_t xTaken;
+
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        xTaken = xAIAOffsetSchedTake( &xOffsetActions, ullOffset, &xAction );
+        taskEXIT_CRITICAL();
+        if( xTaken != pdTRUE )
+        {
+            break;
+        }
+        configPRINTF_DEBUG( ( "DEBUG: Action %u at offset %u taken at %u\r\n", xAction.ulAction,
+                              ( uint32_t )xAction.ullOffset, ( uint32_t )ullOffset ) );
+        prvClientRunOffsetAction( &xAction );
+    }
+}
+#endif
+
+/* Apply the volume to a frame of decoded audio and send it to the speaker. ullOffset is the offset of the frame. */
+static void prvClientPlayFrame( int16_t * psFrame, uint64_t ullOffset )
+{
+    int16_t *psData = psFrame;
+    size_t xBytesSent = 0;
+
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+    prvClientRunOffsetActions( ullOffset );
+    if( bSpeakerCloseDue == true )
+    {
+        /* Nothing is played past the offset of CloseSpeaker. */
+        return;
+    }
+#endif
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    taskENTER_CRITICAL();
+    vAIAPlayclockWrite( &xPlayclock, ullOffset );
+    taskEXIT_CRITICAL();
+#else
+    ( void )ullOffset;
+#endif
+
+    for( int i = 0; i < AIA_SPEAKER_RAW_FRAME_SAMPLES; i++ )
+    {
+        *psData = ( *psData * ( int )AIAClient.xSpeaker.ulVolume ) >> 7;
+        psData++;
+    }
+
+    while( xBytesSent < AIA_SPEAKER_RAW_FRAME_SIZE )
+    {
+        xBytesSent += xStreamBufferSend( AIAClient.xSpeaker.xDecodeBuffer,
+                                         ( uint8_t * )psFrame + xBytesSent,
+                                         AIA_SPEAKER_RAW_FRAME_SIZE - xBytesSent,
+                                         pdMS_TO_TICKS( 40 ) );
+    }
+}
+
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+/* Have the decoder make up a frame, from the FEC data of pucNext if it is given. */
+static void prvClientConcealFrame( const uint8_t * pucNext, int16_t * psFrame )
+{
+    int ret;
+
+#ifdef DEBUG
+    vAIACycleMeterStart( &xConcealMeter );
+#endif
+    OPUS_LOCK();
+    if( pucNext != NULL )
+    {
+        ret = opus_decode( AIAClient.xSpeaker.xDecoder, pucNext, AIA_SPEAKER_DECODER_FRAME_SIZE,
+                           psFrame, AIA_SPEAKER_RAW_FRAME_SAMPLES, 1 );
+    }
+    else
+    {
+        ret = opus_decode( AIAClient.xSpeaker.xDecoder, NULL, 0, psFrame, AIA_SPEAKER_RAW_FRAME_SAMPLES, 0 );
+    }
+    OPUS_UNLOCK();
+#ifdef DEBUG
+    vAIACycleMeterStop( &xConcealMeter );
+    if( pucNext != NULL )
+    {
+        ulFecFrames++;
+    }
+#endif
+    configASSERT( xAIAOpusScratchIsIntact() == pdTRUE );
 
-    return xReturned;
+    if( ret != AIA_SPEAKER_RAW_FRAME_SAMPLES )
+    {
+        memset( psFrame, 0, AIA_SPEAKER_RAW_FRAME_SIZE );
+    }
+    /* Every frame concealed is played next, before the volume is applied. */
+    sFadeFrom = psFrame[ AIA_SPEAKER_RAW_FRAME_SAMPLES - 1 ];
+    bFadeInPending = true;
 }
 
-static BaseType_t prvClientOpenMicrophoneFromISR( BaseType_t * pxHigherPriorityTaskWoken )
+/* Fade from the last sample concealed into the frame, to hide the seam after concealment. */
+static void prvClientFadeIn( int16_t * psFrame )
 {
-    BaseType_t xReturned;
-
-    xReturned = prvClientSetStateFromISR( AIA_STATE_MICROPHONE_OPENED, pxHigherPriorityTaskWoken );
-    if( xReturned == pdPASS )
+    for( int32_t i = 0; i < AIA_SPEAKER_FADE_SAMPLES; i++ )
     {
-        if( bBufferOverrun == true )
-        {
-            bMicrophoneOpenedDuringOverrun = true;
-        }
-
-        bSendMicrophoneOpenedEvent = true;
+        psFrame[ i ] = ( int16_t )( ( sFadeFrom * ( AIA_SPEAKER_FADE_SAMPLES - i ) + psFrame[ i ] * i ) /
+                                    AIA_SPEAKER_FADE_SAMPLES );
     }
+}
 
-    vPlatformLEDBlink( 500 );
-    vPlatformMicrophoneOpen();
+/* Whether the stream goes on past the audio played so far and the frames concealed ahead of it: CloseSpeaker has
+ * come with a later offset, or the /speaker handler has audio after the expected message.
+ */
+static bool prvClientSpeakerContinues( void )
+{
+    AIAClient_Speaker_t * pxSpeaker = &AIAClient.xSpeaker;
+    uint64_t ullNext = pxSpeaker->ullOutputOffset + ( uint64_t )ulConcealedAhead * AIA_SPEAKER_DECODER_FRAME_SIZE;
 
-    return xReturned;
+    if( pxSpeaker->ullCloseOffset > pxSpeaker->ullOpenOffset && pxSpeaker->ullCloseOffset > ullNext )
+    {
+        return true;
+    }
+    return bSpeakerAudioAhead;
 }
 
-static BaseType_t prvClientCloseMicrophone( void )
+/* How long the speaker task can wait for audio before it has to conceal a frame for it: until what has been decoded
+ * is down to half a frame, if the stream is known to go on. Otherwise nothing is concealed, and xTicksToWait is
+ * returned.
+ */
+static TickType_t prvClientConcealWait( TickType_t xTicksToWait )
 {
-    BaseType_t xReturned;
-
-    vPlatformMicrophoneClose();
-    xReturned = prvClientClearState( AIA_STATE_MICROPHONE_OPENED );
+    uint32_t ulDecodedMs = ( uint32_t )( xStreamBufferBytesAvailable( AIAClient.xSpeaker.xDecodeBuffer ) *
+                                         aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / AIA_SPEAKER_RAW_FRAME_SIZE );
 
-    return xReturned;
+    if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) != pdTRUE ||
+        AIAClient.xSpeaker.ullOutputOffset < AIAClient.xSpeaker.ullOpenOffset ||
+        ulLateFrames >= aiaconfigCLIENT_SPEAKER_PLC_MAX_FRAMES )
+    {
+        return xTicksToWait;
+    }
+    if( ulDecodedMs > aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / 2 )
+    {
+        return pdMS_TO_TICKS( ulDecodedMs - aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / 2 );
+    }
+    return ( prvClientSpeakerContinues() == true ) ? 0 : xTicksToWait;
 }
 
-static BaseType_t prvClientOpenSpeaker( uint64_t ullOpenOffset )
+/* Conceal a frame while no audio has come, as long as the stream is known to go on. Returns pdTRUE if one was
+ * played.
+ */
+static BaseType_t prvClientConcealLate( int16_t * psFrame )
 {
-    BaseType_t xReturned;
-
-    xStreamBufferReset( AIAClient.xSpeaker.xDecodeBuffer );
-    vPlatformSpeakerOpen();
+    AIAClient_Speaker_t * pxSpeaker = &AIAClient.xSpeaker;
 
-    xReturned = prvClientSendEvent( aiaEventSpeakerOpened, &ullOpenOffset );
-    if( xReturned == pdPASS )
+    if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) != pdTRUE ||
+        pxSpeaker->ullOutputOffset < pxSpeaker->ullOpenOffset ||
+        ulLateFrames >= aiaconfigCLIENT_SPEAKER_PLC_MAX_FRAMES ||
+        xStreamBufferBytesAvailable( pxSpeaker->xDecodeBuffer ) > AIA_SPEAKER_RAW_FRAME_SIZE / 2 ||
+        prvClientSpeakerContinues() != true )
     {
-        prvClientSetState( AIA_STATE_SPEAKER_OPENED );
+        return pdFALSE;
     }
 
-    return xReturned;
+    prvClientConcealFrame( NULL, psFrame );
+    prvClientPlayFrame( psFrame, pxSpeaker->ullOutputOffset + ( uint64_t )ulConcealedAhead * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    ulConcealedAhead++;
+    ulLateFrames++;
+#ifdef DEBUG
+    ulConcealedLateFrames++;
+#endif
+
+    return pdTRUE;
 }
+#endif
 
-static BaseType_t prvClientCloseSpeaker( uint64_t ullCloseOffset )
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 ) || ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+/* Fill the hole left in a stream by missing messages, so that what follows plays in time. With concealment, the
+ * decoder makes up the audio, the last frame from the FEC data of pucNext. Otherwise it is silence.
+ */
+static void prvClientConcealGap( uint64_t ullMissingBytes, const uint8_t * pucNext, int16_t * psFrame )
 {
-    BaseType_t xReturned;
+    uint32_t ulFrames = ( uint32_t )( ullMissingBytes / AIA_SPEAKER_DECODER_FRAME_SIZE );
+    uint64_t ullFrameOffset = AIAClient.xSpeaker.ullOutputOffset;
 
-    vPlatformSpeakerClose();
-    prvClientClearState( AIA_STATE_SPEAKER_OPENED );
-    xReturned = prvClientSendEvent( aiaEventSpeakerClosed, &ullCloseOffset );
+    if( ulFrames > aiaconfigCLIENT_SPEAKER_GAP_CONCEAL_MS / aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS )
+    {
+        ulFrames = aiaconfigCLIENT_SPEAKER_GAP_CONCEAL_MS / aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS;
+    }
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+    xGapStatistics.ulConcealedFrames += ulFrames;
+#endif
 
-    return xReturned;
-}
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+    /* Frames concealed while the audio was late stand in for the first missing ones. */
+    if( ulConcealedAhead >= ulFrames )
+    {
+        ulConcealedAhead -= ulFrames;
+        return;
+    }
+    ulFrames -= ulConcealedAhead;
+    ullFrameOffset += ( uint64_t )ulConcealedAhead * AIA_SPEAKER_DECODER_FRAME_SIZE;
+    ulConcealedAhead = 0;
 
-static BaseType_t prvClientSendMarker( uint32_t ulMarker )
-{
-    return prvClientSendEvent( aiaEventSpeakerMarkerEncountered, &ulMarker );
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        prvClientConcealFrame( ( i == ulFrames - 1 ) ? pucNext : NULL, psFrame );
+        prvClientPlayFrame( psFrame, ullFrameOffset + ( uint64_t )i * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    }
+#ifdef DEBUG
+    ulConcealedMissingFrames += ulFrames;
+#endif
+#else
+    ( void )pucNext;
+    memset( psFrame, 0, AIA_SPEAKER_RAW_FRAME_SIZE );
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        prvClientPlayFrame( psFrame, ullFrameOffset + ( uint64_t )i * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    }
+#endif
 }
+#endif
 
-static BaseType_t prvClientBufferStateChanged( AIABufferStateChanged_t xBufferStateChanged )
+#if ( aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES > 0 )
+static void prvClientDecodeAheadDiscard( void )
 {
-    return prvClientSendEvent( aiaEventBufferStateChanged, &xBufferStateChanged );
+    if( ulDecodeAheadNext < ulDecodeAheadFrames )
+    {
+        /* The decoder has gone past the audio that is played next. */
+        OPUS_LOCK();
+        opus_decoder_ctl( AIAClient.xSpeaker.xDecoder, OPUS_RESET_STATE );
+        OPUS_UNLOCK();
+    }
+    ulDecodeAheadFrames = 0;
+    ulDecodeAheadNext = 0;
 }
 
-#define STREAM_TASK_GOTO_FAIL( expr, str )            \
-        { if( ( expr ) == true ) {                    \
-            configPRINTF( ( str ) );                  \
-            goto stream_task_exit; } }
-
-static void prvAIAStreamMicrophoneTask( void * pvParameters )
+/* Copy the first /speaker message as it arrives and decode the start of its audio, for OpenSpeaker to find it ready.
+ * The message is not read from the speaker buffer: if it is dropped before the speaker opens, the frames decoded ahead
+ * do not match the next message played, and are discarded.
+ */
+static void prvClientDecodeAheadHold( void )
 {
-    BaseType_t xReturned;
-    char * pcBlob = NULL;
-    AIABinaryAudioStream_t * xAudioStream;
-    AIAClient_Microphone_t * pxMicrophone;
-    TimeOut_t xTimeOut;
-    size_t xBytesReceived;
-    TickType_t xTicksToWait;
-    char * pcEncryptedMessage = NULL;
-    int32_t lEncryptedMessageLength;
-
-    /* Allocate memory for receiving data from microphone buffer */
-    pcBlob = ( char * )pvPortMalloc( AIA_MSG_PARAMS_SIZE_SEQ + sizeof( AIABinaryAudioStream_t ) );
-    STREAM_TASK_GOTO_FAIL( pcBlob == NULL, "Failed to allocate memory for audio stream!\r\n" );
-
-    /* Allocate a buffer to hold the encrypted message. */
-    pcEncryptedMessage = ( char * )pvPortMalloc( sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + sizeof( AIABinaryAudioStream_t ) );
-    STREAM_TASK_GOTO_FAIL( pcEncryptedMessage == NULL, "Failed to allocate memory for encrypted event message!\r\n" );
-
-    xAudioStream = ( AIABinaryAudioStream_t * )( pcBlob + AIA_MSG_PARAMS_SIZE_SEQ );
-    memset( xAudioStream, 0x0, sizeof(AIABinaryAudioStream_t) );
-
-    pxMicrophone = &AIAClient.xMicrophone;
+    AIAClient_Speaker_t * pxSpeaker = &AIAClient.xSpeaker;
+    AIABinaryHeader_t * pxBinaryHeader;
+    const uint8_t * pucMsg;
+    const uint8_t * pucEnd;
+    size_t xMsgLen;
 
-    for( ;; )
+    xMsgLen = xAIASpeakerBufferPeek( &pxSpeaker->xSpeakerBuffer, ucDecodeTaskTemp, sizeof( ucDecodeTaskTemp ), portMAX_DELAY );
+    if( xMsgLen <= sizeof( uint32_t ) )
     {
-        prvClientWaitForState( AIA_STATE_MICROPHONE_OPENED, pdFALSE, pdFALSE, portMAX_DELAY );
-        if( bSendMicrophoneOpenedEvent == true )
-        {
-            bSendMicrophoneOpenedEvent = false;
-            xReturned = prvClientSendEvent( aiaEventMicrophoneOpened, NULL );
-            STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
-        }
-
-        xBytesReceived = 0;
+        return;
+    }
 
-        /* Set a total timeout of the duration of one audio message plus extra 50ms */
-        xTicksToWait = pdMS_TO_TICKS( aiaconfigAIA_AUDIO_DATA_SIZE / ( aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE * aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RESOLUTION / 8 / 1000 ) + 50 );
-        vTaskSetTimeOutState( &xTimeOut );
+    bDecodeAheadHeld = true;
+    prvClientDecodeAheadDiscard();
 
-        while( xBytesReceived < aiaconfigAIA_AUDIO_DATA_SIZE && xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdTRUE )
+    /* The lengths in the message are checked against what was received before anything is decoded. */
+    pucMsg = ucDecodeTaskTemp + sizeof( uint32_t );
+    pucEnd = ucDecodeTaskTemp + xMsgLen;
+    while( ( size_t )( pucEnd - pucMsg ) >= sizeof( AIABinaryHeader_t ) &&
+           ulDecodeAheadFrames < aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES )
+    {
+        pxBinaryHeader = ( AIABinaryHeader_t * )pucMsg;
+        pucMsg += sizeof( AIABinaryHeader_t );
+        if( pxBinaryHeader->ulLength > ( size_t )( pucEnd - pucMsg ) )
         {
-            xBytesReceived += xStreamBufferReceive( pxMicrophone->xMicBuffer,
-                                                    xAudioStream->ucAudio + xBytesReceived,
-                                                    aiaconfigAIA_AUDIO_DATA_SIZE - xBytesReceived,
-                                                    xTicksToWait );
+            break;
         }
 
-        if( xBytesReceived != 0 )
+        if( pxBinaryHeader->ucType == 0 && pxBinaryHeader->ulLength >= sizeof( uint64_t ) )
         {
-            xAudioStream->ullOffset = pxMicrophone->ullMicrophoneOffset;
-            xAudioStream->xHeader.ulLength = xBytesReceived + sizeof( xAudioStream->ullOffset );
-
-            lEncryptedMessageLength = lAIACryptoEncrypt( &AIAClient.xCrypto,
-                                                          pcEncryptedMessage,
-                                                          xAudioStream,
-                                                          xAudioStream->xHeader.ulLength + sizeof( AIABinaryHeader_t ),
-                                                          pxMicrophone->ulMicrophoneSequence );
-            STREAM_TASK_GOTO_FAIL( lEncryptedMessageLength < 0, "Failed to encrypt message!\r\n" );
+            uint64_t ullOffset = ( uint64_t )*( uint32_t * )( pucMsg + sizeof( uint32_t ) ) << 32 | *( uint32_t * )pucMsg;
+            uint32_t ulFrames = ( pxBinaryHeader->ulLength - sizeof( uint64_t ) ) / AIA_SPEAKER_DECODER_FRAME_SIZE;
 
-            /* Only publish the message if CloseMicrophone is not received yet. */
-            if( prvClientGetState( AIA_STATE_MICROPHONE_OPENED ) == pdTRUE )
+            for( uint32_t i = 0; i < ulFrames && ulDecodeAheadFrames < aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES; i++ )
             {
-                xReturned = prvClientPublishMessage( AIA_TOPIC_MICROPHONE, pcEncryptedMessage, lEncryptedMessageLength );
-                STREAM_TASK_GOTO_FAIL( xReturned != pdPASS, "" );
-
-                pxMicrophone->ulMicrophoneSequence++;
-                pxMicrophone->ullMicrophoneOffset += xBytesReceived;
+                OPUS_LOCK();
+                int ret = opus_decode( pxSpeaker->xDecoder,
+                                       pucMsg + sizeof( uint64_t ) + i * AIA_SPEAKER_DECODER_FRAME_SIZE,
+                                       AIA_SPEAKER_DECODER_FRAME_SIZE,
+                                       sDecodeAhead[ ulDecodeAheadFrames ],
+                                       AIA_SPEAKER_RAW_FRAME_SAMPLES,
+                                       0 );
+                OPUS_UNLOCK();
+                if( ret != AIA_SPEAKER_RAW_FRAME_SAMPLES )
+                {
+                    break;
+                }
+                ullDecodeAheadOffset[ ulDecodeAheadFrames++ ] = ullOffset + i * AIA_SPEAKER_DECODER_FRAME_SIZE;
             }
         }
+        pucMsg += pxBinaryHeader->ulLength;
     }
 
-stream_task_exit:
-    if( pcBlob != NULL )
-    {
-        vPortFree( pcBlob );
-    }
+    configPRINTF_DEBUG( ( "DEBUG: Decoded %u frames ahead of OpenSpeaker\r\n", ulDecodeAheadFrames ) );
+}
 
-    if( pcEncryptedMessage != NULL )
+/* Get the frame at ullOffset if it has been decoded ahead. Frames decoded ahead but not played are discarded. */
+static int16_t * prvClientDecodeAheadTake( uint64_t ullOffset )
+{
+    if( ulDecodeAheadNext < ulDecodeAheadFrames )
     {
-        vPortFree( pcEncryptedMessage );
+        if( ullDecodeAheadOffset[ ulDecodeAheadNext ] == ullOffset )
+        {
+            return sDecodeAhead[ ulDecodeAheadNext++ ];
+        }
+        prvClientDecodeAheadDiscard();
     }
 
-    /* Signal the demo task. */
-    if( xDemoTaskHandle != NULL )
-    {
-        xTaskNotifyGive( xDemoTaskHandle );
-    }
-    vTaskDelete( NULL );
+    return NULL;
 }
+#endif
 
 static void prvAIASpeakerTask( void * pvParameters )
 {
@@ -1666,23 +4251,46 @@ static void prvAIASpeakerTask( void * pvParameters )
     int16_t sDecodeTemp[ AIA_SPEAKER_RAW_FRAME_SAMPLES ];
     size_t xBytesRemainedBefore, xBytesRemained;
     AIABufferStateChanged_t xBufferStateChanged;
+    TickType_t xTicksToWait;
 
     for( ; ; )
     {
         if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) != pdTRUE )
         {
+#if ( aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES > 0 )
+            if( bDecodeAheadHeld == false && prvClientGetState( AIA_STATE_OPENSPEAKER_RECEIVED ) != pdTRUE )
+            {
+                prvClientDecodeAheadHold();
+            }
+#endif
             prvClientWaitForState( AIA_STATE_OPENSPEAKER_RECEIVED, pdFALSE, pdFALSE, portMAX_DELAY );
         }
 
-        xBytesRemainedBefore = xStreamBufferBytesAvailable( ( StreamBufferHandle_t )pxSpeaker->xSpeakerBuffer );
+        xBytesRemainedBefore = xAIASpeakerBufferBytesAvailable( &pxSpeaker->xSpeakerBuffer );
+        xTicksToWait = pdMS_TO_TICKS( 2000 );
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+        /* Leave time to conceal a frame before what has been decoded runs out. */
+        xTicksToWait = prvClientConcealWait( xTicksToWait );
+        if( xBytesRemainedBefore == 0  && prvClientGetState( AIA_STATE_OPENSPEAKER_RECEIVED ) != pdTRUE && ulLateFrames == 0 )
+#else
         if( xBytesRemainedBefore == 0  && prvClientGetState( AIA_STATE_OPENSPEAKER_RECEIVED ) != pdTRUE )
+#endif
         {
             xBufferStateChanged.ulSequence = ulSeq + 1;
             xBufferStateChanged.pcBufferStateStr = "UNDERRUN";
             prvClientBufferStateChanged( xBufferStateChanged );
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+            taskENTER_CRITICAL();
+            vAIAPlayoutUnderrun( &xPlayout );
+            taskEXIT_CRITICAL();
+#endif
         }
 
-        xMsgLen = xMessageBufferReceive( pxSpeaker->xSpeakerBuffer, ucDecodeTaskTemp, sizeof( ucDecodeTaskTemp ), pdMS_TO_TICKS( 2000 ) );
+#if ( aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES > 0 )
+        /* The held message is read as any other, and the next time the speaker closes, another is held. */
+        bDecodeAheadHeld = false;
+#endif
+        xMsgLen = xAIASpeakerBufferReceive( &pxSpeaker->xSpeakerBuffer, ucDecodeTaskTemp, sizeof( ucDecodeTaskTemp ), xTicksToWait );
 
         if( xMsgLen == 0 )
         {
@@ -1696,12 +4304,22 @@ static void prvAIASpeakerTask( void * pvParameters )
                 /* In case that a CloseSpeaker directive with no offset is received, close the speaker
                  * at the current output offset.
                  */
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+                if( prvClientGetState( AIA_STATE_CLOSESPEAKERNOOFFSET_RECEIVED ) != pdTRUE )
+                {
+                    prvClientPlayclockDrain();
+                }
+#endif
                 prvClientClearState( AIA_STATE_CLOSESPEAKERNOOFFSET_RECEIVED );
                 pxSpeaker->ullCloseOffset = pxSpeaker->ullOutputOffset;
 
                 prvClientCloseSpeaker( pxSpeaker->ullOutputOffset );
             }
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+            else if( prvClientConcealLate( sDecodeTemp ) != pdTRUE )
+#else
             else
+#endif
             {
                 configPRINTF_DEBUG( ( "DEBUG: No data in the speaker buffer!\r\n" ) );
             }
@@ -1709,7 +4327,7 @@ static void prvAIASpeakerTask( void * pvParameters )
         }
 
         ulSeq = *( uint32_t * )ucDecodeTaskTemp;
-        xBytesRemained = xStreamBufferBytesAvailable( ( StreamBufferHandle_t )pxSpeaker->xSpeakerBuffer );
+        xBytesRemained = xAIASpeakerBufferBytesAvailable( &pxSpeaker->xSpeakerBuffer );
 
         pucMsg = ucDecodeTaskTemp + sizeof( ulSeq );
         xMsgLen -= sizeof( ulSeq );
@@ -1739,42 +4357,68 @@ static void prvAIASpeakerTask( void * pvParameters )
                     {
                         prvClientClearState( AIA_STATE_OPENSPEAKER_RECEIVED );
                         pxSpeaker->ullOpenOffset = ullOffset;
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+                        prvClientPlayoutPrebuffer();
+#endif
                         prvClientOpenSpeaker( pxSpeaker->ullOpenOffset );
                     }
 
                     pucMsg += sizeof( ullOffset );
                     configPRINTF_DEBUG( ( "DEBUG: Playing seq %u\r\n", ulSeq ) );
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 ) || ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+                    if( pxSpeaker->ullOutputOffset >= pxSpeaker->ullOpenOffset && ullOffset > pxSpeaker->ullOutputOffset )
+                    {
+                        prvClientConcealGap( ullOffset - pxSpeaker->ullOutputOffset, pucMsg, sDecodeTemp );
+                    }
+#endif
 
                     for( int i = 0; i < ulCount; i++ )
                     {
-                        int ret = opus_decode( pxSpeaker->xDecoder,
+                        int16_t *psFrame = sDecodeTemp;
+                        int ret = AIA_SPEAKER_RAW_FRAME_SAMPLES;
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+                        if( ulConcealedAhead > 0 )
+                        {
+                            /* The frame has been played concealed while it was late. */
+                            ulConcealedAhead--;
+#ifdef DEBUG
+                            ulDroppedLateFrames++;
+#endif
+                            pucMsg += AIA_SPEAKER_DECODER_FRAME_SIZE;
+                            continue;
+                        }
+                        ulLateFrames = 0;
+#endif
+#if ( aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES > 0 )
+                        psFrame = prvClientDecodeAheadTake( ullOffset + i * AIA_SPEAKER_DECODER_FRAME_SIZE );
+                        if( psFrame == NULL )
+#endif
+                        {
+                            psFrame = sDecodeTemp;
+                            OPUS_LOCK();
+                            ret = opus_decode( pxSpeaker->xDecoder,
                                                pucMsg,
                                                AIA_SPEAKER_DECODER_FRAME_SIZE,
                                                sDecodeTemp,
                                                AIA_SPEAKER_MAX_FRAME_SAMPLES,
                                                0 );
+                            OPUS_UNLOCK();
+                            configASSERT( xAIAOpusScratchIsIntact() == pdTRUE );
+#if ( aiaconfigCLIENT_SPEAKER_PLC == 1 )
+                            if( bFadeInPending == true && ret == AIA_SPEAKER_RAW_FRAME_SAMPLES )
+                            {
+                                prvClientFadeIn( sDecodeTemp );
+                            }
+                            bFadeInPending = false;
+#endif
+                        }
                         if( ret != AIA_SPEAKER_RAW_FRAME_SAMPLES )
                         {
                             configPRINTF( ( "opus_decode error %d\r\n", ret ) );
                         }
                         else
                         {
-                            int16_t *psData = sDecodeTemp;
-                            size_t xBytesSent = 0;
-                            for( int i = 0; i < AIA_SPEAKER_RAW_FRAME_SAMPLES; i++ )
-                            {
-                                *psData = ( *psData * ( int )AIAClient.xSpeaker.ulVolume ) >> 7;
-                                psData++;
-                            }
-
-                            while( xBytesSent < AIA_SPEAKER_RAW_FRAME_SIZE )
-                            {
-                                xBytesSent += xStreamBufferSend( pxSpeaker->xDecodeBuffer,
-                                                                 sDecodeTemp,
-                                                                 sizeof( sDecodeTemp ),
-                                                                 pdMS_TO_TICKS( 40 ) );
-                            }
-
+                            prvClientPlayFrame( psFrame, ullOffset + ( uint64_t )i * AIA_SPEAKER_DECODER_FRAME_SIZE );
                             pucMsg += AIA_SPEAKER_DECODER_FRAME_SIZE;
                         }
                     }
@@ -1789,13 +4433,25 @@ static void prvAIASpeakerTask( void * pvParameters )
             {
                 uint32_t ulMarker = *( uint32_t * )pucMsg;
                 configPRINTF_DEBUG( ( "DEBUG: Marker %u\r\n", ulMarker ) );
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+                prvClientPlayclockMarker( ulMarker );
+#else
                 prvClientSendMarker( ulMarker );
+#endif
 
                 pucMsg += pxBinaryHeader->ulLength;
             }
             xMsgLen -= sizeof( AIABinaryHeader_t ) + pxBinaryHeader->ulLength ;
         }
 
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+        if( bSpeakerCloseDue == true )
+        {
+            /* The audio has been played up to the offset of CloseSpeaker, so the speaker is closed below. */
+            pxSpeaker->ullOutputOffset = pxSpeaker->ullCloseOffset;
+        }
+#endif
+
         if( prvClientGetState( AIA_STATE_SPEAKER_OPENED ) == pdTRUE )
         {
             /* Send UnderrunWarning when available data is less than the threshold and the stream has not reached the end of the speech. */
@@ -1816,6 +4472,12 @@ static void prvAIASpeakerTask( void * pvParameters )
                 /* In case that a CloseSpeaker directive with no offset is received, close the speaker
                  * at the current output offset.
                  */
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+                if( prvClientGetState( AIA_STATE_CLOSESPEAKERNOOFFSET_RECEIVED ) != pdTRUE )
+                {
+                    prvClientPlayclockDrain();
+                }
+#endif
                 prvClientClearState( AIA_STATE_CLOSESPEAKERNOOFFSET_RECEIVED );
                 pxSpeaker->ullCloseOffset = pxSpeaker->ullOutputOffset;
 
@@ -1827,50 +4489,367 @@ static void prvAIASpeakerTask( void * pvParameters )
 
 size_t xClientFillMicrophoneBuffer( void * pvData, size_t xSize, TickType_t xTicksToWait )
 {
-    return xStreamBufferSend( AIAClient.xMicrophone.xMicBuffer,
-                              pvData,
-                              xSize,
-                              xTicksToWait );
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    size_t xBytesSent;
+
+    /* Audio is copied into the capture slots without blocking. */
+    ( void )xTicksToWait;
+
+    taskENTER_CRITICAL();
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+    xBytesSent = xAIAMicInputWriteFromISR( pvData, xSize, &xHigherPriorityTaskWoken );
+#else
+    xBytesSent = xAIACaptureWriteFromISR( pvData, xSize, &xHigherPriorityTaskWoken );
+#endif
+    taskEXIT_CRITICAL();
+
+    if( xHigherPriorityTaskWoken == pdTRUE )
+    {
+        taskYIELD();
+    }
+
+    return xBytesSent;
 }
 
 size_t xClientFillMicrophoneBufferFromISR( void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken )
 {
-    return xStreamBufferSendFromISR( AIAClient.xMicrophone.xMicBuffer,
-                                     pvData,
-                                     xSize,
-                                     pxHigherPriorityTaskWoken );
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+    UBaseType_t uxSavedInterruptStatus;
+    size_t xBytesSent;
+
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    xBytesSent = xAIAMicInputWriteFromISR( pvData, xSize, pxHigherPriorityTaskWoken );
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+    return xBytesSent;
+#else
+    return xAIACaptureWriteFromISR( pvData, xSize, pxHigherPriorityTaskWoken );
+#endif
+}
+
+void vClientSetMicrophoneChunking( uint32_t ulFirstChunkMs, uint32_t ulSmallChunksMs )
+{
+    vAIACaptureSetChunking( ulFirstChunkMs / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS,
+                            ulSmallChunksMs / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS );
+}
+
+void * pvClientMicrophoneFrame( void )
+{
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+    return pvAIAMicInputFrame();
+#else
+    return pvAIACaptureFrame();
+#endif
+}
+
+void * pvClientMicrophoneFrameCapturedFromISR( BaseType_t * pxHigherPriorityTaskWoken )
+{
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+    return pvAIAMicInputFrameDoneFromISR( pxHigherPriorityTaskWoken );
+#else
+    return pvAIACaptureFrameDoneFromISR( pxHigherPriorityTaskWoken );
+#endif
+}
+
+#ifdef DEBUG
+static void prvClientCheckFirstSound( const void * pvData, size_t xRead )
+{
+    const int16_t * psSample = ( const int16_t * )pvData;
+
+    if( bFirstSoundPending != true )
+    {
+        return;
+    }
+
+    for( size_t i = 0; i < xRead / sizeof( int16_t ); i++ )
+    {
+        if( psSample[ i ] != 0 )
+        {
+            ulOpenToSoundUs = ( uint32_t )( ( uint64_t )( ulPlatformGetCycleCount() - ulCyclesAtOpenSpeaker ) * 1000000UL /
+                                            configCPU_CLOCK_HZ );
+            ulOpenToSoundUsTotal += ulOpenToSoundUs;
+            ulOpenToSoundCount++;
+            if( ulOpenToSoundUs > ulOpenToSoundUsMax )
+            {
+                ulOpenToSoundUsMax = ulOpenToSoundUs;
+            }
+            bFirstSoundPending = false;
+            break;
+        }
+    }
 }
+#endif
 
 size_t xClientReadSpeakerBuffer( void * pvData, size_t xSize, TickType_t xTicksToWait )
 {
-    return xStreamBufferReceive( AIAClient.xSpeaker.xDecodeBuffer,
-                                 pvData,
-                                 xSize,
-                                 xTicksToWait );
+    size_t xRead = xStreamBufferReceive( AIAClient.xSpeaker.xDecodeBuffer,
+                                         pvData,
+                                         xSize,
+                                         xTicksToWait );
+
+#if ( aiaconfigCLIENT_AEC == 1 )
+    vAIAAecPlayed( pvData, xRead, xSize );
+#endif
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    {
+        BaseType_t xDue;
+
+        taskENTER_CRITICAL();
+        xDue = xAIAPlayclockPlayedFromISR( &xPlayclock, ( uint32_t )xRead );
+        taskEXIT_CRITICAL();
+        if( xDue == pdTRUE )
+        {
+            ( void )xTimerPendFunctionCall( prvClientPlayclockDue, NULL, 0, 0 );
+        }
+    }
+#endif
+#ifdef DEBUG
+    prvClientCheckFirstSound( pvData, xRead );
+#endif
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    if( bSpeakerStartupPending == true && xRead != 0 )
+    {
+        uint32_t ulStartupUs = ( uint32_t )( ( uint64_t )( ulPlatformGetCycleCount() - ulSpeakerStartupCycles ) * 1000000UL /
+                                             configCPU_CLOCK_HZ );
+
+        bSpeakerStartupPending = false;
+        taskENTER_CRITICAL();
+        vAIAWarmupRecordStartup( &xWarmup, eAIAWarmupSpeaker, xSpeakerStartupWarm, ulStartupUs );
+        taskEXIT_CRITICAL();
+    }
+#endif
+
+    return xRead;
 }
 
 size_t xClientReadSpeakerBufferFromISR( void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken )
 {
-    return xStreamBufferReceiveFromISR( AIAClient.xSpeaker.xDecodeBuffer,
-                                        pvData,
-                                        xSize,
-                                        pxHigherPriorityTaskWoken );
+    size_t xRead = xStreamBufferReceiveFromISR( AIAClient.xSpeaker.xDecodeBuffer,
+                                                pvData,
+                                                xSize,
+                                                pxHigherPriorityTaskWoken );
+
+#if ( aiaconfigCLIENT_AEC == 1 )
+    vAIAAecPlayedFromISR( pvData, xRead, xSize );
+#endif
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    if( xAIAPlayclockPlayedFromISR( &xPlayclock, ( uint32_t )xRead ) == pdTRUE )
+    {
+        ( void )xTimerPendFunctionCallFromISR( prvClientPlayclockDue, NULL, 0, pxHigherPriorityTaskWoken );
+    }
+#endif
+#ifdef DEBUG
+    prvClientCheckFirstSound( pvData, xRead );
+#endif
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    if( bSpeakerStartupPending == true && xRead != 0 )
+    {
+        UBaseType_t uxSavedInterruptStatus;
+        uint32_t ulStartupUs = ( uint32_t )( ( uint64_t )( ulPlatformGetCycleCount() - ulSpeakerStartupCycles ) * 1000000UL /
+                                             configCPU_CLOCK_HZ );
+
+        bSpeakerStartupPending = false;
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        vAIAWarmupRecordStartup( &xWarmup, eAIAWarmupSpeaker, xSpeakerStartupWarm, ulStartupUs );
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+    }
+#endif
+
+    return xRead;
+}
+
+BaseType_t xClientStartWakeword( const AIAWakewordEngine_t * pxEngine )
+{
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+    BaseType_t xStarted;
+
+    if( pxEngine == NULL || pxEngine->xProcess == NULL || pxEngine->pcWakeWord == NULL )
+    {
+        return pdFAIL;
+    }
+
+    vAIAWakewordSetEngine( pxEngine );
+    bResetWakeword = true;
+    prvClientSetState( AIA_STATE_MICROPHONE_LISTENING );
+
+    /* An utterance under way carries on, and listening starts once it is closed. An utterance opened from here on
+     * finds the platform microphone running, and one closed from here on leaves it running. */
+    taskENTER_CRITICAL();
+    xStarted = ( bWakewordListening == false && bWakewordUtterance == false ) ? pdTRUE : pdFALSE;
+    bWakewordListening = true;
+    if( xStarted == pdTRUE )
+    {
+        vAIACaptureSetListening( pdTRUE );
+        vAIACaptureRestart();
+    }
+    taskEXIT_CRITICAL();
+    if( xStarted == pdTRUE )
+    {
+        vPlatformMicrophoneOpen();
+    }
+    configPRINTF( ( "Listening for the wake word \"%s\"\r\n", pxEngine->pcWakeWord ) );
+
+    return pdPASS;
+#else
+    ( void )pxEngine;
+    configPRINTF( ( "Build with aiaconfigCLIENT_WAKEWORD set to 1 to use a wake word!\r\n" ) );
+
+    return pdFAIL;
+#endif
+}
+
+void vClientSetEndpointer( BaseType_t xEnabled )
+{
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+    xEndpointerEnabled = xEnabled;
+#else
+    ( void )xEnabled;
+    configPRINTF( ( "Build with aiaconfigCLIENT_ENDPOINTER set to 1 to detect the end of speech!\r\n" ) );
+#endif
+}
+
+BaseType_t xClientSetFrontendStage( AIAFrontendStage_t xStage, BaseType_t xEnabled )
+{
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+    return xAIAFrontendSetStage( xStage, xEnabled );
+#else
+    ( void )xStage;
+    ( void )xEnabled;
+    configPRINTF( ( "Build with aiaconfigCLIENT_FRONTEND set to 1 to run the microphone front-end!\r\n" ) );
+
+    return pdFAIL;
+#endif
 }
 
 void vClientButtonTapped( void )
 {
+    uint32_t ulCyclesAtTap = ulPlatformGetCycleCount();
+
+#ifdef DEBUG
+    /* Measure from the touch-down if the platform reported it. */
+    taskENTER_CRITICAL();
+    if( bButtonPressPending == true )
+    {
+        bButtonPressPending = false;
+        ulCyclesAtTap = ulCyclesAtButtonPress;
+    }
+    taskEXIT_CRITICAL();
+#endif
+
     AIAClient.pcInitiatorType = "TAP";
-    prvClientOpenMicrophone();
+    prvClientOpenMicrophone( ulCyclesAtTap );
     vPlatformTouchButtonDisable();
 }
 
 void vClientButtonTappedFromISR( BaseType_t * pxHigherPriorityTaskWoken )
 {
+    uint32_t ulCyclesAtTap = ulPlatformGetCycleCount();
+
+#ifdef DEBUG
+    UBaseType_t uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+
+    if( bButtonPressPending == true )
+    {
+        bButtonPressPending = false;
+        ulCyclesAtTap = ulCyclesAtButtonPress;
+    }
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+#endif
+
     AIAClient.pcInitiatorType = "TAP";
-    prvClientOpenMicrophoneFromISR( pxHigherPriorityTaskWoken );
+    prvClientOpenMicrophoneFromISR( ulCyclesAtTap, pxHigherPriorityTaskWoken );
     vPlatformTouchButtonDisable();
 }
 
+void vClientButtonPressed( uint32_t ulTouchDownCycles )
+{
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    TickType_t xNow = xTaskGetTickCount();
+    BaseType_t xOpened = prvClientGetState( AIA_STATE_MICROPHONE_OPENED );
+    BaseType_t xDoubleTap = pdFALSE;
+    BaseType_t xOpen = pdFALSE;
+
+    taskENTER_CRITICAL();
+    if( xGesture == eAIAGestureReleased &&
+        xNow - xTickAtTouchUp < pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_DOUBLE_TAP_MS ) )
+    {
+        /* The utterance of the first tap has not been announced yet, see prvClientWaitForGesture(). */
+        bSendMicrophoneOpenedEvent = false;
+        xGesture = eAIAGestureIdle;
+        xDoubleTap = pdTRUE;
+    }
+    else if( xGesture == eAIAGestureIdle && xOpened != pdTRUE )
+    {
+        xGesture = eAIAGesturePressed;
+        xTickAtTouchDown = xNow;
+        xOpen = pdTRUE;
+    }
+    taskEXIT_CRITICAL();
+
+    if( xDoubleTap == pdTRUE )
+    {
+        configPRINTF( ( "Double tap, stopping playback.\r\n" ) );
+        prvClientCloseMicrophone();
+        vPlatformLEDOff();
+        prvClientSendEvent( aiaEventStopPlaying, NULL );
+    }
+    else if( xOpen == pdTRUE )
+    {
+        /* Nothing is sent until the gesture is known, so have the capture fill whole slots meanwhile. */
+        vAIACaptureSetCongested( pdTRUE );
+        AIAClient.pcInitiatorType = "TAP";
+        prvClientOpenMicrophone( ulTouchDownCycles );
+#ifdef DEBUG
+        ulCyclesAtTouchDown = ulTouchDownCycles;
+        bTouchLatencyPending = true;
+#endif
+    }
+
+    if( xMicrophoneTaskHandle != NULL )
+    {
+        xTaskNotifyGive( xMicrophoneTaskHandle );
+    }
+#elif defined( DEBUG )
+    /* The tap of the release is measured from here. */
+    taskENTER_CRITICAL();
+    ulCyclesAtButtonPress = ulTouchDownCycles;
+    bButtonPressPending = true;
+    taskEXIT_CRITICAL();
+#else
+    ( void )ulTouchDownCycles;
+#endif
+}
+
+void vClientButtonReleased( void )
+{
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    TickType_t xNow = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if( xGesture == eAIAGesturePressed &&
+        xNow - xTickAtTouchDown < pdMS_TO_TICKS( aiaconfigCLIENT_TOUCH_LONG_PRESS_MS ) )
+    {
+        xGesture = eAIAGestureReleased;
+        xTickAtTouchUp = xNow;
+    }
+    else if( xGesture == eAIAGesturePressed || xGesture == eAIAGestureHeld )
+    {
+        /* The microphone task may not have seen the long press yet. */
+        AIAClient.pcInitiatorType = "HOLD";
+        xGesture = eAIAGestureHoldReleased;
+        ulFrameAtTouchUp = ulAIACaptureFrameCount();
+    }
+    taskEXIT_CRITICAL();
+
+    if( xMicrophoneTaskHandle != NULL )
+    {
+        xTaskNotifyGive( xMicrophoneTaskHandle );
+    }
+#else
+    vClientButtonTapped();
+#endif
+}
+
 /* Helper macro if the initialization failed. */
 #define CLIENT_INIT_GOTO_FAIL( expr, str )            \
         { if( ( expr ) == true ) {                    \
@@ -1881,6 +4860,10 @@ BaseType_t xClientInit( IotMqttConnection_t xMqttConnection )
 {
     BaseType_t xReturned;
     int err;
+    int xDecoderSize;
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    int xEncoderSize;
+#endif
 
     AIAClient.xInitialized = pdFALSE;
 
@@ -1896,7 +4879,7 @@ BaseType_t xClientInit( IotMqttConnection_t xMqttConnection )
 
     AIAClient.xMqttConnection = xMqttConnection;
     AIAClient.xDeviceAlerts.xIsSupported = pdFALSE;
-    AIAClient.pcASRProfile = "NEAR_FIELD";
+    AIAClient.pcASRProfile = aiaconfigCLIENT_ASR_PROFILE;
     AIAClient.pcInitiatorType = "TAP";
     AIAClient.pcMicrophoneToken = NULL;
 
@@ -1909,10 +4892,45 @@ BaseType_t xClientInit( IotMqttConnection_t xMqttConnection )
     AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning = aiaconfigCLIENT_SPEAKER_BUFFER_OVERRUN_WARNING;
     AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning = aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING;
 
-    AIAClient.xSpeaker.xDecoder = opus_decoder_create( AIAClient.xSpeaker.ulSampleRate,
-                                                       AIAClient.xSpeaker.ucChannels,
-                                                       &err );
-    CLIENT_INIT_GOTO_FAIL( err != OPUS_OK, "Failed to create decoder!\r\n" );
+    xDecoderSize = opus_decoder_get_size( AIAClient.xSpeaker.ucChannels );
+    CLIENT_INIT_GOTO_FAIL( xDecoderSize <= 0 || xDecoderSize > sizeof( ucDecoderState ), "Decoder state does not fit in its arena!\r\n" );
+    configPRINTF_DEBUG( ( "DEBUG: Opus decoder state uses %d of %u bytes\r\n", xDecoderSize, ( uint32_t )sizeof( ucDecoderState ) ) );
+
+    vAIAOpusScratchInit();
+    AIAClient.xSpeaker.xDecoder = ( OpusDecoder * )ucDecoderState;
+    err = opus_decoder_init( AIAClient.xSpeaker.xDecoder,
+                             AIAClient.xSpeaker.ulSampleRate,
+                             AIAClient.xSpeaker.ucChannels );
+    CLIENT_INIT_GOTO_FAIL( err != OPUS_OK, "Failed to initialize decoder!\r\n" );
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    xEncoderSize = opus_encoder_get_size( aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS );
+    CLIENT_INIT_GOTO_FAIL( xEncoderSize <= 0 || xEncoderSize > sizeof( ucEncoderState ), "Encoder state does not fit in its arena!\r\n" );
+
+    /* Fixed-point SILK at wideband with a low complexity and a constant bitrate, so that every 20ms frame has the
+     * same size and the cost per frame stays predictable on Cortex-M.
+     */
+    AIAClient.xMicrophone.xEncoder = ( OpusEncoder * )ucEncoderState;
+    err = opus_encoder_init( AIAClient.xMicrophone.xEncoder,
+                             aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE,
+                             aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS,
+                             OPUS_APPLICATION_VOIP );
+    CLIENT_INIT_GOTO_FAIL( err != OPUS_OK, "Failed to initialize encoder!\r\n" );
+
+    opus_encoder_ctl( AIAClient.xMicrophone.xEncoder, OPUS_SET_BITRATE( aiaconfigCLIENT_MICROPHONE_ENCODER_BITRATE ) );
+    opus_encoder_ctl( AIAClient.xMicrophone.xEncoder, OPUS_SET_VBR( 0 ) );
+    opus_encoder_ctl( AIAClient.xMicrophone.xEncoder, OPUS_SET_COMPLEXITY( aiaconfigCLIENT_MICROPHONE_ENCODER_COMPLEXITY ) );
+    opus_encoder_ctl( AIAClient.xMicrophone.xEncoder, OPUS_SET_SIGNAL( OPUS_SIGNAL_VOICE ) );
+    opus_encoder_ctl( AIAClient.xMicrophone.xEncoder, OPUS_SET_BANDWIDTH( OPUS_BANDWIDTH_WIDEBAND ) );
+
+    xOpusLock = xSemaphoreCreateMutex();
+    CLIENT_INIT_GOTO_FAIL( xOpusLock == NULL, "Failed to create the Opus lock!\r\n" );
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_GAP_SILENCE == 1 )
+    xReturned = prvClientInitMicrophoneSilence( &AIAClient.xMicrophone );
+    CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to prepare the microphone silence!\r\n" );
+#endif
 
     /* Intialize the context of AES-GCM */
     AIACryptoErrorCode_t cryptoCode = xAIACryptoInit( &AIAClient.xCrypto, &xKeys );
@@ -1921,11 +4939,67 @@ BaseType_t xClientInit( IotMqttConnection_t xMqttConnection )
     AIAClient.xState = xEventGroupCreate();
     CLIENT_INIT_GOTO_FAIL( AIAClient.xState == NULL, "Failed to create xState!\r\n" );
 
-    AIAClient.xMicrophone.xMicBuffer = xStreamBufferCreate( AIA_MICROPHONE_RAW_BUFFER_TOTAL_SIZE, 0 );
-    CLIENT_INIT_GOTO_FAIL( AIAClient.xMicrophone.xMicBuffer == NULL, "Failed to create xMicBuffer!\r\n" );
-
-    AIAClient.xSpeaker.xSpeakerBuffer = xMessageBufferCreate( AIAClient.xSpeaker.ulSpeakerBufferSize );
-    CLIENT_INIT_GOTO_FAIL( AIAClient.xSpeaker.xSpeakerBuffer == NULL, "Failed to create xSpeakerBuffer!\r\n" );
+    xReturned = xAIAEventPoolInit();
+    CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to initialize the event buffers!\r\n" );
+
+    xEventPublished = xSemaphoreCreateBinary();
+    CLIENT_INIT_GOTO_FAIL( xEventPublished == NULL, "Failed to create xEventPublished!\r\n" );
+
+    xReturned = xAIACaptureInit();
+    CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to initialize microphone capture!\r\n" );
+    vClientSetMicrophoneChunking( aiaconfigAIA_AUDIO_FIRST_CHUNK_MS, aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS );
+
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+    vAIAMicInputInit();
+#endif
+
+#if ( aiaconfigCLIENT_ENDPOINTER == 1 )
+    vAIAVadInit( &xVad, aiaconfigCLIENT_ENDPOINTER_THRESHOLD_DB,
+                 aiaconfigCLIENT_ENDPOINTER_ONSET_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS,
+                 aiaconfigCLIENT_ENDPOINTER_HANGOVER_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS );
+#endif
+
+#if ( aiaconfigCLIENT_AEC == 1 )
+    vAIAAecInit();
+    vAIACaptureSetFrameHook( vAIAAecFrameCapturedFromISR );
+#endif
+
+#if ( aiaconfigCLIENT_WARMUP == 1 )
+    vAIAWarmupInit( &xWarmup, pdMS_TO_TICKS( aiaconfigCLIENT_WARMUP_SPEAKER_MS ), pdMS_TO_TICKS( aiaconfigCLIENT_WARMUP_MICROPHONE_MS ) );
+    xWarmupTimer = xTimerCreate( "AIA_Warmup", 1, pdFALSE, NULL, prvClientWarmupTimer );
+    CLIENT_INIT_GOTO_FAIL( xWarmupTimer == NULL, "Failed to create the warm-up timer!\r\n" );
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_GAP_RECOVERY == 1 )
+    xGapTimer = xTimerCreate( "AIA_Gap", 1, pdFALSE, NULL, prvClientSpeakerGapTimer );
+    CLIENT_INIT_GOTO_FAIL( xGapTimer == NULL, "Failed to create the speaker gap timer!\r\n" );
+#endif
+
+#if ( aiaconfigCLIENT_SPEAKER_PLAY_CLOCK == 1 )
+    vAIAPlayclockInit( &xPlayclock, AIA_SPEAKER_RAW_FRAME_SIZE, AIA_SPEAKER_DECODER_FRAME_SIZE );
+#endif
+
+#if ( aiaconfigCLIENT_OFFSET_ACTIONS == 1 )
+    vAIAOffsetSchedInit( &xOffsetActions, xOffsetActionStorage, aiaconfigCLIENT_OFFSET_ACTIONS_MAX );
+#endif
+
+#if ( aiaconfigCLIENT_ADAPTIVE_PLAYOUT == 1 )
+    xCapabilitiesTimer = xTimerCreate( "AIA_Capabilities", aiaconfigAIA_DEFAULT_TIMEOUT, pdFALSE, NULL, prvClientCapabilitiesTimer );
+    CLIENT_INIT_GOTO_FAIL( xCapabilitiesTimer == NULL, "Failed to create the capabilities timer!\r\n" );
+    vAIAPlayoutInit( &xPlayout,
+                     AIAClient.xSpeaker.ulDecoderBitrate / 8,
+                     AIAClient.xSpeaker.ulSpeakerBufferSize,
+                     AIAClient.xSpeaker.ulSpeakerBufferOverrunWarning,
+                     AIAClient.xSpeaker.ulSpeakerBufferUnderrunWarning,
+                     aiaconfigCLIENT_PLAYOUT_MAX_PREBUFFER_MS );
+#endif
+
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+    vAIAFrontendInit();
+#endif
+
+    xReturned = xAIASpeakerBufferInit( &AIAClient.xSpeaker.xSpeakerBuffer, AIAClient.xSpeaker.ulSpeakerBufferSize );
+    CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to create xSpeakerBuffer!\r\n" );
 
     AIAClient.xSpeaker.xDecodeBuffer = xStreamBufferCreate( AIA_DECODER_BUFFER_TOTAL_SIZE, 0 );
     CLIENT_INIT_GOTO_FAIL( AIAClient.xSpeaker.xDecodeBuffer == NULL, "Failed to create xDecodeBuffer!\r\n" );
@@ -1933,6 +5007,10 @@ BaseType_t xClientInit( IotMqttConnection_t xMqttConnection )
     xReturned = xAIABufferListInitialize( &AIAClient.xDirectiveBufferList);
     CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to initialize xDirectiveBufferList!\r\n" );
 
+    xReturned = xAIAOutboundInit( prvClientPublishOutbound );
+    CLIENT_INIT_GOTO_FAIL( xReturned != pdPASS, "Failed to initialize the outbound task!\r\n" );
+    vAIAOutboundSetBackpressureCallback( prvClientMicrophoneBackpressure );
+
     xReturned = xTaskCreate( prvAIAStreamMicrophoneTask,
                              "AIA_StreamMic",
                              aiaconfigAIA_STREAM_MICROPHONE_TASK_STACK_SIZE,
@@ -1981,6 +5059,7 @@ void vClientCleanup( void )
     {
         vTaskDelete( xSpeakerTaskHandle );
     }
+    vAIAOutboundCleanup();
 
     vPlatformLEDOff();
 
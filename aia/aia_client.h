@@ -39,6 +39,10 @@ typedef struct __attribute__ ((__packed__)){
     uint8_t ciphertext[ 0 ];
 } AIAMessage_t;
 
+/* Length of an encrypted AIA message, of which the ciphertext covers the sequence number and the plaintext. */
+#define AIA_MSG_ENCRYPTED_LENGTH( ulPlaintextLength )   \
+        ( sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + ( ulPlaintextLength ) )
+
 /* The handle of the demo task if any so that it could be signaled by the AIA client. */
 extern TaskHandle_t xDemoTaskHandle;
 
@@ -73,13 +77,13 @@ BaseType_t xClientAIAInit( void );
 /**
  * @brief Fill the client microphone buffer.
  *
- * This function sends data to the client microphone buffer. The bytes are copied into the buffer. A timeout can
- * be specified for how long the function can wait.
+ * This function sends data to the client microphone buffer. The bytes are copied into the buffer. Platforms whose
+ * DMA can write to the client memory should use pvClientMicrophoneFrame() instead, which avoids the copy.
  * This function CANNOT be called from an ISR context. Use the interrupt-safe version instead.
  *
  * @param[in] pvData                            A pointer to the data to be sent.
  * @param[in] xSize                             The total bytes of data to be sent.
- * @param[in] xTicksToWait                      Timeout value for how long this function can wait.
+ * @param[in] xTicksToWait                      Not used. Data that does not fit in the buffer is dropped.
  *
  * @return                                      Number of bytes actually being sent.
  *
@@ -105,6 +109,52 @@ size_t xClientFillMicrophoneBuffer( void * pvData, size_t xSize, TickType_t xTic
  */
 size_t xClientFillMicrophoneBufferFromISR( void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken );
 
+/**
+ * @brief Set how the start of an utterance is chunked into microphone messages.
+ *
+ * Small messages get the start of an utterance to AIA sooner, at the cost of more overhead per byte of audio. The
+ * first ulSmallChunksMs of each utterance are sent in messages of ulFirstChunkMs. Messages then double in size up
+ * to aiaconfigAIA_AUDIO_DATA_SIZE. Durations are rounded down to whole 20ms frames. The change applies from the
+ * next microphone message.
+ *
+ * @param[in] ulFirstChunkMs                    The duration of audio in each of the first messages.
+ * @param[in] ulSmallChunksMs                   The duration of audio sent in such small messages.
+ */
+void vClientSetMicrophoneChunking( uint32_t ulFirstChunkMs, uint32_t ulSmallChunksMs );
+
+/**
+ * @brief Get where the platform microphone should write the next frame of audio.
+ *
+ * For zero-copy capture, the platform DMA writes audio straight into the client microphone messages, one frame of
+ * 20ms at a time. The platform calls this function when it opens the microphone to set the destination of the
+ * first frame, and pvClientMicrophoneFrameCapturedFromISR() when a frame has been written to get the next one.
+ * This function should be called while the microphone DMA is stopped.
+ * If the microphone captures another format than the raw one, i.e. several channels (interleaved), a higher rate or
+ * more bits per sample, the frame is in the captured format and is converted into the microphone messages when it is
+ * complete. The address is then never NULL. The audio given to xClientFillMicrophoneBuffer() is in the captured
+ * format likewise.
+ *
+ * @return                                      The address of the frame, or NULL if the client has no room for it.
+ *                                              In that case the platform should capture the frame to a scratch
+ *                                              buffer of its own, and the frame is dropped.
+ */
+void * pvClientMicrophoneFrame( void );
+
+/**
+ * @brief Tell the client that a frame of audio has been written from interrupt.
+ *
+ * The frame is the one at the address last returned by pvClientMicrophoneFrame() or by this function.
+ *
+ * @param[out] pxHigherPriorityTaskWoken        The function sets *pxHigherPriorityTaskWoken to pdTRUE if a context
+ *                                              switch should be performed before the interrupt is exited, that is
+ *                                              when a higher priority task is woken up by this function.
+ *                                              *pxHigherPriorityTaskWoken should be set to pdFALSE before it is
+ *                                              passed into the function.
+ *
+ * @return                                      The address of the next frame, or NULL as for pvClientMicrophoneFrame().
+ */
+void * pvClientMicrophoneFrameCapturedFromISR( BaseType_t * pxHigherPriorityTaskWoken );
+
 /**
  * @brief Receive data from the client speaker buffer.
  *
@@ -140,6 +190,70 @@ size_t xClientReadSpeakerBuffer( void * pvData, size_t xSize, TickType_t xTicksT
  */
 size_t xClientReadSpeakerBufferFromISR( void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken );
 
+/* A keyword spotter run on the microphone audio between utterances. See xClientStartWakeword(). */
+typedef struct {
+    /* The wake word reported to AIA, e.g. "ALEXA". */
+    const char * pcWakeWord;
+
+    /* Forget any audio seen so far. Called before listening starts and again after each utterance. */
+    void ( * vReset )( void );
+
+    /* Process one 20ms frame of raw microphone audio. Returns pdTRUE if the wake word ends in this frame, and then
+     * sets *pulWakeWordFrames to the number of frames the wake word spans, this one included.
+     */
+    BaseType_t ( * xProcess )( const int16_t * psFrame, uint32_t * pulWakeWordFrames );
+} AIAWakewordEngine_t;
+
+/**
+ * @brief Keep the microphone open between utterances and open an utterance when the wake word is detected.
+ *
+ * The platform microphone is opened once and then captures continuously. Between utterances every frame is given
+ * to the spotter and kept in a pre-roll of aiaconfigCLIENT_WAKEWORD_PREROLL_MS. On detection, the utterance is
+ * opened with a WAKEWORD initiator and starts with the pre-roll, followed by the live audio without a gap. Taps and
+ * OpenMicrophone directives still work as before. Requires aiaconfigCLIENT_WAKEWORD to be 1.
+ *
+ * @param[in] pxEngine                          The spotter, which must stay valid from then on.
+ *
+ * @return                                      pdPASS on success and pdFAIL on failure.
+ */
+BaseType_t xClientStartWakeword( const AIAWakewordEngine_t * pxEngine );
+
+/**
+ * @brief Enable or disable closing the microphone on the end of speech detected by the device.
+ *
+ * When enabled, the microphone is closed and MicrophoneClosed is sent once aiaconfigCLIENT_ENDPOINTER_HANGOVER_MS of
+ * silence follows speech, instead of streaming until AIA sends CloseMicrophone. It is enabled by default when
+ * aiaconfigCLIENT_ENDPOINTER is 1. When disabled, the detector still runs, so that DEBUG builds can report what it
+ * would have saved.
+ *
+ * @param[in] xEnabled                          pdTRUE to close the microphone on the end of speech, pdFALSE to leave it
+ *                                              to AIA.
+ */
+void vClientSetEndpointer( BaseType_t xEnabled );
+
+/* The stages of the microphone front-end, in the order they run. See vClientSetFrontendStage(). */
+typedef enum
+{
+    eAIAFrontendDcRemoval = 0,
+    eAIAFrontendHighPass,
+    eAIAFrontendNoiseSuppression,
+    eAIAFrontendAgc,
+    eAIAFrontendStageNum,
+} AIAFrontendStage_t;
+
+/**
+ * @brief Enable or disable a stage of the microphone front-end.
+ *
+ * The front-end runs on every captured frame before the wake word spotter, the endpointer and the encoder. The stages
+ * built in with their aiaconfigCLIENT_FRONTEND_* options start enabled. Requires aiaconfigCLIENT_FRONTEND to be 1.
+ *
+ * @param[in] xStage                            The stage.
+ * @param[in] xEnabled                          pdTRUE to run the stage, pdFALSE to skip it.
+ *
+ * @return                                      pdPASS on success, and pdFAIL if the stage is not built in.
+ */
+BaseType_t xClientSetFrontendStage( AIAFrontendStage_t xStage, BaseType_t xEnabled );
+
 /**
  * @brief The function that should be called when the touch button is tapped.
  *
@@ -157,4 +271,28 @@ void vClientButtonTapped( void );
  */
 void vClientButtonTappedFromISR( BaseType_t * pxHigherPriorityTaskWoken );
 
+/**
+ * @brief The function that should be called when the touch button is pressed.
+ *
+ * With aiaconfigCLIENT_TOUCH_GESTURES set to 1, this opens the microphone right away, and the gesture decides how the
+ * utterance is announced: a tap as TAP, a long press as HOLD until vClientButtonReleased(), and a second tap soon
+ * after a tap stops playback instead. Otherwise this does nothing.
+ * This function CANNOT be called from an ISR context. Wake up a task from the touch interrupt instead.
+ *
+ * @param[in] ulTouchDownCycles                 ulPlatformGetCycleCount() at the scan that first saw the touch, before
+ *                                              it was debounced. DEBUG builds report the latency from it to the first
+ *                                              captured sample.
+ */
+void vClientButtonPressed( uint32_t ulTouchDownCycles );
+
+/**
+ * @brief The function that should be called when the touch button is released.
+ *
+ * Call it for every press reported with vClientButtonPressed(), even while the touch button is disabled. Without
+ * aiaconfigCLIENT_TOUCH_GESTURES, this is vClientButtonTapped().
+ * This function CANNOT be called from an ISR context.
+ *
+ */
+void vClientButtonReleased( void );
+
 #endif /* _AIA_CLIENT_H_ */
@@ -25,15 +25,32 @@
 
 #include "aia_audio_defs.h"
 
+/* Set to 1 to build the client for parts with a 128 KB heap. See "Low-memory profile" in README.md.
+ * The capabilities advertised to AIA follow the buffer sizes selected here.
+ */
+#ifndef aiaconfigLOW_MEMORY_PROFILE
+#define aiaconfigLOW_MEMORY_PROFILE                         ( 0 )
+#endif
+
+#ifndef aiaconfigAWS_ACCOUNT_ID
 #define aiaconfigAWS_ACCOUNT_ID                             ""
+#endif
 
+#ifndef aiaconfigTOPIC_ROOT
 #define aiaconfigTOPIC_ROOT                                 ""
+#endif
 
+#ifndef aiaconfigCLIENT_PUBLIC_KEY
 #define aiaconfigCLIENT_PUBLIC_KEY                          ""
+#endif
 
+#ifndef aiaconfigCLIENT_PRIVATE_KEY
 #define aiaconfigCLIENT_PRIVATE_KEY                         ""
+#endif
 
+#ifndef aiaconfigPEER_PUBLIC_KEY
 #define aiaconfigPEER_PUBLIC_KEY                            ""
+#endif
 
 #define aiaconfigAPI_VERSION                                "v1"
 
@@ -41,12 +58,57 @@
 
 #define aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS             AUDIO_CHANNEL_MONO
 
+/* Microphones captured by the platform, interleaved. With more than one, a beamformer turns them into the mono stream
+ * sent to AIA, and the FAR_FIELD ASR profile is advertised. See "Microphone array" in README.md.
+ */
+#ifndef aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS
+#define aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS           ( 1UL )
+#endif
+
+/* Delay of each microphone in samples, which steers the beam. All zeros points it broadside to the array. */
+#ifndef aiaconfigCLIENT_MICROPHONE_ARRAY_DELAYS
+#define aiaconfigCLIENT_MICROPHONE_ARRAY_DELAYS             { 0 }
+#endif
+
+/* The largest delay above. Delays are in samples at the capture rate, and a sample at 16kHz is 21mm of sound travel. */
+#define aiaconfigCLIENT_MICROPHONE_ARRAY_MAX_DELAY          ( 4UL )
+
+/* The ASR profile advertised to AIA: CLOSE_TALK, NEAR_FIELD or FAR_FIELD. */
+#ifndef aiaconfigCLIENT_ASR_PROFILE
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 )
+#define aiaconfigCLIENT_ASR_PROFILE                         "FAR_FIELD"
+#else
+#define aiaconfigCLIENT_ASR_PROFILE                         "NEAR_FIELD"
+#endif
+#endif
+
 #define aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS    ( 20UL )
 
 /* PDM mic supports 16/24/32bits raw data, sample resolution should be 16 or 32bits */
 #define aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RESOLUTION    ( 16UL )
 
-#define aiaconfigCLIENT_MICROPHONE_RAW_BUFFER_FRAMES        ( 10UL )
+/* Rate and resolution the platform microphone captures at. Audio is converted to the 16kHz 16-bit raw format above
+ * before it is streamed. The rate may be 16, 32 or 48kHz. 24-bit samples are right-justified and sign-extended in
+ * 32 bits. See "Microphone capture formats" in README.md.
+ */
+#ifndef aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE
+#define aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE      aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE
+#endif
+
+#ifndef aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION
+#define aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION    aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RESOLUTION
+#endif
+
+#if ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+
+/* 1.5 seconds of audio at the advertised decoder bitrate. */
+#define aiaconfigCLIENT_SPEAKER_BUFFER_SIZE                 ( 12000UL )
+
+#define aiaconfigCLIENT_SPEAKER_BUFFER_OVERRUN_WARNING      ( 8000UL )
+
+#define aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING     ( 4000UL )
+
+#else
 
 #define aiaconfigCLIENT_SPEAKER_BUFFER_SIZE                 ( 32000UL )
 
@@ -54,8 +116,68 @@
 
 #define aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING     ( 10000UL )
 
+#endif
+
 #define aiaconfigCLIENT_DECODER_BUFFER_FRAMES               ( 1UL )
 
+/* The number of frames of the first /speaker message decoded while waiting for OpenSpeaker, so that playback starts
+ * as soon as it is processed. 0 decodes nothing ahead. See "Speaker decode-ahead" in README.md.
+ */
+#ifndef aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES
+#define aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES         ( 0UL )
+#endif
+
+/* Set to 1 to hold the speaker for a prebuffer measured from how late /speaker messages arrive, and to advertise
+ * warning thresholds that follow it. See "Adaptive playout" in README.md.
+ */
+#ifndef aiaconfigCLIENT_ADAPTIVE_PLAYOUT
+#define aiaconfigCLIENT_ADAPTIVE_PLAYOUT                    ( 0 )
+#endif
+
+/* The longest prebuffer the adaptive playout holds the speaker for. */
+#define aiaconfigCLIENT_PLAYOUT_MAX_PREBUFFER_MS            ( 1000UL )
+
+/* Set to 1 to recover from /speaker messages lost beyond the resequencing range, rather than disconnect from AIA.
+ * See "Speaker gap recovery" in README.md.
+ */
+#ifndef aiaconfigCLIENT_SPEAKER_GAP_RECOVERY
+#define aiaconfigCLIENT_SPEAKER_GAP_RECOVERY                ( 0 )
+#endif
+
+/* How long missing /speaker messages may be late before a resend is asked for, and how long the resend may take. */
+#define aiaconfigCLIENT_SPEAKER_GAP_WAIT_MS                 ( 200UL )
+#define aiaconfigCLIENT_SPEAKER_GAP_RESEND_MS               ( 1000UL )
+
+/* The longest hole in the audio of a stream filled in, so that playback stays in time with the offsets. */
+#define aiaconfigCLIENT_SPEAKER_GAP_CONCEAL_MS              ( 1000UL )
+
+/* Set to 1 to conceal missing and late speaker audio with the packet-loss concealment of the decoder, rather than
+ * play silence. See "Speaker concealment" in README.md.
+ */
+#ifndef aiaconfigCLIENT_SPEAKER_PLC
+#define aiaconfigCLIENT_SPEAKER_PLC                         ( 0 )
+#endif
+
+/* The most frames concealed in a row while the audio is late. The speaker plays silence after that. */
+#define aiaconfigCLIENT_SPEAKER_PLC_MAX_FRAMES              ( 5UL )
+
+/* Set to 1 to send markers and SpeakerClosed as the audio is actually played, from the speaker reads of the
+ * platform. See "Speaker playback clock" in README.md.
+ */
+#ifndef aiaconfigCLIENT_SPEAKER_PLAY_CLOCK
+#define aiaconfigCLIENT_SPEAKER_PLAY_CLOCK                  ( 0 )
+#endif
+
+/* Set to 1 to take SetAttentionState, SetVolume and CloseSpeaker with an offset when the speaker gets to that offset.
+ * See "Offset actions" in README.md.
+ */
+#ifndef aiaconfigCLIENT_OFFSET_ACTIONS
+#define aiaconfigCLIENT_OFFSET_ACTIONS                      ( 0 )
+#endif
+
+/* The most actions waiting for their offset. An action that does not fit is taken at once. */
+#define aiaconfigCLIENT_OFFSET_ACTIONS_MAX                  ( 8UL )
+
 #define aiaconfigCLIENT_SPEAKER_CHANNELS                    AUDIO_CHANNEL_MONO
 
 #define aiaconfigCLIENT_SPEAKER_SAMPLE_RATE                 AUDIO_SAMPLE_RATE_16KHZ
@@ -66,9 +188,167 @@
 
 #define aiaconfigCLIENT_SPEAKER_DECODER_BITRATE             ( 64000UL )
 
+/* Size of the static arena holding the Opus decoder state. It must be no less than opus_decoder_get_size(). */
+#define aiaconfigCLIENT_DECODER_STATE_SIZE                  ( 20UL * 1024UL )
+
+/* Set to 1 to send microphone audio as Opus instead of raw L16 PCM. See "Microphone encoder" in README.md. */
+#ifndef aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS
+#define aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS             ( 0 )
+#endif
+
+/* Constant bitrate of the microphone encoder. 32 kbit/s gives 80 bytes per 20ms frame. */
+#define aiaconfigCLIENT_MICROPHONE_ENCODER_BITRATE          ( 32000UL )
+
+/* Opus complexity from 0 to 10. Low values keep the fixed-point encoder well within a Cortex-M4 budget. */
+#define aiaconfigCLIENT_MICROPHONE_ENCODER_COMPLEXITY       ( 2 )
+
+/* Set to 1 to send silence in place of the microphone audio dropped during an overflow, at the offsets it would
+ * have had, and 0 to leave a gap in the offsets instead. See "Microphone capture" in README.md. The silence is sent
+ * from a buffer of its own, which holds as many frames as a capture slot.
+ */
+#ifndef aiaconfigCLIENT_MICROPHONE_GAP_SILENCE
+#define aiaconfigCLIENT_MICROPHONE_GAP_SILENCE              ( 1 )
+#endif
+
+/* Set to 1 to keep the microphone open between utterances and open one on a wake word. See "Wake word" in README.md. */
+#ifndef aiaconfigCLIENT_WAKEWORD
+#define aiaconfigCLIENT_WAKEWORD                            ( 0 )
+#endif
+
+/* Audio kept before the point the wake word is detected, and sent at the start of the utterance. It should cover the
+ * wake word plus some audio before it. Each 20ms costs 640 bytes of RAM.
+ */
+#define aiaconfigCLIENT_WAKEWORD_PREROLL_MS                 ( 500UL )
+
+/* Set to 1 to detect the end of speech on the device and close the microphone before AIA does. See "End of speech"
+ * in README.md.
+ */
+#ifndef aiaconfigCLIENT_ENDPOINTER
+#define aiaconfigCLIENT_ENDPOINTER                          ( 0 )
+#endif
+
+/* How far above the noise floor a frame must be to count as speech. */
+#define aiaconfigCLIENT_ENDPOINTER_THRESHOLD_DB             ( 12UL )
+
+/* Speech needed before the end of speech is looked for, so that a click does not start the hang-over. */
+#define aiaconfigCLIENT_ENDPOINTER_ONSET_MS                 ( 100UL )
+
+/* Silence after speech that ends the utterance. Shorter values answer sooner but may cut users off mid-sentence. */
+#define aiaconfigCLIENT_ENDPOINTER_HANGOVER_MS              ( 700UL )
+
+/* Set to 1 to cancel the echo of the speaker in the microphone audio, so that users can barge in while the speaker
+ * plays. See "Echo cancellation" in README.md.
+ */
+#ifndef aiaconfigCLIENT_AEC
+#define aiaconfigCLIENT_AEC                                 ( 0 )
+#endif
+
+/* Length of the echo path covered by the filter, 16ms at 16kHz. At least 128, see aia_aec.c. */
+#define aiaconfigCLIENT_AEC_TAPS                            ( 256UL )
+
+/* The filter adapts 1 / aiaconfigCLIENT_AEC_UPDATE_PARTS of its taps per sample, in turn, which takes it several
+ * times longer to converge. Filtering costs about 3 cycles per tap and sample on a Cortex-M4, adapting a tap about 5.
+ * It must divide aiaconfigCLIENT_AEC_TAPS.
+ */
+#ifndef aiaconfigCLIENT_AEC_UPDATE_PARTS
+#define aiaconfigCLIENT_AEC_UPDATE_PARTS                    ( 4UL )
+#endif
+
+/* Samples between the speaker audio being read and its echo reaching the microphone DMA, less a few taps of margin.
+ * This covers the speaker DMA block and FIFO, and depends on the platform.
+ */
+#define aiaconfigCLIENT_AEC_DELAY_SAMPLES                   ( 160UL )
+
+/* NLMS step size in Q15. Larger values converge faster but leave more residual echo. */
+#define aiaconfigCLIENT_AEC_STEP_Q15                        ( 8192 )
+
+/* Speaker audio kept as the reference, in samples. It must be a power of two and cover the microphone audio
+ * waiting in the capture slots plus the delay and the taps.
+ */
+#define aiaconfigCLIENT_AEC_REFERENCE_SAMPLES               ( 4096UL )
+
+/* Set to 1 to run the microphone front-end on every captured frame. See "Microphone front-end" in README.md. */
+#ifndef aiaconfigCLIENT_FRONTEND
+#define aiaconfigCLIENT_FRONTEND                            ( 0 )
+#endif
+
+/* The stages built into the front-end. Each can still be disabled at run time with xClientSetFrontendStage(). */
+#define aiaconfigCLIENT_FRONTEND_DC_REMOVAL                 ( 1 )
+#define aiaconfigCLIENT_FRONTEND_HIGH_PASS                  ( 1 )
+#define aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION          ( 1 )
+#define aiaconfigCLIENT_FRONTEND_AGC                        ( 1 )
+
+/* The most the noise suppression pulls frames at the noise floor down by. */
+#define aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB       ( 12UL )
+
+/* The level the AGC brings speech to, below full scale, and the most it amplifies by. */
+#define aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS            ( 26UL )
+#define aiaconfigCLIENT_FRONTEND_AGC_MAX_GAIN_DB            ( 18UL )
+
+/* Set to 1 to open the microphone as soon as the touch button is pressed, and to tell taps, long presses and double
+ * taps apart. The platform reports presses and releases with vClientButtonPressed() and vClientButtonReleased(). See
+ * "Touch gestures" in README.md.
+ */
+#ifndef aiaconfigCLIENT_TOUCH_GESTURES
+#define aiaconfigCLIENT_TOUCH_GESTURES                      ( 0 )
+#endif
+
+/* A press held this long is a long press. The microphone stays open until the button is released. */
+#define aiaconfigCLIENT_TOUCH_LONG_PRESS_MS                 ( 400UL )
+
+/* A second tap within this time of a release is a double tap, which stops playback instead. The utterance of a tap is
+ * held back this long in case a second tap follows, so 0 announces taps on release and disables double taps.
+ */
+#define aiaconfigCLIENT_TOUCH_DOUBLE_TAP_MS                 ( 250UL )
+
+/* Set to 1 to start the speaker and the microphone ahead of the directives that are likely to need them soon. See
+ * "Warm-up" in README.md.
+ */
+#ifndef aiaconfigCLIENT_WARMUP
+#define aiaconfigCLIENT_WARMUP                              ( 0 )
+#endif
+
+/* The speaker plays silence from THINKING on, until OpenSpeaker comes or this runs out. 0 leaves it cold. */
+#define aiaconfigCLIENT_WARMUP_SPEAKER_MS                   ( 3000UL )
+
+/* The microphone keeps capturing this long after SPEAKING, in case OpenMicrophone follows. 0 leaves it cold. */
+#define aiaconfigCLIENT_WARMUP_MICROPHONE_MS                ( 1500UL )
+
+/* Size of the static arena holding the Opus encoder state. It must be no less than opus_encoder_get_size(). */
+#define aiaconfigCLIENT_ENCODER_STATE_SIZE                  ( 20UL * 1024UL )
+
+/* Size of the static Opus pseudo-stack used for decode scratch. It must equal GLOBAL_STACK_SIZE given to the Opus
+ * build, which aia_opus_scratch.c checks. Check xAIAOpusScratchHighWaterMark() in a DEBUG build when tuning this value.
+ * The encoder shares the pseudo-stack and needs more of it than the decoder does.
+ */
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+#define aiaconfigCLIENT_DECODER_SCRATCH_SIZE                ( 24UL * 1024UL )
+#else
+#define aiaconfigCLIENT_DECODER_SCRATCH_SIZE                ( 12UL * 1024UL )
+#endif
+
 #define aiaconfigAIA_MESSAGE_MAX_SIZE                       ( 5400UL )
 
-#define aiaconfigAIA_AUDIO_DATA_SIZE                        ( 4800UL )
+/* Maximum size of microphone audio per message, used once an utterance is under way and while the outbound audio
+ * queue is congested. Audio is captured in whole 20ms raw frames, so this should be a multiple of 640 bytes.
+ */
+#if ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+/* 40ms of microphone audio per message. Messages reach this size right after the small chunks of the start of an
+ * utterance, so backpressure of the outbound task has no effect from then on: stalls only go into the spare slots.
+ */
+#define aiaconfigAIA_AUDIO_DATA_SIZE                        ( 1280UL )
+#else
+/* 140ms of microphone audio per message. */
+#define aiaconfigAIA_AUDIO_DATA_SIZE                        ( 4480UL )
+#endif
+
+/* The start of an utterance is sent in messages of aiaconfigAIA_AUDIO_FIRST_CHUNK_MS, for the first
+ * aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS, so that it reaches AIA quickly. Messages then double in size up to
+ * aiaconfigAIA_AUDIO_DATA_SIZE. Both can be changed at runtime with vClientSetMicrophoneChunking().
+ */
+#define aiaconfigAIA_AUDIO_FIRST_CHUNK_MS                   ( 20UL )
+
+#define aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS                  ( 300UL )
 
 #define aiaconfigAIA_DEFAULT_TIMEOUT                        pdMS_TO_TICKS( 5000 )
 
@@ -82,13 +362,114 @@
 /* Maximum jsmn token numbers. */
 #define aiaconfigJSMN_MAX_TOKENS                            ( 64UL )
 
+/* The Opus encoder keeps its temporaries on the pseudo-stack, but its call chain still needs a deeper task stack. */
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+#define aiaconfigAIA_STREAM_MICROPHONE_TASK_STACK_SIZE      ( configMINIMAL_STACK_SIZE * 8 )
+#elif ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+#define aiaconfigAIA_STREAM_MICROPHONE_TASK_STACK_SIZE      ( configMINIMAL_STACK_SIZE * 3 )
+#else
 #define aiaconfigAIA_STREAM_MICROPHONE_TASK_STACK_SIZE      ( configMINIMAL_STACK_SIZE * 4 )
+#endif
 #define aiaconfigAIA_STREAM_MICROPHONE_TASK_PRIORITY        ( tskIDLE_PRIORITY + 3 )
 
-#define aiaconfigAIA_SPEAKER_TASK_STACK_SIZE                ( configMINIMAL_STACK_SIZE * 18 )
+/* Opus decode scratch is served from its own arena, so this only covers the client itself. An Opus build with
+ * VAR_ARRAYS keeps the scratch on this stack instead, and needs ( configMINIMAL_STACK_SIZE * 18 ).
+ */
+#ifndef aiaconfigAIA_SPEAKER_TASK_STACK_SIZE
+#if ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+#define aiaconfigAIA_SPEAKER_TASK_STACK_SIZE                ( configMINIMAL_STACK_SIZE * 6 )
+#else
+#define aiaconfigAIA_SPEAKER_TASK_STACK_SIZE                ( configMINIMAL_STACK_SIZE * 8 )
+#endif
+#endif
 #define aiaconfigAIA_SPEAKER_TASK_PRIORITY                  ( configMAX_PRIORITIES - 2 )
 
+/* The outbound task encrypts and publishes all events and microphone audio. */
+#define aiaconfigAIA_OUTBOUND_TASK_STACK_SIZE               ( configMINIMAL_STACK_SIZE * 4 )
+#define aiaconfigAIA_OUTBOUND_TASK_PRIORITY                 ( tskIDLE_PRIORITY + 3 )
+
+#define aiaconfigAIA_OUTBOUND_CONTROL_QUEUE_LENGTH          ( 8UL )
+
+/* Number of event buffers, see aia_eventpool.h. Each takes about 1 KB. An event waits for a buffer for up to
+ * aiaconfigAIA_DEFAULT_TIMEOUT when all of them are queued or being published.
+ */
+#if ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+#define aiaconfigAIA_EVENT_BUFFERS                          ( 4UL )
+#else
+#define aiaconfigAIA_EVENT_BUFFERS                          ( aiaconfigAIA_OUTBOUND_CONTROL_QUEUE_LENGTH + 2UL )
+#endif
+
+/* Each queued audio message holds a buffer of aiaconfigAIA_AUDIO_DATA_SIZE. */
+#define aiaconfigAIA_OUTBOUND_AUDIO_QUEUE_LENGTH            ( 2UL )
+
+/* Number of microphone capture slots, each holding up to aiaconfigAIA_AUDIO_DATA_SIZE of audio. Besides the slots
+ * being filled and published and those in the outbound audio queue, the spare ones absorb network stalls.
+ */
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+/* The pre-roll is sent in slots of its own at the start of an utterance, each holding as many whole frames as fit in
+ * aiaconfigAIA_AUDIO_DATA_SIZE. Raw audio takes 32 bytes per millisecond.
+ */
+#define aiaconfigAIA_MICROPHONE_SLOT_FRAMES                 ( aiaconfigAIA_AUDIO_DATA_SIZE / ( 32UL * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS ) )
+#define aiaconfigAIA_MICROPHONE_PREROLL_SLOTS               ( ( aiaconfigCLIENT_WAKEWORD_PREROLL_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS + \
+                                                                aiaconfigAIA_MICROPHONE_SLOT_FRAMES - 1UL ) / aiaconfigAIA_MICROPHONE_SLOT_FRAMES )
+#else
+#define aiaconfigAIA_MICROPHONE_PREROLL_SLOTS               ( 0UL )
+#endif
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+/* The audio captured while a gesture is told apart waits in whole slots until MicrophoneOpened is sent. */
+#define aiaconfigAIA_MICROPHONE_GESTURE_SLOTS               ( ( ( aiaconfigCLIENT_TOUCH_LONG_PRESS_MS + aiaconfigCLIENT_TOUCH_DOUBLE_TAP_MS ) * 32UL + \
+                                                                aiaconfigAIA_AUDIO_DATA_SIZE - 1UL ) / aiaconfigAIA_AUDIO_DATA_SIZE )
+#else
+#define aiaconfigAIA_MICROPHONE_GESTURE_SLOTS               ( 0UL )
+#endif
+/* Spare capture slots, on top of the slot being filled, the one being prepared by the microphone task and those in
+ * the outbound audio queue. While the network stalls, the DMA goes on filling them, so they ride out stalls shorter
+ * than ( aiaconfigAIA_MICROPHONE_SPARE_SLOTS * aiaconfigAIA_AUDIO_DATA_SIZE / 32 ) ms of raw audio. That is 420ms with
+ * the default slots of 140ms, but only 120ms with the 40ms slots of the low-memory profile: there, 200ms stalls drop
+ * audio unless this is raised to 6, i.e. about 3.9 KB more. During the first aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS of an
+ * utterance the slots hold a single frame each, and absorb less. test_stall of the host tests measures the drops.
+ */
+#ifndef aiaconfigAIA_MICROPHONE_SPARE_SLOTS
+#define aiaconfigAIA_MICROPHONE_SPARE_SLOTS                 ( 3UL )
+#endif
+#define aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS               ( aiaconfigAIA_OUTBOUND_AUDIO_QUEUE_LENGTH + aiaconfigAIA_MICROPHONE_SPARE_SLOTS + \
+                                                              aiaconfigAIA_MICROPHONE_PREROLL_SLOTS + aiaconfigAIA_MICROPHONE_GESTURE_SLOTS )
+
+/* Microphone audio is published at no more than this many bytes per interval. Events are always published, but
+ * count against the budget. The default allows the microphone to catch up at 2.5 times real time.
+ */
+#define aiaconfigAIA_OUTBOUND_INTERVAL                      pdMS_TO_TICKS( 100 )
+#define aiaconfigAIA_OUTBOUND_BYTES_PER_INTERVAL            ( 8000L )
+
+/* DEBUG builds only: delay every aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_INTERVAL-th microphone message by
+ * aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS before it is published, to see how the microphone pipeline rides out
+ * network stalls. Dropped frames are reported at CloseMicrophone. 0 disables the delay.
+ */
+#ifndef aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS
+#define aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS          ( 0UL )
+#endif
+#ifndef aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_INTERVAL
+#define aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_INTERVAL    ( 25UL )
+#endif
+
 /* The number of out-of-order messages received on /speaker that we handle. */
+#if ( aiaconfigLOW_MEMORY_PROFILE == 1 )
+#define aiaconfigAIA_SPEAKER_RESEQUENCING                   ( 2UL )
+#else
 #define aiaconfigAIA_SPEAKER_RESEQUENCING                   ( 4UL )
+#endif
+
+/* Number of MQTT packet buffers in the pool owned by the client. Each message held in the resequencing buffer keeps
+ * one, plus one for the packet being received and one for the packet being sent. MQTT falls back to the heap
+ * when the pool runs out. With 0, every packet comes from the heap, as without the pool.
+ */
+#ifndef aiaconfigAIA_RECEIVE_POOL_BUFFERS
+#define aiaconfigAIA_RECEIVE_POOL_BUFFERS                   ( aiaconfigAIA_SPEAKER_RESEQUENCING + 2UL )
+#endif
+
+/* Size of each buffer in the pool. It holds the remaining part of a PUBLISH packet, i.e. the topic name, the
+ * packet identifier and an encrypted message of up to aiaconfigAIA_MESSAGE_MAX_SIZE bytes.
+ */
+#define aiaconfigAIA_RECEIVE_POOL_BUFFER_SIZE               ( aiaconfigAIA_MESSAGE_MAX_SIZE + 256UL )
 
 #endif
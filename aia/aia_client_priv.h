@@ -25,10 +25,12 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "queue.h"
 #include "semphr.h"
 #include "event_groups.h"
 #include "stream_buffer.h"
 #include "message_buffer.h"
+#include "timers.h"
 
 /* Credentials includes. */
 #include "aws_clientcredential.h"
@@ -39,6 +41,24 @@
 #include "aia_platform.h"
 #include "aia_utils.h"
 #include "aia_bufferlist.h"
+#include "aia_opus_scratch.h"
+#include "aia_recvpool.h"
+#include "aia_eventpool.h"
+#include "aia_publish.h"
+#include "aia_outbound.h"
+#include "aia_capture.h"
+#include "aia_micinput.h"
+#include "aia_beamformer.h"
+#include "aia_decimator.h"
+#include "aia_wakeword.h"
+#include "aia_vad.h"
+#include "aia_aec.h"
+#include "aia_frontend.h"
+#include "aia_warmup.h"
+#include "aia_playout.h"
+#include "aia_playclock.h"
+#include "aia_offsetsched.h"
+#include "aia_speakerbuffer.h"
 
 #include "opus.h"
 
@@ -110,6 +130,8 @@ enum {
     sAlexaThinking,
     sAlexaSpeaking,
     sAlexaAlerting,
+    sMicrophoneListening,
+    sMicrophoneWarm,
     sMax = 32
 };
 
@@ -125,6 +147,10 @@ enum {
 #define AIA_STATE_ALEXA_THINKING                        ( 1 << sAlexaThinking )
 #define AIA_STATE_ALEXA_SPEAKING                        ( 1 << sAlexaSpeaking )
 #define AIA_STATE_ALEXA_ALERTING                        ( 1 << sAlexaAlerting )
+/* The platform microphone stays open between utterances, feeding the wake word spotter. */
+#define AIA_STATE_MICROPHONE_LISTENING                  ( 1 << sMicrophoneListening )
+/* The platform microphone has been started ahead of OpenMicrophone, and its audio is dropped until then. */
+#define AIA_STATE_MICROPHONE_WARM                       ( 1 << sMicrophoneWarm )
 #define AIA_STATE_ALEXA_MASK                            ( AIA_STATE_ALEXA_IDLE | AIA_STATE_ALEXA_THINKING | AIA_STATE_ALEXA_SPEAKING | AIA_STATE_ALEXA_ALERTING )
 
 #define AIA_SPEAKER_DECODER_FRAME_SIZE                  ( aiaconfigCLIENT_SPEAKER_DECODER_BITRATE * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS / 1000 / 8 )
@@ -139,7 +165,24 @@ enum {
 #define AIA_MICROPHONE_RAW_BYTES_PER_SAMPLE             ( aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RESOLUTION / 8 )
 #define AIA_MICROPHONE_RAW_FRAME_SAMPLES                ( aiaconfigCLIENT_MICROPHONE_RAW_CHANNELS * aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS / 1000 )
 #define AIA_MICROPHONE_RAW_FRAME_SIZE                   ( AIA_MICROPHONE_RAW_FRAME_SAMPLES * AIA_MICROPHONE_RAW_BYTES_PER_SAMPLE )
-#define AIA_MICROPHONE_RAW_BUFFER_TOTAL_SIZE            ( AIA_MICROPHONE_RAW_FRAME_SIZE * aiaconfigCLIENT_MICROPHONE_RAW_BUFFER_FRAMES )
+#define AIA_MICROPHONE_MAX_FRAMES                       ( aiaconfigAIA_AUDIO_DATA_SIZE / AIA_MICROPHONE_RAW_FRAME_SIZE )
+/* What the platform microphone captures, before it is converted to the raw format. */
+#define AIA_MICROPHONE_DECIMATION                       ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE / aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE )
+#define AIA_MICROPHONE_CAPTURE_BYTES_PER_SAMPLE         ( ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION == 16 ) ? 2 : 4 )
+#define AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES            ( AIA_MICROPHONE_RAW_FRAME_SAMPLES * AIA_MICROPHONE_DECIMATION )
+#define AIA_MICROPHONE_CAPTURE_FRAME_SIZE               ( AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES * aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS * AIA_MICROPHONE_CAPTURE_BYTES_PER_SAMPLE )
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 ) || ( AIA_MICROPHONE_DECIMATION > 1 ) || ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 16 )
+#define AIA_MICROPHONE_CAPTURE_CONVERTED                ( 1 )
+#else
+#define AIA_MICROPHONE_CAPTURE_CONVERTED                ( 0 )
+#endif
+#define AIA_MICROPHONE_ENCODER_FRAME_SIZE               ( aiaconfigCLIENT_MICROPHONE_ENCODER_BITRATE * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS / 1000 / 8 )
+/* Bytes a frame of microphone audio takes in the stream, which the offsets count in. */
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+#define AIA_MICROPHONE_STREAM_FRAME_SIZE                AIA_MICROPHONE_ENCODER_FRAME_SIZE
+#else
+#define AIA_MICROPHONE_STREAM_FRAME_SIZE                AIA_MICROPHONE_RAW_FRAME_SIZE
+#endif
 
 typedef enum {
     aiaEventSecretRotated,
@@ -166,7 +209,8 @@ typedef enum {
 typedef struct {
     struct {
         uint32_t ulLen;
-        uint8_t ucBuffer[ aiaconfigAIA_MESSAGE_MAX_SIZE ];
+        /* Retained with pvAIARecvPoolRetain(). */
+        uint8_t * pucBuffer;
     } xMessage [ aiaconfigAIA_SPEAKER_RESEQUENCING ];
     uint8_t ucStartIndex;
 } AIAClient_Resequence_t;
@@ -189,8 +233,48 @@ typedef struct {
     char * pcBufferStateStr;
 } AIABufferStateChanged_t;
 
+/* Where a touch on the button is, between touch-down and the utterance being announced or closed. */
+typedef enum {
+    eAIAGestureIdle,
+    /* Touched, with the microphone open and MicrophoneOpened held back until the gesture is known. */
+    eAIAGesturePressed,
+    /* Released before the long press, and waiting for a second tap. */
+    eAIAGestureReleased,
+    /* Held past the long press. */
+    eAIAGestureHeld,
+    /* Released after a long press. The microphone closes once the audio up to the release is streamed. */
+    eAIAGestureHoldReleased,
+} AIAClient_Gesture_t;
+
+/* Where the recovery of /speaker messages lost beyond the resequencing range is. */
+typedef enum {
+    eAIAGapNone,
+    /* Waiting for the missing messages, which may only be late. */
+    eAIAGapWaiting,
+    /* The timer has asked for a resend. The /speaker handler is to drop what it holds and expect it. */
+    eAIAGapResendRequested,
+    /* Waiting for the resend. */
+    eAIAGapResending,
+    /* The resend has not come. The /speaker handler plays on from the next message, and the speaker task fills the
+     * hole in the offsets.
+     */
+    eAIAGapLost,
+} AIAClient_Gap_t;
+
+typedef struct {
+    /* Gaps beyond the resequencing range, those filled while waiting, the resends asked for and those that came. */
+    uint32_t ulGaps;
+    uint32_t ulFilled;
+    uint32_t ulResends;
+    uint32_t ulResent;
+    /* Gaps given up on, the messages missing from them, and the frames of silence played in their place. */
+    uint32_t ulLost;
+    uint32_t ulLostMessages;
+    uint32_t ulConcealedFrames;
+} AIAClient_GapStatistics_t;
+
 typedef struct {
-    char * pcWakeWordString;
+    const char * pcWakeWordString;
     uint64_t ullWakeWordBegin;
     uint64_t ullWakeWordEnd;
 } AIAClient_Wakeword_t;
@@ -205,14 +289,11 @@ typedef struct {
     uint64_t ullOutputOffset;
     OpusDecoder * xDecoder;
     uint32_t ulDecoderBitrate;
-    /* The speaker buffer is currently implemented using FreeRTOS message buffers.
-     * However, AIA has some special requirements for buffer management which message
-     * buffers cannot satisfy, e.g. message replacement and re-ordering. We have to
-     * introduce another buffer for resequencing in aia_client as one of the drawbacks
-     * of the current method. A better solution is to implement customized buffer with
-     * other data structures e.g. linked list.
+    /* The speaker buffer works as a FreeRTOS message buffer that can also replace its oldest messages, which AIA
+     * asks for while the speaker is closed. Messages are still re-ordered in a resequencing buffer of aia_client
+     * before they are written to it.
      */
-    MessageBufferHandle_t xSpeakerBuffer;
+    AIASpeakerBuffer_t xSpeakerBuffer;
     uint32_t ulSpeakerBufferSize;
     uint32_t ulSpeakerBufferOverrunWarning;
     uint32_t ulSpeakerBufferUnderrunWarning;
@@ -230,10 +311,22 @@ typedef struct {
     uint64_t ullOffset;
 } AIAClient_SetVolume_t;
 
+/* Directive actions taken when the speaker gets to an offset. */
+typedef enum {
+    eAIAOffsetActionSetVolume,
+    eAIAOffsetActionSetAttentionState,
+    eAIAOffsetActionCloseSpeaker
+} AIAClient_OffsetAction_t;
+
 typedef struct {
-    StreamBufferHandle_t xMicBuffer;
     uint32_t ulMicrophoneSequence;
     uint64_t ullMicrophoneOffset;
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+    OpusEncoder * xEncoder;
+    /* The last frame encoded, sent again in place of a frame that fails to encode. */
+    uint8_t ucLastEncodedFrame[ AIA_MICROPHONE_ENCODER_FRAME_SIZE ];
+    BaseType_t xLastEncodedFrameValid;
+#endif
 } AIAClient_Microphone_t;
 
 typedef struct {
@@ -59,7 +59,9 @@ typedef struct {
  * @param[out] msg_buf      The buffer holding the encrypted AIA message to be sent.
  * @param[in] plaintext     The original data. Note that the memory pointed to by this
  *                          pointer must contain enough space preceding it for the
- *                          sequence number.
+ *                          sequence number. msg_buf may be anywhere, e.g. in the
+ *                          MQTT packet buffer, as AIAMessage_t has no alignment
+ *                          requirement.
  * @param[in] plaintext_len The length of the original data.
  * @param[in] sequence      The sequence number of this message.
  *
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_decimator.h"
+
+#if ( AIA_MICROPHONE_DECIMATION > 1 )
+
+#if defined( __ARM_FEATURE_SIMD32 )
+#include <arm_acle.h>
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE != AIA_MICROPHONE_DECIMATION * aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE )
+#error "The capture rate of the microphone must be a multiple of the raw rate."
+#endif
+
+/* Kaiser-windowed sinc low-pass filters in Q15 with a gain of exactly 1, cut off at 8kHz (-6dB). */
+#if ( AIA_MICROPHONE_DECIMATION == 2 )
+#define AIA_DECIMATOR_TAPS              ( 40 )
+static const int16_t sTaps[ AIA_DECIMATOR_TAPS ] __attribute__((aligned(4))) = {
+    -6, -13, 23, 38, -59, -86, 122, 168, -226, -299, 390, 503, -647, -831, 1074, 1414, -1928, -2820, 4839, 14728,
+    14728, 4839, -2820, -1928, 1414, 1074, -831, -647, 503, 390, -299, -226, 168, 122, -86, -59, 38, 23, -13, -6
+};
+#elif ( AIA_MICROPHONE_DECIMATION == 3 )
+#define AIA_DECIMATOR_TAPS              ( 60 )
+static const int16_t sTaps[ AIA_DECIMATOR_TAPS ] __attribute__((aligned(4))) = {
+    -3, -9, -7, 11, 30, 20, -27, -70, -45, 56, 139, 85, -104, -250, -150, 178, 423, 250, -295, -695, -411, 487, 1162,
+    702, -862, -2174, -1434, 2046, 6906, 10425, 10425, 6906, 2046, -1434, -2174, -862, 702, 1162, 487, -411, -695,
+    -295, 250, 423, 178, -150, -250, -104, 85, 139, 56, -45, -70, -27, 20, 30, 11, -7, -9, -3
+};
+#else
+#error "The microphone can be captured at 16, 32 or 48kHz."
+#endif
+
+#define AIA_DECIMATOR_OUTPUT_SAMPLES    AIA_MICROPHONE_RAW_FRAME_SAMPLES
+#define AIA_DECIMATOR_INPUT_SAMPLES     AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES
+/* The input keeps the end of the previous frame for the taps. The filters have an even number of taps, so that the
+ * frame stays 32-bit aligned.
+ */
+#define AIA_DECIMATOR_HISTORY           AIA_DECIMATOR_TAPS
+
+/* DEBUG builds check the SIMD version against the reference on a frame every second. */
+#define AIA_DECIMATOR_CHECK_FRAMES      ( 1000UL / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+static struct {
+    int16_t sInput[ AIA_DECIMATOR_HISTORY + AIA_DECIMATOR_INPUT_SAMPLES ] __attribute__((aligned(4)));
+    AIACycleMeter_t xMeter;
+#if defined( __ARM_FEATURE_SIMD32 ) && defined( DEBUG )
+    int16_t sReference[ AIA_DECIMATOR_OUTPUT_SAMPLES ];
+    AIACycleMeter_t xReferenceMeter;
+    uint32_t ulReferenceMismatches;
+#endif
+} xDecimator;
+
+static int16_t prvRound( int64_t llSum )
+{
+    int64_t llSample = ( llSum + ( 1 << 14 ) ) >> 15;
+
+    return ( int16_t )( ( llSample > INT16_MAX ) ? INT16_MAX : ( llSample < INT16_MIN ) ? INT16_MIN : llSample );
+}
+
+/* The plain C version, which the SIMD one is checked against. Output n ends with input sample ( n + 1 ) * M - 1. */
+static void prvDecimateReference( int16_t * psOutput )
+{
+    const int16_t * psWindow;
+    int64_t llSum;
+
+    for( uint32_t n = 0; n < AIA_DECIMATOR_OUTPUT_SAMPLES; n++ )
+    {
+        psWindow = &xDecimator.sInput[ AIA_DECIMATOR_HISTORY + ( n + 1 ) * AIA_MICROPHONE_DECIMATION - AIA_DECIMATOR_TAPS ];
+        llSum = 0;
+        for( uint32_t k = 0; k < AIA_DECIMATOR_TAPS; k++ )
+        {
+            llSum += ( int32_t )sTaps[ k ] * psWindow[ k ];
+        }
+        psOutput[ n ] = prvRound( llSum );
+    }
+}
+
+#if defined( __ARM_FEATURE_SIMD32 )
+
+/* Two taps at a time with SMLALD. The 64-bit sum cannot overflow, whatever the input. */
+static void prvDecimate( int16_t * psOutput )
+{
+    const int16_t * psWindow;
+    int64_t llSum;
+    uint32_t ulTaps;
+    uint32_t ulSamples;
+
+    for( uint32_t n = 0; n < AIA_DECIMATOR_OUTPUT_SAMPLES; n++ )
+    {
+        psWindow = &xDecimator.sInput[ AIA_DECIMATOR_HISTORY + ( n + 1 ) * AIA_MICROPHONE_DECIMATION - AIA_DECIMATOR_TAPS ];
+        llSum = 0;
+        for( uint32_t k = 0; k < AIA_DECIMATOR_TAPS; k += 2 )
+        {
+            memcpy( &ulTaps, &sTaps[ k ], sizeof( ulTaps ) );
+            /* The window of odd phases is not aligned, which LDR allows. */
+            memcpy( &ulSamples, &psWindow[ k ], sizeof( ulSamples ) );
+            llSum = __smlald( ( int16x2_t )ulTaps, ( int16x2_t )ulSamples, llSum );
+        }
+        psOutput[ n ] = prvRound( llSum );
+    }
+}
+
+#else
+
+#define prvDecimate     prvDecimateReference
+
+#endif
+
+void vAIADecimatorInit( void )
+{
+    memset( &xDecimator, 0, sizeof( xDecimator ) );
+}
+
+int16_t * psAIADecimatorInput( void )
+{
+    return &xDecimator.sInput[ AIA_DECIMATOR_HISTORY ];
+}
+
+void vAIADecimatorProcess( int16_t * psOutput )
+{
+    vAIACycleMeterStart( &xDecimator.xMeter );
+    prvDecimate( psOutput );
+    vAIACycleMeterStop( &xDecimator.xMeter );
+
+#if defined( __ARM_FEATURE_SIMD32 ) && defined( DEBUG )
+    if( xDecimator.xMeter.ulCount % AIA_DECIMATOR_CHECK_FRAMES == 1 )
+    {
+        vAIACycleMeterStart( &xDecimator.xReferenceMeter );
+        prvDecimateReference( xDecimator.sReference );
+        vAIACycleMeterStop( &xDecimator.xReferenceMeter );
+
+        if( memcmp( xDecimator.sReference, psOutput, sizeof( xDecimator.sReference ) ) != 0 )
+        {
+            xDecimator.ulReferenceMismatches++;
+        }
+    }
+#endif
+
+    /* Keep the end of this frame for the taps of the next one. */
+    memcpy( &xDecimator.sInput[ 0 ], &xDecimator.sInput[ AIA_DECIMATOR_INPUT_SAMPLES ], AIA_DECIMATOR_HISTORY * sizeof( int16_t ) );
+}
+
+void vAIADecimatorGetStatistics( AIADecimatorStatistics_t * pxStatistics )
+{
+    pxStatistics->ulCyclesAverage = ulAIACycleMeterAverage( &xDecimator.xMeter );
+    pxStatistics->ulCyclesMax = xDecimator.xMeter.ulMax;
+    pxStatistics->ulFrames = xDecimator.xMeter.ulCount;
+#if defined( __ARM_FEATURE_SIMD32 ) && defined( DEBUG )
+    pxStatistics->ulReferenceCyclesAverage = ulAIACycleMeterAverage( &xDecimator.xReferenceMeter );
+    pxStatistics->ulReferenceMismatches = xDecimator.ulReferenceMismatches;
+#else
+    pxStatistics->ulReferenceCyclesAverage = 0;
+    pxStatistics->ulReferenceMismatches = 0;
+#endif
+}
+
+void vAIADecimatorReport( void )
+{
+    AIADecimatorStatistics_t xDecimator;
+
+    vAIADecimatorGetStatistics( &xDecimator );
+    configPRINTF_DEBUG( ( "DEBUG: Decimator from %u Hz %u cycles per frame on average, %u max, over %u frames\r\n",
+                          ( uint32_t )aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE, xDecimator.ulCyclesAverage,
+                          xDecimator.ulCyclesMax, xDecimator.ulFrames ) );
+    if( xDecimator.ulReferenceCyclesAverage != 0 )
+    {
+        configPRINTF_DEBUG( ( "DEBUG: Decimator reference %u cycles per frame on average, %u frames not matching\r\n",
+                              xDecimator.ulReferenceCyclesAverage, xDecimator.ulReferenceMismatches ) );
+    }
+}
+
+#endif /* AIA_MICROPHONE_DECIMATION > 1 */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_DECIMATOR_H_
+#define _AIA_DECIMATOR_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A FIR decimator in polyphase form from the capture rate of the microphone to the 16kHz raw rate: only the outputs
+ * kept are computed, so the filter costs its taps once per output sample rather than once per input sample. The filter is flat to 6.5kHz and at least
+ * 50dB down from 9.5kHz, so that what folds back below 8kHz stays above the band ASR relies on.
+ */
+
+/**
+ * @brief                   Clear the history of the filter.
+ */
+void vAIADecimatorInit( void );
+
+/**
+ * @brief                   Get where the next frame at the capture rate is to be written.
+ *
+ * @return                  Room for AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES samples.
+ */
+int16_t * psAIADecimatorInput( void );
+
+/**
+ * @brief                   Decimate the frame written to psAIADecimatorInput().
+ *
+ * @param[out] psOutput     The frame at the raw rate, AIA_MICROPHONE_RAW_FRAME_SAMPLES samples.
+ */
+void vAIADecimatorProcess( int16_t * psOutput );
+
+typedef struct {
+    /* CPU cycles per frame. */
+    uint32_t ulCyclesAverage;
+    uint32_t ulCyclesMax;
+    uint32_t ulFrames;
+    /* CPU cycles per frame of the plain C reference, and the frames it did not give the same result on. DEBUG builds
+     * for cores with the DSP extension run it on a frame every second.
+     */
+    uint32_t ulReferenceCyclesAverage;
+    uint32_t ulReferenceMismatches;
+} AIADecimatorStatistics_t;
+
+/**
+ * @brief                   Get the statistics since vAIADecimatorInit().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIADecimatorGetStatistics( AIADecimatorStatistics_t * pxStatistics );
+
+/**
+ * @brief                   Print the statistics since vAIADecimatorInit() to the debug log.
+ */
+void vAIADecimatorReport( void );
+
+#endif /* _AIA_DECIMATOR_H_ */
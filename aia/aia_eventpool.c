@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_eventpool.h"
+
+static struct {
+    uint8_t ucBuffer[ aiaconfigAIA_EVENT_BUFFERS ][ AIA_EVENT_BUFFER_SIZE ] __attribute__((aligned(4)));
+    /* Pointers to the free buffers. */
+    QueueHandle_t xFree;
+    UBaseType_t uxMinFree;
+} xEventPool;
+
+BaseType_t xAIAEventPoolInit( void )
+{
+    void * pvBuffer;
+
+    if( xEventPool.xFree != NULL )
+    {
+        return pdPASS;
+    }
+
+    xEventPool.xFree = xQueueCreate( aiaconfigAIA_EVENT_BUFFERS, sizeof( void * ) );
+    if( xEventPool.xFree == NULL )
+    {
+        configPRINTF( ( "Failed to create the event buffer pool!\r\n" ) );
+        return pdFAIL;
+    }
+
+    for( int i = 0; i < aiaconfigAIA_EVENT_BUFFERS; i++ )
+    {
+        pvBuffer = xEventPool.ucBuffer[ i ];
+        ( void )xQueueSend( xEventPool.xFree, &pvBuffer, 0 );
+    }
+    xEventPool.uxMinFree = aiaconfigAIA_EVENT_BUFFERS;
+
+    return pdPASS;
+}
+
+void * pvAIAEventPoolTake( TickType_t xTicksToWait )
+{
+    void * pvBuffer = NULL;
+    UBaseType_t uxFree;
+
+    if( xQueueReceive( xEventPool.xFree, &pvBuffer, xTicksToWait ) != pdTRUE )
+    {
+        return NULL;
+    }
+
+    uxFree = uxQueueMessagesWaiting( xEventPool.xFree );
+    taskENTER_CRITICAL();
+    if( uxFree < xEventPool.uxMinFree )
+    {
+        xEventPool.uxMinFree = uxFree;
+    }
+    taskEXIT_CRITICAL();
+
+    return pvBuffer;
+}
+
+void vAIAEventPoolGive( void * pvBuffer )
+{
+    configASSERT( ( uint8_t * )pvBuffer >= &xEventPool.ucBuffer[ 0 ][ 0 ] &&
+                  ( uint8_t * )pvBuffer < &xEventPool.ucBuffer[ aiaconfigAIA_EVENT_BUFFERS ][ 0 ] );
+
+    /* There is always room, as the queue holds every buffer of the pool. */
+    ( void )xQueueSend( xEventPool.xFree, &pvBuffer, 0 );
+}
+
+UBaseType_t uxAIAEventPoolMinFree( void )
+{
+    return xEventPool.uxMinFree;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_EVENTPOOL_H_
+#define _AIA_EVENTPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* Events and capabilities are built in buffers of a fixed pool owned by the client instead of the heap. Each buffer
+ * holds AIA_EVENT_MESSAGE_MAX_SIZE of JSON plus the room for the sequence number preceding it, see
+ * lAIACryptoEncrypt(). A buffer is taken when the message is built, and given back by the outbound task once the
+ * message has been published or dropped, so aiaconfigAIA_EVENT_BUFFERS bounds the events in flight.
+ */
+
+/* Size of each buffer of the pool. */
+#define AIA_EVENT_BUFFER_SIZE               ( AIA_MSG_PARAMS_SIZE_SEQ + AIA_EVENT_MESSAGE_MAX_SIZE )
+
+/**
+ * @brief                   Create the free list of the pool. Calling it again once it is created does nothing.
+ *
+ * @return                  pdPASS on success and pdFAIL on failure.
+ */
+BaseType_t xAIAEventPoolInit( void );
+
+/**
+ * @brief                   Take a buffer of AIA_EVENT_BUFFER_SIZE bytes from the pool.
+ *
+ * @param[in] xTicksToWait  The maximum time to wait for a buffer to be given back.
+ *
+ * @return                  Pointer to the buffer, or NULL if none was free within xTicksToWait.
+ */
+void * pvAIAEventPoolTake( TickType_t xTicksToWait );
+
+/**
+ * @brief                   Give a buffer back to the pool. It has the signature of AIAOutboundMessage_t.vRelease.
+ *
+ * @param[in] pvBuffer      Pointer to a buffer from pvAIAEventPoolTake().
+ */
+void vAIAEventPoolGive( void * pvBuffer );
+
+/**
+ * @brief                   Return the fewest buffers that have been free at once since xAIAEventPoolInit().
+ *
+ * @return                  The number of buffers.
+ */
+UBaseType_t uxAIAEventPoolMinFree( void );
+
+#endif /* _AIA_EVENTPOOL_H_ */
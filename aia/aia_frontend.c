@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_frontend.h"
+
+#if ( aiaconfigCLIENT_FRONTEND == 1 )
+
+#define AIA_FRONTEND_FRAME_SAMPLES      AIA_MICROPHONE_RAW_FRAME_SAMPLES
+
+/* Levels are the mean square of a frame as log2 in Q8, see lAIALog2Q8(). A full-scale square wave is 30 and 1 dB is
+ * 85, so that x dBFS is AIA_FRONTEND_DBFS( x ).
+ */
+#define AIA_FRONTEND_DB( x )            ( ( int32_t )( x ) * 85 )
+#define AIA_FRONTEND_DBFS( x )          ( ( 30 << 8 ) - AIA_FRONTEND_DB( x ) )
+
+/* Gains are applied in Q12. */
+#define AIA_FRONTEND_GAIN_SHIFT         ( 12 )
+#define AIA_FRONTEND_UNITY_GAIN         ( 1 << AIA_FRONTEND_GAIN_SHIFT )
+
+/* The DC blocker y[n] = x[n] - x[n-1] + ( 1 - 2^-8 ) * y[n-1] keeps y with 8 more bits. */
+#define AIA_FRONTEND_DC_SHIFT           ( 8 )
+
+/* 100Hz second-order Butterworth high-pass at 16kHz in Q28, from the bilinear transform. The signal is kept with 12
+ * more bits, so that the poles close to the unit circle stay stable.
+ */
+#define AIA_FRONTEND_HPF_B0             ( 261084055 )
+#define AIA_FRONTEND_HPF_B1             ( -2 * AIA_FRONTEND_HPF_B0 )
+#define AIA_FRONTEND_HPF_A1             ( -521966747 )
+#define AIA_FRONTEND_HPF_A2             ( 253934019 )
+#define AIA_FRONTEND_HPF_SHIFT          ( 12 )
+
+/* The noise floor follows quieter frames quickly, and rises by about 0.6dB per second at 20ms frames. */
+#define AIA_FRONTEND_NOISE_INITIAL      AIA_FRONTEND_DBFS( 60 )
+#define AIA_FRONTEND_NOISE_RISE         ( 1 )
+#define AIA_FRONTEND_NOISE_FALL_SHIFT   ( 2 )
+
+/* The AGC only follows frames above -50dBFS, so that it does not turn silence up. Its level follows louder frames
+ * at once and quieter ones slowly, and its gain rises by at most 0.5dB per frame.
+ */
+#define AIA_FRONTEND_AGC_GATE           AIA_FRONTEND_DBFS( 50 )
+#define AIA_FRONTEND_AGC_RELEASE_SHIFT  ( 4 )
+#define AIA_FRONTEND_AGC_RISE           ( AIA_FRONTEND_DB( 1 ) / 2 )
+
+#if ( aiaconfigCLIENT_MICROPHONE_RAW_SAMPLE_RATE != AUDIO_SAMPLE_RATE_16KHZ ) && ( aiaconfigCLIENT_FRONTEND_HIGH_PASS == 1 )
+#error "The high-pass filter of the microphone front-end is designed for 16kHz."
+#endif
+
+typedef struct {
+    const char * pcName;
+    BaseType_t xBuiltIn;
+    void ( * vProcess )( int16_t * psFrame );
+    volatile BaseType_t xEnabled;
+    AIACycleMeter_t xMeter;
+} AIAFrontendStageEntry_t;
+
+static struct {
+    int32_t lDcInput;
+    int32_t lDcOutput;
+
+    int32_t lHpfInput[ 2 ];
+    int32_t lHpfOutput[ 2 ];
+
+    int32_t lNoiseFloor;
+    int32_t lNoiseGain;
+
+    int32_t lAgcLevel;
+    int32_t lAgcGain;
+    int32_t lAgcAppliedGain;
+} xFrontend;
+
+static int16_t prvSaturate( int32_t lSample )
+{
+    return ( int16_t )( ( lSample > INT16_MAX ) ? INT16_MAX : ( lSample < INT16_MIN ) ? INT16_MIN : lSample );
+}
+
+/* The mean square of a frame as log2 in Q8. */
+static int32_t prvFrameLevel( const int16_t * psFrame )
+{
+    uint64_t ullSquares = 0;
+
+    for( uint32_t i = 0; i < AIA_FRONTEND_FRAME_SAMPLES; i++ )
+    {
+        ullSquares += ( uint64_t )( ( int32_t )psFrame[ i ] * psFrame[ i ] );
+    }
+
+    return lAIALog2Q8( ullSquares / AIA_FRONTEND_FRAME_SAMPLES );
+}
+
+/* 2^x in Q12 for x in Q8, interpolating linearly between powers of two. */
+static int32_t prvExp2Q8( int32_t lValue )
+{
+    int32_t lInteger = lValue >> 8;
+    int32_t lPower;
+
+    if( lInteger < -AIA_FRONTEND_GAIN_SHIFT )
+    {
+        return 0;
+    }
+
+    lPower = ( lInteger >= 0 ) ? ( AIA_FRONTEND_UNITY_GAIN << lInteger ) : ( AIA_FRONTEND_UNITY_GAIN >> -lInteger );
+
+    return ( lPower * ( 256 + ( lValue & 255 ) ) ) >> 8;
+}
+
+/* Apply a gain in Q12 that moves from lFrom to lTo over the frame, so that a change of gain does not click. */
+static void prvApplyGain( int16_t * psFrame, int32_t lFrom, int32_t lTo )
+{
+    /* The gain in Q20, stepped once per sample. */
+    int32_t lGain = lFrom << 8;
+    int32_t lStep = ( ( lTo - lFrom ) << 8 ) / ( int32_t )AIA_FRONTEND_FRAME_SAMPLES;
+
+    for( uint32_t i = 0; i < AIA_FRONTEND_FRAME_SAMPLES; i++ )
+    {
+        lGain += lStep;
+        psFrame[ i ] = prvSaturate( ( psFrame[ i ] * ( lGain >> 8 ) ) >> AIA_FRONTEND_GAIN_SHIFT );
+    }
+}
+
+#if ( aiaconfigCLIENT_FRONTEND_DC_REMOVAL == 1 )
+static void prvDcRemoval( int16_t * psFrame )
+{
+    int32_t lInput;
+
+    for( uint32_t i = 0; i < AIA_FRONTEND_FRAME_SAMPLES; i++ )
+    {
+        lInput = psFrame[ i ];
+        xFrontend.lDcOutput += ( ( lInput - xFrontend.lDcInput ) << AIA_FRONTEND_DC_SHIFT ) - ( xFrontend.lDcOutput >> AIA_FRONTEND_DC_SHIFT );
+        xFrontend.lDcInput = lInput;
+        psFrame[ i ] = prvSaturate( xFrontend.lDcOutput >> AIA_FRONTEND_DC_SHIFT );
+    }
+}
+#endif
+
+#if ( aiaconfigCLIENT_FRONTEND_HIGH_PASS == 1 )
+static void prvHighPass( int16_t * psFrame )
+{
+    int32_t lInput;
+    int32_t lOutput;
+    int64_t llSum;
+
+    for( uint32_t i = 0; i < AIA_FRONTEND_FRAME_SAMPLES; i++ )
+    {
+        lInput = ( int32_t )psFrame[ i ] << AIA_FRONTEND_HPF_SHIFT;
+        llSum = ( int64_t )AIA_FRONTEND_HPF_B0 * ( lInput + xFrontend.lHpfInput[ 1 ] ) +
+                ( int64_t )AIA_FRONTEND_HPF_B1 * xFrontend.lHpfInput[ 0 ] -
+                ( int64_t )AIA_FRONTEND_HPF_A1 * xFrontend.lHpfOutput[ 0 ] -
+                ( int64_t )AIA_FRONTEND_HPF_A2 * xFrontend.lHpfOutput[ 1 ];
+        lOutput = ( int32_t )( llSum >> 28 );
+
+        xFrontend.lHpfInput[ 1 ] = xFrontend.lHpfInput[ 0 ];
+        xFrontend.lHpfInput[ 0 ] = lInput;
+        xFrontend.lHpfOutput[ 1 ] = xFrontend.lHpfOutput[ 0 ];
+        xFrontend.lHpfOutput[ 0 ] = lOutput;
+
+        psFrame[ i ] = prvSaturate( ( lOutput + ( 1 << ( AIA_FRONTEND_HPF_SHIFT - 1 ) ) ) >> AIA_FRONTEND_HPF_SHIFT );
+    }
+}
+#endif
+
+#if ( aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION == 1 )
+/* A downward expander: frames at the noise floor are attenuated by the full amount, and frames that much above it
+ * or more are left as they are.
+ */
+static void prvNoiseSuppression( int16_t * psFrame )
+{
+    int32_t lLevel = prvFrameLevel( psFrame );
+    int32_t lAttenuation;
+    int32_t lGain;
+
+    if( lLevel < xFrontend.lNoiseFloor )
+    {
+        xFrontend.lNoiseFloor -= ( xFrontend.lNoiseFloor - lLevel ) >> AIA_FRONTEND_NOISE_FALL_SHIFT;
+    }
+    else
+    {
+        xFrontend.lNoiseFloor += AIA_FRONTEND_NOISE_RISE;
+    }
+
+    lAttenuation = AIA_FRONTEND_DB( aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB ) - ( lLevel - xFrontend.lNoiseFloor );
+    lAttenuation = ( lAttenuation < 0 ) ? 0 : ( lAttenuation > AIA_FRONTEND_DB( aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB ) ) ?
+                   AIA_FRONTEND_DB( aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB ) : lAttenuation;
+
+    /* Levels are powers, so the gain of the samples is half of it. */
+    lGain = prvExp2Q8( -lAttenuation / 2 );
+    prvApplyGain( psFrame, xFrontend.lNoiseGain, lGain );
+    xFrontend.lNoiseGain = lGain;
+}
+#endif
+
+#if ( aiaconfigCLIENT_FRONTEND_AGC == 1 )
+static void prvAgc( int16_t * psFrame )
+{
+    int32_t lLevel = prvFrameLevel( psFrame );
+    int32_t lTarget;
+    int32_t lPeak = 1;
+    int32_t lGain;
+
+    if( lLevel > AIA_FRONTEND_AGC_GATE )
+    {
+        if( lLevel > xFrontend.lAgcLevel )
+        {
+            xFrontend.lAgcLevel = lLevel;
+        }
+        else
+        {
+            xFrontend.lAgcLevel -= ( xFrontend.lAgcLevel - lLevel ) >> AIA_FRONTEND_AGC_RELEASE_SHIFT;
+        }
+    }
+
+    lTarget = AIA_FRONTEND_DBFS( aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS ) - xFrontend.lAgcLevel;
+    lTarget = ( lTarget < 0 ) ? 0 : ( lTarget > AIA_FRONTEND_DB( aiaconfigCLIENT_FRONTEND_AGC_MAX_GAIN_DB ) ) ?
+              AIA_FRONTEND_DB( aiaconfigCLIENT_FRONTEND_AGC_MAX_GAIN_DB ) : lTarget;
+
+    if( lTarget < xFrontend.lAgcGain || lTarget - xFrontend.lAgcGain <= AIA_FRONTEND_AGC_RISE )
+    {
+        xFrontend.lAgcGain = lTarget;
+    }
+    else
+    {
+        xFrontend.lAgcGain += AIA_FRONTEND_AGC_RISE;
+    }
+
+    /* Never push the loudest sample of the frame past full scale. */
+    for( uint32_t i = 0; i < AIA_FRONTEND_FRAME_SAMPLES; i++ )
+    {
+        int32_t lSample = ( psFrame[ i ] >= 0 ) ? psFrame[ i ] : -psFrame[ i ];
+
+        lPeak = ( lSample > lPeak ) ? lSample : lPeak;
+    }
+    lGain = prvExp2Q8( xFrontend.lAgcGain / 2 );
+    if( lPeak * lGain > ( INT16_MAX << AIA_FRONTEND_GAIN_SHIFT ) )
+    {
+        lGain = ( INT16_MAX << AIA_FRONTEND_GAIN_SHIFT ) / lPeak;
+    }
+
+    prvApplyGain( psFrame, xFrontend.lAgcAppliedGain, lGain );
+    xFrontend.lAgcAppliedGain = lGain;
+}
+#endif
+
+static AIAFrontendStageEntry_t xStages[ eAIAFrontendStageNum ] = {
+#if ( aiaconfigCLIENT_FRONTEND_DC_REMOVAL == 1 )
+    [ eAIAFrontendDcRemoval ] = { "DC removal", pdTRUE, prvDcRemoval },
+#else
+    [ eAIAFrontendDcRemoval ] = { "DC removal", pdFALSE, NULL },
+#endif
+#if ( aiaconfigCLIENT_FRONTEND_HIGH_PASS == 1 )
+    [ eAIAFrontendHighPass ] = { "High-pass", pdTRUE, prvHighPass },
+#else
+    [ eAIAFrontendHighPass ] = { "High-pass", pdFALSE, NULL },
+#endif
+#if ( aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION == 1 )
+    [ eAIAFrontendNoiseSuppression ] = { "Noise suppression", pdTRUE, prvNoiseSuppression },
+#else
+    [ eAIAFrontendNoiseSuppression ] = { "Noise suppression", pdFALSE, NULL },
+#endif
+#if ( aiaconfigCLIENT_FRONTEND_AGC == 1 )
+    [ eAIAFrontendAgc ] = { "AGC", pdTRUE, prvAgc },
+#else
+    [ eAIAFrontendAgc ] = { "AGC", pdFALSE, NULL },
+#endif
+};
+
+void vAIAFrontendInit( void )
+{
+    memset( &xFrontend, 0, sizeof( xFrontend ) );
+    xFrontend.lNoiseFloor = AIA_FRONTEND_NOISE_INITIAL;
+    xFrontend.lNoiseGain = AIA_FRONTEND_UNITY_GAIN;
+    xFrontend.lAgcLevel = AIA_FRONTEND_DBFS( aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS );
+    xFrontend.lAgcAppliedGain = AIA_FRONTEND_UNITY_GAIN;
+
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        xStages[ i ].xEnabled = xStages[ i ].xBuiltIn;
+    }
+    vAIAFrontendResetStatistics();
+}
+
+BaseType_t xAIAFrontendSetStage( AIAFrontendStage_t xStage, BaseType_t xEnabled )
+{
+    if( xStage >= eAIAFrontendStageNum || xStages[ xStage ].xBuiltIn != pdTRUE )
+    {
+        return pdFAIL;
+    }
+
+    xStages[ xStage ].xEnabled = xEnabled;
+
+    return pdPASS;
+}
+
+void vAIAFrontendProcess( int16_t * psFrame )
+{
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        if( xStages[ i ].xEnabled == pdTRUE )
+        {
+            vAIACycleMeterStart( &xStages[ i ].xMeter );
+            xStages[ i ].vProcess( psFrame );
+            vAIACycleMeterStop( &xStages[ i ].xMeter );
+        }
+    }
+}
+
+void vAIAFrontendGetStatistics( AIAFrontendStage_t xStage, AIAFrontendStatistics_t * pxStatistics )
+{
+    pxStatistics->pcName = xStages[ xStage ].pcName;
+    pxStatistics->xEnabled = xStages[ xStage ].xEnabled;
+    pxStatistics->ulCyclesAverage = ulAIACycleMeterAverage( &xStages[ xStage ].xMeter );
+    pxStatistics->ulCyclesMax = xStages[ xStage ].xMeter.ulMax;
+    pxStatistics->ulFrames = xStages[ xStage ].xMeter.ulCount;
+}
+
+void vAIAFrontendReport( void )
+{
+    AIAFrontendStatistics_t xStage;
+    uint32_t ulTotalCycles = 0;
+    uint32_t ulBudgetCycles = ( uint32_t )( ( uint64_t )configCPU_CLOCK_HZ * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS / 1000 );
+
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        vAIAFrontendGetStatistics( ( AIAFrontendStage_t )i, &xStage );
+        if( xStage.xEnabled == pdTRUE )
+        {
+            configPRINTF_DEBUG( ( "DEBUG: Front-end %s %u cycles per frame on average, %u max, over %u frames\r\n",
+                                  xStage.pcName, xStage.ulCyclesAverage, xStage.ulCyclesMax, xStage.ulFrames ) );
+            ulTotalCycles += xStage.ulCyclesMax;
+        }
+    }
+    configPRINTF_DEBUG( ( "DEBUG: Front-end %u cycles per frame at most, %u.%u%% of the frame\r\n", ulTotalCycles,
+                          ulTotalCycles * 100U / ulBudgetCycles, ulTotalCycles * 1000U / ulBudgetCycles % 10 ) );
+}
+
+void vAIAFrontendResetStatistics( void )
+{
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        vAIACycleMeterReset( &xStages[ i ].xMeter );
+    }
+}
+
+#endif /* aiaconfigCLIENT_FRONTEND == 1 */
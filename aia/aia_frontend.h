@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_FRONTEND_H_
+#define _AIA_FRONTEND_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "aia_client.h"
+
+/* The microphone front-end: a chain of stages run in place on each frame of AIA_MICROPHONE_RAW_FRAME_SAMPLES
+ * samples, between the capture and the microphone stream. A stage is built in with its aiaconfigCLIENT_FRONTEND_*
+ * option and can then be enabled or disabled at run time.
+ * - DC removal: a one-pole DC blocker at about 10Hz.
+ * - High-pass: a second-order Butterworth filter at 100Hz, against handling noise and mains hum.
+ * - Noise suppression: a broadband gain that pulls frames close to the noise floor down by up to
+ *   aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB.
+ * - AGC: a gain that brings speech to aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS, by up to
+ *   aiaconfigCLIENT_FRONTEND_AGC_MAX_GAIN_DB, without clipping.
+ */
+
+/**
+ * @brief                   Clear the state of the stages and enable those built in.
+ */
+void vAIAFrontendInit( void );
+
+/**
+ * @brief                   Enable or disable a stage.
+ *
+ * @param[in] xStage        The stage.
+ * @param[in] xEnabled      pdTRUE to run the stage, pdFALSE to skip it.
+ *
+ * @return                  pdPASS on success, and pdFAIL if the stage is not built in.
+ */
+BaseType_t xAIAFrontendSetStage( AIAFrontendStage_t xStage, BaseType_t xEnabled );
+
+/**
+ * @brief                   Run the enabled stages on a frame in place.
+ *
+ * @param[in,out] psFrame   The frame of AIA_MICROPHONE_RAW_FRAME_SAMPLES samples.
+ */
+void vAIAFrontendProcess( int16_t * psFrame );
+
+typedef struct {
+    const char * pcName;
+    BaseType_t xEnabled;
+    /* CPU cycles per frame, and the frames measured. */
+    uint32_t ulCyclesAverage;
+    uint32_t ulCyclesMax;
+    uint32_t ulFrames;
+} AIAFrontendStatistics_t;
+
+/**
+ * @brief                   Get the statistics of a stage since the last vAIAFrontendResetStatistics().
+ *
+ * @param[in] xStage        The stage.
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIAFrontendGetStatistics( AIAFrontendStage_t xStage, AIAFrontendStatistics_t * pxStatistics );
+
+/**
+ * @brief                   Print the statistics since the last vAIAFrontendResetStatistics() to the debug log.
+ */
+void vAIAFrontendReport( void );
+
+/**
+ * @brief                   Clear the statistics of all stages.
+ */
+void vAIAFrontendResetStatistics( void );
+
+#endif /* _AIA_FRONTEND_H_ */
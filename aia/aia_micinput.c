@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_micinput.h"
+
+#if ( AIA_MICROPHONE_CAPTURE_CONVERTED == 1 )
+
+#define AIA_MICINPUT_SAMPLES            ( AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES * aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS )
+/* The bits dropped from each sample. */
+#define AIA_MICINPUT_SHIFT              ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION - 16 )
+
+#if ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 16 ) && \
+    ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 24 ) && \
+    ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 32 )
+#error "The microphone can be captured with 16, 24 or 32-bit samples."
+#endif
+
+static struct {
+    /* Two frames, so that the DMA can be given the next one while the last one is converted. */
+    uint32_t ulFrame[ 2 ][ AIA_MICROPHONE_CAPTURE_FRAME_SIZE / sizeof( uint32_t ) ];
+    uint32_t ulIndex;
+    size_t xFrameBytes;
+
+    /* Where frames the capture has no room for are converted, to keep the state of the stages going. */
+    int16_t sScratch[ AIA_MICROPHONE_RAW_FRAME_SAMPLES ];
+
+    uint32_t ulDither;
+    AIACycleMeter_t xConversionMeter;
+} xMicInput;
+
+#if ( AIA_MICINPUT_SHIFT > 0 )
+
+/* Round to 16 bits with triangular dither of +/-1 LSB, from the two halves of a xorshift32 draw. psOutput may be
+ * the same as plInput, as each sample is read before a smaller one is written over it.
+ */
+static void prvConvert( const int32_t * plInput, int16_t * psOutput, size_t xSamples )
+{
+    uint32_t ulRandom = xMicInput.ulDither;
+    int32_t lDither;
+    int64_t llSample;
+
+    vAIACycleMeterStart( &xMicInput.xConversionMeter );
+
+    for( size_t i = 0; i < xSamples; i++ )
+    {
+        ulRandom ^= ulRandom << 13;
+        ulRandom ^= ulRandom >> 17;
+        ulRandom ^= ulRandom << 5;
+        lDither = ( int32_t )( ulRandom & ( ( 1UL << AIA_MICINPUT_SHIFT ) - 1 ) ) -
+                  ( int32_t )( ( ulRandom >> 16 ) & ( ( 1UL << AIA_MICINPUT_SHIFT ) - 1 ) );
+
+        llSample = ( ( int64_t )plInput[ i ] + lDither + ( 1L << ( AIA_MICINPUT_SHIFT - 1 ) ) ) >> AIA_MICINPUT_SHIFT;
+        psOutput[ i ] = ( int16_t )( ( llSample > INT16_MAX ) ? INT16_MAX : ( llSample < INT16_MIN ) ? INT16_MIN : llSample );
+    }
+
+    xMicInput.ulDither = ulRandom;
+
+    vAIACycleMeterStop( &xMicInput.xConversionMeter );
+}
+
+#endif
+
+static void prvFrameDone( BaseType_t * pxHigherPriorityTaskWoken )
+{
+    int16_t * psCapture = ( int16_t * )pvAIACaptureFrame();
+    int16_t * psFrame = ( int16_t * )xMicInput.ulFrame[ xMicInput.ulIndex ];
+    int16_t * psOutput = ( psCapture != NULL ) ? psCapture : xMicInput.sScratch;
+#if ( AIA_MICROPHONE_DECIMATION > 1 )
+    int16_t * psMono = psAIADecimatorInput();
+#else
+    int16_t * psMono = psOutput;
+#endif
+
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 )
+#if ( AIA_MICINPUT_SHIFT > 0 )
+    prvConvert( ( const int32_t * )psFrame, psFrame, AIA_MICINPUT_SAMPLES );
+#endif
+    vAIABeamformerProcess( psFrame, psMono );
+#elif ( AIA_MICINPUT_SHIFT > 0 )
+    prvConvert( ( const int32_t * )psFrame, psMono, AIA_MICINPUT_SAMPLES );
+#else
+    memcpy( psMono, psFrame, AIA_MICINPUT_SAMPLES * sizeof( int16_t ) );
+#endif
+
+#if ( AIA_MICROPHONE_DECIMATION > 1 )
+    vAIADecimatorProcess( psOutput );
+#endif
+
+    /* The capture counts the frame as dropped if it had no room for it. */
+    ( void )pvAIACaptureFrameDoneFromISR( pxHigherPriorityTaskWoken );
+    xMicInput.ulIndex ^= 1;
+}
+
+void vAIAMicInputInit( void )
+{
+    memset( &xMicInput, 0, sizeof( xMicInput ) );
+    xMicInput.ulDither = 0x12345678UL;
+
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS > 1 )
+    vAIABeamformerInit();
+#endif
+#if ( AIA_MICROPHONE_DECIMATION > 1 )
+    vAIADecimatorInit();
+#endif
+}
+
+void * pvAIAMicInputFrame( void )
+{
+    return xMicInput.ulFrame[ xMicInput.ulIndex ];
+}
+
+void * pvAIAMicInputFrameDoneFromISR( BaseType_t * pxHigherPriorityTaskWoken )
+{
+    prvFrameDone( pxHigherPriorityTaskWoken );
+
+    return xMicInput.ulFrame[ xMicInput.ulIndex ];
+}
+
+size_t xAIAMicInputWriteFromISR( const void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    const uint8_t * pucData = ( const uint8_t * )pvData;
+    size_t xCopied = 0;
+    size_t xLength;
+
+    while( xCopied < xSize )
+    {
+        xLength = AIA_MICROPHONE_CAPTURE_FRAME_SIZE - xMicInput.xFrameBytes;
+        if( xLength > xSize - xCopied )
+        {
+            xLength = xSize - xCopied;
+        }
+        memcpy( ( uint8_t * )xMicInput.ulFrame[ xMicInput.ulIndex ] + xMicInput.xFrameBytes, pucData + xCopied, xLength );
+        xMicInput.xFrameBytes += xLength;
+        xCopied += xLength;
+
+        if( xMicInput.xFrameBytes == AIA_MICROPHONE_CAPTURE_FRAME_SIZE )
+        {
+            xMicInput.xFrameBytes = 0;
+            prvFrameDone( pxHigherPriorityTaskWoken );
+        }
+    }
+
+    return xCopied;
+}
+
+void vAIAMicInputGetStatistics( AIAMicInputStatistics_t * pxStatistics )
+{
+    pxStatistics->ulConversionCyclesAverage = ulAIACycleMeterAverage( &xMicInput.xConversionMeter );
+    pxStatistics->ulConversionCyclesMax = xMicInput.xConversionMeter.ulMax;
+    pxStatistics->ulFrames = xMicInput.xConversionMeter.ulCount;
+}
+
+void vAIAMicInputReport( void )
+{
+    AIAMicInputStatistics_t xMicInput;
+
+    vAIAMicInputGetStatistics( &xMicInput );
+    configPRINTF_DEBUG( ( "DEBUG: %u-bit to 16-bit conversion %u cycles per frame on average, %u max, over %u frames\r\n",
+                          ( uint32_t )aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION, xMicInput.ulConversionCyclesAverage,
+                          xMicInput.ulConversionCyclesMax, xMicInput.ulFrames ) );
+}
+
+#endif /* AIA_MICROPHONE_CAPTURE_CONVERTED == 1 */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_MICINPUT_H_
+#define _AIA_MICINPUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* The conversion of what the platform microphone captures to the raw format of the microphone stream, for platforms
+ * whose microphone does not capture that format already: several channels, a higher rate or more bits per sample.
+ *
+ * The platform microphone DMA writes one frame of AIA_MICROPHONE_CAPTURE_FRAME_SIZE bytes at a time to the address
+ * given by pvAIAMicInputFrame(). When a frame is complete, the ISR calls pvAIAMicInputFrameDoneFromISR(), which
+ * converts it straight into the capture slot, see aia_capture.h, and returns where the next frame is to be written.
+ * The frame goes through, as configured:
+ * - the conversion of 24 or 32-bit samples to 16 bits, with triangular dither,
+ * - the beamformer of the channels, see aia_beamformer.h,
+ * - the decimator to the raw rate, see aia_decimator.h.
+ */
+
+/**
+ * @brief                   Clear the state of the stages.
+ */
+void vAIAMicInputInit( void );
+
+/**
+ * @brief                   Get where the next captured frame is to be written.
+ *
+ * @return                  The address of the frame.
+ */
+void * pvAIAMicInputFrame( void );
+
+/**
+ * @brief                   Convert the frame returned by pvAIAMicInputFrame() and hand it to the capture. Call this from
+ *                          interrupt only.
+ *
+ * @param[out] pxHigherPriorityTaskWoken    Set to pdTRUE if the microphone task has been woken up.
+ *
+ * @return                  The address the next frame is to be written to.
+ */
+void * pvAIAMicInputFrameDoneFromISR( BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief                   Copy captured audio, for platforms whose DMA cannot write to the frames. Call this from
+ *                          interrupt or with interrupts masked.
+ *
+ * @param[in] pvData        The audio, in the format captured.
+ * @param[in] xSize         The length of the audio in bytes.
+ * @param[out] pxHigherPriorityTaskWoken    Set to pdTRUE if the microphone task has been woken up.
+ *
+ * @return                  The number of bytes copied, i.e. xSize. Frames the capture has no room for are dropped.
+ */
+size_t xAIAMicInputWriteFromISR( const void * pvData, size_t xSize, BaseType_t * pxHigherPriorityTaskWoken );
+
+typedef struct {
+    /* CPU cycles per frame to convert the samples to 16 bits. */
+    uint32_t ulConversionCyclesAverage;
+    uint32_t ulConversionCyclesMax;
+    uint32_t ulFrames;
+} AIAMicInputStatistics_t;
+
+/**
+ * @brief                   Get the statistics since vAIAMicInputInit().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIAMicInputGetStatistics( AIAMicInputStatistics_t * pxStatistics );
+
+/**
+ * @brief                   Print the statistics since vAIAMicInputInit() to the debug log.
+ */
+void vAIAMicInputReport( void );
+
+#endif /* _AIA_MICINPUT_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include "aia_offsetsched.h"
+
+/* Whether action A is to be taken before action B. The order wraps around, so it is compared by its difference. */
+static BaseType_t prvBefore( const AIAOffsetAction_t * pxA, const AIAOffsetAction_t * pxB )
+{
+    if( pxA->ullOffset != pxB->ullOffset )
+    {
+        return ( pxA->ullOffset < pxB->ullOffset ) ? pdTRUE : pdFALSE;
+    }
+
+    return ( ( int32_t )( pxA->ulOrder - pxB->ulOrder ) < 0 ) ? pdTRUE : pdFALSE;
+}
+
+static void prvSwap( AIAOffsetAction_t * pxA, AIAOffsetAction_t * pxB )
+{
+    AIAOffsetAction_t xTemp = *pxA;
+
+    *pxA = *pxB;
+    *pxB = xTemp;
+}
+
+void vAIAOffsetSchedInit( AIAOffsetScheduler_t * pxScheduler, AIAOffsetAction_t * pxStorage, uint32_t ulCapacity )
+{
+    pxScheduler->pxHeap = pxStorage;
+    pxScheduler->ulCapacity = ulCapacity;
+    pxScheduler->ulCount = 0;
+    pxScheduler->ulNextOrder = 0;
+}
+
+BaseType_t xAIAOffsetSchedAdd( AIAOffsetScheduler_t * pxScheduler, uint64_t ullOffset, uint32_t ulAction, uint32_t ulValue )
+{
+    AIAOffsetAction_t * pxHeap = pxScheduler->pxHeap;
+    uint32_t ulIndex;
+
+    if( pxScheduler->ulCount >= pxScheduler->ulCapacity )
+    {
+        return pdFAIL;
+    }
+
+    ulIndex = pxScheduler->ulCount++;
+    pxHeap[ ulIndex ].ullOffset = ullOffset;
+    pxHeap[ ulIndex ].ulAction = ulAction;
+    pxHeap[ ulIndex ].ulValue = ulValue;
+    pxHeap[ ulIndex ].ulOrder = pxScheduler->ulNextOrder++;
+
+    /* Sift up. */
+    while( ulIndex > 0 && prvBefore( &pxHeap[ ulIndex ], &pxHeap[ ( ulIndex - 1 ) / 2 ] ) == pdTRUE )
+    {
+        prvSwap( &pxHeap[ ulIndex ], &pxHeap[ ( ulIndex - 1 ) / 2 ] );
+        ulIndex = ( ulIndex - 1 ) / 2;
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xAIAOffsetSchedTake( AIAOffsetScheduler_t * pxScheduler, uint64_t ullOffset, AIAOffsetAction_t * pxAction )
+{
+    AIAOffsetAction_t * pxHeap = pxScheduler->pxHeap;
+    uint32_t ulIndex = 0;
+
+    if( pxScheduler->ulCount == 0 || pxHeap[ 0 ].ullOffset > ullOffset )
+    {
+        return pdFALSE;
+    }
+
+    *pxAction = pxHeap[ 0 ];
+    pxHeap[ 0 ] = pxHeap[ --pxScheduler->ulCount ];
+
+    /* Sift down. */
+    for( ; ; )
+    {
+        uint32_t ulFirst = ulIndex;
+        uint32_t ulLeft = 2 * ulIndex + 1;
+        uint32_t ulRight = ulLeft + 1;
+
+        if( ulLeft < pxScheduler->ulCount && prvBefore( &pxHeap[ ulLeft ], &pxHeap[ ulFirst ] ) == pdTRUE )
+        {
+            ulFirst = ulLeft;
+        }
+        if( ulRight < pxScheduler->ulCount && prvBefore( &pxHeap[ ulRight ], &pxHeap[ ulFirst ] ) == pdTRUE )
+        {
+            ulFirst = ulRight;
+        }
+        if( ulFirst == ulIndex )
+        {
+            break;
+        }
+        prvSwap( &pxHeap[ ulIndex ], &pxHeap[ ulFirst ] );
+        ulIndex = ulFirst;
+    }
+
+    return pdTRUE;
+}
+
+uint32_t ulAIAOffsetSchedCount( const AIAOffsetScheduler_t * pxScheduler )
+{
+    return pxScheduler->ulCount;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _AIA_OFFSETSCHED_H_
+#define _AIA_OFFSETSCHED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A scheduler of actions keyed on the offset of the speaker stream, for directives that take effect when playback
+ * reaches an offset. The actions are kept in a binary heap ordered by offset, and actions at the same offset in the
+ * order they were added. Adding one takes O(log n). The speaker task asks for the actions due as it plays each
+ * frame, which takes O(1) when none is, i.e. nearly always, and O(log n) per action taken. The offsets are given by
+ * the caller, so the scheduler runs as well against a virtual playback clock. The caller serializes the calls.
+ */
+
+typedef struct {
+    uint64_t ullOffset;
+    /* What to do and with what, as defined by the caller. */
+    uint32_t ulAction;
+    uint32_t ulValue;
+    /* Orders actions at the same offset. */
+    uint32_t ulOrder;
+} AIAOffsetAction_t;
+
+typedef struct {
+    AIAOffsetAction_t * pxHeap;
+    uint32_t ulCapacity;
+    uint32_t ulCount;
+    uint32_t ulNextOrder;
+} AIAOffsetScheduler_t;
+
+/**
+ * @brief                           Set up an empty scheduler.
+ *
+ * @param[out] pxScheduler          The scheduler.
+ * @param[in] pxStorage             Room for the actions.
+ * @param[in] ulCapacity            The number of actions pxStorage can hold.
+ */
+void vAIAOffsetSchedInit( AIAOffsetScheduler_t * pxScheduler, AIAOffsetAction_t * pxStorage, uint32_t ulCapacity );
+
+/**
+ * @brief                           Add an action to take when playback reaches an offset.
+ *
+ * @param[in] pxScheduler           The scheduler.
+ * @param[in] ullOffset             The offset.
+ * @param[in] ulAction              The action.
+ * @param[in] ulValue               The value of the action.
+ *
+ * @return                          pdPASS on success, pdFAIL if the scheduler is full.
+ */
+BaseType_t xAIAOffsetSchedAdd( AIAOffsetScheduler_t * pxScheduler, uint64_t ullOffset, uint32_t ulAction, uint32_t ulValue );
+
+/**
+ * @brief                           Take the next action due once playback has reached an offset.
+ *
+ * Call this until it returns pdFALSE to take every action due, in order.
+ *
+ * @param[in] pxScheduler           The scheduler.
+ * @param[in] ullOffset             The offset reached. An action is due if its offset is not above it.
+ * @param[out] pxAction             The action.
+ *
+ * @return                          pdTRUE if an action has been taken.
+ */
+BaseType_t xAIAOffsetSchedTake( AIAOffsetScheduler_t * pxScheduler, uint64_t ullOffset, AIAOffsetAction_t * pxAction );
+
+/**
+ * @brief                           Get the number of actions waiting.
+ *
+ * @param[in] pxScheduler           The scheduler.
+ *
+ * @return                          The number of actions.
+ */
+uint32_t ulAIAOffsetSchedCount( const AIAOffsetScheduler_t * pxScheduler );
+
+#endif /* _AIA_OFFSETSCHED_H_ */
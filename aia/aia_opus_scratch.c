@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_opus_scratch.h"
+#include "aia_client_config.h"
+
+/* Opus takes GLOBAL_STACK_SIZE bytes of pseudo-stack from the arena, and does not know how large the arena is. */
+#if defined( NONTHREADSAFE_PSEUDOSTACK )
+#if !defined( GLOBAL_STACK_SIZE )
+#error "Define GLOBAL_STACK_SIZE as aiaconfigCLIENT_DECODER_SCRATCH_SIZE in the DEFINES of the project"
+#elif ( GLOBAL_STACK_SIZE != aiaconfigCLIENT_DECODER_SCRATCH_SIZE )
+#error "GLOBAL_STACK_SIZE in the DEFINES of the project must equal aiaconfigCLIENT_DECODER_SCRATCH_SIZE (24576 with the Opus microphone encoder, else 12288)"
+#endif
+#endif
+
+#define AIA_OPUS_SCRATCH_FILL_BYTE      ( 0xA5U )
+#define AIA_OPUS_SCRATCH_GUARD_WORD     ( 0xDEADBEEFUL )
+
+/* The pseudo-stack grows upwards from the start of the arena. A guard word is placed
+ * right after it to catch an overflow, as Opus does not check the pseudo-stack bound
+ * on every allocation.
+ */
+static struct {
+    uint8_t ucArena[ aiaconfigCLIENT_DECODER_SCRATCH_SIZE ];
+    uint32_t ulGuard;
+} xScratch __attribute__((aligned(8)));
+
+void vAIAOpusScratchInit( void )
+{
+    memset( xScratch.ucArena, AIA_OPUS_SCRATCH_FILL_BYTE, sizeof( xScratch.ucArena ) );
+    xScratch.ulGuard = AIA_OPUS_SCRATCH_GUARD_WORD;
+}
+
+void * pvAIAOpusScratchAlloc( size_t xSize )
+{
+    /* GLOBAL_STACK_SIZE given to Opus must not be larger than the arena. */
+    configASSERT( xSize <= sizeof( xScratch.ucArena ) );
+
+    return xScratch.ucArena;
+}
+
+size_t xAIAOpusScratchHighWaterMark( void )
+{
+    size_t xUnused = 0;
+
+    /* As the pseudo-stack grows upwards, count the untouched bytes from the end of the arena. */
+    while( xUnused < sizeof( xScratch.ucArena ) &&
+            xScratch.ucArena[ sizeof( xScratch.ucArena ) - 1 - xUnused ] == AIA_OPUS_SCRATCH_FILL_BYTE )
+    {
+        xUnused++;
+    }
+
+    return xUnused;
+}
+
+BaseType_t xAIAOpusScratchIsIntact( void )
+{
+    return ( xScratch.ulGuard == AIA_OPUS_SCRATCH_GUARD_WORD ) ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_OPUS_SCRATCH_H_
+#define _AIA_OPUS_SCRATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/**
+ * @brief                   Initialize the Opus scratch arena.
+ *
+ * The arena is filled with a known pattern so that its high water mark can be measured later. This must be
+ * called before the first opus_decode() call.
+ */
+void vAIAOpusScratchInit( void );
+
+/**
+ * @brief                   Hand the scratch arena to Opus.
+ *
+ * Opus is built with NONTHREADSAFE_PSEUDOSTACK and CUSTOM_SUPPORT, and custom_support.h maps opus_alloc_scratch()
+ * to this function. Opus calls it only once, the first time it needs temporary memory, and then manages the arena
+ * as a pseudo-stack itself. As the pseudo-stack is not thread safe, calls into Opus from different tasks must be
+ * serialized.
+ *
+ * @param[in] xSize         The size of the pseudo-stack requested by Opus, i.e. GLOBAL_STACK_SIZE.
+ *
+ * @return                  Pointer to the arena.
+ */
+void * pvAIAOpusScratchAlloc( size_t xSize );
+
+/**
+ * @brief                   Return the minimum amount of scratch memory that has remained unused so far.
+ *
+ * This has the same semantics as uxTaskGetStackHighWaterMark(), except that the value is in bytes.
+ *
+ * @return                  The number of bytes of the arena that have never been touched.
+ */
+size_t xAIAOpusScratchHighWaterMark( void );
+
+/**
+ * @brief                   Check that Opus has not run past the end of the scratch arena.
+ *
+ * @return                  `pdTRUE` if the guard word at the end of the arena is intact; `pdFALSE` otherwise.
+ */
+BaseType_t xAIAOpusScratchIsIntact( void );
+
+#endif /* _AIA_OPUS_SCRATCH_H_ */
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "aia_outbound.h"
+#include "aia_client.h"
+#include "aia_client_config.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+static struct {
+    QueueHandle_t xQueue[ eAIAOutboundQueueNum ];
+    /* Counts the messages in both queues. */
+    SemaphoreHandle_t xPending;
+    TaskHandle_t xTask;
+    AIAOutboundPublish_t xPublish;
+    AIAOutboundBackpressureCallback_t xBackpressureCallback;
+    BaseType_t xCongested;
+    /* Events waiting in the audio queue. Events queued meanwhile join them there to keep their order. */
+    UBaseType_t uxAudioEvents;
+    /* Bytes that may still be published in the current interval. Events may take it below zero. */
+    int32_t lBudget;
+    TickType_t xIntervalStart;
+} xOutbound;
+
+static const UBaseType_t uxQueueLength[ eAIAOutboundQueueNum ] = {
+    aiaconfigAIA_OUTBOUND_CONTROL_QUEUE_LENGTH,
+    aiaconfigAIA_OUTBOUND_AUDIO_QUEUE_LENGTH,
+};
+
+static void prvRefillBudget( void )
+{
+    TickType_t xElapsed = xTaskGetTickCount() - xOutbound.xIntervalStart;
+
+    if( xElapsed >= aiaconfigAIA_OUTBOUND_INTERVAL )
+    {
+        xOutbound.xIntervalStart += xElapsed - ( xElapsed % aiaconfigAIA_OUTBOUND_INTERVAL );
+        /* Carry over what events have overspent, but not what was left unused. */
+        xOutbound.lBudget = ( xOutbound.lBudget < 0 ? xOutbound.lBudget : 0 ) + aiaconfigAIA_OUTBOUND_BYTES_PER_INTERVAL;
+    }
+}
+
+static void prvUpdateBackpressure( void )
+{
+    BaseType_t xCongested = xOutbound.xCongested;
+
+    /* MicrophoneOpened is queued right before the first audio of an utterance, which must not make it look congested. */
+    if( uxQueueSpacesAvailable( xOutbound.xQueue[ eAIAOutboundAudio ] ) == 0 && xOutbound.uxAudioEvents == 0 )
+    {
+        xCongested = pdTRUE;
+    }
+    else if( uxQueueMessagesWaiting( xOutbound.xQueue[ eAIAOutboundAudio ] ) == 0 )
+    {
+        xCongested = pdFALSE;
+    }
+
+    if( xCongested != xOutbound.xCongested )
+    {
+        xOutbound.xCongested = xCongested;
+        configPRINTF_DEBUG( ( "DEBUG: Outbound audio queue is %s\r\n", xCongested == pdTRUE ? "congested" : "drained" ) );
+        if( xOutbound.xBackpressureCallback != NULL )
+        {
+            xOutbound.xBackpressureCallback( xCongested );
+        }
+    }
+}
+
+/* Take the next message to publish. Events go first. Audio goes only while there is budget left. */
+static BaseType_t prvNextMessage( AIAOutboundMessage_t * pxMessage )
+{
+    for( ;; )
+    {
+        prvRefillBudget();
+        prvUpdateBackpressure();
+
+        if( xQueueReceive( xOutbound.xQueue[ eAIAOutboundControl ], pxMessage, 0 ) == pdPASS )
+        {
+            return pdPASS;
+        }
+
+        if( xQueuePeek( xOutbound.xQueue[ eAIAOutboundAudio ], pxMessage, 0 ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+
+        if( pxMessage->xEvent == pdTRUE )
+        {
+            taskENTER_CRITICAL();
+            xOutbound.uxAudioEvents--;
+            taskEXIT_CRITICAL();
+            return xQueueReceive( xOutbound.xQueue[ eAIAOutboundAudio ], pxMessage, 0 );
+        }
+
+        if( xOutbound.lBudget > 0 )
+        {
+            return xQueueReceive( xOutbound.xQueue[ eAIAOutboundAudio ], pxMessage, 0 );
+        }
+
+        /* Out of budget. Wait for the next interval, but let an event through as soon as it is queued. */
+        xQueuePeek( xOutbound.xQueue[ eAIAOutboundControl ],
+                    pxMessage,
+                    aiaconfigAIA_OUTBOUND_INTERVAL - ( xTaskGetTickCount() - xOutbound.xIntervalStart ) );
+    }
+}
+
+static void prvAIAOutboundTask( void * pvParameters )
+{
+    AIAOutboundMessage_t xMessage;
+
+    for( ;; )
+    {
+        xSemaphoreTake( xOutbound.xPending, portMAX_DELAY );
+
+        if( prvNextMessage( &xMessage ) != pdPASS )
+        {
+            continue;
+        }
+
+        xOutbound.lBudget -= AIA_MSG_ENCRYPTED_LENGTH( xMessage.ulLength );
+        if( xOutbound.xPublish( &xMessage ) == pdPASS && xMessage.xPublished != NULL )
+        {
+            xSemaphoreGive( xMessage.xPublished );
+        }
+        xMessage.vRelease( xMessage.pvBuffer );
+    }
+}
+
+BaseType_t xAIAOutboundInit( AIAOutboundPublish_t xPublish )
+{
+    BaseType_t xReturned;
+
+    memset( &xOutbound, 0, sizeof( xOutbound ) );
+    xOutbound.xPublish = xPublish;
+    xOutbound.xIntervalStart = xTaskGetTickCount();
+    xOutbound.lBudget = aiaconfigAIA_OUTBOUND_BYTES_PER_INTERVAL;
+
+    for( int i = 0; i < eAIAOutboundQueueNum; i++ )
+    {
+        xOutbound.xQueue[ i ] = xQueueCreate( uxQueueLength[ i ], sizeof( AIAOutboundMessage_t ) );
+        if( xOutbound.xQueue[ i ] == NULL )
+        {
+            return pdFAIL;
+        }
+    }
+
+    xOutbound.xPending = xSemaphoreCreateCounting( aiaconfigAIA_OUTBOUND_CONTROL_QUEUE_LENGTH + aiaconfigAIA_OUTBOUND_AUDIO_QUEUE_LENGTH, 0 );
+    if( xOutbound.xPending == NULL )
+    {
+        return pdFAIL;
+    }
+
+    xReturned = xTaskCreate( prvAIAOutboundTask,
+                             "AIA_Outbound",
+                             aiaconfigAIA_OUTBOUND_TASK_STACK_SIZE,
+                             NULL,
+                             aiaconfigAIA_OUTBOUND_TASK_PRIORITY,
+                             &xOutbound.xTask );
+
+    return xReturned;
+}
+
+void vAIAOutboundSetBackpressureCallback( AIAOutboundBackpressureCallback_t xCallback )
+{
+    xOutbound.xBackpressureCallback = xCallback;
+}
+
+BaseType_t xAIAOutboundSend( AIAOutboundQueue_t xQueue, const AIAOutboundMessage_t * pxMessage, TickType_t xTicksToWait )
+{
+    if( pxMessage->xEvent == pdTRUE )
+    {
+        taskENTER_CRITICAL();
+        if( xOutbound.uxAudioEvents > 0 )
+        {
+            xQueue = eAIAOutboundAudio;
+        }
+        if( xQueue == eAIAOutboundAudio )
+        {
+            xOutbound.uxAudioEvents++;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if( xQueueSend( xOutbound.xQueue[ xQueue ], pxMessage, xTicksToWait ) != pdPASS )
+    {
+        configPRINTF( ( "Outbound %s queue is full!\r\n", xQueue == eAIAOutboundAudio ? "audio" : "control" ) );
+        if( pxMessage->xEvent == pdTRUE && xQueue == eAIAOutboundAudio )
+        {
+            taskENTER_CRITICAL();
+            xOutbound.uxAudioEvents--;
+            taskEXIT_CRITICAL();
+        }
+        return pdFAIL;
+    }
+
+    xSemaphoreGive( xOutbound.xPending );
+
+    return pdPASS;
+}
+
+void vAIAOutboundCleanup( void )
+{
+    AIAOutboundMessage_t xMessage;
+
+    if( xOutbound.xTask != NULL )
+    {
+        vTaskDelete( xOutbound.xTask );
+        xOutbound.xTask = NULL;
+    }
+
+    for( int i = 0; i < eAIAOutboundQueueNum; i++ )
+    {
+        if( xOutbound.xQueue[ i ] != NULL )
+        {
+            while( xQueueReceive( xOutbound.xQueue[ i ], &xMessage, 0 ) == pdPASS )
+            {
+                xMessage.vRelease( xMessage.pvBuffer );
+            }
+            vQueueDelete( xOutbound.xQueue[ i ] );
+            xOutbound.xQueue[ i ] = NULL;
+        }
+    }
+
+    if( xOutbound.xPending != NULL )
+    {
+        vSemaphoreDelete( xOutbound.xPending );
+        xOutbound.xPending = NULL;
+    }
+}
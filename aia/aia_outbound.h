@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_OUTBOUND_H_
+#define _AIA_OUTBOUND_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* All encrypted messages of the client are published by a single outbound task, from two queues:
+ *
+ * - eAIAOutboundControl carries events. It always goes first.
+ * - eAIAOutboundAudio carries microphone audio, plus the MicrophoneOpened and MicrophoneClosed events, so that
+ *   they stay in order with the audio stream. MicrophoneOpened is therefore always published before the first
+ *   audio chunk it announces, and MicrophoneClosed after the last one it accounts for. Audio of this queue is only
+ *   published while there is byte budget left in the current interval. An event reaching the head of the queue is
+ *   published at once, like those of eAIAOutboundControl.
+ *
+ * Events are published in the order they are queued: an event queued for eAIAOutboundControl while an event is
+ * still waiting in eAIAOutboundAudio goes into eAIAOutboundAudio behind it, rather than overtake it.
+ *
+ * The sequence number of a message is taken when it is actually published, as messages of one topic may be
+ * queued in both queues.
+ */
+typedef enum
+{
+    eAIAOutboundControl = 0,
+    eAIAOutboundAudio,
+    eAIAOutboundQueueNum,
+} AIAOutboundQueue_t;
+
+typedef struct {
+    const char * pcTopic;
+    /* The plaintext, with AIA_MSG_PARAMS_SIZE_SEQ bytes available preceding it. */
+    void * pvPlaintext;
+    uint32_t ulLength;
+    /* The sequence counter of the topic, advanced once the message is published. */
+    uint32_t * pulSequence;
+    /* The buffer holding the plaintext, given to vRelease() once the message has been published or dropped. */
+    void * pvBuffer;
+    void ( * vRelease )( void * pvBuffer );
+    /* pdTRUE for an event, pdFALSE for audio. */
+    BaseType_t xEvent;
+    /* If not NULL, given once the message has been published. It is not given if publishing fails or the message
+     * is dropped.
+     */
+    SemaphoreHandle_t xPublished;
+} AIAOutboundMessage_t;
+
+/* Called by the outbound task to publish a message. */
+typedef BaseType_t ( * AIAOutboundPublish_t )( const AIAOutboundMessage_t * pxMessage );
+
+/* Called by the outbound task when the audio queue gets full (pdTRUE) and when it has been drained (pdFALSE). */
+typedef void ( * AIAOutboundBackpressureCallback_t )( BaseType_t xCongested );
+
+/**
+ * @brief                   Create the outbound queues and task.
+ *
+ * @param[in] xPublish      The function publishing a message.
+ *
+ * @return                  pdPASS on success and pdFAIL on failure.
+ */
+BaseType_t xAIAOutboundInit( AIAOutboundPublish_t xPublish );
+
+/**
+ * @brief                   Register the callback for backpressure on the audio queue. Only one is supported.
+ *
+ * @param[in] xCallback     The callback, or NULL to remove it.
+ */
+void vAIAOutboundSetBackpressureCallback( AIAOutboundBackpressureCallback_t xCallback );
+
+/**
+ * @brief                   Queue a message for publishing.
+ *
+ * The message is copied to the queue. On success the ownership of pvBuffer is passed to the outbound task. pdPASS
+ * only means that the message is queued; a caller that needs to know it was published sets xPublished.
+ *
+ * @param[in] xQueue        The queue to put the message into.
+ * @param[in] pxMessage     The message.
+ * @param[in] xTicksToWait  The maximum time to wait for space in the queue.
+ *
+ * @return                  pdPASS on success and pdFAIL if the queue is still full after xTicksToWait.
+ */
+BaseType_t xAIAOutboundSend( AIAOutboundQueue_t xQueue, const AIAOutboundMessage_t * pxMessage, TickType_t xTicksToWait );
+
+/**
+ * @brief                   Delete the outbound task and queues. Messages still queued are released unpublished.
+ */
+void vAIAOutboundCleanup( void );
+
+#endif /* _AIA_OUTBOUND_H_ */
@@ -73,6 +73,10 @@ void vPlatformLEDBlink( uint32_t interval_ms );
 
 /**
  * @brief The function that opens microphone for voice capture.
+ *
+ * The platform either copies captured audio to the client with xClientFillMicrophoneBufferFromISR(), or, to avoid
+ * the copy, lets the microphone DMA write each frame to the address given by pvClientMicrophoneFrame() and
+ * pvClientMicrophoneFrameCapturedFromISR().
  */
 void vPlatformMicrophoneOpen( void );
 
@@ -101,4 +105,11 @@ void vPlatformTouchButtonEnable( void );
  */
 void vPlatformTouchButtonDisable( void );
 
+/**
+ * @brief The function that returns a free-running CPU cycle counter, used to benchmark the audio path.
+ *
+ * @return The current cycle count. The counter wraps around at 2^32.
+ */
+uint32_t ulPlatformGetCycleCount( void );
+
 #endif /* _AIA_PLATFORM_H_ */
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include <string.h>
+
+#include "aia_playclock.h"
+
+/* Whether the position has been played. Positions wrap around, so they are compared by their difference. */
+static BaseType_t prvPlayed( const AIAPlayclock_t * pxPlayclock, uint32_t ulPosition )
+{
+    return ( ( int32_t )( pxPlayclock->ulPlayed - ulPosition ) >= 0 ) ? pdTRUE : pdFALSE;
+}
+
+static BaseType_t prvDue( const AIAPlayclock_t * pxPlayclock )
+{
+    if( pxPlayclock->ulEventTail == pxPlayclock->ulEventHead )
+    {
+        return pdFALSE;
+    }
+
+    return prvPlayed( pxPlayclock, pxPlayclock->xEvents[ pxPlayclock->ulEventTail % AIA_PLAYCLOCK_EVENTS ].ulPosition );
+}
+
+void vAIAPlayclockInit( AIAPlayclock_t * pxPlayclock, uint32_t ulRawFrameSize, uint32_t ulEncodedFrameSize )
+{
+    memset( pxPlayclock, 0, sizeof( *pxPlayclock ) );
+    pxPlayclock->ulRawFrameSize = ulRawFrameSize;
+    pxPlayclock->ulEncodedFrameSize = ulEncodedFrameSize;
+}
+
+void vAIAPlayclockStart( AIAPlayclock_t * pxPlayclock, uint64_t ullOffset )
+{
+    pxPlayclock->ulWritten = 0;
+    pxPlayclock->ulPlayed = 0;
+    pxPlayclock->ulReading = 0;
+    pxPlayclock->ullNextOffset = ullOffset;
+    for( uint32_t i = 0; i < AIA_PLAYCLOCK_ANCHORS; i++ )
+    {
+        pxPlayclock->xAnchors[ i ].ulPosition = 0;
+        pxPlayclock->xAnchors[ i ].ullOffset = ullOffset;
+    }
+    pxPlayclock->ulAnchorIndex = 0;
+    pxPlayclock->ulEventTail = pxPlayclock->ulEventHead;
+    pxPlayclock->xDueSignalled = pdFALSE;
+    pxPlayclock->xRunning = pdTRUE;
+}
+
+void vAIAPlayclockStop( AIAPlayclock_t * pxPlayclock )
+{
+    pxPlayclock->xRunning = pdFALSE;
+    pxPlayclock->ulEventTail = pxPlayclock->ulEventHead;
+    pxPlayclock->xDueSignalled = pdFALSE;
+}
+
+void vAIAPlayclockWrite( AIAPlayclock_t * pxPlayclock, uint64_t ullOffset )
+{
+    if( ullOffset != pxPlayclock->ullNextOffset )
+    {
+        pxPlayclock->ulAnchorIndex = ( pxPlayclock->ulAnchorIndex + 1 ) % AIA_PLAYCLOCK_ANCHORS;
+        pxPlayclock->xAnchors[ pxPlayclock->ulAnchorIndex ].ulPosition = pxPlayclock->ulWritten;
+        pxPlayclock->xAnchors[ pxPlayclock->ulAnchorIndex ].ullOffset = ullOffset;
+    }
+    pxPlayclock->ulWritten += pxPlayclock->ulRawFrameSize;
+    pxPlayclock->ullNextOffset = ullOffset + pxPlayclock->ulEncodedFrameSize;
+}
+
+BaseType_t xAIAPlayclockPlayedFromISR( AIAPlayclock_t * pxPlayclock, uint32_t ulBytes )
+{
+    if( pxPlayclock->xRunning != pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+    /* What was read last time has been played out by now. */
+    pxPlayclock->ulPlayed += pxPlayclock->ulReading;
+    pxPlayclock->ulReading = ulBytes;
+
+    if( pxPlayclock->xDueSignalled == pdTRUE || prvDue( pxPlayclock ) != pdTRUE )
+    {
+        return pdFALSE;
+    }
+    pxPlayclock->xDueSignalled = pdTRUE;
+
+    return pdTRUE;
+}
+
+BaseType_t xAIAPlayclockSchedule( AIAPlayclock_t * pxPlayclock, AIAPlayclockEventType_t xType, uint32_t ulValue )
+{
+    AIAPlayclockEvent_t * pxEvent;
+
+    if( pxPlayclock->xRunning != pdTRUE ||
+        pxPlayclock->ulEventHead - pxPlayclock->ulEventTail >= AIA_PLAYCLOCK_EVENTS )
+    {
+        return pdFAIL;
+    }
+
+    pxEvent = &pxPlayclock->xEvents[ pxPlayclock->ulEventHead % AIA_PLAYCLOCK_EVENTS ];
+    pxEvent->ulPosition = pxPlayclock->ulWritten;
+    pxEvent->xType = xType;
+    pxEvent->ulValue = ulValue;
+    pxPlayclock->ulEventHead++;
+
+    return pdPASS;
+}
+
+BaseType_t xAIAPlayclockTakeDue( AIAPlayclock_t * pxPlayclock, AIAPlayclockEvent_t * pxEvent )
+{
+    pxPlayclock->xDueSignalled = pdFALSE;
+    if( prvDue( pxPlayclock ) != pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+    *pxEvent = pxPlayclock->xEvents[ pxPlayclock->ulEventTail % AIA_PLAYCLOCK_EVENTS ];
+    pxPlayclock->ulEventTail++;
+
+    return pdTRUE;
+}
+
+uint64_t ullAIAPlayclockOffset( const AIAPlayclock_t * pxPlayclock )
+{
+    uint32_t ulPlayed = pxPlayclock->ulPlayed;
+    const AIAPlayclockAnchor_t * pxAnchor = &pxPlayclock->xAnchors[ pxPlayclock->ulAnchorIndex ];
+
+    /* Find the last jump in the offsets played through. The oldest anchor is taken if they all lie ahead. */
+    for( uint32_t i = 1; i < AIA_PLAYCLOCK_ANCHORS && ( int32_t )( ulPlayed - pxAnchor->ulPosition ) < 0; i++ )
+    {
+        pxAnchor = &pxPlayclock->xAnchors[ ( pxPlayclock->ulAnchorIndex + AIA_PLAYCLOCK_ANCHORS - i ) % AIA_PLAYCLOCK_ANCHORS ];
+    }
+    if( ( int32_t )( ulPlayed - pxAnchor->ulPosition ) < 0 )
+    {
+        return pxAnchor->ullOffset;
+    }
+
+    return pxAnchor->ullOffset + ( uint64_t )( ulPlayed - pxAnchor->ulPosition ) * pxPlayclock->ulEncodedFrameSize /
+           pxPlayclock->ulRawFrameSize;
+}
+
+uint32_t ulAIAPlayclockUnplayed( const AIAPlayclock_t * pxPlayclock )
+{
+    return pxPlayclock->ulWritten - pxPlayclock->ulPlayed;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _AIA_PLAYCLOCK_H_
+#define _AIA_PLAYCLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A playback clock for the speaker. The speaker task tells it the offset of each frame of audio it writes for the
+ * speaker, and the platform tells it, through the speaker read functions, what has been played. Audio read for the
+ * DMA is counted as played when the next read comes, i.e. when the DMA has played out what it was given. The clock
+ * maps the raw audio played back to the offsets of the stream, and holds events, e.g. markers, until the audio
+ * written before them has been played.
+ *
+ * Positions are raw bytes counted from vAIAPlayclockStart() and wrap around. xAIAPlayclockPlayedFromISR() is called
+ * from interrupt, and the other calls are serialized with it by the caller.
+ */
+
+/* The most events held at once. */
+#define AIA_PLAYCLOCK_EVENTS        ( 8 )
+
+/* The most jumps in the offsets tracked between what is played and what is written. */
+#define AIA_PLAYCLOCK_ANCHORS       ( 4 )
+
+typedef enum {
+    /* A SpeakerMarkerEncountered event for the marker in ulValue. */
+    eAIAPlayclockMarker,
+    /* The end of the stream, once everything written has been played. */
+    eAIAPlayclockEnd
+} AIAPlayclockEventType_t;
+
+typedef struct {
+    uint32_t ulPosition;
+    AIAPlayclockEventType_t xType;
+    uint32_t ulValue;
+} AIAPlayclockEvent_t;
+
+typedef struct {
+    uint32_t ulPosition;
+    uint64_t ullOffset;
+} AIAPlayclockAnchor_t;
+
+typedef struct {
+    uint32_t ulRawFrameSize;
+    uint32_t ulEncodedFrameSize;
+    BaseType_t xRunning;
+    /* Raw bytes written for the speaker, played, and given to the DMA but not played yet. */
+    uint32_t ulWritten;
+    volatile uint32_t ulPlayed;
+    uint32_t ulReading;
+    /* The offset expected of the next frame written, and the positions the offsets jumped at, the oldest overwritten. */
+    uint64_t ullNextOffset;
+    AIAPlayclockAnchor_t xAnchors[ AIA_PLAYCLOCK_ANCHORS ];
+    uint32_t ulAnchorIndex;
+    /* The events held, taken from ulEventTail and added at ulEventHead. */
+    AIAPlayclockEvent_t xEvents[ AIA_PLAYCLOCK_EVENTS ];
+    volatile uint32_t ulEventHead;
+    volatile uint32_t ulEventTail;
+    /* Set once an event has been found due, until the events are taken. */
+    volatile BaseType_t xDueSignalled;
+} AIAPlayclock_t;
+
+/**
+ * @brief                           Set up a stopped clock.
+ *
+ * @param[out] pxPlayclock          The clock.
+ * @param[in] ulRawFrameSize        The bytes of a decoded frame.
+ * @param[in] ulEncodedFrameSize    The bytes of an encoded frame, in which offsets are counted.
+ */
+void vAIAPlayclockInit( AIAPlayclock_t * pxPlayclock, uint32_t ulRawFrameSize, uint32_t ulEncodedFrameSize );
+
+/**
+ * @brief                           Start the clock for a stream, with nothing written or played.
+ *
+ * @param[in] pxPlayclock           The clock.
+ * @param[in] ullOffset             The offset the stream is opened at.
+ */
+void vAIAPlayclockStart( AIAPlayclock_t * pxPlayclock, uint64_t ullOffset );
+
+/**
+ * @brief                           Stop the clock. The events held are dropped.
+ *
+ * @param[in] pxPlayclock           The clock.
+ */
+void vAIAPlayclockStop( AIAPlayclock_t * pxPlayclock );
+
+/**
+ * @brief                           Record a frame written for the speaker.
+ *
+ * @param[in] pxPlayclock           The clock.
+ * @param[in] ullOffset             The offset of the frame.
+ */
+void vAIAPlayclockWrite( AIAPlayclock_t * pxPlayclock, uint64_t ullOffset );
+
+/**
+ * @brief                           Record audio read for the speaker DMA. Call this from interrupt only.
+ *
+ * @param[in] pxPlayclock           The clock.
+ * @param[in] ulBytes               The bytes read, 0 if none.
+ *
+ * @return                          pdTRUE if an event has become due, once until the events are taken.
+ */
+BaseType_t xAIAPlayclockPlayedFromISR( AIAPlayclock_t * pxPlayclock, uint32_t ulBytes );
+
+/**
+ * @brief                           Hold an event until what has been written so far is played.
+ *
+ * @param[in] pxPlayclock           The clock.
+ * @param[in] xType                 The type of the event.
+ * @param[in] ulValue               The value of the event.
+ *
+ * @return                          pdPASS if the event is held, pdFAIL if the clock is stopped or too many are.
+ */
+BaseType_t xAIAPlayclockSchedule( AIAPlayclock_t * pxPlayclock, AIAPlayclockEventType_t xType, uint32_t ulValue );
+
+/**
+ * @brief                           Take the oldest event if it is due.
+ *
+ * @param[in] pxPlayclock           The clock.
+ * @param[out] pxEvent              The event.
+ *
+ * @return                          pdTRUE if an event has been taken.
+ */
+BaseType_t xAIAPlayclockTakeDue( AIAPlayclock_t * pxPlayclock, AIAPlayclockEvent_t * pxEvent );
+
+/**
+ * @brief                           Get the offset of the audio being played.
+ *
+ * @param[in] pxPlayclock           The clock.
+ *
+ * @return                          The offset.
+ */
+uint64_t ullAIAPlayclockOffset( const AIAPlayclock_t * pxPlayclock );
+
+/**
+ * @brief                           Get the raw bytes written but not played yet.
+ *
+ * @param[in] pxPlayclock           The clock.
+ *
+ * @return                          The number of bytes.
+ */
+uint32_t ulAIAPlayclockUnplayed( const AIAPlayclock_t * pxPlayclock );
+
+#endif /* _AIA_PLAYCLOCK_H_ */
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#include <string.h>
+
+#include "aia_playout.h"
+
+/* A new target within this much of the last one is not worth advertising new thresholds for. */
+#define AIA_PLAYOUT_HYSTERESIS_MS       ( 100UL )
+
+static uint32_t prvTicksToMs( TickType_t xTicks )
+{
+    return ( uint32_t )xTicks * portTICK_PERIOD_MS;
+}
+
+static uint32_t prvMsToBytes( const AIAPlayout_t * pxPlayout, uint32_t ulMs )
+{
+    return ( uint32_t )( ( uint64_t )ulMs * pxPlayout->ulBytesPerSecond / 1000UL );
+}
+
+static void prvGetThresholds( const AIAPlayout_t * pxPlayout,
+                              uint32_t ulTargetMs,
+                              uint32_t * pulOverrunWarning,
+                              uint32_t * pulUnderrunWarning )
+{
+    uint32_t ulUnderrunWarning;
+    uint32_t ulOverrunWarning;
+
+    /* Warn of an underrun with twice the target buffered on top of the configured threshold, but leave at least half
+     * the buffer above it.
+     */
+    ulUnderrunWarning = pxPlayout->ulMinUnderrunWarning + prvMsToBytes( pxPlayout, 2 * ulTargetMs );
+    if( ulUnderrunWarning > pxPlayout->ulBufferSize / 2 && ulTargetMs != 0 )
+    {
+        ulUnderrunWarning = pxPlayout->ulBufferSize / 2;
+    }
+    if( ulUnderrunWarning < pxPlayout->ulMinUnderrunWarning )
+    {
+        ulUnderrunWarning = pxPlayout->ulMinUnderrunWarning;
+    }
+
+    ulOverrunWarning = ( pxPlayout->ulBufferSize + ulUnderrunWarning ) / 2;
+    if( ulOverrunWarning < pxPlayout->ulMinOverrunWarning )
+    {
+        ulOverrunWarning = pxPlayout->ulMinOverrunWarning;
+    }
+
+    *pulOverrunWarning = ulOverrunWarning;
+    *pulUnderrunWarning = ulUnderrunWarning;
+}
+
+void vAIAPlayoutInit( AIAPlayout_t * pxPlayout,
+                      uint32_t ulBytesPerSecond,
+                      uint32_t ulBufferSize,
+                      uint32_t ulOverrunWarning,
+                      uint32_t ulUnderrunWarning,
+                      uint32_t ulMaxTargetMs )
+{
+    memset( pxPlayout, 0, sizeof( *pxPlayout ) );
+    pxPlayout->ulBytesPerSecond = ulBytesPerSecond;
+    pxPlayout->ulBufferSize = ulBufferSize;
+    pxPlayout->ulMinOverrunWarning = ulOverrunWarning;
+    pxPlayout->ulMinUnderrunWarning = ulUnderrunWarning;
+    pxPlayout->ulMaxTargetMs = ulMaxTargetMs;
+    prvGetThresholds( pxPlayout, 0, &pxPlayout->ulOverrunWarning, &pxPlayout->ulUnderrunWarning );
+}
+
+void vAIAPlayoutArrival( AIAPlayout_t * pxPlayout, uint64_t ullOffset, TickType_t xNow )
+{
+    uint32_t ulElapsedMs;
+    uint32_t ulMediaMs;
+
+    if( pxPlayout->xStarted == pdFALSE )
+    {
+        /* Audio left over from the stream ended would make the next one look late. */
+        if( ullOffset < pxPlayout->ullEndOffset )
+        {
+            return;
+        }
+
+        pxPlayout->xStarted = pdTRUE;
+        pxPlayout->xFirstArrival = xNow;
+        pxPlayout->ullFirstOffset = ullOffset;
+        pxPlayout->ulJitterMs = 0;
+        return;
+    }
+
+    if( ullOffset < pxPlayout->ullFirstOffset )
+    {
+        return;
+    }
+
+    ulElapsedMs = prvTicksToMs( xNow - pxPlayout->xFirstArrival );
+    ulMediaMs = ( uint32_t )( ( ullOffset - pxPlayout->ullFirstOffset ) * 1000UL / pxPlayout->ulBytesPerSecond );
+    if( ulElapsedMs > ulMediaMs && ulElapsedMs - ulMediaMs > pxPlayout->ulJitterMs )
+    {
+        pxPlayout->ulJitterMs = ulElapsedMs - ulMediaMs;
+    }
+}
+
+TickType_t xAIAPlayoutPrebuffer( const AIAPlayout_t * pxPlayout, size_t xBufferedBytes, TickType_t xNow )
+{
+    uint32_t ulElapsedMs;
+
+    if( pxPlayout->xStarted == pdFALSE ||
+        xBufferedBytes >= prvMsToBytes( pxPlayout, pxPlayout->xStatistics.ulTargetMs ) )
+    {
+        return 0;
+    }
+
+    ulElapsedMs = prvTicksToMs( xNow - pxPlayout->xFirstArrival );
+    if( ulElapsedMs >= pxPlayout->xStatistics.ulTargetMs )
+    {
+        return 0;
+    }
+
+    return pdMS_TO_TICKS( pxPlayout->xStatistics.ulTargetMs - ulElapsedMs );
+}
+
+void vAIAPlayoutUnderrun( AIAPlayout_t * pxPlayout )
+{
+    pxPlayout->xStatistics.ulUnderruns++;
+}
+
+BaseType_t xAIAPlayoutStreamEnd( AIAPlayout_t * pxPlayout, uint64_t ullEndOffset )
+{
+    AIAPlayoutStatistics_t * pxStatistics = &pxPlayout->xStatistics;
+    uint32_t ulJitterMs = pxPlayout->ulJitterMs;
+    uint32_t ulTargetMs;
+    uint32_t ulOverrunWarning;
+    uint32_t ulUnderrunWarning;
+    uint32_t ulDifference;
+
+    if( pxPlayout->xStarted == pdFALSE )
+    {
+        return pdFALSE;
+    }
+
+    pxPlayout->xStarted = pdFALSE;
+    pxPlayout->ullEndOffset = ullEndOffset;
+
+    pxStatistics->ulStreams++;
+    pxStatistics->ulLastJitterMs = ulJitterMs;
+    if( ulJitterMs > pxStatistics->ulMaxJitterMs )
+    {
+        pxStatistics->ulMaxJitterMs = ulJitterMs;
+    }
+
+    /* Follow a late stream at once, and come back down once it has left the history. */
+    pxPlayout->ulHistoryMs[ pxPlayout->ulHistoryIndex ] = ulJitterMs;
+    pxPlayout->ulHistoryIndex = ( pxPlayout->ulHistoryIndex + 1 ) % AIA_PLAYOUT_HISTORY;
+    ulTargetMs = 0;
+    for( uint32_t i = 0; i < AIA_PLAYOUT_HISTORY; i++ )
+    {
+        if( pxPlayout->ulHistoryMs[ i ] > ulTargetMs )
+        {
+            ulTargetMs = pxPlayout->ulHistoryMs[ i ];
+        }
+    }
+    if( ulTargetMs > pxPlayout->ulMaxTargetMs )
+    {
+        ulTargetMs = pxPlayout->ulMaxTargetMs;
+    }
+    pxStatistics->ulTargetMs = ulTargetMs;
+
+    /* One proposal at a time: the target is proposed again at the end of the next stream if it still differs. */
+    if( pxPlayout->xProposed == pdTRUE )
+    {
+        return pdFALSE;
+    }
+
+    prvGetThresholds( pxPlayout, ulTargetMs, &ulOverrunWarning, &ulUnderrunWarning );
+    ulDifference = ( ulUnderrunWarning > pxPlayout->ulUnderrunWarning ) ? ulUnderrunWarning - pxPlayout->ulUnderrunWarning :
+                                                                          pxPlayout->ulUnderrunWarning - ulUnderrunWarning;
+
+    /* Small steps are not worth a capabilities round, but getting back to the configured thresholds is. */
+    if( ulDifference == 0 ||
+        ( ulDifference < prvMsToBytes( pxPlayout, AIA_PLAYOUT_HYSTERESIS_MS ) && ulUnderrunWarning != pxPlayout->ulMinUnderrunWarning ) )
+    {
+        return pdFALSE;
+    }
+
+    pxPlayout->xProposed = pdTRUE;
+    pxPlayout->ulProposedOverrunWarning = ulOverrunWarning;
+    pxPlayout->ulProposedUnderrunWarning = ulUnderrunWarning;
+
+    return pdTRUE;
+}
+
+void vAIAPlayoutGetProposedThresholds( const AIAPlayout_t * pxPlayout,
+                                       uint32_t * pulOverrunWarning,
+                                       uint32_t * pulUnderrunWarning )
+{
+    *pulOverrunWarning = pxPlayout->ulProposedOverrunWarning;
+    *pulUnderrunWarning = pxPlayout->ulProposedUnderrunWarning;
+}
+
+BaseType_t xAIAPlayoutAcknowledge( AIAPlayout_t * pxPlayout, BaseType_t xAccepted )
+{
+    if( pxPlayout->xProposed == pdFALSE )
+    {
+        return pdFALSE;
+    }
+
+    pxPlayout->xProposed = pdFALSE;
+    if( xAccepted == pdTRUE )
+    {
+        pxPlayout->ulOverrunWarning = pxPlayout->ulProposedOverrunWarning;
+        pxPlayout->ulUnderrunWarning = pxPlayout->ulProposedUnderrunWarning;
+        pxPlayout->xStatistics.ulThresholdChanges++;
+    }
+    else
+    {
+        pxPlayout->xStatistics.ulThresholdRejections++;
+    }
+
+    return pdTRUE;
+}
+
+void vAIAPlayoutGetThresholds( const AIAPlayout_t * pxPlayout, uint32_t * pulOverrunWarning, uint32_t * pulUnderrunWarning )
+{
+    *pulOverrunWarning = pxPlayout->ulOverrunWarning;
+    *pulUnderrunWarning = pxPlayout->ulUnderrunWarning;
+}
+
+void vAIAPlayoutGetStatistics( const AIAPlayout_t * pxPlayout, AIAPlayoutStatistics_t * pxStatistics )
+{
+    *pxStatistics = pxPlayout->xStatistics;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _AIA_PLAYOUT_H_
+#define _AIA_PLAYOUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* An adaptive playout controller for the speaker. It measures how late the /speaker messages of each stream arrive
+ * against the media clock, taking the first message of the stream as the reference. This is the most the stream has
+ * to be delayed by for playback not to run dry if it starts as soon as that message arrives. The largest delay of the
+ * last AIA_PLAYOUT_HISTORY streams becomes the prebuffer target held before the speaker is started. The
+ * buffer warning thresholds follow the target, so that the service is told to hurry before the prebuffer runs out.
+ * New thresholds are only proposed at the end of a stream, one proposal at a time, and are used once the service has
+ * accepted them in a capabilities acknowledgement. On a link that delivers ahead of real time, as AIA does, the target is 0 and playback starts at once. The caller
+ * serializes the calls.
+ */
+
+/* The number of streams the prebuffer target looks back on. */
+#define AIA_PLAYOUT_HISTORY         ( 8 )
+
+typedef struct {
+    /* Streams ended and the underruns in them. */
+    uint32_t ulStreams;
+    uint32_t ulUnderruns;
+    /* The most a message arrived late in the last stream, and in any stream. */
+    uint32_t ulLastJitterMs;
+    uint32_t ulMaxJitterMs;
+    /* The prebuffer target for the next stream. */
+    uint32_t ulTargetMs;
+    /* Thresholds proposed and accepted, and proposals rejected or not acknowledged. */
+    uint32_t ulThresholdChanges;
+    uint32_t ulThresholdRejections;
+} AIAPlayoutStatistics_t;
+
+typedef struct {
+    uint32_t ulBytesPerSecond;
+    uint32_t ulBufferSize;
+    uint32_t ulMinOverrunWarning;
+    uint32_t ulMinUnderrunWarning;
+    uint32_t ulMaxTargetMs;
+    /* The thresholds last accepted by the service. */
+    uint32_t ulOverrunWarning;
+    uint32_t ulUnderrunWarning;
+    /* The thresholds proposed and waiting for the acknowledgement of the service. */
+    BaseType_t xProposed;
+    uint32_t ulProposedOverrunWarning;
+    uint32_t ulProposedUnderrunWarning;
+    /* The stream being measured. */
+    BaseType_t xStarted;
+    TickType_t xFirstArrival;
+    uint64_t ullFirstOffset;
+    uint64_t ullEndOffset;
+    uint32_t ulJitterMs;
+    /* The jitter of the last streams, the oldest overwritten first. */
+    uint32_t ulHistoryMs[ AIA_PLAYOUT_HISTORY ];
+    uint32_t ulHistoryIndex;
+    AIAPlayoutStatistics_t xStatistics;
+} AIAPlayout_t;
+
+/**
+ * @brief                           Set up a controller with no prebuffer and the configured thresholds.
+ *
+ * @param[out] pxPlayout            The controller.
+ * @param[in] ulBytesPerSecond      The rate of the encoded audio, in which offsets and the buffer are counted.
+ * @param[in] ulBufferSize          The size of the speaker buffer.
+ * @param[in] ulOverrunWarning      The lowest overrun warning threshold to advertise.
+ * @param[in] ulUnderrunWarning     The lowest underrun warning threshold to advertise.
+ * @param[in] ulMaxTargetMs         The longest prebuffer to hold.
+ */
+void vAIAPlayoutInit( AIAPlayout_t * pxPlayout,
+                      uint32_t ulBytesPerSecond,
+                      uint32_t ulBufferSize,
+                      uint32_t ulOverrunWarning,
+                      uint32_t ulUnderrunWarning,
+                      uint32_t ulMaxTargetMs );
+
+/**
+ * @brief                           Record the arrival of a /speaker message.
+ *
+ * The first message after the end of a stream starts the next one, unless its audio belongs to the stream ended.
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[in] ullOffset             The offset of the first audio in the message.
+ * @param[in] xNow                  The current tick count.
+ */
+void vAIAPlayoutArrival( AIAPlayout_t * pxPlayout, uint64_t ullOffset, TickType_t xNow );
+
+/**
+ * @brief                           Get how much longer to hold the speaker before it is started.
+ *
+ * The prebuffer is complete once the target has passed since the first message of the stream arrived, or once as
+ * much audio is buffered.
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[in] xBufferedBytes        The audio in the speaker buffer.
+ * @param[in] xNow                  The current tick count.
+ *
+ * @return                          The ticks left, or 0 to start now.
+ */
+TickType_t xAIAPlayoutPrebuffer( const AIAPlayout_t * pxPlayout, size_t xBufferedBytes, TickType_t xNow );
+
+/**
+ * @brief                           Record that the speaker buffer ran dry.
+ *
+ * @param[in] pxPlayout             The controller.
+ */
+void vAIAPlayoutUnderrun( AIAPlayout_t * pxPlayout );
+
+/**
+ * @brief                           End the stream being measured, and set the target from it.
+ *
+ * If the thresholds that follow the target have moved enough, and no proposal is waiting for an acknowledgement, they
+ * are proposed, see vAIAPlayoutGetProposedThresholds(). The thresholds in use do not change until the proposal is
+ * accepted with xAIAPlayoutAcknowledge().
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[in] ullEndOffset          The offset the stream was closed at.
+ *
+ * @return                          pdTRUE if new thresholds are proposed, to be advertised.
+ */
+BaseType_t xAIAPlayoutStreamEnd( AIAPlayout_t * pxPlayout, uint64_t ullEndOffset );
+
+/**
+ * @brief                           Get the buffer warning thresholds proposed by xAIAPlayoutStreamEnd().
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[out] pulOverrunWarning    The overrun warning threshold.
+ * @param[out] pulUnderrunWarning   The underrun warning threshold.
+ */
+void vAIAPlayoutGetProposedThresholds( const AIAPlayout_t * pxPlayout,
+                                       uint32_t * pulOverrunWarning,
+                                       uint32_t * pulUnderrunWarning );
+
+/**
+ * @brief                           Settle the proposal waiting for an acknowledgement, if any.
+ *
+ * Accepted, the proposed thresholds are used from now on. Otherwise, as when the service rejects the capabilities or
+ * does not answer, the thresholds stay as they were, and may be proposed again at the end of a later stream.
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[in] xAccepted             pdTRUE if the service accepted the proposed thresholds.
+ *
+ * @return                          pdTRUE if a proposal was waiting, pdFALSE otherwise.
+ */
+BaseType_t xAIAPlayoutAcknowledge( AIAPlayout_t * pxPlayout, BaseType_t xAccepted );
+
+/**
+ * @brief                           Get the buffer warning thresholds in use, the last accepted.
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[out] pulOverrunWarning    The overrun warning threshold.
+ * @param[out] pulUnderrunWarning   The underrun warning threshold.
+ */
+void vAIAPlayoutGetThresholds( const AIAPlayout_t * pxPlayout, uint32_t * pulOverrunWarning, uint32_t * pulUnderrunWarning );
+
+/**
+ * @brief                           Get the statistics since vAIAPlayoutInit().
+ *
+ * @param[in] pxPlayout             The controller.
+ * @param[out] pxStatistics         The statistics.
+ */
+void vAIAPlayoutGetStatistics( const AIAPlayout_t * pxPlayout, AIAPlayoutStatistics_t * pxStatistics );
+
+#endif /* _AIA_PLAYOUT_H_ */
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "aia_publish.h"
+#include "aia_client.h"
+#include "aia_recvpool.h"
+#include "aia_utils.h"
+
+/* Without it MQTT ignores pMqttSerializer and sends the AIAPublishPayload_t itself, see aia_publish.h. */
+#if !defined( IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES ) || ( IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES != 1 )
+#error "The AIA publish serializer needs IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES set to 1 in iot_config.h."
+#endif
+
+#define MQTT_PACKET_TYPE_PUBLISH            ( 0x30U )
+#define MQTT_PUBLISH_FLAG_RETAIN            ( 0x01U )
+
+/* Time spent in AES-GCM and the plaintext bytes it has processed. */
+static AIACycleMeter_t xCryptoMeter;
+static uint64_t ullCryptoBytes;
+
+/* The remaining length is encoded in 1 to 4 bytes. */
+static size_t prvRemainingLengthEncodedSize( size_t xRemainingLength )
+{
+    size_t xSize = 1;
+
+    while( xRemainingLength > 127U )
+    {
+        xRemainingLength >>= 7;
+        xSize++;
+    }
+
+    return xSize;
+}
+
+static IotMqttError_t prvSerializePublish( const IotMqttPublishInfo_t * pxPublishInfo,
+                                           uint8_t ** ppucPublishPacket,
+                                           size_t * pxPacketSize,
+                                           uint16_t * pusPacketIdentifier,
+                                           uint8_t ** ppucPacketIdentifierHigh )
+{
+    const AIAPublishPayload_t * pxPayload = ( const AIAPublishPayload_t * )pxPublishInfo->pPayload;
+    size_t xRemainingLength;
+    size_t xPacketSize;
+    uint8_t * pucPacket;
+    uint8_t * pucCursor;
+    int32_t lLength;
+
+    if( pxPublishInfo->qos != IOT_MQTT_QOS_0 )
+    {
+        configPRINTF( ( "Only QoS 0 is supported by the AIA publish serializer!\r\n" ) );
+        return IOT_MQTT_BAD_PARAMETER;
+    }
+
+    /* Catches a payload that is not an AIAPublishPayload_t, published on the connection by someone else. */
+    configASSERT( pxPayload != NULL );
+    configASSERT( pxPublishInfo->payloadLength == ( ( pxPayload->pxCrypto != NULL ) ?
+                                                    AIA_MSG_ENCRYPTED_LENGTH( pxPayload->ulMessageLength ) :
+                                                    pxPayload->ulMessageLength ) );
+
+    xRemainingLength = sizeof( uint16_t ) + pxPublishInfo->topicNameLength + pxPublishInfo->payloadLength;
+    xPacketSize = 1 + prvRemainingLengthEncodedSize( xRemainingLength ) + xRemainingLength;
+
+    pucPacket = ( uint8_t * )pvAIARecvPoolMalloc( xPacketSize );
+    if( pucPacket == NULL )
+    {
+        return IOT_MQTT_NO_MEMORY;
+    }
+
+    pucCursor = pucPacket;
+    *pucCursor++ = MQTT_PACKET_TYPE_PUBLISH | ( pxPublishInfo->retain == true ? MQTT_PUBLISH_FLAG_RETAIN : 0 );
+    do
+    {
+        uint8_t ucByte = ( uint8_t )( xRemainingLength & 0x7FU );
+
+        xRemainingLength >>= 7;
+        *pucCursor++ = ( xRemainingLength > 0 ) ? ( ucByte | 0x80U ) : ucByte;
+    } while( xRemainingLength > 0 );
+
+    *pucCursor++ = ( uint8_t )( pxPublishInfo->topicNameLength >> 8 );
+    *pucCursor++ = ( uint8_t )( pxPublishInfo->topicNameLength & 0xFFU );
+    memcpy( pucCursor, pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength );
+    pucCursor += pxPublishInfo->topicNameLength;
+
+    /* The payload goes to the rest of the packet. */
+    if( pxPayload->pxCrypto != NULL )
+    {
+        vAIACycleMeterStart( &xCryptoMeter );
+        lLength = lAIACryptoEncrypt( pxPayload->pxCrypto,
+                                     pucCursor,
+                                     pxPayload->pvMessage,
+                                     pxPayload->ulMessageLength,
+                                     pxPayload->ulSequence );
+        vAIACycleMeterStop( &xCryptoMeter );
+        ullCryptoBytes += pxPayload->ulMessageLength;
+    }
+    else
+    {
+        memcpy( pucCursor, pxPayload->pvMessage, pxPayload->ulMessageLength );
+        lLength = ( int32_t )pxPayload->ulMessageLength;
+    }
+
+    if( lLength < 0 || ( size_t )lLength != pxPublishInfo->payloadLength )
+    {
+        configPRINTF( ( "Failed to serialize the message to %.*s!\r\n", pxPublishInfo->topicNameLength, pxPublishInfo->pTopicName ) );
+        vAIARecvPoolFree( pucPacket );
+        return IOT_MQTT_BAD_PARAMETER;
+    }
+
+    *ppucPublishPacket = pucPacket;
+    *pxPacketSize = xPacketSize;
+    *pusPacketIdentifier = 0;
+    *ppucPacketIdentifierHigh = NULL;
+
+    return IOT_MQTT_SUCCESS;
+}
+
+const IotMqttSerializer_t xAIAMqttSerializer = {
+    .serialize.publish = prvSerializePublish,
+};
+
+uint32_t ulAIAPublishCryptoCyclesPerKB( void )
+{
+    return ( ullCryptoBytes != 0 ) ? ( uint32_t )( xCryptoMeter.ullTotal * 1024U / ullCryptoBytes ) : 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_PUBLISH_H_
+#define _AIA_PUBLISH_H_
+
+#include <stdint.h>
+
+#include "iot_mqtt.h"
+#include "aia_crypto.h"
+
+/* The AIA client does not hand ready-made payloads to IotMqtt_Publish(). Instead pPayload of IotMqttPublishInfo_t
+ * points to an AIAPublishPayload_t, and the PUBLISH serializer below builds the message straight into the MQTT
+ * packet buffer after the topic name, so that AES-GCM writes the ciphertext and the tag in place and no copy of
+ * the payload is made on the way to the network.
+ *
+ * payloadLength of IotMqttPublishInfo_t must be set to the length of the message on the wire, i.e.
+ * AIA_MSG_ENCRYPTED_LENGTH() of the plaintext length for an encrypted message.
+ *
+ * This relies on the MQTT library never reading pPayload itself, which holds as long as:
+ * - IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES is 1 in iot_config.h, or the library would serialize the
+ *   AIAPublishPayload_t as the payload. aia_publish.c does not build otherwise.
+ * - only QoS 0 is published. For QoS 1 and 2 the library may set the DUP flag in and resend the packet built here,
+ *   which is still fine, but the serializer rejects them as the client does not use them.
+ * - every PUBLISH on the connection comes from the AIA client. Anything else published on it must pass an
+ *   AIAPublishPayload_t with pxCrypto set to NULL. The serializer asserts that payloadLength matches the message.
+ */
+typedef struct {
+    /* The crypto context used to encrypt the message, or NULL to send the message in clear. */
+    AIACrypto_t * pxCrypto;
+    /* The message. If it is to be encrypted, AIA_MSG_PARAMS_SIZE_SEQ bytes must be available preceding it. */
+    void * pvMessage;
+    uint32_t ulMessageLength;
+    /* The sequence number of an encrypted message. */
+    uint32_t ulSequence;
+} AIAPublishPayload_t;
+
+/* The serializer to be given to IotMqtt_Connect() as pMqttSerializer of IotMqttNetworkInfo_t. Only PUBLISH is
+ * overridden, and only QoS 0 is supported as that is all the AIA client uses. The packet buffer is allocated from
+ * the pool in aia_recvpool.h and freed by MQTT with IotMqtt_FreeMessage().
+ */
+extern const IotMqttSerializer_t xAIAMqttSerializer;
+
+/**
+ * @brief                   Get the average cost of AES-GCM in the PUBLISH serializer so far.
+ *
+ * This is used to compare the cost of encrypting microphone audio with the cost of compressing it.
+ *
+ * @return                  CPU cycles per KB of encrypted plaintext, or 0 if nothing has been encrypted.
+ */
+uint32_t ulAIAPublishCryptoCyclesPerKB( void );
+
+#endif /* _AIA_PUBLISH_H_ */
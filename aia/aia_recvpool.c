@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "aia_recvpool.h"
+#include "aia_client_config.h"
+#include "task.h"
+
+static struct {
+    uint8_t ucBuffer[ aiaconfigAIA_RECEIVE_POOL_BUFFERS ][ aiaconfigAIA_RECEIVE_POOL_BUFFER_SIZE ];
+    uint8_t ucRefCount[ aiaconfigAIA_RECEIVE_POOL_BUFFERS ];
+    uint32_t ulHeapAllocations;
+} xPool __attribute__((aligned(8)));
+
+/* Return the index of the pool buffer that pvAddress points into, or -1 if it is not in the pool. */
+static int32_t prvPoolIndex( const void * pvAddress )
+{
+    const uint8_t * pucAddress = ( const uint8_t * )pvAddress;
+
+    if( pucAddress < &xPool.ucBuffer[ 0 ][ 0 ] ||
+        pucAddress >= &xPool.ucBuffer[ aiaconfigAIA_RECEIVE_POOL_BUFFERS ][ 0 ] )
+    {
+        return -1;
+    }
+
+    return ( int32_t )( ( pucAddress - &xPool.ucBuffer[ 0 ][ 0 ] ) / aiaconfigAIA_RECEIVE_POOL_BUFFER_SIZE );
+}
+
+/* MQTT allocates from its receive task and the outbound task, and the client retains from the MQTT callback. */
+static void prvCountHeapAllocation( const void * pvBuffer )
+{
+    if( pvBuffer != NULL )
+    {
+        taskENTER_CRITICAL();
+        xPool.ulHeapAllocations++;
+        taskEXIT_CRITICAL();
+    }
+}
+
+void * pvAIARecvPoolMalloc( size_t xSize )
+{
+    void * pvBuffer = NULL;
+
+    if( xSize <= aiaconfigAIA_RECEIVE_POOL_BUFFER_SIZE )
+    {
+        taskENTER_CRITICAL();
+        for( int i = 0; i < aiaconfigAIA_RECEIVE_POOL_BUFFERS; i++ )
+        {
+            if( xPool.ucRefCount[ i ] == 0 )
+            {
+                xPool.ucRefCount[ i ] = 1;
+                pvBuffer = xPool.ucBuffer[ i ];
+                break;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if( pvBuffer == NULL )
+    {
+        pvBuffer = pvPortMalloc( xSize );
+        prvCountHeapAllocation( pvBuffer );
+    }
+
+    return pvBuffer;
+}
+
+void vAIARecvPoolFree( void * pvBuffer )
+{
+    int32_t lIndex = prvPoolIndex( pvBuffer );
+
+    if( lIndex < 0 )
+    {
+        vPortFree( pvBuffer );
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    configASSERT( xPool.ucRefCount[ lIndex ] != 0 );
+    xPool.ucRefCount[ lIndex ]--;
+    taskEXIT_CRITICAL();
+}
+
+void * pvAIARecvPoolRetain( const void * pvMessage, size_t xLength )
+{
+    int32_t lIndex = prvPoolIndex( pvMessage );
+    void * pvRetained;
+
+    if( lIndex >= 0 )
+    {
+        taskENTER_CRITICAL();
+        configASSERT( xPool.ucRefCount[ lIndex ] != 0 );
+        xPool.ucRefCount[ lIndex ]++;
+        taskEXIT_CRITICAL();
+        return ( void * )pvMessage;
+    }
+
+    pvRetained = pvPortMalloc( xLength );
+    if( pvRetained != NULL )
+    {
+        memcpy( pvRetained, pvMessage, xLength );
+    }
+    prvCountHeapAllocation( pvRetained );
+
+    return pvRetained;
+}
+
+uint32_t ulAIARecvPoolHeapAllocations( void )
+{
+    return xPool.ulHeapAllocations;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_RECVPOOL_H_
+#define _AIA_RECVPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* MQTT library allocates a buffer for every packet it sends or receives through IotMqtt_MallocMessage() and
+ * IotMqtt_FreeMessage(). iot_config.h of the board maps them to pvAIARecvPoolMalloc() and vAIARecvPoolFree(), so
+ * that packets are read directly into a fixed pool owned by the AIA client instead of the heap.
+ *
+ * Each buffer of the pool is reference counted. MQTT holds one reference from allocation until it frees the packet
+ * after the subscription callback returns. The client may take another one with pvAIARecvPoolRetain() to keep a
+ * received message, e.g. for resequencing, without copying it.
+ *
+ * The pool needs no initialization, as MQTT may allocate from it before the client is initialized.
+ */
+
+/**
+ * @brief                   Allocate a packet buffer, mapped to IotMqtt_MallocMessage().
+ *
+ * A free buffer of the pool is returned if the requested size fits. Otherwise it falls back to the heap.
+ *
+ * @param[in] xSize         Size of the buffer in bytes.
+ *
+ * @return                  Pointer to the buffer, or NULL if no memory is available.
+ */
+void * pvAIARecvPoolMalloc( size_t xSize );
+
+/**
+ * @brief                   Drop a reference to a buffer, mapped to IotMqtt_FreeMessage().
+ *
+ * The buffer returns to the pool when its last reference is dropped. The client also uses this function to release
+ * what it has got from pvAIARecvPoolRetain().
+ *
+ * @param[in] pvBuffer      Pointer to the buffer, or to any location inside it for a buffer of the pool.
+ */
+void vAIARecvPoolFree( void * pvBuffer );
+
+/**
+ * @brief                   Take ownership of a received message beyond the MQTT callback.
+ *
+ * If the message lies in a buffer of the pool, a reference to the buffer is taken and the message is not copied.
+ * Otherwise, i.e. MQTT has fallen back to the heap, the message is copied to a new heap buffer.
+ *
+ * @param[in] pvMessage     Pointer to the message.
+ * @param[in] xLength       Length of the message in bytes.
+ *
+ * @return                  Pointer to the retained message, to be released by vAIARecvPoolFree(), or NULL if no
+ *                          memory is available.
+ */
+void * pvAIARecvPoolRetain( const void * pvMessage, size_t xLength );
+
+/**
+ * @brief                   Return the number of heap allocations made on behalf of the pool so far.
+ *
+ * Both fallbacks of pvAIARecvPoolMalloc() and copies made by pvAIARecvPoolRetain() are counted, if they succeed.
+ *
+ * @return                  The number of heap allocations.
+ */
+uint32_t ulAIARecvPoolHeapAllocations( void );
+
+#endif /* _AIA_RECVPOOL_H_ */
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "aia_speakerbuffer.h"
+
+/* Messages are stored with their length in front, as in a FreeRTOS message buffer. */
+#define AIA_SPEAKER_BUFFER_LENGTH_SIZE      ( sizeof( uint32_t ) )
+
+static size_t prvWrap( const AIASpeakerBuffer_t * pxBuffer, size_t xIndex )
+{
+    return ( xIndex >= pxBuffer->xSize ) ? xIndex - pxBuffer->xSize : xIndex;
+}
+
+static void prvCopyIn( AIASpeakerBuffer_t * pxBuffer, size_t xIndex, const void * pvData, size_t xLength )
+{
+    size_t xFirst = pxBuffer->xSize - xIndex;
+
+    if( xFirst > xLength )
+    {
+        xFirst = xLength;
+    }
+    memcpy( pxBuffer->pucStorage + xIndex, pvData, xFirst );
+    memcpy( pxBuffer->pucStorage, ( const uint8_t * )pvData + xFirst, xLength - xFirst );
+}
+
+static void prvCopyOut( const AIASpeakerBuffer_t * pxBuffer, size_t xIndex, void * pvData, size_t xLength )
+{
+    size_t xFirst = pxBuffer->xSize - xIndex;
+
+    if( xFirst > xLength )
+    {
+        xFirst = xLength;
+    }
+    memcpy( pvData, pxBuffer->pucStorage + xIndex, xFirst );
+    memcpy( ( uint8_t * )pvData + xFirst, pxBuffer->pucStorage, xLength - xFirst );
+}
+
+/* Wake up a task blocked on the buffer. Called in a critical section. */
+static void prvNotify( TaskHandle_t * pxTask )
+{
+    if( *pxTask != NULL )
+    {
+        ( void )xTaskNotify( *pxTask, 0, eNoAction );
+        *pxTask = NULL;
+    }
+}
+
+/* Move the read position past the oldest messages, xBytes with their lengths. Called in a critical section. */
+static void prvAdvanceTail( AIASpeakerBuffer_t * pxBuffer, size_t xBytes )
+{
+    pxBuffer->xTail = prvWrap( pxBuffer, pxBuffer->xTail + xBytes );
+    pxBuffer->xUsed -= xBytes;
+    pxBuffer->ulReads++;
+    prvNotify( &pxBuffer->xTaskWaitingToSend );
+}
+
+/* Write a message the buffer has room for. Only the writer moves xHead, and the reader does not look past xUsed, so
+ * the message is copied outside the critical section.
+ */
+static void prvWrite( AIASpeakerBuffer_t * pxBuffer, const void * pvData, size_t xLength )
+{
+    uint32_t ulLength = ( uint32_t )xLength;
+
+    prvCopyIn( pxBuffer, pxBuffer->xHead, &ulLength, AIA_SPEAKER_BUFFER_LENGTH_SIZE );
+    prvCopyIn( pxBuffer, prvWrap( pxBuffer, pxBuffer->xHead + AIA_SPEAKER_BUFFER_LENGTH_SIZE ), pvData, xLength );
+
+    taskENTER_CRITICAL();
+    pxBuffer->xHead = prvWrap( pxBuffer, pxBuffer->xHead + AIA_SPEAKER_BUFFER_LENGTH_SIZE + xLength );
+    pxBuffer->xUsed += AIA_SPEAKER_BUFFER_LENGTH_SIZE + xLength;
+    prvNotify( &pxBuffer->xTaskWaitingToReceive );
+    taskEXIT_CRITICAL();
+}
+
+BaseType_t xAIASpeakerBufferInit( AIASpeakerBuffer_t * pxBuffer, size_t xSize )
+{
+    memset( pxBuffer, 0, sizeof( AIASpeakerBuffer_t ) );
+    pxBuffer->pucStorage = ( uint8_t * )pvPortMalloc( xSize );
+    if( pxBuffer->pucStorage == NULL )
+    {
+        return pdFAIL;
+    }
+    pxBuffer->xSize = xSize;
+
+    return pdPASS;
+}
+
+size_t xAIASpeakerBufferSend( AIASpeakerBuffer_t * pxBuffer, const void * pvData, size_t xLength, TickType_t xTicksToWait )
+{
+    TimeOut_t xTimeOut;
+    BaseType_t xRoom;
+
+    if( xLength + AIA_SPEAKER_BUFFER_LENGTH_SIZE > pxBuffer->xSize )
+    {
+        return 0;
+    }
+
+    vTaskSetTimeOutState( &xTimeOut );
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        xRoom = ( pxBuffer->xSize - pxBuffer->xUsed >= xLength + AIA_SPEAKER_BUFFER_LENGTH_SIZE ) ? pdTRUE : pdFALSE;
+        pxBuffer->xTaskWaitingToSend = ( xRoom == pdTRUE ) ? NULL : xTaskGetCurrentTaskHandle();
+        taskEXIT_CRITICAL();
+
+        if( xRoom == pdTRUE )
+        {
+            break;
+        }
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+        {
+            taskENTER_CRITICAL();
+            pxBuffer->xTaskWaitingToSend = NULL;
+            taskEXIT_CRITICAL();
+            return 0;
+        }
+        ( void )xTaskNotifyWait( 0, 0, NULL, xTicksToWait );
+    }
+
+    prvWrite( pxBuffer, pvData, xLength );
+
+    return xLength;
+}
+
+size_t xAIASpeakerBufferSendDropOldest( AIASpeakerBuffer_t * pxBuffer,
+                                        const void * pvData,
+                                        size_t xLength,
+                                        uint32_t * pulDropped )
+{
+    BaseType_t xDropped;
+    size_t xTail;
+    size_t xUsed;
+    size_t xFreed;
+    uint32_t ulReads;
+    uint32_t ulLength;
+    uint32_t ulMessages;
+
+    *pulDropped = 0;
+    if( xLength + AIA_SPEAKER_BUFFER_LENGTH_SIZE > pxBuffer->xSize )
+    {
+        return 0;
+    }
+
+    /* The messages to drop are found outside of the critical section, following their lengths from the read position:
+     * only the writer changes the storage, and the reader moves the read position past whole messages. They are then
+     * dropped together, unless the reader has read one meanwhile, which makes room, and they are looked for again.
+     */
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        xTail = pxBuffer->xTail;
+        xUsed = pxBuffer->xUsed;
+        ulReads = pxBuffer->ulReads;
+        taskEXIT_CRITICAL();
+
+        xFreed = 0;
+        ulMessages = 0;
+        while( pxBuffer->xSize - ( xUsed - xFreed ) < xLength + AIA_SPEAKER_BUFFER_LENGTH_SIZE )
+        {
+            prvCopyOut( pxBuffer, prvWrap( pxBuffer, xTail + xFreed ), &ulLength, AIA_SPEAKER_BUFFER_LENGTH_SIZE );
+            xFreed += AIA_SPEAKER_BUFFER_LENGTH_SIZE + ulLength;
+            ulMessages++;
+        }
+        if( ulMessages == 0 )
+        {
+            break;
+        }
+
+        taskENTER_CRITICAL();
+        xDropped = ( pxBuffer->ulReads == ulReads ) ? pdTRUE : pdFALSE;
+        if( xDropped == pdTRUE )
+        {
+            prvAdvanceTail( pxBuffer, xFreed );
+        }
+        taskEXIT_CRITICAL();
+
+        if( xDropped == pdTRUE )
+        {
+            *pulDropped = ulMessages;
+            break;
+        }
+    }
+
+    prvWrite( pxBuffer, pvData, xLength );
+
+    return xLength;
+}
+
+/* Copy the oldest message out, and read it if xConsume is pdTRUE. */
+static size_t prvRead( AIASpeakerBuffer_t * pxBuffer,
+                       void * pvData,
+                       size_t xMaxLength,
+                       TickType_t xTicksToWait,
+                       BaseType_t xConsume )
+{
+    TimeOut_t xTimeOut;
+    BaseType_t xFound;
+    BaseType_t xRead;
+    size_t xTail = 0;
+    uint32_t ulLength = 0;
+    uint32_t ulReads = 0;
+
+    vTaskSetTimeOutState( &xTimeOut );
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        xFound = ( pxBuffer->xUsed > 0 ) ? pdTRUE : pdFALSE;
+        if( xFound == pdTRUE )
+        {
+            xTail = pxBuffer->xTail;
+            ulReads = pxBuffer->ulReads;
+            prvCopyOut( pxBuffer, xTail, &ulLength, AIA_SPEAKER_BUFFER_LENGTH_SIZE );
+            pxBuffer->xTaskWaitingToReceive = NULL;
+        }
+        else
+        {
+            pxBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+        }
+        taskEXIT_CRITICAL();
+
+        if( xFound == pdFALSE )
+        {
+            if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+            {
+                taskENTER_CRITICAL();
+                pxBuffer->xTaskWaitingToReceive = NULL;
+                taskEXIT_CRITICAL();
+                return 0;
+            }
+            ( void )xTaskNotifyWait( 0, 0, NULL, xTicksToWait );
+            continue;
+        }
+
+        if( ulLength <= xMaxLength )
+        {
+            prvCopyOut( pxBuffer, prvWrap( pxBuffer, xTail + AIA_SPEAKER_BUFFER_LENGTH_SIZE ), pvData, ulLength );
+        }
+
+        /* Unless the writer has dropped the message while it was copied, the copy is kept, and the message read if
+         * xConsume is pdTRUE. Otherwise copy the next one.
+         */
+        taskENTER_CRITICAL();
+        xRead = ( pxBuffer->ulReads == ulReads ) ? pdTRUE : pdFALSE;
+        if( xRead == pdTRUE && xConsume == pdTRUE )
+        {
+            prvAdvanceTail( pxBuffer, AIA_SPEAKER_BUFFER_LENGTH_SIZE + ulLength );
+        }
+        taskEXIT_CRITICAL();
+
+        if( xRead == pdTRUE )
+        {
+            return ( ulLength <= xMaxLength ) ? ulLength : 0;
+        }
+    }
+}
+
+size_t xAIASpeakerBufferReceive( AIASpeakerBuffer_t * pxBuffer, void * pvData, size_t xMaxLength, TickType_t xTicksToWait )
+{
+    return prvRead( pxBuffer, pvData, xMaxLength, xTicksToWait, pdTRUE );
+}
+
+size_t xAIASpeakerBufferPeek( AIASpeakerBuffer_t * pxBuffer, void * pvData, size_t xMaxLength, TickType_t xTicksToWait )
+{
+    return prvRead( pxBuffer, pvData, xMaxLength, xTicksToWait, pdFALSE );
+}
+
+size_t xAIASpeakerBufferBytesAvailable( const AIASpeakerBuffer_t * pxBuffer )
+{
+    return pxBuffer->xUsed;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _AIA_SPEAKERBUFFER_H_
+#define _AIA_SPEAKERBUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The speaker buffer holds the /speaker messages from the MQTT callback until the speaker task decodes them. It works
+ * as a FreeRTOS message buffer with one writer and one reader, each message stored as its length followed by its
+ * bytes. In addition, the writer may drop the oldest messages to make room for a new one, as AIA asks while the
+ * speaker is closed. The messages to drop are found outside of critical sections, and dropped together by moving the
+ * read position past them in a critical section of constant length, and the scheduler is never suspended. If the reader was copying that message out at the time, it finds the
+ * read position moved once it is done, and discards the copy.
+ */
+
+typedef struct {
+    uint8_t * pucStorage;
+    size_t xSize;
+    /* Where the next message is written and read, and the bytes in use. They are changed in critical sections. */
+    size_t xHead;
+    size_t xTail;
+    size_t xUsed;
+    /* Counts the moves of xTail, so that the reader can tell the message it copied has been dropped meanwhile, and
+     * the writer that the messages it is to drop have been read.
+     */
+    uint32_t ulReads;
+    /* The tasks blocked on the buffer, notified as a message is written or read. */
+    TaskHandle_t xTaskWaitingToReceive;
+    TaskHandle_t xTaskWaitingToSend;
+} AIASpeakerBuffer_t;
+
+/**
+ * @brief                   Allocate the storage of an empty buffer.
+ *
+ * @param[out] pxBuffer     The buffer.
+ * @param[in] xSize         The size of the storage in bytes, the length of each message included.
+ *
+ * @return                  pdPASS on success and pdFAIL on failure.
+ */
+BaseType_t xAIASpeakerBufferInit( AIASpeakerBuffer_t * pxBuffer, size_t xSize );
+
+/**
+ * @brief                   Write a message, waiting for room as xMessageBufferSend() does.
+ *
+ * @param[in] pxBuffer      The buffer.
+ * @param[in] pvData        The message.
+ * @param[in] xLength       The length of the message in bytes.
+ * @param[in] xTicksToWait  The maximum time to wait for room.
+ *
+ * @return                  xLength if the message has been written, 0 otherwise.
+ */
+size_t xAIASpeakerBufferSend( AIASpeakerBuffer_t * pxBuffer, const void * pvData, size_t xLength, TickType_t xTicksToWait );
+
+/**
+ * @brief                   Write a message, dropping the oldest messages to make room if needed.
+ *
+ * Only as many messages as needed are dropped, all at once, in a critical section of constant length. Finding them
+ * takes time in proportion to their number, outside of it.
+ *
+ * @param[in] pxBuffer      The buffer.
+ * @param[in] pvData        The message.
+ * @param[in] xLength       The length of the message in bytes.
+ * @param[out] pulDropped   The number of messages dropped.
+ *
+ * @return                  xLength if the message has been written, or 0 if it would not fit in the empty buffer.
+ */
+size_t xAIASpeakerBufferSendDropOldest( AIASpeakerBuffer_t * pxBuffer,
+                                        const void * pvData,
+                                        size_t xLength,
+                                        uint32_t * pulDropped );
+
+/**
+ * @brief                   Read the oldest message, waiting for one as xMessageBufferReceive() does.
+ *
+ * A message longer than xMaxLength is dropped.
+ *
+ * @param[in] pxBuffer      The buffer.
+ * @param[out] pvData       Where the message is copied to.
+ * @param[in] xMaxLength    The size of pvData in bytes.
+ * @param[in] xTicksToWait  The maximum time to wait for a message.
+ *
+ * @return                  The length of the message, or 0 if none has been read.
+ */
+size_t xAIASpeakerBufferReceive( AIASpeakerBuffer_t * pxBuffer, void * pvData, size_t xMaxLength, TickType_t xTicksToWait );
+
+/**
+ * @brief                   Copy the oldest message without reading it, waiting for one as xAIASpeakerBufferReceive().
+ *
+ * The message stays in the buffer, where the writer may still drop it. A message longer than xMaxLength is not copied.
+ *
+ * @param[in] pxBuffer      The buffer.
+ * @param[out] pvData       Where the message is copied to.
+ * @param[in] xMaxLength    The size of pvData in bytes.
+ * @param[in] xTicksToWait  The maximum time to wait for a message.
+ *
+ * @return                  The length of the message, or 0 if none has been copied.
+ */
+size_t xAIASpeakerBufferPeek( AIASpeakerBuffer_t * pxBuffer, void * pvData, size_t xMaxLength, TickType_t xTicksToWait );
+
+/**
+ * @brief                   Get the bytes in use, the lengths of the messages included, as xStreamBufferBytesAvailable().
+ *
+ * @param[in] pxBuffer      The buffer.
+ *
+ * @return                  The number of bytes.
+ */
+size_t xAIASpeakerBufferBytesAvailable( const AIASpeakerBuffer_t * pxBuffer );
+
+#endif /* _AIA_SPEAKERBUFFER_H_ */
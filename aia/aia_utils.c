@@ -21,18 +21,12 @@
  */
 
 #include "aia_utils.h"
+#include "aia_platform.h"
 
 void vPrintJSONString( const char * description, const uint8_t * js, int start, int end )
 {
-    char * s = ( char * )pvPortMalloc( end - start + 1 );
-
-    if( s != NULL )
-    {
-        memcpy( s, js + start, end - start );
-        s[ end - start ] = 0;
-        configPRINTF( ( "%s%s\r\n", description, s ) );
-        vPortFree( s );
-    }
+    /* Printed with a precision rather than copied to a terminated string, so that logging a message takes no heap. */
+    configPRINTF( ( "%s%.*s\r\n", description, end - start, js + start ) );
 }
 
 uint64_t ullConvertJSONLong( const uint8_t * js, int start, int end )
@@ -86,3 +80,54 @@ int32_t lParseJSMN( const char * pcMessage, size_t xMessageLength, jsmntok_t * p
 
     return lNbTokens;
 }
+
+void vAIACycleMeterReset( AIACycleMeter_t * pxMeter )
+{
+    memset( pxMeter, 0, sizeof( AIACycleMeter_t ) );
+}
+
+void vAIACycleMeterStart( AIACycleMeter_t * pxMeter )
+{
+    pxMeter->ulStart = ulPlatformGetCycleCount();
+}
+
+void vAIACycleMeterStop( AIACycleMeter_t * pxMeter )
+{
+    /* Unsigned subtraction handles a single wrap of the counter. */
+    uint32_t ulCycles = ulPlatformGetCycleCount() - pxMeter->ulStart;
+
+    pxMeter->ullTotal += ulCycles;
+    pxMeter->ulCount++;
+    if( ulCycles > pxMeter->ulMax )
+    {
+        pxMeter->ulMax = ulCycles;
+    }
+}
+
+uint32_t ulAIACycleMeterAverage( const AIACycleMeter_t * pxMeter )
+{
+    return ( pxMeter->ulCount != 0 ) ? ( uint32_t )( pxMeter->ullTotal / pxMeter->ulCount ) : 0;
+}
+
+int32_t lAIALog2Q8( uint64_t ullValue )
+{
+    int32_t lExponent;
+    uint32_t ulMantissa;
+
+    if( ullValue == 0 )
+    {
+        return 0;
+    }
+
+    lExponent = 63 - __builtin_clzll( ullValue );
+    if( lExponent >= 8 )
+    {
+        ulMantissa = ( uint32_t )( ullValue >> ( lExponent - 8 ) );
+    }
+    else
+    {
+        ulMantissa = ( uint32_t )( ullValue << ( 8 - lExponent ) );
+    }
+
+    return ( lExponent << 8 ) + ( int32_t )( ulMantissa - 256 );
+}
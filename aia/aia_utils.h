@@ -94,4 +94,56 @@ BaseType_t xIsDirective( const uint8_t * pcUserDirective, const size_t xUserDire
  */
 int32_t lParseJSMN( const char * pcMessage, size_t xMessageLength, jsmntok_t * pxJSMNTokens, uint32_t ulMaxTokenNumber );
 
+/**
+ * @brief                           Cycle counts accumulated over several runs of the same piece of code.
+ */
+typedef struct {
+    uint32_t ulStart;
+    uint64_t ullTotal;
+    uint32_t ulMax;
+    uint32_t ulCount;
+} AIACycleMeter_t;
+
+/**
+ * @brief                           Clear the counts of a cycle meter.
+ *
+ * @param[in] pxMeter               The cycle meter.
+ */
+void vAIACycleMeterReset( AIACycleMeter_t * pxMeter );
+
+/**
+ * @brief                           Record the cycle count at the start of a measured run.
+ *
+ * @param[in] pxMeter               The cycle meter.
+ */
+void vAIACycleMeterStart( AIACycleMeter_t * pxMeter );
+
+/**
+ * @brief                           Add the cycles spent since vAIACycleMeterStart() to the meter.
+ *
+ * @param[in] pxMeter               The cycle meter.
+ */
+void vAIACycleMeterStop( AIACycleMeter_t * pxMeter );
+
+/**
+ * @brief                           Get the average cycles per run.
+ *
+ * @param[in] pxMeter               The cycle meter.
+ *
+ * @return                          The average, or 0 if nothing has been measured.
+ */
+uint32_t ulAIACycleMeterAverage( const AIACycleMeter_t * pxMeter );
+
+/**
+ * @brief                           Get log2 of a value in Q8, interpolating linearly between powers of two.
+ *
+ * Audio levels are compared as log2 of their energy, so that no division or floating point is needed per frame.
+ * 1 dB is 85 in these units.
+ *
+ * @param[in] ullValue              The value.
+ *
+ * @return                          log2 of the value in Q8, or 0 if the value is 0.
+ */
+int32_t lAIALog2Q8( uint64_t ullValue );
+
 #endif /* _AIA_UTILS_H_ */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "aia_vad.h"
+#include "aia_utils.h"
+
+/* 1 dB is log2( 10 ) / 10 = 0.332 in log2, i.e. 85 in Q8, see lAIALog2Q8(). */
+#define AIA_VAD_DB_TO_LOG2_Q8( x )      ( ( int32_t )( x ) * 85 )
+
+/* The energy of a full-scale square wave, and the noise floor assumed before any frame has been seen. */
+#define AIA_VAD_FULL_SCALE_Q8           ( 30 << 8 )
+#define AIA_VAD_INITIAL_NOISE_FLOOR     ( AIA_VAD_FULL_SCALE_Q8 - AIA_VAD_DB_TO_LOG2_Q8( 60 ) )
+
+/* Frames no louder than this are never speech, even in a very quiet room: about -75 dBFS. */
+#define AIA_VAD_MIN_SPEECH              ( AIA_VAD_FULL_SCALE_Q8 - AIA_VAD_DB_TO_LOG2_Q8( 75 ) )
+
+/* The noise floor rises by 1/256 of log2 per frame, i.e. about 0.6 dB per second at 20ms frames, and falls by a
+ * quarter of the distance to a quieter frame.
+ */
+#define AIA_VAD_NOISE_RISE              ( 1 )
+#define AIA_VAD_NOISE_FALL_SHIFT        ( 2 )
+
+/* The value of the endpointer once an utterance has ended, so that the end is only reported once. */
+#define AIA_VAD_ENDED                   ( UINT32_MAX )
+
+/* The energy of a frame without its DC offset, as log2 in Q8. */
+static int32_t prvFrameEnergy( const int16_t * psFrame, size_t xSamples )
+{
+    int32_t lSum = 0;
+    uint64_t ullSquares = 0;
+    int32_t lMean;
+    uint64_t ullMeanSquare;
+    uint32_t ulVariance;
+
+    for( size_t i = 0; i < xSamples; i++ )
+    {
+        lSum += psFrame[ i ];
+        ullSquares += ( uint64_t )( ( int32_t )psFrame[ i ] * psFrame[ i ] );
+    }
+
+    lMean = lSum / ( int32_t )xSamples;
+    ullMeanSquare = ullSquares / xSamples;
+    ulVariance = ( uint32_t )( ullMeanSquare - ( uint64_t )( lMean * lMean ) );
+
+    return lAIALog2Q8( ulVariance );
+}
+
+void vAIAVadInit( AIAVad_t * pxVad, uint32_t ulThresholdDb, uint32_t ulOnsetFrames, uint32_t ulHangoverFrames )
+{
+    pxVad->lThreshold = AIA_VAD_DB_TO_LOG2_Q8( ulThresholdDb );
+    pxVad->ulOnsetFrames = ( ulOnsetFrames != 0 ) ? ulOnsetFrames : 1;
+    pxVad->ulHangoverFrames = ( ulHangoverFrames != 0 ) ? ulHangoverFrames : 1;
+    pxVad->lNoiseFloor = AIA_VAD_INITIAL_NOISE_FLOOR;
+    vAIAVadStart( pxVad );
+}
+
+void vAIAVadStart( AIAVad_t * pxVad )
+{
+    pxVad->xSpeechStarted = pdFALSE;
+    pxVad->ulSpeechFrames = 0;
+    pxVad->ulSilenceFrames = 0;
+}
+
+BaseType_t xAIAVadIsSpeech( AIAVad_t * pxVad, const int16_t * psFrame, size_t xSamples )
+{
+    int32_t lEnergy = prvFrameEnergy( psFrame, xSamples );
+    BaseType_t xSpeech;
+
+    xSpeech = ( lEnergy > pxVad->lNoiseFloor + pxVad->lThreshold && lEnergy > AIA_VAD_MIN_SPEECH ) ? pdTRUE : pdFALSE;
+
+    if( lEnergy < pxVad->lNoiseFloor )
+    {
+        pxVad->lNoiseFloor -= ( pxVad->lNoiseFloor - lEnergy ) >> AIA_VAD_NOISE_FALL_SHIFT;
+    }
+    else
+    {
+        pxVad->lNoiseFloor += AIA_VAD_NOISE_RISE;
+    }
+
+    return xSpeech;
+}
+
+BaseType_t xAIAVadEndOfSpeech( AIAVad_t * pxVad, const int16_t * psFrame, size_t xSamples )
+{
+    BaseType_t xSpeech = xAIAVadIsSpeech( pxVad, psFrame, xSamples );
+
+    if( pxVad->ulSilenceFrames == AIA_VAD_ENDED )
+    {
+        return pdFALSE;
+    }
+
+    if( xSpeech == pdTRUE )
+    {
+        pxVad->ulSilenceFrames = 0;
+        if( ++pxVad->ulSpeechFrames >= pxVad->ulOnsetFrames )
+        {
+            pxVad->xSpeechStarted = pdTRUE;
+        }
+        return pdFALSE;
+    }
+
+    pxVad->ulSpeechFrames = 0;
+    if( pxVad->xSpeechStarted == pdTRUE && ++pxVad->ulSilenceFrames >= pxVad->ulHangoverFrames )
+    {
+        pxVad->ulSilenceFrames = AIA_VAD_ENDED;
+        return pdTRUE;
+    }
+
+    return pdFALSE;
+}
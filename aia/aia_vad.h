@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_VAD_H_
+#define _AIA_VAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A fixed-point energy detector telling speech from background noise, and an endpointer finding the end of an
+ * utterance with it. A frame is speech when its energy is some dB above the noise floor. The noise floor follows
+ * quiet frames down quickly and creeps up slowly otherwise, so it adapts to the room across utterances. The end of
+ * speech is a run of hang-over frames without speech, once enough consecutive speech frames have started the
+ * utterance. Energies are kept as log2 in Q8, so there is no division or floating point per frame.
+ */
+typedef struct {
+    /* Settings, see xAIAVadInit(). */
+    int32_t lThreshold;
+    uint32_t ulOnsetFrames;
+    uint32_t ulHangoverFrames;
+
+    /* Kept across utterances. */
+    int32_t lNoiseFloor;
+
+    /* State of the current utterance. */
+    BaseType_t xSpeechStarted;
+    uint32_t ulSpeechFrames;
+    uint32_t ulSilenceFrames;
+} AIAVad_t;
+
+/**
+ * @brief                       Set up a detector.
+ *
+ * @param[out] pxVad            The detector.
+ * @param[in] ulThresholdDb     How far above the noise floor a frame must be to be speech.
+ * @param[in] ulOnsetFrames     Consecutive speech frames that start an utterance.
+ * @param[in] ulHangoverFrames  Frames without speech that end it.
+ */
+void vAIAVadInit( AIAVad_t * pxVad, uint32_t ulThresholdDb, uint32_t ulOnsetFrames, uint32_t ulHangoverFrames );
+
+/**
+ * @brief                       Start a new utterance. The noise floor is kept.
+ *
+ * @param[in] pxVad             The detector.
+ */
+void vAIAVadStart( AIAVad_t * pxVad );
+
+/**
+ * @brief                       Classify a frame and update the noise floor.
+ *
+ * @param[in] pxVad             The detector.
+ * @param[in] psFrame           The samples.
+ * @param[in] xSamples          The number of samples.
+ *
+ * @return                      pdTRUE if the frame is speech.
+ */
+BaseType_t xAIAVadIsSpeech( AIAVad_t * pxVad, const int16_t * psFrame, size_t xSamples );
+
+/**
+ * @brief                       Run the endpointer on the next frame of the utterance.
+ *
+ * @param[in] pxVad             The detector.
+ * @param[in] psFrame           The samples.
+ * @param[in] xSamples          The number of samples.
+ *
+ * @return                      pdTRUE if the utterance ends with this frame. It is reported once per utterance.
+ */
+BaseType_t xAIAVadEndOfSpeech( AIAVad_t * pxVad, const int16_t * psFrame, size_t xSamples );
+
+#endif /* _AIA_VAD_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_wakeword.h"
+
+#if ( aiaconfigCLIENT_WAKEWORD == 1 )
+
+#define AIA_WAKEWORD_PREROLL_FRAMES     ( aiaconfigCLIENT_WAKEWORD_PREROLL_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+static struct {
+    const AIAWakewordEngine_t * pxEngine;
+    /* A ring of the last frames, where ulNext is the frame to be overwritten next. */
+    int16_t sFrames[ AIA_WAKEWORD_PREROLL_FRAMES ][ AIA_MICROPHONE_RAW_FRAME_SAMPLES ];
+    uint32_t ulNext;
+    uint32_t ulCount;
+    BaseType_t xDetected;
+    /* Frames of the wake word, and frames added after it was detected. */
+    uint32_t ulWakeWordFrames;
+    uint32_t ulFramesAfter;
+    uint32_t ulDetections;
+    AIACycleMeter_t xMeter;
+} xWakeword;
+
+void vAIAWakewordSetEngine( const AIAWakewordEngine_t * pxEngine )
+{
+    xWakeword.pxEngine = pxEngine;
+    xWakeword.ulDetections = 0;
+    vAIACycleMeterReset( &xWakeword.xMeter );
+}
+
+const AIAWakewordEngine_t * pxAIAWakewordGetEngine( void )
+{
+    return xWakeword.pxEngine;
+}
+
+void vAIAWakewordReset( void )
+{
+    xWakeword.ulNext = 0;
+    xWakeword.ulCount = 0;
+    xWakeword.xDetected = pdFALSE;
+    xWakeword.ulWakeWordFrames = 0;
+    xWakeword.ulFramesAfter = 0;
+
+    if( xWakeword.pxEngine != NULL && xWakeword.pxEngine->vReset != NULL )
+    {
+        xWakeword.pxEngine->vReset();
+    }
+}
+
+BaseType_t xAIAWakewordProcess( const void * pvFrame )
+{
+    int16_t * psFrame = xWakeword.sFrames[ xWakeword.ulNext ];
+    BaseType_t xDetected = pdFALSE;
+    uint32_t ulWakeWordFrames = 0;
+
+    memcpy( psFrame, pvFrame, AIA_MICROPHONE_RAW_FRAME_SIZE );
+    xWakeword.ulNext = ( xWakeword.ulNext + 1 ) % AIA_WAKEWORD_PREROLL_FRAMES;
+    if( xWakeword.ulCount < AIA_WAKEWORD_PREROLL_FRAMES )
+    {
+        xWakeword.ulCount++;
+    }
+
+    if( xWakeword.xDetected == pdTRUE )
+    {
+        xWakeword.ulFramesAfter++;
+        return pdFALSE;
+    }
+
+    if( xWakeword.pxEngine == NULL )
+    {
+        return pdFALSE;
+    }
+
+    vAIACycleMeterStart( &xWakeword.xMeter );
+    xDetected = xWakeword.pxEngine->xProcess( psFrame, &ulWakeWordFrames );
+    vAIACycleMeterStop( &xWakeword.xMeter );
+
+    if( xDetected == pdTRUE )
+    {
+        xWakeword.xDetected = pdTRUE;
+        xWakeword.ulWakeWordFrames = ulWakeWordFrames;
+        xWakeword.ulDetections++;
+    }
+
+    return xDetected;
+}
+
+uint32_t ulAIAWakewordPrerollFrames( void )
+{
+    return xWakeword.ulCount;
+}
+
+const void * pvAIAWakewordPrerollFrame( uint32_t ulFrame )
+{
+    uint32_t ulOldest = ( xWakeword.ulNext + AIA_WAKEWORD_PREROLL_FRAMES - xWakeword.ulCount ) % AIA_WAKEWORD_PREROLL_FRAMES;
+
+    configASSERT( ulFrame < xWakeword.ulCount );
+
+    return xWakeword.sFrames[ ( ulOldest + ulFrame ) % AIA_WAKEWORD_PREROLL_FRAMES ];
+}
+
+void vAIAWakewordGetIndices( uint32_t * pulBeginFrame, uint32_t * pulEndFrame )
+{
+    uint32_t ulEnd = 0;
+
+    if( xWakeword.ulCount > xWakeword.ulFramesAfter )
+    {
+        ulEnd = xWakeword.ulCount - xWakeword.ulFramesAfter;
+    }
+
+    *pulEndFrame = ulEnd;
+    *pulBeginFrame = ( ulEnd > xWakeword.ulWakeWordFrames ) ? ulEnd - xWakeword.ulWakeWordFrames : 0;
+}
+
+void vAIAWakewordGetStatistics( AIAWakewordStatistics_t * pxStatistics )
+{
+    pxStatistics->ulFrames = xWakeword.xMeter.ulCount;
+    pxStatistics->ulDetections = xWakeword.ulDetections;
+    pxStatistics->ulCyclesAverage = ulAIACycleMeterAverage( &xWakeword.xMeter );
+    pxStatistics->ulCyclesMax = xWakeword.xMeter.ulMax;
+}
+
+#endif /* aiaconfigCLIENT_WAKEWORD == 1 */
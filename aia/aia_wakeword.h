@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _AIA_WAKEWORD_H_
+#define _AIA_WAKEWORD_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "aia_client.h"
+
+/* Runs the keyword spotter between utterances and keeps the pre-roll, i.e. the last aiaconfigCLIENT_WAKEWORD_PREROLL_MS
+ * of microphone audio. Frames are counted from the oldest frame of the pre-roll. These functions are only called
+ * from the microphone task.
+ */
+
+/**
+ * @brief                   Set the spotter to run.
+ *
+ * @param[in] pxEngine      The spotter.
+ */
+void vAIAWakewordSetEngine( const AIAWakewordEngine_t * pxEngine );
+
+/**
+ * @brief                   Get the spotter set with vAIAWakewordSetEngine().
+ *
+ * @return                  The spotter, or NULL if none is set.
+ */
+const AIAWakewordEngine_t * pxAIAWakewordGetEngine( void );
+
+/**
+ * @brief                   Empty the pre-roll and reset the spotter.
+ */
+void vAIAWakewordReset( void );
+
+/**
+ * @brief                   Add a frame to the pre-roll and run the spotter on it.
+ *
+ * Once the wake word has been detected, frames are only added to the pre-roll until vAIAWakewordReset().
+ *
+ * @param[in] pvFrame       A raw frame of AIA_MICROPHONE_RAW_FRAME_SIZE bytes.
+ *
+ * @return                  pdTRUE if the wake word has been detected in this frame.
+ */
+BaseType_t xAIAWakewordProcess( const void * pvFrame );
+
+/**
+ * @brief                   Get the number of frames in the pre-roll.
+ */
+uint32_t ulAIAWakewordPrerollFrames( void );
+
+/**
+ * @brief                   Get a frame of the pre-roll.
+ *
+ * @param[in] ulFrame       The frame, from 0 for the oldest.
+ *
+ * @return                  The frame.
+ */
+const void * pvAIAWakewordPrerollFrame( uint32_t ulFrame );
+
+/**
+ * @brief                   Get where the detected wake word is in the pre-roll.
+ *
+ * The start is 0 if the wake word began before the oldest frame still in the pre-roll.
+ *
+ * @param[out] pulBeginFrame    The first frame of the wake word.
+ * @param[out] pulEndFrame      The frame right after the wake word.
+ */
+void vAIAWakewordGetIndices( uint32_t * pulBeginFrame, uint32_t * pulEndFrame );
+
+typedef struct {
+    /* Frames given to the spotter. */
+    uint32_t ulFrames;
+    uint32_t ulDetections;
+    /* CPU cycles spent in the spotter per frame. */
+    uint32_t ulCyclesAverage;
+    uint32_t ulCyclesMax;
+} AIAWakewordStatistics_t;
+
+/**
+ * @brief                   Get the spotter statistics since vAIAWakewordSetEngine().
+ *
+ * @param[out] pxStatistics The statistics.
+ */
+void vAIAWakewordGetStatistics( AIAWakewordStatistics_t * pxStatistics );
+
+#endif /* _AIA_WAKEWORD_H_ */
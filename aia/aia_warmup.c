@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "aia_warmup.h"
+
+typedef enum {
+    eAIAWarmupCold = 0,
+    eAIAWarmupWarm,
+    eAIAWarmupClaimed,
+} AIAWarmupState_t;
+
+static uint32_t prvTicksToMs( TickType_t xTicks )
+{
+    return ( uint32_t )xTicks * portTICK_PERIOD_MS;
+}
+
+void vAIAWarmupInit( AIAWarmupPolicy_t * pxPolicy, TickType_t xSpeakerHold, TickType_t xMicrophoneHold )
+{
+    memset( pxPolicy, 0, sizeof( *pxPolicy ) );
+    pxPolicy->xPath[ eAIAWarmupSpeaker ].xHold = xSpeakerHold;
+    pxPolicy->xPath[ eAIAWarmupMicrophone ].xHold = xMicrophoneHold;
+}
+
+BaseType_t xAIAWarmupStart( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow )
+{
+    if( pxPolicy->xPath[ xPath ].xHold == 0 || pxPolicy->xPath[ xPath ].ucState == eAIAWarmupClaimed )
+    {
+        return pdFALSE;
+    }
+
+    if( pxPolicy->xPath[ xPath ].ucState == eAIAWarmupWarm )
+    {
+        /* The time already spent warm still counts as extra once the path is claimed or stopped. */
+        pxPolicy->xPath[ xPath ].xStatistics.ulExtraActiveMs += prvTicksToMs( xNow - pxPolicy->xPath[ xPath ].xWarmSince );
+        pxPolicy->xPath[ xPath ].xWarmSince = xNow;
+        return pdFALSE;
+    }
+
+    pxPolicy->xPath[ xPath ].ucState = eAIAWarmupWarm;
+    pxPolicy->xPath[ xPath ].xWarmSince = xNow;
+    pxPolicy->xPath[ xPath ].xStatistics.ulWarmups++;
+
+    return pdTRUE;
+}
+
+BaseType_t xAIAWarmupClaim( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow )
+{
+    AIAWarmupState_t xState = ( AIAWarmupState_t )pxPolicy->xPath[ xPath ].ucState;
+
+    pxPolicy->xPath[ xPath ].ucState = eAIAWarmupClaimed;
+    if( xState == eAIAWarmupWarm )
+    {
+        pxPolicy->xPath[ xPath ].xStatistics.ulHits++;
+        pxPolicy->xPath[ xPath ].xStatistics.ulExtraActiveMs += prvTicksToMs( xNow - pxPolicy->xPath[ xPath ].xWarmSince );
+    }
+
+    return ( xState != eAIAWarmupCold ) ? pdTRUE : pdFALSE;
+}
+
+void vAIAWarmupRelease( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath )
+{
+    if( pxPolicy->xPath[ xPath ].ucState == eAIAWarmupClaimed )
+    {
+        pxPolicy->xPath[ xPath ].ucState = eAIAWarmupCold;
+    }
+}
+
+BaseType_t xAIAWarmupStop( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow, BaseType_t xForce )
+{
+    TickType_t xWarm = xNow - pxPolicy->xPath[ xPath ].xWarmSince;
+
+    if( pxPolicy->xPath[ xPath ].ucState != eAIAWarmupWarm ||
+        ( xForce != pdTRUE && xWarm < pxPolicy->xPath[ xPath ].xHold ) )
+    {
+        return pdFALSE;
+    }
+
+    pxPolicy->xPath[ xPath ].ucState = eAIAWarmupCold;
+    pxPolicy->xPath[ xPath ].xStatistics.ulMisses++;
+    pxPolicy->xPath[ xPath ].xStatistics.ulExtraActiveMs += prvTicksToMs( xWarm );
+
+    return pdTRUE;
+}
+
+TickType_t xAIAWarmupNextExpiry( const AIAWarmupPolicy_t * pxPolicy, TickType_t xNow )
+{
+    TickType_t xNext = portMAX_DELAY;
+
+    for( uint32_t i = 0; i < eAIAWarmupPathNum; i++ )
+    {
+        TickType_t xWarm = xNow - pxPolicy->xPath[ i ].xWarmSince;
+        TickType_t xLeft;
+
+        if( pxPolicy->xPath[ i ].ucState != eAIAWarmupWarm )
+        {
+            continue;
+        }
+
+        xLeft = ( xWarm < pxPolicy->xPath[ i ].xHold ) ? pxPolicy->xPath[ i ].xHold - xWarm : 0;
+        if( xLeft < xNext )
+        {
+            xNext = xLeft;
+        }
+    }
+
+    return xNext;
+}
+
+void vAIAWarmupRecordStartup( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, BaseType_t xWarm, uint32_t ulStartupUs )
+{
+    uint32_t i = ( xWarm == pdTRUE ) ? 1 : 0;
+
+    /* Sums of microseconds wrap after an hour of startup time, well beyond any session. */
+    pxPolicy->xPath[ xPath ].ulStartupUs[ i ] += ulStartupUs;
+    pxPolicy->xPath[ xPath ].ulStartups[ i ]++;
+}
+
+void vAIAWarmupGetStatistics( const AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, AIAWarmupStatistics_t * pxStatistics )
+{
+    const uint32_t * pulSum = pxPolicy->xPath[ xPath ].ulStartupUs;
+    const uint32_t * pulCount = pxPolicy->xPath[ xPath ].ulStartups;
+
+    *pxStatistics = pxPolicy->xPath[ xPath ].xStatistics;
+    pxStatistics->ulColdStartupUs = ( pulCount[ 0 ] != 0 ) ? pulSum[ 0 ] / pulCount[ 0 ] : 0;
+    pxStatistics->ulWarmStartupUs = ( pulCount[ 1 ] != 0 ) ? pulSum[ 1 ] / pulCount[ 1 ] : 0;
+    pxStatistics->ulSavedMs = 0;
+    if( pulCount[ 0 ] != 0 && pulCount[ 1 ] != 0 && pxStatistics->ulColdStartupUs > pxStatistics->ulWarmStartupUs )
+    {
+        pxStatistics->ulSavedMs = ( uint32_t )( ( uint64_t )( pxStatistics->ulColdStartupUs - pxStatistics->ulWarmStartupUs ) *
+                                                pxStatistics->ulHits / 1000UL );
+    }
+}
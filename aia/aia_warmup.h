@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _AIA_WARMUP_H_
+#define _AIA_WARMUP_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A power/latency policy deciding when to start the speaker and the microphone ahead of the directives that need
+ * them. Each path is cold, warm or claimed. A warm path was started speculatively and is stopped once its hold runs
+ * out, unless a directive claims it first. A claimed path is in real use until it is released, and a cold path
+ * claimed is started by the caller as usual. The policy only keeps the books. The caller starts and stops the
+ * hardware, and serializes the calls.
+ */
+typedef enum {
+    eAIAWarmupSpeaker,
+    eAIAWarmupMicrophone,
+    eAIAWarmupPathNum,
+} AIAWarmupPath_t;
+
+typedef struct {
+    /* Speculative starts, those claimed by a directive and those stopped unused. */
+    uint32_t ulWarmups;
+    uint32_t ulHits;
+    uint32_t ulMisses;
+    /* Time the path ran before it was needed, or for nothing. */
+    uint32_t ulExtraActiveMs;
+    /* Average time from a claim to the path carrying audio, from cold and from warm. */
+    uint32_t ulColdStartupUs;
+    uint32_t ulWarmStartupUs;
+    /* The hits times the difference of the two, once both have been measured. */
+    uint32_t ulSavedMs;
+} AIAWarmupStatistics_t;
+
+typedef struct {
+    struct {
+        uint8_t ucState;
+        TickType_t xHold;
+        TickType_t xWarmSince;
+        uint32_t ulStartupUs[ 2 ];
+        uint32_t ulStartups[ 2 ];
+        AIAWarmupStatistics_t xStatistics;
+    } xPath[ eAIAWarmupPathNum ];
+} AIAWarmupPolicy_t;
+
+/**
+ * @brief                       Set up a policy with every path cold.
+ *
+ * @param[out] pxPolicy         The policy.
+ * @param[in] xSpeakerHold      How long the speaker stays warm without being claimed.
+ * @param[in] xMicrophoneHold   How long the microphone stays warm without being claimed.
+ */
+void vAIAWarmupInit( AIAWarmupPolicy_t * pxPolicy, TickType_t xSpeakerHold, TickType_t xMicrophoneHold );
+
+/**
+ * @brief                       Ask for a path to be warmed up, as a directive needing it is likely to come soon.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ * @param[in] xNow              The current tick count.
+ *
+ * @return                      pdTRUE if the caller is to start the path now. A warm path gets its hold renewed.
+ */
+BaseType_t xAIAWarmupStart( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow );
+
+/**
+ * @brief                       Claim a path for a directive.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ * @param[in] xNow              The current tick count.
+ *
+ * @return                      pdTRUE if the path is running already, and pdFALSE if the caller is to start it.
+ */
+BaseType_t xAIAWarmupClaim( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow );
+
+/**
+ * @brief                       Release a claimed path, once the caller has stopped it.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ */
+void vAIAWarmupRelease( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath );
+
+/**
+ * @brief                       Cool a warm path down.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ * @param[in] xNow              The current tick count.
+ * @param[in] xForce            pdTRUE to cool it down even if its hold has not run out, as it will not be needed.
+ *
+ * @return                      pdTRUE if the caller is to stop the path now.
+ */
+BaseType_t xAIAWarmupStop( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, TickType_t xNow, BaseType_t xForce );
+
+/**
+ * @brief                       Get when xAIAWarmupStop() is next to be called.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xNow              The current tick count.
+ *
+ * @return                      The ticks until the first hold runs out, or portMAX_DELAY if no path is warm.
+ */
+TickType_t xAIAWarmupNextExpiry( const AIAWarmupPolicy_t * pxPolicy, TickType_t xNow );
+
+/**
+ * @brief                       Record how long a claimed path took to carry audio.
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ * @param[in] xWarm             What xAIAWarmupClaim() returned.
+ * @param[in] ulStartupUs       The time from the claim to the first audio.
+ */
+void vAIAWarmupRecordStartup( AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, BaseType_t xWarm, uint32_t ulStartupUs );
+
+/**
+ * @brief                       Get the statistics of a path since vAIAWarmupInit().
+ *
+ * @param[in] pxPolicy          The policy.
+ * @param[in] xPath             The path.
+ * @param[out] pxStatistics     The statistics.
+ */
+void vAIAWarmupGetStatistics( const AIAWarmupPolicy_t * pxPolicy, AIAWarmupPath_t xPath, AIAWarmupStatistics_t * pxStatistics );
+
+#endif /* _AIA_WARMUP_H_ */
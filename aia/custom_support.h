@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* This header is included by Opus' os_support.h when the library is built with CUSTOM_SUPPORT.
+ * The file name is fixed by Opus, which is why it does not follow the aia_ prefix.
+ */
+
+#ifndef _AIA_OPUS_CUSTOM_SUPPORT_H_
+#define _AIA_OPUS_CUSTOM_SUPPORT_H_
+
+#include <stddef.h>
+
+/* Serve the Opus pseudo-stack (NONTHREADSAFE_PSEUDOSTACK) from a static arena instead of the heap. */
+#define OVERRIDE_OPUS_ALLOC_SCRATCH
+
+extern void * pvAIAOpusScratchAlloc( size_t xSize );
+
+#define opus_alloc_scratch( size )      pvAIAOpusScratchAlloc( size )
+
+#endif /* _AIA_OPUS_CUSTOM_SUPPORT_H_ */
@@ -21,6 +21,7 @@
  */
 
 #include "aia_client.h"
+#include "aia_publish.h"
 
 #define MQTT_KEEP_ALIVE_INTERVAL_SECONDS        ( 1200UL )
 #define MQTT_TIMEOUT_MILLISECONDS               ( 5000UL )
@@ -45,6 +46,8 @@ static BaseType_t prvEstablishMqttConnection( bool awsIotMqttMode,
     xNetworkInfo.u.setup.pNetworkServerInfo = pNetworkServerInfo;
     xNetworkInfo.u.setup.pNetworkCredentialInfo = pNetworkCredentialInfo;
     xNetworkInfo.pNetworkInterface = pNetworkInterface;
+    /* The AIA client builds its messages straight into the PUBLISH packets. */
+    xNetworkInfo.pMqttSerializer = &xAIAMqttSerializer;
 
     /* Set the members of the connection info not set by the initializer. */
     xConnectInfo.awsIotMqttMode = awsIotMqttMode;
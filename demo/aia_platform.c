@@ -22,17 +22,39 @@
 
 #include "aia_platform.h"
 #include "aia_client.h"
+#include "aia_client_config.h"
 #include "task.h"
 #include "cycfg.h"
 #include "cycfg_capsense.h"
 
 #define CAPSENSE_INTERRUPT_PRIORITY     ( 7u )
-#define CAPSENSE_SCAN_TASK_PRIORITY     ( configMAX_PRIORITIES - 1 )
+/* Below the audio tasks of the client, which a scan only waits for until they block. */
+#define CAPSENSE_SCAN_TASK_PRIORITY     ( tskIDLE_PRIORITY + 2 )
 #define CAPSENSE_SCAN_TASK_STACK_SIZE   ( configMINIMAL_STACK_SIZE )
+/* A touch is seen within one interval plus a scan. The scan task wakes up from the CapSense interrupt once a scan is
+ * done, so it does not poll for the result. The ON_DEBOUNCE of Button1 in design.cycapsense is 3 scans, so a touch
+ * has to last 20 to 30ms to be reported, at the third scan that sees it.
+ */
 #define CAPSENSE_SCAN_INTERVAL_MS       ( 10u )
+/* Bounds the wait for a scan, should its interrupt get lost. */
+#define CAPSENSE_SCAN_TIMEOUT_MS        ( 10u )
+
+/* The PDM/PCM block of the board captures its one microphone, and the record DMA moves a single channel. */
+#if ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS != 1 )
+#error "This board captures one microphone, it cannot give the client an interleaved array."
+#endif
+
+/* PDM_PCM_config and DMA_Record_Descriptor_0_config are generated by the Device Configurator for 16kHz 16-bit
+ * samples. Other capture formats need both generated again, with the clock dividers, word length and transfer size
+ * that go with them.
+ */
+#if ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE != AUDIO_SAMPLE_RATE_16KHZ ) || \
+    ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RESOLUTION != 16 )
+#error "The PDM/PCM block and the record DMA of this board are configured for 16kHz 16-bit capture only."
+#endif
 
-/* Samples transferred by DMA each time. */
-#define DMA_RECORD_BUFFER_SAMPLES       ( 320 )
+/* Samples transferred by DMA each time. This must be one 20ms frame of the client microphone. */
+#define DMA_RECORD_BUFFER_SAMPLES       ( aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS / 1000 )
 
 /* Samples stored in buffer to be sent to I2S by DMA each time. */
 /* As the data stored in buffer is mono-channel audio, DMA is configured as
@@ -42,6 +64,9 @@
 #define DMA_PLAY_BUFFER_SAMPLES         ( 160 )
 
 /* Buffers used by DMAs .*/
+/* The record DMA writes straight into the client microphone messages. This buffer only takes the frames the client
+ * has no room for.
+ */
 static uint16_t DMARecordBuffer[ DMA_RECORD_BUFFER_SAMPLES ];
 static uint16_t DMAPlayBuffer[ DMA_PLAY_BUFFER_SAMPLES ];
 
@@ -50,6 +75,8 @@ static bool openPlatformMicrophone = false;
 static bool openPlatformSpeaker = false;
 static bool enablePlatformTouchButton = false;
 
+static TaskHandle_t xCapsenseScanTaskHandle;
+
 static uint32_t blinkInterval, blinkCount;
 
 static void prvCapsenseIsr( void );
@@ -63,24 +90,57 @@ static void LEDBlinkyIsrHandler( void );
 
 static void prvCapsenseIsr( void )
 {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
     Cy_CapSense_InterruptHandler( CYBSP_CSD_HW, &cy_capsense_context );
+
+    /* Hand the result to the scan task as soon as the scan is done. */
+    if( CY_CAPSENSE_NOT_BUSY == Cy_CapSense_IsBusy( &cy_capsense_context ) && xCapsenseScanTaskHandle != NULL )
+    {
+        vTaskNotifyGiveFromISR( xCapsenseScanTaskHandle, &xHigherPriorityTaskWoken );
+    }
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
 
 static void prvProcessTouch( void )
 {
     uint32_t button1_status;
     static uint32_t button1_status_prev;
+    static bool button1_pressed;
+    const cy_stc_capsense_widget_config_t * button1 = &cy_capsense_context.ptrWdConfig[ CY_CAPSENSE_BUTTON1_WDGT_ID ];
+    bool button1_touched;
+    static bool button1_touched_prev;
+    static uint32_t button1_touch_down_cycles;
 
     /* Get button 1 status */
     button1_status = Cy_CapSense_IsSensorActive( CY_CAPSENSE_BUTTON1_WDGT_ID,
                                                  CY_CAPSENSE_BUTTON1_SNS0_ID,
                                                  &cy_capsense_context );
 
-    /* Detect if button has been tapped, i.e. pressed and released */
+    /* The status is debounced. Time the touch-down from the first scan over the finger threshold instead. */
+    button1_touched = ( button1->ptrSnsContext[ CY_CAPSENSE_BUTTON1_SNS0_ID ].diff >= button1->ptrWdContext->fingerTh );
+    if( button1_touched == true && button1_touched_prev == false && 0u == button1_status )
+    {
+        button1_touch_down_cycles = ulPlatformGetCycleCount();
+    }
+    button1_touched_prev = button1_touched;
+
+    /* Report the touch-down, so that the client can open the microphone before the button is released. */
+    if( ( 0u == button1_status_prev ) &&
+            ( 0u != button1_status ) &&
+            enablePlatformTouchButton == true )
+    {
+        button1_pressed = true;
+        vClientButtonPressed( button1_touch_down_cycles );
+    }
+
+    /* Every press reported is released, even if the button has been disabled since. */
     if( ( 0u != button1_status_prev ) &&
-            ( 0u == button1_status ) )
+            ( 0u == button1_status ) &&
+            button1_pressed == true )
     {
-        vClientButtonTapped();
+        button1_pressed = false;
+        vClientButtonReleased();
     }
 
     button1_status_prev = button1_status;
@@ -89,25 +149,23 @@ static void prvProcessTouch( void )
 static void vCapsenseScanTask( void * p )
 {
     Cy_CapSense_SetupWidget( CY_CAPSENSE_BUTTON1_WDGT_ID , &cy_capsense_context );
-    Cy_CapSense_Scan( &cy_capsense_context );
 
     for( ;; )
     {
-        vTaskDelay( pdMS_TO_TICKS( CAPSENSE_SCAN_INTERVAL_MS ) );
+        /* Start a scan and wait for its interrupt */
+        Cy_CapSense_Scan( &cy_capsense_context );
+        ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( CAPSENSE_SCAN_TIMEOUT_MS ) );
 
-        /* Check if CapSense is busy with a previous scan */
-        if( CY_CAPSENSE_NOT_BUSY == Cy_CapSense_IsBusy( &cy_capsense_context )
-                && enablePlatformTouchButton == true )
+        if( CY_CAPSENSE_NOT_BUSY == Cy_CapSense_IsBusy( &cy_capsense_context ) )
         {
             /* Process widget */
             Cy_CapSense_ProcessWidget( CY_CAPSENSE_BUTTON1_WDGT_ID, &cy_capsense_context );
 
             /* Process touch input */
             prvProcessTouch();
-
-            /* Start next scan */
-            Cy_CapSense_Scan( &cy_capsense_context );
         }
+
+        vTaskDelay( pdMS_TO_TICKS( CAPSENSE_SCAN_INTERVAL_MS ) );
     }
 }
 
@@ -146,7 +204,7 @@ BaseType_t xPlatformTouchButtonInit( void )
                                  CAPSENSE_SCAN_TASK_STACK_SIZE,
                                  NULL,
                                  CAPSENSE_SCAN_TASK_PRIORITY,
-                                 NULL );
+                                 &xCapsenseScanTaskHandle );
     }
 
     return xReturned;
@@ -246,8 +304,14 @@ void vPlatformLEDBlink( uint32_t interval_ms )
     Cy_TCPWM_TriggerStart( Cont_1ms_HW, Cont_1ms_MASK );
 }
 
+static void prvSetRecordDestination( void * pvFrame )
+{
+    Cy_DMA_Descriptor_SetDstAddress( &DMA_Record_Descriptor_0, ( pvFrame != NULL ) ? pvFrame : ( void * ) DMARecordBuffer );
+}
+
 void vPlatformMicrophoneOpen( void )
 {
+    prvSetRecordDestination( pvClientMicrophoneFrame() );
     Cy_PDM_PCM_ClearFifo( PDM_PCM_HW );
     Cy_PDM_PCM_Enable( PDM_PCM_HW );
     Cy_DMA_Channel_Enable( DMA_Record_HW, DMA_Record_CHANNEL );
@@ -282,6 +346,19 @@ void vPlatformTouchButtonDisable( void )
     enablePlatformTouchButton = false;
 }
 
+uint32_t ulPlatformGetCycleCount( void )
+{
+    /* The DWT cycle counter is not running out of reset. */
+    if( ( DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk ) == 0 )
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    return DWT->CYCCNT;
+}
+
 /* ISRs */
 
 static void I2SIsrHandler( void )
@@ -306,7 +383,7 @@ static void DMARecordIsrHandler( void )
     }
     else
     {
-        xClientFillMicrophoneBufferFromISR( DMARecordBuffer, sizeof( DMARecordBuffer ), &xHigherPriorityTaskWoken );
+        prvSetRecordDestination( pvClientMicrophoneFrameCapturedFromISR( &xHigherPriorityTaskWoken ) );
 
         Cy_DMA_Channel_Enable( DMA_Record_HW, DMA_Record_CHANNEL );
     }
@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The service side of AIA for the host tests. Messages are encrypted with AES-256-GCM under the X25519 secret of
+ * the service key pair and the client public key, both from aia_test_keys.h, independently of aia_crypto.c.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nettle/base64.h>
+#include <nettle/curve25519.h>
+#include <nettle/gcm.h>
+
+#include "aia_client_priv.h"
+#include "aia_test_keys.h"
+#include "aia_service.h"
+#include "host.h"
+
+#define SERVICE_EVENT_NAMES             ( 32U )
+#define SERVICE_EVENT_NAME_MAX          ( 32U )
+#define SERVICE_MESSAGE_MAX             ( 8192U )
+/* A reply starts with 500ms of audio at once, which fits the speaker buffer of the low-memory profile. */
+#define SERVICE_SPEAKER_AHEAD_FRAMES    ( 25U )
+
+#if ( aiaconfigCLIENT_MICROPHONE_ENCODER_OPUS == 1 )
+#define SERVICE_MICROPHONE_BYTES_PER_MS ( aiaconfigCLIENT_MICROPHONE_ENCODER_BITRATE / 8000UL )
+#else
+#define SERVICE_MICROPHONE_BYTES_PER_MS ( 32UL )
+#endif
+
+typedef struct {
+    char cName[ SERVICE_EVENT_NAME_MAX ];
+    uint32_t ulCount;
+} ServiceEventCount_t;
+
+static struct {
+    pthread_mutex_t xLock;
+    pthread_cond_t xChanged;
+    struct gcm_aes256_ctx xGcm;
+    uint64_t ullIv;
+    BaseType_t xAcceptCapabilities;
+    AIAServiceStats_t xStats;
+    ServiceEventCount_t xEvents[ SERVICE_EVENT_NAMES ];
+    /* Sequence numbers expected from the client, per topic. */
+    uint32_t ulEventSequence;
+    uint32_t ulMicrophoneSequence;
+    /* Sequence numbers of what the service sends, per topic. */
+    uint32_t ulDirectiveSequence;
+    uint32_t ulSpeakerSequence;
+    uint32_t ulCapabilitiesAckSequence;
+    uint64_t ullSpeakerOffset;
+    AIAServiceMicrophoneHook_t xMicrophoneHook;
+    AIAServiceEventHook_t xEventHook;
+} xService = {
+    .xLock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void prvDecodeKey( const char * pcKey, uint8_t * pucKey )
+{
+    struct base64_decode_ctx xCtx;
+    size_t xLength = CURVE25519_SIZE;
+
+    base64_decode_init( &xCtx );
+    base64_decode_update( &xCtx, &xLength, pucKey, strlen( pcKey ), pcKey );
+    configASSERT( base64_decode_final( &xCtx ) == 1 && xLength == CURVE25519_SIZE );
+}
+
+static void prvDeadline( struct timespec * pxDeadline, uint32_t ulTimeoutMs )
+{
+    clock_gettime( CLOCK_MONOTONIC, pxDeadline );
+    pxDeadline->tv_sec += ulTimeoutMs / 1000;
+    pxDeadline->tv_nsec += ( long )( ulTimeoutMs % 1000 ) * 1000000L;
+    if( pxDeadline->tv_nsec >= 1000000000L )
+    {
+        pxDeadline->tv_sec++;
+        pxDeadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Called with the lock held. */
+static ServiceEventCount_t * prvEvent( const char * pcName, size_t xLength )
+{
+    for( int i = 0; i < SERVICE_EVENT_NAMES; i++ )
+    {
+        if( xService.xEvents[ i ].cName[ 0 ] == '\0' )
+        {
+            if( xLength >= SERVICE_EVENT_NAME_MAX )
+            {
+                xLength = SERVICE_EVENT_NAME_MAX - 1;
+            }
+            memcpy( xService.xEvents[ i ].cName, pcName, xLength );
+            return &xService.xEvents[ i ];
+        }
+        if( strlen( xService.xEvents[ i ].cName ) == xLength && memcmp( xService.xEvents[ i ].cName, pcName, xLength ) == 0 )
+        {
+            return &xService.xEvents[ i ];
+        }
+    }
+    configASSERT( 0 );
+    return NULL;
+}
+
+static size_t prvDecrypt( const uint8_t * pucPayload, size_t xLength, uint8_t * pucPlaintext, uint32_t * pulSequence )
+{
+    const AIAMessage_t * pxMessage = ( const AIAMessage_t * )pucPayload;
+    size_t xCiphertextLength;
+    uint8_t ucTag[ AIA_MSG_PARAMS_SIZE_MAC ];
+
+    if( xLength < sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ || xLength - sizeof( AIAMessage_t ) > SERVICE_MESSAGE_MAX )
+    {
+        return 0;
+    }
+    xCiphertextLength = xLength - sizeof( AIAMessage_t );
+
+    gcm_aes256_set_iv( &xService.xGcm, AIA_MSG_PARAMS_SIZE_IV, pxMessage->iv );
+    gcm_aes256_decrypt( &xService.xGcm, xCiphertextLength, pucPlaintext, pxMessage->ciphertext );
+    gcm_aes256_digest( &xService.xGcm, sizeof( ucTag ), ucTag );
+    if( memcmp( ucTag, pxMessage->mac, sizeof( ucTag ) ) != 0 ||
+        memcmp( pucPlaintext, pxMessage->sequence, AIA_MSG_PARAMS_SIZE_SEQ ) != 0 )
+    {
+        return 0;
+    }
+
+    memcpy( pulSequence, pucPlaintext, AIA_MSG_PARAMS_SIZE_SEQ );
+    return xCiphertextLength;
+}
+
+static void prvSendEncrypted( const char * pcTopic, uint32_t * pulSequence, const void * pvMessage, size_t xLength )
+{
+    static uint8_t ucPacket[ sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + SERVICE_MESSAGE_MAX ];
+    static uint8_t ucPlaintext[ AIA_MSG_PARAMS_SIZE_SEQ + SERVICE_MESSAGE_MAX ];
+    AIAMessage_t * pxMessage = ( AIAMessage_t * )ucPacket;
+
+    configASSERT( xLength <= SERVICE_MESSAGE_MAX );
+
+    pthread_mutex_lock( &xService.xLock );
+    memcpy( ucPlaintext, pulSequence, AIA_MSG_PARAMS_SIZE_SEQ );
+    memcpy( ucPlaintext + AIA_MSG_PARAMS_SIZE_SEQ, pvMessage, xLength );
+    memcpy( pxMessage->sequence, pulSequence, AIA_MSG_PARAMS_SIZE_SEQ );
+    memset( pxMessage->iv, 0, AIA_MSG_PARAMS_SIZE_IV );
+    xService.ullIv++;
+    memcpy( pxMessage->iv, &xService.ullIv, sizeof( xService.ullIv ) );
+    ( *pulSequence )++;
+
+    gcm_aes256_set_iv( &xService.xGcm, AIA_MSG_PARAMS_SIZE_IV, pxMessage->iv );
+    gcm_aes256_encrypt( &xService.xGcm, AIA_MSG_PARAMS_SIZE_SEQ + xLength, pxMessage->ciphertext, ucPlaintext );
+    gcm_aes256_digest( &xService.xGcm, AIA_MSG_PARAMS_SIZE_MAC, pxMessage->mac );
+
+    /* Delivered in order, from a copy. */
+    vHostMqttDeliver( pcTopic, ucPacket, AIA_MSG_ENCRYPTED_LENGTH( xLength ) );
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+static void prvHandleEvent( const char * pcMessage, size_t xLength )
+{
+    char cName[ SERVICE_EVENT_NAME_MAX ];
+    const char * pcName = memmem( pcMessage, xLength, "\"name\":\"", 8 );
+    const char * pcEnd;
+    char cReply[ 160 ];
+    int lReply = 0;
+
+    if( pcName == NULL )
+    {
+        return;
+    }
+    pcName += 8;
+    pcEnd = memchr( pcName, '"', pcMessage + xLength - pcName );
+    if( pcEnd == NULL )
+    {
+        return;
+    }
+
+    snprintf( cName, sizeof( cName ), "%.*s", ( int )( pcEnd - pcName ), pcName );
+    if( strcmp( cName, "BufferStateChanged" ) == 0 )
+    {
+        if( memmem( pcMessage, xLength, "\"OVERRUN\"", 9 ) != NULL )
+        {
+            xService.xStats.ulOverruns++;
+        }
+        else if( memmem( pcMessage, xLength, "\"UNDERRUN\"", 10 ) != NULL )
+        {
+            xService.xStats.ulUnderruns++;
+        }
+    }
+    else if( strcmp( cName, "SynchronizeState" ) == 0 )
+    {
+        lReply = snprintf( cReply, sizeof( cReply ),
+                           "{\"directives\":[{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"sync\"},"
+                           "\"payload\":{\"state\":\"IDLE\"}}]}" );
+    }
+
+    xService.xStats.ulEvents++;
+    prvEvent( cName, strlen( cName ) )->ulCount++;
+    if( xService.xEventHook != NULL )
+    {
+        xService.xEventHook( cName, pcMessage, xLength );
+    }
+
+    if( lReply > 0 )
+    {
+        pthread_mutex_unlock( &xService.xLock );
+        prvSendEncrypted( AIA_TOPIC_DIRECTIVE, &xService.ulDirectiveSequence, cReply, ( size_t )lReply );
+        pthread_mutex_lock( &xService.xLock );
+    }
+}
+
+static void prvHandleMicrophone( const uint8_t * pucMessage, size_t xLength )
+{
+    AIABinaryHeader_t xHeader;
+    uint64_t ullOffset;
+
+    if( xLength < sizeof( xHeader ) + sizeof( ullOffset ) )
+    {
+        return;
+    }
+    memcpy( &xHeader, pucMessage, sizeof( xHeader ) );
+    memcpy( &ullOffset, pucMessage + sizeof( xHeader ), sizeof( ullOffset ) );
+
+    if( xService.xStats.ulMicrophoneMessages != 0 && ullOffset != xService.xStats.ullMicrophoneOffset )
+    {
+        xService.xStats.ulMicrophoneOffsetJumps++;
+        if( ullOffset > xService.xStats.ullMicrophoneOffset )
+        {
+            xService.xStats.ullMicrophoneBytesSkipped += ullOffset - xService.xStats.ullMicrophoneOffset;
+        }
+    }
+    if( xService.xMicrophoneHook != NULL && xHeader.ulLength >= sizeof( ullOffset ) &&
+        xLength >= sizeof( xHeader ) + xHeader.ulLength )
+    {
+        xService.xMicrophoneHook( ullOffset, pucMessage + sizeof( xHeader ) + sizeof( ullOffset ), xHeader.ulLength - sizeof( ullOffset ) );
+    }
+    xService.xStats.ulMicrophoneMessages++;
+    xService.xStats.ullMicrophoneBytes += xHeader.ulLength - sizeof( ullOffset );
+    xService.xStats.ullMicrophoneOffset = ullOffset + xHeader.ulLength - sizeof( ullOffset );
+}
+
+static void prvBroker( const char * pcTopic, size_t xTopicLength, const uint8_t * pucPayload, size_t xLength )
+{
+    static uint8_t ucPlaintext[ SERVICE_MESSAGE_MAX ];
+    char cTopic[ 128 ];
+    uint32_t ulSequence;
+    size_t xPlaintextLength;
+
+    snprintf( cTopic, sizeof( cTopic ), "%.*s", ( int )xTopicLength, pcTopic );
+    if( strcmp( cTopic, AIA_TOPIC_CONNECTION_CLI ) == 0 )
+    {
+        static const char cAck[] = "{\"header\":{\"name\":\"Acknowledge\",\"messageId\":\"1\"},"
+                                   "\"payload\":{\"connectMessageId\":\"0\",\"code\":\"CONNECTION_ESTABLISHED\"}}";
+
+        if( memmem( pucPayload, xLength, "\"Connect\"", 9 ) != NULL )
+        {
+            pthread_mutex_lock( &xService.xLock );
+            xService.ulEventSequence = 0;
+            xService.ulMicrophoneSequence = 0;
+            vHostMqttDeliver( AIA_TOPIC_CONNECTION_SER, cAck, sizeof( cAck ) - 1 );
+            pthread_mutex_unlock( &xService.xLock );
+        }
+        return;
+    }
+
+    pthread_mutex_lock( &xService.xLock );
+    xPlaintextLength = prvDecrypt( pucPayload, xLength, ucPlaintext, &ulSequence );
+    if( xPlaintextLength == 0 )
+    {
+        xService.xStats.ulDecryptFailures++;
+    }
+    else if( strcmp( cTopic, AIA_TOPIC_CAPABILITIES_PUB ) == 0 )
+    {
+        char cAck[ 160 ];
+        int lAck = snprintf( cAck, sizeof( cAck ),
+                             "{\"header\":{\"name\":\"Acknowledge\",\"messageId\":\"2\"},"
+                             "\"payload\":{\"messageId\":\"cap\",\"code\":\"%s\"}}",
+                             ( xService.xAcceptCapabilities == pdTRUE ) ? "CAPABILITIES_ACCEPTED" : "CAPABILITIES_REJECTED" );
+
+        const char * pcThreshold = memmem( ucPlaintext, xPlaintextLength, "\"underrunWarningThreshold\":", 27 );
+
+        if( pcThreshold != NULL )
+        {
+            xService.xStats.ulUnderrunWarningThreshold = ( uint32_t )strtoul( pcThreshold + 27, NULL, 10 );
+        }
+        if( xService.xAcceptCapabilities == pdTRUE )
+        {
+            xService.xStats.ulCapabilitiesAccepted++;
+        }
+        else
+        {
+            xService.xStats.ulCapabilitiesRejected++;
+        }
+        pthread_mutex_unlock( &xService.xLock );
+        prvSendEncrypted( AIA_TOPIC_CAPABILITIES_ACK, &xService.ulCapabilitiesAckSequence, cAck, ( size_t )lAck );
+        pthread_mutex_lock( &xService.xLock );
+    }
+    else if( strcmp( cTopic, AIA_TOPIC_EVENT ) == 0 )
+    {
+        if( ulSequence != xService.ulEventSequence )
+        {
+            xService.xStats.ulSequenceErrors++;
+        }
+        xService.ulEventSequence = ulSequence + 1;
+        prvHandleEvent( ( const char * )ucPlaintext + AIA_MSG_PARAMS_SIZE_SEQ, xPlaintextLength - AIA_MSG_PARAMS_SIZE_SEQ );
+    }
+    else if( strcmp( cTopic, AIA_TOPIC_MICROPHONE ) == 0 )
+    {
+        if( ulSequence != xService.ulMicrophoneSequence )
+        {
+            xService.xStats.ulSequenceErrors++;
+        }
+        xService.ulMicrophoneSequence = ulSequence + 1;
+        prvHandleMicrophone( ucPlaintext + AIA_MSG_PARAMS_SIZE_SEQ, xPlaintextLength - AIA_MSG_PARAMS_SIZE_SEQ );
+    }
+    pthread_cond_broadcast( &xService.xChanged );
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+void vAIAServiceInit( BaseType_t xAcceptCapabilities )
+{
+    uint8_t ucPrivate[ CURVE25519_SIZE ];
+    uint8_t ucPeer[ CURVE25519_SIZE ];
+    uint8_t ucSecret[ CURVE25519_SIZE ];
+    pthread_condattr_t xAttr;
+
+    pthread_condattr_init( &xAttr );
+    pthread_condattr_setclock( &xAttr, CLOCK_MONOTONIC );
+    pthread_cond_init( &xService.xChanged, &xAttr );
+    pthread_condattr_destroy( &xAttr );
+
+    prvDecodeKey( aiatestSERVICE_PRIVATE_KEY, ucPrivate );
+    prvDecodeKey( aiaconfigCLIENT_PUBLIC_KEY, ucPeer );
+    curve25519_mul( ucSecret, ucPrivate, ucPeer );
+    gcm_aes256_set_key( &xService.xGcm, ucSecret );
+
+    xService.xAcceptCapabilities = xAcceptCapabilities;
+    vHostMqttSetBroker( prvBroker );
+}
+
+void vAIAServiceSetAcceptCapabilities( BaseType_t xAcceptCapabilities )
+{
+    pthread_mutex_lock( &xService.xLock );
+    xService.xAcceptCapabilities = xAcceptCapabilities;
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+void vAIAServiceStats( AIAServiceStats_t * pxStats )
+{
+    pthread_mutex_lock( &xService.xLock );
+    *pxStats = xService.xStats;
+    pxStats->ulSpeakerSequence = xService.ulSpeakerSequence;
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+BaseType_t xAIAServiceWaitForEvent( const char * pcName, uint32_t ulCount, uint32_t ulTimeoutMs )
+{
+    struct timespec xDeadline;
+    BaseType_t xReturned = pdPASS;
+
+    prvDeadline( &xDeadline, ulTimeoutMs );
+    pthread_mutex_lock( &xService.xLock );
+    while( prvEvent( pcName, strlen( pcName ) )->ulCount < ulCount )
+    {
+        if( pthread_cond_timedwait( &xService.xChanged, &xService.xLock, &xDeadline ) != 0 )
+        {
+            xReturned = ( prvEvent( pcName, strlen( pcName ) )->ulCount < ulCount ) ? pdFAIL : pdPASS;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &xService.xLock );
+
+    if( xReturned != pdPASS )
+    {
+        printf( "Service: timed out waiting for %s #%u\n", pcName, ulCount );
+    }
+    return xReturned;
+}
+
+void vAIAServiceSetMicrophoneHook( AIAServiceMicrophoneHook_t xHook )
+{
+    pthread_mutex_lock( &xService.xLock );
+    xService.xMicrophoneHook = xHook;
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+void vAIAServiceSetEventHook( AIAServiceEventHook_t xHook )
+{
+    pthread_mutex_lock( &xService.xLock );
+    xService.xEventHook = xHook;
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+BaseType_t xAIAServiceWaitForMicrophone( uint64_t ullBytes, uint32_t ulTimeoutMs )
+{
+    struct timespec xDeadline;
+    BaseType_t xReturned = pdPASS;
+
+    prvDeadline( &xDeadline, ulTimeoutMs );
+    pthread_mutex_lock( &xService.xLock );
+    while( xService.xStats.ullMicrophoneBytes < ullBytes )
+    {
+        if( pthread_cond_timedwait( &xService.xChanged, &xService.xLock, &xDeadline ) != 0 )
+        {
+            xReturned = ( xService.xStats.ullMicrophoneBytes < ullBytes ) ? pdFAIL : pdPASS;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &xService.xLock );
+
+    if( xReturned != pdPASS )
+    {
+        printf( "Service: timed out waiting for %llu bytes of microphone audio\n", ( unsigned long long )ullBytes );
+    }
+    return xReturned;
+}
+
+void vAIAServiceSendDirectives( const char * pcDirectives )
+{
+    char cMessage[ 1024 ];
+    int lLength = snprintf( cMessage, sizeof( cMessage ), "{\"directives\":[%s]}", pcDirectives );
+
+    configASSERT( lLength > 0 && lLength < sizeof( cMessage ) );
+    prvSendEncrypted( AIA_TOPIC_DIRECTIVE, &xService.ulDirectiveSequence, cMessage, ( size_t )lLength );
+}
+
+void vAIAServiceSendSpeaker( uint64_t ullOffset, uint32_t ulFrames, uint32_t ulFramesPerMessage, uint32_t ulPaceMs )
+{
+    static uint8_t ucMessage[ SERVICE_MESSAGE_MAX ];
+    AIABinaryHeader_t xHeader = { 0 };
+
+    configASSERT( sizeof( xHeader ) + sizeof( ullOffset ) + ulFramesPerMessage * AIA_SPEAKER_DECODER_FRAME_SIZE <= sizeof( ucMessage ) );
+
+    while( ulFrames > 0 )
+    {
+        uint32_t ulCount = ( ulFrames < ulFramesPerMessage ) ? ulFrames : ulFramesPerMessage;
+        uint8_t * pucFrame = ucMessage + sizeof( xHeader ) + sizeof( ullOffset );
+
+        xHeader.ulLength = sizeof( ullOffset ) + ulCount * AIA_SPEAKER_DECODER_FRAME_SIZE;
+        xHeader.ucType = 0;
+        xHeader.ucCount = ( uint8_t )( ulCount - 1 );
+        memcpy( ucMessage, &xHeader, sizeof( xHeader ) );
+        memcpy( ucMessage + sizeof( xHeader ), &ullOffset, sizeof( ullOffset ) );
+        for( uint32_t i = 0; i < ulCount; i++, pucFrame += AIA_SPEAKER_DECODER_FRAME_SIZE )
+        {
+            /* Never 0, so that a played frame can be told from silence. */
+            uint16_t usValue = ( uint16_t )( ( ullOffset / AIA_SPEAKER_DECODER_FRAME_SIZE + i ) % 1000U + 1U );
+
+            memset( pucFrame, 0, AIA_SPEAKER_DECODER_FRAME_SIZE );
+            memcpy( pucFrame, &usValue, sizeof( usValue ) );
+        }
+
+        prvSendEncrypted( AIA_TOPIC_SPEAKER, &xService.ulSpeakerSequence, ucMessage, sizeof( xHeader ) + xHeader.ulLength );
+
+        ullOffset += ulCount * AIA_SPEAKER_DECODER_FRAME_SIZE;
+        ulFrames -= ulCount;
+        if( ulPaceMs != 0 && ulFrames > 0 )
+        {
+            usleep( ulPaceMs * 1000U );
+        }
+    }
+
+    pthread_mutex_lock( &xService.xLock );
+    if( ullOffset > xService.ullSpeakerOffset )
+    {
+        xService.ullSpeakerOffset = ullOffset;
+    }
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+void vAIAServiceSendMarker( uint32_t ulMarker )
+{
+    uint8_t ucMessage[ sizeof( AIABinaryHeader_t ) + sizeof( ulMarker ) ];
+    AIABinaryHeader_t xHeader = { 0 };
+
+    xHeader.ulLength = sizeof( ulMarker );
+    xHeader.ucType = 1;
+    memcpy( ucMessage, &xHeader, sizeof( xHeader ) );
+    memcpy( ucMessage + sizeof( xHeader ), &ulMarker, sizeof( ulMarker ) );
+    prvSendEncrypted( AIA_TOPIC_SPEAKER, &xService.ulSpeakerSequence, ucMessage, sizeof( ucMessage ) );
+}
+
+void vAIAServiceSkipSpeakerSequence( uint32_t ulSequence )
+{
+    pthread_mutex_lock( &xService.xLock );
+    xService.ulSpeakerSequence = ulSequence;
+    pthread_mutex_unlock( &xService.xLock );
+}
+
+uint32_t ulAIAServiceEventCount( const char * pcName )
+{
+    uint32_t ulCount;
+
+    pthread_mutex_lock( &xService.xLock );
+    ulCount = prvEvent( pcName, strlen( pcName ) )->ulCount;
+    pthread_mutex_unlock( &xService.xLock );
+    return ulCount;
+}
+
+BaseType_t xAIAServiceConverse( uint32_t ulUtteranceMs, uint32_t ulReplyFrames, uint32_t ulTimeoutMs )
+{
+    AIAServiceStats_t xStats;
+    char cDirectives[ 512 ];
+    uint32_t ulOpened = ulAIAServiceEventCount( "MicrophoneOpened" ) + 1;
+    uint32_t ulSpeakerClosed = ulAIAServiceEventCount( "SpeakerClosed" ) + 1;
+    uint64_t ullOffset;
+    uint32_t ulAhead;
+
+    if( xAIAServiceWaitForEvent( "MicrophoneOpened", ulOpened, ulTimeoutMs ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+    vAIAServiceStats( &xStats );
+    if( xAIAServiceWaitForMicrophone( xStats.ullMicrophoneBytes + ( uint64_t )ulUtteranceMs * SERVICE_MICROPHONE_BYTES_PER_MS,
+                                      ulTimeoutMs ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"CloseMicrophone\",\"messageId\":\"c\"}},"
+                               "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"t\"},\"payload\":{\"state\":\"THINKING\"}}" );
+
+    pthread_mutex_lock( &xService.xLock );
+    ullOffset = xService.ullSpeakerOffset;
+    pthread_mutex_unlock( &xService.xLock );
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullOffset );
+    vAIAServiceSendDirectives( cDirectives );
+
+    /* SERVICE_SPEAKER_AHEAD_FRAMES ahead of the playback, then at its pace. */
+    ulAhead = ( ulReplyFrames < SERVICE_SPEAKER_AHEAD_FRAMES ) ? ulReplyFrames : SERVICE_SPEAKER_AHEAD_FRAMES;
+    vAIAServiceSendSpeaker( ullOffset, ulAhead, 5, 0 );
+    ullOffset += ( uint64_t )ulAhead * AIA_SPEAKER_DECODER_FRAME_SIZE;
+    vAIAServiceSendSpeaker( ullOffset, ulReplyFrames - ulAhead, 5, 5 * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    ullOffset += ( uint64_t )( ulReplyFrames - ulAhead ) * AIA_SPEAKER_DECODER_FRAME_SIZE;
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullOffset );
+    vAIAServiceSendDirectives( cDirectives );
+    if( xAIAServiceWaitForEvent( "SpeakerClosed", ulSpeakerClosed, ulTimeoutMs ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"i\"},\"payload\":{\"state\":\"IDLE\"}}" );
+    return pdPASS;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _AIA_SERVICE_H_
+#define _AIA_SERVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* A scripted AIA service for the host tests. It takes the place of the broker, decrypts what the client publishes
+ * with the keys of aia_test_keys.h, acknowledges the connection and the capabilities, and keeps count of the events
+ * and of the microphone stream. The conversation itself is driven by the test, with the functions below.
+ */
+
+typedef struct {
+    uint32_t ulEvents;
+    uint32_t ulMicrophoneMessages;
+    /* Audio bytes of the microphone stream, in the format of the capabilities. */
+    uint64_t ullMicrophoneBytes;
+    /* Offset following the last microphone message. */
+    uint64_t ullMicrophoneOffset;
+    /* Messages whose offset was not where the previous one ended. */
+    uint32_t ulMicrophoneOffsetJumps;
+    /* Bytes skipped by those jumps. */
+    uint64_t ullMicrophoneBytesSkipped;
+    uint32_t ulDecryptFailures;
+    /* Messages of a topic whose sequence number was not the one following the previous. */
+    uint32_t ulSequenceErrors;
+    uint32_t ulOverruns;
+    uint32_t ulUnderruns;
+    uint32_t ulCapabilitiesAccepted;
+    uint32_t ulCapabilitiesRejected;
+    /* The underrun warning threshold of the last capabilities. */
+    uint32_t ulUnderrunWarningThreshold;
+    /* The sequence number of the next speaker message. */
+    uint32_t ulSpeakerSequence;
+} AIAServiceStats_t;
+
+/* Take over the broker. xAcceptCapabilities decides the code of the capabilities acknowledgement. */
+void vAIAServiceInit( BaseType_t xAcceptCapabilities );
+
+/* Change the code of the capabilities acknowledgements from now on. */
+void vAIAServiceSetAcceptCapabilities( BaseType_t xAcceptCapabilities );
+
+void vAIAServiceStats( AIAServiceStats_t * pxStats );
+
+/* Called with the audio of every microphone message, in the format of the capabilities, on the publishing task and
+ * with the service locked: it must not call the service. NULL removes it.
+ */
+typedef void ( * AIAServiceMicrophoneHook_t )( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength );
+void vAIAServiceSetMicrophoneHook( AIAServiceMicrophoneHook_t xHook );
+
+/* Called with the name and the JSON of every event, in the same way. NULL removes it. */
+typedef void ( * AIAServiceEventHook_t )( const char * pcName, const char * pcJson, size_t xLength );
+void vAIAServiceSetEventHook( AIAServiceEventHook_t xHook );
+
+/* The number of events named pcName since vAIAServiceInit(). */
+uint32_t ulAIAServiceEventCount( const char * pcName );
+
+/* Wait for the ulCount-th event named pcName since vAIAServiceInit(). */
+BaseType_t xAIAServiceWaitForEvent( const char * pcName, uint32_t ulCount, uint32_t ulTimeoutMs );
+
+/* Wait until the microphone stream has brought ullBytes of audio. */
+BaseType_t xAIAServiceWaitForMicrophone( uint64_t ullBytes, uint32_t ulTimeoutMs );
+
+/* Publish one or more directives, given as a comma-separated list of {"header":...} objects. */
+void vAIAServiceSendDirectives( const char * pcDirectives );
+
+/* Publish ulFrames speaker frames, starting at ullOffset, in messages of ulFramesPerMessage. The value of the
+ * frames is the number of the frame, which the Opus stand-in decodes into every sample. With ulPaceMs not 0, each
+ * message is sent ulPaceMs after the previous.
+ */
+void vAIAServiceSendSpeaker( uint64_t ullOffset, uint32_t ulFrames, uint32_t ulFramesPerMessage, uint32_t ulPaceMs );
+
+/* Publish a speaker message with the marker ulMarker, to come after the audio sent before it. */
+void vAIAServiceSendMarker( uint32_t ulMarker );
+
+/* Give the next speaker message the given sequence number: leave out the ones before it, or send again from it. */
+void vAIAServiceSkipSpeakerSequence( uint32_t ulSequence );
+
+/* Run the service side of an utterance: wait for the microphone to be opened and ulUtteranceMs of its audio, close
+ * it, answer with ulReplyFrames speaker frames and go back to IDLE once SpeakerClosed comes.
+ */
+BaseType_t xAIAServiceConverse( uint32_t ulUtteranceMs, uint32_t ulReplyFrames, uint32_t ulTimeoutMs );
+
+#endif /* _AIA_SERVICE_H_ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "aia_client_priv.h"
+#include "aia_publish.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+static const char * const * ppcLogPatterns;
+static volatile uint32_t ulLogMatches;
+static uint32_t ulFailedChecks;
+static IotMqttConnection_t xConnection;
+static TaskHandle_t xTestTask;
+
+static void prvLogHook( const char * pcLine )
+{
+    for( const char * const * ppcPattern = ppcLogPatterns; ppcPattern != NULL && *ppcPattern != NULL; ppcPattern++ )
+    {
+        if( strstr( pcLine, *ppcPattern ) != NULL )
+        {
+            ulLogMatches++;
+            fputs( pcLine, stdout );
+            break;
+        }
+    }
+}
+
+void vTestLogOnly( const char * const * ppcPatterns )
+{
+    ppcLogPatterns = ppcPatterns;
+    vHostSetLogHook( ( getenv( "AIA_TEST_VERBOSE" ) == NULL ) ? prvLogHook : NULL,
+                     ( getenv( "AIA_TEST_VERBOSE" ) == NULL ) ? pdTRUE : pdFALSE );
+}
+
+uint32_t ulTestLogMatches( void )
+{
+    return ulLogMatches;
+}
+
+void vTestSleepMs( uint32_t ulMs )
+{
+    usleep( ulMs * 1000U );
+}
+
+BaseType_t xTestStartClient( BaseType_t xAcceptCapabilities )
+{
+    IotMqttNetworkInfo_t xNetworkInfo = { 0 };
+
+    vAIAServiceInit( xAcceptCapabilities );
+
+    xNetworkInfo.pMqttSerializer = &xAIAMqttSerializer;
+    if( IotMqtt_Connect( &xNetworkInfo, NULL, 5000, &xConnection ) != IOT_MQTT_SUCCESS )
+    {
+        return pdFAIL;
+    }
+    if( xClientInit( xConnection ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    /* The client signals the task of the demo when it gives up on AIA. */
+    xTestTask = xTaskGetCurrentTaskHandle();
+    xDemoTaskHandle = xTestTask;
+    if( xClientAIAInit() != pdPASS )
+    {
+        return pdFAIL;
+    }
+    if( xAIAServiceWaitForEvent( "SynchronizeState", 1, 5000 ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    for( int i = 0; i < 500; i++ )
+    {
+        HostPlatformStats_t xStats;
+
+        vHostPlatformStats( &xStats );
+        if( xStats.xTouchEnabled == pdTRUE )
+        {
+            return pdPASS;
+        }
+        vTestSleepMs( 10 );
+    }
+    return pdFAIL;
+}
+
+BaseType_t xTestTap( uint32_t ulTimeoutMs )
+{
+    for( uint32_t i = 0; i < ulTimeoutMs; i += 10 )
+    {
+        HostPlatformStats_t xStats;
+
+        vHostPlatformStats( &xStats );
+        if( xStats.xTouchEnabled == pdTRUE )
+        {
+            vHostTouch( pdTRUE );
+            vTestSleepMs( 60 );
+            vHostTouch( pdFALSE );
+            return pdPASS;
+        }
+        vTestSleepMs( 10 );
+    }
+    printf( "Test: the touch button was not enabled in %u ms\n", ulTimeoutMs );
+    return pdFAIL;
+}
+
+BaseType_t xTestClientFailed( void )
+{
+    return ( ulTaskNotifyTake( pdFALSE, 0 ) != 0 ) ? pdTRUE : pdFALSE;
+}
+
+static void prvWriteU32( FILE * pxFile, uint32_t ulValue )
+{
+    uint8_t ucBytes[ 4 ] = { ulValue, ulValue >> 8, ulValue >> 16, ulValue >> 24 };
+
+    fwrite( ucBytes, 1, sizeof( ucBytes ), pxFile );
+}
+
+static void prvWriteU16( FILE * pxFile, uint16_t usValue )
+{
+    uint8_t ucBytes[ 2 ] = { usValue, usValue >> 8 };
+
+    fwrite( ucBytes, 1, sizeof( ucBytes ), pxFile );
+}
+
+void vTestWriteWav( const char * pcPath, const int16_t * psSamples, uint32_t ulSamples )
+{
+    FILE * pxFile = fopen( pcPath, "wb" );
+
+    configASSERT( pxFile != NULL );
+    fwrite( "RIFF", 1, 4, pxFile );
+    prvWriteU32( pxFile, 36 + ulSamples * 2 );
+    fwrite( "WAVEfmt ", 1, 8, pxFile );
+    prvWriteU32( pxFile, 16 );
+    prvWriteU16( pxFile, 1 );
+    prvWriteU16( pxFile, 1 );
+    prvWriteU32( pxFile, aiatestWAV_SAMPLE_RATE );
+    prvWriteU32( pxFile, aiatestWAV_SAMPLE_RATE * 2 );
+    prvWriteU16( pxFile, 2 );
+    prvWriteU16( pxFile, 16 );
+    fwrite( "data", 1, 4, pxFile );
+    prvWriteU32( pxFile, ulSamples * 2 );
+    for( uint32_t i = 0; i < ulSamples; i++ )
+    {
+        prvWriteU16( pxFile, ( uint16_t )psSamples[ i ] );
+    }
+    fclose( pxFile );
+}
+
+static uint32_t prvReadU32( const uint8_t * pucBytes )
+{
+    return pucBytes[ 0 ] | ( pucBytes[ 1 ] << 8 ) | ( pucBytes[ 2 ] << 16 ) | ( ( uint32_t )pucBytes[ 3 ] << 24 );
+}
+
+BaseType_t xTestReadWav( const char * pcPath, uint32_t ulMaxSamples, int16_t ** ppsSamples, uint32_t * pulSamples )
+{
+    FILE * pxFile = fopen( pcPath, "rb" );
+    uint8_t ucChunk[ 8 ];
+    uint8_t ucFormat[ 16 ];
+    BaseType_t xFormat = pdFALSE;
+
+    *pulSamples = 0;
+    if( pxFile == NULL )
+    {
+        return pdFAIL;
+    }
+    if( fread( ucChunk, 1, 8, pxFile ) != 8 || memcmp( ucChunk, "RIFF", 4 ) != 0 ||
+        fread( ucChunk, 1, 4, pxFile ) != 4 || memcmp( ucChunk, "WAVE", 4 ) != 0 )
+    {
+        fclose( pxFile );
+        return pdFAIL;
+    }
+    while( fread( ucChunk, 1, 8, pxFile ) == 8 )
+    {
+        uint32_t ulSize = prvReadU32( ucChunk + 4 );
+
+        if( memcmp( ucChunk, "fmt ", 4 ) == 0 && ulSize >= sizeof( ucFormat ) )
+        {
+            if( fread( ucFormat, 1, sizeof( ucFormat ), pxFile ) != sizeof( ucFormat ) )
+            {
+                break;
+            }
+            /* PCM, mono, 16 kHz, 16-bit. */
+            xFormat = ( ucFormat[ 0 ] == 1 && ucFormat[ 2 ] == 1 && prvReadU32( ucFormat + 4 ) == aiatestWAV_SAMPLE_RATE &&
+                        ucFormat[ 14 ] == 16 ) ? pdTRUE : pdFALSE;
+            fseek( pxFile, ( ulSize - sizeof( ucFormat ) + 1 ) & ~1U, SEEK_CUR );
+        }
+        else if( memcmp( ucChunk, "data", 4 ) == 0 && xFormat == pdTRUE )
+        {
+            uint32_t ulSamples = ulSize / 2;
+
+            if( ulSamples > ulMaxSamples )
+            {
+                ulSamples = ulMaxSamples;
+            }
+            *ppsSamples = malloc( ulSamples * sizeof( int16_t ) );
+            *pulSamples = fread( *ppsSamples, sizeof( int16_t ), ulSamples, pxFile );
+            fclose( pxFile );
+            return pdPASS;
+        }
+        else
+        {
+            fseek( pxFile, ( ulSize + 1 ) & ~1U, SEEK_CUR );
+        }
+    }
+    fclose( pxFile );
+    return pdFAIL;
+}
+
+void vTestCheck( BaseType_t xPassed, const char * pcFormat, ... )
+{
+    va_list xArgs;
+
+    printf( "%s: ", ( xPassed == pdFALSE ) ? "FAIL" : "ok" );
+    va_start( xArgs, pcFormat );
+    vprintf( pcFormat, xArgs );
+    va_end( xArgs );
+    printf( "\n" );
+    fflush( stdout );
+
+    if( xPassed == pdFALSE )
+    {
+        ulFailedChecks++;
+    }
+}
+
+int lTestResult( void )
+{
+    printf( "%s\n", ( ulFailedChecks == 0 ) ? "PASSED" : "FAILED" );
+    return ( ulFailedChecks == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _AIA_TEST_H_
+#define _AIA_TEST_H_
+
+#include "FreeRTOS.h"
+
+/* Common steps of the host tests. A test is a program that returns 0 when it passes. */
+
+/* Keep the log of the client out of the output, except for the lines that contain one of the given strings. The
+ * number of such lines is returned by ulTestLogMatches(). Set AIA_TEST_VERBOSE in the environment for the whole log.
+ */
+void vTestLogOnly( const char * const * ppcPatterns );
+uint32_t ulTestLogMatches( void );
+
+/* Connect the client to the scripted service and wait until it is IDLE with the touch button enabled. */
+BaseType_t xTestStartClient( BaseType_t xAcceptCapabilities );
+
+/* Wait until the touch button is enabled, and tap it. */
+BaseType_t xTestTap( uint32_t ulTimeoutMs );
+
+/* Whether the client has signalled the demo task, which it does when it gives up on AIA. */
+BaseType_t xTestClientFailed( void );
+
+void vTestSleepMs( uint32_t ulMs );
+
+/* The WAV files of the tests are 16 kHz 16-bit mono. */
+#define aiatestWAV_SAMPLE_RATE              ( 16000U )
+
+/* Load the samples of a 16 kHz 16-bit mono PCM WAV file, up to ulMaxSamples of them, into memory from malloc(). */
+BaseType_t xTestReadWav( const char * pcPath, uint32_t ulMaxSamples, int16_t ** ppsSamples, uint32_t * pulSamples );
+
+/* Write samples as a 16 kHz 16-bit mono PCM WAV file. */
+void vTestWriteWav( const char * pcPath, const int16_t * psSamples, uint32_t ulSamples );
+
+/* Print a check, and count it as failed when xPassed is pdFALSE. */
+void vTestCheck( BaseType_t xPassed, const char * pcFormat, ... );
+int lTestResult( void );
+
+#endif /* _AIA_TEST_H_ */
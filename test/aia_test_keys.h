@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _AIA_TEST_KEYS_H_
+#define _AIA_TEST_KEYS_H_
+
+/* Keys of the host tests, included ahead of every file so that they take the place of the ones of
+ * aia_client_config.h. They are made up for the tests: the client and the scripted service of aia_service.c each
+ * hold one X25519 key pair and the public key of the other.
+ */
+
+#define aiaconfigAWS_ACCOUNT_ID                             "000000000000"
+#define aiaconfigTOPIC_ROOT                                 "host"
+
+#define aiaconfigCLIENT_PUBLIC_KEY                          "hl9txL834M9Xj89q27Evl9e1VGr1jEuukQEbgzVbfCI="
+#define aiaconfigCLIENT_PRIVATE_KEY                         "BxgpOktcbX6PoLHC0+T1BhcoOUpbbH2On7DB0uP0BRY="
+#define aiaconfigPEER_PUBLIC_KEY                            "yYDkQ1uokYVy7N+hXnSoIFIOa6gbUjfERXQs1+ZpWwA="
+
+#define aiatestSERVICE_PRIVATE_KEY                          "WpXQC0aBvPcybajjHlmUzwpFgLv2MWyn4h1Yk84JRH8="
+
+#endif /* _AIA_TEST_KEYS_H_ */
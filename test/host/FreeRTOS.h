@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The subset of the FreeRTOS API used by the AIA client, implemented on POSIX threads in freertos_host.c. It is only
+ * meant to run the client on a Linux host for testing, and does not try to schedule by priority. Values match
+ * FreeRTOSConfig.h of the CY8CPROTO-062-4343W demo.
+ */
+
+#ifndef _HOST_FREERTOS_H_
+#define _HOST_FREERTOS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef uint16_t configSTACK_DEPTH_TYPE;
+
+#define pdFALSE                             ( ( BaseType_t ) 0 )
+#define pdTRUE                              ( ( BaseType_t ) 1 )
+#define pdPASS                              ( pdTRUE )
+#define pdFAIL                              ( pdFALSE )
+#define errQUEUE_EMPTY                      ( ( BaseType_t ) 0 )
+#define errQUEUE_FULL                       ( ( BaseType_t ) 0 )
+
+#define portMAX_DELAY                       ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS                  ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define pdMS_TO_TICKS( xTimeInMs )          ( ( TickType_t ) ( ( ( TickType_t ) ( xTimeInMs ) * ( TickType_t ) configTICK_RATE_HZ ) / ( TickType_t ) 1000 ) )
+
+#define configCPU_CLOCK_HZ                  ( 150000000UL )
+#define configTICK_RATE_HZ                  ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES                ( 8 )
+#define configMINIMAL_STACK_SIZE            ( ( unsigned short ) 130 )
+#define tskIDLE_PRIORITY                    ( ( UBaseType_t ) 0U )
+#define INCLUDE_uxTaskGetStackHighWaterMark ( 1 )
+
+void vAssertCalled( const char * pcFile, uint32_t ulLine );
+#define configASSERT( x )                   if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+void vLoggingPrintf( const char * pcFormat, ... );
+#define configPRINTF( X )                   vLoggingPrintf X
+#ifdef DEBUG
+#define configPRINTF_DEBUG( X )             vLoggingPrintf X
+#else
+#define configPRINTF_DEBUG( X )
+#endif
+
+void * pvPortMalloc( size_t xSize );
+void vPortFree( void * pv );
+size_t xPortGetFreeHeapSize( void );
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+/* Interrupts are simulated by threads that hold the critical section while they run, see vHostInterruptEnter(). */
+void vHostEnterCritical( void );
+void vHostExitCritical( void );
+#define taskENTER_CRITICAL()                vHostEnterCritical()
+#define taskEXIT_CRITICAL()                 vHostExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR()       ( vHostEnterCritical(), ( UBaseType_t ) 0 )
+#define taskEXIT_CRITICAL_FROM_ISR( x )     ( ( void )( x ), vHostExitCritical() )
+#define taskDISABLE_INTERRUPTS()            vHostEnterCritical()
+#define taskENABLE_INTERRUPTS()             vHostExitCritical()
+
+void vHostYield( void );
+#define taskYIELD()                         vHostYield()
+#define portYIELD_FROM_ISR( x )             ( ( void )( x ) )
+
+#endif /* _HOST_FREERTOS_H_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_ARM_ACLE_H_
+#define _HOST_ARM_ACLE_H_
+
+#include <stdint.h>
+
+/* The SIMD intrinsics of the DSP extension used by the AIA client, in plain C with the results the instructions give,
+ * so that tests built with __ARM_FEATURE_SIMD32 defined run the SIMD paths on the host. Lane 0 is the low halfword.
+ */
+typedef int32_t int16x2_t;
+
+static inline int32_t prvHostLane( uint32_t ulValue, uint32_t ulLane )
+{
+    return ( int16_t )( ulValue >> ( 16 * ulLane ) );
+}
+
+/* Halving add of each lane, rounded down. */
+static inline int16x2_t __shadd16( int16x2_t xA, int16x2_t xB )
+{
+    uint32_t ulLow = ( uint32_t )( ( prvHostLane( ( uint32_t )xA, 0 ) + prvHostLane( ( uint32_t )xB, 0 ) ) >> 1 ) & 0xffffU;
+    uint32_t ulHigh = ( uint32_t )( ( prvHostLane( ( uint32_t )xA, 1 ) + prvHostLane( ( uint32_t )xB, 1 ) ) >> 1 ) & 0xffffU;
+
+    return ( int16x2_t )( ulLow | ( ulHigh << 16 ) );
+}
+
+/* Dual multiply of the lanes, both products added to a 64-bit accumulator. */
+static inline int64_t __smlald( int16x2_t xA, int16x2_t xB, int64_t llAccumulator )
+{
+    return llAccumulator + ( int64_t )prvHostLane( ( uint32_t )xA, 0 ) * prvHostLane( ( uint32_t )xB, 0 ) +
+           ( int64_t )prvHostLane( ( uint32_t )xA, 1 ) * prvHostLane( ( uint32_t )xB, 1 );
+}
+
+#endif /* _HOST_ARM_ACLE_H_ */
@@ -0,0 +1,1353 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The FreeRTOS API used by the AIA client, on POSIX threads. Every task is a thread and all of them run at once;
+ * priorities are ignored. Blocking calls wait on one condition variable, broadcast on every change of a kernel
+ * object. Interrupts are threads that hold the critical section while they run.
+ *
+ * The heap keeps the accounting of heap_4: every allocation, kernel objects included, counts against an optional
+ * cap, so that a run can tell the peak heap use of the client and fail when it goes over the budget of a part.
+ * Kernel objects are charged their approximate size on Cortex-M4.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+#include "timers.h"
+#include "host.h"
+
+/* Approximate sizes of the kernel objects on Cortex-M4, charged to the heap. */
+#define HOST_TCB_SIZE                   ( 100U )
+#define HOST_QUEUE_SIZE                 ( 80U )
+#define HOST_STREAM_BUFFER_SIZE         ( 36U )
+#define HOST_EVENT_GROUP_SIZE           ( 32U )
+#define HOST_TIMER_SIZE                 ( 44U )
+/* heap_4 adds a block header to every allocation. */
+#define HOST_HEAP_BLOCK_HEADER          ( 8U )
+/* Message buffers prefix each message with its length, a size_t on the board. */
+#define HOST_MESSAGE_LENGTH_SIZE        ( sizeof( uint32_t ) )
+
+#define HOST_PENDED_CALLS               ( 16U )
+
+typedef enum {
+    eNotWaitingNotification = 0,
+    eWaitingNotification,
+    eNotified
+} HostNotifyState_t;
+
+struct HostTask {
+    pthread_t xThread;
+    char cName[ 16 ];
+    TaskFunction_t pxCode;
+    void * pvParameters;
+    size_t xCharged;
+    uint32_t ulStackDepth;
+    uint32_t ulNotifiedValue;
+    HostNotifyState_t eNotifyState;
+    volatile BaseType_t xDeleted;
+};
+
+struct HostQueue {
+    uint8_t * pucStorage;
+    UBaseType_t uxLength;
+    UBaseType_t uxItemSize;
+    UBaseType_t uxCount;
+    UBaseType_t uxHead;
+    size_t xCharged;
+};
+
+struct HostStreamBuffer {
+    uint8_t * pucStorage;
+    size_t xSize;
+    size_t xHead;
+    size_t xCount;
+    size_t xTriggerLevel;
+    BaseType_t xIsMessageBuffer;
+    size_t xCharged;
+};
+
+struct HostEventGroup {
+    EventBits_t uxBits;
+};
+
+struct HostTimer {
+    const char * pcName;
+    TickType_t xPeriod;
+    UBaseType_t uxAutoReload;
+    void * pvID;
+    TimerCallbackFunction_t pxCallback;
+    BaseType_t xActive;
+    uint64_t ullExpiry;
+    struct HostTimer * pxNext;
+};
+
+typedef struct {
+    PendedFunction_t xFunction;
+    void * pvParameter1;
+    uint32_t ulParameter2;
+} HostPendedCall_t;
+
+static pthread_mutex_t xKernelLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xKernelChanged;
+static pthread_mutex_t xCriticalLock;
+static pthread_mutex_t xHeapLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t xLogLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t xInitOnce = PTHREAD_ONCE_INIT;
+static __thread struct HostTask * pxCurrentTask;
+static struct timespec xStart;
+
+static struct {
+    size_t xCap;
+    size_t xUsed;
+    size_t xPeak;
+    uint32_t ulAllocations;
+    uint32_t ulFailures;
+} xHeap;
+
+static struct {
+    pthread_t xThread;
+    struct HostTimer * pxTimers;
+    HostPendedCall_t xPended[ HOST_PENDED_CALLS ];
+    UBaseType_t uxPendedHead;
+    UBaseType_t uxPendedCount;
+} xDaemon;
+
+static void ( * vLogHook )( const char * pcLine );
+static BaseType_t xLogQuiet;
+
+static void * prvDaemon( void * pvParameters );
+
+static void prvInit( void )
+{
+    pthread_condattr_t xCondAttr;
+    pthread_mutexattr_t xMutexAttr;
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    pthread_condattr_init( &xCondAttr );
+    pthread_condattr_setclock( &xCondAttr, CLOCK_MONOTONIC );
+    pthread_cond_init( &xKernelChanged, &xCondAttr );
+
+    pthread_mutexattr_init( &xMutexAttr );
+    pthread_mutexattr_settype( &xMutexAttr, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &xCriticalLock, &xMutexAttr );
+
+    pthread_create( &xDaemon.xThread, NULL, prvDaemon, NULL );
+}
+
+static void prvEnsureInit( void )
+{
+    pthread_once( &xInitOnce, prvInit );
+}
+
+static uint64_t prvNowMs( void )
+{
+    struct timespec xNow;
+
+    prvEnsureInit();
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t )( xNow.tv_sec - xStart.tv_sec ) * 1000ULL + ( uint64_t )( xNow.tv_nsec / 1000000L ) -
+           ( uint64_t )( xStart.tv_nsec / 1000000L );
+}
+
+static struct HostTask * prvCurrentTask( void )
+{
+    /* Threads not created by xTaskCreate(), e.g. main(), get a handle on first use. */
+    if( pxCurrentTask == NULL )
+    {
+        pxCurrentTask = calloc( 1, sizeof( struct HostTask ) );
+        pxCurrentTask->xThread = pthread_self();
+        strcpy( pxCurrentTask->cName, "host" );
+    }
+    return pxCurrentTask;
+}
+
+/*-----------------------------------------------------------*/
+
+void vHostSetHeapCap( size_t xCap )
+{
+    pthread_mutex_lock( &xHeapLock );
+    xHeap.xCap = xCap;
+    pthread_mutex_unlock( &xHeapLock );
+}
+
+static BaseType_t prvCharge( size_t xSize )
+{
+    BaseType_t xCharged = pdFALSE;
+
+    xSize += HOST_HEAP_BLOCK_HEADER;
+    pthread_mutex_lock( &xHeapLock );
+    if( xHeap.xCap == 0 || xHeap.xUsed + xSize <= xHeap.xCap )
+    {
+        xHeap.xUsed += xSize;
+        xHeap.ulAllocations++;
+        if( xHeap.xUsed > xHeap.xPeak )
+        {
+            xHeap.xPeak = xHeap.xUsed;
+        }
+        xCharged = pdTRUE;
+    }
+    else
+    {
+        xHeap.ulFailures++;
+    }
+    pthread_mutex_unlock( &xHeapLock );
+
+    return xCharged;
+}
+
+static void prvRefund( size_t xSize )
+{
+    pthread_mutex_lock( &xHeapLock );
+    configASSERT( xHeap.xUsed >= xSize + HOST_HEAP_BLOCK_HEADER );
+    xHeap.xUsed -= xSize + HOST_HEAP_BLOCK_HEADER;
+    pthread_mutex_unlock( &xHeapLock );
+}
+
+void * pvPortMalloc( size_t xSize )
+{
+    size_t * pxBlock;
+
+    if( xSize == 0 || prvCharge( xSize ) == pdFALSE )
+    {
+        return NULL;
+    }
+
+    pxBlock = malloc( sizeof( size_t ) * 2 + xSize );
+    configASSERT( pxBlock != NULL );
+    pxBlock[ 0 ] = xSize;
+    return &pxBlock[ 2 ];
+}
+
+void vPortFree( void * pv )
+{
+    size_t * pxBlock;
+
+    if( pv == NULL )
+    {
+        return;
+    }
+
+    pxBlock = ( size_t * )pv - 2;
+    prvRefund( pxBlock[ 0 ] );
+    free( pxBlock );
+}
+
+size_t xPortGetFreeHeapSize( void )
+{
+    size_t xFree;
+
+    pthread_mutex_lock( &xHeapLock );
+    xFree = ( xHeap.xCap != 0 ) ? xHeap.xCap - xHeap.xUsed : SIZE_MAX;
+    pthread_mutex_unlock( &xHeapLock );
+    return xFree;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    size_t xFree;
+
+    pthread_mutex_lock( &xHeapLock );
+    xFree = ( xHeap.xCap != 0 ) ? xHeap.xCap - xHeap.xPeak : SIZE_MAX;
+    pthread_mutex_unlock( &xHeapLock );
+    return xFree;
+}
+
+void vHostHeapStats( HostHeapStats_t * pxStats )
+{
+    pthread_mutex_lock( &xHeapLock );
+    pxStats->xUsed = xHeap.xUsed;
+    pxStats->xPeak = xHeap.xPeak;
+    pxStats->ulAllocations = xHeap.ulAllocations;
+    pxStats->ulFailures = xHeap.ulFailures;
+    pthread_mutex_unlock( &xHeapLock );
+}
+
+/*-----------------------------------------------------------*/
+
+void vHostEnterCritical( void )
+{
+    prvEnsureInit();
+    pthread_mutex_lock( &xCriticalLock );
+}
+
+void vHostExitCritical( void )
+{
+    pthread_mutex_unlock( &xCriticalLock );
+}
+
+void vHostInterruptEnter( void )
+{
+    vHostEnterCritical();
+}
+
+void vHostInterruptExit( void )
+{
+    vHostExitCritical();
+}
+
+void vHostYield( void )
+{
+    sched_yield();
+}
+
+void vAssertCalled( const char * pcFile, uint32_t ulLine )
+{
+    fprintf( stderr, "ASSERT failed at %s:%u\n", pcFile, ulLine );
+    abort();
+}
+
+void vHostSetLogHook( void ( * vHook )( const char * pcLine ), BaseType_t xQuiet )
+{
+    pthread_mutex_lock( &xLogLock );
+    vLogHook = vHook;
+    xLogQuiet = xQuiet;
+    pthread_mutex_unlock( &xLogLock );
+}
+
+void vLoggingPrintf( const char * pcFormat, ... )
+{
+    char cLine[ 1024 ];
+    va_list xArgs;
+
+    va_start( xArgs, pcFormat );
+    vsnprintf( cLine, sizeof( cLine ), pcFormat, xArgs );
+    va_end( xArgs );
+
+    pthread_mutex_lock( &xLogLock );
+    if( vLogHook != NULL )
+    {
+        vLogHook( cLine );
+    }
+    if( xLogQuiet == pdFALSE )
+    {
+        fputs( cLine, stdout );
+        fflush( stdout );
+    }
+    pthread_mutex_unlock( &xLogLock );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Called with the kernel lock held. Returns pdFALSE once xDeadline has passed. A task deleted by another one exits
+ * here, the next time it blocks.
+ */
+static BaseType_t prvWait( uint64_t ullDeadline )
+{
+    struct HostTask * pxTask = prvCurrentTask();
+    struct timespec xAbs;
+    int lResult = 0;
+
+    if( ullDeadline == UINT64_MAX )
+    {
+        pthread_cond_wait( &xKernelChanged, &xKernelLock );
+    }
+    else
+    {
+        ullDeadline += ( uint64_t )xStart.tv_sec * 1000ULL + ( uint64_t )( xStart.tv_nsec / 1000000L );
+        xAbs.tv_sec = ( time_t )( ullDeadline / 1000ULL );
+        xAbs.tv_nsec = ( long )( ullDeadline % 1000ULL ) * 1000000L;
+        lResult = pthread_cond_timedwait( &xKernelChanged, &xKernelLock, &xAbs );
+    }
+
+    if( pxTask->xDeleted == pdTRUE )
+    {
+        pthread_mutex_unlock( &xKernelLock );
+        pthread_exit( NULL );
+    }
+
+    return ( lResult == ETIMEDOUT ) ? pdFALSE : pdTRUE;
+}
+
+static uint64_t prvDeadline( TickType_t xTicksToWait )
+{
+    return ( xTicksToWait == portMAX_DELAY ) ? UINT64_MAX : prvNowMs() + xTicksToWait;
+}
+
+static BaseType_t prvExpired( uint64_t ullDeadline )
+{
+    return ( ullDeadline != UINT64_MAX && prvNowMs() >= ullDeadline ) ? pdTRUE : pdFALSE;
+}
+
+static void prvChanged( void )
+{
+    pthread_cond_broadcast( &xKernelChanged );
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvTaskEntry( void * pvParameters )
+{
+    struct HostTask * pxTask = ( struct HostTask * )pvParameters;
+
+    pxCurrentTask = pxTask;
+    pxTask->pxCode( pxTask->pvParameters );
+
+    /* A FreeRTOS task must not return. */
+    vAssertCalled( __FILE__, __LINE__ );
+    return NULL;
+}
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * pcName,
+                        configSTACK_DEPTH_TYPE usStackDepth,
+                        void * pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * pxCreatedTask )
+{
+    struct HostTask * pxTask;
+    size_t xCharged = HOST_TCB_SIZE + usStackDepth * sizeof( StackType_t );
+
+    ( void )uxPriority;
+    prvEnsureInit();
+    if( prvCharge( xCharged ) == pdFALSE )
+    {
+        return pdFAIL;
+    }
+
+    pxTask = calloc( 1, sizeof( struct HostTask ) );
+    strncpy( pxTask->cName, pcName, sizeof( pxTask->cName ) - 1 );
+    pxTask->pxCode = pxTaskCode;
+    pxTask->pvParameters = pvParameters;
+    pxTask->xCharged = xCharged;
+    pxTask->ulStackDepth = usStackDepth;
+
+    /* Publish the handle before the task can use it, as FreeRTOS does. */
+    if( pxCreatedTask != NULL )
+    {
+        *pxCreatedTask = pxTask;
+    }
+    if( pthread_create( &pxTask->xThread, NULL, prvTaskEntry, pxTask ) != 0 )
+    {
+        prvRefund( xCharged );
+        free( pxTask );
+        return pdFAIL;
+    }
+    pthread_detach( pxTask->xThread );
+
+    return pdPASS;
+}
+
+void vTaskDelete( TaskHandle_t xTask )
+{
+    struct HostTask * pxTask = ( xTask != NULL ) ? xTask : prvCurrentTask();
+
+    if( pxTask->xCharged != 0 )
+    {
+        prvRefund( pxTask->xCharged );
+        pxTask->xCharged = 0;
+    }
+
+    pthread_mutex_lock( &xKernelLock );
+    pxTask->xDeleted = pdTRUE;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+
+    /* The handle is not freed, as the thread may still be on its way to its next blocking call. */
+    if( pxTask == prvCurrentTask() )
+    {
+        pthread_exit( NULL );
+    }
+}
+
+void vTaskDelay( TickType_t xTicksToDelay )
+{
+    uint64_t ullDeadline = prvNowMs() + xTicksToDelay;
+
+    pthread_mutex_lock( &xKernelLock );
+    while( prvExpired( ullDeadline ) == pdFALSE )
+    {
+        prvWait( ullDeadline );
+    }
+    pthread_mutex_unlock( &xKernelLock );
+}
+
+void vTaskSuspendAll( void )
+{
+    vHostEnterCritical();
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    vHostExitCritical();
+    return pdFALSE;
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+    return ( TickType_t )prvNowMs();
+}
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+    return ( TickType_t )prvNowMs();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+    return prvCurrentTask();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask )
+{
+    /* Stack use is not measured on the host. */
+    return ( xTask != NULL ) ? xTask->ulStackDepth : prvCurrentTask()->ulStackDepth;
+}
+
+void vTaskSetTimeOutState( TimeOut_t * pxTimeOut )
+{
+    pxTimeOut->xTimeOnEntering = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * pxTimeOut, TickType_t * pxTicksToWait )
+{
+    TickType_t xElapsed;
+
+    if( *pxTicksToWait == portMAX_DELAY )
+    {
+        return pdFALSE;
+    }
+
+    xElapsed = xTaskGetTickCount() - pxTimeOut->xTimeOnEntering;
+    if( xElapsed >= *pxTicksToWait )
+    {
+        *pxTicksToWait = 0;
+        return pdTRUE;
+    }
+
+    *pxTicksToWait -= xElapsed;
+    vTaskSetTimeOutState( pxTimeOut );
+    return pdFALSE;
+}
+
+static BaseType_t prvNotify( struct HostTask * pxTask, uint32_t ulValue, eNotifyAction eAction )
+{
+    BaseType_t xReturn = pdPASS;
+
+    pthread_mutex_lock( &xKernelLock );
+    switch( eAction )
+    {
+        case eSetBits:
+            pxTask->ulNotifiedValue |= ulValue;
+            break;
+        case eIncrement:
+            pxTask->ulNotifiedValue++;
+            break;
+        case eSetValueWithOverwrite:
+            pxTask->ulNotifiedValue = ulValue;
+            break;
+        case eSetValueWithoutOverwrite:
+            if( pxTask->eNotifyState != eNotified )
+            {
+                pxTask->ulNotifiedValue = ulValue;
+            }
+            else
+            {
+                xReturn = pdFAIL;
+            }
+            break;
+        case eNoAction:
+        default:
+            break;
+    }
+    pxTask->eNotifyState = eNotified;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+
+    return xReturn;
+}
+
+BaseType_t xTaskNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction )
+{
+    return prvNotify( xTaskToNotify, ulValue, eAction );
+}
+
+BaseType_t xTaskNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvNotify( xTaskToNotify, ulValue, eAction );
+}
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    ( void )prvNotify( xTaskToNotify, 0, eIncrement );
+}
+
+BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t * pulNotificationValue, TickType_t xTicksToWait )
+{
+    struct HostTask * pxTask = prvCurrentTask();
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    BaseType_t xReturn;
+
+    pthread_mutex_lock( &xKernelLock );
+    if( pxTask->eNotifyState != eNotified )
+    {
+        pxTask->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+        pxTask->eNotifyState = eWaitingNotification;
+        while( pxTask->eNotifyState != eNotified && xTicksToWait != 0 && prvExpired( ullDeadline ) == pdFALSE )
+        {
+            prvWait( ullDeadline );
+        }
+    }
+
+    if( pulNotificationValue != NULL )
+    {
+        *pulNotificationValue = pxTask->ulNotifiedValue;
+    }
+    if( pxTask->eNotifyState != eNotified )
+    {
+        xReturn = pdFALSE;
+    }
+    else
+    {
+        pxTask->ulNotifiedValue &= ~ulBitsToClearOnExit;
+        xReturn = pdTRUE;
+    }
+    pxTask->eNotifyState = eNotWaitingNotification;
+    pthread_mutex_unlock( &xKernelLock );
+
+    return xReturn;
+}
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+    struct HostTask * pxTask = prvCurrentTask();
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    uint32_t ulReturn;
+
+    pthread_mutex_lock( &xKernelLock );
+    if( pxTask->ulNotifiedValue == 0 )
+    {
+        /* As in FreeRTOS, a notification that came before without a value is not kept. */
+        pxTask->eNotifyState = eWaitingNotification;
+        while( pxTask->eNotifyState != eNotified && xTicksToWait != 0 && prvExpired( ullDeadline ) == pdFALSE )
+        {
+            prvWait( ullDeadline );
+        }
+    }
+
+    ulReturn = pxTask->ulNotifiedValue;
+    if( ulReturn != 0 )
+    {
+        pxTask->ulNotifiedValue = ( xClearCountOnExit != pdFALSE ) ? 0 : ulReturn - 1;
+    }
+    pxTask->eNotifyState = eNotWaitingNotification;
+    pthread_mutex_unlock( &xKernelLock );
+
+    return ulReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+static struct HostQueue * prvQueueCreate( UBaseType_t uxQueueLength, UBaseType_t uxItemSize, UBaseType_t uxInitialCount )
+{
+    struct HostQueue * pxQueue;
+    size_t xCharged = HOST_QUEUE_SIZE + uxQueueLength * uxItemSize;
+
+    prvEnsureInit();
+    if( prvCharge( xCharged ) == pdFALSE )
+    {
+        return NULL;
+    }
+
+    pxQueue = calloc( 1, sizeof( struct HostQueue ) );
+    pxQueue->pucStorage = calloc( uxQueueLength, uxItemSize > 0 ? uxItemSize : 1 );
+    pxQueue->uxLength = uxQueueLength;
+    pxQueue->uxItemSize = uxItemSize;
+    pxQueue->uxCount = uxInitialCount;
+    pxQueue->xCharged = xCharged;
+    return pxQueue;
+}
+
+QueueHandle_t xQueueCreate( UBaseType_t uxQueueLength, UBaseType_t uxItemSize )
+{
+    return prvQueueCreate( uxQueueLength, uxItemSize, 0 );
+}
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+    prvRefund( xQueue->xCharged );
+    free( xQueue->pucStorage );
+    free( xQueue );
+}
+
+static BaseType_t prvQueueSend( struct HostQueue * pxQueue, const void * pvItem, TickType_t xTicksToWait, BaseType_t xToFront )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    UBaseType_t uxIndex;
+
+    pthread_mutex_lock( &xKernelLock );
+    while( pxQueue->uxCount == pxQueue->uxLength )
+    {
+        if( xTicksToWait == 0 || prvExpired( ullDeadline ) == pdTRUE )
+        {
+            pthread_mutex_unlock( &xKernelLock );
+            return errQUEUE_FULL;
+        }
+        prvWait( ullDeadline );
+    }
+
+    if( pxQueue->uxItemSize > 0 )
+    {
+        if( xToFront == pdTRUE )
+        {
+            pxQueue->uxHead = ( pxQueue->uxHead + pxQueue->uxLength - 1 ) % pxQueue->uxLength;
+            uxIndex = pxQueue->uxHead;
+        }
+        else
+        {
+            uxIndex = ( pxQueue->uxHead + pxQueue->uxCount ) % pxQueue->uxLength;
+        }
+        memcpy( pxQueue->pucStorage + uxIndex * pxQueue->uxItemSize, pvItem, pxQueue->uxItemSize );
+    }
+    pxQueue->uxCount++;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+
+    return pdPASS;
+}
+
+static BaseType_t prvQueueReceive( struct HostQueue * pxQueue, void * pvBuffer, TickType_t xTicksToWait, BaseType_t xPeek )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+
+    pthread_mutex_lock( &xKernelLock );
+    while( pxQueue->uxCount == 0 )
+    {
+        if( xTicksToWait == 0 || prvExpired( ullDeadline ) == pdTRUE )
+        {
+            pthread_mutex_unlock( &xKernelLock );
+            return errQUEUE_EMPTY;
+        }
+        prvWait( ullDeadline );
+    }
+
+    if( pxQueue->uxItemSize > 0 )
+    {
+        memcpy( pvBuffer, pxQueue->pucStorage + pxQueue->uxHead * pxQueue->uxItemSize, pxQueue->uxItemSize );
+    }
+    if( xPeek == pdFALSE )
+    {
+        if( pxQueue->uxItemSize > 0 )
+        {
+            pxQueue->uxHead = ( pxQueue->uxHead + 1 ) % pxQueue->uxLength;
+        }
+        pxQueue->uxCount--;
+        prvChanged();
+    }
+    pthread_mutex_unlock( &xKernelLock );
+
+    return pdPASS;
+}
+
+BaseType_t xQueueSend( QueueHandle_t xQueue, const void * pvItemToQueue, TickType_t xTicksToWait )
+{
+    return prvQueueSend( xQueue, pvItemToQueue, xTicksToWait, pdFALSE );
+}
+
+BaseType_t xQueueSendToFront( QueueHandle_t xQueue, const void * pvItemToQueue, TickType_t xTicksToWait )
+{
+    return prvQueueSend( xQueue, pvItemToQueue, xTicksToWait, pdTRUE );
+}
+
+BaseType_t xQueueSendFromISR( QueueHandle_t xQueue, const void * pvItemToQueue, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvQueueSend( xQueue, pvItemToQueue, 0, pdFALSE );
+}
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * pvBuffer, TickType_t xTicksToWait )
+{
+    return prvQueueReceive( xQueue, pvBuffer, xTicksToWait, pdFALSE );
+}
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * pvBuffer, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvQueueReceive( xQueue, pvBuffer, 0, pdFALSE );
+}
+
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * pvBuffer, TickType_t xTicksToWait )
+{
+    return prvQueueReceive( xQueue, pvBuffer, xTicksToWait, pdTRUE );
+}
+
+BaseType_t xQueueReset( QueueHandle_t xQueue )
+{
+    pthread_mutex_lock( &xKernelLock );
+    xQueue->uxCount = 0;
+    xQueue->uxHead = 0;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting( QueueHandle_t xQueue )
+{
+    UBaseType_t uxCount;
+
+    pthread_mutex_lock( &xKernelLock );
+    uxCount = xQueue->uxCount;
+    pthread_mutex_unlock( &xKernelLock );
+    return uxCount;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR( QueueHandle_t xQueue )
+{
+    return uxQueueMessagesWaiting( xQueue );
+}
+
+UBaseType_t uxQueueSpacesAvailable( QueueHandle_t xQueue )
+{
+    UBaseType_t uxSpaces;
+
+    pthread_mutex_lock( &xKernelLock );
+    uxSpaces = xQueue->uxLength - xQueue->uxCount;
+    pthread_mutex_unlock( &xKernelLock );
+    return uxSpaces;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex( void )
+{
+    return prvQueueCreate( 1, 0, 1 );
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary( void )
+{
+    return prvQueueCreate( 1, 0, 0 );
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting( UBaseType_t uxMaxCount, UBaseType_t uxInitialCount )
+{
+    return prvQueueCreate( uxMaxCount, 0, uxInitialCount );
+}
+
+BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore, TickType_t xBlockTime )
+{
+    return prvQueueReceive( xSemaphore, NULL, xBlockTime, pdFALSE );
+}
+
+BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore )
+{
+    return prvQueueSend( xSemaphore, NULL, 0, pdFALSE );
+}
+
+BaseType_t xSemaphoreGiveFromISR( SemaphoreHandle_t xSemaphore, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvQueueSend( xSemaphore, NULL, 0, pdFALSE );
+}
+
+/*-----------------------------------------------------------*/
+
+EventGroupHandle_t xEventGroupCreate( void )
+{
+    prvEnsureInit();
+    if( prvCharge( HOST_EVENT_GROUP_SIZE ) == pdFALSE )
+    {
+        return NULL;
+    }
+    return calloc( 1, sizeof( struct HostEventGroup ) );
+}
+
+void vEventGroupDelete( EventGroupHandle_t xEventGroup )
+{
+    prvRefund( HOST_EVENT_GROUP_SIZE );
+    free( xEventGroup );
+}
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet )
+{
+    EventBits_t uxBits;
+
+    pthread_mutex_lock( &xKernelLock );
+    xEventGroup->uxBits |= uxBitsToSet;
+    uxBits = xEventGroup->uxBits;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+    return uxBits;
+}
+
+BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    ( void )xEventGroupSetBits( xEventGroup, uxBitsToSet );
+    return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear )
+{
+    EventBits_t uxBits;
+
+    pthread_mutex_lock( &xKernelLock );
+    uxBits = xEventGroup->uxBits;
+    xEventGroup->uxBits &= ~uxBitsToClear;
+    pthread_mutex_unlock( &xKernelLock );
+    return uxBits;
+}
+
+EventBits_t xEventGroupGetBitsFromISR( EventGroupHandle_t xEventGroup )
+{
+    return xEventGroupClearBits( xEventGroup, 0 );
+}
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t xEventGroup,
+                                 const EventBits_t uxBitsToWaitFor,
+                                 const BaseType_t xClearOnExit,
+                                 const BaseType_t xWaitForAllBits,
+                                 TickType_t xTicksToWait )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    EventBits_t uxBits;
+    BaseType_t xMet;
+
+    pthread_mutex_lock( &xKernelLock );
+    for( ; ; )
+    {
+        uxBits = xEventGroup->uxBits;
+        xMet = ( xWaitForAllBits != pdFALSE ) ? ( ( uxBits & uxBitsToWaitFor ) == uxBitsToWaitFor ) :
+                                                 ( ( uxBits & uxBitsToWaitFor ) != 0 );
+        if( xMet == pdTRUE || xTicksToWait == 0 || prvExpired( ullDeadline ) == pdTRUE )
+        {
+            break;
+        }
+        prvWait( ullDeadline );
+    }
+    if( xMet == pdTRUE && xClearOnExit != pdFALSE )
+    {
+        xEventGroup->uxBits &= ~uxBitsToWaitFor;
+    }
+    pthread_mutex_unlock( &xKernelLock );
+
+    return uxBits;
+}
+
+/*-----------------------------------------------------------*/
+
+static struct HostStreamBuffer * prvStreamBufferCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer )
+{
+    struct HostStreamBuffer * pxBuffer;
+    size_t xCharged = HOST_STREAM_BUFFER_SIZE + xBufferSizeBytes + 1;
+
+    prvEnsureInit();
+    if( prvCharge( xCharged ) == pdFALSE )
+    {
+        return NULL;
+    }
+
+    pxBuffer = calloc( 1, sizeof( struct HostStreamBuffer ) );
+    pxBuffer->pucStorage = malloc( xBufferSizeBytes );
+    pxBuffer->xSize = xBufferSizeBytes;
+    pxBuffer->xTriggerLevel = ( xTriggerLevelBytes == 0 ) ? 1 : xTriggerLevelBytes;
+    pxBuffer->xIsMessageBuffer = xIsMessageBuffer;
+    pxBuffer->xCharged = xCharged;
+    return pxBuffer;
+}
+
+StreamBufferHandle_t xStreamBufferCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes )
+{
+    return prvStreamBufferCreate( xBufferSizeBytes, xTriggerLevelBytes, pdFALSE );
+}
+
+MessageBufferHandle_t xMessageBufferCreate( size_t xBufferSizeBytes )
+{
+    return prvStreamBufferCreate( xBufferSizeBytes, 0, pdTRUE );
+}
+
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer )
+{
+    prvRefund( xStreamBuffer->xCharged );
+    free( xStreamBuffer->pucStorage );
+    free( xStreamBuffer );
+}
+
+static void prvStreamWrite( struct HostStreamBuffer * pxBuffer, const uint8_t * pucData, size_t xLength )
+{
+    for( size_t i = 0; i < xLength; i++ )
+    {
+        pxBuffer->pucStorage[ ( pxBuffer->xHead + pxBuffer->xCount ) % pxBuffer->xSize ] = pucData[ i ];
+        pxBuffer->xCount++;
+    }
+}
+
+static void prvStreamRead( struct HostStreamBuffer * pxBuffer, uint8_t * pucData, size_t xLength, BaseType_t xConsume )
+{
+    for( size_t i = 0; i < xLength; i++ )
+    {
+        pucData[ i ] = pxBuffer->pucStorage[ ( pxBuffer->xHead + i ) % pxBuffer->xSize ];
+    }
+    if( xConsume == pdTRUE )
+    {
+        pxBuffer->xHead = ( pxBuffer->xHead + xLength ) % pxBuffer->xSize;
+        pxBuffer->xCount -= xLength;
+    }
+}
+
+static size_t prvStreamSend( struct HostStreamBuffer * pxBuffer, const void * pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    size_t xRequired = xDataLengthBytes + ( pxBuffer->xIsMessageBuffer == pdTRUE ? HOST_MESSAGE_LENGTH_SIZE : 0 );
+    size_t xSent;
+
+    pthread_mutex_lock( &xKernelLock );
+    while( pxBuffer->xSize - pxBuffer->xCount < xRequired && xTicksToWait != 0 && prvExpired( ullDeadline ) == pdFALSE )
+    {
+        prvWait( ullDeadline );
+    }
+
+    if( pxBuffer->xIsMessageBuffer == pdTRUE )
+    {
+        uint32_t ulLength = ( uint32_t )xDataLengthBytes;
+
+        if( pxBuffer->xSize - pxBuffer->xCount < xRequired )
+        {
+            xSent = 0;
+        }
+        else
+        {
+            prvStreamWrite( pxBuffer, ( const uint8_t * )&ulLength, HOST_MESSAGE_LENGTH_SIZE );
+            prvStreamWrite( pxBuffer, pvTxData, xDataLengthBytes );
+            xSent = xDataLengthBytes;
+        }
+    }
+    else
+    {
+        /* A stream buffer takes as much as fits once the wait is over. */
+        xSent = pxBuffer->xSize - pxBuffer->xCount;
+        xSent = ( xSent < xDataLengthBytes ) ? xSent : xDataLengthBytes;
+        prvStreamWrite( pxBuffer, pvTxData, xSent );
+    }
+    if( xSent > 0 )
+    {
+        prvChanged();
+    }
+    pthread_mutex_unlock( &xKernelLock );
+
+    return xSent;
+}
+
+static size_t prvStreamReceive( struct HostStreamBuffer * pxBuffer, void * pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    size_t xReceived = 0;
+
+    pthread_mutex_lock( &xKernelLock );
+    if( pxBuffer->xCount == 0 )
+    {
+        /* Once it has to wait, it waits for the trigger level, as FreeRTOS does. */
+        while( pxBuffer->xCount < pxBuffer->xTriggerLevel && xTicksToWait != 0 && prvExpired( ullDeadline ) == pdFALSE )
+        {
+            prvWait( ullDeadline );
+        }
+    }
+
+    if( pxBuffer->xIsMessageBuffer == pdTRUE )
+    {
+        uint32_t ulLength;
+
+        if( pxBuffer->xCount >= HOST_MESSAGE_LENGTH_SIZE )
+        {
+            prvStreamRead( pxBuffer, ( uint8_t * )&ulLength, HOST_MESSAGE_LENGTH_SIZE, pdFALSE );
+            if( ulLength <= xBufferLengthBytes )
+            {
+                uint8_t ucLength[ HOST_MESSAGE_LENGTH_SIZE ];
+
+                prvStreamRead( pxBuffer, ucLength, HOST_MESSAGE_LENGTH_SIZE, pdTRUE );
+                prvStreamRead( pxBuffer, pvRxData, ulLength, pdTRUE );
+                xReceived = ulLength;
+            }
+        }
+    }
+    else
+    {
+        xReceived = ( pxBuffer->xCount < xBufferLengthBytes ) ? pxBuffer->xCount : xBufferLengthBytes;
+        prvStreamRead( pxBuffer, pvRxData, xReceived, pdTRUE );
+    }
+    if( xReceived > 0 )
+    {
+        prvChanged();
+    }
+    pthread_mutex_unlock( &xKernelLock );
+
+    return xReceived;
+}
+
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer, const void * pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait )
+{
+    return prvStreamSend( xStreamBuffer, pvTxData, xDataLengthBytes, xTicksToWait );
+}
+
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer, const void * pvTxData, size_t xDataLengthBytes, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvStreamSend( xStreamBuffer, pvTxData, xDataLengthBytes, 0 );
+}
+
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer, void * pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+    return prvStreamReceive( xStreamBuffer, pvRxData, xBufferLengthBytes, xTicksToWait );
+}
+
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer, void * pvRxData, size_t xBufferLengthBytes, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvStreamReceive( xStreamBuffer, pvRxData, xBufferLengthBytes, 0 );
+}
+
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+    size_t xCount;
+
+    pthread_mutex_lock( &xKernelLock );
+    xCount = xStreamBuffer->xCount;
+    pthread_mutex_unlock( &xKernelLock );
+    return xCount;
+}
+
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+    size_t xSpaces;
+
+    pthread_mutex_lock( &xKernelLock );
+    xSpaces = xStreamBuffer->xSize - xStreamBuffer->xCount;
+    pthread_mutex_unlock( &xKernelLock );
+    return xSpaces;
+}
+
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer )
+{
+    pthread_mutex_lock( &xKernelLock );
+    xStreamBuffer->xHead = 0;
+    xStreamBuffer->xCount = 0;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+    return pdPASS;
+}
+
+size_t xMessageBufferSend( MessageBufferHandle_t xMessageBuffer, const void * pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait )
+{
+    return prvStreamSend( xMessageBuffer, pvTxData, xDataLengthBytes, xTicksToWait );
+}
+
+size_t xMessageBufferReceive( MessageBufferHandle_t xMessageBuffer, void * pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+    return prvStreamReceive( xMessageBuffer, pvRxData, xBufferLengthBytes, xTicksToWait );
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvDaemon( void * pvParameters )
+{
+    struct HostTimer * pxTimer;
+    struct HostTimer * pxDue;
+    HostPendedCall_t xCall;
+    uint64_t ullNext;
+
+    ( void )pvParameters;
+    pxCurrentTask = calloc( 1, sizeof( struct HostTask ) );
+    strcpy( pxCurrentTask->cName, "Tmr Svc" );
+
+    pthread_mutex_lock( &xKernelLock );
+    for( ; ; )
+    {
+        if( xDaemon.uxPendedCount > 0 )
+        {
+            xCall = xDaemon.xPended[ xDaemon.uxPendedHead ];
+            xDaemon.uxPendedHead = ( xDaemon.uxPendedHead + 1 ) % HOST_PENDED_CALLS;
+            xDaemon.uxPendedCount--;
+            prvChanged();
+            pthread_mutex_unlock( &xKernelLock );
+            xCall.xFunction( xCall.pvParameter1, xCall.ulParameter2 );
+            pthread_mutex_lock( &xKernelLock );
+            continue;
+        }
+
+        pxDue = NULL;
+        ullNext = UINT64_MAX;
+        for( pxTimer = xDaemon.pxTimers; pxTimer != NULL; pxTimer = pxTimer->pxNext )
+        {
+            if( pxTimer->xActive == pdTRUE && pxTimer->ullExpiry < ullNext )
+            {
+                ullNext = pxTimer->ullExpiry;
+                pxDue = pxTimer;
+            }
+        }
+
+        if( pxDue != NULL && prvNowMs() >= ullNext )
+        {
+            if( pxDue->uxAutoReload != pdFALSE )
+            {
+                pxDue->ullExpiry += pxDue->xPeriod;
+            }
+            else
+            {
+                pxDue->xActive = pdFALSE;
+            }
+            pthread_mutex_unlock( &xKernelLock );
+            pxDue->pxCallback( pxDue );
+            pthread_mutex_lock( &xKernelLock );
+            continue;
+        }
+
+        prvWait( ullNext );
+    }
+
+    return NULL;
+}
+
+TimerHandle_t xTimerCreate( const char * pcTimerName,
+                            TickType_t xTimerPeriodInTicks,
+                            UBaseType_t uxAutoReload,
+                            void * pvTimerID,
+                            TimerCallbackFunction_t pxCallbackFunction )
+{
+    struct HostTimer * pxTimer;
+
+    prvEnsureInit();
+    if( prvCharge( HOST_TIMER_SIZE ) == pdFALSE )
+    {
+        return NULL;
+    }
+
+    pxTimer = calloc( 1, sizeof( struct HostTimer ) );
+    pxTimer->pcName = pcTimerName;
+    pxTimer->xPeriod = xTimerPeriodInTicks;
+    pxTimer->uxAutoReload = uxAutoReload;
+    pxTimer->pvID = pvTimerID;
+    pxTimer->pxCallback = pxCallbackFunction;
+
+    pthread_mutex_lock( &xKernelLock );
+    pxTimer->pxNext = xDaemon.pxTimers;
+    xDaemon.pxTimers = pxTimer;
+    pthread_mutex_unlock( &xKernelLock );
+
+    return pxTimer;
+}
+
+static BaseType_t prvTimerStart( struct HostTimer * pxTimer, TickType_t xPeriod )
+{
+    pthread_mutex_lock( &xKernelLock );
+    if( xPeriod != 0 )
+    {
+        pxTimer->xPeriod = xPeriod;
+    }
+    pxTimer->ullExpiry = prvNowMs() + pxTimer->xPeriod;
+    pxTimer->xActive = pdTRUE;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+    return pdPASS;
+}
+
+BaseType_t xTimerStart( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    ( void )xTicksToWait;
+    return prvTimerStart( xTimer, 0 );
+}
+
+BaseType_t xTimerReset( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    ( void )xTicksToWait;
+    return prvTimerStart( xTimer, 0 );
+}
+
+BaseType_t xTimerChangePeriod( TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait )
+{
+    ( void )xTicksToWait;
+    configASSERT( xNewPeriod > 0 );
+    /* As in FreeRTOS, changing the period also starts the timer. */
+    return prvTimerStart( xTimer, xNewPeriod );
+}
+
+BaseType_t xTimerStop( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    ( void )xTicksToWait;
+    pthread_mutex_lock( &xKernelLock );
+    xTimer->xActive = pdFALSE;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive( TimerHandle_t xTimer )
+{
+    BaseType_t xActive;
+
+    pthread_mutex_lock( &xKernelLock );
+    xActive = xTimer->xActive;
+    pthread_mutex_unlock( &xKernelLock );
+    return xActive;
+}
+
+void * pvTimerGetTimerID( TimerHandle_t xTimer )
+{
+    return xTimer->pvID;
+}
+
+static BaseType_t prvPend( PendedFunction_t xFunctionToPend, void * pvParameter1, uint32_t ulParameter2, TickType_t xTicksToWait )
+{
+    uint64_t ullDeadline = prvDeadline( xTicksToWait );
+    UBaseType_t uxIndex;
+
+    prvEnsureInit();
+    pthread_mutex_lock( &xKernelLock );
+    while( xDaemon.uxPendedCount == HOST_PENDED_CALLS )
+    {
+        if( xTicksToWait == 0 || prvExpired( ullDeadline ) == pdTRUE )
+        {
+            pthread_mutex_unlock( &xKernelLock );
+            return pdFAIL;
+        }
+        prvWait( ullDeadline );
+    }
+    uxIndex = ( xDaemon.uxPendedHead + xDaemon.uxPendedCount ) % HOST_PENDED_CALLS;
+    xDaemon.xPended[ uxIndex ].xFunction = xFunctionToPend;
+    xDaemon.xPended[ uxIndex ].pvParameter1 = pvParameter1;
+    xDaemon.xPended[ uxIndex ].ulParameter2 = ulParameter2;
+    xDaemon.uxPendedCount++;
+    prvChanged();
+    pthread_mutex_unlock( &xKernelLock );
+
+    return pdPASS;
+}
+
+BaseType_t xTimerPendFunctionCall( PendedFunction_t xFunctionToPend, void * pvParameter1, uint32_t ulParameter2, TickType_t xTicksToWait )
+{
+    return prvPend( xFunctionToPend, pvParameter1, ulParameter2, xTicksToWait );
+}
+
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t xFunctionToPend, void * pvParameter1, uint32_t ulParameter2, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void )pxHigherPriorityTaskWoken;
+    return prvPend( xFunctionToPend, pvParameter1, ulParameter2, 0 );
+}
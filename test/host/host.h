@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/* Hooks of the host build into what stands in for the board: the heap, interrupts, the log, the MQTT broker, the
+ * audio DMA, the touch button and the Opus codec.
+ */
+
+typedef struct {
+    size_t xUsed;
+    size_t xPeak;
+    uint32_t ulAllocations;
+    /* Allocations refused for going over the cap. */
+    uint32_t ulFailures;
+} HostHeapStats_t;
+
+/* Refuse allocations that would take the heap beyond xCap bytes. 0 removes the cap. */
+void vHostSetHeapCap( size_t xCap );
+void vHostHeapStats( HostHeapStats_t * pxStats );
+
+/* Run the caller as an interrupt: no task or other interrupt touches what the critical section guards meanwhile. */
+void vHostInterruptEnter( void );
+void vHostInterruptExit( void );
+
+/* Every line logged is given to vHook, if not NULL. xQuiet stops printing to stdout. */
+void vHostSetLogHook( void ( * vHook )( const char * pcLine ), BaseType_t xQuiet );
+
+/* Called for every message published by the client, on the publishing task. */
+typedef void ( * HostBrokerHandler_t )( const char * pcTopic, size_t xTopicLength, const uint8_t * pucPayload, size_t xLength );
+void vHostMqttSetBroker( HostBrokerHandler_t xHandler );
+
+/* Stall every ulEvery-th publish for ulDelayMs before it goes out, as a congested link would. 0 disables it. */
+void vHostMqttSetPublishDelay( uint32_t ulDelayMs, uint32_t ulEvery );
+
+/* Deliver a message to the client, in order, from the receive thread of the connection. */
+void vHostMqttDeliver( const char * pcTopic, const void * pvPayload, size_t xLength );
+
+/* Fill the frame of each microphone DMA transfer, in the capture format of the client. */
+typedef void ( * HostMicrophoneSource_t )( void * pvFrame, size_t xBytes );
+void vHostPlatformSetMicrophoneSource( HostMicrophoneSource_t xSource );
+
+/* Each speaker DMA transfer, with the bytes the client had for it. */
+typedef void ( * HostSpeakerSink_t )( const int16_t * psSamples, size_t xSamples, size_t xBytesRead );
+void vHostPlatformSetSpeakerSink( HostSpeakerSink_t xSink );
+
+/* Delay the first transfer of the speaker and the microphone after they are started, as the codec and a PDM
+ * microphone take to settle on a board. Both are 0 by default.
+ */
+void vHostPlatformSetStartupDelay( uint32_t ulSpeakerMs, uint32_t ulMicrophoneMs );
+
+typedef struct {
+    uint32_t ulMicrophoneFrames;
+    /* Transfers that found no frame of the client to write to. */
+    uint32_t ulMicrophoneDiscarded;
+    uint32_t ulSpeakerTransfers;
+    /* Transfers of an open speaker that the client could not fill. */
+    uint32_t ulSpeakerUnderruns;
+    BaseType_t xMicrophoneOpen;
+    BaseType_t xSpeakerOpen;
+    BaseType_t xTouchEnabled;
+} HostPlatformStats_t;
+void vHostPlatformStats( HostPlatformStats_t * pxStats );
+
+/* Touch the button, or let go of it. The scan sees it within HOST_CAPSENSE_SCAN_INTERVAL_MS (10ms), and reports a
+ * touch-down 2 scans later, unless the client has the button disabled, as on the board.
+ */
+void vHostTouch( BaseType_t xPressed );
+
+typedef struct {
+    uint32_t ulDecoded;
+    uint32_t ulConcealed;
+    uint32_t ulFec;
+    uint32_t ulDecoderResets;
+    uint32_t ulEncoded;
+    uint32_t ulEncodeFailures;
+} HostOpusStats_t;
+void vHostOpusStats( HostOpusStats_t * pxStats );
+
+/* Fail every ulFrames-th call to opus_encode(). 0 disables it. */
+void vHostOpusFailEncodeEvery( uint32_t ulFrames );
+
+#endif /* _HOST_H_ */
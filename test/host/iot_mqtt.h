@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_IOT_MQTT_H_
+#define _HOST_IOT_MQTT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The config header is always included first, as by the MQTT library. */
+#include "iot_config.h"
+
+/* The MQTT API used by the AIA client and the demo, as in libraries/c_sdk/standard/mqtt. mqtt_host.c connects the
+ * client to a broker in the same process, see host.h.
+ */
+typedef struct _mqttConnection * IotMqttConnection_t;
+
+typedef enum {
+    IOT_MQTT_SUCCESS = 0,
+    IOT_MQTT_STATUS_PENDING,
+    IOT_MQTT_INIT_FAILED,
+    IOT_MQTT_BAD_PARAMETER,
+    IOT_MQTT_NO_MEMORY,
+    IOT_MQTT_NETWORK_ERROR,
+    IOT_MQTT_SCHEDULING_ERROR,
+    IOT_MQTT_BAD_RESPONSE,
+    IOT_MQTT_TIMEOUT,
+    IOT_MQTT_SERVER_REFUSED,
+    IOT_MQTT_RETRY_NO_RESPONSE
+} IotMqttError_t;
+
+typedef enum {
+    IOT_MQTT_QOS_0 = 0,
+    IOT_MQTT_QOS_1 = 1,
+    IOT_MQTT_QOS_2 = 2
+} IotMqttQos_t;
+
+typedef struct {
+    IotMqttQos_t qos;
+    bool retain;
+    const char * pTopicName;
+    uint16_t topicNameLength;
+    const void * pPayload;
+    size_t payloadLength;
+    uint32_t retryMs;
+    uint32_t retryLimit;
+} IotMqttPublishInfo_t;
+
+#define IOT_MQTT_PUBLISH_INFO_INITIALIZER   { .qos = IOT_MQTT_QOS_0 }
+
+typedef struct {
+    IotMqttConnection_t mqttConnection;
+    union {
+        struct {
+            const char * pTopicFilter;
+            uint16_t topicFilterLength;
+            IotMqttPublishInfo_t info;
+        } message;
+    } u;
+} IotMqttCallbackParam_t;
+
+typedef struct {
+    void * pCallbackContext;
+    void ( * function )( void *, IotMqttCallbackParam_t * );
+} IotMqttCallbackInfo_t;
+
+typedef struct {
+    IotMqttQos_t qos;
+    const char * pTopicFilter;
+    uint16_t topicFilterLength;
+    IotMqttCallbackInfo_t callback;
+} IotMqttSubscription_t;
+
+#define IOT_MQTT_SUBSCRIPTION_INITIALIZER   { .qos = IOT_MQTT_QOS_0 }
+
+typedef struct IotMqttSerializer {
+    struct {
+        IotMqttError_t ( * publish )( const IotMqttPublishInfo_t * pPublishInfo,
+                                      uint8_t ** pPublishPacket,
+                                      size_t * pPacketSize,
+                                      uint16_t * pPacketIdentifier,
+                                      uint8_t ** pPacketIdentifierHigh );
+    } serialize;
+} IotMqttSerializer_t;
+
+typedef struct {
+    const IotMqttSerializer_t * pMqttSerializer;
+} IotMqttNetworkInfo_t;
+
+#define IOT_MQTT_NETWORK_INFO_INITIALIZER   { 0 }
+
+IotMqttError_t IotMqtt_Connect( const IotMqttNetworkInfo_t * pNetworkInfo,
+                                const void * pConnectInfo,
+                                uint32_t timeoutMs,
+                                IotMqttConnection_t * const pMqttConnection );
+void IotMqtt_Disconnect( IotMqttConnection_t mqttConnection, uint32_t flags );
+IotMqttError_t IotMqtt_Publish( IotMqttConnection_t mqttConnection,
+                                const IotMqttPublishInfo_t * pPublishInfo,
+                                uint32_t flags,
+                                const void * pCallbackInfo,
+                                void * pPublishOperation );
+IotMqttError_t IotMqtt_TimedSubscribe( IotMqttConnection_t mqttConnection,
+                                       const IotMqttSubscription_t * pSubscriptionList,
+                                       size_t subscriptionCount,
+                                       uint32_t flags,
+                                       uint32_t timeoutMs );
+const char * IotMqtt_strerror( IotMqttError_t status );
+
+#endif /* _HOST_IOT_MQTT_H_ */
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* A tokenizer with the behaviour of jsmn in its default, non-strict mode: tokens are emitted in document order, a key
+ * has size 1, an object has the number of its keys as size and an array the number of its elements.
+ */
+
+#include "jsmn.h"
+
+static jsmntok_t * prvAlloc( jsmn_parser * parser, jsmntok_t * tokens, unsigned int num_tokens )
+{
+    jsmntok_t * tok;
+
+    if( parser->toknext >= num_tokens )
+    {
+        return NULL;
+    }
+    tok = &tokens[ parser->toknext++ ];
+    tok->start = tok->end = -1;
+    tok->size = 0;
+    return tok;
+}
+
+static void prvFill( jsmntok_t * token, jsmntype_t type, int start, int end )
+{
+    token->type = type;
+    token->start = start;
+    token->end = end;
+    token->size = 0;
+}
+
+static int prvPrimitive( jsmn_parser * parser, const char * js, size_t len, jsmntok_t * tokens, unsigned int num_tokens )
+{
+    jsmntok_t * token;
+    int start = ( int )parser->pos;
+
+    for( ; parser->pos < len && js[ parser->pos ] != '\0'; parser->pos++ )
+    {
+        char c = js[ parser->pos ];
+
+        if( c == ':' || c == '\t' || c == '\r' || c == '\n' || c == ' ' || c == ',' || c == ']' || c == '}' )
+        {
+            break;
+        }
+        if( c < 32 || c >= 127 )
+        {
+            parser->pos = ( unsigned int )start;
+            return JSMN_ERROR_INVAL;
+        }
+    }
+
+    if( tokens == NULL )
+    {
+        parser->pos--;
+        return 0;
+    }
+    token = prvAlloc( parser, tokens, num_tokens );
+    if( token == NULL )
+    {
+        parser->pos = ( unsigned int )start;
+        return JSMN_ERROR_NOMEM;
+    }
+    prvFill( token, JSMN_PRIMITIVE, start, ( int )parser->pos );
+    parser->pos--;
+    return 0;
+}
+
+static int prvString( jsmn_parser * parser, const char * js, size_t len, jsmntok_t * tokens, unsigned int num_tokens )
+{
+    jsmntok_t * token;
+    int start = ( int )parser->pos;
+
+    parser->pos++;
+    for( ; parser->pos < len && js[ parser->pos ] != '\0'; parser->pos++ )
+    {
+        char c = js[ parser->pos ];
+
+        if( c == '\"' )
+        {
+            if( tokens == NULL )
+            {
+                return 0;
+            }
+            token = prvAlloc( parser, tokens, num_tokens );
+            if( token == NULL )
+            {
+                parser->pos = ( unsigned int )start;
+                return JSMN_ERROR_NOMEM;
+            }
+            prvFill( token, JSMN_STRING, start + 1, ( int )parser->pos );
+            return 0;
+        }
+        if( c == '\\' && parser->pos + 1 < len )
+        {
+            parser->pos++;
+        }
+    }
+    parser->pos = ( unsigned int )start;
+    return JSMN_ERROR_PART;
+}
+
+void jsmn_init( jsmn_parser * parser )
+{
+    parser->pos = 0;
+    parser->toknext = 0;
+    parser->toksuper = -1;
+}
+
+int jsmn_parse( jsmn_parser * parser, const char * js, size_t len, jsmntok_t * tokens, unsigned int num_tokens )
+{
+    int r;
+    int i;
+    jsmntok_t * token;
+    int count = ( int )parser->toknext;
+
+    for( ; parser->pos < len && js[ parser->pos ] != '\0'; parser->pos++ )
+    {
+        char c = js[ parser->pos ];
+        jsmntype_t type;
+
+        switch( c )
+        {
+            case '{':
+            case '[':
+                count++;
+                if( tokens == NULL )
+                {
+                    break;
+                }
+                token = prvAlloc( parser, tokens, num_tokens );
+                if( token == NULL )
+                {
+                    return JSMN_ERROR_NOMEM;
+                }
+                if( parser->toksuper != -1 )
+                {
+                    tokens[ parser->toksuper ].size++;
+                }
+                token->type = ( c == '{' ) ? JSMN_OBJECT : JSMN_ARRAY;
+                token->start = ( int )parser->pos;
+                parser->toksuper = ( int )parser->toknext - 1;
+                break;
+            case '}':
+            case ']':
+                if( tokens == NULL )
+                {
+                    break;
+                }
+                type = ( c == '}' ) ? JSMN_OBJECT : JSMN_ARRAY;
+                for( i = ( int )parser->toknext - 1; i >= 0; i-- )
+                {
+                    token = &tokens[ i ];
+                    if( token->start != -1 && token->end == -1 )
+                    {
+                        if( token->type != type )
+                        {
+                            return JSMN_ERROR_INVAL;
+                        }
+                        parser->toksuper = -1;
+                        token->end = ( int )parser->pos + 1;
+                        break;
+                    }
+                }
+                if( i == -1 )
+                {
+                    return JSMN_ERROR_INVAL;
+                }
+                for( ; i >= 0; i-- )
+                {
+                    token = &tokens[ i ];
+                    if( token->start != -1 && token->end == -1 )
+                    {
+                        parser->toksuper = i;
+                        break;
+                    }
+                }
+                break;
+            case '\"':
+                r = prvString( parser, js, len, tokens, num_tokens );
+                if( r < 0 )
+                {
+                    return r;
+                }
+                count++;
+                if( parser->toksuper != -1 && tokens != NULL )
+                {
+                    tokens[ parser->toksuper ].size++;
+                }
+                break;
+            case '\t':
+            case '\r':
+            case '\n':
+            case ' ':
+                break;
+            case ':':
+                parser->toksuper = ( int )parser->toknext - 1;
+                break;
+            case ',':
+                if( tokens != NULL && parser->toksuper != -1 &&
+                    tokens[ parser->toksuper ].type != JSMN_ARRAY &&
+                    tokens[ parser->toksuper ].type != JSMN_OBJECT )
+                {
+                    for( i = ( int )parser->toknext - 1; i >= 0; i-- )
+                    {
+                        if( tokens[ i ].type == JSMN_ARRAY || tokens[ i ].type == JSMN_OBJECT )
+                        {
+                            if( tokens[ i ].start != -1 && tokens[ i ].end == -1 )
+                            {
+                                parser->toksuper = i;
+                                break;
+                            }
+                        }
+                    }
+                }
+                break;
+            default:
+                r = prvPrimitive( parser, js, len, tokens, num_tokens );
+                if( r < 0 )
+                {
+                    return r;
+                }
+                count++;
+                if( parser->toksuper != -1 && tokens != NULL )
+                {
+                    tokens[ parser->toksuper ].size++;
+                }
+                break;
+        }
+    }
+
+    if( tokens != NULL )
+    {
+        for( i = ( int )parser->toknext - 1; i >= 0; i-- )
+        {
+            if( tokens[ i ].start != -1 && tokens[ i ].end == -1 )
+            {
+                return JSMN_ERROR_PART;
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_MBEDTLS_CIPHER_H_
+#define _HOST_MBEDTLS_CIPHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Only AES-256-GCM is provided, on top of nettle, see mbedtls_host.c. */
+#define MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA   -0x6100
+#define MBEDTLS_ERR_CIPHER_AUTH_FAILED      -0x6300
+
+typedef enum {
+    MBEDTLS_CIPHER_AES_256_GCM = 1
+} mbedtls_cipher_type_t;
+
+typedef enum {
+    MBEDTLS_DECRYPT = 0,
+    MBEDTLS_ENCRYPT
+} mbedtls_operation_t;
+
+typedef struct {
+    mbedtls_cipher_type_t type;
+} mbedtls_cipher_info_t;
+
+typedef struct {
+    const mbedtls_cipher_info_t * cipher_info;
+    unsigned char key[ 32 ];
+} mbedtls_cipher_context_t;
+
+void mbedtls_cipher_init( mbedtls_cipher_context_t * ctx );
+void mbedtls_cipher_free( mbedtls_cipher_context_t * ctx );
+const mbedtls_cipher_info_t * mbedtls_cipher_info_from_type( const mbedtls_cipher_type_t cipher_type );
+int mbedtls_cipher_setup( mbedtls_cipher_context_t * ctx, const mbedtls_cipher_info_t * cipher_info );
+int mbedtls_cipher_setkey( mbedtls_cipher_context_t * ctx, const unsigned char * key, int key_bitlen, const mbedtls_operation_t operation );
+int mbedtls_cipher_auth_encrypt( mbedtls_cipher_context_t * ctx,
+                                 const unsigned char * iv, size_t iv_len,
+                                 const unsigned char * ad, size_t ad_len,
+                                 const unsigned char * input, size_t ilen,
+                                 unsigned char * output, size_t * olen,
+                                 unsigned char * tag, size_t tag_len );
+int mbedtls_cipher_auth_decrypt( mbedtls_cipher_context_t * ctx,
+                                 const unsigned char * iv, size_t iv_len,
+                                 const unsigned char * ad, size_t ad_len,
+                                 const unsigned char * input, size_t ilen,
+                                 unsigned char * output, size_t * olen,
+                                 const unsigned char * tag, size_t tag_len );
+
+#endif /* _HOST_MBEDTLS_CIPHER_H_ */
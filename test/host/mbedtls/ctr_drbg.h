@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_MBEDTLS_CTR_DRBG_H_
+#define _HOST_MBEDTLS_CTR_DRBG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A deterministic generator, so that runs of the host tests can be compared. It is not a DRBG. */
+typedef struct {
+    uint64_t ullState;
+} mbedtls_ctr_drbg_context;
+
+void mbedtls_ctr_drbg_init( mbedtls_ctr_drbg_context * ctx );
+void mbedtls_ctr_drbg_free( mbedtls_ctr_drbg_context * ctx );
+int mbedtls_ctr_drbg_seed( mbedtls_ctr_drbg_context * ctx,
+                           int ( * f_entropy )( void *, unsigned char *, size_t ),
+                           void * p_entropy,
+                           const unsigned char * custom,
+                           size_t len );
+int mbedtls_ctr_drbg_random( void * p_rng, unsigned char * output, size_t output_len );
+
+#endif /* _HOST_MBEDTLS_CTR_DRBG_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_MBEDTLS_ECDH_H_
+#define _HOST_MBEDTLS_ECDH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Curve25519 only. An mpi is a 256-bit big-endian integer, as mbedtls reads and writes it. */
+#define MBEDTLS_ERR_ECP_BAD_INPUT_DATA      -0x4F80
+
+typedef enum {
+    MBEDTLS_ECP_DP_NONE = 0,
+    MBEDTLS_ECP_DP_CURVE25519
+} mbedtls_ecp_group_id;
+
+typedef struct {
+    unsigned char p[ 32 ];
+} mbedtls_mpi;
+
+typedef struct {
+    mbedtls_mpi X;
+    mbedtls_mpi Y;
+    mbedtls_mpi Z;
+} mbedtls_ecp_point;
+
+typedef struct {
+    mbedtls_ecp_group_id id;
+    size_t nbits;
+} mbedtls_ecp_group;
+
+void mbedtls_ecp_group_init( mbedtls_ecp_group * grp );
+void mbedtls_ecp_point_init( mbedtls_ecp_point * pt );
+void mbedtls_mpi_init( mbedtls_mpi * X );
+int mbedtls_ecp_group_load( mbedtls_ecp_group * grp, mbedtls_ecp_group_id id );
+int mbedtls_mpi_lset( mbedtls_mpi * X, int z );
+int mbedtls_mpi_read_binary( mbedtls_mpi * X, const unsigned char * buf, size_t buflen );
+int mbedtls_mpi_write_binary( const mbedtls_mpi * X, unsigned char * buf, size_t buflen );
+int mbedtls_mpi_set_bit( mbedtls_mpi * X, size_t pos, unsigned char val );
+int mbedtls_ecp_check_pubkey( const mbedtls_ecp_group * grp, const mbedtls_ecp_point * pt );
+int mbedtls_ecp_check_privkey( const mbedtls_ecp_group * grp, const mbedtls_mpi * d );
+int mbedtls_ecdh_compute_shared( mbedtls_ecp_group * grp,
+                                 mbedtls_mpi * z,
+                                 const mbedtls_ecp_point * Q,
+                                 const mbedtls_mpi * d,
+                                 int ( * f_rng )( void *, unsigned char *, size_t ),
+                                 void * p_rng );
+
+#endif /* _HOST_MBEDTLS_ECDH_H_ */
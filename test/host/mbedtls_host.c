@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The mbedtls calls made by aia_crypto.c, implemented with nettle so that the host build encrypts and decrypts
+ * exactly as the board does. */
+
+#include <string.h>
+#include <stdint.h>
+
+#include <nettle/base64.h>
+#include <nettle/curve25519.h>
+#include <nettle/gcm.h>
+
+#include "mbedtls/base64.h"
+#include "mbedtls/cipher.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/entropy.h"
+
+#define MBEDTLS_ERR_BASE64_INVALID_CHARACTER    -0x002C
+
+static const mbedtls_cipher_info_t xAes256Gcm = { MBEDTLS_CIPHER_AES_256_GCM };
+
+int mbedtls_base64_decode( unsigned char * dst, size_t dlen, size_t * olen, const unsigned char * src, size_t slen )
+{
+    struct base64_decode_ctx xCtx;
+    size_t xLength = dlen;
+
+    base64_decode_init( &xCtx );
+    if( BASE64_DECODE_LENGTH( slen ) > dlen + 2 ||
+        base64_decode_update( &xCtx, &xLength, dst, slen, ( const char * )src ) == 0 ||
+        base64_decode_final( &xCtx ) == 0 )
+    {
+        *olen = 0;
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+    *olen = xLength;
+    return 0;
+}
+
+void mbedtls_cipher_init( mbedtls_cipher_context_t * ctx )
+{
+    memset( ctx, 0, sizeof( *ctx ) );
+}
+
+void mbedtls_cipher_free( mbedtls_cipher_context_t * ctx )
+{
+    memset( ctx, 0, sizeof( *ctx ) );
+}
+
+const mbedtls_cipher_info_t * mbedtls_cipher_info_from_type( const mbedtls_cipher_type_t cipher_type )
+{
+    return ( cipher_type == MBEDTLS_CIPHER_AES_256_GCM ) ? &xAes256Gcm : NULL;
+}
+
+int mbedtls_cipher_setup( mbedtls_cipher_context_t * ctx, const mbedtls_cipher_info_t * cipher_info )
+{
+    if( cipher_info == NULL )
+    {
+        return MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA;
+    }
+    ctx->cipher_info = cipher_info;
+    return 0;
+}
+
+int mbedtls_cipher_setkey( mbedtls_cipher_context_t * ctx, const unsigned char * key, int key_bitlen, const mbedtls_operation_t operation )
+{
+    ( void )operation;
+    if( ctx->cipher_info == NULL || key_bitlen != 256 )
+    {
+        return MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA;
+    }
+    memcpy( ctx->key, key, sizeof( ctx->key ) );
+    return 0;
+}
+
+static void prvGcmStart( struct gcm_aes256_ctx * pxGcm, const mbedtls_cipher_context_t * ctx,
+                         const unsigned char * iv, size_t iv_len, const unsigned char * ad, size_t ad_len )
+{
+    gcm_aes256_set_key( pxGcm, ctx->key );
+    gcm_aes256_set_iv( pxGcm, iv_len, iv );
+    if( ad_len > 0 )
+    {
+        gcm_aes256_update( pxGcm, ad_len, ad );
+    }
+}
+
+int mbedtls_cipher_auth_encrypt( mbedtls_cipher_context_t * ctx,
+                                 const unsigned char * iv, size_t iv_len,
+                                 const unsigned char * ad, size_t ad_len,
+                                 const unsigned char * input, size_t ilen,
+                                 unsigned char * output, size_t * olen,
+                                 unsigned char * tag, size_t tag_len )
+{
+    struct gcm_aes256_ctx xGcm;
+
+    if( ctx->cipher_info == NULL || tag_len > GCM_DIGEST_SIZE )
+    {
+        return MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA;
+    }
+    prvGcmStart( &xGcm, ctx, iv, iv_len, ad, ad_len );
+    gcm_aes256_encrypt( &xGcm, ilen, output, input );
+    gcm_aes256_digest( &xGcm, tag_len, tag );
+    *olen = ilen;
+    return 0;
+}
+
+int mbedtls_cipher_auth_decrypt( mbedtls_cipher_context_t * ctx,
+                                 const unsigned char * iv, size_t iv_len,
+                                 const unsigned char * ad, size_t ad_len,
+                                 const unsigned char * input, size_t ilen,
+                                 unsigned char * output, size_t * olen,
+                                 const unsigned char * tag, size_t tag_len )
+{
+    struct gcm_aes256_ctx xGcm;
+    unsigned char ucTag[ GCM_DIGEST_SIZE ];
+
+    if( ctx->cipher_info == NULL || tag_len > GCM_DIGEST_SIZE )
+    {
+        return MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA;
+    }
+    prvGcmStart( &xGcm, ctx, iv, iv_len, ad, ad_len );
+    gcm_aes256_decrypt( &xGcm, ilen, output, input );
+    gcm_aes256_digest( &xGcm, tag_len, ucTag );
+    if( memcmp( ucTag, tag, tag_len ) != 0 )
+    {
+        /* mbedtls clears the output when the tag does not match. */
+        memset( output, 0, ilen );
+        *olen = 0;
+        return MBEDTLS_ERR_CIPHER_AUTH_FAILED;
+    }
+    *olen = ilen;
+    return 0;
+}
+
+void mbedtls_entropy_init( mbedtls_entropy_context * ctx )
+{
+    ctx->ulCalls = 0;
+}
+
+void mbedtls_entropy_free( mbedtls_entropy_context * ctx )
+{
+    ctx->ulCalls = 0;
+}
+
+int mbedtls_entropy_func( void * data, unsigned char * output, size_t len )
+{
+    mbedtls_entropy_context * ctx = ( mbedtls_entropy_context * )data;
+
+    memset( output, ( int )( ++ctx->ulCalls ), len );
+    return 0;
+}
+
+void mbedtls_ctr_drbg_init( mbedtls_ctr_drbg_context * ctx )
+{
+    ctx->ullState = 0;
+}
+
+void mbedtls_ctr_drbg_free( mbedtls_ctr_drbg_context * ctx )
+{
+    ctx->ullState = 0;
+}
+
+int mbedtls_ctr_drbg_seed( mbedtls_ctr_drbg_context * ctx,
+                           int ( * f_entropy )( void *, unsigned char *, size_t ),
+                           void * p_entropy,
+                           const unsigned char * custom,
+                           size_t len )
+{
+    unsigned char ucEntropy[ 8 ];
+    size_t i;
+
+    f_entropy( p_entropy, ucEntropy, sizeof( ucEntropy ) );
+    ctx->ullState = 0xcbf29ce484222325ULL;
+    for( i = 0; i < sizeof( ucEntropy ); i++ )
+    {
+        ctx->ullState = ( ctx->ullState ^ ucEntropy[ i ] ) * 0x100000001b3ULL;
+    }
+    for( i = 0; i < len; i++ )
+    {
+        ctx->ullState = ( ctx->ullState ^ custom[ i ] ) * 0x100000001b3ULL;
+    }
+    return 0;
+}
+
+int mbedtls_ctr_drbg_random( void * p_rng, unsigned char * output, size_t output_len )
+{
+    mbedtls_ctr_drbg_context * ctx = ( mbedtls_ctr_drbg_context * )p_rng;
+    size_t i;
+
+    for( i = 0; i < output_len; i++ )
+    {
+        /* splitmix64 */
+        uint64_t z = ( ctx->ullState += 0x9e3779b97f4a7c15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+        output[ i ] = ( unsigned char )( z ^ ( z >> 31 ) );
+    }
+    return 0;
+}
+
+void mbedtls_ecp_group_init( mbedtls_ecp_group * grp )
+{
+    memset( grp, 0, sizeof( *grp ) );
+}
+
+void mbedtls_ecp_point_init( mbedtls_ecp_point * pt )
+{
+    memset( pt, 0, sizeof( *pt ) );
+}
+
+void mbedtls_mpi_init( mbedtls_mpi * X )
+{
+    memset( X, 0, sizeof( *X ) );
+}
+
+int mbedtls_ecp_group_load( mbedtls_ecp_group * grp, mbedtls_ecp_group_id id )
+{
+    if( id != MBEDTLS_ECP_DP_CURVE25519 )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    grp->id = id;
+    /* As mbedtls reports it for Curve25519. */
+    grp->nbits = 254;
+    return 0;
+}
+
+int mbedtls_mpi_lset( mbedtls_mpi * X, int z )
+{
+    int i;
+
+    memset( X->p, 0, sizeof( X->p ) );
+    for( i = 0; i < 4; i++ )
+    {
+        X->p[ sizeof( X->p ) - 1 - i ] = ( unsigned char )( ( unsigned int )z >> ( 8 * i ) );
+    }
+    return 0;
+}
+
+int mbedtls_mpi_read_binary( mbedtls_mpi * X, const unsigned char * buf, size_t buflen )
+{
+    if( buflen > sizeof( X->p ) )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    memset( X->p, 0, sizeof( X->p ) );
+    memcpy( X->p + sizeof( X->p ) - buflen, buf, buflen );
+    return 0;
+}
+
+int mbedtls_mpi_write_binary( const mbedtls_mpi * X, unsigned char * buf, size_t buflen )
+{
+    if( buflen < sizeof( X->p ) )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    memset( buf, 0, buflen - sizeof( X->p ) );
+    memcpy( buf + buflen - sizeof( X->p ), X->p, sizeof( X->p ) );
+    return 0;
+}
+
+int mbedtls_mpi_set_bit( mbedtls_mpi * X, size_t pos, unsigned char val )
+{
+    unsigned char * pucByte;
+
+    if( pos >= 8 * sizeof( X->p ) )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    pucByte = &X->p[ sizeof( X->p ) - 1 - pos / 8 ];
+    *pucByte = ( unsigned char )( ( *pucByte & ~( 1U << ( pos % 8 ) ) ) | ( ( val & 1U ) << ( pos % 8 ) ) );
+    return 0;
+}
+
+int mbedtls_ecp_check_pubkey( const mbedtls_ecp_group * grp, const mbedtls_ecp_point * pt )
+{
+    ( void )pt;
+    return ( grp->id == MBEDTLS_ECP_DP_CURVE25519 ) ? 0 : MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+}
+
+int mbedtls_ecp_check_privkey( const mbedtls_ecp_group * grp, const mbedtls_mpi * d )
+{
+    /* mbedtls requires a clamped Montgomery scalar: bits 0-2 clear and bit 254 set. */
+    if( grp->id != MBEDTLS_ECP_DP_CURVE25519 || ( d->p[ 31 ] & 0x07 ) != 0 || ( d->p[ 0 ] & 0xc0 ) != 0x40 )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    return 0;
+}
+
+static void prvReverse( unsigned char * pucDst, const unsigned char * pucSrc )
+{
+    int i;
+
+    for( i = 0; i < 32; i++ )
+    {
+        pucDst[ i ] = pucSrc[ 31 - i ];
+    }
+}
+
+int mbedtls_ecdh_compute_shared( mbedtls_ecp_group * grp,
+                                 mbedtls_mpi * z,
+                                 const mbedtls_ecp_point * Q,
+                                 const mbedtls_mpi * d,
+                                 int ( * f_rng )( void *, unsigned char *, size_t ),
+                                 void * p_rng )
+{
+    unsigned char ucScalar[ CURVE25519_SIZE ];
+    unsigned char ucPoint[ CURVE25519_SIZE ];
+    unsigned char ucShared[ CURVE25519_SIZE ];
+
+    ( void )f_rng;
+    ( void )p_rng;
+    if( mbedtls_ecp_check_privkey( grp, d ) != 0 )
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    /* nettle takes X25519 little-endian encodings. */
+    prvReverse( ucScalar, d->p );
+    prvReverse( ucPoint, Q->X.p );
+    curve25519_mul( ucShared, ucScalar, ucPoint );
+    prvReverse( z->p, ucShared );
+    return 0;
+}
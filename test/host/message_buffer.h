@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_MESSAGE_BUFFER_H_
+#define _HOST_MESSAGE_BUFFER_H_
+
+#include "stream_buffer.h"
+
+/* Message buffers are stream buffers of messages prefixed with their length, as in FreeRTOS. */
+typedef StreamBufferHandle_t MessageBufferHandle_t;
+
+MessageBufferHandle_t xMessageBufferCreate( size_t xBufferSizeBytes );
+size_t xMessageBufferSend( MessageBufferHandle_t xMessageBuffer, const void * pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait );
+size_t xMessageBufferReceive( MessageBufferHandle_t xMessageBuffer, void * pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait );
+#define vMessageBufferDelete( xMessageBuffer )          vStreamBufferDelete( xMessageBuffer )
+#define xMessageBufferReset( xMessageBuffer )           xStreamBufferReset( xMessageBuffer )
+
+#endif /* _HOST_MESSAGE_BUFFER_H_ */
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* An MQTT connection to a broker in the same process. Publishing goes through the serializer of the connection, as
+ * with the MQTT library, and the packet it builds is parsed back and handed to the broker. Messages for the client
+ * are read into buffers from IotMqtt_MallocMessage(), which iot_config.h of the board maps to pvAIARecvPoolMalloc(),
+ * and given to the callback of the subscription on a receive thread.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "iot_mqtt.h"
+#include "host.h"
+#include "aia_recvpool.h"
+
+#define HOST_MQTT_SUBSCRIPTIONS             ( 8U )
+#define HOST_MQTT_TOPIC_MAX                 ( 128U )
+
+typedef struct HostMessage {
+    char cTopic[ HOST_MQTT_TOPIC_MAX ];
+    uint16_t usTopicLength;
+    uint8_t * pucPayload;
+    size_t xLength;
+    struct HostMessage * pxNext;
+} HostMessage_t;
+
+struct _mqttConnection {
+    const IotMqttSerializer_t * pxSerializer;
+    struct {
+        char cFilter[ HOST_MQTT_TOPIC_MAX ];
+        uint16_t usFilterLength;
+        IotMqttCallbackInfo_t xCallback;
+    } xSubscriptions[ HOST_MQTT_SUBSCRIPTIONS ];
+    size_t xSubscriptionCount;
+    pthread_t xReceiveThread;
+};
+
+static pthread_mutex_t xLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xDelivered = PTHREAD_COND_INITIALIZER;
+static HostMessage_t * pxInboxHead;
+static HostMessage_t * pxInboxTail;
+static HostBrokerHandler_t xBroker;
+static uint32_t ulPublishDelayMs;
+static uint32_t ulPublishDelayEvery;
+static uint32_t ulPublishes;
+
+void vHostMqttSetBroker( HostBrokerHandler_t xHandler )
+{
+    pthread_mutex_lock( &xLock );
+    xBroker = xHandler;
+    pthread_mutex_unlock( &xLock );
+}
+
+void vHostMqttSetPublishDelay( uint32_t ulDelayMs, uint32_t ulEvery )
+{
+    pthread_mutex_lock( &xLock );
+    ulPublishDelayMs = ulDelayMs;
+    ulPublishDelayEvery = ulEvery;
+    pthread_mutex_unlock( &xLock );
+}
+
+void vHostMqttDeliver( const char * pcTopic, const void * pvPayload, size_t xLength )
+{
+    HostMessage_t * pxMessage = calloc( 1, sizeof( HostMessage_t ) );
+
+    pxMessage->usTopicLength = ( uint16_t )strlen( pcTopic );
+    configASSERT( pxMessage->usTopicLength < HOST_MQTT_TOPIC_MAX );
+    memcpy( pxMessage->cTopic, pcTopic, pxMessage->usTopicLength );
+    pxMessage->pucPayload = malloc( xLength > 0 ? xLength : 1 );
+    memcpy( pxMessage->pucPayload, pvPayload, xLength );
+    pxMessage->xLength = xLength;
+
+    pthread_mutex_lock( &xLock );
+    if( pxInboxTail == NULL )
+    {
+        pxInboxHead = pxMessage;
+    }
+    else
+    {
+        pxInboxTail->pxNext = pxMessage;
+    }
+    pxInboxTail = pxMessage;
+    pthread_cond_signal( &xDelivered );
+    pthread_mutex_unlock( &xLock );
+}
+
+static void prvDispatch( struct _mqttConnection * pxConnection, HostMessage_t * pxMessage )
+{
+    IotMqttCallbackParam_t xParam;
+    IotMqttCallbackInfo_t xCallback = { 0 };
+    /* MQTT reads the whole PUBLISH packet, so the buffer also holds the fixed header and the topic. */
+    size_t xHeader = 5 + 2 + pxMessage->usTopicLength;
+    uint8_t * pucPacket = IotMqtt_MallocMessage( xHeader + pxMessage->xLength );
+
+    if( pucPacket == NULL )
+    {
+        fprintf( stderr, "mqtt_host: no memory for a message of %zu bytes to %s\n", pxMessage->xLength, pxMessage->cTopic );
+        return;
+    }
+    memcpy( pucPacket + xHeader, pxMessage->pucPayload, pxMessage->xLength );
+
+    pthread_mutex_lock( &xLock );
+    for( size_t i = 0; i < pxConnection->xSubscriptionCount; i++ )
+    {
+        if( pxConnection->xSubscriptions[ i ].usFilterLength == pxMessage->usTopicLength &&
+            memcmp( pxConnection->xSubscriptions[ i ].cFilter, pxMessage->cTopic, pxMessage->usTopicLength ) == 0 )
+        {
+            xCallback = pxConnection->xSubscriptions[ i ].xCallback;
+        }
+    }
+    pthread_mutex_unlock( &xLock );
+
+    if( xCallback.function != NULL )
+    {
+        memset( &xParam, 0, sizeof( xParam ) );
+        xParam.mqttConnection = pxConnection;
+        xParam.u.message.info.qos = IOT_MQTT_QOS_0;
+        xParam.u.message.info.pTopicName = pxMessage->cTopic;
+        xParam.u.message.info.topicNameLength = pxMessage->usTopicLength;
+        xParam.u.message.info.pPayload = pucPacket + xHeader;
+        xParam.u.message.info.payloadLength = pxMessage->xLength;
+        xCallback.function( xCallback.pCallbackContext, &xParam );
+    }
+
+    IotMqtt_FreeMessage( pucPacket );
+}
+
+static void * prvReceive( void * pvParameters )
+{
+    struct _mqttConnection * pxConnection = ( struct _mqttConnection * )pvParameters;
+    HostMessage_t * pxMessage;
+
+    for( ; ; )
+    {
+        pthread_mutex_lock( &xLock );
+        while( pxInboxHead == NULL )
+        {
+            pthread_cond_wait( &xDelivered, &xLock );
+        }
+        pxMessage = pxInboxHead;
+        pxInboxHead = pxMessage->pxNext;
+        if( pxInboxHead == NULL )
+        {
+            pxInboxTail = NULL;
+        }
+        pthread_mutex_unlock( &xLock );
+
+        prvDispatch( pxConnection, pxMessage );
+        free( pxMessage->pucPayload );
+        free( pxMessage );
+    }
+
+    return NULL;
+}
+
+IotMqttError_t IotMqtt_Connect( const IotMqttNetworkInfo_t * pNetworkInfo,
+                                const void * pConnectInfo,
+                                uint32_t timeoutMs,
+                                IotMqttConnection_t * const pMqttConnection )
+{
+    struct _mqttConnection * pxConnection = calloc( 1, sizeof( struct _mqttConnection ) );
+
+    ( void )pConnectInfo;
+    ( void )timeoutMs;
+    pxConnection->pxSerializer = pNetworkInfo->pMqttSerializer;
+    pthread_create( &pxConnection->xReceiveThread, NULL, prvReceive, pxConnection );
+    pthread_detach( pxConnection->xReceiveThread );
+    *pMqttConnection = pxConnection;
+
+    return IOT_MQTT_SUCCESS;
+}
+
+void IotMqtt_Disconnect( IotMqttConnection_t mqttConnection, uint32_t flags )
+{
+    ( void )mqttConnection;
+    ( void )flags;
+}
+
+static IotMqttError_t prvSerializePublish( const IotMqttPublishInfo_t * pxInfo, uint8_t ** ppucPacket, size_t * pxPacketSize )
+{
+    size_t xRemaining = 2 + pxInfo->topicNameLength + pxInfo->payloadLength;
+    size_t xLengthBytes = 1;
+    uint8_t * pucCursor;
+
+    for( size_t x = xRemaining; x > 127; x >>= 7 )
+    {
+        xLengthBytes++;
+    }
+    *pxPacketSize = 1 + xLengthBytes + xRemaining;
+    *ppucPacket = IotMqtt_MallocMessage( *pxPacketSize );
+    if( *ppucPacket == NULL )
+    {
+        return IOT_MQTT_NO_MEMORY;
+    }
+
+    pucCursor = *ppucPacket;
+    *pucCursor++ = 0x30;
+    do
+    {
+        uint8_t ucByte = ( uint8_t )( xRemaining & 0x7F );
+
+        xRemaining >>= 7;
+        *pucCursor++ = ( xRemaining > 0 ) ? ( ucByte | 0x80 ) : ucByte;
+    } while( xRemaining > 0 );
+    *pucCursor++ = ( uint8_t )( pxInfo->topicNameLength >> 8 );
+    *pucCursor++ = ( uint8_t )pxInfo->topicNameLength;
+    memcpy( pucCursor, pxInfo->pTopicName, pxInfo->topicNameLength );
+    memcpy( pucCursor + pxInfo->topicNameLength, pxInfo->pPayload, pxInfo->payloadLength );
+
+    return IOT_MQTT_SUCCESS;
+}
+
+IotMqttError_t IotMqtt_Publish( IotMqttConnection_t mqttConnection,
+                                const IotMqttPublishInfo_t * pPublishInfo,
+                                uint32_t flags,
+                                const void * pCallbackInfo,
+                                void * pPublishOperation )
+{
+    IotMqttError_t xStatus;
+    uint8_t * pucPacket = NULL;
+    uint8_t * pucCursor;
+    size_t xPacketSize = 0;
+    size_t xRemaining = 0;
+    uint32_t ulShift = 0;
+    uint16_t usTopicLength;
+    uint16_t usPacketIdentifier;
+    uint8_t * pucPacketIdentifierHigh;
+    uint32_t ulDelayMs = 0;
+    HostBrokerHandler_t xHandler;
+
+    ( void )flags;
+    ( void )pCallbackInfo;
+    ( void )pPublishOperation;
+
+    if( mqttConnection->pxSerializer != NULL && mqttConnection->pxSerializer->serialize.publish != NULL )
+    {
+        xStatus = mqttConnection->pxSerializer->serialize.publish( pPublishInfo, &pucPacket, &xPacketSize,
+                                                                    &usPacketIdentifier, &pucPacketIdentifierHigh );
+    }
+    else
+    {
+        xStatus = prvSerializePublish( pPublishInfo, &pucPacket, &xPacketSize );
+    }
+    if( xStatus != IOT_MQTT_SUCCESS )
+    {
+        return xStatus;
+    }
+
+    /* Parse the packet back, as the broker would. */
+    configASSERT( ( pucPacket[ 0 ] & 0xF0 ) == 0x30 );
+    pucCursor = pucPacket + 1;
+    do
+    {
+        xRemaining |= ( size_t )( *pucCursor & 0x7F ) << ulShift;
+        ulShift += 7;
+    } while( ( *pucCursor++ & 0x80 ) != 0 );
+    configASSERT( ( size_t )( pucCursor - pucPacket ) + xRemaining == xPacketSize );
+    usTopicLength = ( uint16_t )( ( pucCursor[ 0 ] << 8 ) | pucCursor[ 1 ] );
+    pucCursor += 2;
+
+    pthread_mutex_lock( &xLock );
+    ulPublishes++;
+    if( ulPublishDelayEvery != 0 && ulPublishes % ulPublishDelayEvery == 0 )
+    {
+        ulDelayMs = ulPublishDelayMs;
+    }
+    xHandler = xBroker;
+    pthread_mutex_unlock( &xLock );
+
+    if( ulDelayMs != 0 )
+    {
+        usleep( ulDelayMs * 1000U );
+    }
+    if( xHandler != NULL )
+    {
+        xHandler( ( const char * )pucCursor, usTopicLength, pucCursor + usTopicLength, xRemaining - 2 - usTopicLength );
+    }
+
+    IotMqtt_FreeMessage( pucPacket );
+    return IOT_MQTT_SUCCESS;
+}
+
+IotMqttError_t IotMqtt_TimedSubscribe( IotMqttConnection_t mqttConnection,
+                                       const IotMqttSubscription_t * pSubscriptionList,
+                                       size_t subscriptionCount,
+                                       uint32_t flags,
+                                       uint32_t timeoutMs )
+{
+    IotMqttError_t xStatus = IOT_MQTT_SUCCESS;
+
+    ( void )flags;
+    ( void )timeoutMs;
+    pthread_mutex_lock( &xLock );
+    for( size_t i = 0; i < subscriptionCount; i++ )
+    {
+        size_t j;
+
+        if( pSubscriptionList[ i ].topicFilterLength >= HOST_MQTT_TOPIC_MAX )
+        {
+            xStatus = IOT_MQTT_BAD_PARAMETER;
+            break;
+        }
+        /* Subscribing again to a filter replaces its callback. */
+        for( j = 0; j < mqttConnection->xSubscriptionCount; j++ )
+        {
+            if( mqttConnection->xSubscriptions[ j ].usFilterLength == pSubscriptionList[ i ].topicFilterLength &&
+                memcmp( mqttConnection->xSubscriptions[ j ].cFilter, pSubscriptionList[ i ].pTopicFilter,
+                        pSubscriptionList[ i ].topicFilterLength ) == 0 )
+            {
+                break;
+            }
+        }
+        if( j == HOST_MQTT_SUBSCRIPTIONS )
+        {
+            xStatus = IOT_MQTT_NO_MEMORY;
+            break;
+        }
+        memcpy( mqttConnection->xSubscriptions[ j ].cFilter, pSubscriptionList[ i ].pTopicFilter, pSubscriptionList[ i ].topicFilterLength );
+        mqttConnection->xSubscriptions[ j ].usFilterLength = pSubscriptionList[ i ].topicFilterLength;
+        mqttConnection->xSubscriptions[ j ].xCallback = pSubscriptionList[ i ].callback;
+        if( j == mqttConnection->xSubscriptionCount )
+        {
+            mqttConnection->xSubscriptionCount++;
+        }
+    }
+    pthread_mutex_unlock( &xLock );
+
+    return xStatus;
+}
+
+const char * IotMqtt_strerror( IotMqttError_t status )
+{
+    return ( status == IOT_MQTT_SUCCESS ) ? "SUCCESS" : "FAILURE";
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _HOST_OPUS_H_
+#define _HOST_OPUS_H_
+
+#include <stdint.h>
+
+/* The Opus API used by the AIA client, implemented by a stand-in codec in opus_host.c. It keeps the sizes and the
+ * calling conventions of Opus, but not its signal processing, see host.h.
+ */
+typedef int16_t opus_int16;
+typedef int32_t opus_int32;
+typedef struct OpusDecoder OpusDecoder;
+typedef struct OpusEncoder OpusEncoder;
+
+#define OPUS_OK                             0
+#define OPUS_BAD_ARG                        -1
+#define OPUS_BUFFER_TOO_SMALL               -2
+#define OPUS_INTERNAL_ERROR                 -3
+#define OPUS_INVALID_PACKET                 -4
+
+#define OPUS_APPLICATION_VOIP               2048
+#define OPUS_SIGNAL_VOICE                   3001
+#define OPUS_BANDWIDTH_WIDEBAND             1103
+
+#define OPUS_SET_BITRATE_REQUEST            4002
+#define OPUS_SET_VBR_REQUEST                4006
+#define OPUS_SET_BANDWIDTH_REQUEST          4008
+#define OPUS_SET_COMPLEXITY_REQUEST         4010
+#define OPUS_SET_SIGNAL_REQUEST             4024
+#define OPUS_RESET_STATE                    4028
+
+#define OPUS_SET_BITRATE( x )               OPUS_SET_BITRATE_REQUEST, ( opus_int32 )( x )
+#define OPUS_SET_VBR( x )                   OPUS_SET_VBR_REQUEST, ( opus_int32 )( x )
+#define OPUS_SET_BANDWIDTH( x )             OPUS_SET_BANDWIDTH_REQUEST, ( opus_int32 )( x )
+#define OPUS_SET_COMPLEXITY( x )            OPUS_SET_COMPLEXITY_REQUEST, ( opus_int32 )( x )
+#define OPUS_SET_SIGNAL( x )                OPUS_SET_SIGNAL_REQUEST, ( opus_int32 )( x )
+
+int opus_decoder_get_size( int channels );
+int opus_decoder_init( OpusDecoder * st, opus_int32 Fs, int channels );
+int opus_decode( OpusDecoder * st, const unsigned char * data, opus_int32 len, opus_int16 * pcm, int frame_size, int decode_fec );
+int opus_decoder_ctl( OpusDecoder * st, int request, ... );
+
+int opus_encoder_get_size( int channels );
+int opus_encoder_init( OpusEncoder * st, opus_int32 Fs, int channels, int application );
+opus_int32 opus_encode( OpusEncoder * st, const opus_int16 * pcm, int frame_size, unsigned char * data, opus_int32 max_data_bytes );
+int opus_encoder_ctl( OpusEncoder * st, int request, ... );
+
+#endif /* _HOST_OPUS_H_ */
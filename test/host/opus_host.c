@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* A stand-in for Opus, so that the client runs on the host without the codec. A packet carries the first sample of
+ * its frame, and decodes to a frame holding that value throughout, so a test can tell which frame is played.
+ * Concealment repeats the last frame at half its level, and a FEC decode yields the frame of the packet given.
+ * Both the encoder and the decoder take their pseudo-stack through opus_alloc_scratch(), as Opus built with
+ * NONTHREADSAFE_PSEUDOSTACK does, and touch a fixed part of it so that the high-water mark of the arena moves.
+ */
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "opus.h"
+#include "host.h"
+#include "custom_support.h"
+
+#define HOST_OPUS_DECODER_SCRATCH           ( 9000U )
+#define HOST_OPUS_ENCODER_SCRATCH           ( 20000U )
+/* Every packet the stand-in encodes or decodes holds one frame of this duration. */
+#define HOST_OPUS_PACKET_MS                 ( 20 )
+
+struct OpusDecoder {
+    opus_int32 lFs;
+    opus_int16 sLast;
+};
+
+struct OpusEncoder {
+    opus_int32 lFs;
+    opus_int32 lBitrate;
+};
+
+static HostOpusStats_t xStats;
+static uint32_t ulFailEvery;
+
+void vHostOpusFailEncodeEvery( uint32_t ulFrames )
+{
+    ulFailEvery = ulFrames;
+}
+
+void vHostOpusStats( HostOpusStats_t * pxStats )
+{
+    *pxStats = xStats;
+}
+
+static void prvTouchScratch( size_t xBytes )
+{
+#if defined( GLOBAL_STACK_SIZE )
+    if( xBytes > GLOBAL_STACK_SIZE )
+    {
+        xBytes = GLOBAL_STACK_SIZE;
+    }
+#endif
+    memset( opus_alloc_scratch( xBytes ), 0, xBytes );
+}
+
+static void prvFill( opus_int16 * pcm, int frame_size, opus_int16 sValue )
+{
+    for( int i = 0; i < frame_size; i++ )
+    {
+        pcm[ i ] = sValue;
+    }
+}
+
+int opus_decoder_get_size( int channels )
+{
+    return ( channels == 1 ) ? ( int )sizeof( struct OpusDecoder ) : 0;
+}
+
+int opus_decoder_init( OpusDecoder * st, opus_int32 Fs, int channels )
+{
+    if( channels != 1 )
+    {
+        return OPUS_BAD_ARG;
+    }
+    memset( st, 0, sizeof( *st ) );
+    st->lFs = Fs;
+    return OPUS_OK;
+}
+
+int opus_decode( OpusDecoder * st, const unsigned char * data, opus_int32 len, opus_int16 * pcm, int frame_size, int decode_fec )
+{
+    prvTouchScratch( HOST_OPUS_DECODER_SCRATCH );
+
+    if( data == NULL || len == 0 )
+    {
+        xStats.ulConcealed++;
+        st->sLast = ( opus_int16 )( st->sLast / 2 );
+        prvFill( pcm, frame_size, st->sLast );
+        return frame_size;
+    }
+    if( len < 2 )
+    {
+        return OPUS_INVALID_PACKET;
+    }
+
+    if( decode_fec != 0 )
+    {
+        xStats.ulFec++;
+    }
+    else
+    {
+        xStats.ulDecoded++;
+    }
+    /* As Opus, a packet decodes to its own duration, frame_size is only the room in pcm. */
+    if( frame_size < st->lFs * HOST_OPUS_PACKET_MS / 1000 )
+    {
+        return OPUS_BUFFER_TOO_SMALL;
+    }
+    frame_size = st->lFs * HOST_OPUS_PACKET_MS / 1000;
+    st->sLast = ( opus_int16 )( ( uint16_t )data[ 0 ] | ( ( uint16_t )data[ 1 ] << 8 ) );
+    prvFill( pcm, frame_size, st->sLast );
+    return frame_size;
+}
+
+int opus_decoder_ctl( OpusDecoder * st, int request, ... )
+{
+    if( request == OPUS_RESET_STATE )
+    {
+        st->sLast = 0;
+        xStats.ulDecoderResets++;
+        return OPUS_OK;
+    }
+    return OPUS_BAD_ARG;
+}
+
+int opus_encoder_get_size( int channels )
+{
+    return ( channels == 1 ) ? ( int )sizeof( struct OpusEncoder ) : 0;
+}
+
+int opus_encoder_init( OpusEncoder * st, opus_int32 Fs, int channels, int application )
+{
+    ( void )application;
+    if( channels != 1 )
+    {
+        return OPUS_BAD_ARG;
+    }
+    memset( st, 0, sizeof( *st ) );
+    st->lFs = Fs;
+    st->lBitrate = 32000;
+    return OPUS_OK;
+}
+
+opus_int32 opus_encode( OpusEncoder * st, const opus_int16 * pcm, int frame_size, unsigned char * data, opus_int32 max_data_bytes )
+{
+    /* A constant bitrate, as the client sets it. */
+    opus_int32 lBytes = st->lBitrate / 8 * frame_size / st->lFs;
+
+    prvTouchScratch( HOST_OPUS_ENCODER_SCRATCH );
+
+    xStats.ulEncoded++;
+    if( ulFailEvery != 0 && xStats.ulEncoded % ulFailEvery == 0 )
+    {
+        xStats.ulEncodeFailures++;
+        return OPUS_INTERNAL_ERROR;
+    }
+    if( lBytes > max_data_bytes || lBytes < 2 )
+    {
+        return OPUS_BUFFER_TOO_SMALL;
+    }
+
+    memset( data, 0, lBytes );
+    data[ 0 ] = ( unsigned char )( ( uint16_t )pcm[ 0 ] & 0xFFU );
+    data[ 1 ] = ( unsigned char )( ( uint16_t )pcm[ 0 ] >> 8 );
+    return lBytes;
+}
+
+int opus_encoder_ctl( OpusEncoder * st, int request, ... )
+{
+    va_list xArgs;
+    opus_int32 lValue;
+
+    va_start( xArgs, request );
+    lValue = va_arg( xArgs, opus_int32 );
+    va_end( xArgs );
+
+    switch( request )
+    {
+        case OPUS_SET_BITRATE_REQUEST:
+            st->lBitrate = lValue;
+            return OPUS_OK;
+        case OPUS_SET_VBR_REQUEST:
+        case OPUS_SET_BANDWIDTH_REQUEST:
+        case OPUS_SET_COMPLEXITY_REQUEST:
+        case OPUS_SET_SIGNAL_REQUEST:
+            return OPUS_OK;
+        default:
+            return OPUS_BAD_ARG;
+    }
+}
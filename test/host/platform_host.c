@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The platform of the board on the host. The microphone and speaker DMA are threads that run their interrupt
+ * handlers every transfer, as demo/aia_platform.c does: the record one moves to the next frame of the client, and
+ * the play one reads 10ms of audio from the speaker buffer. The touch button is scanned as on the board too: a task
+ * starts a scan every HOST_CAPSENSE_SCAN_INTERVAL_MS, and a thread standing in for the CapSense block completes it
+ * from its interrupt. The cycle counter runs at configCPU_CLOCK_HZ.
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aia_client_priv.h"
+#include "host.h"
+
+/* As DMA_PLAY_BUFFER_SAMPLES of the board. */
+#define HOST_PLAY_BUFFER_SAMPLES            ( 160 )
+
+/* As CAPSENSE_SCAN_INTERVAL_MS of the board and the ON_DEBOUNCE of its button, and about the time of a scan. */
+#define HOST_CAPSENSE_SCAN_INTERVAL_MS      ( 10 )
+#define HOST_CAPSENSE_ON_DEBOUNCE           ( 3 )
+#define HOST_CAPSENSE_SCAN_US               ( 500 )
+
+static struct {
+    pthread_t xRecord;
+    pthread_t xPlay;
+    pthread_t xCapsense;
+    TaskHandle_t xScanTask;
+    uint8_t ucRecordBuffer[ AIA_MICROPHONE_CAPTURE_FRAME_SIZE ] __attribute__((aligned(4)));
+    int16_t sPlayBuffer[ HOST_PLAY_BUFFER_SAMPLES ];
+    void * pvRecordDestination;
+    volatile BaseType_t xMicrophoneOpen;
+    volatile BaseType_t xSpeakerOpen;
+    volatile BaseType_t xSpeakerRunning;
+    volatile BaseType_t xTouchEnabled;
+    /* The finger on the button, what the last scan saw of it, and whether its touch-down was reported. */
+    volatile BaseType_t xTouched;
+    BaseType_t xScanTouched;
+    BaseType_t xScanRequested;
+    BaseType_t xPressed;
+    HostMicrophoneSource_t xSource;
+    HostSpeakerSink_t xSink;
+    HostPlatformStats_t xStats;
+    uint32_t ulSpeakerStartupMs;
+    uint32_t ulMicrophoneStartupMs;
+} xPlatform;
+
+static pthread_mutex_t xLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xStarted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t xScanStart = PTHREAD_COND_INITIALIZER;
+
+static void prvSleepUntil( struct timespec * pxNext, long lPeriodNs )
+{
+    pxNext->tv_nsec += lPeriodNs;
+    while( pxNext->tv_nsec >= 1000000000L )
+    {
+        pxNext->tv_nsec -= 1000000000L;
+        pxNext->tv_sec++;
+    }
+    clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, pxNext, NULL );
+}
+
+static void prvWaitStarted( volatile BaseType_t * pxRunning )
+{
+    pthread_mutex_lock( &xLock );
+    while( *pxRunning == pdFALSE )
+    {
+        pthread_cond_wait( &xStarted, &xLock );
+    }
+    pthread_mutex_unlock( &xLock );
+}
+
+static void * prvRecordDma( void * pvParameters )
+{
+    struct timespec xNext;
+
+    ( void )pvParameters;
+    for( ; ; )
+    {
+        prvWaitStarted( &xPlatform.xMicrophoneOpen );
+        clock_gettime( CLOCK_MONOTONIC, &xNext );
+        prvSleepUntil( &xNext, ( long )xPlatform.ulMicrophoneStartupMs * 1000000L );
+
+        while( xPlatform.xMicrophoneOpen == pdTRUE )
+        {
+            prvSleepUntil( &xNext, aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS * 1000000L );
+
+            /* The transfer fills the destination set at the previous interrupt. */
+            vHostInterruptEnter();
+            if( xPlatform.xSource != NULL )
+            {
+                xPlatform.xSource( xPlatform.pvRecordDestination, AIA_MICROPHONE_CAPTURE_FRAME_SIZE );
+            }
+            else
+            {
+                memset( xPlatform.pvRecordDestination, 0, AIA_MICROPHONE_CAPTURE_FRAME_SIZE );
+            }
+            xPlatform.xStats.ulMicrophoneFrames++;
+            if( xPlatform.pvRecordDestination == xPlatform.ucRecordBuffer )
+            {
+                xPlatform.xStats.ulMicrophoneDiscarded++;
+            }
+            if( xPlatform.xMicrophoneOpen == pdTRUE )
+            {
+                BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+                void * pvFrame = pvClientMicrophoneFrameCapturedFromISR( &xHigherPriorityTaskWoken );
+
+                xPlatform.pvRecordDestination = ( pvFrame != NULL ) ? pvFrame : xPlatform.ucRecordBuffer;
+            }
+            vHostInterruptExit();
+        }
+    }
+
+    return NULL;
+}
+
+static void * prvPlayDma( void * pvParameters )
+{
+    struct timespec xNext;
+    size_t xDataSize;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    ( void )pvParameters;
+    for( ; ; )
+    {
+        prvWaitStarted( &xPlatform.xSpeakerRunning );
+        clock_gettime( CLOCK_MONOTONIC, &xNext );
+        prvSleepUntil( &xNext, ( long )xPlatform.ulSpeakerStartupMs * 1000000L );
+
+        while( xPlatform.xSpeakerRunning == pdTRUE )
+        {
+            prvSleepUntil( &xNext, HOST_PLAY_BUFFER_SAMPLES * 1000000000L / aiaconfigCLIENT_SPEAKER_SAMPLE_RATE );
+
+            vHostInterruptEnter();
+            memset( xPlatform.sPlayBuffer, 0, sizeof( xPlatform.sPlayBuffer ) );
+            xDataSize = xClientReadSpeakerBufferFromISR( xPlatform.sPlayBuffer, sizeof( xPlatform.sPlayBuffer ), &xHigherPriorityTaskWoken );
+            xPlatform.xStats.ulSpeakerTransfers++;
+            if( xPlatform.xSpeakerOpen == pdTRUE && xDataSize < sizeof( xPlatform.sPlayBuffer ) )
+            {
+                xPlatform.xStats.ulSpeakerUnderruns++;
+            }
+            if( xPlatform.xSink != NULL )
+            {
+                xPlatform.xSink( xPlatform.sPlayBuffer, HOST_PLAY_BUFFER_SAMPLES, xDataSize );
+            }
+            /* Stop once closed and drained. */
+            if( xPlatform.xSpeakerOpen == pdFALSE && xDataSize == 0 )
+            {
+                xPlatform.xSpeakerRunning = pdFALSE;
+            }
+            vHostInterruptExit();
+        }
+    }
+
+    return NULL;
+}
+
+void vHostPlatformSetMicrophoneSource( HostMicrophoneSource_t xSource )
+{
+    vHostInterruptEnter();
+    xPlatform.xSource = xSource;
+    vHostInterruptExit();
+}
+
+void vHostPlatformSetSpeakerSink( HostSpeakerSink_t xSink )
+{
+    vHostInterruptEnter();
+    xPlatform.xSink = xSink;
+    vHostInterruptExit();
+}
+
+void vHostPlatformSetStartupDelay( uint32_t ulSpeakerMs, uint32_t ulMicrophoneMs )
+{
+    xPlatform.ulSpeakerStartupMs = ulSpeakerMs;
+    xPlatform.ulMicrophoneStartupMs = ulMicrophoneMs;
+}
+
+void vHostPlatformStats( HostPlatformStats_t * pxStats )
+{
+    vHostInterruptEnter();
+    *pxStats = xPlatform.xStats;
+    pxStats->xMicrophoneOpen = xPlatform.xMicrophoneOpen;
+    pxStats->xSpeakerOpen = xPlatform.xSpeakerOpen;
+    pxStats->xTouchEnabled = xPlatform.xTouchEnabled;
+    vHostInterruptExit();
+}
+
+void vHostTouch( BaseType_t xPressed )
+{
+    xPlatform.xTouched = xPressed;
+}
+
+/* The CapSense block: a scan takes HOST_CAPSENSE_SCAN_US, and its interrupt latches what it saw. */
+static void * prvCapsense( void * pvParameters )
+{
+    ( void )pvParameters;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &xLock );
+        while( xPlatform.xScanRequested == pdFALSE )
+        {
+            pthread_cond_wait( &xScanStart, &xLock );
+        }
+        xPlatform.xScanRequested = pdFALSE;
+        pthread_mutex_unlock( &xLock );
+
+        usleep( HOST_CAPSENSE_SCAN_US );
+
+        vHostInterruptEnter();
+        xPlatform.xScanTouched = xPlatform.xTouched;
+        vTaskNotifyGiveFromISR( xPlatform.xScanTask, NULL );
+        vHostInterruptExit();
+    }
+
+    return NULL;
+}
+
+/* As vCapsenseScanTask() and prvProcessTouch() of the board: a touch-down is reported once debounced, with the cycle
+ * count of the first scan that saw it, and every press reported is released, even if the button is disabled since.
+ */
+static void prvCapsenseScanTask( void * pvParameters )
+{
+    uint32_t ulScansTouched = 0;
+    uint32_t ulTouchDownCycles = 0;
+    BaseType_t xTouched;
+
+    ( void )pvParameters;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &xLock );
+        xPlatform.xScanRequested = pdTRUE;
+        pthread_cond_signal( &xScanStart );
+        pthread_mutex_unlock( &xLock );
+        ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 10 ) );
+
+        vHostInterruptEnter();
+        xTouched = xPlatform.xScanTouched;
+        vHostInterruptExit();
+
+        if( xTouched == pdTRUE )
+        {
+            if( ulScansTouched++ == 0 )
+            {
+                ulTouchDownCycles = ulPlatformGetCycleCount();
+            }
+            if( ulScansTouched == HOST_CAPSENSE_ON_DEBOUNCE && xPlatform.xTouchEnabled == pdTRUE )
+            {
+                xPlatform.xPressed = pdTRUE;
+                vClientButtonPressed( ulTouchDownCycles );
+            }
+        }
+        else
+        {
+            ulScansTouched = 0;
+            if( xPlatform.xPressed == pdTRUE )
+            {
+                xPlatform.xPressed = pdFALSE;
+                vClientButtonReleased();
+            }
+        }
+
+        vTaskDelay( pdMS_TO_TICKS( HOST_CAPSENSE_SCAN_INTERVAL_MS ) );
+    }
+}
+
+BaseType_t xPlatformLEDInit( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xPlatformMicrophoneInit( void )
+{
+    xPlatform.pvRecordDestination = xPlatform.ucRecordBuffer;
+    if( xPlatform.xRecord == 0 && pthread_create( &xPlatform.xRecord, NULL, prvRecordDma, NULL ) != 0 )
+    {
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xPlatformSpeakerInit( void )
+{
+    if( xPlatform.xPlay == 0 && pthread_create( &xPlatform.xPlay, NULL, prvPlayDma, NULL ) != 0 )
+    {
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xPlatformTouchButtonInit( void )
+{
+    if( xPlatform.xCapsense == 0 && pthread_create( &xPlatform.xCapsense, NULL, prvCapsense, NULL ) != 0 )
+    {
+        return pdFAIL;
+    }
+    if( xPlatform.xScanTask == NULL )
+    {
+        return xTaskCreate( prvCapsenseScanTask, "Capsense Scan", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2,
+                            &xPlatform.xScanTask );
+    }
+    return pdPASS;
+}
+
+void vPlatformLEDOn( void )
+{
+}
+
+void vPlatformLEDOff( void )
+{
+}
+
+void vPlatformLEDBlink( uint32_t interval_ms )
+{
+    ( void )interval_ms;
+}
+
+void vPlatformMicrophoneOpen( void )
+{
+    void * pvFrame = pvClientMicrophoneFrame();
+
+    vHostInterruptEnter();
+    xPlatform.pvRecordDestination = ( pvFrame != NULL ) ? pvFrame : xPlatform.ucRecordBuffer;
+    vHostInterruptExit();
+
+    pthread_mutex_lock( &xLock );
+    xPlatform.xMicrophoneOpen = pdTRUE;
+    pthread_cond_broadcast( &xStarted );
+    pthread_mutex_unlock( &xLock );
+}
+
+void vPlatformMicrophoneClose( void )
+{
+    xPlatform.xMicrophoneOpen = pdFALSE;
+}
+
+void vPlatformSpeakerOpen( void )
+{
+    pthread_mutex_lock( &xLock );
+    xPlatform.xSpeakerOpen = pdTRUE;
+    xPlatform.xSpeakerRunning = pdTRUE;
+    pthread_cond_broadcast( &xStarted );
+    pthread_mutex_unlock( &xLock );
+}
+
+void vPlatformSpeakerClose( void )
+{
+    xPlatform.xSpeakerOpen = pdFALSE;
+}
+
+void vPlatformTouchButtonEnable( void )
+{
+    xPlatform.xTouchEnabled = pdTRUE;
+}
+
+void vPlatformTouchButtonDisable( void )
+{
+    xPlatform.xTouchEnabled = pdFALSE;
+}
+
+uint32_t ulPlatformGetCycleCount( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint32_t )( ( uint64_t )xNow.tv_sec * configCPU_CLOCK_HZ +
+                         ( uint64_t )xNow.tv_nsec * ( configCPU_CLOCK_HZ / 1000000UL ) / 1000UL );
+}
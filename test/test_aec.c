@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_aec.c on its own, with host test vectors. The speaker audio is given to the reference as the platform would,
+ * and every microphone frame is the echo of it through a room impulse response of about 10ms, starting 2ms into the
+ * filter, plus quiet near-end noise. For each vector the echo return loss enhancement (ERLE) is measured over its
+ * end, after the filter has converged, and checked against a floor. The vectors are white noise, speech-like noise
+ * that comes and goes, white noise with 1s of loud near-end talk in the middle, during which the filter must not
+ * diverge, and a frame whose reference is gone, which must be left as it is. The cycles per frame are printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_aec.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAME_SAMPLES                ( AIA_MICROPHONE_RAW_FRAME_SAMPLES )
+#define aiatestFRAMES_PER_SECOND            ( 1000U / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+#define aiatestMAX_SECONDS                  ( 8U )
+#define aiatestMAX_SAMPLES                  ( aiatestMAX_SECONDS * aiatestFRAMES_PER_SECOND * aiatestFRAME_SAMPLES )
+/* The echo path, in taps of the filter. */
+#define aiatestECHO_FIRST_TAP               ( 32U )
+#define aiatestECHO_TAPS                    ( 160U )
+
+typedef enum {
+    eWhite,
+    eSpeechLike,
+} FarEnd_t;
+
+/* Everything played so far, as the reference ring sees it. */
+static int16_t sPlayed[ aiatestMAX_SAMPLES ];
+static uint32_t ulPlayed;
+static float fEcho[ aiaconfigCLIENT_AEC_TAPS ];
+static uint32_t ulSeed = 1;
+
+static float prvRandom( void )
+{
+    ulSeed = ulSeed * 1103515245U + 12345U;
+    return ( float )( ( ulSeed >> 8 ) & 0xffff ) / 32768.0f - 1.0f;
+}
+
+static int16_t prvClip( float fSample )
+{
+    return ( int16_t )( ( fSample > 32767.0f ) ? 32767.0f : ( fSample < -32768.0f ) ? -32768.0f : fSample );
+}
+
+/* A direct path and decaying reflections. */
+static void prvMakeEchoPath( void )
+{
+    memset( fEcho, 0, sizeof( fEcho ) );
+    fEcho[ aiatestECHO_FIRST_TAP ] = 0.25f;
+    for( uint32_t i = 1; i < aiatestECHO_TAPS; i++ )
+    {
+        fEcho[ aiatestECHO_FIRST_TAP + i ] = 0.04f * expf( -( float )i / 40.0f ) * prvRandom();
+    }
+}
+
+typedef struct {
+    const char * pcName;
+    FarEnd_t xFarEnd;
+    uint32_t ulSeconds;
+    /* Loud near-end talk, in frames. */
+    uint32_t ulTalkStart;
+    uint32_t ulTalkEnd;
+    /* ERLE is measured from this frame to the end. */
+    uint32_t ulMeasureFrom;
+    float fMinErleDb;
+} Vector_t;
+
+static float prvRunVector( const Vector_t * pxVector, AIAAecStatistics_t * pxStatistics )
+{
+    uint32_t ulFrames = pxVector->ulSeconds * aiatestFRAMES_PER_SECOND;
+    double dMicrophone = 0.0;
+    double dResidual = 0.0;
+    float fLowpass = 0.0f;
+
+    vAIAAecInit();
+    ulPlayed = 0;
+
+    for( uint32_t f = 0; f < ulFrames; f++ )
+    {
+        int16_t sFrame[ aiatestFRAME_SAMPLES ];
+        int16_t sMicrophone[ aiatestFRAME_SAMPLES ];
+        /* Speech-like audio comes and goes 4 times a second. */
+        float fEnvelope = ( pxVector->xFarEnd == eSpeechLike ) ? ( ( ( f / 6 ) % 2 == 0 ) ? 1.0f : 0.1f ) : 1.0f;
+        int32_t lPosition;
+
+        for( uint32_t n = 0; n < aiatestFRAME_SAMPLES; n++ )
+        {
+            float fSample = prvRandom();
+
+            if( pxVector->xFarEnd == eSpeechLike )
+            {
+                fLowpass = 0.9f * fLowpass + 0.3f * fSample;
+                fSample = fLowpass;
+            }
+            sFrame[ n ] = prvClip( 6000.0f * fEnvelope * fSample );
+        }
+        memcpy( &sPlayed[ ulPlayed ], sFrame, sizeof( sFrame ) );
+        ulPlayed += aiatestFRAME_SAMPLES;
+        vAIAAecPlayed( sFrame, sizeof( sFrame ), sizeof( sFrame ) );
+
+        vHostInterruptEnter();
+        vAIAAecFrameCapturedFromISR( f );
+        vHostInterruptExit();
+
+        /* Sample n lines up with the reference aiaconfigCLIENT_AEC_DELAY_SAMPLES before the end of the frame. */
+        lPosition = ( int32_t )ulPlayed - ( int32_t )aiaconfigCLIENT_AEC_DELAY_SAMPLES - ( int32_t )aiatestFRAME_SAMPLES;
+        for( uint32_t n = 0; n < aiatestFRAME_SAMPLES; n++ )
+        {
+            float fSample = 50.0f * prvRandom();
+
+            for( uint32_t k = aiatestECHO_FIRST_TAP; k < aiatestECHO_FIRST_TAP + aiatestECHO_TAPS; k++ )
+            {
+                if( lPosition + ( int32_t )n >= ( int32_t )k )
+                {
+                    fSample += fEcho[ k ] * sPlayed[ lPosition + n - k ];
+                }
+            }
+            if( f >= pxVector->ulTalkStart && f < pxVector->ulTalkEnd )
+            {
+                fSample += 8000.0f * sinf( 2.0f * ( float )M_PI * 300.0f * ( float )( f * aiatestFRAME_SAMPLES + n ) / 16000.0f );
+            }
+            sMicrophone[ n ] = prvClip( fSample );
+        }
+
+        if( f >= pxVector->ulMeasureFrom )
+        {
+            for( uint32_t n = 0; n < aiatestFRAME_SAMPLES; n++ )
+            {
+                dMicrophone += ( double )sMicrophone[ n ] * sMicrophone[ n ];
+            }
+        }
+        vAIAAecProcess( sMicrophone, f );
+        if( f >= pxVector->ulMeasureFrom )
+        {
+            for( uint32_t n = 0; n < aiatestFRAME_SAMPLES; n++ )
+            {
+                dResidual += ( double )sMicrophone[ n ] * sMicrophone[ n ];
+            }
+        }
+    }
+
+    vAIAAecGetStatistics( pxStatistics );
+    return ( float )( 10.0 * log10( dMicrophone / dResidual ) );
+}
+
+int main( void )
+{
+    static const Vector_t xVectors[] = {
+        { "white noise", eWhite, 4, UINT32_MAX, UINT32_MAX, 3 * aiatestFRAMES_PER_SECOND, 20.0f },
+        { "speech-like noise", eSpeechLike, 6, UINT32_MAX, UINT32_MAX, 4 * aiatestFRAMES_PER_SECOND, 15.0f },
+        { "white noise with near-end talk", eWhite, 7, 3 * aiatestFRAMES_PER_SECOND, 4 * aiatestFRAMES_PER_SECOND,
+          5 * aiatestFRAMES_PER_SECOND, 20.0f },
+    };
+    AIAAecStatistics_t xStatistics;
+    int16_t sFrame[ aiatestFRAME_SAMPLES ];
+
+    prvMakeEchoPath();
+    printf( "%u taps, adapted %u at a time\n", ( uint32_t )aiaconfigCLIENT_AEC_TAPS,
+            ( uint32_t )( aiaconfigCLIENT_AEC_TAPS / aiaconfigCLIENT_AEC_UPDATE_PARTS ) );
+    for( size_t i = 0; i < sizeof( xVectors ) / sizeof( xVectors[ 0 ] ); i++ )
+    {
+        float fErle = prvRunVector( &xVectors[ i ], &xStatistics );
+
+        printf( "%s: ERLE %.1f dB over the last %u ms, %d.%02d dB reported, %u cycles per frame on average, %u most\n",
+                xVectors[ i ].pcName, fErle,
+                ( xVectors[ i ].ulSeconds * aiatestFRAMES_PER_SECOND - xVectors[ i ].ulMeasureFrom ) *
+                aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS,
+                xStatistics.lErleQ8 / 256, ( abs( xStatistics.lErleQ8 ) % 256 ) * 100 / 256,
+                xStatistics.ulCyclesAverage, xStatistics.ulCyclesMax );
+        vTestCheck( fErle >= xVectors[ i ].fMinErleDb, "%s: ERLE of at least %.0f dB", xVectors[ i ].pcName,
+                    xVectors[ i ].fMinErleDb );
+    }
+
+    /* The frame captured after the last one of the vector has no reference position yet. */
+    memset( sFrame, 0x11, sizeof( sFrame ) );
+    vAIAAecResetStatistics();
+    vAIAAecProcess( sFrame, xStatistics.ulFrames + 1000 );
+    vAIAAecGetStatistics( &xStatistics );
+    vTestCheck( xStatistics.ulBypassedFrames == 1 && sFrame[ 0 ] == 0x1111 && sFrame[ aiatestFRAME_SAMPLES - 1 ] == 0x1111,
+                "a frame whose reference is gone is left as it is" );
+
+    return lTestResult();
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_beamformer.c on its own, built for 2, 3 and 4 microphones, the SIMD version for 2 and 4 with the intrinsics of
+ * host/arm_acle.h. Channels of full-scale noise, with runs at the ends of the range, must give on every sample the
+ * beam the plain C reference gives, which is checked sample by sample here and by the DEBUG check of the module, and
+ * stay within rounding of the mean of the delayed channels. A source in the steered direction must come out exactly,
+ * delayed by the largest delay. The cycles per frame of both versions are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_beamformer.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+
+#define aiatestCHANNELS                     ( aiaconfigCLIENT_MICROPHONE_ARRAY_CHANNELS )
+#define aiatestFRAME_SAMPLES                ( AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES )
+#define aiatestFRAMES_PER_SECOND            ( 1000U / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+#define aiatestFRAMES                       ( 10U * aiatestFRAMES_PER_SECOND )
+#define aiatestSAMPLES                      ( aiatestFRAMES * aiatestFRAME_SAMPLES )
+
+static const uint16_t usDelays[ aiatestCHANNELS ] = aiaconfigCLIENT_MICROPHONE_ARRAY_DELAYS;
+static int16_t sChannels[ aiatestCHANNELS ][ aiatestSAMPLES ];
+static uint32_t ulSeed = 1;
+
+static int16_t prvRandom( void )
+{
+    ulSeed = ulSeed * 1103515245U + 12345U;
+    return ( int16_t )( ulSeed >> 16 );
+}
+
+/* Sample n of channel c after its delay, silence before the start. */
+static int32_t prvDelayed( uint32_t c, uint32_t n )
+{
+    return ( n >= usDelays[ c ] ) ? sChannels[ c ][ n - usDelays[ c ] ] : 0;
+}
+
+/* The beam as the reference gives it: a third of the sum for three channels, pairs halved and rounded down
+ * otherwise.
+ */
+static int32_t prvExpected( uint32_t n )
+{
+#if ( aiatestCHANNELS == 3 )
+    return ( prvDelayed( 0, n ) + prvDelayed( 1, n ) + prvDelayed( 2, n ) ) / 3;
+#elif ( aiatestCHANNELS == 4 )
+    return ( ( ( prvDelayed( 0, n ) + prvDelayed( 1, n ) ) >> 1 ) + ( ( prvDelayed( 2, n ) + prvDelayed( 3, n ) ) >> 1 ) ) >> 1;
+#else
+    return ( prvDelayed( 0, n ) + prvDelayed( 1, n ) ) >> 1;
+#endif
+}
+
+/* Run every frame through the beamformer, and count the samples not as expected and not within rounding of the mean.
+ * The mean is in quarters of a step, the beam of two or four channels is rounded down, of three towards zero.
+ */
+static void prvRun( uint32_t * pulNotExpected, uint32_t * pulNotNearMean, AIABeamformerStatistics_t * pxStatistics )
+{
+    static int16_t sFrame[ aiatestFRAME_SAMPLES * aiatestCHANNELS ];
+    int16_t sBeam[ aiatestFRAME_SAMPLES ];
+
+    *pulNotExpected = 0;
+    *pulNotNearMean = 0;
+    vAIABeamformerInit();
+
+    for( uint32_t f = 0; f < aiatestFRAMES; f++ )
+    {
+        for( uint32_t i = 0; i < aiatestFRAME_SAMPLES; i++ )
+        {
+            for( uint32_t c = 0; c < aiatestCHANNELS; c++ )
+            {
+                sFrame[ i * aiatestCHANNELS + c ] = sChannels[ c ][ f * aiatestFRAME_SAMPLES + i ];
+            }
+        }
+        vAIABeamformerProcess( sFrame, sBeam );
+
+        for( uint32_t i = 0; i < aiatestFRAME_SAMPLES; i++ )
+        {
+            uint32_t n = f * aiatestFRAME_SAMPLES + i;
+            int32_t lSum = 0;
+            int32_t lError;
+
+            for( uint32_t c = 0; c < aiatestCHANNELS; c++ )
+            {
+                lSum += prvDelayed( c, n );
+            }
+            /* Beam minus mean, times 12 so that thirds and quarters are whole. */
+            lError = 12 * sBeam[ i ] - 12 * lSum / ( int32_t )aiatestCHANNELS;
+
+            if( sBeam[ i ] != prvExpected( n ) )
+            {
+                ( *pulNotExpected )++;
+            }
+#if ( aiatestCHANNELS == 3 )
+            if( lError <= -12 || lError >= 12 )
+#else
+            if( lError < -18 || lError > 0 )
+#endif
+            {
+                ( *pulNotNearMean )++;
+            }
+        }
+    }
+
+    vAIABeamformerGetStatistics( pxStatistics );
+}
+
+int main( void )
+{
+    AIABeamformerStatistics_t xStatistics;
+    uint32_t ulNotExpected;
+    uint32_t ulNotNearMean;
+    uint32_t ulMaxDelay = 0;
+
+    /* Noise over the whole range, with a frame at either end of it every half second. */
+    for( uint32_t c = 0; c < aiatestCHANNELS; c++ )
+    {
+        for( uint32_t n = 0; n < aiatestSAMPLES; n++ )
+        {
+            uint32_t f = n / aiatestFRAME_SAMPLES;
+
+            sChannels[ c ][ n ] = ( f % 25 == 1 ) ? INT16_MAX : ( f % 25 == 2 ) ? INT16_MIN : prvRandom();
+        }
+        ulMaxDelay = ( usDelays[ c ] > ulMaxDelay ) ? usDelays[ c ] : ulMaxDelay;
+    }
+    prvRun( &ulNotExpected, &ulNotNearMean, &xStatistics );
+    printf( "%u microphones, %s: %u cycles per frame on average, %u most, reference %u\n", ( uint32_t )aiatestCHANNELS,
+#if defined( __ARM_FEATURE_SIMD32 ) && ( aiatestCHANNELS != 3 )
+            "SIMD",
+#else
+            "plain C",
+#endif
+            xStatistics.ulCyclesAverage, xStatistics.ulCyclesMax, xStatistics.ulReferenceCyclesAverage );
+    vTestCheck( xStatistics.ulFrames == aiatestFRAMES, "%u frames formed", xStatistics.ulFrames );
+    vTestCheck( ulNotExpected == 0, "every sample as the reference gives it, %u not", ulNotExpected );
+    vTestCheck( ulNotNearMean == 0, "every sample within rounding of the mean of the channels, %u not", ulNotNearMean );
+#if defined( __ARM_FEATURE_SIMD32 ) && ( aiatestCHANNELS != 3 )
+    vTestCheck( xStatistics.ulReferenceCyclesAverage != 0 && xStatistics.ulReferenceMismatches == 0,
+                "the DEBUG check of the module ran and found no mismatch, %u", xStatistics.ulReferenceMismatches );
+#endif
+
+    /* A source the delays are steered to reaches channel c ulMaxDelay - delay samples late. */
+    for( uint32_t n = 0; n < aiatestSAMPLES; n++ )
+    {
+        sChannels[ 0 ][ n ] = prvRandom();
+    }
+    for( uint32_t c = aiatestCHANNELS; c-- > 0; )
+    {
+        for( uint32_t n = aiatestSAMPLES; n-- > 0; )
+        {
+            uint32_t ulLate = ulMaxDelay - usDelays[ c ];
+
+            sChannels[ c ][ n ] = ( n >= ulLate ) ? sChannels[ 0 ][ n - ulLate ] : 0;
+        }
+    }
+    prvRun( &ulNotExpected, &ulNotNearMean, &xStatistics );
+    vTestCheck( ulNotExpected == 0 && ulNotNearMean == 0, "a source in the steered direction comes out as it is" );
+
+    return lTestResult();
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_capture.c on its own, with the record DMA simulated by the test: every frame is written at the address the
+ * capture gives, carrying its number in its first bytes, and completed from "interrupt". Checks the chunking of the
+ * slots, that an overflow drops whole frames and reports them as the gap before the next slot, that a restart drops
+ * the slots of the previous stream, also while the DMA runs, and that xAIACaptureWriteFromISR() puts a byte stream
+ * cut at any length back together. Last, a POSIX thread copies 10ms of audio at a time in real time, as a platform whose DMA cannot write
+ * to the slots would, and the time spent in the interrupt and the bytes copied per second are printed.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "aia_capture.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestCOPY_CHUNK                   ( AIA_MICROPHONE_RAW_FRAME_SIZE / 2 )
+#define aiatestCOPY_MS                      ( 1000U )
+
+static uint8_t ucScratch[ AIA_MICROPHONE_RAW_FRAME_SIZE ];
+static void * pvDestination;
+static uint32_t ulNextFrame;
+
+/* Write ulFrames frames where the DMA would, each completed from interrupt. */
+static void prvCaptureFrames( uint32_t ulFrames )
+{
+    for( uint32_t i = 0; i < ulFrames; i++ )
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+        vHostInterruptEnter();
+        memcpy( ( pvDestination != NULL ) ? pvDestination : ucScratch, &ulNextFrame, sizeof( ulNextFrame ) );
+        ulNextFrame++;
+        pvDestination = pvAIACaptureFrameDoneFromISR( &xHigherPriorityTaskWoken );
+        vHostInterruptExit();
+    }
+}
+
+/* Receive a slot and release it. *pxConsecutive tells whether its frames are the consecutive ones its first frame
+ * says. Returns pdFAIL if no slot was filled.
+ */
+static BaseType_t prvReceive( uint32_t * pulFrames, uint32_t * pulGapFrames, uint32_t * pulFirstFrame, BaseType_t * pxConsecutive )
+{
+    void * pvSlot;
+    const uint8_t * pucAudio;
+
+    if( xAIACaptureReceive( &pvSlot, pulFrames, pulGapFrames, 0 ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    *pulFirstFrame = ulAIACaptureFirstFrame( pvSlot );
+    pucAudio = ( const uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ + offsetof( AIABinaryAudioStream_t, ucAudio );
+    for( uint32_t i = 0; i < *pulFrames; i++ )
+    {
+        uint32_t ulFrame;
+
+        memcpy( &ulFrame, pucAudio + i * AIA_MICROPHONE_RAW_FRAME_SIZE, sizeof( ulFrame ) );
+        if( ulFrame != *pulFirstFrame + i )
+        {
+            *pxConsecutive = pdFALSE;
+        }
+    }
+    vAIACaptureRelease( pvSlot );
+
+    return pdPASS;
+}
+
+static void prvDrain( void )
+{
+    void * pvSlot;
+    uint32_t ulFrames, ulGapFrames;
+
+    while( xAIACaptureReceive( &pvSlot, &ulFrames, &ulGapFrames, 0 ) == pdPASS )
+    {
+        vAIACaptureRelease( pvSlot );
+    }
+}
+
+static void prvTestChunking( void )
+{
+    uint32_t ulExpected[ 16 ];
+    uint32_t ulCount = 0;
+    uint32_t ulStream = 0;
+    uint32_t ulFrames, ulGapFrames, ulFirstFrame;
+    uint32_t ulWrong = 0;
+    uint32_t ulReceived = 0;
+
+    /* Five slots of a frame, then doubling up to a full slot. */
+    for( uint32_t ulTarget = 1; ulCount < sizeof( ulExpected ) / sizeof( ulExpected[ 0 ] ); ulCount++ )
+    {
+        if( ulStream >= 5 )
+        {
+            ulTarget = ( ulTarget * 2 > AIA_MICROPHONE_MAX_FRAMES ) ? AIA_MICROPHONE_MAX_FRAMES : ulTarget * 2;
+        }
+        ulExpected[ ulCount ] = ulTarget;
+        ulStream += ulTarget;
+    }
+
+    vAIACaptureSetChunking( 1, 5 );
+    vAIACaptureRestart();
+    pvDestination = pvAIACaptureFrame();
+    for( uint32_t i = 0; i < ulStream; i++ )
+    {
+        prvCaptureFrames( 1 );
+        while( ulReceived < ulCount )
+        {
+            BaseType_t xConsecutive = pdTRUE;
+
+            if( prvReceive( &ulFrames, &ulGapFrames, &ulFirstFrame, &xConsecutive ) != pdPASS )
+            {
+                break;
+            }
+            if( xConsecutive != pdTRUE || ulFrames != ulExpected[ ulReceived ] || ulGapFrames != 0 )
+            {
+                ulWrong++;
+            }
+            ulReceived++;
+        }
+    }
+    vTestCheck( ulReceived == ulCount && ulWrong == 0, "slots of 1, 1, 1, 1, 1, 2, 4 and then %u frames, in order",
+                ( uint32_t )AIA_MICROPHONE_MAX_FRAMES );
+}
+
+static void prvTestOverflow( void )
+{
+    const uint32_t ulCapacity = aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS * AIA_MICROPHONE_MAX_FRAMES;
+    AIACaptureStatistics_t xBefore, xAfter;
+    void * pvHeld;
+    uint32_t ulFrames, ulGapFrames, ulFirstFrame;
+    uint32_t ulSlots = 0;
+    BaseType_t xConsecutive = pdTRUE;
+
+    /* Full slots, as while congested, and nothing received while they fill up. */
+    vAIACaptureGetStatistics( &xBefore );
+    vAIACaptureSetCongested( pdTRUE );
+    vAIACaptureRestart();
+    pvDestination = pvAIACaptureFrame();
+    prvCaptureFrames( ulCapacity + 3 );
+    vAIACaptureGetStatistics( &xAfter );
+    vTestCheck( pvDestination == NULL && xAfter.ulDroppedFrames - xBefore.ulDroppedFrames == 3 &&
+                xAfter.ulOverflows - xBefore.ulOverflows == 1 && xAfter.ulMaxSlotsInUse == aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS,
+                "with every slot taken, %u frames fit and the next ones are dropped as one overflow", ulCapacity );
+
+    /* Free one slot. The frame written to the scratch meanwhile is lost too, and the next slot reports the gap. */
+    vTestCheck( xAIACaptureReceive( &pvHeld, &ulFrames, &ulGapFrames, 0 ) == pdPASS && ulGapFrames == 0,
+                "the first slot has no gap" );
+    vAIACaptureRelease( pvHeld );
+    prvCaptureFrames( 1 + AIA_MICROPHONE_MAX_FRAMES );
+    while( prvReceive( &ulFrames, &ulGapFrames, &ulFirstFrame, &xConsecutive ) == pdPASS )
+    {
+        ulSlots++;
+    }
+    vTestCheck( xConsecutive == pdTRUE && ulSlots == aiaconfigAIA_MICROPHONE_CAPTURE_SLOTS && ulGapFrames == 4 && ulFirstFrame == ulNextFrame - AIA_MICROPHONE_MAX_FRAMES,
+                "the slot after the overflow starts %u frames later, and says so", ulGapFrames );
+    vAIACaptureSetCongested( pdFALSE );
+    prvDrain();
+}
+
+static void prvTestRestart( void )
+{
+    uint32_t ulFrames, ulGapFrames, ulFirstFrame;
+    uint32_t ulRestartFrame;
+    BaseType_t xConsecutive = pdTRUE;
+
+    vAIACaptureSetChunking( 2, 0 );
+    vAIACaptureRestart();
+    pvDestination = pvAIACaptureFrame();
+    prvCaptureFrames( 5 );
+    vAIACaptureRestart();
+    pvDestination = pvAIACaptureFrame();
+    ulRestartFrame = ulNextFrame;
+    prvCaptureFrames( 2 );
+    vTestCheck( prvReceive( &ulFrames, &ulGapFrames, &ulFirstFrame, &xConsecutive ) == pdPASS && xConsecutive == pdTRUE &&
+                ulFirstFrame == ulRestartFrame &&
+                ulFrames == 2 && ulGapFrames == 0,
+                "a restart drops the slots of the stream before it" );
+    prvDrain();
+
+    /* A warm or listening microphone is restarted with the DMA running, and it is not pointed again. */
+    prvCaptureFrames( 3 );
+    vAIACaptureRestart();
+    ulRestartFrame = ulNextFrame + 1;
+    prvCaptureFrames( 3 );
+    vTestCheck( prvReceive( &ulFrames, &ulGapFrames, &ulFirstFrame, &xConsecutive ) == pdPASS && xConsecutive == pdTRUE &&
+                ulFirstFrame == ulRestartFrame && ulFrames == 2 && ulGapFrames == 0,
+                "a restart with the DMA running starts the stream at the next frame" );
+    prvDrain();
+}
+
+static void prvTestWrite( void )
+{
+    /* A slot of 3 frames and one of 6. */
+    static uint8_t ucStream[ AIA_MICROPHONE_RAW_FRAME_SIZE * 9 ];
+    AIACaptureStatistics_t xBefore, xAfter;
+    void * pvSlot;
+    uint32_t ulFrames, ulGapFrames;
+    size_t xOffset = 0;
+    size_t xReceived = 0;
+    BaseType_t xSame = pdTRUE;
+
+    for( size_t i = 0; i < sizeof( ucStream ); i++ )
+    {
+        ucStream[ i ] = ( uint8_t )( i * 13U + 5U );
+    }
+
+    vAIACaptureGetStatistics( &xBefore );
+    vAIACaptureSetChunking( 3, 0 );
+    vAIACaptureRestart();
+    /* Lengths that do not divide a frame, so frames end in the middle of a write. */
+    for( size_t xLength = 1; xOffset < sizeof( ucStream ); xLength = xLength * 3 + 1 )
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+        if( xLength > sizeof( ucStream ) - xOffset )
+        {
+            xLength = sizeof( ucStream ) - xOffset;
+        }
+        vHostInterruptEnter();
+        xOffset += xAIACaptureWriteFromISR( ucStream + xOffset, xLength, &xHigherPriorityTaskWoken );
+        vHostInterruptExit();
+    }
+    vAIACaptureGetStatistics( &xAfter );
+
+    while( xAIACaptureReceive( &pvSlot, &ulFrames, &ulGapFrames, 0 ) == pdPASS )
+    {
+        const uint8_t * pucAudio = ( const uint8_t * )pvSlot + AIA_MSG_PARAMS_SIZE_SEQ + offsetof( AIABinaryAudioStream_t, ucAudio );
+
+        if( memcmp( pucAudio, ucStream + xReceived, ulFrames * AIA_MICROPHONE_RAW_FRAME_SIZE ) != 0 )
+        {
+            xSame = pdFALSE;
+        }
+        xReceived += ulFrames * AIA_MICROPHONE_RAW_FRAME_SIZE;
+        vAIACaptureRelease( pvSlot );
+    }
+    vTestCheck( xSame == pdTRUE && xReceived == sizeof( ucStream ) && xAfter.ulCopiedBytes - xBefore.ulCopiedBytes == sizeof( ucStream ),
+                "writes of any length are put back together into whole frames" );
+}
+
+static volatile BaseType_t xCopying;
+static uint64_t ullWriteCycles;
+static uint32_t ulWriteCyclesMax;
+static uint32_t ulWrites;
+
+/* The interrupt of a platform that receives 10ms of audio at a time and copies it into the slots. */
+static void * prvCopyThread( void * pvParameters )
+{
+    static uint8_t ucChunk[ aiatestCOPY_CHUNK ];
+    struct timespec xNext;
+
+    ( void )pvParameters;
+    clock_gettime( CLOCK_MONOTONIC, &xNext );
+    while( xCopying == pdTRUE )
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        uint32_t ulCycles;
+
+        xNext.tv_nsec += aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS * 1000000L / 2;
+        if( xNext.tv_nsec >= 1000000000L )
+        {
+            xNext.tv_nsec -= 1000000000L;
+            xNext.tv_sec++;
+        }
+        clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xNext, NULL );
+
+        vHostInterruptEnter();
+        ulCycles = ulPlatformGetCycleCount();
+        xAIACaptureWriteFromISR( ucChunk, sizeof( ucChunk ), &xHigherPriorityTaskWoken );
+        ulCycles = ulPlatformGetCycleCount() - ulCycles;
+        vHostInterruptExit();
+
+        ullWriteCycles += ulCycles;
+        ulWriteCyclesMax = ( ulCycles > ulWriteCyclesMax ) ? ulCycles : ulWriteCyclesMax;
+        ulWrites++;
+    }
+
+    return NULL;
+}
+
+static void prvTestCopyRate( void )
+{
+    AIACaptureStatistics_t xBefore, xAfter;
+    pthread_t xThread;
+    struct timespec xStart, xEnd;
+    uint32_t ulMs;
+    uint32_t ulBytesPerSecond;
+    uint32_t ulCyclesPerUs = configCPU_CLOCK_HZ / 1000000UL;
+
+    vAIACaptureSetChunking( 1, 15 );
+    vAIACaptureRestart();
+    vAIACaptureGetStatistics( &xBefore );
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+    xCopying = pdTRUE;
+    pthread_create( &xThread, NULL, prvCopyThread, NULL );
+    while( vTestSleepMs( 5 ), prvDrain(), 1 )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &xEnd );
+        ulMs = ( uint32_t )( ( xEnd.tv_sec - xStart.tv_sec ) * 1000 + ( xEnd.tv_nsec - xStart.tv_nsec ) / 1000000L );
+        if( ulMs >= aiatestCOPY_MS )
+        {
+            break;
+        }
+    }
+    xCopying = pdFALSE;
+    pthread_join( xThread, NULL );
+    vAIACaptureGetStatistics( &xAfter );
+
+    ulBytesPerSecond = ( uint32_t )( ( uint64_t )( xAfter.ulCopiedBytes - xBefore.ulCopiedBytes ) * 1000U / ulMs );
+    printf( "Copy into slots: %u bytes/s in %u writes of %u bytes, %u us average and %u us most in the interrupt\n",
+            ulBytesPerSecond, ulWrites, ( uint32_t )aiatestCOPY_CHUNK,
+            ( uint32_t )( ullWriteCycles / ( ulWrites != 0 ? ulWrites : 1 ) / ulCyclesPerUs ), ulWriteCyclesMax / ulCyclesPerUs );
+    printf( "Frame completion from the DMA interrupt: %u us average, %u us most\n",
+            xAfter.ulIsrCyclesAverage / ulCyclesPerUs, xAfter.ulIsrCyclesMax / ulCyclesPerUs );
+    vTestCheck( ulBytesPerSecond > 32000U * 9U / 10U && ulBytesPerSecond < 32000U * 11U / 10U &&
+                xAfter.ulDroppedFrames == xBefore.ulDroppedFrames,
+                "audio copied in real time goes into the slots at %u bytes/s without a drop", ulBytesPerSecond );
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+
+    vTestLogOnly( pcErrors );
+    vTestCheck( xAIACaptureInit() == pdPASS, "the capture starts" );
+
+    prvTestChunking();
+    prvTestOverflow();
+    prvTestRestart();
+    prvTestWrite();
+    prvTestCopyRate();
+
+    return lTestResult();
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Tap to the first microphone message on the wire, and the cost of publishing an utterance, with the small chunks of
+ * aiaconfigAIA_AUDIO_FIRST_CHUNK_MS at its start and with whole aiaconfigAIA_AUDIO_DATA_SIZE messages from the first
+ * one. Each utterance starts with a tap of aiatestHOLD_MS, which opens the microphone on release, and gets a short
+ * conversation. The test measures the time from the touch to the first audio the service receives, and reads the
+ * figures the client reports as the microphone closes: the time from the touch-down the platform saw to the first
+ * message published, and the messages, bytes of overhead and cycles spent publishing them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestUTTERANCES                   ( 4U )
+#define aiatestUTTERANCE_MS                 ( 1000U )
+#define aiatestHOLD_MS                      ( 60U )
+#define aiatestFIXED_CHUNK_MS               ( AIA_MICROPHONE_MAX_FRAMES * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+typedef struct {
+    uint32_t ulReports;
+    uint32_t ulTapToPublishUs;
+    uint32_t ulTapToReceiveUs;
+    uint32_t ulMessages;
+    uint32_t ulAudioBytes;
+    uint32_t ulOverheadBytes;
+    uint64_t ullPublishCycles;
+} Figures_t;
+
+static volatile uint64_t ullUsAtFirstAudio;
+static Figures_t xFigures;
+
+static uint64_t prvNowUs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t )xNow.tv_sec * 1000000U + ( uint64_t )xNow.tv_nsec / 1000U;
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    ( void )ullOffset;
+    ( void )pucAudio;
+    ( void )xLength;
+    if( ullUsAtFirstAudio == 0 )
+    {
+        ullUsAtFirstAudio = prvNowUs();
+    }
+}
+
+/* The DEBUG report of the client as the microphone closes. It covers the messages published up to then. */
+static void prvLogHook( const char * pcLine )
+{
+    const char * pcReport;
+    unsigned int ulMs, ulTenths, ulMessages, ulAudio, ulOverhead, ulPercent, ulPercentTenths, ulCycles;
+
+    if( ( pcReport = strstr( pcLine, "First microphone message published " ) ) != NULL &&
+        sscanf( pcReport, "First microphone message published %u.%u ms", &ulMs, &ulTenths ) == 2 )
+    {
+        xFigures.ulReports++;
+        xFigures.ulTapToPublishUs += ulMs * 1000U + ulTenths * 100U;
+    }
+    else if( ( pcReport = strstr( pcLine, "DEBUG: " ) ) != NULL &&
+             sscanf( pcReport, "DEBUG: %u microphone messages, %u bytes of audio, %u bytes of overhead (%u.%u%%), %u cycles",
+                     &ulMessages, &ulAudio, &ulOverhead, &ulPercent, &ulPercentTenths, &ulCycles ) == 6 )
+    {
+        xFigures.ulMessages += ulMessages;
+        xFigures.ulAudioBytes += ulAudio;
+        xFigures.ulOverheadBytes += ulOverhead;
+        xFigures.ullPublishCycles += ( uint64_t )ulMessages * ulCycles;
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+static BaseType_t prvWaitTouchEnabled( void )
+{
+    for( uint32_t i = 0; i < 500; i++ )
+    {
+        HostPlatformStats_t xStats;
+
+        vHostPlatformStats( &xStats );
+        if( xStats.xTouchEnabled == pdTRUE )
+        {
+            return pdPASS;
+        }
+        vTestSleepMs( 10 );
+    }
+
+    return pdFAIL;
+}
+
+/* aiatestUTTERANCES taps and conversations. Returns the figures per utterance. */
+static Figures_t prvUtterances( const char * pcName )
+{
+    Figures_t xPerUtterance;
+    uint32_t ulConversations = 0;
+
+    memset( &xFigures, 0, sizeof( xFigures ) );
+    for( uint32_t u = 0; u < aiatestUTTERANCES; u++ )
+    {
+        uint64_t ullUsAtTouch;
+
+        if( prvWaitTouchEnabled() != pdPASS )
+        {
+            break;
+        }
+        ullUsAtFirstAudio = 0;
+        ullUsAtTouch = prvNowUs();
+        vHostTouch( pdTRUE );
+        vTestSleepMs( aiatestHOLD_MS );
+        vHostTouch( pdFALSE );
+        if( xAIAServiceConverse( aiatestUTTERANCE_MS, 5, 10000 ) != pdPASS )
+        {
+            break;
+        }
+        xFigures.ulTapToReceiveUs += ( uint32_t )( ullUsAtFirstAudio - ullUsAtTouch );
+        ulConversations++;
+    }
+    vTestCheck( ulConversations == aiatestUTTERANCES && xFigures.ulReports == aiatestUTTERANCES,
+                "%s: every tap gets its conversation and its report, %u and %u of %u", pcName, ulConversations,
+                xFigures.ulReports, aiatestUTTERANCES );
+
+    xPerUtterance = xFigures;
+    if( ulConversations != 0 )
+    {
+        xPerUtterance.ulTapToPublishUs /= aiatestUTTERANCES;
+        xPerUtterance.ulTapToReceiveUs /= ulConversations;
+        xPerUtterance.ulMessages /= aiatestUTTERANCES;
+        xPerUtterance.ulAudioBytes /= aiatestUTTERANCES;
+        xPerUtterance.ulOverheadBytes /= aiatestUTTERANCES;
+        xPerUtterance.ullPublishCycles /= aiatestUTTERANCES;
+    }
+    printf( "%s: tap to first message %u.%u ms published, %u.%u ms received; per utterance %u messages, "
+            "%u bytes of audio, %u bytes of overhead, %u cycles to publish\n", pcName,
+            xPerUtterance.ulTapToPublishUs / 1000U, ( xPerUtterance.ulTapToPublishUs % 1000U ) / 100U,
+            xPerUtterance.ulTapToReceiveUs / 1000U, ( xPerUtterance.ulTapToReceiveUs % 1000U ) / 100U,
+            xPerUtterance.ulMessages, xPerUtterance.ulAudioBytes, xPerUtterance.ulOverheadBytes,
+            ( uint32_t )xPerUtterance.ullPublishCycles );
+
+    return xPerUtterance;
+}
+
+int main( void )
+{
+    Figures_t xChunked, xFixed;
+
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+
+    xChunked = prvUtterances( "Chunked" );
+    vClientSetMicrophoneChunking( aiatestFIXED_CHUNK_MS, 0 );
+    xFixed = prvUtterances( "Fixed" );
+
+    vTestCheck( xChunked.ulTapToPublishUs >= aiatestHOLD_MS * 1000U && xFixed.ulTapToPublishUs >= aiatestHOLD_MS * 1000U,
+                "the client measures from the touch-down, before the release that opens the microphone" );
+    vTestCheck( xChunked.ulTapToReceiveUs >= xChunked.ulTapToPublishUs &&
+                xChunked.ulTapToReceiveUs < xChunked.ulTapToPublishUs + 20000U,
+                "the service receives the first message within 20 ms of what the client reports" );
+    vTestCheck( xFixed.ulTapToReceiveUs >= xChunked.ulTapToReceiveUs +
+                ( aiatestFIXED_CHUNK_MS - aiaconfigAIA_AUDIO_FIRST_CHUNK_MS ) * 1000U / 2U,
+                "chunks of %u ms reach the service sooner than messages of %u ms", ( uint32_t )aiaconfigAIA_AUDIO_FIRST_CHUNK_MS,
+                ( uint32_t )aiatestFIXED_CHUNK_MS );
+    vTestCheck( xChunked.ulMessages > aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS / aiaconfigAIA_AUDIO_FIRST_CHUNK_MS,
+                "every utterance starts with %u ms of small chunks", ( uint32_t )aiaconfigAIA_AUDIO_SMALL_CHUNKS_MS );
+    vTestCheck( xChunked.ulMessages > xFixed.ulMessages && xChunked.ulOverheadBytes > xFixed.ulOverheadBytes &&
+                xChunked.ullPublishCycles > xFixed.ullPublishCycles,
+                "the small chunks cost more messages, bytes of overhead and cycles to publish" );
+    vTestCheck( xTestClientFailed() == pdFALSE, "the client stays connected" );
+
+    return lTestResult();
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_decimator.c on its own, built from 32 and 48kHz, with the SIMD version and the intrinsics of host/arm_acle.h.
+ * Full-scale noise, with frames at the ends of the range on the frames the DEBUG check of the module runs on, must
+ * give the output of the plain C reference. Tones then measure the response the header states: a gain of 1 at DC,
+ * flat to 6.5kHz and at least 50dB down from 9.5kHz. The cycles per frame of both versions are printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_decimator.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+
+#define aiatestINPUT_SAMPLES                ( AIA_MICROPHONE_CAPTURE_FRAME_SAMPLES )
+#define aiatestOUTPUT_SAMPLES               ( AIA_MICROPHONE_RAW_FRAME_SAMPLES )
+#define aiatestFRAMES_PER_SECOND            ( 1000U / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+/* Frames of a tone, the first of which fill the history of the filter and are not measured. */
+#define aiatestTONE_FRAMES                  ( 10U )
+
+static uint32_t ulSeed = 1;
+
+static int16_t prvRandom( void )
+{
+    ulSeed = ulSeed * 1103515245U + 12345U;
+    return ( int16_t )( ulSeed >> 16 );
+}
+
+/* Gain in dB of a tone of ulHz at 0.5 of full scale. */
+static float prvToneGainDb( uint32_t ulHz )
+{
+    int16_t sOutput[ aiatestOUTPUT_SAMPLES ];
+    double dInput = 0.0;
+    double dOutput = 0.0;
+
+    vAIADecimatorInit();
+    for( uint32_t f = 0; f < aiatestTONE_FRAMES; f++ )
+    {
+        int16_t * psInput = psAIADecimatorInput();
+
+        for( uint32_t i = 0; i < aiatestINPUT_SAMPLES; i++ )
+        {
+            double dPhase = 2.0 * M_PI * ulHz * ( double )( f * aiatestINPUT_SAMPLES + i ) /
+                            aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE;
+
+            psInput[ i ] = ( int16_t )lrint( 16384.0 * sin( dPhase ) );
+            if( f > 0 )
+            {
+                dInput += ( double )psInput[ i ] * psInput[ i ];
+            }
+        }
+        vAIADecimatorProcess( sOutput );
+        if( f > 0 )
+        {
+            for( uint32_t i = 0; i < aiatestOUTPUT_SAMPLES; i++ )
+            {
+                dOutput += ( double )sOutput[ i ] * sOutput[ i ] * AIA_MICROPHONE_DECIMATION;
+            }
+        }
+    }
+
+    return ( float )( 10.0 * log10( ( dOutput + 1.0 ) / dInput ) );
+}
+
+int main( void )
+{
+    AIADecimatorStatistics_t xStatistics;
+    int16_t sOutput[ aiatestOUTPUT_SAMPLES ];
+    float fGainDb;
+    float fWorstPassDb = 0.0f;
+    float fWorstStopDb = -200.0f;
+
+    vAIADecimatorInit();
+    for( uint32_t f = 0; f < 10U * aiatestFRAMES_PER_SECOND; f++ )
+    {
+        int16_t * psInput = psAIADecimatorInput();
+
+        for( uint32_t i = 0; i < aiatestINPUT_SAMPLES; i++ )
+        {
+            /* The module checks the frames after every aiatestFRAMES_PER_SECOND-th. */
+            psInput[ i ] = ( f % aiatestFRAMES_PER_SECOND == 0 && i % 2 == 0 ) ? INT16_MAX :
+                           ( f % aiatestFRAMES_PER_SECOND == 0 ) ? INT16_MIN : prvRandom();
+        }
+        vAIADecimatorProcess( sOutput );
+    }
+    vAIADecimatorGetStatistics( &xStatistics );
+    printf( "from %u Hz, %s: %u cycles per frame on average, %u most, reference %u\n",
+            ( uint32_t )aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE,
+#if defined( __ARM_FEATURE_SIMD32 )
+            "SIMD",
+#else
+            "plain C",
+#endif
+            xStatistics.ulCyclesAverage, xStatistics.ulCyclesMax, xStatistics.ulReferenceCyclesAverage );
+#if defined( __ARM_FEATURE_SIMD32 )
+    vTestCheck( xStatistics.ulReferenceCyclesAverage != 0 && xStatistics.ulReferenceMismatches == 0,
+                "the DEBUG check of the module ran and found no mismatch, %u", xStatistics.ulReferenceMismatches );
+#endif
+
+    /* DC goes through unchanged. */
+    vAIADecimatorInit();
+    for( uint32_t f = 0; f < 2; f++ )
+    {
+        int16_t * psInput = psAIADecimatorInput();
+
+        for( uint32_t i = 0; i < aiatestINPUT_SAMPLES; i++ )
+        {
+            psInput[ i ] = 12345;
+        }
+        vAIADecimatorProcess( sOutput );
+    }
+    vTestCheck( sOutput[ 0 ] == 12345 && sOutput[ aiatestOUTPUT_SAMPLES - 1 ] == 12345, "a gain of 1 at DC, %d",
+                sOutput[ 0 ] );
+
+    for( uint32_t ulHz = 250; ulHz <= 6500; ulHz += 250 )
+    {
+        fGainDb = prvToneGainDb( ulHz );
+        fWorstPassDb = ( fabsf( fGainDb ) > fabsf( fWorstPassDb ) ) ? fGainDb : fWorstPassDb;
+    }
+    for( uint32_t ulHz = 9500; ulHz < aiaconfigCLIENT_MICROPHONE_CAPTURE_SAMPLE_RATE / 2; ulHz += 250 )
+    {
+        fGainDb = prvToneGainDb( ulHz );
+        fWorstStopDb = ( fGainDb > fWorstStopDb ) ? fGainDb : fWorstStopDb;
+    }
+    printf( "passband to 6500 Hz within %.2f dB, stopband from 9500 Hz at %.1f dB\n", fWorstPassDb, fWorstStopDb );
+    vTestCheck( fabsf( fWorstPassDb ) <= 0.5f, "flat to 6.5kHz" );
+    vTestCheck( fWorstStopDb <= -50.0f, "at least 50dB down from 9.5kHz" );
+
+    return lTestResult();
+}
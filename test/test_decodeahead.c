@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Decode-ahead against the drops of a closed speaker. The first /speaker message of an answer is decoded ahead while
+ * the speaker is closed, then so much audio follows before OpenSpeaker that the speaker buffer drops it, along with
+ * other old messages. The message decoded ahead must have stayed in the buffer for the MQTT task to drop, and the
+ * frames decoded from it must be discarded: the speaker plays the oldest audio kept, frame after frame, and nothing
+ * of what was dropped. The next answer fits in the buffer, and its frames decoded ahead are played.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAMES_PER_MESSAGE           ( 25U )
+/* Far more than the speaker buffer holds, so that the first messages are dropped. */
+#define aiatestMESSAGES                     ( aiaconfigCLIENT_SPEAKER_BUFFER_SIZE * 3U / \
+                                              ( aiatestFRAMES_PER_MESSAGE * AIA_SPEAKER_DECODER_FRAME_SIZE ) )
+#define aiatestFRAMES                       ( aiatestMESSAGES * aiatestFRAMES_PER_MESSAGE )
+
+/* The frame values played, in the 10ms transfers of the speaker DMA. Half a frame each. */
+static volatile uint32_t ulFirstValue;
+static volatile uint32_t ulLastValue;
+static volatile uint32_t ulTransfers;
+static volatile uint32_t ulBreaks;
+
+static void prvSpeakerSink( const int16_t * psSamples, size_t xSamples, size_t xBytesRead )
+{
+    uint32_t ulValue = ( uint32_t )( uint16_t )psSamples[ 0 ];
+
+    ( void )xSamples;
+    if( xBytesRead == 0 )
+    {
+        return;
+    }
+    if( ulTransfers == 0 )
+    {
+        ulFirstValue = ulValue;
+    }
+    else if( ulValue != ulLastValue && ulValue != ulLastValue + 1 )
+    {
+        ulBreaks++;
+    }
+    ulLastValue = ulValue;
+    ulTransfers++;
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", "Decoded", "Dropped", NULL };
+    HostOpusStats_t xOpusBefore, xOpusAhead, xOpusAfter;
+    char cDirectives[ 256 ];
+    uint32_t ulKeptFrames;
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostPlatformSetSpeakerSink( prvSpeakerSink );
+    /* At 128, the speaker plays the samples as decoded. */
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":128}}" );
+    vTestCheck( xAIAServiceWaitForEvent( "VolumeChanged", 1, 2000 ), "the volume is set" );
+
+    vHostOpusStats( &xOpusBefore );
+    vAIAServiceSendSpeaker( 0, aiatestFRAMES_PER_MESSAGE, aiatestFRAMES_PER_MESSAGE, 0 );
+    vTestSleepMs( 200 );
+    vHostOpusStats( &xOpusAhead );
+    vTestCheck( xOpusAhead.ulDecoded - xOpusBefore.ulDecoded == aiaconfigCLIENT_SPEAKER_DECODE_AHEAD_FRAMES,
+                "the first message is decoded ahead, %u frames", xOpusAhead.ulDecoded - xOpusBefore.ulDecoded );
+
+    vAIAServiceSendSpeaker( ( uint64_t )aiatestFRAMES_PER_MESSAGE * AIA_SPEAKER_DECODER_FRAME_SIZE,
+                            aiatestFRAMES - aiatestFRAMES_PER_MESSAGE, aiatestFRAMES_PER_MESSAGE, 0 );
+    vTestSleepMs( 200 );
+    vHostOpusStats( &xOpusAfter );
+    vTestCheck( xOpusAfter.ulDecoded == xOpusAhead.ulDecoded, "nothing more is decoded while the speaker is closed" );
+
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+                               "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":0}}" );
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )aiatestFRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 1, 20000 ), "the speaker plays to CloseSpeaker and closes" );
+    vTestSleepMs( 100 );
+
+    vHostOpusStats( &xOpusAfter );
+    ulKeptFrames = aiatestFRAMES + 1U - ulFirstValue;
+    printf( "%u frames sent, played from frame %u to %u in %u transfers, %u decoder resets\n", aiatestFRAMES,
+            ulFirstValue - 1U, ulLastValue - 1U, ulTransfers, xOpusAfter.ulDecoderResets - xOpusBefore.ulDecoderResets );
+    vTestCheck( ulFirstValue > aiatestFRAMES_PER_MESSAGE && ( ulFirstValue - 1U ) % aiatestFRAMES_PER_MESSAGE == 0,
+                "the first message is dropped and playback starts at the oldest message kept" );
+    vTestCheck( ulLastValue == aiatestFRAMES && ulBreaks == 0, "every frame kept is played once and in order" );
+    vTestCheck( ulTransfers >= ulKeptFrames * 2U && ulTransfers <= ulKeptFrames * 2U + 2U,
+                "no frame decoded ahead from the dropped message is played, %u transfers for %u frames",
+                ulTransfers, ulKeptFrames );
+    vTestCheck( xOpusAfter.ulDecoderResets > xOpusBefore.ulDecoderResets,
+                "the decoder is reset for the frames decoded ahead" );
+
+    /* An answer the buffer holds: the frames decoded ahead are played, and not decoded again. */
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"i\"},\"payload\":{\"state\":\"IDLE\"}}" );
+    ulTransfers = 0;
+    vHostOpusStats( &xOpusBefore );
+    vAIAServiceSendSpeaker( ( uint64_t )aiatestFRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE, 2U * aiatestFRAMES_PER_MESSAGE,
+                            aiatestFRAMES_PER_MESSAGE, 0 );
+    vTestSleepMs( 200 );
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}},"
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )aiatestFRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE,
+              ( unsigned long long )( aiatestFRAMES + 2U * aiatestFRAMES_PER_MESSAGE ) * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 2, 20000 ), "the next answer plays" );
+    vTestSleepMs( 100 );
+
+    vHostOpusStats( &xOpusAfter );
+    vTestCheck( ulFirstValue == aiatestFRAMES + 1U && ulLastValue == aiatestFRAMES + 2U * aiatestFRAMES_PER_MESSAGE &&
+                ulBreaks == 0, "it plays in order from its first frame" );
+    vTestCheck( xOpusAfter.ulDecoded - xOpusBefore.ulDecoded == 2U * aiatestFRAMES_PER_MESSAGE &&
+                xOpusAfter.ulDecoderResets == xOpusBefore.ulDecoderResets,
+                "its frames decoded ahead are played as they are, %u frames decoded",
+                xOpusAfter.ulDecoded - xOpusBefore.ulDecoded );
+
+    return lTestResult();
+}
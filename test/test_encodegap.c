@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Microphone offsets when opus_encode() fails. Every raw frame carries its number in its samples, which the Opus
+ * stand-in keeps in the first two bytes of the encoded frame, so the service can tell for each frame of the stream
+ * whether it sits at the offset it was captured at. With every 7th encode failing, the frames after a failure must
+ * stay in place, the failed one being sent again as the frame before it.
+ */
+
+#include <stdio.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFAIL_EVERY                   ( 7U )
+
+static uint16_t usCapturedFrame;
+static BaseType_t xBaseKnown;
+static int32_t lBase;
+static int32_t lPrevious;
+static uint32_t ulInPlace;
+static uint32_t ulRepeated;
+static uint32_t ulMisplaced;
+
+static void prvSource( void * pvFrame, size_t xBytes )
+{
+    int16_t * psSamples = ( int16_t * )pvFrame;
+
+    usCapturedFrame++;
+    for( size_t i = 0; i < xBytes / sizeof( int16_t ); i++ )
+    {
+        psSamples[ i ] = ( int16_t )usCapturedFrame;
+    }
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    for( size_t i = 0; i + AIA_MICROPHONE_STREAM_FRAME_SIZE <= xLength; i += AIA_MICROPHONE_STREAM_FRAME_SIZE )
+    {
+        int32_t lFrame = ( int32_t )( uint16_t )( pucAudio[ i ] | ( pucAudio[ i + 1 ] << 8 ) );
+        int32_t lIndex = ( int32_t )( ( ullOffset + i ) / AIA_MICROPHONE_STREAM_FRAME_SIZE );
+
+        if( xBaseKnown == pdFALSE )
+        {
+            lBase = lFrame - lIndex;
+            xBaseKnown = pdTRUE;
+        }
+        if( lFrame - lIndex == lBase )
+        {
+            ulInPlace++;
+        }
+        else if( lFrame == lPrevious && lFrame - lIndex == lBase - 1 )
+        {
+            ulRepeated++;
+        }
+        else
+        {
+            ulMisplaced++;
+        }
+        lPrevious = lFrame;
+    }
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+    AIAServiceStats_t xStats;
+    HostOpusStats_t xOpus;
+
+    vTestLogOnly( pcErrors );
+    vHostPlatformSetMicrophoneSource( prvSource );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+    vHostOpusFailEncodeEvery( aiatestFAIL_EVERY );
+
+    vTestCheck( xTestTap( 5000 ), "the microphone opens" );
+    vTestCheck( xAIAServiceConverse( 1000, 25, 10000 ), "an utterance of 1s gets its reply" );
+    vHostOpusFailEncodeEvery( 0 );
+
+    vHostOpusStats( &xOpus );
+    vAIAServiceStats( &xStats );
+    printf( "%u frames encoded, %u failed; %u frames in place, %u repeated, %u misplaced\n",
+            xOpus.ulEncoded, xOpus.ulEncodeFailures, ulInPlace, ulRepeated, ulMisplaced );
+    vTestCheck( xOpus.ulEncodeFailures >= 5, "encodes fail" );
+    vTestCheck( ulRepeated == xOpus.ulEncodeFailures, "each failed frame is replaced with the frame before it" );
+    vTestCheck( ulMisplaced == 0, "every other frame is at the offset it was captured at" );
+    vTestCheck( xStats.ulMicrophoneOffsetJumps == 0 && xStats.ulDecryptFailures == 0 && xStats.ulSequenceErrors == 0,
+                "the stream has no gap, and decrypts in sequence" );
+    vTestCheck( ulTestLogMatches() == 0, "no error is logged" );
+
+    return lTestResult();
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The end of speech, on recorded utterances. Each utterance is played into the microphone in real time after a
+ * tap, and the service closes the microphone as AIA does: on MicrophoneClosed from the client, or else once it has
+ * received aiatestSERVICE_HANGOVER_MS of the audio after the end of speech, which it is told. The link adds no
+ * latency here, which it would add to both. It then sends
+ * CloseMicrophone and THINKING in both cases. The utterances are run with the endpointer enabled and disabled, and
+ * for each the uplink bytes and the time from the end of speech to THINKING are compared, with the cycles of the
+ * detector per frame. Then the service closes the microphone as the client does, to race it.
+ *
+ * The WAV file is 16 kHz 16-bit mono, taken from AIA_TEST_UTTERANCE_WAV in the environment, e.g. a recording of a
+ * request after quiet, or else written by the test: three words of 500ms with pauses of 250ms, after quiet. The end
+ * of speech is the end of its last loud frame.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAME_SAMPLES                ( AIA_MICROPHONE_RAW_FRAME_SAMPLES )
+#define aiatestWAV_MAX_SECONDS              ( 20U )
+#define aiatestUTTERANCES                   ( 2U )
+/* Lead of the service over the client when racing it, per utterance. */
+#define aiatestRACE_LEADS_MS                { 0U, 20U, 40U }
+#define aiatestRACES                        ( 3U )
+/* The silence the service waits for before closing the microphone itself, unless AIA_TEST_SERVICE_HANGOVER_MS is
+ * set. Streamed audio reaches it after the link and the publishing, and it has to tell the end of the request from a
+ * pause, so it waits longer than the client, which hears the silence as it is captured.
+ */
+#define aiatestSERVICE_HANGOVER_MS          ( 1000U )
+/* Frames louder than this on average are speech, to find the end of speech in the file. */
+#define aiatestLOUD                         ( 1000 )
+
+typedef struct {
+    uint64_t ullBytes;
+    uint32_t ulLatencyMs;
+    uint32_t ulDetectorCycles;
+} Result_t;
+
+static int16_t * psWav;
+static uint32_t ulWavSamples;
+static uint32_t ulSpeechEnd;
+
+static volatile uint32_t ulWavPosition;
+static volatile uint32_t ulSeed = 1;
+static volatile uint64_t ullMsAtSpeechEnd;
+static volatile uint64_t ullMsAtThinking;
+static volatile uint32_t ulDetectorCycles;
+static volatile uint32_t ulMicrophoneCloses;
+static volatile uint64_t ullStreamStart;
+static volatile BaseType_t xStreamStarted;
+
+static uint64_t prvNowMs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t )xNow.tv_sec * 1000U + ( uint64_t )xNow.tv_nsec / 1000000U;
+}
+
+static int16_t prvQuiet( void )
+{
+    ulSeed = ulSeed * 1103515245 + 12345;
+    return ( int16_t )( ( int32_t )( ( ulSeed >> 16 ) % 61 ) - 30 );
+}
+
+/* Quiet noise, then three words of a voiced sound with pauses between them, then quiet noise. */
+static void prvWriteWav( const char * pcPath )
+{
+    static const struct { uint32_t ulStartMs, ulEndMs; } xWords[] = { { 500, 1000 }, { 1250, 1750 }, { 2000, 2500 } };
+    uint32_t ulSamples = 3 * aiatestWAV_SAMPLE_RATE;
+    int16_t * psSamples = malloc( ulSamples * sizeof( int16_t ) );
+
+    for( uint32_t i = 0; i < ulSamples; i++ )
+    {
+        uint32_t ulMs = i * 1000 / aiatestWAV_SAMPLE_RATE;
+        double dTime = ( double )i / aiatestWAV_SAMPLE_RATE;
+        int32_t lSample = prvQuiet();
+
+        for( size_t w = 0; w < sizeof( xWords ) / sizeof( xWords[ 0 ] ); w++ )
+        {
+            if( ulMs >= xWords[ w ].ulStartMs && ulMs < xWords[ w ].ulEndMs )
+            {
+                /* A 150 Hz voice with two harmonics, its loudness rising and falling over the word. */
+                double dEnvelope = sin( M_PI * ( ulMs - xWords[ w ].ulStartMs ) / ( xWords[ w ].ulEndMs - xWords[ w ].ulStartMs ) );
+
+                lSample += ( int32_t )( ( 2000.0 + 6000.0 * dEnvelope ) *
+                                        ( 0.6 * sin( 2.0 * M_PI * 150.0 * dTime ) + 0.3 * sin( 2.0 * M_PI * 300.0 * dTime ) +
+                                          0.1 * sin( 2.0 * M_PI * 450.0 * dTime ) ) );
+            }
+        }
+        psSamples[ i ] = ( int16_t )lSample;
+    }
+    vTestWriteWav( pcPath, psSamples, ulSamples );
+    free( psSamples );
+}
+
+/* The end of the last loud frame of the file. */
+static uint32_t prvFindSpeechEnd( void )
+{
+    uint32_t ulEnd = 0;
+
+    for( uint32_t f = 0; ( f + 1 ) * aiatestFRAME_SAMPLES <= ulWavSamples; f++ )
+    {
+        uint32_t ulSum = 0;
+
+        for( uint32_t i = 0; i < aiatestFRAME_SAMPLES; i++ )
+        {
+            ulSum += ( uint32_t )abs( psWav[ f * aiatestFRAME_SAMPLES + i ] );
+        }
+        if( ulSum / aiatestFRAME_SAMPLES > aiatestLOUD )
+        {
+            ulEnd = ( f + 1 ) * aiatestFRAME_SAMPLES;
+        }
+    }
+    return ulEnd;
+}
+
+/* The WAV file from the start of each utterance, then quiet noise. */
+static void prvSource( void * pvFrame, size_t xBytes )
+{
+    int16_t * psSamples = ( int16_t * )pvFrame;
+
+    for( size_t i = 0; i < xBytes / sizeof( int16_t ); i++ )
+    {
+        psSamples[ i ] = ( ulWavPosition < ulWavSamples ) ? psWav[ ulWavPosition ] : prvQuiet();
+        if( ++ulWavPosition == ulSpeechEnd )
+        {
+            ullMsAtSpeechEnd = prvNowMs();
+        }
+    }
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    ( void )pucAudio;
+    ( void )xLength;
+    if( xStreamStarted == pdFALSE )
+    {
+        ullStreamStart = ullOffset;
+        xStreamStarted = pdTRUE;
+    }
+}
+
+static void prvLogHook( const char * pcLine )
+{
+    const char * pcCycles = strstr( pcLine, "End of speech detector " );
+
+    if( strstr( pcLine, "Switching to THINKING state" ) != NULL )
+    {
+        ullMsAtThinking = prvNowMs();
+    }
+    if( pcCycles != NULL )
+    {
+        ulDetectorCycles = ( uint32_t )strtoul( pcCycles + strlen( "End of speech detector " ), NULL, 10 );
+    }
+    /* Once at every close of the microphone. */
+    if( strstr( pcLine, "DEBUG: Microphone ISR" ) != NULL )
+    {
+        ulMicrophoneCloses++;
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+/* Run an utterance, and close the microphone as the service: once the client has, or once ulCloseAtMs of the audio
+ * after the end of speech has come, whichever is first.
+ */
+static BaseType_t prvUtterance( uint32_t ulCloseAtMs, Result_t * pxResult )
+{
+    AIAServiceStats_t xBefore, xAfter;
+    uint32_t ulClosed = ulAIAServiceEventCount( "MicrophoneClosed" );
+    uint64_t ullCloseAt;
+    BaseType_t xReturned = pdFAIL;
+
+    vAIAServiceStats( &xBefore );
+    xStreamStarted = pdFALSE;
+    ullMsAtSpeechEnd = 0;
+    ullMsAtThinking = 0;
+    ulWavPosition = 0;
+    if( xTestTap( 2000 ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    for( uint32_t i = 0; i < ( ulWavSamples * 1000U / aiatestWAV_SAMPLE_RATE + ulCloseAtMs ) * 2U; i += 5 )
+    {
+        AIAServiceStats_t xStats;
+
+        vAIAServiceStats( &xStats );
+        ullCloseAt = ullStreamStart + ( uint64_t )( ulSpeechEnd + ulCloseAtMs * aiatestWAV_SAMPLE_RATE / 1000U ) * sizeof( int16_t );
+        if( ulAIAServiceEventCount( "MicrophoneClosed" ) > ulClosed ||
+            ( xStreamStarted == pdTRUE && xStats.ullMicrophoneOffset >= ullCloseAt ) )
+        {
+            xReturned = pdPASS;
+            break;
+        }
+        vTestSleepMs( 5 );
+    }
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"CloseMicrophone\",\"messageId\":\"c\"}},"
+                               "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"t\"},\"payload\":{\"state\":\"THINKING\"}}" );
+
+    /* The audio still queued at the close is published meanwhile. */
+    vTestSleepMs( 200 );
+    vAIAServiceStats( &xAfter );
+    pxResult->ullBytes = xAfter.ullMicrophoneBytes - xBefore.ullMicrophoneBytes;
+    pxResult->ulLatencyMs = ( ullMsAtThinking > ullMsAtSpeechEnd && ullMsAtSpeechEnd != 0 ) ?
+                            ( uint32_t )( ullMsAtThinking - ullMsAtSpeechEnd ) : 0;
+    pxResult->ulDetectorCycles = ulDetectorCycles;
+    if( xAfter.ullMicrophoneOffset < ullStreamStart + ( uint64_t )ulSpeechEnd * sizeof( int16_t ) )
+    {
+        printf( "The stream ends %u ms before the end of speech\n",
+                ( uint32_t )( ( ullStreamStart + ulSpeechEnd * sizeof( int16_t ) - xAfter.ullMicrophoneOffset ) /
+                              ( aiatestWAV_SAMPLE_RATE * sizeof( int16_t ) / 1000U ) ) );
+        xReturned = pdFAIL;
+    }
+
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"i\"},\"payload\":{\"state\":\"IDLE\"}}" );
+    return xReturned;
+}
+
+static void prvRun( BaseType_t xEndpointer, uint32_t ulServiceHangoverMs, Result_t * pxTotal )
+{
+    uint32_t ulClosed = ulAIAServiceEventCount( "MicrophoneClosed" );
+
+    vClientSetEndpointer( xEndpointer );
+    memset( pxTotal, 0, sizeof( *pxTotal ) );
+    for( uint32_t i = 0; i < aiatestUTTERANCES; i++ )
+    {
+        Result_t xResult;
+
+        vTestCheck( prvUtterance( ulServiceHangoverMs, &xResult ),
+                    "utterance %u with the endpointer %s is streamed to its end and closed", i + 1,
+                    ( xEndpointer == pdTRUE ) ? "enabled" : "disabled" );
+        printf( "Endpointer %s: %llu bytes streamed, THINKING %u ms after the end of speech, detector %u cycles per frame\n",
+                ( xEndpointer == pdTRUE ) ? "enabled" : "disabled", ( unsigned long long )xResult.ullBytes,
+                xResult.ulLatencyMs, xResult.ulDetectorCycles );
+        pxTotal->ullBytes += xResult.ullBytes;
+        pxTotal->ulLatencyMs += xResult.ulLatencyMs;
+        pxTotal->ulDetectorCycles = ( xResult.ulDetectorCycles > pxTotal->ulDetectorCycles ) ?
+                                    xResult.ulDetectorCycles : pxTotal->ulDetectorCycles;
+    }
+    vTestCheck( ulAIAServiceEventCount( "MicrophoneClosed" ) - ulClosed == ( ( xEndpointer == pdTRUE ) ? aiatestUTTERANCES : 0 ),
+                "MicrophoneClosed is sent %s", ( xEndpointer == pdTRUE ) ? "once per utterance" : "never, AIA closes the microphone" );
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", NULL };
+    static const uint32_t ulLeadsMs[ aiatestRACES ] = aiatestRACE_LEADS_MS;
+    const char * pcWav = getenv( "AIA_TEST_UTTERANCE_WAV" );
+    const char * pcServiceHangover = getenv( "AIA_TEST_SERVICE_HANGOVER_MS" );
+    uint32_t ulServiceHangoverMs = ( pcServiceHangover != NULL ) ? ( uint32_t )atoi( pcServiceHangover ) : aiatestSERVICE_HANGOVER_MS;
+    Result_t xEnabled, xDisabled;
+    uint32_t ulBudgetCycles = configCPU_CLOCK_HZ / 1000U * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS;
+    uint32_t ulCloses;
+    uint32_t ulClosed;
+    BaseType_t xRead;
+
+    if( pcWav == NULL )
+    {
+        pcWav = "build/test_endpointer.wav";
+        prvWriteWav( pcWav );
+    }
+    xRead = xTestReadWav( pcWav, aiatestWAV_MAX_SECONDS * aiatestWAV_SAMPLE_RATE, &psWav, &ulWavSamples );
+    vTestCheck( xRead, "%s is a WAV file of 16 kHz 16-bit mono audio, of %u ms", pcWav, ulWavSamples * 1000 / aiatestWAV_SAMPLE_RATE );
+    ulSpeechEnd = prvFindSpeechEnd();
+    vTestCheck( ulSpeechEnd != 0, "speech ends at %u ms", ulSpeechEnd * 1000 / aiatestWAV_SAMPLE_RATE );
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+    vHostPlatformSetMicrophoneSource( prvSource );
+
+    printf( "The service closes the microphone after %u ms of silence, the client after %u ms\n", ulServiceHangoverMs,
+            ( uint32_t )aiaconfigCLIENT_ENDPOINTER_HANGOVER_MS );
+    prvRun( pdFALSE, ulServiceHangoverMs, &xDisabled );
+    prvRun( pdTRUE, ulServiceHangoverMs, &xEnabled );
+    printf( "Per utterance, the endpointer saves %lld bytes of uplink and %d ms to THINKING, for %u cycles per %u ms frame at most (%u.%u%%)\n",
+            ( long long )( xDisabled.ullBytes - xEnabled.ullBytes ) / aiatestUTTERANCES,
+            ( int32_t )( xDisabled.ulLatencyMs - xEnabled.ulLatencyMs ) / ( int32_t )aiatestUTTERANCES,
+            xEnabled.ulDetectorCycles, ( uint32_t )aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS,
+            xEnabled.ulDetectorCycles * 100U / ulBudgetCycles, xEnabled.ulDetectorCycles * 1000U / ulBudgetCycles % 10 );
+    vTestCheck( xEnabled.ullBytes < xDisabled.ullBytes, "less audio is streamed with the endpointer" );
+    vTestCheck( xEnabled.ulLatencyMs < xDisabled.ulLatencyMs, "THINKING comes sooner with the endpointer" );
+    vTestCheck( xEnabled.ulDetectorCycles > 0 && xEnabled.ulDetectorCycles < ulBudgetCycles,
+                "the detector cycles are reported, and within the frame" );
+
+    /* CloseMicrophone comes as the client closes the microphone itself: only one of them closes it. */
+    ulCloses = ulMicrophoneCloses;
+    ulClosed = ulAIAServiceEventCount( "MicrophoneClosed" );
+    for( uint32_t i = 0; i < aiatestRACES; i++ )
+    {
+        Result_t xResult;
+
+        vTestCheck( prvUtterance( aiaconfigCLIENT_ENDPOINTER_HANGOVER_MS - ulLeadsMs[ i ], &xResult ),
+                    "utterance closed by both %u ms apart is streamed to its end", ulLeadsMs[ i ] );
+    }
+    vTestCheck( ulMicrophoneCloses - ulCloses == aiatestRACES && ulAIAServiceEventCount( "MicrophoneClosed" ) - ulClosed <= aiatestRACES,
+                "the microphone is closed once per utterance, %u times in %u", ulMicrophoneCloses - ulCloses, aiatestRACES );
+    vTestCheck( xTestTap( 2000 ) && xAIAServiceWaitForEvent( "MicrophoneOpened", 2 * aiatestUTTERANCES + aiatestRACES + 1, 2000 ),
+                "the microphone opens again" );
+
+    return lTestResult();
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_frontend.c on its own, with a WAV file. The file is taken from AIA_TEST_FRONTEND_WAV in the environment (16 kHz
+ * 16-bit mono), e.g. a recording from the board, or else written by the test: quiet noise with a DC offset and 50Hz
+ * hum, and three words of a voiced sound at -36dBFS. The stages are added one at a time, in the order they run, and
+ * the effect of each is measured against the chain without it:
+ * - DC removal takes the mean of the signal to zero.
+ * - The high-pass filter attenuates the hum, and leaves the voice alone.
+ * - Noise suppression pulls the pauses down, and leaves the words alone.
+ * - AGC brings the words to aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS, without clipping.
+ * These are checked on the file written by the test, and only reported for another file. The cycles per frame of
+ * each stage are printed, as a share of the frame at configCPU_CLOCK_HZ.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_frontend.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAME_SAMPLES                ( AIA_MICROPHONE_RAW_FRAME_SAMPLES )
+#define aiatestWAV_MAX_SECONDS              ( 60U )
+#define aiatestBUDGET_CYCLES                ( ( uint32_t )( ( uint64_t )configCPU_CLOCK_HZ * \
+                                                            aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS / 1000U ) )
+/* The file written by the test. */
+#define aiatestSECONDS                      ( 6U )
+#define aiatestDC_OFFSET                    ( 1000.0 )
+#define aiatestHUM_HZ                       ( 50.0 )
+#define aiatestHUM_AMPLITUDE                ( 100.0 )
+#define aiatestVOICE_HZ                     ( 150.0 )
+#define aiatestVOICE_DBFS                   ( -36.0 )
+
+typedef struct {
+    uint32_t ulStartMs;
+    uint32_t ulEndMs;
+} Span_t;
+
+static const Span_t xWords[] = { { 1000, 2000 }, { 2500, 3500 }, { 4000, 5000 } };
+/* The middle of the last word, once the AGC has settled, and the pause at the end. */
+static const Span_t xWord = { 4200, 4800 };
+static const Span_t xPause = { 5200, 6000 };
+/* All but the first 500ms, which the filters take to settle. */
+static const Span_t xSettled = { 500, aiatestSECONDS * 1000U };
+
+static uint32_t ulSeed = 1;
+
+static double prvNoise( void )
+{
+    ulSeed = ulSeed * 1103515245U + 12345U;
+    return ( double )( ( int32_t )( ( ulSeed >> 16 ) % 81 ) - 40 );
+}
+
+static void prvWriteWav( const char * pcPath )
+{
+    uint32_t ulSamples = aiatestSECONDS * aiatestWAV_SAMPLE_RATE;
+    int16_t * psSamples = malloc( ulSamples * sizeof( int16_t ) );
+    /* The harmonics at 1, 1/2 and 1/3 of the fundamental have a mean square of 0.681 times its amplitude squared. */
+    double dVoice = 32767.0 * pow( 10.0, aiatestVOICE_DBFS / 20.0 ) / sqrt( 0.681 );
+
+    for( uint32_t i = 0; i < ulSamples; i++ )
+    {
+        uint32_t ulMs = i * 1000U / aiatestWAV_SAMPLE_RATE;
+        double dTime = ( double )i / aiatestWAV_SAMPLE_RATE;
+        double dSample = aiatestDC_OFFSET + aiatestHUM_AMPLITUDE * sin( 2.0 * M_PI * aiatestHUM_HZ * dTime ) + prvNoise();
+
+        for( size_t w = 0; w < sizeof( xWords ) / sizeof( xWords[ 0 ] ); w++ )
+        {
+            if( ulMs >= xWords[ w ].ulStartMs && ulMs < xWords[ w ].ulEndMs )
+            {
+                /* Steady, with 20ms ramps at both ends. */
+                double dFromEdge = fmin( dTime - xWords[ w ].ulStartMs / 1000.0, xWords[ w ].ulEndMs / 1000.0 - dTime );
+                double dEnvelope = ( dFromEdge < 0.02 ) ? dFromEdge / 0.02 : 1.0;
+
+                dSample += dVoice * dEnvelope * ( sin( 2.0 * M_PI * aiatestVOICE_HZ * dTime ) +
+                                                  sin( 2.0 * M_PI * 2.0 * aiatestVOICE_HZ * dTime ) / 2.0 +
+                                                  sin( 2.0 * M_PI * 3.0 * aiatestVOICE_HZ * dTime ) / 3.0 );
+            }
+        }
+        psSamples[ i ] = ( int16_t )lrint( dSample );
+    }
+    vTestWriteWav( pcPath, psSamples, ulSamples );
+    free( psSamples );
+}
+
+/* Run the first ulStages stages over the whole file. */
+static void prvRun( const int16_t * psInput, int16_t * psOutput, uint32_t ulSamples, uint32_t ulStages )
+{
+    vAIAFrontendInit();
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        ( void )xAIAFrontendSetStage( ( AIAFrontendStage_t )i, ( i < ulStages ) ? pdTRUE : pdFALSE );
+    }
+
+    memcpy( psOutput, psInput, ulSamples * sizeof( int16_t ) );
+    for( uint32_t f = 0; ( f + 1 ) * aiatestFRAME_SAMPLES <= ulSamples; f++ )
+    {
+        vAIAFrontendProcess( &psOutput[ f * aiatestFRAME_SAMPLES ] );
+    }
+}
+
+static double prvMean( const int16_t * psSamples, const Span_t * pxSpan )
+{
+    double dSum = 0.0;
+    uint32_t ulFrom = pxSpan->ulStartMs * ( aiatestWAV_SAMPLE_RATE / 1000U );
+    uint32_t ulTo = pxSpan->ulEndMs * ( aiatestWAV_SAMPLE_RATE / 1000U );
+
+    for( uint32_t i = ulFrom; i < ulTo; i++ )
+    {
+        dSum += psSamples[ i ];
+    }
+
+    return dSum / ( ulTo - ulFrom );
+}
+
+/* The mean square in dB relative to a full-scale square wave, as the front-end measures it. */
+static double prvLevelDb( const int16_t * psSamples, uint32_t ulFrom, uint32_t ulTo )
+{
+    double dSum = 1e-9;
+
+    for( uint32_t i = ulFrom; i < ulTo; i++ )
+    {
+        dSum += ( double )psSamples[ i ] * psSamples[ i ];
+    }
+
+    return 10.0 * log10( dSum / ( ulTo - ulFrom ) / ( 32767.0 * 32767.0 ) );
+}
+
+static double prvSpanLevelDb( const int16_t * psSamples, const Span_t * pxSpan )
+{
+    return prvLevelDb( psSamples, pxSpan->ulStartMs * ( aiatestWAV_SAMPLE_RATE / 1000U ),
+                       pxSpan->ulEndMs * ( aiatestWAV_SAMPLE_RATE / 1000U ) );
+}
+
+/* The amplitude of a tone in dB, with the Goertzel algorithm. */
+static double prvToneDb( const int16_t * psSamples, const Span_t * pxSpan, double dHz )
+{
+    double dCoefficient = 2.0 * cos( 2.0 * M_PI * dHz / aiatestWAV_SAMPLE_RATE );
+    double dPrevious = 0.0, dBeforePrevious = 0.0, dCurrent;
+    uint32_t ulFrom = pxSpan->ulStartMs * ( aiatestWAV_SAMPLE_RATE / 1000U );
+    uint32_t ulTo = pxSpan->ulEndMs * ( aiatestWAV_SAMPLE_RATE / 1000U );
+
+    for( uint32_t i = ulFrom; i < ulTo; i++ )
+    {
+        dCurrent = psSamples[ i ] + dCoefficient * dPrevious - dBeforePrevious;
+        dBeforePrevious = dPrevious;
+        dPrevious = dCurrent;
+    }
+
+    return 20.0 * log10( 2.0 * sqrt( dPrevious * dPrevious + dBeforePrevious * dBeforePrevious -
+                                     dCoefficient * dPrevious * dBeforePrevious ) / ( ulTo - ulFrom ) + 1e-9 );
+}
+
+static uint32_t prvClipped( const int16_t * psSamples, uint32_t ulSamples )
+{
+    uint32_t ulClipped = 0;
+
+    for( uint32_t i = 0; i < ulSamples; i++ )
+    {
+        ulClipped += ( psSamples[ i ] == INT16_MAX || psSamples[ i ] == INT16_MIN ) ? 1 : 0;
+    }
+
+    return ulClipped;
+}
+
+static int prvCompareDouble( const void * pvA, const void * pvB )
+{
+    double dA = *( const double * )pvA, dB = *( const double * )pvB;
+
+    return ( dA > dB ) - ( dA < dB );
+}
+
+/* The levels of the frames at a percentile, 90 for speech and 10 for the noise between it. */
+static double prvPercentileDb( const int16_t * psSamples, uint32_t ulSamples, uint32_t ulPercent )
+{
+    uint32_t ulFrames = ulSamples / aiatestFRAME_SAMPLES;
+    double * pdLevels = malloc( ulFrames * sizeof( double ) );
+    double dLevel;
+
+    for( uint32_t f = 0; f < ulFrames; f++ )
+    {
+        pdLevels[ f ] = prvLevelDb( psSamples, f * aiatestFRAME_SAMPLES, ( f + 1 ) * aiatestFRAME_SAMPLES );
+    }
+    qsort( pdLevels, ulFrames, sizeof( double ), prvCompareDouble );
+    dLevel = pdLevels[ ( ulFrames - 1 ) * ulPercent / 100U ];
+    free( pdLevels );
+
+    return dLevel;
+}
+
+/* The levels before and after the whole chain, and the cycles of each stage. */
+static void prvReport( const int16_t * psInput, const int16_t * psOutput, uint32_t ulSamples )
+{
+    AIAFrontendStatistics_t xStatistics;
+    uint32_t ulTotalCycles = 0;
+
+    printf( "speech %.1f dBFS -> %.1f dBFS, noise %.1f dBFS -> %.1f dBFS, %u samples clipped\n",
+            prvPercentileDb( psInput, ulSamples, 90 ), prvPercentileDb( psOutput, ulSamples, 90 ),
+            prvPercentileDb( psInput, ulSamples, 10 ), prvPercentileDb( psOutput, ulSamples, 10 ),
+            prvClipped( psOutput, ulSamples ) );
+    for( uint32_t i = 0; i < eAIAFrontendStageNum; i++ )
+    {
+        vAIAFrontendGetStatistics( ( AIAFrontendStage_t )i, &xStatistics );
+        printf( "%s: %u cycles per frame on average (%.2f%% of %u), %u max, over %u frames\n", xStatistics.pcName,
+                xStatistics.ulCyclesAverage, 100.0 * xStatistics.ulCyclesAverage / aiatestBUDGET_CYCLES,
+                aiatestBUDGET_CYCLES, xStatistics.ulCyclesMax, xStatistics.ulFrames );
+        ulTotalCycles += xStatistics.ulCyclesAverage;
+    }
+    printf( "chain: %u cycles per frame on average, %.2f%% of the %ums frame\n", ulTotalCycles,
+            100.0 * ulTotalCycles / aiatestBUDGET_CYCLES, ( uint32_t )aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS );
+    vTestCheck( ulTotalCycles < aiatestBUDGET_CYCLES, "the chain fits in the frame" );
+}
+
+int main( void )
+{
+    const char * pcPath = getenv( "AIA_TEST_FRONTEND_WAV" );
+    int16_t * psInput;
+    int16_t * psOutput[ eAIAFrontendStageNum + 1 ];
+    uint32_t ulSamples;
+
+    if( pcPath == NULL )
+    {
+        pcPath = "build/test_frontend.wav";
+        prvWriteWav( pcPath );
+    }
+    if( xTestReadWav( pcPath, aiatestWAV_MAX_SECONDS * aiatestWAV_SAMPLE_RATE, &psInput, &ulSamples ) != pdPASS )
+    {
+        printf( "FAILED: cannot read %s\n", pcPath );
+        return 1;
+    }
+    printf( "%s: %u ms\n", pcPath, ulSamples * 1000U / aiatestWAV_SAMPLE_RATE );
+
+    /* psOutput[ n ] has gone through the first n stages, with the statistics of the last run, of all of them. */
+    for( uint32_t n = 0; n <= eAIAFrontendStageNum; n++ )
+    {
+        psOutput[ n ] = malloc( ulSamples * sizeof( int16_t ) );
+        prvRun( psInput, psOutput[ n ], ulSamples, n );
+    }
+    prvReport( psInput, psOutput[ eAIAFrontendStageNum ], ulSamples );
+    vAIAFrontendReport();
+
+    if( getenv( "AIA_TEST_FRONTEND_WAV" ) == NULL )
+    {
+        double dBefore, dAfter, dHumDrop, dVoiceChange, dPauseDrop, dWordChange, dWord;
+
+        dBefore = prvMean( psOutput[ eAIAFrontendDcRemoval ], &xSettled );
+        dAfter = prvMean( psOutput[ eAIAFrontendDcRemoval + 1 ], &xSettled );
+        printf( "DC removal: mean %.1f -> %.1f\n", dBefore, dAfter );
+        vTestCheck( fabs( dAfter ) < 5.0, "DC removal takes the mean from %.0f to about 0", aiatestDC_OFFSET );
+
+        dHumDrop = prvToneDb( psOutput[ eAIAFrontendHighPass ], &xSettled, aiatestHUM_HZ ) -
+                   prvToneDb( psOutput[ eAIAFrontendHighPass + 1 ], &xSettled, aiatestHUM_HZ );
+        dVoiceChange = prvToneDb( psOutput[ eAIAFrontendHighPass + 1 ], &xSettled, 3.0 * aiatestVOICE_HZ ) -
+                       prvToneDb( psOutput[ eAIAFrontendHighPass ], &xSettled, 3.0 * aiatestVOICE_HZ );
+        printf( "High-pass: %.0fHz attenuated by %.1f dB, %.0fHz changed by %+.2f dB\n", aiatestHUM_HZ, dHumDrop,
+                3.0 * aiatestVOICE_HZ, dVoiceChange );
+        /* A second-order Butterworth filter at 100Hz is 12.3dB down at 50Hz. */
+        vTestCheck( dHumDrop > 11.0, "the high-pass filter attenuates %.0fHz hum by more than 11 dB", aiatestHUM_HZ );
+        vTestCheck( fabs( dVoiceChange ) < 0.5, "the high-pass filter passes %.0fHz", 3.0 * aiatestVOICE_HZ );
+
+        dPauseDrop = prvSpanLevelDb( psOutput[ eAIAFrontendNoiseSuppression ], &xPause ) -
+                     prvSpanLevelDb( psOutput[ eAIAFrontendNoiseSuppression + 1 ], &xPause );
+        dWordChange = prvSpanLevelDb( psOutput[ eAIAFrontendNoiseSuppression + 1 ], &xWord ) -
+                      prvSpanLevelDb( psOutput[ eAIAFrontendNoiseSuppression ], &xWord );
+        printf( "Noise suppression: noise floor lowered by %.1f dB, words changed by %+.2f dB\n", dPauseDrop, dWordChange );
+        vTestCheck( dPauseDrop > aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB - 3.0,
+                    "noise suppression lowers the noise floor by about %u dB",
+                    ( uint32_t )aiaconfigCLIENT_FRONTEND_NOISE_SUPPRESSION_DB );
+        vTestCheck( fabs( dWordChange ) < 1.0, "noise suppression leaves the words alone" );
+
+        dBefore = prvSpanLevelDb( psOutput[ eAIAFrontendAgc ], &xWord );
+        dWord = prvSpanLevelDb( psOutput[ eAIAFrontendAgc + 1 ], &xWord );
+        printf( "AGC: words %.1f dBFS -> %.1f dBFS\n", dBefore, dWord );
+        vTestCheck( fabs( dWord + aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS ) < 1.5, "AGC brings the words to -%u dBFS",
+                    ( uint32_t )aiaconfigCLIENT_FRONTEND_AGC_TARGET_DBFS );
+        vTestCheck( prvClipped( psOutput[ eAIAFrontendAgc + 1 ], ulSamples ) == 0, "AGC does not clip" );
+    }
+
+    for( uint32_t n = 0; n <= eAIAFrontendStageNum; n++ )
+    {
+        free( psOutput[ n ] );
+    }
+    free( psInput );
+
+    return lTestResult();
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The low-memory profile in a capped heap. The client connects, publishes its capabilities and goes through
+ * utterances started by a tap, each with a spoken reply, while the heap refuses anything beyond
+ * aiatestHEAP_CAP. Any allocation refused, or any event that could not get a buffer, fails the test.
+ *
+ * The MQTT and TLS stacks of the board are not part of the host build, so this covers the share of the client:
+ * tasks, queues, stream and message buffers, timers and whatever the client allocates at run time. The static RAM of
+ * the client, its pools and arenas, is taken from the symbol table of the test and printed along with the heap.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#if ( aiaconfigLOW_MEMORY_PROFILE != 1 )
+#error "Build this test with aiaconfigLOW_MEMORY_PROFILE=1."
+#endif
+
+#ifndef aiatestHEAP_CAP
+#define aiatestHEAP_CAP                     ( 128U * 1024U )
+#endif
+
+#define aiatestUTTERANCES                   ( 3U )
+#define aiatestUTTERANCE_MS                 ( 1500U )
+#define aiatestREPLY_FRAMES                 ( 100U )
+
+static const char * const pcErrors[] = {
+    "No event buffer is free",
+    "Failed",
+    "failed",
+    NULL
+};
+
+/* The size of the data and bss objects defined in aia/, from nm, with the largest printed. */
+static uint32_t prvClientStaticRam( void )
+{
+    char cExe[ 256 ] = { 0 };
+    char cLine[ 512 ];
+    char cName[ 64 ];
+    char cType;
+    unsigned long ulSize;
+    uint32_t ulTotal = 0;
+    FILE * pxNm;
+
+    if( readlink( "/proc/self/exe", cExe, sizeof( cExe ) - 1 ) <= 0 )
+    {
+        return 0;
+    }
+    snprintf( cLine, sizeof( cLine ), "nm -S -l --defined-only --size-sort -r %s", cExe );
+    pxNm = popen( cLine, "r" );
+    if( pxNm == NULL )
+    {
+        return 0;
+    }
+    while( fgets( cLine, sizeof( cLine ), pxNm ) != NULL )
+    {
+        if( sscanf( cLine, "%*lx %lx %c %63s", &ulSize, &cType, cName ) == 3 && strchr( "bBdD", cType ) != NULL &&
+            strstr( cLine, "/aia/" ) != NULL )
+        {
+            if( ulSize >= 1024U )
+            {
+                printf( "Static: %s %lu bytes\n", cName, ulSize );
+            }
+            ulTotal += ( uint32_t )ulSize;
+        }
+    }
+    pclose( pxNm );
+
+    return ulTotal;
+}
+
+int main( void )
+{
+    HostHeapStats_t xHeap;
+    AIAServiceStats_t xService;
+    HostPlatformStats_t xPlatform;
+    BaseType_t xConversed = pdPASS;
+    uint32_t ulAllocationsAtStart;
+    uint32_t ulStaticRam;
+
+    vTestLogOnly( pcErrors );
+    vHostSetHeapCap( aiatestHEAP_CAP );
+
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects in a %u KB heap", aiatestHEAP_CAP / 1024U );
+    vHostHeapStats( &xHeap );
+    ulAllocationsAtStart = xHeap.ulAllocations;
+
+    for( uint32_t i = 0; i < aiatestUTTERANCES && xConversed == pdPASS; i++ )
+    {
+        xConversed = xTestTap( 5000 );
+        if( xConversed == pdPASS )
+        {
+            xConversed = xAIAServiceConverse( aiatestUTTERANCE_MS, aiatestREPLY_FRAMES, 10000 );
+        }
+        vTestCheck( xConversed, "utterance %u and its reply of %u ms", i + 1, aiatestREPLY_FRAMES * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    }
+    /* Let the SpeakerClosed reports and the IDLE directive go through. */
+    vTestSleepMs( 500 );
+
+    vHostHeapStats( &xHeap );
+    vAIAServiceStats( &xService );
+    vHostPlatformStats( &xPlatform );
+
+    printf( "Heap: peak %zu of %u bytes, %u allocations, %u refused\n",
+            xHeap.xPeak, aiatestHEAP_CAP, xHeap.ulAllocations, xHeap.ulFailures );
+    ulStaticRam = prvClientStaticRam();
+    printf( "Client RAM: %zu bytes of heap at the peak and %u static, %zu in all, MQTT and TLS not included\n",
+            xHeap.xPeak, ulStaticRam, xHeap.xPeak + ulStaticRam );
+    printf( "Event buffers: %u of %lu left at the least\n",
+            ( uint32_t )uxAIAEventPoolMinFree(), ( unsigned long )aiaconfigAIA_EVENT_BUFFERS );
+    printf( "Service: %u events, %u microphone messages, %u overruns, %u underruns\n",
+            xService.ulEvents, xService.ulMicrophoneMessages, xService.ulOverruns, xService.ulUnderruns );
+
+    vTestCheck( ulStaticRam != 0, "the static RAM of the client is measured" );
+    vTestCheck( xHeap.ulFailures == 0, "no allocation is refused" );
+    vTestCheck( xHeap.ulAllocations == ulAllocationsAtStart, "nothing is allocated once connected, %u allocations",
+                xHeap.ulAllocations - ulAllocationsAtStart );
+    vTestCheck( ulTestLogMatches() == 0, "no error is logged" );
+    vTestCheck( xService.ulDecryptFailures == 0 && xService.ulSequenceErrors == 0, "every message decrypts, in sequence" );
+    vTestCheck( xService.ulOverruns == 0, "the speaker buffer does not overrun" );
+    vTestCheck( xTestClientFailed() == pdFALSE, "the client stays connected" );
+
+    return lTestResult();
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_offsetsched.c on its own, against a virtual playback clock. The clock plays the stream a frame at a time, and
+ * now and then jumps ahead over a hole in the offsets, as the speaker task does. Actions are added at random offsets
+ * ahead of it, at the offset playing and behind it, several at the same offset, up to the capacity of the scheduler.
+ * At every frame, the actions taken must be exactly those a sorted list says are due, in the order of their offsets
+ * and, at the same offset, in the order they were added. The order numbers start just short of wrapping around.
+ *
+ * Then in the client, against the scripted service and the speaker DMA of the host. The directives of an answer come
+ * before its audio, while the speaker is about to open: SetVolume, SetAttentionState, a CloseSpeaker that falls in
+ * the middle of a message, and a SetAttentionState past it. Each must be taken just before the frame at its offset is
+ * played. The frames before SetVolume must play at the old volume and the rest at the new one, nothing may play past
+ * CloseSpeaker, and the state past it must be taken as the speaker closes. A SetVolume with an offset in the next
+ * answer, sent while no speaker is open or about to open, must be taken at once and apply from its first frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_offsetsched.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestCAPACITY                     ( 16U )
+#define aiatestFRAMES                       ( 200000U )
+#define aiatestFRAME                        ( ( uint64_t )AIA_SPEAKER_DECODER_FRAME_SIZE )
+/* Actions are added up to this many frames ahead of the clock. */
+#define aiatestHORIZON_FRAMES               ( 50U )
+/* The answers played in the client, in frames from their first. CloseSpeaker falls in the middle of a message. */
+#define aiatestSENT_FRAMES                  ( 40U )
+#define aiatestFRAMES_PER_MESSAGE           ( 5U )
+#define aiatestVOLUME_FRAME                 ( 10U )
+#define aiatestIDLE_FRAME                   ( 20U )
+#define aiatestCLOSE_FRAME                  ( 33U )
+#define aiatestPAST_CLOSE_FRAME             ( 38U )
+#define aiatestNEXT_FRAMES                  ( 10U )
+#define aiatestSAMPLES                      ( AIA_SPEAKER_RAW_FRAME_SAMPLES )
+
+/* The reference: the actions waiting, in the order they are to be taken. */
+static AIAOffsetAction_t xReference[ aiatestCAPACITY ];
+static uint32_t ulReferenceCount;
+
+static void prvReferenceAdd( uint64_t ullOffset, uint32_t ulAction, uint32_t ulValue )
+{
+    uint32_t i = ulReferenceCount;
+
+    /* After every action at the same offset or before. */
+    while( i > 0 && xReference[ i - 1 ].ullOffset > ullOffset )
+    {
+        xReference[ i ] = xReference[ i - 1 ];
+        i--;
+    }
+    xReference[ i ].ullOffset = ullOffset;
+    xReference[ i ].ulAction = ulAction;
+    xReference[ i ].ulValue = ulValue;
+    ulReferenceCount++;
+}
+
+static void prvReferenceTake( void )
+{
+    memmove( &xReference[ 0 ], &xReference[ 1 ], ( ulReferenceCount - 1U ) * sizeof( xReference[ 0 ] ) );
+    ulReferenceCount--;
+}
+
+/* Samples read by the speaker DMA of the host since the test last reset its count, and those played out, counted as
+ * the client does: what a transfer reads has been played when the next one comes. The first sample of each frame is
+ * kept; the Opus stand-in decodes the number of the frame, plus one, into every sample.
+ */
+static volatile uint64_t ullSamplesRead;
+static volatile uint64_t ullSamplesPlayed;
+static int16_t sFirstSample[ aiatestSENT_FRAMES ];
+
+/* Taken from the log and the events of the client. */
+typedef struct {
+    uint32_t ulAction;
+    uint32_t ulOffset;
+    uint32_t ulTakenAt;
+} TakenAction_t;
+
+static TakenAction_t xTaken[ 8 ];
+static volatile uint32_t ulTakenCount;
+static volatile uint32_t ulScheduledCount;
+static volatile uint64_t ullSamplesAtIdle;
+static volatile uint64_t ullClosedOffset;
+
+static void prvSpeakerSink( const int16_t * psSamples, size_t xSamples, size_t xBytesRead )
+{
+    ( void )xSamples;
+    ullSamplesPlayed = ullSamplesRead;
+    for( size_t i = 0; i < xBytesRead / sizeof( int16_t ); i++ )
+    {
+        if( ullSamplesRead % aiatestSAMPLES == 0 && ullSamplesRead / aiatestSAMPLES < aiatestSENT_FRAMES )
+        {
+            sFirstSample[ ullSamplesRead / aiatestSAMPLES ] = psSamples[ i ];
+        }
+        ullSamplesRead++;
+    }
+}
+
+static void prvResetCounts( void )
+{
+    vHostInterruptEnter();
+    ullSamplesRead = 0;
+    ullSamplesPlayed = 0;
+    memset( sFirstSample, 0, sizeof( sFirstSample ) );
+    vHostInterruptExit();
+    ulTakenCount = 0;
+    ulScheduledCount = 0;
+    ullSamplesAtIdle = UINT64_MAX;
+    ullClosedOffset = 0;
+}
+
+static void prvLogHook( const char * pcLine )
+{
+    const char * pcReport = strstr( pcLine, "DEBUG: Action " );
+    TakenAction_t xAction;
+
+    if( pcReport != NULL && ulTakenCount < sizeof( xTaken ) / sizeof( xTaken[ 0 ] ) &&
+        sscanf( pcReport, "DEBUG: Action %u at offset %u taken at %u", &xAction.ulAction, &xAction.ulOffset,
+                &xAction.ulTakenAt ) == 3 )
+    {
+        xTaken[ ulTakenCount++ ] = xAction;
+    }
+    else if( pcReport != NULL && strstr( pcReport, " scheduled" ) != NULL )
+    {
+        ulScheduledCount++;
+    }
+    if( strstr( pcLine, "Switching to IDLE state." ) != NULL )
+    {
+        ullSamplesAtIdle = ullSamplesPlayed;
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+static void prvEvent( const char * pcName, const char * pcJson, size_t xLength )
+{
+    const char * pcValue;
+    unsigned long long ullValue;
+
+    ( void )xLength;
+    if( strcmp( pcName, "SpeakerClosed" ) == 0 && ( pcValue = strstr( pcJson, "\"offset\":" ) ) != NULL &&
+        sscanf( pcValue, "\"offset\":%llu", &ullValue ) == 1 )
+    {
+        ullClosedOffset = ullValue;
+    }
+}
+
+/* The frames from ulFirst to ulLast played at ulVolume. */
+static BaseType_t prvPlayedAt( uint64_t ullOpenOffset, uint32_t ulFirst, uint32_t ulLast, uint32_t ulVolume )
+{
+    for( uint32_t f = ulFirst; f < ulLast; f++ )
+    {
+        int16_t sExpected = ( int16_t )( ( ( int )( ( ullOpenOffset / aiatestFRAME + f ) % 1000U + 1U ) * ( int )ulVolume ) >> 7 );
+
+        if( sFirstSample[ f ] != sExpected )
+        {
+            printf( "frame %u played %d, %d expected at volume %u\n", f, sFirstSample[ f ], sExpected, ulVolume );
+            return pdFALSE;
+        }
+    }
+
+    return pdTRUE;
+}
+
+/* Whether the action was taken at the frame at ulFrame, or at the close for UINT32_MAX. */
+static BaseType_t prvTakenAt( uint32_t ulIndex, AIAClient_OffsetAction_t xAction, uint32_t ulFrame, uint32_t ulTakenAt )
+{
+    return ( ulIndex < ulTakenCount && xTaken[ ulIndex ].ulAction == ( uint32_t )xAction &&
+             xTaken[ ulIndex ].ulOffset == ulFrame * aiatestFRAME && xTaken[ ulIndex ].ulTakenAt == ulTakenAt ) ? pdTRUE : pdFALSE;
+}
+
+static void prvClient( void )
+{
+    char cDirectives[ 1024 ];
+    uint32_t ulVolumeChanged;
+    uint64_t ullNextOffset = aiatestSENT_FRAMES * aiatestFRAME;
+
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostPlatformSetSpeakerSink( prvSpeakerSink );
+    vAIAServiceSetEventHook( prvEvent );
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":128}},"
+                               "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"t\"},\"payload\":{\"state\":\"THINKING\"}}" );
+    vTestCheck( xAIAServiceWaitForEvent( "VolumeChanged", 1, 2000 ), "SetVolume with no offset is taken at once" );
+
+    /* The directives of an answer, then its audio. */
+    prvResetCounts();
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":0}},"
+              "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":64,\"offset\":%u}},"
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"i\"},\"payload\":{\"state\":\"IDLE\",\"offset\":%u}},"
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%u}},"
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"t\"},\"payload\":{\"state\":\"THINKING\",\"offset\":%u}}",
+              ( uint32_t )( aiatestVOLUME_FRAME * aiatestFRAME ), ( uint32_t )( aiatestIDLE_FRAME * aiatestFRAME ),
+              ( uint32_t )( aiatestCLOSE_FRAME * aiatestFRAME ), ( uint32_t )( aiatestPAST_CLOSE_FRAME * aiatestFRAME ) );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestSleepMs( 100 );
+    vTestCheck( ulScheduledCount == 4 && ulTakenCount == 0, "the actions wait for the speaker about to open" );
+    vAIAServiceSendSpeaker( 0, aiatestSENT_FRAMES, aiatestFRAMES_PER_MESSAGE, 0 );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 1, 5000 ), "the answer plays to CloseSpeaker" );
+    vTestSleepMs( 100 );
+
+    printf( "Actions taken:" );
+    for( uint32_t i = 0; i < ulTakenCount; i++ )
+    {
+        printf( " %u at %u taken at %u%s", xTaken[ i ].ulAction, xTaken[ i ].ulOffset, xTaken[ i ].ulTakenAt,
+                ( i + 1U < ulTakenCount ) ? "," : "\n" );
+    }
+    printf( "IDLE after %llu samples played, %llu samples read, SpeakerClosed at %llu\n",
+            ( unsigned long long )ullSamplesAtIdle, ( unsigned long long )ullSamplesRead,
+            ( unsigned long long )ullClosedOffset );
+    vTestCheck( ulTakenCount == 4 &&
+                prvTakenAt( 0, eAIAOffsetActionSetVolume, aiatestVOLUME_FRAME, aiatestVOLUME_FRAME * aiatestFRAME ) &&
+                prvTakenAt( 1, eAIAOffsetActionSetAttentionState, aiatestIDLE_FRAME, aiatestIDLE_FRAME * aiatestFRAME ) &&
+                prvTakenAt( 2, eAIAOffsetActionCloseSpeaker, aiatestCLOSE_FRAME, aiatestCLOSE_FRAME * aiatestFRAME ) &&
+                prvTakenAt( 3, eAIAOffsetActionSetAttentionState, aiatestPAST_CLOSE_FRAME, UINT32_MAX ),
+                "each action is taken at the frame at its offset, the one past CloseSpeaker as the speaker closes" );
+    vTestCheck( prvPlayedAt( 0, 0, aiatestVOLUME_FRAME, 128 ) && prvPlayedAt( 0, aiatestVOLUME_FRAME, aiatestCLOSE_FRAME, 64 ),
+                "frames play at the old volume up to the offset of SetVolume, and at the new one from it" );
+    /* Ahead of what is played by the buffer of decoded audio, the transfer under way and the frame being written. */
+    vTestCheck( ullSamplesAtIdle <= aiatestIDLE_FRAME * aiatestSAMPLES &&
+                ullSamplesAtIdle + ( aiaconfigCLIENT_DECODER_BUFFER_FRAMES + 2U ) * aiatestSAMPLES > aiatestIDLE_FRAME * aiatestSAMPLES,
+                "IDLE is taken as the frame at its offset goes to the speaker" );
+    vTestCheck( ullSamplesRead == aiatestCLOSE_FRAME * aiatestSAMPLES && ullClosedOffset == aiatestCLOSE_FRAME * aiatestFRAME,
+                "nothing plays past CloseSpeaker, in the middle of a message, and SpeakerClosed reports its offset" );
+
+    /* SetVolume with an offset and no speaker open. */
+    prvResetCounts();
+    ulVolumeChanged = ulAIAServiceEventCount( "VolumeChanged" );
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":96,\"offset\":%u}}",
+              ( uint32_t )( ullNextOffset + aiatestNEXT_FRAMES / 2U * aiatestFRAME ) );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "VolumeChanged", ulVolumeChanged + 1U, 2000 ) && ulScheduledCount == 0 &&
+                ulTakenCount == 0, "SetVolume with an offset is taken at once while no speaker is open" );
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}},"
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullNextOffset, ( unsigned long long )( ullNextOffset + aiatestNEXT_FRAMES * aiatestFRAME ) );
+    vAIAServiceSendDirectives( cDirectives );
+    vAIAServiceSendSpeaker( ullNextOffset, aiatestNEXT_FRAMES, aiatestFRAMES_PER_MESSAGE, 0 );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 2, 5000 ), "the next answer plays" );
+    vTestSleepMs( 100 );
+    vTestCheck( prvPlayedAt( ullNextOffset, 0, aiatestNEXT_FRAMES, 96 ) && ullSamplesRead == aiatestNEXT_FRAMES * aiatestSAMPLES,
+                "the next answer plays at that volume from its first frame" );
+    vTestCheck( xTestClientFailed() == pdFALSE, "the client stays connected" );
+}
+
+int main( void )
+{
+    static AIAOffsetAction_t xStorage[ aiatestCAPACITY ];
+    AIAOffsetScheduler_t xScheduler;
+    AIAOffsetAction_t xAction;
+    uint64_t ullPlaying = 0;
+    uint32_t ulValue = 0;
+    uint32_t ulAdded = 0;
+    uint32_t ulTaken = 0;
+    uint32_t ulRefused = 0;
+    uint32_t ulWrong = 0;
+    uint32_t ulJumps = 0;
+    uint32_t ulMostDue = 0;
+
+    srand( 1 );
+    vAIAOffsetSchedInit( &xScheduler, xStorage, aiatestCAPACITY );
+    vTestCheck( xAIAOffsetSchedTake( &xScheduler, UINT64_MAX, &xAction ) == pdFALSE, "nothing is due when empty" );
+    xScheduler.ulNextOrder = UINT32_MAX - 1000U;
+
+    for( uint32_t f = 0; f < aiatestFRAMES; f++ )
+    {
+        uint32_t ulDue = 0;
+
+        /* Directives come now and then, some with several actions at the same offset. */
+        if( rand() % 4 == 0 )
+        {
+            uint32_t ulActions = 1U + ( uint32_t )rand() % 3U;
+            int32_t lFrames = ( int32_t )( rand() % ( aiatestHORIZON_FRAMES + 4U ) ) - 3;
+            uint64_t ullOffset = ullPlaying + ( int64_t )lFrames * ( int64_t )aiatestFRAME;
+
+            if( lFrames < 0 && ullPlaying < ( uint64_t )( -lFrames ) * aiatestFRAME )
+            {
+                ullOffset = 0;
+            }
+            for( uint32_t a = 0; a < ulActions; a++ )
+            {
+                uint32_t ulAction = ( uint32_t )rand() % 3U;
+
+                BaseType_t xFull = ( ulReferenceCount == aiatestCAPACITY );
+                BaseType_t xAdded = xAIAOffsetSchedAdd( &xScheduler, ullOffset, ulAction, ulValue );
+
+                if( ( xAdded == pdPASS ) == ( xFull == pdTRUE ) )
+                {
+                    /* Added when there was room, refused when full. */
+                    ulWrong++;
+                }
+                else if( xFull == pdTRUE )
+                {
+                    ulRefused++;
+                }
+                else
+                {
+                    prvReferenceAdd( ullOffset, ulAction, ulValue );
+                    ulAdded++;
+                }
+                ulValue++;
+            }
+        }
+
+        /* The frame at ullPlaying is played: take what is due. */
+        while( xAIAOffsetSchedTake( &xScheduler, ullPlaying, &xAction ) == pdTRUE )
+        {
+            if( ulReferenceCount == 0 || xReference[ 0 ].ullOffset > ullPlaying ||
+                xAction.ullOffset != xReference[ 0 ].ullOffset || xAction.ulAction != xReference[ 0 ].ulAction ||
+                xAction.ulValue != xReference[ 0 ].ulValue )
+            {
+                if( ulWrong++ == 0 )
+                {
+                    printf( "frame %u at %llu: took %u at %llu\n", f, ( unsigned long long )ullPlaying,
+                            xAction.ulValue, ( unsigned long long )xAction.ullOffset );
+                }
+                break;
+            }
+            prvReferenceTake();
+            ulTaken++;
+            ulDue++;
+        }
+        if( ulReferenceCount > 0 && xReference[ 0 ].ullOffset <= ullPlaying )
+        {
+            ulWrong++;
+        }
+        if( ulAIAOffsetSchedCount( &xScheduler ) != ulReferenceCount )
+        {
+            ulWrong++;
+        }
+        ulMostDue = ( ulDue > ulMostDue ) ? ulDue : ulMostDue;
+
+        /* The clock moves on a frame, or over a hole in the offsets. */
+        if( rand() % 100 == 0 )
+        {
+            ullPlaying += ( 2U + ( uint32_t )rand() % 20U ) * aiatestFRAME;
+            ulJumps++;
+        }
+        else
+        {
+            ullPlaying += aiatestFRAME;
+        }
+    }
+
+    /* The stream ends: everything left is due. */
+    while( xAIAOffsetSchedTake( &xScheduler, UINT64_MAX, &xAction ) == pdTRUE )
+    {
+        if( ulReferenceCount == 0 || xAction.ulValue != xReference[ 0 ].ulValue )
+        {
+            ulWrong++;
+            break;
+        }
+        prvReferenceTake();
+        ulTaken++;
+    }
+
+    printf( "%u frames, %u jumps: %u actions added, %u refused as full, %u taken, at most %u at a frame\n",
+            aiatestFRAMES, ulJumps, ulAdded, ulRefused, ulTaken, ulMostDue );
+    vTestCheck( ulWrong == 0, "every action is taken at its offset, in order, %u wrong", ulWrong );
+    vTestCheck( ulTaken == ulAdded && ulReferenceCount == 0 && ulAIAOffsetSchedCount( &xScheduler ) == 0,
+                "every action added is taken once" );
+    vTestCheck( ulRefused > 0 && ulMostDue > 1 && ulJumps > 0, "the scheduler fills, and several actions come due at once" );
+    vTestCheck( ( int32_t )( xScheduler.ulNextOrder - ( UINT32_MAX - 1000U ) ) > 1000, "the order numbers wrap around" );
+
+    prvClient();
+
+    return lTestResult();
+}
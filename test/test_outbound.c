@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Order of the outbound task, on its own with a recording publish function. An event queued for the control queue
+ * while MicrophoneClosed waits behind audio in the audio queue must not overtake it, an event at the head of the
+ * audio queue goes out whatever is left of the budget, and xPublished is only given for a message that is published.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_outbound.h"
+#include "aia_test.h"
+#include "semphr.h"
+#include "task.h"
+
+#define aiatestMAX_PUBLISHED                ( 8 )
+
+static uint8_t ucBuffer[ AIA_MSG_PARAMS_SIZE_SEQ + aiaconfigAIA_OUTBOUND_BYTES_PER_INTERVAL ];
+static uint32_t ulSequence;
+static const char * pcPublished[ aiatestMAX_PUBLISHED ];
+static TickType_t xPublishedAt[ aiatestMAX_PUBLISHED ];
+static volatile uint32_t ulPublished;
+static volatile uint32_t ulReleased;
+static SemaphoreHandle_t xGate;
+
+/* The name of a message is its plaintext. The first one is held until the test opens the gate. */
+static BaseType_t prvPublish( const AIAOutboundMessage_t * pxMessage )
+{
+    if( ulPublished == 0 )
+    {
+        xSemaphoreTake( xGate, portMAX_DELAY );
+    }
+    if( strcmp( ( const char * )pxMessage->pvPlaintext, "Unpublishable" ) == 0 )
+    {
+        return pdFAIL;
+    }
+    if( ulPublished < aiatestMAX_PUBLISHED )
+    {
+        pcPublished[ ulPublished ] = ( const char * )pxMessage->pvPlaintext;
+        xPublishedAt[ ulPublished ] = xTaskGetTickCount();
+    }
+    ( *pxMessage->pulSequence )++;
+    ulPublished++;
+    return pdPASS;
+}
+
+static void prvRelease( void * pvBuffer )
+{
+    ( void )pvBuffer;
+    ulReleased++;
+}
+
+static BaseType_t prvSend( AIAOutboundQueue_t xQueue, const char * pcName, uint32_t ulLength, BaseType_t xEvent, SemaphoreHandle_t xPublished )
+{
+    AIAOutboundMessage_t xMessage = {
+        .pcTopic = "aia/loopback",
+        .pvPlaintext = ( void * )pcName,
+        .ulLength = ulLength,
+        .pulSequence = &ulSequence,
+        .pvBuffer = ucBuffer,
+        .vRelease = prvRelease,
+        .xEvent = xEvent,
+        .xPublished = xPublished,
+    };
+
+    return xAIAOutboundSend( xQueue, &xMessage, pdMS_TO_TICKS( 2000 ) );
+}
+
+/* Waits for room in the full audio queue, where it has to follow MicrophoneClosed. */
+static void prvSendEventTask( void * pvParameters )
+{
+    prvSend( eAIAOutboundControl, "SpeakerOpened", 100, pdTRUE, NULL );
+    vTaskDelete( NULL );
+}
+
+static uint32_t prvIndexOf( const char * pcName )
+{
+    for( uint32_t i = 0; i < ulPublished && i < aiatestMAX_PUBLISHED; i++ )
+    {
+        if( strcmp( pcPublished[ i ], pcName ) == 0 )
+        {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+    SemaphoreHandle_t xPublished = xSemaphoreCreateBinary();
+    SemaphoreHandle_t xNotPublished = xSemaphoreCreateBinary();
+    uint32_t ulAudio;
+    uint32_t ulClosed;
+
+    vTestLogOnly( pcErrors );
+    xGate = xSemaphoreCreateBinary();
+    vTestCheck( xAIAOutboundInit( prvPublish ) == pdPASS, "the outbound task starts" );
+
+    /* Hold the task on the first event, and fill the audio queue behind it: audio of a whole interval of budget,
+     * then MicrophoneClosed. SpeakerOpened comes last, from another task.
+     */
+    prvSend( eAIAOutboundControl, "SynchronizeState", 100, pdTRUE, xPublished );
+    vTestSleepMs( 10 );
+    prvSend( eAIAOutboundAudio, "Audio", aiaconfigAIA_OUTBOUND_BYTES_PER_INTERVAL - 100, pdFALSE, NULL );
+    prvSend( eAIAOutboundAudio, "MicrophoneClosed", 100, pdTRUE, NULL );
+    xTaskCreate( prvSendEventTask, "Event", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+    vTestSleepMs( 10 );
+    xSemaphoreGive( xGate );
+
+    vTestCheck( xSemaphoreTake( xPublished, pdMS_TO_TICKS( 1000 ) ) == pdPASS, "xPublished is given once the event is published" );
+    vTestSleepMs( 300 );
+    ulAudio = prvIndexOf( "Audio" );
+    ulClosed = prvIndexOf( "MicrophoneClosed" );
+    vTestCheck( ulPublished == 4 && ulReleased == 4, "%u messages are published and released", ulPublished );
+    vTestCheck( ulAudio == 1 && ulClosed == 2 && prvIndexOf( "SpeakerOpened" ) == 3,
+                "SpeakerOpened does not overtake MicrophoneClosed" );
+    if( ulAudio < aiatestMAX_PUBLISHED && ulClosed < aiatestMAX_PUBLISHED )
+    {
+        vTestCheck( xPublishedAt[ ulClosed ] - xPublishedAt[ ulAudio ] < aiaconfigAIA_OUTBOUND_INTERVAL / 2,
+                    "MicrophoneClosed goes out %u ms after the audio that used up the budget",
+                    ( uint32_t )( xPublishedAt[ ulClosed ] - xPublishedAt[ ulAudio ] ) );
+    }
+
+    prvSend( eAIAOutboundControl, "Unpublishable", 100, pdTRUE, xNotPublished );
+    vTestCheck( xSemaphoreTake( xNotPublished, pdMS_TO_TICKS( 300 ) ) != pdPASS && ulReleased == 5,
+                "xPublished is not given when publishing fails, and the buffer is released" );
+
+    vAIAOutboundCleanup();
+
+    return lTestResult();
+}
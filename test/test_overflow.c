@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Microphone overflows under a throttled uplink. Every 4th publish stalls for 300ms, longer than the spare capture
+ * slots of the low-memory profile hold, so audio is dropped. Every captured frame carries its number, which is never
+ * 0, in its samples, so the service can tell for each frame of the stream whether it sits at the offset it was
+ * captured at. With aiaconfigCLIENT_MICROPHONE_GAP_SILENCE set, the dropped frames must reach the service as frames of
+ * silence and the stream must have no hole in its offsets; without it, no silence is sent and the holes must stand
+ * for the dropped frames. Either way every frame of audio must stay in place.
+ */
+
+#include <stdio.h>
+
+#include "aia_capture.h"
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestUTTERANCE_MS                 ( 4000U )
+#define aiatestSTALL_MS                     ( 300U )
+#define aiatestSTALL_EVERY                  ( 4U )
+
+static uint16_t usCapturedFrame;
+static uint32_t ulSilentFrames;
+static uint32_t ulAudioFrames;
+static BaseType_t xBaseKnown;
+static int32_t lBase;
+static uint32_t ulMisplaced;
+
+static void prvSource( void * pvFrame, size_t xBytes )
+{
+    int16_t * psSamples = ( int16_t * )pvFrame;
+
+    usCapturedFrame++;
+    for( size_t i = 0; i < xBytes / sizeof( int16_t ); i++ )
+    {
+        psSamples[ i ] = ( int16_t )usCapturedFrame;
+    }
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    for( size_t i = 0; i + AIA_MICROPHONE_STREAM_FRAME_SIZE <= xLength; i += AIA_MICROPHONE_STREAM_FRAME_SIZE )
+    {
+        BaseType_t xSilent = pdTRUE;
+        int32_t lFrame = ( int32_t )( uint16_t )( pucAudio[ i ] | ( pucAudio[ i + 1 ] << 8 ) );
+        int32_t lIndex = ( int32_t )( ( ullOffset + i ) / AIA_MICROPHONE_STREAM_FRAME_SIZE );
+
+        for( size_t j = 0; j < AIA_MICROPHONE_STREAM_FRAME_SIZE; j++ )
+        {
+            if( pucAudio[ i + j ] != 0 )
+            {
+                xSilent = pdFALSE;
+                break;
+            }
+        }
+        if( xSilent == pdTRUE )
+        {
+            ulSilentFrames++;
+        }
+        else
+        {
+            ulAudioFrames++;
+            if( xBaseKnown == pdFALSE )
+            {
+                lBase = lFrame - lIndex;
+                xBaseKnown = pdTRUE;
+            }
+            if( lFrame - lIndex != lBase )
+            {
+                ulMisplaced++;
+            }
+        }
+    }
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", "overflow", NULL };
+    AIAServiceStats_t xStats;
+    AIACaptureStatistics_t xCapture;
+    uint32_t ulDropped;
+
+    vTestLogOnly( pcPatterns );
+    vHostPlatformSetMicrophoneSource( prvSource );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+    vAIACaptureGetStatistics( &xCapture );
+    ulDropped = xCapture.ulDroppedFrames;
+
+    vHostMqttSetPublishDelay( aiatestSTALL_MS, aiatestSTALL_EVERY );
+    vTestCheck( xTestTap( 5000 ), "the microphone opens" );
+    vTestCheck( xAIAServiceConverse( aiatestUTTERANCE_MS, 25, 30000 ), "an utterance of %u ms gets its reply", aiatestUTTERANCE_MS );
+    vHostMqttSetPublishDelay( 0, 0 );
+    /* Let the last microphone messages queued before MicrophoneClosed reach the service. */
+    vTestSleepMs( 500 );
+
+    vAIAServiceStats( &xStats );
+    vAIACaptureGetStatistics( &xCapture );
+    ulDropped = xCapture.ulDroppedFrames - ulDropped;
+    printf( "%u frames dropped in %u overflows; %u frames of audio, %u misplaced, and %u of silence sent, "
+            "%u offset jumps of %u bytes\n", ulDropped, xCapture.ulOverflows, ulAudioFrames, ulMisplaced, ulSilentFrames,
+            xStats.ulMicrophoneOffsetJumps, ( uint32_t )xStats.ullMicrophoneBytesSkipped );
+
+    vTestCheck( ulDropped != 0 && ulTestLogMatches() >= 1, "stalls of %u ms on every %u-th publish overflow the capture",
+                aiatestSTALL_MS, aiatestSTALL_EVERY );
+#if ( aiaconfigCLIENT_MICROPHONE_GAP_SILENCE == 1 )
+    vTestCheck( ulSilentFrames != 0 && ulSilentFrames <= ulDropped, "dropped frames are sent as silence" );
+    vTestCheck( xStats.ulMicrophoneOffsetJumps == 0, "the offsets of the stream have no hole" );
+#else
+    vTestCheck( ulSilentFrames == 0, "no silence is sent" );
+    vTestCheck( xStats.ullMicrophoneBytesSkipped != 0 &&
+                xStats.ullMicrophoneBytesSkipped <= ( uint64_t )ulDropped * AIA_MICROPHONE_STREAM_FRAME_SIZE,
+                "the holes in the offsets stand for dropped frames" );
+#endif
+    vTestCheck( ulMisplaced == 0, "every frame of audio sits at the offset it was captured at" );
+    vTestCheck( ( uint64_t )( ulAudioFrames + ulSilentFrames ) * AIA_MICROPHONE_STREAM_FRAME_SIZE +
+                xStats.ullMicrophoneBytesSkipped == xStats.ullMicrophoneOffset, "the frames and holes make up the stream" );
+    vTestCheck( xStats.ulDecryptFailures == 0 && xStats.ulSequenceErrors == 0, "the stream decrypts in sequence" );
+
+    return lTestResult();
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_playclock.c on its own, against a simulated speaker DMA. Frames are written into a buffer of decoded audio as
+ * the speaker task would, with stalls that leave the DMA short, and a jump in the offsets now and then. The DMA reads
+ * half a frame, or what there is, per transfer, and reports it to the clock as the speaker read functions do. The run
+ * is long enough for the positions of the clock to wrap around.
+ *
+ * After every transfer, the offset of the clock must be that of the audio the DMA has played out, i.e. not counting
+ * the transfer under way. Markers held after a frame must come due with the transfer that finishes playing it, and
+ * the end once everything written has been played.
+ *
+ * Then in the client, against the scripted service and the speaker DMA of the host, which the test follows with a
+ * playback clock of its own from what each transfer reads. An answer with markers between its aiatestMARKER_FRAMES
+ * frame parts is sent all at once, far ahead of playback: each SpeakerMarkerEncountered must come once the frames before
+ * it have been played and within a frame of it, and SpeakerClosed only once the whole answer has been played. A
+ * longer answer is stopped by CloseSpeaker with no offset: SpeakerClosed must report the offset played, within a
+ * frame of the clock of the test, and the marker not played by then must never come.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_playclock.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestRAW_FRAME                    ( AIA_SPEAKER_RAW_FRAME_SIZE )
+#define aiatestENCODED_FRAME                ( AIA_SPEAKER_DECODER_FRAME_SIZE )
+/* The DMA plays a frame in two transfers. */
+#define aiatestTRANSFER                     ( aiatestRAW_FRAME / 2U )
+/* Frames the buffer of decoded audio holds. */
+#define aiatestBUFFER_FRAMES                ( 6U )
+/* Enough transfers for the raw positions to wrap around. */
+#define aiatestTRANSFERS                    ( ( uint32_t )( ( 1ULL << 32 ) / aiatestTRANSFER ) + 1000000U )
+#define aiatestMARKER_EVERY                 ( 7U )
+#define aiatestJUMP_EVERY                   ( 50U )
+#define aiatestJUMP_FRAMES                  ( 3U )
+/* The answers played in the client. The first has a marker after each aiatestMARKER_FRAMES but the last. */
+#define aiatestMARKER_FRAMES                ( 10U )
+#define aiatestMARKERS                      ( 3U )
+#define aiatestANSWER_FRAMES                ( ( aiatestMARKERS + 1U ) * aiatestMARKER_FRAMES )
+#define aiatestSTOPPED_FRAMES               ( 100U )
+#define aiatestSTOP_AFTER_MS                ( 600U )
+
+/* The frames written and not yet played out, with the raw position each starts at. */
+typedef struct {
+    uint64_t ullPosition;
+    uint64_t ullOffset;
+} Frame_t;
+
+static Frame_t xFrames[ aiatestBUFFER_FRAMES + 2U ];
+static uint32_t ulFrameHead;
+static uint32_t ulFrameTail;
+
+static AIAPlayclock_t xPlayclock;
+
+/* The offset of the audio played out to ullPlayed, from the frames written. */
+static uint64_t prvExpectedOffset( uint64_t ullPlayed, uint64_t ullNextOffset )
+{
+    while( ulFrameTail != ulFrameHead &&
+           xFrames[ ulFrameTail % ( aiatestBUFFER_FRAMES + 2U ) ].ullPosition + aiatestRAW_FRAME <= ullPlayed &&
+           ulFrameHead - ulFrameTail > 1U )
+    {
+        ulFrameTail++;
+    }
+    if( ulFrameTail == ulFrameHead )
+    {
+        return ullNextOffset;
+    }
+
+    Frame_t * pxFrame = &xFrames[ ulFrameTail % ( aiatestBUFFER_FRAMES + 2U ) ];
+
+    return pxFrame->ullOffset + ( ullPlayed - pxFrame->ullPosition ) * aiatestENCODED_FRAME / aiatestRAW_FRAME;
+}
+
+/* Held events come due in order, and at the right transfer: when the audio written before them has been played, and
+ * not before. Returns the number of events taken, or UINT32_MAX if one was wrong.
+ */
+static uint32_t prvTakeDue( uint64_t ullPlayed, uint64_t ullPlayedBefore, AIAPlayclockEventType_t * pxLastType,
+                            uint32_t * pulExpectedMarker )
+{
+    AIAPlayclockEvent_t xEvent;
+    uint32_t ulTaken = 0;
+
+    while( xAIAPlayclockTakeDue( &xPlayclock, &xEvent ) == pdTRUE )
+    {
+        uint64_t ullDue = ( uint64_t )xEvent.ulValue * aiatestRAW_FRAME;
+
+        *pxLastType = xEvent.xType;
+        if( xEvent.xType == eAIAPlayclockMarker )
+        {
+            if( xEvent.ulValue != *pulExpectedMarker )
+            {
+                return UINT32_MAX;
+            }
+            *pulExpectedMarker += aiatestMARKER_EVERY;
+        }
+        if( ullPlayed < ullDue || ullPlayedBefore >= ullDue )
+        {
+            printf( "event %u due at %llu taken at %llu\n", xEvent.ulValue, ( unsigned long long )ullDue,
+                    ( unsigned long long )ullPlayed );
+            return UINT32_MAX;
+        }
+        ulTaken++;
+    }
+
+    return ulTaken;
+}
+
+/* Samples played out by the speaker DMA of the host since the clock of the test was reset, counted as the client
+ * does: what a transfer reads has been played when the next one comes.
+ */
+static volatile uint64_t ullSamplesPlayed;
+static uint32_t ulSamplesReading;
+
+/* Taken by the event hook as each event arrives. */
+static uint64_t ullSamplesAtMarker[ aiatestMARKERS + 2U ];
+static uint32_t ulMarker[ aiatestMARKERS + 2U ];
+static volatile uint32_t ulMarkersReceived;
+static uint64_t ullSamplesAtClosed;
+static uint64_t ullClosedOffset;
+
+static void prvSpeakerSink( const int16_t * psSamples, size_t xSamples, size_t xBytesRead )
+{
+    ( void )psSamples;
+    ( void )xSamples;
+    ullSamplesPlayed += ulSamplesReading;
+    ulSamplesReading = ( uint32_t )( xBytesRead / sizeof( int16_t ) );
+}
+
+static void prvResetClock( void )
+{
+    vHostInterruptEnter();
+    ullSamplesPlayed = 0;
+    ulSamplesReading = 0;
+    vHostInterruptExit();
+    ulMarkersReceived = 0;
+    ullClosedOffset = 0;
+}
+
+static void prvEvent( const char * pcName, const char * pcJson, size_t xLength )
+{
+    const char * pcValue;
+    unsigned long long ullValue;
+    unsigned int ulValue;
+
+    ( void )xLength;
+    if( strcmp( pcName, "SpeakerMarkerEncountered" ) == 0 && ulMarkersReceived < aiatestMARKERS + 2U &&
+        ( pcValue = strstr( pcJson, "\"marker\":" ) ) != NULL && sscanf( pcValue, "\"marker\":%u", &ulValue ) == 1 )
+    {
+        ullSamplesAtMarker[ ulMarkersReceived ] = ullSamplesPlayed;
+        ulMarker[ ulMarkersReceived++ ] = ulValue;
+    }
+    else if( strcmp( pcName, "SpeakerClosed" ) == 0 && ( pcValue = strstr( pcJson, "\"offset\":" ) ) != NULL &&
+             sscanf( pcValue, "\"offset\":%llu", &ullValue ) == 1 )
+    {
+        ullSamplesAtClosed = ullSamplesPlayed;
+        ullClosedOffset = ullValue;
+    }
+}
+
+static void prvLogHook( const char * pcLine )
+{
+    if( strstr( pcLine, "ailed" ) != NULL || strstr( pcLine, "DEBUG: Closed at offset" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+static void prvOpenSpeaker( uint64_t ullOffset, const char * pcCloseSpeaker )
+{
+    char cDirectives[ 256 ];
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}}%s",
+              ( unsigned long long )ullOffset, pcCloseSpeaker );
+    vAIAServiceSendDirectives( cDirectives );
+}
+
+static void prvClient( void )
+{
+    char cCloseSpeaker[ 128 ];
+    uint64_t ullOffset = ( uint64_t )aiatestANSWER_FRAMES * aiatestENCODED_FRAME;
+    uint64_t ullPlayedOffset;
+    BaseType_t xHeld = pdTRUE;
+
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostPlatformSetSpeakerSink( prvSpeakerSink );
+    vAIAServiceSetEventHook( prvEvent );
+
+    /* An answer sent at once, with its markers, played to its end. */
+    prvResetClock();
+    for( uint32_t m = 0; m <= aiatestMARKERS; m++ )
+    {
+        vAIAServiceSendSpeaker( ( uint64_t )m * aiatestMARKER_FRAMES * aiatestENCODED_FRAME, aiatestMARKER_FRAMES, 5, 0 );
+        if( m < aiatestMARKERS )
+        {
+            vAIAServiceSendMarker( m + 1U );
+        }
+    }
+    snprintf( cCloseSpeaker, sizeof( cCloseSpeaker ),
+              ",{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullOffset );
+    prvOpenSpeaker( 0, cCloseSpeaker );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 1, 5000 ), "the answer plays to its end" );
+    for( uint32_t m = 0; m < ulMarkersReceived; m++ )
+    {
+        uint64_t ullDue = ( uint64_t )( m + 1U ) * aiatestMARKER_FRAMES * AIA_SPEAKER_RAW_FRAME_SAMPLES;
+
+        printf( "Marker %u after %llu samples, sent after %llu played\n", ulMarker[ m ], ( unsigned long long )ullDue,
+                ( unsigned long long )ullSamplesAtMarker[ m ] );
+        xHeld &= ( ulMarker[ m ] == m + 1U && ullSamplesAtMarker[ m ] >= ullDue && ullSamplesAtMarker[ m ] < ullDue + AIA_SPEAKER_RAW_FRAME_SAMPLES );
+    }
+    vTestCheck( ulMarkersReceived == aiatestMARKERS && xHeld == pdTRUE,
+                "each of %u markers is sent once the frames before it are played, within a frame", aiatestMARKERS );
+    vTestCheck( ullClosedOffset == ullOffset &&
+                ullSamplesAtClosed >= ( uint64_t )aiatestANSWER_FRAMES * AIA_SPEAKER_RAW_FRAME_SAMPLES,
+                "SpeakerClosed reports the close offset %llu once it is played, at %llu, after %llu samples",
+                ( unsigned long long )ullOffset, ( unsigned long long )ullClosedOffset,
+                ( unsigned long long )ullSamplesAtClosed );
+
+    /* A longer answer stopped early, with a marker it does not get to. */
+    prvResetClock();
+    vAIAServiceSendSpeaker( ullOffset, aiatestSTOPPED_FRAMES - 20U, 5, 0 );
+    vAIAServiceSendMarker( aiatestMARKERS + 1U );
+    vAIAServiceSendSpeaker( ullOffset + ( aiatestSTOPPED_FRAMES - 20U ) * aiatestENCODED_FRAME, 20U, 5, 0 );
+    prvOpenSpeaker( ullOffset, "" );
+    vTestSleepMs( aiatestSTOP_AFTER_MS );
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"y\"}}" );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 2, 2000 ), "CloseSpeaker with no offset closes the speaker" );
+    ullPlayedOffset = ullOffset + ullSamplesAtClosed * aiatestENCODED_FRAME / AIA_SPEAKER_RAW_FRAME_SAMPLES;
+    printf( "Stopped after %u ms: SpeakerClosed at offset %llu, %llu played by then\n", aiatestSTOP_AFTER_MS,
+            ( unsigned long long )ullClosedOffset, ( unsigned long long )ullPlayedOffset );
+    vTestCheck( ullClosedOffset <= ullPlayedOffset && ullClosedOffset + aiatestENCODED_FRAME > ullPlayedOffset &&
+                ullClosedOffset < ullOffset + ( aiatestSTOPPED_FRAMES - 20U ) * aiatestENCODED_FRAME,
+                "SpeakerClosed reports the offset played, within a frame, short of the audio decoded" );
+    vTestSleepMs( 200 );
+    vTestCheck( ulMarkersReceived == 0, "the marker not played is dropped" );
+    vTestCheck( xTestClientFailed() == pdFALSE, "the client stays connected" );
+}
+
+int main( void )
+{
+    uint64_t ullWritten = 0;
+    uint64_t ullRead = 0;
+    uint64_t ullPlayed = 0;
+    uint64_t ullNextOffset = 0;
+    uint32_t ulReading = 0;
+    uint32_t ulFramesWritten = 0;
+    uint32_t ulStall = 0;
+    uint32_t ulMismatches = 0;
+    uint32_t ulUnderruns = 0;
+    uint32_t ulJumps = 0;
+    uint32_t ulMarkers = 0;
+    uint32_t ulMarkersMissed = 0;
+    uint32_t ulExpectedMarker = aiatestMARKER_EVERY;
+    uint32_t ulTaken;
+    BaseType_t xWrong = pdFALSE;
+    BaseType_t xEnded = pdFALSE;
+    AIAPlayclockEventType_t xLastType = eAIAPlayclockMarker;
+
+    srand( 1 );
+    vAIAPlayclockInit( &xPlayclock, aiatestRAW_FRAME, aiatestENCODED_FRAME );
+    vTestCheck( xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockMarker, 0 ) == pdFAIL,
+                "a stopped clock holds no event" );
+    vAIAPlayclockStart( &xPlayclock, 0 );
+
+    for( uint32_t t = 0; t < aiatestTRANSFERS; t++ )
+    {
+        BaseType_t xWriting = ( t < aiatestTRANSFERS - 4U * aiatestBUFFER_FRAMES );
+        uint64_t ullPlayedBefore = ullPlayed;
+        BaseType_t xDue;
+
+        /* The speaker task: fill the buffer unless it is held up. */
+        if( ulStall > 0 )
+        {
+            ulStall--;
+        }
+        else if( xWriting == pdTRUE && rand() % 500 == 0 )
+        {
+            ulStall = 10U + ( uint32_t )rand() % 30U;
+        }
+        while( xWriting == pdTRUE && ulStall == 0 && ullWritten - ullRead + aiatestRAW_FRAME <= aiatestBUFFER_FRAMES * aiatestRAW_FRAME )
+        {
+            if( ulFramesWritten % aiatestJUMP_EVERY == aiatestJUMP_EVERY - 1U )
+            {
+                ullNextOffset += aiatestJUMP_FRAMES * aiatestENCODED_FRAME;
+                ulJumps++;
+            }
+            xFrames[ ulFrameHead % ( aiatestBUFFER_FRAMES + 2U ) ].ullPosition = ullWritten;
+            xFrames[ ulFrameHead % ( aiatestBUFFER_FRAMES + 2U ) ].ullOffset = ullNextOffset;
+            ulFrameHead++;
+            vAIAPlayclockWrite( &xPlayclock, ullNextOffset );
+            ullWritten += aiatestRAW_FRAME;
+            ullNextOffset += aiatestENCODED_FRAME;
+            ulFramesWritten++;
+            if( ulFramesWritten % aiatestMARKER_EVERY == 0 )
+            {
+                if( xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockMarker, ulFramesWritten ) == pdPASS )
+                {
+                    ulMarkers++;
+                }
+                else
+                {
+                    ulMarkersMissed++;
+                }
+            }
+        }
+        if( xWriting != pdTRUE && xEnded == pdFALSE && xLastType != eAIAPlayclockEnd )
+        {
+            /* The stream closes: the end comes after the last frame written. */
+            vTestCheck( xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockEnd, ulFramesWritten ) == pdPASS,
+                        "the end is held" );
+            xEnded = pdTRUE;
+        }
+
+        /* The DMA: what was read for the last transfer has played out, and the next is read. */
+        ullPlayed += ulReading;
+        ulReading = ( ullWritten - ullRead < aiatestTRANSFER ) ? ( uint32_t )( ullWritten - ullRead ) : aiatestTRANSFER;
+        ullRead += ulReading;
+        if( ulReading < aiatestTRANSFER && xWriting == pdTRUE )
+        {
+            ulUnderruns++;
+        }
+        xDue = xAIAPlayclockPlayedFromISR( &xPlayclock, ulReading );
+
+        if( ullAIAPlayclockOffset( &xPlayclock ) != prvExpectedOffset( ullPlayed, ullNextOffset ) )
+        {
+            if( ulMismatches++ == 0 )
+            {
+                printf( "transfer %u: offset %llu, expected %llu\n", t,
+                        ( unsigned long long )ullAIAPlayclockOffset( &xPlayclock ),
+                        ( unsigned long long )prvExpectedOffset( ullPlayed, ullNextOffset ) );
+            }
+        }
+        if( ulAIAPlayclockUnplayed( &xPlayclock ) != ( uint32_t )( ullWritten - ullPlayed ) )
+        {
+            ulMismatches++;
+        }
+
+        ulTaken = prvTakeDue( ullPlayed, ullPlayedBefore, &xLastType, &ulExpectedMarker );
+        if( ulTaken == UINT32_MAX || ( xDue == pdTRUE ) != ( ulTaken > 0 ) )
+        {
+            xWrong = pdTRUE;
+        }
+    }
+
+    printf( "%u transfers, %llu bytes written, %u frames, %u underruns, %u offset jumps, %u markers\n",
+            aiatestTRANSFERS, ( unsigned long long )ullWritten, ulFramesWritten, ulUnderruns, ulJumps, ulMarkers );
+    vTestCheck( ullWritten > UINT32_MAX && ulUnderruns > 0 && ulJumps > 0, "the positions wrap around, with underruns and jumps" );
+    vTestCheck( ulMismatches == 0, "the offset is that of the audio played out after every transfer, %u wrong", ulMismatches );
+    vTestCheck( ulMarkersMissed == 0 && xWrong == pdFALSE && ulExpectedMarker > ulMarkers * aiatestMARKER_EVERY,
+                "every marker comes due, in order, with the transfer that plays out the frame before it" );
+    vTestCheck( xLastType == eAIAPlayclockEnd && ullPlayed == ullWritten, "the end comes once everything written is played" );
+
+    /* As many events as the clock holds, then one more. */
+    vAIAPlayclockStart( &xPlayclock, 0 );
+    vAIAPlayclockWrite( &xPlayclock, 0 );
+    for( uint32_t i = 0; i < AIA_PLAYCLOCK_EVENTS; i++ )
+    {
+        xWrong |= ( xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockMarker, i ) != pdPASS );
+    }
+    vTestCheck( xWrong == pdFALSE && xAIAPlayclockSchedule( &xPlayclock, eAIAPlayclockMarker, 0 ) == pdFAIL,
+                "%u events are held, and no more", AIA_PLAYCLOCK_EVENTS );
+    vAIAPlayclockStop( &xPlayclock );
+    vAIAPlayclockStart( &xPlayclock, 0 );
+    ( void )xAIAPlayclockPlayedFromISR( &xPlayclock, 0 );
+    vTestCheck( xAIAPlayclockPlayedFromISR( &xPlayclock, 0 ) == pdFALSE, "the events are dropped when it stops" );
+
+    prvClient();
+
+    return lTestResult();
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The adaptive playout controller of aia_playout.c, on its own and in the client.
+ *
+ * First against synthetic traces: streams of 3s in messages of 100ms, sent 1s ahead of real time as AIA does, over a
+ * link with 30ms of delay where a message stalls for 300 to 900ms now and then, holding up the ones behind it. Each
+ * trace is played with the controller, and with the prebuffer held at 0 as the client does without it, counting the
+ * underruns and the time from the first message sent to the first audio played. The traces come from the seeds below,
+ * so every run plays the same ones.
+ *
+ * Then in the client, against the scripted service: thresholds proposed after a late stream are only used once the
+ * capabilities carrying them are accepted, and left as they were when they are rejected.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_playout.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestSTREAMS                      ( 60U )
+#define aiatestSTREAM_MS                    ( 3000U )
+#define aiatestMESSAGE_MS                   ( 100U )
+#define aiatestMESSAGES                     ( aiatestSTREAM_MS / aiatestMESSAGE_MS )
+#define aiatestAHEAD_MS                     ( 1000U )
+#define aiatestDELAY_MS                     ( 30U )
+#define aiatestSTALL_MIN_MS                 ( 300U )
+#define aiatestSTALL_MAX_MS                 ( 900U )
+/* Time between streams. */
+#define aiatestPAUSE_MS                     ( 2000U )
+#define aiatestBYTES_PER_SECOND             ( aiaconfigCLIENT_SPEAKER_DECODER_BITRATE / 8U )
+#define aiatestMESSAGE_BYTES                ( aiatestBYTES_PER_SECOND * aiatestMESSAGE_MS / 1000U )
+
+typedef struct {
+    uint32_t ulUnderruns;
+    uint32_t ulFirstAudioMs;
+    uint32_t ulMaxTargetMs;
+    uint32_t ulProposals;
+} TestPlayoutResult_t;
+
+/* The arrival of each message of a stream, in ms from the first sent. */
+static void prvTrace( uint32_t * pulArrival, uint32_t ulStallPercent )
+{
+    uint32_t ulLast = 0;
+
+    for( uint32_t k = 0; k < aiatestMESSAGES; k++ )
+    {
+        uint32_t ulSent = ( k * aiatestMESSAGE_MS > aiatestAHEAD_MS ) ? k * aiatestMESSAGE_MS - aiatestAHEAD_MS : 0;
+        uint32_t ulArrival = ulSent + aiatestDELAY_MS;
+
+        if( ( uint32_t )rand() % 100U < ulStallPercent )
+        {
+            ulArrival += aiatestSTALL_MIN_MS + ( uint32_t )rand() % ( aiatestSTALL_MAX_MS - aiatestSTALL_MIN_MS );
+        }
+        /* In order, as over TCP. */
+        ulLast = ( ulArrival > ulLast ) ? ulArrival : ulLast;
+        pulArrival[ k ] = ulLast;
+    }
+}
+
+/* Play one stream starting at xStart, as the speaker task would: hold the prebuffer, then play each message in turn
+ * for its 100ms, waiting out an underrun when the next one is not there.
+ */
+static void prvPlay( AIAPlayout_t * pxPlayout,
+                     const uint32_t * pulArrival,
+                     TickType_t xStart,
+                     uint64_t ullOffset,
+                     TestPlayoutResult_t * pxResult )
+{
+    uint32_t ulPlay;
+    uint32_t ulArrived = 0;
+    AIAPlayoutStatistics_t xStatistics;
+
+    for( uint32_t k = 0; k < aiatestMESSAGES; k++ )
+    {
+        vAIAPlayoutArrival( pxPlayout, ullOffset + ( uint64_t )k * aiatestMESSAGE_BYTES, xStart + pulArrival[ k ] );
+    }
+
+    for( ulPlay = pulArrival[ 0 ]; ; ulPlay++ )
+    {
+        while( ulArrived < aiatestMESSAGES && pulArrival[ ulArrived ] <= ulPlay )
+        {
+            ulArrived++;
+        }
+        if( xAIAPlayoutPrebuffer( pxPlayout, ulArrived * aiatestMESSAGE_BYTES, xStart + ulPlay ) == 0 )
+        {
+            break;
+        }
+    }
+    pxResult->ulFirstAudioMs += ulPlay;
+
+    for( uint32_t k = 0; k < aiatestMESSAGES; k++, ulPlay += aiatestMESSAGE_MS )
+    {
+        if( pulArrival[ k ] > ulPlay )
+        {
+            vAIAPlayoutUnderrun( pxPlayout );
+            pxResult->ulUnderruns++;
+            ulPlay = pulArrival[ k ];
+        }
+    }
+
+    if( xAIAPlayoutStreamEnd( pxPlayout, ullOffset + ( uint64_t )aiatestMESSAGES * aiatestMESSAGE_BYTES ) == pdTRUE )
+    {
+        pxResult->ulProposals++;
+        ( void )xAIAPlayoutAcknowledge( pxPlayout, pdTRUE );
+    }
+    vAIAPlayoutGetStatistics( pxPlayout, &xStatistics );
+    pxResult->ulMaxTargetMs = ( xStatistics.ulTargetMs > pxResult->ulMaxTargetMs ) ? xStatistics.ulTargetMs :
+                                                                                       pxResult->ulMaxTargetMs;
+}
+
+static void prvRunTraces( uint32_t ulStallPercent, uint32_t ulMaxTargetMs, TestPlayoutResult_t * pxResult )
+{
+    static AIAPlayout_t xPlayout;
+    uint32_t ulArrival[ aiatestMESSAGES ];
+    TickType_t xStart = 0;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    vAIAPlayoutInit( &xPlayout, aiatestBYTES_PER_SECOND, aiaconfigCLIENT_SPEAKER_BUFFER_SIZE,
+                     aiaconfigCLIENT_SPEAKER_BUFFER_OVERRUN_WARNING, aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING,
+                     ulMaxTargetMs );
+    srand( ulStallPercent + 1U );
+    for( uint32_t s = 0; s < aiatestSTREAMS; s++ )
+    {
+        prvTrace( ulArrival, ulStallPercent );
+        prvPlay( &xPlayout, ulArrival, xStart, ( uint64_t )s * aiatestSTREAM_MS * aiatestBYTES_PER_SECOND / 1000U, pxResult );
+        xStart += ulArrival[ aiatestMESSAGES - 1 ] + aiatestSTREAM_MS + aiatestPAUSE_MS;
+    }
+    pxResult->ulFirstAudioMs /= aiatestSTREAMS;
+}
+
+static void prvCompare( uint32_t ulStallPercent )
+{
+    TestPlayoutResult_t xFixed;
+    TestPlayoutResult_t xAdaptive;
+
+    prvRunTraces( ulStallPercent, 0, &xFixed );
+    prvRunTraces( ulStallPercent, aiaconfigCLIENT_PLAYOUT_MAX_PREBUFFER_MS, &xAdaptive );
+
+    printf( "%u%% stalls over %u streams: fixed %u underruns, first audio %u ms; adaptive %u underruns, "
+            "first audio %u ms, target up to %u ms, %u threshold changes\n",
+            ulStallPercent, aiatestSTREAMS, xFixed.ulUnderruns, xFixed.ulFirstAudioMs, xAdaptive.ulUnderruns,
+            xAdaptive.ulFirstAudioMs, xAdaptive.ulMaxTargetMs, xAdaptive.ulProposals );
+
+    if( ulStallPercent == 0 )
+    {
+        vTestCheck( xAdaptive.ulUnderruns == 0 && xAdaptive.ulFirstAudioMs == xFixed.ulFirstAudioMs &&
+                    xAdaptive.ulMaxTargetMs == 0 && xAdaptive.ulProposals == 0,
+                    "on a good link the controller holds nothing and changes nothing" );
+    }
+    else
+    {
+        vTestCheck( xAdaptive.ulUnderruns < xFixed.ulUnderruns, "with %u%% stalls the controller underruns less",
+                    ulStallPercent );
+        vTestCheck( xAdaptive.ulMaxTargetMs <= aiaconfigCLIENT_PLAYOUT_MAX_PREBUFFER_MS, "the target stays within its cap" );
+    }
+}
+
+static void prvCheckProposals( void )
+{
+    static AIAPlayout_t xPlayout;
+    uint32_t ulArrival[ aiatestMESSAGES ];
+    uint32_t ulOverrunWarning, ulUnderrunWarning;
+    uint32_t ulProposedOverrunWarning, ulProposedUnderrunWarning;
+    TestPlayoutResult_t xResult = { 0 };
+    BaseType_t xProposed;
+
+    vAIAPlayoutInit( &xPlayout, aiatestBYTES_PER_SECOND, aiaconfigCLIENT_SPEAKER_BUFFER_SIZE,
+                     aiaconfigCLIENT_SPEAKER_BUFFER_OVERRUN_WARNING, aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING,
+                     aiaconfigCLIENT_PLAYOUT_MAX_PREBUFFER_MS );
+
+    /* A stream whose every message is 500ms late. */
+    for( uint32_t k = 0; k < aiatestMESSAGES; k++ )
+    {
+        ulArrival[ k ] = ( k == 0 ) ? 0 : k * aiatestMESSAGE_MS + 500U;
+        vAIAPlayoutArrival( &xPlayout, ( uint64_t )k * aiatestMESSAGE_BYTES, ulArrival[ k ] );
+    }
+    xProposed = xAIAPlayoutStreamEnd( &xPlayout, ( uint64_t )aiatestMESSAGES * aiatestMESSAGE_BYTES );
+    vAIAPlayoutGetThresholds( &xPlayout, &ulOverrunWarning, &ulUnderrunWarning );
+    vAIAPlayoutGetProposedThresholds( &xPlayout, &ulProposedOverrunWarning, &ulProposedUnderrunWarning );
+    vTestCheck( xProposed == pdTRUE && ulProposedUnderrunWarning > ulUnderrunWarning &&
+                ulUnderrunWarning == aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING,
+                "a late stream proposes thresholds, %u and %u bytes, and the configured ones stay in use",
+                ulProposedOverrunWarning, ulProposedUnderrunWarning );
+
+    prvPlay( &xPlayout, ulArrival, 10000, ( uint64_t )aiatestMESSAGES * aiatestMESSAGE_BYTES, &xResult );
+    vTestCheck( xResult.ulProposals == 0, "nothing more is proposed while a proposal waits" );
+
+    vTestCheck( xAIAPlayoutAcknowledge( &xPlayout, pdFALSE ) == pdTRUE && xAIAPlayoutAcknowledge( &xPlayout, pdFALSE ) == pdFALSE,
+                "a rejection settles the proposal, once" );
+    vAIAPlayoutGetThresholds( &xPlayout, &ulOverrunWarning, &ulUnderrunWarning );
+    vTestCheck( ulUnderrunWarning == aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING &&
+                ulOverrunWarning == aiaconfigCLIENT_SPEAKER_BUFFER_OVERRUN_WARNING, "the thresholds rejected are not used" );
+
+    xProposed = xAIAPlayoutStreamEnd( &xPlayout, ( uint64_t )aiatestMESSAGES * aiatestMESSAGE_BYTES );
+    vTestCheck( xProposed == pdFALSE, "a stream that never started proposes nothing" );
+    for( uint32_t k = 0; k < aiatestMESSAGES; k++ )
+    {
+        vAIAPlayoutArrival( &xPlayout, ( uint64_t )( 2U * aiatestMESSAGES + k ) * aiatestMESSAGE_BYTES, 20000U + ulArrival[ k ] );
+    }
+    xProposed = xAIAPlayoutStreamEnd( &xPlayout, ( uint64_t )3U * aiatestMESSAGES * aiatestMESSAGE_BYTES );
+    ( void )xAIAPlayoutAcknowledge( &xPlayout, pdTRUE );
+    vAIAPlayoutGetThresholds( &xPlayout, &ulOverrunWarning, &ulUnderrunWarning );
+    vTestCheck( xProposed == pdTRUE && ulOverrunWarning == ulProposedOverrunWarning &&
+                ulUnderrunWarning == ulProposedUnderrunWarning,
+                "the next late stream proposes them again, and once accepted they are used" );
+}
+
+/* An answer whose messages come in at half the pace of the audio, so that the stream is late. */
+static BaseType_t prvLateAnswer( uint32_t ulAnswer )
+{
+    static uint64_t ullOffset = 0;
+    char cDirectives[ 320 ];
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullOffset );
+    vAIAServiceSendDirectives( cDirectives );
+    vAIAServiceSendSpeaker( ullOffset, 20, 5, 2U * 5U * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    ullOffset += 20U * AIA_SPEAKER_DECODER_FRAME_SIZE;
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullOffset );
+    vAIAServiceSendDirectives( cDirectives );
+    if( xAIAServiceWaitForEvent( "SpeakerClosed", ulAnswer, 10000 ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"i\"},\"payload\":{\"state\":\"IDLE\"}}" );
+    /* Leave time for the capabilities round. */
+    vTestSleepMs( 500 );
+    return pdPASS;
+}
+
+static volatile uint32_t ulNotAccepted;
+static volatile uint32_t ulAccepted;
+
+/* The client reports how each proposal was settled, e.g. "Speaker buffer warnings at 8000 and 4000 bytes". */
+static void prvLogHook( const char * pcLine )
+{
+    if( strstr( pcLine, "Speaker buffer warnings at " ) != NULL )
+    {
+        if( strstr( pcLine, "not accepted" ) != NULL )
+        {
+            ulNotAccepted++;
+        }
+        else
+        {
+            ulAccepted++;
+        }
+    }
+}
+
+static void prvCheckClient( void )
+{
+    AIAServiceStats_t xStats;
+
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostSetLogHook( prvLogHook, pdTRUE );
+
+    vAIAServiceSetAcceptCapabilities( pdFALSE );
+    vTestCheck( prvLateAnswer( 1 ), "a late answer plays" );
+    vAIAServiceStats( &xStats );
+    vTestCheck( xStats.ulCapabilitiesRejected == 1 && xStats.ulUnderrunWarningThreshold > aiaconfigCLIENT_SPEAKER_BUFFER_UNDERRUN_WARNING &&
+                ulNotAccepted == 1 && ulAccepted == 0,
+                "its thresholds are proposed, at %u bytes to underrun, rejected and not used", xStats.ulUnderrunWarningThreshold );
+
+    vAIAServiceSetAcceptCapabilities( pdTRUE );
+    vTestCheck( prvLateAnswer( 2 ), "another late answer plays" );
+    vAIAServiceStats( &xStats );
+    vTestCheck( xStats.ulCapabilitiesAccepted == 2 && ulAccepted == 1 && ulNotAccepted == 1,
+                "its thresholds are proposed again, accepted and used" );
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", NULL };
+
+    vTestLogOnly( pcPatterns );
+
+    prvCompare( 0 );
+    prvCompare( 8 );
+    prvCompare( 15 );
+    prvCheckProposals();
+    prvCheckClient();
+
+    return lTestResult();
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Loopback of xAIAMqttSerializer. Messages of many lengths, around those where the MQTT remaining length takes one
+ * more byte, are published through the MQTT stand-in, which parses each packet back as a broker would. Encrypted
+ * messages are decrypted with lAIACryptoDecrypt() and compared with what was sent, clear ones byte for byte.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_publish.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestTOPIC                        "aia/loopback"
+#define aiatestMAX_MESSAGE                  ( 20000U )
+
+static AIACrypto_t xCrypto;
+static uint8_t ucReceived[ sizeof( AIAMessage_t ) + AIA_MSG_PARAMS_SIZE_SEQ + aiatestMAX_MESSAGE ];
+static size_t xReceivedLength;
+static BaseType_t xTopicMatched;
+
+static void prvBroker( const char * pcTopic, size_t xTopicLength, const uint8_t * pucPayload, size_t xLength )
+{
+    xTopicMatched = ( xTopicLength == strlen( aiatestTOPIC ) && memcmp( pcTopic, aiatestTOPIC, xTopicLength ) == 0 ) ? pdTRUE : pdFALSE;
+    xReceivedLength = ( xLength <= sizeof( ucReceived ) ) ? xLength : 0;
+    memcpy( ucReceived, pucPayload, xReceivedLength );
+}
+
+static IotMqttError_t prvPublish( IotMqttConnection_t xConnection, AIAPublishPayload_t * pxPayload, size_t xWireLength )
+{
+    IotMqttPublishInfo_t xInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+
+    xInfo.pTopicName = aiatestTOPIC;
+    xInfo.topicNameLength = strlen( aiatestTOPIC );
+    xInfo.pPayload = pxPayload;
+    xInfo.payloadLength = xWireLength;
+    xReceivedLength = 0;
+    return IotMqtt_Publish( xConnection, &xInfo, 0, NULL, NULL );
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+    static const uint32_t ulLengths[] = { 0, 1, 2, 50, 85, 86, 87, 88, 89, 90, 91, 92, 93, 125, 126, 127, 128, 129,
+                                          1000, 5400, 16300, 16330, 16331, 16332, 16333, 16334, 16346, 16347,
+                                          16348, 16349, aiatestMAX_MESSAGE };
+    static uint8_t ucBuffer[ AIA_MSG_PARAMS_SIZE_SEQ + aiatestMAX_MESSAGE ];
+    static uint8_t ucDecrypted[ AIA_MSG_PARAMS_SIZE_SEQ + aiatestMAX_MESSAGE ];
+    AIACryptoKeys_t xKeys = {
+        .client_public_key = aiaconfigCLIENT_PUBLIC_KEY,
+        .client_private_key = aiaconfigCLIENT_PRIVATE_KEY,
+        .peer_public_key = aiaconfigPEER_PUBLIC_KEY,
+    };
+    IotMqttNetworkInfo_t xNetworkInfo = IOT_MQTT_NETWORK_INFO_INITIALIZER;
+    IotMqttConnection_t xConnection;
+    uint8_t * pucMessage = ucBuffer + AIA_MSG_PARAMS_SIZE_SEQ;
+    uint32_t ulEncryptedOk = 0;
+    uint32_t ulClearOk = 0;
+    HostHeapStats_t xHeap;
+
+    vTestLogOnly( pcErrors );
+    vTestCheck( xAIACryptoInit( &xCrypto, &xKeys ) == eCryptoSuccess, "crypto is initialized" );
+    xNetworkInfo.pMqttSerializer = &xAIAMqttSerializer;
+    vTestCheck( IotMqtt_Connect( &xNetworkInfo, NULL, 1000, &xConnection ) == IOT_MQTT_SUCCESS, "MQTT connects" );
+    vHostMqttSetBroker( prvBroker );
+
+    for( uint32_t i = 0; i < sizeof( ucBuffer ) - AIA_MSG_PARAMS_SIZE_SEQ; i++ )
+    {
+        pucMessage[ i ] = ( uint8_t )( i * 7U + 3U );
+    }
+
+    for( size_t i = 0; i < sizeof( ulLengths ) / sizeof( ulLengths[ 0 ] ); i++ )
+    {
+        uint32_t ulLength = ulLengths[ i ];
+        AIAPublishPayload_t xEncrypted = { .pxCrypto = &xCrypto, .pvMessage = pucMessage, .ulMessageLength = ulLength, .ulSequence = 1000U + i };
+        AIAPublishPayload_t xClear = { .pxCrypto = NULL, .pvMessage = pucMessage, .ulMessageLength = ulLength };
+        int32_t lDecrypted;
+
+        /* The sequence number goes in front of the plaintext, so it must not be part of the comparison. */
+        if( prvPublish( xConnection, &xEncrypted, AIA_MSG_ENCRYPTED_LENGTH( ulLength ) ) == IOT_MQTT_SUCCESS &&
+            xTopicMatched == pdTRUE && xReceivedLength == AIA_MSG_ENCRYPTED_LENGTH( ulLength ) )
+        {
+            lDecrypted = lAIACryptoDecrypt( &xCrypto, ucDecrypted, ucReceived, xReceivedLength );
+            if( lDecrypted == ( int32_t )( AIA_MSG_PARAMS_SIZE_SEQ + ulLength ) &&
+                memcmp( ucDecrypted, &xEncrypted.ulSequence, AIA_MSG_PARAMS_SIZE_SEQ ) == 0 &&
+                memcmp( ucDecrypted + AIA_MSG_PARAMS_SIZE_SEQ, pucMessage, ulLength ) == 0 )
+            {
+                ulEncryptedOk++;
+            }
+            else
+            {
+                printf( "Encrypted message of %u bytes does not decrypt to what was sent\n", ulLength );
+            }
+        }
+        else
+        {
+            printf( "Encrypted message of %u bytes is not received whole\n", ulLength );
+        }
+
+        if( prvPublish( xConnection, &xClear, ulLength ) == IOT_MQTT_SUCCESS &&
+            xTopicMatched == pdTRUE && xReceivedLength == ulLength && memcmp( ucReceived, pucMessage, ulLength ) == 0 )
+        {
+            ulClearOk++;
+        }
+        else
+        {
+            printf( "Clear message of %u bytes is not received as sent\n", ulLength );
+        }
+    }
+    vTestCheck( ulEncryptedOk == sizeof( ulLengths ) / sizeof( ulLengths[ 0 ] ), "%u encrypted messages of 0 to %u bytes go through", ulEncryptedOk, aiatestMAX_MESSAGE );
+    vTestCheck( ulClearOk == sizeof( ulLengths ) / sizeof( ulLengths[ 0 ] ), "%u clear messages of 0 to %u bytes go through", ulClearOk, aiatestMAX_MESSAGE );
+
+    /* The packet itself: flags, remaining length and topic, in a buffer of the pool. */
+    {
+        IotMqttPublishInfo_t xInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+        AIAPublishPayload_t xClear = { .pxCrypto = NULL, .pvMessage = pucMessage, .ulMessageLength = 200 };
+        uint8_t * pucPacket = NULL;
+        size_t xPacketSize = 0;
+        uint16_t usIdentifier;
+        uint8_t * pucIdentifierHigh;
+        size_t xRemaining = 2 + strlen( aiatestTOPIC ) + 200;
+
+        xInfo.retain = true;
+        xInfo.pTopicName = aiatestTOPIC;
+        xInfo.topicNameLength = strlen( aiatestTOPIC );
+        xInfo.pPayload = &xClear;
+        xInfo.payloadLength = 200;
+        vHostHeapStats( &xHeap );
+        vTestCheck( xAIAMqttSerializer.serialize.publish( &xInfo, &pucPacket, &xPacketSize, &usIdentifier, &pucIdentifierHigh ) == IOT_MQTT_SUCCESS &&
+                    pucPacket[ 0 ] == 0x31 &&
+                    pucPacket[ 1 ] == ( uint8_t )( ( xRemaining & 0x7F ) | 0x80 ) && pucPacket[ 2 ] == ( uint8_t )( xRemaining >> 7 ) &&
+                    xPacketSize == 3 + xRemaining &&
+                    memcmp( pucPacket + 5, aiatestTOPIC, strlen( aiatestTOPIC ) ) == 0 &&
+                    usIdentifier == 0 && pucIdentifierHigh == NULL,
+                    "a retained PUBLISH packet is laid out as MQTT 3.1.1 requires" );
+        if( pucPacket != NULL )
+        {
+            vAIARecvPoolFree( pucPacket );
+        }
+        {
+            HostHeapStats_t xAfter;
+
+            vHostHeapStats( &xAfter );
+            vTestCheck( xAfter.ulAllocations == xHeap.ulAllocations, "the packet comes from the pool" );
+        }
+
+        xInfo.qos = IOT_MQTT_QOS_1;
+        vTestCheck( xAIAMqttSerializer.serialize.publish( &xInfo, &pucPacket, &xPacketSize, &usIdentifier, &pucIdentifierHigh ) == IOT_MQTT_BAD_PARAMETER,
+                    "QoS 1 is rejected" );
+    }
+
+    return lTestResult();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Heap allocations of the MQTT packet buffers during playback, counted by ulAIARecvPoolHeapAllocations() and by the
+ * heap itself. Built twice: test_recvpool with the pool of the configuration, which must not touch the heap, and
+ * test_recvpool_heap with aiaconfigAIA_RECEIVE_POOL_BUFFERS at 0, i.e. every packet from the heap as before the pool.
+ * Both print the measured rate. The counter must match the heap in both, and must not count an allocation the heap
+ * refuses.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestREPLY_FRAMES                 ( 250U )
+
+static uint32_t prvNowMs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint32_t )( xNow.tv_sec * 1000U + xNow.tv_nsec / 1000000L );
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+    HostHeapStats_t xBefore;
+    HostHeapStats_t xAfter;
+    uint32_t ulCountedBefore;
+    uint32_t ulCounted;
+    uint32_t ulMs;
+    uint32_t ulPerSecondX100;
+
+    vTestLogOnly( pcErrors );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects, with %lu pool buffers",
+                ( unsigned long )aiaconfigAIA_RECEIVE_POOL_BUFFERS );
+    vTestCheck( xTestTap( 5000 ), "the microphone opens" );
+
+    vHostHeapStats( &xBefore );
+    ulCountedBefore = ulAIARecvPoolHeapAllocations();
+    ulMs = prvNowMs();
+    vTestCheck( xAIAServiceConverse( 500, aiatestREPLY_FRAMES, 15000 ), "an utterance and a reply of %u ms",
+                aiatestREPLY_FRAMES * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    ulMs = prvNowMs() - ulMs;
+    vHostHeapStats( &xAfter );
+    ulCounted = ulAIARecvPoolHeapAllocations() - ulCountedBefore;
+
+    ulPerSecondX100 = ( uint32_t )( ( uint64_t )ulCounted * 100000U / ulMs );
+    printf( "MQTT buffers: %u heap allocations in %u ms, %u.%02u per second\n",
+            ulCounted, ulMs, ulPerSecondX100 / 100, ulPerSecondX100 % 100 );
+
+    /* Nothing else in the client allocates once connected, see test_heapcap. */
+    vTestCheck( ulCounted == xAfter.ulAllocations - xBefore.ulAllocations,
+                "the counter matches the %u allocations of the heap", xAfter.ulAllocations - xBefore.ulAllocations );
+#if ( aiaconfigAIA_RECEIVE_POOL_BUFFERS > 0 )
+    vTestCheck( ulCounted == 0, "the pool keeps MQTT off the heap" );
+#else
+    vTestCheck( ulCounted > 0, "without the pool every packet is allocated" );
+#endif
+
+    /* A message the heap has no room for is dropped by MQTT, and must not be counted. The IDLE directive that ends
+     * the conversation is let through first, so that the cap leaves no room at all.
+     */
+    vTestSleepMs( 300 );
+    vHostHeapStats( &xBefore );
+    ulCountedBefore = ulAIARecvPoolHeapAllocations();
+    vHostSetHeapCap( xBefore.xUsed );
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":50}}" );
+    vTestSleepMs( 200 );
+    vHostSetHeapCap( 0 );
+    vHostHeapStats( &xAfter );
+#if ( aiaconfigAIA_RECEIVE_POOL_BUFFERS == 0 )
+    vTestCheck( xAfter.ulFailures > xBefore.ulFailures, "the heap refuses the packet" );
+#endif
+    vTestCheck( ulAIARecvPoolHeapAllocations() == ulCountedBefore + ( xAfter.ulAllocations - xBefore.ulAllocations ),
+                "a refused allocation is not counted" );
+
+    return lTestResult();
+}
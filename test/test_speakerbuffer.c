@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* aia_speakerbuffer.c on its own, written to as the MQTT task does while the speaker is closed. Each message carries
+ * the offset of its audio and bytes that follow from it. The buffer is overfilled with messages of varying lengths:
+ * the messages kept must be the newest ones, as many as fit, with their offsets following on to the last one written.
+ * A message copied by the reader, as decode-ahead does, and dropped before it is read, must not be read: the next
+ * read gets the oldest message kept. Then a reader task reads while the buffer is overfilled, and must read whole
+ * messages in order, which with those dropped and those left account for every message written. The cycles taken
+ * to write a message, old ones dropped, are printed, along with the worst case: a buffer full of the shortest
+ * messages, all dropped for the longest.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_speakerbuffer.h"
+#include "aia_client_priv.h"
+#include "aia_test.h"
+#include "semphr.h"
+#include "task.h"
+
+#define aiatestBUFFER_SIZE                  ( 4096U )
+#define aiatestLENGTH_SIZE                  ( sizeof( uint32_t ) )
+#define aiatestOFFSET_SIZE                  ( sizeof( uint64_t ) )
+#define aiatestMAX_PAYLOAD                  ( 300U )
+#define aiatestOVERFILL_MESSAGES            ( 200U )
+#define aiatestREADER_MESSAGES              ( 20000U )
+
+static AIASpeakerBuffer_t xBuffer;
+static AIACycleMeter_t xMeter;
+static uint32_t ulMostDropped;
+static uint64_t ullNextOffset;
+static uint32_t ulNextLength;
+
+/* The reader task. */
+static SemaphoreHandle_t xReaderDone;
+static volatile BaseType_t xWriterDone;
+static volatile uint32_t ulRead;
+static volatile uint32_t ulBadMessages;
+static volatile uint32_t ulOutOfOrder;
+
+static uint32_t prvPayloadLength( uint32_t ulMessage )
+{
+    return 40U + ( ulMessage * 37U ) % ( aiatestMAX_PAYLOAD - 40U );
+}
+
+/* Write the next message, old ones dropped if needed. Returns the number dropped. */
+static uint32_t prvWrite( uint32_t ulPayload )
+{
+    uint8_t ucMessage[ aiatestOFFSET_SIZE + aiatestBUFFER_SIZE ];
+    uint32_t ulDropped;
+    size_t xWritten;
+
+    memcpy( ucMessage, &ullNextOffset, aiatestOFFSET_SIZE );
+    for( uint32_t i = 0; i < ulPayload; i++ )
+    {
+        ucMessage[ aiatestOFFSET_SIZE + i ] = ( uint8_t )( ullNextOffset + i );
+    }
+
+    vAIACycleMeterStart( &xMeter );
+    xWritten = xAIASpeakerBufferSendDropOldest( &xBuffer, ucMessage, aiatestOFFSET_SIZE + ulPayload, &ulDropped );
+    vAIACycleMeterStop( &xMeter );
+
+    configASSERT( xWritten == aiatestOFFSET_SIZE + ulPayload );
+    ulMostDropped = ( ulDropped > ulMostDropped ) ? ulDropped : ulMostDropped;
+    ullNextOffset += ulPayload;
+
+    return ulDropped;
+}
+
+/* The offset of a message read, or UINT64_MAX if its bytes do not follow from it. */
+static uint64_t prvCheck( const uint8_t * pucMessage, size_t xLength )
+{
+    uint64_t ullOffset;
+
+    if( xLength < aiatestOFFSET_SIZE )
+    {
+        return UINT64_MAX;
+    }
+    memcpy( &ullOffset, pucMessage, aiatestOFFSET_SIZE );
+    for( size_t i = aiatestOFFSET_SIZE; i < xLength; i++ )
+    {
+        if( pucMessage[ i ] != ( uint8_t )( ullOffset + i - aiatestOFFSET_SIZE ) )
+        {
+            return UINT64_MAX;
+        }
+    }
+    ulNextLength = ( uint32_t )( xLength - aiatestOFFSET_SIZE );
+
+    return ullOffset;
+}
+
+static void prvReaderTask( void * pvParameters )
+{
+    static uint8_t ucMessage[ aiatestOFFSET_SIZE + aiatestMAX_PAYLOAD ];
+    uint64_t ullLast = 0;
+    uint64_t ullOffset;
+    size_t xLength;
+
+    ( void )pvParameters;
+    for( ; ; )
+    {
+        xLength = xAIASpeakerBufferReceive( &xBuffer, ucMessage, sizeof( ucMessage ), pdMS_TO_TICKS( 100 ) );
+        if( xLength == 0 )
+        {
+            if( xWriterDone == pdTRUE && xAIASpeakerBufferBytesAvailable( &xBuffer ) == 0 )
+            {
+                break;
+            }
+            continue;
+        }
+        ullOffset = prvCheck( ucMessage, xLength );
+        if( ullOffset == UINT64_MAX )
+        {
+            ulBadMessages++;
+        }
+        else if( ulRead > 0 && ullOffset <= ullLast )
+        {
+            ulOutOfOrder++;
+        }
+        ullLast = ullOffset;
+        ulRead++;
+    }
+    xSemaphoreGive( xReaderDone );
+    vTaskDelete( NULL );
+}
+
+static void prvReport( const char * pcName )
+{
+    printf( "%s: %u cycles on average to write a message, %u at most, %u messages dropped at most at once\n", pcName,
+            ulAIACycleMeterAverage( &xMeter ), xMeter.ulMax, ulMostDropped );
+    vAIACycleMeterReset( &xMeter );
+    ulMostDropped = 0;
+}
+
+int main( void )
+{
+    static const char * const pcErrors[] = { "Failed", "failed", NULL };
+    static uint8_t ucMessage[ aiatestBUFFER_SIZE ];
+    uint64_t ullExpected;
+    uint64_t ullPeeked;
+    uint32_t ulDropped = 0;
+    uint32_t ulKept = 0;
+    uint32_t ulBad = 0;
+    uint32_t ulFirstKept;
+    size_t xLength;
+
+    vTestLogOnly( pcErrors );
+    vTestCheck( xAIASpeakerBufferInit( &xBuffer, aiatestBUFFER_SIZE ) == pdPASS, "the buffer is allocated" );
+    vTestCheck( xAIASpeakerBufferSendDropOldest( &xBuffer, ucMessage, aiatestBUFFER_SIZE, &ulDropped ) == 0 &&
+                ulDropped == 0, "a message longer than the buffer is not written" );
+
+    /* Overfilled, with no reader. */
+    for( uint32_t m = 0; m < aiatestOVERFILL_MESSAGES; m++ )
+    {
+        ulDropped += prvWrite( prvPayloadLength( m ) );
+    }
+    prvReport( "overfilled" );
+    ulFirstKept = ulDropped;
+    ullExpected = 0;
+    for( uint32_t m = 0; m < ulFirstKept; m++ )
+    {
+        ullExpected += prvPayloadLength( m );
+    }
+    while( ( xLength = xAIASpeakerBufferReceive( &xBuffer, ucMessage, sizeof( ucMessage ), 0 ) ) != 0 )
+    {
+        ulBad += ( prvCheck( ucMessage, xLength ) != ullExpected ) ? 1U : 0U;
+        ullExpected += ulNextLength;
+        ulKept++;
+    }
+    printf( "%u messages written, %u dropped, %u kept\n", aiatestOVERFILL_MESSAGES, ulDropped, ulKept );
+    vTestCheck( ulDropped > 0 && ulDropped + ulKept == aiatestOVERFILL_MESSAGES && ulBad == 0 &&
+                ullExpected == ullNextOffset, "the newest messages are kept whole, their offsets following on to the end" );
+    {
+        uint32_t ulBytes = 0;
+
+        for( uint32_t m = ulFirstKept - 1U; m < aiatestOVERFILL_MESSAGES; m++ )
+        {
+            ulBytes += aiatestLENGTH_SIZE + aiatestOFFSET_SIZE + prvPayloadLength( m );
+        }
+        vTestCheck( ulBytes > aiatestBUFFER_SIZE, "no more messages are dropped than needed" );
+    }
+
+    /* The oldest message is copied out, then dropped before it is read. */
+    for( uint32_t m = 0; m < 4U; m++ )
+    {
+        ( void )prvWrite( prvPayloadLength( m ) );
+    }
+    ullPeeked = prvCheck( ucMessage, xAIASpeakerBufferPeek( &xBuffer, ucMessage, sizeof( ucMessage ), 0 ) );
+    ulDropped = 0;
+    while( ulDropped == 0 )
+    {
+        ulDropped = prvWrite( aiatestMAX_PAYLOAD );
+    }
+    ullExpected = ullPeeked;
+    for( uint32_t m = 0; m < ulDropped; m++ )
+    {
+        ullExpected += prvPayloadLength( m );
+    }
+    xLength = xAIASpeakerBufferReceive( &xBuffer, ucMessage, sizeof( ucMessage ), 0 );
+    vTestCheck( prvCheck( ucMessage, xLength ) == ullExpected && ullExpected != ullPeeked,
+                "a message copied out and then dropped is not read, the oldest one kept is" );
+    while( xAIASpeakerBufferReceive( &xBuffer, ucMessage, sizeof( ucMessage ), 0 ) != 0 )
+    {
+    }
+
+    /* The worst case: the buffer full of the shortest messages, all dropped for the longest one. */
+    for( uint32_t m = 0; xAIASpeakerBufferBytesAvailable( &xBuffer ) + aiatestLENGTH_SIZE + aiatestOFFSET_SIZE <= aiatestBUFFER_SIZE; m++ )
+    {
+        ( void )prvWrite( 0 );
+    }
+    vAIACycleMeterReset( &xMeter );
+    ulDropped = prvWrite( aiatestBUFFER_SIZE - aiatestLENGTH_SIZE - aiatestOFFSET_SIZE );
+    prvReport( "worst case" );
+    vTestCheck( ulDropped == aiatestBUFFER_SIZE / ( aiatestLENGTH_SIZE + aiatestOFFSET_SIZE ),
+                "%u shortest messages are dropped at once for the longest", ulDropped );
+    while( xAIASpeakerBufferReceive( &xBuffer, ucMessage, sizeof( ucMessage ), 0 ) != 0 )
+    {
+    }
+
+    /* Overfilled while a reader task reads. */
+    xReaderDone = xSemaphoreCreateBinary();
+    xTaskCreate( prvReaderTask, "Reader", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+    ulDropped = 0;
+    for( uint32_t m = 0; m < aiatestREADER_MESSAGES; m++ )
+    {
+        ulDropped += prvWrite( prvPayloadLength( m ) );
+        if( m % 64U == 0 )
+        {
+            vTestSleepMs( 1 );
+        }
+    }
+    xWriterDone = pdTRUE;
+    vTestCheck( xSemaphoreTake( xReaderDone, pdMS_TO_TICKS( 5000 ) ) == pdPASS, "the reader reads what is left" );
+    prvReport( "with a reader" );
+    printf( "%u messages written, %u dropped, %u read\n", aiatestREADER_MESSAGES, ulDropped, ulRead );
+    vTestCheck( ulBadMessages == 0 && ulOutOfOrder == 0, "the reader reads whole messages in order" );
+    vTestCheck( ulDropped + ulRead == aiatestREADER_MESSAGES, "each message is either dropped or read" );
+
+    return lTestResult();
+}
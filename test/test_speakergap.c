@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* A /speaker message that never comes, with the resequencing buffer full behind it. The next message is beyond the
+ * resequencing range and dropped, and as the speaker is closed the missing message is given up on once the gap has
+ * waited. When the dropped message comes again, the messages held must be played from the lowest one, and only the
+ * frames of the missing message left out.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAMES_PER_MESSAGE           ( 10U )
+#define aiatestMESSAGES_BEFORE              ( 2U )
+/* The missing message, then those held behind it, then the one beyond the resequencing range. */
+#define aiatestMISSING                      ( aiatestMESSAGES_BEFORE )
+#define aiatestHELD                         ( aiatestMISSING + 1U )
+#define aiatestBEYOND                       ( aiatestHELD + aiaconfigAIA_SPEAKER_RESEQUENCING )
+#define aiatestFRAMES                       ( ( aiatestBEYOND + 1U ) * aiatestFRAMES_PER_MESSAGE )
+
+/* The frame values played, in the 10ms transfers of the speaker DMA. */
+static volatile uint8_t ucPlayed[ aiatestFRAMES + 2U ];
+static volatile BaseType_t xReported;
+
+static void prvSpeakerSink( const int16_t * psSamples, size_t xSamples, size_t xBytesRead )
+{
+    uint32_t ulValue = ( uint32_t )( uint16_t )psSamples[ 0 ];
+
+    ( void )xSamples;
+    if( xBytesRead != 0 && ulValue < sizeof( ucPlayed ) )
+    {
+        ucPlayed[ ulValue ] = 1;
+    }
+}
+
+static void prvLogHook( const char * pcLine )
+{
+    if( strstr( pcLine, "lost 1 of 1 messages" ) != NULL )
+    {
+        xReported = pdTRUE;
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+/* Send the frames of messages ulFirst to ulLast, counted from the first of the answer. */
+static void prvSendMessages( uint32_t ulFirst, uint32_t ulLast )
+{
+    vAIAServiceSendSpeaker( ( uint64_t )ulFirst * aiatestFRAMES_PER_MESSAGE * AIA_SPEAKER_DECODER_FRAME_SIZE,
+                            ( ulLast - ulFirst + 1U ) * aiatestFRAMES_PER_MESSAGE, aiatestFRAMES_PER_MESSAGE, 0 );
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", NULL };
+    AIAServiceStats_t xStats;
+    char cDirectives[ 384 ];
+    uint32_t ulFirstSequence;
+    uint32_t ulMissed = 0;
+    uint32_t ulPlayedFromMissing = 0;
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vHostPlatformSetSpeakerSink( prvSpeakerSink );
+    /* At 128, the speaker plays the samples as decoded. */
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetVolume\",\"messageId\":\"v\"},\"payload\":{\"volume\":128}}" );
+    vTestCheck( xAIAServiceWaitForEvent( "VolumeChanged", 1, 2000 ), "the volume is set" );
+
+    vAIAServiceStats( &xStats );
+    ulFirstSequence = xStats.ulSpeakerSequence;
+    prvSendMessages( 0, aiatestMISSING - 1U );
+    vAIAServiceSkipSpeakerSequence( ulFirstSequence + aiatestHELD );
+    prvSendMessages( aiatestHELD, aiatestBEYOND );
+    vTestSleepMs( aiaconfigCLIENT_SPEAKER_GAP_WAIT_MS * 2U );
+
+    /* Everything from the message dropped on comes again. */
+    vAIAServiceSkipSpeakerSequence( ulFirstSequence + aiatestBEYOND );
+    prvSendMessages( aiatestBEYOND, aiatestBEYOND );
+    vTestSleepMs( 100 );
+    vTestCheck( xReported, "the missing message alone is given up on" );
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":0}},"
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )aiatestFRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 1, 10000 ), "the speaker plays to CloseSpeaker and closes" );
+    vTestSleepMs( 100 );
+
+    for( uint32_t f = 0; f < aiatestFRAMES; f++ )
+    {
+        BaseType_t xMissing = ( f / aiatestFRAMES_PER_MESSAGE == aiatestMISSING );
+
+        if( xMissing == pdTRUE )
+        {
+            ulPlayedFromMissing += ucPlayed[ f + 1U ];
+        }
+        else if( ucPlayed[ f + 1U ] == 0 )
+        {
+            ulMissed++;
+        }
+    }
+    printf( "%u frames sent in %u messages, message %u missing: %u other frames not played\n", aiatestFRAMES,
+            aiatestBEYOND + 1U, aiatestMISSING, ulMissed );
+    vTestCheck( ulMissed == 0, "every frame held behind the missing message is played" );
+    vTestCheck( ulPlayedFromMissing == 0, "nothing of the missing message is played" );
+
+    return lTestResult();
+}
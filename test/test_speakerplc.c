@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Concealment of late speaker audio. A message is late with the one after it already come, so the stream is known to
+ * go on: frames are concealed in its place once what has been decoded runs out, and as many of its frames dropped
+ * when it comes. Then the audio runs out with nothing known to follow, and nothing is concealed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestFRAMES_PER_MESSAGE           ( 5U )
+#define aiatestMESSAGES                     ( 4U )
+/* The message that comes late, after the one following it. */
+#define aiatestLATE                         ( 2U )
+#define aiatestFRAMES                       ( aiatestMESSAGES * aiatestFRAMES_PER_MESSAGE )
+
+static volatile uint32_t ulNoData;
+
+static void prvLogHook( const char * pcLine )
+{
+    if( strstr( pcLine, "No data in the speaker buffer" ) != NULL )
+    {
+        ulNoData++;
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+/* Send the frames of messages ulFirst to ulLast, counted from the first of the answer. */
+static void prvSendMessages( uint32_t ulFirst, uint32_t ulLast )
+{
+    vAIAServiceSendSpeaker( ( uint64_t )ulFirst * aiatestFRAMES_PER_MESSAGE * AIA_SPEAKER_DECODER_FRAME_SIZE,
+                            ( ulLast - ulFirst + 1U ) * aiatestFRAMES_PER_MESSAGE, aiatestFRAMES_PER_MESSAGE, 0 );
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", NULL };
+    HostOpusStats_t xBefore, xLate, xAfter;
+    AIAServiceStats_t xStats;
+    char cDirectives[ 256 ];
+    uint32_t ulFirstSequence;
+    uint32_t ulConcealed;
+    uint32_t ulNoDataIdle;
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+                               "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":0}}" );
+    vTestSleepMs( 50 );
+
+    vHostOpusStats( &xBefore );
+    vAIAServiceStats( &xStats );
+    ulFirstSequence = xStats.ulSpeakerSequence;
+    prvSendMessages( 0, aiatestLATE - 1U );
+    vAIAServiceSkipSpeakerSequence( ulFirstSequence + aiatestLATE + 1U );
+    prvSendMessages( aiatestLATE + 1U, aiatestLATE + 1U );
+    vTestSleepMs( aiatestLATE * aiatestFRAMES_PER_MESSAGE * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS +
+                  ( aiaconfigCLIENT_SPEAKER_PLC_MAX_FRAMES + 2U ) * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    vHostOpusStats( &xLate );
+    ulConcealed = xLate.ulConcealed - xBefore.ulConcealed;
+    vTestCheck( ulConcealed > 0 && ulConcealed <= aiaconfigCLIENT_SPEAKER_PLC_MAX_FRAMES,
+                "frames are concealed while the message is late, %u", ulConcealed );
+
+    vAIAServiceSkipSpeakerSequence( ulFirstSequence + aiatestLATE );
+    prvSendMessages( aiatestLATE, aiatestLATE );
+    vTestSleepMs( ( aiatestFRAMES_PER_MESSAGE + 2U ) * aiaconfigCLIENT_SPEAKER_FRAME_DURATION_MS );
+    vHostOpusStats( &xAfter );
+    vTestCheck( xAfter.ulDecoded - xLate.ulDecoded == 2U * aiatestFRAMES_PER_MESSAGE - ulConcealed,
+                "as many frames of the late message are dropped, %u decoded",
+                xAfter.ulDecoded - xLate.ulDecoded );
+
+    /* The stream has run out, and nothing says that it goes on. */
+    ulNoDataIdle = ulNoData;
+    vTestSleepMs( 500 );
+    vHostOpusStats( &xAfter );
+    vTestCheck( xAfter.ulConcealed == xLate.ulConcealed, "nothing is concealed once the known audio has played" );
+    printf( "%u frames concealed, speaker task woken %u times in 500 ms of silence\n", ulConcealed,
+            ulNoData - ulNoDataIdle );
+    vTestCheck( ulNoData - ulNoDataIdle <= 1U, "the speaker task does not poll while the speaker buffer is empty" );
+
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )aiatestFRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE );
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", 1, 5000 ), "the speaker closes" );
+
+    return lTestResult();
+}
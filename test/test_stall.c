@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Microphone audio dropped under network stalls, injected by the client itself with
+ * aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS on every aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_INTERVAL-th microphone
+ * message. Built with the default configuration, with the low-memory profile, and with the low-memory profile and
+ * more spare capture slots. Prints the audio dropped, and checks that none is dropped when the spare slots hold as
+ * much audio as a stall lasts, as aia_client_config.h says, and that some is when they do not.
+ */
+
+#include <stdio.h>
+
+#include "aia_capture.h"
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestUTTERANCE_MS                 ( 4000U )
+
+/* Raw audio held by the spare slots. */
+#define aiatestSPARE_MS                     ( aiaconfigAIA_MICROPHONE_SPARE_SLOTS * aiaconfigAIA_AUDIO_DATA_SIZE / 32U )
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", "publish stalls", NULL };
+    AIAServiceStats_t xStats;
+    AIACaptureStatistics_t xCapture;
+    HostPlatformStats_t xPlatform;
+    uint32_t ulDroppedMs;
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects, with %u spare capture slots of %u ms",
+                ( uint32_t )aiaconfigAIA_MICROPHONE_SPARE_SLOTS, ( uint32_t )( aiaconfigAIA_AUDIO_DATA_SIZE / 32U ) );
+    vTestCheck( xTestTap( 5000 ), "the microphone opens" );
+    vTestCheck( xAIAServiceConverse( aiatestUTTERANCE_MS, 25, 20000 ), "an utterance of %u ms gets its reply", aiatestUTTERANCE_MS );
+
+    vAIAServiceStats( &xStats );
+    vAIACaptureGetStatistics( &xCapture );
+    vHostPlatformStats( &xPlatform );
+    ulDroppedMs = xCapture.ulDroppedFrames * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS;
+    printf( "%u ms of audio dropped under stalls of %u ms, with %u ms of spare slots, %u DMA frames discarded\n",
+            ulDroppedMs, ( uint32_t )aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS, ( uint32_t )aiatestSPARE_MS,
+            xPlatform.ulMicrophoneDiscarded );
+    vTestCheck( ulTestLogMatches() >= 1, "the client reports the stalls" );
+    if( aiatestSPARE_MS > aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS )
+    {
+        vTestCheck( ulDroppedMs == 0, "spare slots of %u ms ride out stalls of %u ms", ( uint32_t )aiatestSPARE_MS,
+                    ( uint32_t )aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS );
+    }
+    else
+    {
+        vTestCheck( ulDroppedMs != 0, "spare slots of %u ms do not ride out stalls of %u ms", ( uint32_t )aiatestSPARE_MS,
+                    ( uint32_t )aiaconfigDEBUG_MICROPHONE_PUBLISH_DELAY_MS );
+    }
+    vTestCheck( xStats.ulDecryptFailures == 0 && xStats.ulSequenceErrors == 0, "the stream decrypts in sequence" );
+
+    return lTestResult();
+}
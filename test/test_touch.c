@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Touch to first captured sample, through the scan and interrupt path of host/platform_host.c: a scan every 10ms,
+ * completed from the CapSense interrupt, and a touch-down debounced over 3 scans. Each touch comes at a random point
+ * of the scan interval and of the capture frame, is held for aiatestHOLD_MS and gets a short conversation. The
+ * latency from the touch to the first sample of the utterance is measured here, from the cycle count of the first
+ * frame the capture keeps, and printed as a histogram.
+ *
+ * With aiaconfigCLIENT_TOUCH_GESTURES the microphone opens on touch-down, so every latency must stay within the
+ * scan interval, the debounce and a frame, and the client must report its own latency from the scan that first saw
+ * the touch, which cannot be more. Without, the microphone opens on release, after the whole press.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_capture.h"
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestTOUCHES                      ( 12U )
+#define aiatestHOLD_MS                      ( 120U )
+#define aiatestBUCKET_MS                    ( 5U )
+#define aiatestBUCKETS                      ( 8U )
+/* The scan interval, the two more scans of the debounce, and the capture frame under way when the microphone opens,
+ * which the stream waits out.
+ */
+#define aiatestMAX_TOUCH_DOWN_MS            ( 3U * 10U + aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS )
+
+static volatile uint32_t ulReports;
+static volatile uint32_t ulReportedMaxMs;
+
+/* The DEBUG report of the client, e.g. "First sample captured 12 ms after touch-down". */
+static void prvLogHook( const char * pcLine )
+{
+    const char * pcReport = strstr( pcLine, "First sample captured " );
+
+    if( pcReport != NULL )
+    {
+        uint32_t ulMs = ( uint32_t )strtoul( pcReport + strlen( "First sample captured " ), NULL, 10 );
+
+        ulReportedMaxMs = ( ulMs > ulReportedMaxMs ) ? ulMs : ulReportedMaxMs;
+        ulReports++;
+    }
+}
+
+static BaseType_t prvWaitTouchEnabled( void )
+{
+    for( int i = 0; i < 500; i++ )
+    {
+        HostPlatformStats_t xStats;
+
+        vHostPlatformStats( &xStats );
+        if( xStats.xTouchEnabled == pdTRUE )
+        {
+            return pdPASS;
+        }
+        vTestSleepMs( 10 );
+    }
+    return pdFAIL;
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", NULL };
+    uint32_t ulHistogram[ aiatestBUCKETS ] = { 0 };
+    uint32_t ulMaxMs = 0;
+    uint32_t ulMinMs = UINT32_MAX;
+    uint32_t ulMeasured = 0;
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    srand( 1 );
+
+    for( uint32_t t = 0; t < aiatestTOUCHES; t++ )
+    {
+        AIACaptureStatistics_t xCapture;
+        uint32_t ulFirstFrameCycles;
+        uint32_t ulTouchCycles;
+        int32_t lLatencyCycles;
+        uint32_t ulLatencyMs;
+
+        if( prvWaitTouchEnabled() != pdPASS )
+        {
+            break;
+        }
+        vTestSleepMs( ( uint32_t )rand() % 20U );
+
+        vAIACaptureGetStatistics( &xCapture );
+        ulFirstFrameCycles = xCapture.ulFirstFrameCycles;
+        ulTouchCycles = ulPlatformGetCycleCount();
+        vHostTouch( pdTRUE );
+        vTestSleepMs( aiatestHOLD_MS );
+        vHostTouch( pdFALSE );
+
+        /* The capture does not restart again until the next touch. */
+        if( xAIAServiceConverse( 200, 5, 10000 ) != pdPASS )
+        {
+            break;
+        }
+        vAIACaptureGetStatistics( &xCapture );
+        if( xCapture.ulFirstFrameCycles == ulFirstFrameCycles )
+        {
+            break;
+        }
+
+        /* The first sample kept was captured a frame before its frame ended. */
+        lLatencyCycles = ( int32_t )( xCapture.ulFirstFrameCycles - ulTouchCycles -
+                                      configCPU_CLOCK_HZ / 1000UL * aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS );
+        ulLatencyMs = ( lLatencyCycles > 0 ) ? ( uint32_t )( ( uint64_t )lLatencyCycles * 1000UL / configCPU_CLOCK_HZ ) : 0;
+        ulHistogram[ ( ulLatencyMs / aiatestBUCKET_MS < aiatestBUCKETS ) ? ulLatencyMs / aiatestBUCKET_MS : aiatestBUCKETS - 1 ]++;
+        ulMaxMs = ( ulLatencyMs > ulMaxMs ) ? ulLatencyMs : ulMaxMs;
+        ulMinMs = ( ulLatencyMs < ulMinMs ) ? ulLatencyMs : ulMinMs;
+        ulMeasured++;
+    }
+
+    printf( "touch to first captured sample over %u touches of %u ms: %u to %u ms, %u ms buckets: %u %u %u %u %u %u %u %u\n",
+            ulMeasured, aiatestHOLD_MS, ulMinMs, ulMaxMs, aiatestBUCKET_MS, ulHistogram[ 0 ], ulHistogram[ 1 ],
+            ulHistogram[ 2 ], ulHistogram[ 3 ], ulHistogram[ 4 ], ulHistogram[ 5 ], ulHistogram[ 6 ], ulHistogram[ 7 ] );
+    vTestCheck( ulMeasured == aiatestTOUCHES, "every touch opens the microphone and gets its reply, %u of %u",
+                ulMeasured, aiatestTOUCHES );
+#if ( aiaconfigCLIENT_TOUCH_GESTURES == 1 )
+    vTestCheck( ulMaxMs <= aiatestMAX_TOUCH_DOWN_MS, "the first sample within %u ms of the touch",
+                aiatestMAX_TOUCH_DOWN_MS );
+    vTestCheck( ulReports == ulMeasured && ulReportedMaxMs <= ulMaxMs,
+                "the client reports each latency from the first scan, %u reports, at most %u ms", ulReports,
+                ulReportedMaxMs );
+#else
+    vTestCheck( ulMinMs >= aiatestHOLD_MS, "the first sample after the release" );
+#endif
+
+    return lTestResult();
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The wake word, from a WAV file. The file is played into the microphone in real time, and a stub spotter reports
+ * the wake word when a loud run of 100ms to 500ms ends, which makes it span that run and the quiet frame after it.
+ * For every utterance opened on it, the service checks that MicrophoneOpened carries a WAKEWORD initiator, that the
+ * stream starts with aiaconfigCLIENT_WAKEWORD_PREROLL_MS of pre-roll, and that its beginOffset and endOffset point at
+ * the wake word in the audio streamed.
+ *
+ * The WAV file is 16 kHz 16-bit mono, taken from AIA_TEST_WAV in the environment, e.g. a recording with short
+ * words after quiet, or else written by the test: two times a wake word of 300ms, a pause of 200ms and a command of
+ * 1s, after quiet.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestSAMPLE_RATE                  ( aiatestWAV_SAMPLE_RATE )
+#define aiatestFRAME_SAMPLES                ( AIA_MICROPHONE_RAW_FRAME_SAMPLES )
+#define aiatestWAV_MAX_SECONDS              ( 60U )
+/* The stream is kept in full to check the offsets against the audio. */
+#define aiatestSTREAM_MAX_SAMPLES           ( aiatestWAV_MAX_SECONDS * aiatestSAMPLE_RATE )
+#define aiatestUTTERANCES                   ( 2U )
+
+/* Frames louder than this on average are speech to the stub spotter. */
+#define aiatestLOUD                         ( 1000 )
+#define aiatestWAKEWORD_MIN_FRAMES          ( 5U )
+#define aiatestWAKEWORD_MAX_FRAMES          ( 25U )
+
+static int16_t * psWav;
+static uint32_t ulWavSamples;
+static uint32_t ulWavPosition;
+
+static int16_t * psStream;
+
+typedef struct {
+    uint64_t ullStart;
+    uint64_t ullBegin;
+    uint64_t ullEnd;
+    BaseType_t xWakeword;
+    BaseType_t xStarted;
+} Utterance_t;
+static Utterance_t xUtterances[ aiatestUTTERANCES ];
+static uint32_t ulUtterances;
+
+static uint32_t ulLoudFrames;
+
+static BaseType_t prvLoud( const int16_t * psFrame )
+{
+    uint32_t ulSum = 0;
+
+    for( uint32_t i = 0; i < aiatestFRAME_SAMPLES; i++ )
+    {
+        ulSum += ( uint32_t )abs( psFrame[ i ] );
+    }
+    return ( ulSum / aiatestFRAME_SAMPLES > aiatestLOUD ) ? pdTRUE : pdFALSE;
+}
+
+static void prvSpotterReset( void )
+{
+    ulLoudFrames = 0;
+}
+
+static BaseType_t prvSpotterProcess( const int16_t * psFrame, uint32_t * pulWakeWordFrames )
+{
+    BaseType_t xDetected = pdFALSE;
+
+    if( prvLoud( psFrame ) == pdTRUE )
+    {
+        ulLoudFrames++;
+    }
+    else
+    {
+        if( ulLoudFrames >= aiatestWAKEWORD_MIN_FRAMES && ulLoudFrames <= aiatestWAKEWORD_MAX_FRAMES )
+        {
+            *pulWakeWordFrames = ulLoudFrames + 1;
+            xDetected = pdTRUE;
+        }
+        ulLoudFrames = 0;
+    }
+    return xDetected;
+}
+
+static const AIAWakewordEngine_t xSpotter = {
+    .pcWakeWord = "ALEXA",
+    .vReset = prvSpotterReset,
+    .xProcess = prvSpotterProcess,
+};
+
+/* Quiet noise, with tones of ulAmplitude at the given times. */
+static void prvWriteWav( const char * pcPath )
+{
+    static const struct { uint32_t ulStartMs, ulEndMs, ulHz; } xTones[] = {
+        { 1000, 1300, 1000 }, { 1500, 2500, 500 }, { 6000, 6300, 1000 }, { 6500, 7500, 500 },
+    };
+    uint32_t ulSamples = 9 * aiatestSAMPLE_RATE;
+    int16_t * psSamples = malloc( ulSamples * sizeof( int16_t ) );
+    uint32_t ulSeed = 1;
+
+    for( uint32_t i = 0; i < ulSamples; i++ )
+    {
+        uint32_t ulMs = i * 1000 / aiatestSAMPLE_RATE;
+        int32_t lSample;
+
+        ulSeed = ulSeed * 1103515245 + 12345;
+        lSample = ( int32_t )( ( ulSeed >> 16 ) % 61 ) - 30;
+        for( size_t t = 0; t < sizeof( xTones ) / sizeof( xTones[ 0 ] ); t++ )
+        {
+            if( ulMs >= xTones[ t ].ulStartMs && ulMs < xTones[ t ].ulEndMs )
+            {
+                lSample += ( int32_t )( 8000.0 * sin( 2.0 * M_PI * xTones[ t ].ulHz * i / aiatestSAMPLE_RATE ) );
+            }
+        }
+        psSamples[ i ] = ( int16_t )lSample;
+    }
+    vTestWriteWav( pcPath, psSamples, ulSamples );
+    free( psSamples );
+}
+
+/* The WAV file, then silence. */
+static void prvSource( void * pvFrame, size_t xBytes )
+{
+    int16_t * psSamples = ( int16_t * )pvFrame;
+
+    for( size_t i = 0; i < xBytes / sizeof( int16_t ); i++ )
+    {
+        psSamples[ i ] = ( ulWavPosition < ulWavSamples ) ? psWav[ ulWavPosition++ ] : 0;
+    }
+}
+
+static uint64_t prvJsonNumber( const char * pcJson, size_t xLength, const char * pcKey )
+{
+    const char * pcFound = memmem( pcJson, xLength, pcKey, strlen( pcKey ) );
+
+    return ( pcFound != NULL ) ? strtoull( pcFound + strlen( pcKey ), NULL, 10 ) : UINT64_MAX;
+}
+
+static void prvEvent( const char * pcName, const char * pcJson, size_t xLength )
+{
+    if( strcmp( pcName, "MicrophoneOpened" ) == 0 && ulUtterances < aiatestUTTERANCES )
+    {
+        Utterance_t * pxUtterance = &xUtterances[ ulUtterances++ ];
+
+        pxUtterance->xWakeword = ( memmem( pcJson, xLength, "\"WAKEWORD\"", 10 ) != NULL &&
+                                   memmem( pcJson, xLength, "\"ALEXA\"", 7 ) != NULL ) ? pdTRUE : pdFALSE;
+        pxUtterance->ullBegin = prvJsonNumber( pcJson, xLength, "\"beginOffset\":" );
+        pxUtterance->ullEnd = prvJsonNumber( pcJson, xLength, "\"endOffset\":" );
+    }
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    if( ulUtterances > 0 && xUtterances[ ulUtterances - 1 ].xStarted == pdFALSE )
+    {
+        xUtterances[ ulUtterances - 1 ].ullStart = ullOffset;
+        xUtterances[ ulUtterances - 1 ].xStarted = pdTRUE;
+    }
+    if( ullOffset + xLength <= aiatestSTREAM_MAX_SAMPLES * sizeof( int16_t ) )
+    {
+        memcpy( ( uint8_t * )psStream + ullOffset, pucAudio, xLength );
+    }
+}
+
+/* Whether the frame of the stream at the offset is loud. */
+static BaseType_t prvStreamLoud( uint64_t ullOffset )
+{
+    return prvLoud( psStream + ullOffset / sizeof( int16_t ) );
+}
+
+int main( void )
+{
+    static const char * const pcPatterns[] = { "Failed", "failed", "Wake word detected", "pre-roll", NULL };
+    const char * pcWav = getenv( "AIA_TEST_WAV" );
+    AIAServiceStats_t xStats;
+    BaseType_t xRead;
+
+    if( pcWav == NULL )
+    {
+        pcWav = "build/test_wakeword.wav";
+        prvWriteWav( pcWav );
+    }
+    xRead = xTestReadWav( pcWav, aiatestSTREAM_MAX_SAMPLES, &psWav, &ulWavSamples );
+    vTestCheck( xRead, "%s is a WAV file of 16 kHz 16-bit mono audio, of %u ms", pcWav,
+                ulWavSamples * 1000 / aiatestSAMPLE_RATE );
+    psStream = calloc( aiatestSTREAM_MAX_SAMPLES, sizeof( int16_t ) );
+
+    vTestLogOnly( pcPatterns );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vAIAServiceSetEventHook( prvEvent );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+    vHostPlatformSetMicrophoneSource( prvSource );
+    vTestCheck( xClientStartWakeword( &xSpotter ), "listening starts" );
+
+    for( uint32_t i = 0; i < aiatestUTTERANCES; i++ )
+    {
+        vTestCheck( xAIAServiceConverse( 1000, 25, 10000 ), "the wake word opens utterance %u, which gets its reply", i + 1 );
+    }
+
+    vAIAServiceStats( &xStats );
+    for( uint32_t i = 0; i < ulUtterances; i++ )
+    {
+        const Utterance_t * pxUtterance = &xUtterances[ i ];
+        uint64_t ullFrame = AIA_MICROPHONE_RAW_FRAME_SIZE;
+
+        printf( "Utterance %u: stream from %llu, wake word from %llu to %llu\n", i + 1,
+                ( unsigned long long )pxUtterance->ullStart, ( unsigned long long )pxUtterance->ullBegin,
+                ( unsigned long long )pxUtterance->ullEnd );
+        vTestCheck( pxUtterance->xWakeword, "utterance %u has the WAKEWORD initiator and the wake word", i + 1 );
+        vTestCheck( pxUtterance->ullEnd - pxUtterance->ullStart ==
+                    aiaconfigCLIENT_WAKEWORD_PREROLL_MS / aiaconfigCLIENT_MICROPHONE_RAW_FRAME_DURATION_MS * ullFrame,
+                    "its stream starts with %u ms of pre-roll", ( uint32_t )aiaconfigCLIENT_WAKEWORD_PREROLL_MS );
+        vTestCheck( pxUtterance->ullBegin > pxUtterance->ullStart && pxUtterance->ullEnd - 2 * ullFrame > pxUtterance->ullBegin &&
+                    prvStreamLoud( pxUtterance->ullBegin - ullFrame ) == pdFALSE && prvStreamLoud( pxUtterance->ullBegin ) == pdTRUE &&
+                    prvStreamLoud( pxUtterance->ullEnd - 2 * ullFrame ) == pdTRUE && prvStreamLoud( pxUtterance->ullEnd - ullFrame ) == pdFALSE,
+                    "its beginOffset and endOffset frame the wake word in the stream" );
+    }
+    vTestCheck( ulTestLogMatches() == aiatestUTTERANCES, "the spotter cycles are reported on each detection" );
+    vTestCheck( xStats.ulMicrophoneOffsetJumps == 0, "the pre-roll and the live audio follow each other without a gap" );
+    vTestCheck( xStats.ulDecryptFailures == 0 && xStats.ulSequenceErrors == 0, "the stream decrypts in sequence" );
+
+    return lTestResult();
+}
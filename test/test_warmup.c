@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2019 - 2020 Arm Ltd.  All Rights Reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The warm-up policy against the scripted service. First an answer comes with no THINKING before it, to the cold
+ * speaker, and the microphone is warmed after it for a follow-up that does not come, until its hold runs out. Then
+ * THINKING is followed by IDLE, which stops the speaker warmed for nothing. Then OpenMicrophone comes to the cold
+ * microphone, and THINKING, SPEAKING and a follow-up OpenMicrophone go as warm-up expects: the speaker and the
+ * microphone must each be running before the directive that claims them, be released as that use ends, and no
+ * SpeakerOpened or MicrophoneOpened goes out for a warm path. The speaker and the microphone of the host take
+ * aiatestSPEAKER_STARTUP_MS and aiatestMICROPHONE_STARTUP_MS to start, as on a board. The test measures the time from each directive to the
+ * first sound played and to the first audio received, cold and warm, and prints the figures the client reports: the
+ * uses, the time active ahead of time and the time saved.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aia_client_priv.h"
+#include "aia_service.h"
+#include "aia_test.h"
+#include "host.h"
+
+#define aiatestTHINKING_MS                  ( 300U )
+#define aiatestANSWER_FRAMES                ( 25U )
+/* From start to the first transfer. */
+#define aiatestSPEAKER_STARTUP_MS           ( 60U )
+#define aiatestMICROPHONE_STARTUP_MS        ( 50U )
+
+typedef struct {
+    uint32_t ulHits;
+    uint32_t ulWarmups;
+    uint32_t ulExtraActiveMs;
+    uint32_t ulColdUs;
+    uint32_t ulWarmUs;
+    uint32_t ulSavedMs;
+} Report_t;
+
+static volatile uint64_t ullMsAtFirstSound;
+static volatile uint64_t ullMsAtFirstAudio;
+static Report_t xSpeakerReport;
+static Report_t xMicrophoneReport;
+static uint64_t ullSpeakerOffset;
+
+static uint64_t prvNowMs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t )xNow.tv_sec * 1000U + ( uint64_t )xNow.tv_nsec / 1000000U;
+}
+
+static void prvSpeakerSink( const int16_t * psSamples, size_t xSamples, size_t xBytesRead )
+{
+    ( void )xSamples;
+    if( ullMsAtFirstSound == 0 && xBytesRead != 0 && psSamples[ 0 ] != 0 )
+    {
+        ullMsAtFirstSound = prvNowMs();
+    }
+}
+
+static void prvMicrophone( uint64_t ullOffset, const uint8_t * pucAudio, size_t xLength )
+{
+    ( void )ullOffset;
+    ( void )pucAudio;
+    ( void )xLength;
+    if( ullMsAtFirstAudio == 0 )
+    {
+        ullMsAtFirstAudio = prvNowMs();
+    }
+}
+
+static void prvLogHook( const char * pcLine )
+{
+    const char * pcReport = strstr( pcLine, " warm-up used " );
+    Report_t * pxReport = ( strstr( pcLine, "DEBUG: Speaker" ) != NULL ) ? &xSpeakerReport : &xMicrophoneReport;
+
+    if( pcReport != NULL )
+    {
+        sscanf( pcReport, " warm-up used %u of %u times, %u ms active ahead of time, started in %u us cold and %u us warm, %u ms saved",
+                &pxReport->ulHits, &pxReport->ulWarmups, &pxReport->ulExtraActiveMs, &pxReport->ulColdUs,
+                &pxReport->ulWarmUs, &pxReport->ulSavedMs );
+    }
+    if( strstr( pcLine, "ailed" ) != NULL )
+    {
+        printf( "%s", pcLine );
+    }
+}
+
+static void prvSetState( const char * pcState )
+{
+    char cDirective[ 160 ];
+
+    snprintf( cDirective, sizeof( cDirective ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"a\"},\"payload\":{\"state\":\"%s\"}}", pcState );
+    vAIAServiceSendDirectives( cDirective );
+}
+
+static BaseType_t prvPlatform( BaseType_t xSpeakerOpen, BaseType_t xMicrophoneOpen )
+{
+    HostPlatformStats_t xPlatform;
+
+    vHostPlatformStats( &xPlatform );
+    return ( xPlatform.xSpeakerOpen == xSpeakerOpen && xPlatform.xMicrophoneOpen == xMicrophoneOpen ) ? pdTRUE : pdFALSE;
+}
+
+/* SPEAKING, then an answer played to its end. Returns the time from OpenSpeaker to its first sound. */
+static uint32_t prvAnswer( void )
+{
+    char cDirectives[ 512 ];
+    uint32_t ulClosed = ulAIAServiceEventCount( "SpeakerClosed" ) + 1U;
+    uint64_t ullSentAt;
+
+    ullMsAtFirstSound = 0;
+    vAIAServiceSendSpeaker( ullSpeakerOffset, aiatestANSWER_FRAMES, 5, 0 );
+    snprintf( cDirectives, sizeof( cDirectives ),
+              "{\"header\":{\"name\":\"SetAttentionState\",\"messageId\":\"s\"},\"payload\":{\"state\":\"SPEAKING\"}},"
+              "{\"header\":{\"name\":\"OpenSpeaker\",\"messageId\":\"o\"},\"payload\":{\"offset\":%llu}},"
+              "{\"header\":{\"name\":\"CloseSpeaker\",\"messageId\":\"x\"},\"payload\":{\"offset\":%llu}}",
+              ( unsigned long long )ullSpeakerOffset,
+              ( unsigned long long )( ullSpeakerOffset + aiatestANSWER_FRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE ) );
+    ullSpeakerOffset += aiatestANSWER_FRAMES * AIA_SPEAKER_DECODER_FRAME_SIZE;
+    ullSentAt = prvNowMs();
+    vAIAServiceSendDirectives( cDirectives );
+    vTestCheck( xAIAServiceWaitForEvent( "SpeakerClosed", ulClosed, 5000 ), "the answer plays to its end" );
+    vTestSleepMs( 50 );
+
+    return ( ullMsAtFirstSound > ullSentAt ) ? ( uint32_t )( ullMsAtFirstSound - ullSentAt ) : 0;
+}
+
+/* OpenMicrophone. Returns the time to the first audio. */
+static uint32_t prvOpenMicrophone( void )
+{
+    uint32_t ulOpened = ulAIAServiceEventCount( "MicrophoneOpened" ) + 1U;
+    uint64_t ullSentAt;
+    AIAServiceStats_t xStats;
+
+    ullMsAtFirstAudio = 0;
+    ullSentAt = prvNowMs();
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"OpenMicrophone\",\"messageId\":\"m\"},"
+                               "\"payload\":{\"timeoutInMilliseconds\":8000}}" );
+    vTestCheck( xAIAServiceWaitForEvent( "MicrophoneOpened", ulOpened, 2000 ), "OpenMicrophone opens the microphone" );
+    vAIAServiceStats( &xStats );
+    vTestCheck( xAIAServiceWaitForMicrophone( xStats.ullMicrophoneBytes + 1U, 2000 ), "the microphone streams" );
+
+    return ( ullMsAtFirstAudio > ullSentAt ) ? ( uint32_t )( ullMsAtFirstAudio - ullSentAt ) : 0;
+}
+
+int main( void )
+{
+    uint32_t ulSpeakerColdMs, ulSpeakerWarmMs, ulMicrophoneColdMs, ulMicrophoneWarmMs;
+    uint32_t ulSpeakerOpened, ulMicrophoneOpened;
+
+    vHostSetLogHook( prvLogHook, pdTRUE );
+    vHostPlatformSetStartupDelay( aiatestSPEAKER_STARTUP_MS, aiatestMICROPHONE_STARTUP_MS );
+    vTestCheck( xTestStartClient( pdTRUE ), "the client connects" );
+    vHostPlatformSetSpeakerSink( prvSpeakerSink );
+    vAIAServiceSetMicrophoneHook( prvMicrophone );
+
+    /* An answer with no THINKING before it, then the microphone warmed for a follow-up that does not come. */
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "the speaker and the microphone are off" );
+    ulSpeakerColdMs = prvAnswer();
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "the speaker cold when claimed stops at the end of the answer" );
+    prvSetState( "IDLE" );
+    vTestSleepMs( 100 );
+    vTestCheck( prvPlatform( pdFALSE, pdTRUE ), "the microphone is warmed after SPEAKING" );
+    vTestSleepMs( aiaconfigCLIENT_WARMUP_MICROPHONE_MS );
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "the microphone stops once its hold of %u ms runs out",
+                ( uint32_t )aiaconfigCLIENT_WARMUP_MICROPHONE_MS );
+
+    /* THINKING with no answer. */
+    prvSetState( "THINKING" );
+    vTestSleepMs( aiatestTHINKING_MS );
+    vTestCheck( prvPlatform( pdTRUE, pdFALSE ), "the speaker is warmed on THINKING" );
+    prvSetState( "IDLE" );
+    vTestSleepMs( 100 );
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "IDLE stops the speaker" );
+
+    /* A request, its answer and a follow-up. */
+    ulMicrophoneColdMs = prvOpenMicrophone();
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"CloseMicrophone\",\"messageId\":\"c\"}}" );
+    prvSetState( "THINKING" );
+    vTestSleepMs( aiatestTHINKING_MS );
+    vTestCheck( prvPlatform( pdTRUE, pdFALSE ), "the microphone is closed, and the speaker warmed on THINKING" );
+    ulSpeakerOpened = ulAIAServiceEventCount( "SpeakerOpened" );
+    ulSpeakerWarmMs = prvAnswer();
+    vTestCheck( ulAIAServiceEventCount( "SpeakerOpened" ) == ulSpeakerOpened + 1U, "OpenSpeaker is answered once" );
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "the speaker is released at the end of the answer" );
+    prvSetState( "IDLE" );
+    vTestSleepMs( aiatestTHINKING_MS );
+    ulMicrophoneOpened = ulAIAServiceEventCount( "MicrophoneOpened" );
+    vTestCheck( prvPlatform( pdFALSE, pdTRUE ), "the microphone is warmed for the follow-up" );
+    vTestCheck( ulAIAServiceEventCount( "MicrophoneOpened" ) == ulMicrophoneOpened, "a warm microphone is not opened" );
+    ulMicrophoneWarmMs = prvOpenMicrophone();
+    vAIAServiceSendDirectives( "{\"header\":{\"name\":\"CloseMicrophone\",\"messageId\":\"c\"}}" );
+    prvSetState( "IDLE" );
+    vTestSleepMs( 200 );
+    vTestCheck( prvPlatform( pdFALSE, pdFALSE ), "the microphone claimed warm is released on CloseMicrophone" );
+
+    printf( "Speaker: first sound %u ms after OpenSpeaker cold, %u ms warm\n", ulSpeakerColdMs, ulSpeakerWarmMs );
+    printf( "Microphone: first audio %u ms after OpenMicrophone cold, %u ms warm\n", ulMicrophoneColdMs, ulMicrophoneWarmMs );
+    printf( "Client: speaker used %u of %u warm-ups, %u ms active ahead of time, started in %u us cold and %u us warm, "
+            "%u ms saved\n", xSpeakerReport.ulHits, xSpeakerReport.ulWarmups, xSpeakerReport.ulExtraActiveMs,
+            xSpeakerReport.ulColdUs, xSpeakerReport.ulWarmUs, xSpeakerReport.ulSavedMs );
+    printf( "Client: microphone used %u of %u warm-ups, %u ms active ahead of time, started in %u us cold and %u us warm, "
+            "%u ms saved\n", xMicrophoneReport.ulHits, xMicrophoneReport.ulWarmups, xMicrophoneReport.ulExtraActiveMs,
+            xMicrophoneReport.ulColdUs, xMicrophoneReport.ulWarmUs, xMicrophoneReport.ulSavedMs );
+
+    vTestCheck( xSpeakerReport.ulWarmups == 2 && xSpeakerReport.ulHits == 1, "the speaker is warmed twice and used once" );
+    vTestCheck( xSpeakerReport.ulExtraActiveMs >= 2U * aiatestTHINKING_MS &&
+                xSpeakerReport.ulExtraActiveMs < 2U * aiatestTHINKING_MS + 300U,
+                "the speaker is active ahead of time while THINKING only" );
+    vTestCheck( xMicrophoneReport.ulWarmups == 2 && xMicrophoneReport.ulHits == 1,
+                "the microphone is warmed twice and used once" );
+    vTestCheck( xMicrophoneReport.ulExtraActiveMs >= aiaconfigCLIENT_WARMUP_MICROPHONE_MS + aiatestTHINKING_MS &&
+                xMicrophoneReport.ulExtraActiveMs < aiaconfigCLIENT_WARMUP_MICROPHONE_MS + aiatestTHINKING_MS + 300U,
+                "the microphone is active ahead of time for its hold and until the follow-up" );
+    vTestCheck( ulSpeakerWarmMs < ulSpeakerColdMs && xSpeakerReport.ulSavedMs > 0, "the warm speaker sounds sooner" );
+    vTestCheck( ulMicrophoneWarmMs < ulMicrophoneColdMs && xMicrophoneReport.ulSavedMs > 0,
+                "the warm microphone streams sooner" );
+    vTestCheck( xTestClientFailed() == pdFALSE, "the client stays connected" );
+
+    return lTestResult();
+}